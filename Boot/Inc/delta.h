@@ -0,0 +1,105 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : delta.h
+  * @brief          : Delta patch format and in-place applier, shared by the
+  *                   bootloader and the host diff tool
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Patch format (little endian):
+  *
+  *   header   "SCD1", old size, old crc32, new size, new crc32 (20 bytes)
+  *   ops      until new size bytes have been produced:
+  *     DELTA_OP_ADD     varint length, zigzag varint (source - destination),
+  *                      then runs of: varint n (bytes copied unchanged from
+  *                      the old image), varint m, m bytes added (mod 256) to
+  *                      the next m old bytes; the runs end with length
+  *     DELTA_OP_INSERT  varint length, length literal bytes
+  *
+  * The new image is written over the old one page by page. While page p is
+  * assembled in RAM, old pages >= p are still in flash and the last
+  * DELTA_HISTORY_PAGES old pages before p are kept in RAM, so the diff tool
+  * may only use sources at or after (destination - DELTA_HISTORY_SIZE).
+  * RAM use is one page plus the history, whatever the image size.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DELTA_H
+#define __DELTA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "boot.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define DELTA_MAGIC             0x31444353UL      /* "SCD1" */
+#define DELTA_HEADER_SIZE       20U
+#define DELTA_PAGE_SIZE         BOOT_PAGE_SIZE
+#define DELTA_HISTORY_PAGES     1U
+#define DELTA_HISTORY_SIZE      (DELTA_HISTORY_PAGES * DELTA_PAGE_SIZE)
+
+#define DELTA_OP_ADD            0x01U
+#define DELTA_OP_INSERT         0x02U
+
+/* Delta_Feed()/Delta_Finish() results */
+#define DELTA_OK                0
+#define DELTA_ERR_FORMAT        (-1)      /* malformed patch */
+#define DELTA_ERR_BASE          (-2)      /* installed image is not the patch's base */
+#define DELTA_ERR_WRITE         (-3)      /* page write failed */
+
+/* Exported types ------------------------------------------------------------*/
+/* Writes one finished page of the new image at the given image offset */
+typedef int (*Delta_WriteFn)(uint32_t offset, const uint8_t *data, uint32_t length);
+/* zlib-compatible CRC-32 of the installed image */
+typedef uint32_t (*Delta_CrcFn)(const uint8_t *data, uint32_t length);
+
+typedef struct
+{
+  const uint8_t *image;       /* installed image, overwritten page by page */
+  Delta_WriteFn write;
+  Delta_CrcFn crc;
+
+  uint32_t oldSize;
+  uint32_t oldCrc;
+  uint32_t newSize;
+  uint32_t newCrc;
+
+  uint32_t out;               /* bytes of the new image produced */
+  uint32_t source;            /* old image offset of the running ADD */
+  uint32_t remaining;         /* bytes left in the running op or run */
+  uint32_t opLeft;            /* bytes left in the running ADD */
+  uint32_t value;             /* varint being decoded */
+  uint8_t shift;
+  uint8_t state;
+  uint8_t op;
+  uint8_t headerFill;
+
+  uint8_t header[DELTA_HEADER_SIZE];
+  uint8_t page[DELTA_PAGE_SIZE];
+  uint8_t history[DELTA_HISTORY_SIZE];
+} Delta_Applier;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Delta_Init(Delta_Applier *delta, const uint8_t *image, Delta_WriteFn write, Delta_CrcFn crc);
+int Delta_Feed(Delta_Applier *delta, const uint8_t *data, uint32_t length);
+int Delta_Finish(Delta_Applier *delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DELTA_H */
@@ -0,0 +1,222 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : boot_can.c
+  * @brief          : bxCAN driver of the bootloader (the can.h calls it uses)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Same bit timing and RX queue as Core/Src/can.c, without what only the
+  * application needs: no TX queue, no TX or error interrupt, no silent mode
+  * and none of the monitor, ping, stress and alarm hooks. A response goes
+  * straight into a free mailbox; the bootloader sends one at a time and
+  * waits for a mailbox when all three are busy.
+  *
+  * Unlike the application, the controller retransmits: a response lost in
+  * arbitration would otherwise cost the uploader a timeout.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "can.h"
+
+/* Private define ------------------------------------------------------------*/
+#define BOOT_CAN_TSR_TME_ALL  (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)
+#define BOOT_CAN_BITRATE      1000000U  /* the application's bus rate */
+#define BOOT_CAN_BIT_TQ       8U        /* 1 + BS1 3 + BS2 4, as Core/Src/can.c */
+
+/* Private variables ---------------------------------------------------------*/
+CAN_HandleTypeDef hcan;
+
+/* Filled by CAN_RxFifo0_IRQ, drained by CAN_Receive; indices run freely */
+static CAN_Frame rxQueue[CAN_RX_QUEUE_LEN];
+static volatile uint32_t rxHead;
+static volatile uint32_t rxTail;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  CAN init function: 1 Mbit/s as the application, the prescaler
+  *         from PCLK1 (32 MHz, so 4); call after SystemClock_Config()
+  * @retval None
+  */
+void MX_CAN_Init(void)
+{
+  hcan.Instance = CAN;
+  hcan.Init.Prescaler = HAL_RCC_GetPCLK1Freq() / (BOOT_CAN_BITRATE * BOOT_CAN_BIT_TQ);
+  hcan.Init.Mode = CAN_MODE_NORMAL;
+  hcan.Init.SyncJumpWidth = CAN_SJW_1TQ;
+  hcan.Init.TimeSeg1 = CAN_BS1_3TQ;
+  hcan.Init.TimeSeg2 = CAN_BS2_4TQ;
+  hcan.Init.TimeTriggeredMode = DISABLE;
+  hcan.Init.AutoBusOff = DISABLE;
+  hcan.Init.AutoWakeUp = DISABLE;
+  hcan.Init.AutoRetransmission = ENABLE;
+  hcan.Init.ReceiveFifoLocked = DISABLE;
+  hcan.Init.TransmitFifoPriority = DISABLE;
+  if (HAL_CAN_Init(&hcan) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+void HAL_CAN_MspInit(CAN_HandleTypeDef* canHandle)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  if (canHandle->Instance == CAN)
+  {
+    __HAL_RCC_CAN1_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    /* PA11 CAN_RX, PA12 CAN_TX */
+    GPIO_InitStruct.Pin = GPIO_PIN_11|GPIO_PIN_12;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+    GPIO_InitStruct.Alternate = GPIO_AF9_CAN;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    HAL_NVIC_SetPriority(CAN_RX0_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(CAN_RX0_IRQn);
+  }
+}
+
+/**
+  * @brief  Enables the interrupt that feeds the RX queue
+  * @note   Call after HAL_CAN_Start()
+  * @retval None
+  */
+void CAN_StartQueues(void)
+{
+  if (HAL_CAN_ActivateNotification(&hcan, CAN_IT_RX_FIFO0_MSG_PENDING) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/**
+  * @brief  Loads a frame into a free transmit mailbox
+  * @param  frame: frame to send
+  * @retval HAL_OK when loaded, HAL_BUSY when all three mailboxes are pending
+  */
+HAL_StatusTypeDef CAN_TransmitFrame(const CAN_Frame *frame)
+{
+  CAN_TypeDef *can = hcan.Instance;
+  CAN_TxMailBox_TypeDef *mb;
+  uint32_t tir;
+
+  if ((can->TSR & BOOT_CAN_TSR_TME_ALL) == 0U)
+  {
+    return HAL_BUSY;
+  }
+  mb = &can->sTxMailBox[(can->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos];
+
+  if ((frame->id & CAN_FRAME_EXT) != 0U)
+  {
+    tir = ((frame->id & CAN_FRAME_ID_MASK) << CAN_TI0R_EXID_Pos) | CAN_ID_EXT;
+  }
+  else
+  {
+    tir = (frame->id & 0x7FFU) << CAN_TI0R_STID_Pos;
+  }
+
+  mb->TDTR = frame->dlc;
+  mb->TDLR = ((uint32_t)frame->data[3] << 24) | ((uint32_t)frame->data[2] << 16) |
+             ((uint32_t)frame->data[1] << 8)  | frame->data[0];
+  mb->TDHR = ((uint32_t)frame->data[7] << 24) | ((uint32_t)frame->data[6] << 16) |
+             ((uint32_t)frame->data[5] << 8)  | frame->data[4];
+  mb->TIR = tir | CAN_TI0R_TXRQ;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Takes the oldest received frame from the RX queue
+  * @param  frame: destination
+  * @retval 1 if a frame was returned, 0 if the queue is empty
+  */
+uint8_t CAN_Receive(CAN_Frame *frame)
+{
+  uint32_t tail = rxTail;
+
+  if (tail == rxHead)
+  {
+    return 0;
+  }
+  *frame = rxQueue[tail & (CAN_RX_QUEUE_LEN - 1U)];
+  rxTail = tail + 1U;
+
+  return 1;
+}
+
+/**
+  * @brief  Tells whether CAN_Receive() has a frame to return
+  * @retval 1 if the RX queue is not empty
+  */
+uint8_t CAN_RxPending(void)
+{
+  return (rxTail != rxHead) ? 1U : 0U;
+}
+
+/**
+  * @brief  CAN RX FIFO0 interrupt body: moves every pending frame to the
+  *         queue; a frame that finds it full is dropped, and the uploader
+  *         resends the block it belonged to
+  * @retval None
+  */
+void CAN_RxFifo0_IRQ(void)
+{
+  CAN_TypeDef *can = hcan.Instance;
+
+  can->RF0R = CAN_RF0R_FOVR0;
+  while ((can->RF0R & CAN_RF0R_FMP0) != 0U)
+  {
+    const CAN_FIFOMailBox_TypeDef *mb = &can->sFIFOMailBox[0];
+    uint32_t head = rxHead;
+
+    if ((head - rxTail) < CAN_RX_QUEUE_LEN)
+    {
+      CAN_Frame *f = &rxQueue[head & (CAN_RX_QUEUE_LEN - 1U)];
+      uint32_t rir = mb->RIR;
+      uint32_t rdlr = mb->RDLR;
+      uint32_t rdhr = mb->RDHR;
+
+      if ((rir & CAN_RI0R_IDE) != 0U)
+      {
+        f->id = (rir >> CAN_RI0R_EXID_Pos) | CAN_FRAME_EXT;
+      }
+      else
+      {
+        f->id = rir >> CAN_RI0R_STID_Pos;
+      }
+      f->dlc = (uint8_t)(mb->RDTR & CAN_RDT0R_DLC);
+      f->filter = 0;
+      f->time = 0;
+      f->data[0] = (uint8_t)rdlr;
+      f->data[1] = (uint8_t)(rdlr >> 8);
+      f->data[2] = (uint8_t)(rdlr >> 16);
+      f->data[3] = (uint8_t)(rdlr >> 24);
+      f->data[4] = (uint8_t)rdhr;
+      f->data[5] = (uint8_t)(rdhr >> 8);
+      f->data[6] = (uint8_t)(rdhr >> 16);
+      f->data[7] = (uint8_t)(rdhr >> 24);
+      rxHead = head + 1U;
+    }
+
+    /* Release the output mailbox and wait until FMP0 reflects it */
+    can->RF0R = CAN_RF0R_RFOM0;
+    while ((can->RF0R & CAN_RF0R_RFOM0) != 0U)
+    {
+    }
+  }
+}
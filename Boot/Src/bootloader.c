@@ -0,0 +1,763 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : bootloader.c
+  * @brief          : Resident CAN bootloader (flash pages 0-3)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Starts the application at BOOT_APP_BASE unless it is missing or the
+  * application asked for an update (BOOT_REQUEST_MAGIC in RTC->BKP0R).
+  * Otherwise it serves the protocol described in boot.h.
+  *
+  * Reception and programming overlap: the CAN RX interrupt (boot_can.c) keeps
+  * filling the software queue while the main loop programs the oldest
+  * complete block a few words at a time, so block k+1 streams in while block
+  * k is written. Blocks are checked with the hardware CRC unit before they
+  * are programmed and compared with flash afterwards.
+  *
+  * The first 8 bytes of the image (initial SP and reset vector) are held
+  * back and programmed only after END has verified the whole image, so an
+  * interrupted update never leaves a startable half image behind.
+  *
+  * DELTA instead of START streams a patch (delta.h) through the same blocks.
+  * Blocks are then taken strictly in order and fed to the applier, which
+  * rebuilds the image over the installed one page by page. A page erase
+  * stalls the CPU, interrupts included, so in this mode the host keeps only
+  * one block in flight and every ACK means the node is listening again.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "main.h"
+#include "can.h"
+#include "boot.h"
+#include "delta.h"
+
+/* Private define ------------------------------------------------------------*/
+#define BOOT_PROGRAM_CHUNK      32U       /* bytes programmed between RX polls */
+#define BOOT_PATCH_CHUNK        64U       /* patch bytes applied between RX polls */
+#define BOOT_APP_BLOCKS         (BOOT_APP_MAX_SIZE / BOOT_BLOCK_SIZE)
+#define BOOT_RAM_END            (SRAM_BASE + (12UL * 1024UL))
+#define BOOT_RESPOND_TIMEOUT_MS 10U       /* mailboxes stay full: nobody acknowledges */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint8_t data[BOOT_BLOCK_SIZE];
+  uint32_t crc;
+  uint16_t number;
+  uint16_t length;
+  uint16_t received;
+} BlockBuffer;
+
+/* Private variables ---------------------------------------------------------*/
+CRC_HandleTypeDef hcrc;
+
+static BlockBuffer buffers[BOOT_WINDOW];
+static BlockBuffer *filling;              // block currently being received
+static uint32_t fillSeq;                  // blocks received and CRC-checked
+static uint32_t programSeq;               // blocks programmed
+static uint32_t programOffset;            // progress within the oldest block
+
+static uint8_t hostAddress = 0xFFU;
+static uint8_t sessionOpen;
+static uint8_t deltaMode;
+static uint32_t streamSize;               // bytes carried by the blocks
+static uint32_t nextBlock;                // delta mode: next block accepted
+static uint32_t imageSize;
+static uint32_t imageCrc;
+static uint32_t imageVectors[2];
+static uint32_t doneMap[(BOOT_APP_BLOCKS + 31U) / 32U];
+static Delta_Applier delta;
+
+/* Private function prototypes -----------------------------------------------*/
+static void MX_CRC_Init(void);
+
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Checks that the application vector table points into RAM and flash
+  * @retval 1 if the application can be started
+  */
+static int Boot_AppValid(void)
+{
+  const uint32_t *vectors = (const uint32_t *)BOOT_APP_BASE;
+
+  return (vectors[0] > SRAM_BASE) && (vectors[0] <= BOOT_RAM_END) &&
+         ((vectors[1] & 1U) != 0U) &&
+         (vectors[1] > BOOT_APP_BASE) && (vectors[1] < (BOOT_APP_BASE + BOOT_APP_MAX_SIZE));
+}
+
+/**
+  * @brief  Hands over to the application with the core as after reset
+  * @retval None (does not return)
+  */
+static void Boot_JumpToApp(void)
+{
+  const uint32_t *vectors = (const uint32_t *)BOOT_APP_BASE;
+  void (*entry)(void) = (void (*)(void))vectors[1];
+
+  SysTick->CTRL = 0;
+  SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+  HAL_DeInit();
+
+  SCB->VTOR = BOOT_APP_BASE;
+  __set_MSP(vectors[0]);
+  entry();
+}
+
+/**
+  * @brief  zlib-compatible CRC-32 on the hardware CRC unit
+  * @param  data: first buffer
+  * @param  length: bytes in data
+  * @param  more: optional second buffer appended to the calculation (may be NULL)
+  * @param  moreLength: bytes in more
+  * @retval CRC-32
+  */
+static uint32_t Boot_Crc32(const uint8_t *data, uint32_t length, const uint8_t *more, uint32_t moreLength)
+{
+  uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)(uintptr_t)data, length);
+
+  if (more != NULL)
+  {
+    crc = HAL_CRC_Accumulate(&hcrc, (uint32_t *)(uintptr_t)more, moreLength);
+  }
+  return ~crc;
+}
+
+static void Boot_Respond(uint8_t cmd, uint8_t status, const uint8_t *args, uint32_t count)
+{
+  CAN_Frame frame;
+  uint32_t start;
+
+  frame.id = BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, hostAddress, BOOT_NODE_ADDRESS) | CAN_FRAME_EXT;
+  frame.dlc = 8;
+  frame.filter = 0;
+  frame.time = 0;
+  memset(frame.data, 0xFF, sizeof(frame.data));
+  frame.data[0] = cmd | BOOT_RSP;
+  frame.data[1] = status;
+  if (count > 6U)
+  {
+    count = 6U;
+  }
+  memcpy(&frame.data[2], args, count);
+
+  /* Alone on the bus the controller retransmits forever; the response is
+   * then dropped and the uploader's timeout takes over */
+  start = HAL_GetTick();
+  while (CAN_TransmitFrame(&frame) != HAL_OK)
+  {
+    if ((HAL_GetTick() - start) > BOOT_RESPOND_TIMEOUT_MS)
+    {
+      return;
+    }
+  }
+}
+
+static void Boot_RespondBlock(uint32_t number, uint8_t status)
+{
+  uint8_t args[2] = { (uint8_t)number, (uint8_t)(number >> 8) };
+
+  Boot_Respond(BOOT_CMD_BLOCK, status, args, sizeof(args));
+}
+
+static uint32_t Boot_Le32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void Boot_Ping(void)
+{
+  uint8_t args[5];
+
+  args[0] = BOOT_VERSION;
+  args[1] = BOOT_WINDOW;
+  args[2] = (uint8_t)(BOOT_BLOCK_SIZE / 256U);
+  args[3] = (uint8_t)Boot_AppValid();
+  args[4] = (uint8_t)(BOOT_APP_MAX_SIZE / 1024U);
+  Boot_Respond(BOOT_CMD_PING, BOOT_OK, args, sizeof(args));
+}
+
+static void Boot_ResetSession(void)
+{
+  sessionOpen = 0;
+  deltaMode = 0;
+  filling = NULL;
+  fillSeq = 0;
+  programSeq = 0;
+  programOffset = 0;
+  nextBlock = 0;
+  memset(doneMap, 0, sizeof(doneMap));
+}
+
+/**
+  * @brief  START: erases the pages the new image needs, invalidating the old one
+  * @param  frame: command frame
+  * @retval None
+  */
+static void Boot_Start(const CAN_Frame *frame)
+{
+  FLASH_EraseInitTypeDef erase;
+  uint32_t pageError = 0;
+  uint32_t size = (uint32_t)frame->data[1] | ((uint32_t)frame->data[2] << 8) | ((uint32_t)frame->data[3] << 16);
+
+  Boot_ResetSession();
+  if ((size < 8U) || (size > BOOT_APP_MAX_SIZE))
+  {
+    Boot_Respond(BOOT_CMD_START, BOOT_ERR_RANGE, NULL, 0);
+    return;
+  }
+  streamSize = size;
+  imageSize = size;
+  imageCrc = Boot_Le32(&frame->data[4]);
+
+  /* The CPU stalls on flash fetches while a page erases; the host waits for
+   * this response before streaming, so no frame is lost meanwhile */
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.PageAddress = BOOT_APP_BASE;
+  erase.NbPages = (size + BOOT_PAGE_SIZE - 1U) / BOOT_PAGE_SIZE;
+  HAL_FLASH_Unlock();
+  if (HAL_FLASHEx_Erase(&erase, &pageError) != HAL_OK)
+  {
+    HAL_FLASH_Lock();
+    Boot_Respond(BOOT_CMD_START, BOOT_ERR_FLASH, NULL, 0);
+    return;
+  }
+
+  sessionOpen = 1;
+  Boot_Respond(BOOT_CMD_START, BOOT_OK, NULL, 0);
+}
+
+static uint32_t Boot_ImageCrc(const uint8_t *data, uint32_t length)
+{
+  return Boot_Crc32(data, length, NULL, 0);
+}
+
+/**
+  * @brief  Delta applier page writer: erase, program, read back. The vector
+  *         table words of page 0 are held back for END like in a full update
+  * @retval 0 on success
+  */
+static int Boot_WritePage(uint32_t offset, const uint8_t *data, uint32_t length)
+{
+  FLASH_EraseInitTypeDef erase;
+  uint32_t pageError = 0;
+  uint32_t start = 0;
+  uint32_t i;
+
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.PageAddress = BOOT_APP_BASE + offset;
+  erase.NbPages = 1;
+  if (HAL_FLASHEx_Erase(&erase, &pageError) != HAL_OK)
+  {
+    return -1;
+  }
+  if (offset == 0U)
+  {
+    memcpy(imageVectors, data, sizeof(imageVectors));
+    start = sizeof(imageVectors);
+  }
+  for (i = start; i < length; i += 4U)
+  {
+    uint32_t word = 0xFFFFFFFFUL;
+
+    memcpy(&word, &data[i], ((length - i) < 4U) ? (length - i) : 4U);
+    if ((word != 0xFFFFFFFFUL) &&
+        (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, BOOT_APP_BASE + offset + i, word) != HAL_OK))
+    {
+      return -1;
+    }
+  }
+  return (memcmp((const void *)(BOOT_APP_BASE + offset + start), &data[start], length - start) == 0) ? 0 : -1;
+}
+
+/**
+  * @brief  DELTA: opens a patch session; nothing is erased until the patch
+  *         header has matched the installed image
+  * @param  frame: command frame, patch size in bytes 1..3
+  * @retval None
+  */
+static void Boot_Delta(const CAN_Frame *frame)
+{
+  uint32_t size = (uint32_t)frame->data[1] | ((uint32_t)frame->data[2] << 8) | ((uint32_t)frame->data[3] << 16);
+
+  Boot_ResetSession();
+  if ((size <= DELTA_HEADER_SIZE) || (size > BOOT_APP_MAX_SIZE))
+  {
+    Boot_Respond(BOOT_CMD_DELTA, BOOT_ERR_RANGE, NULL, 0);
+    return;
+  }
+  streamSize = size;
+  Delta_Init(&delta, (const uint8_t *)BOOT_APP_BASE, Boot_WritePage, Boot_ImageCrc);
+  HAL_FLASH_Unlock();
+  deltaMode = 1;
+  sessionOpen = 1;
+  Boot_Respond(BOOT_CMD_DELTA, BOOT_OK, NULL, 0);
+}
+
+static uint8_t Boot_DeltaStatus(int result)
+{
+  switch (result)
+  {
+    case DELTA_OK:
+      return BOOT_OK;
+    case DELTA_ERR_BASE:
+      return BOOT_ERR_BASE;
+    case DELTA_ERR_WRITE:
+      return BOOT_ERR_FLASH;
+    default:
+      return BOOT_ERR_PATCH;
+  }
+}
+
+/**
+  * @brief  BLOCK: opens the next free buffer for the announced block
+  * @param  frame: command frame
+  * @retval None
+  */
+static void Boot_BlockHeader(const CAN_Frame *frame)
+{
+  uint32_t number = (uint32_t)frame->data[1] | ((uint32_t)frame->data[2] << 8);
+  uint32_t offset = number * BOOT_BLOCK_SIZE;
+
+  if (filling != NULL)
+  {
+    Boot_RespondBlock(filling->number, BOOT_ERR_INCOMPLETE);
+    filling = NULL;
+  }
+  if (!sessionOpen)
+  {
+    Boot_RespondBlock(number, BOOT_ERR_STATE);
+    return;
+  }
+  if (offset >= streamSize)
+  {
+    Boot_RespondBlock(number, BOOT_ERR_RANGE);
+    return;
+  }
+  if (deltaMode && (number != nextBlock))
+  {
+    /* A resent block that was already taken is acknowledged, its data ignored */
+    Boot_RespondBlock(number, (number < nextBlock) ? BOOT_OK : BOOT_ERR_SEQUENCE);
+    return;
+  }
+  if ((fillSeq - programSeq) >= BOOT_WINDOW)
+  {
+    Boot_RespondBlock(number, BOOT_ERR_BUSY);
+    return;
+  }
+
+  filling = &buffers[fillSeq % BOOT_WINDOW];
+  filling->number = (uint16_t)number;
+  filling->crc = Boot_Le32(&frame->data[3]);
+  filling->length = (uint16_t)(((streamSize - offset) < BOOT_BLOCK_SIZE) ? (streamSize - offset) : BOOT_BLOCK_SIZE);
+  filling->received = 0;
+  memset(filling->data, 0xFF, sizeof(filling->data));
+}
+
+/**
+  * @brief  Data frame: appends eight bytes to the open block, checks its CRC
+  *         when complete and queues it for programming
+  * @param  frame: data frame
+  * @retval None
+  */
+static void Boot_BlockData(const CAN_Frame *frame)
+{
+  uint32_t count;
+
+  if (filling == NULL)
+  {
+    return;
+  }
+  count = filling->length - filling->received;
+  if (count > frame->dlc)
+  {
+    count = frame->dlc;
+  }
+  memcpy(&filling->data[filling->received], frame->data, count);
+  filling->received += (uint16_t)count;
+  if (filling->received < filling->length)
+  {
+    return;
+  }
+
+  if (Boot_Crc32(filling->data, filling->length, NULL, 0) != filling->crc)
+  {
+    Boot_RespondBlock(filling->number, BOOT_ERR_CRC);
+  }
+  else
+  {
+    fillSeq++;
+    nextBlock++;
+  }
+  filling = NULL;
+}
+
+/**
+  * @brief  Delta mode: feeds the next piece of the oldest received block to
+  *         the patch applier, acknowledging the block once it is consumed
+  * @retval None
+  */
+static void Boot_PatchStep(void)
+{
+  BlockBuffer *block = &buffers[programSeq % BOOT_WINDOW];
+  uint32_t count = block->length - programOffset;
+  int result;
+
+  if (count > BOOT_PATCH_CHUNK)
+  {
+    count = BOOT_PATCH_CHUNK;
+  }
+  result = Delta_Feed(&delta, &block->data[programOffset], count);
+  programOffset += count;
+  if ((result == DELTA_OK) && (programOffset < block->length))
+  {
+    return;
+  }
+
+  if (result != DELTA_OK)
+  {
+    sessionOpen = 0;
+  }
+  Boot_RespondBlock(block->number, Boot_DeltaStatus(result));
+  programSeq++;
+  programOffset = 0;
+}
+
+/**
+  * @brief  Programs the next few words of the oldest received block and
+  *         acknowledges the block once it is written and read back
+  * @retval None
+  */
+static void Boot_ProgramStep(void)
+{
+  BlockBuffer *block;
+  uint32_t base;
+  uint32_t end;
+  uint32_t start;
+  uint8_t status = BOOT_OK;
+
+  if (programSeq == fillSeq)
+  {
+    return;
+  }
+  if (deltaMode)
+  {
+    Boot_PatchStep();
+    return;
+  }
+  block = &buffers[programSeq % BOOT_WINDOW];
+  base = BOOT_APP_BASE + ((uint32_t)block->number * BOOT_BLOCK_SIZE);
+  end = ((uint32_t)block->length + 3U) & ~3UL;
+
+  /* A resent block that is already in flash is only compared */
+  if ((doneMap[block->number / 32U] & (1UL << (block->number % 32U))) != 0U)
+  {
+    programOffset = end;
+  }
+
+  if ((block->number == 0U) && (programOffset == 0U))
+  {
+    memcpy(imageVectors, block->data, sizeof(imageVectors));
+    programOffset = sizeof(imageVectors);
+  }
+
+  start = programOffset;
+  while ((programOffset < end) && ((programOffset - start) < BOOT_PROGRAM_CHUNK))
+  {
+    uint32_t word;
+
+    memcpy(&word, &block->data[programOffset], sizeof(word));
+    if ((word != 0xFFFFFFFFUL) &&
+        (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, base + programOffset, word) != HAL_OK))
+    {
+      status = BOOT_ERR_FLASH;
+      programOffset = end;
+      break;
+    }
+    programOffset += sizeof(word);
+  }
+  if (programOffset < end)
+  {
+    return;
+  }
+
+  start = (block->number == 0U) ? sizeof(imageVectors) : 0U;
+  if ((status == BOOT_OK) &&
+      (memcmp((const void *)(base + start), &block->data[start], block->length - start) != 0))
+  {
+    status = BOOT_ERR_FLASH;
+  }
+  if (status == BOOT_OK)
+  {
+    doneMap[block->number / 32U] |= 1UL << (block->number % 32U);
+  }
+  Boot_RespondBlock(block->number, status);
+  programSeq++;
+  programOffset = 0;
+}
+
+/**
+  * @brief  END: checks that every block is in flash, verifies the image CRC
+  *         and finally programs the vector table
+  * @retval None
+  */
+static void Boot_End(void)
+{
+  uint32_t blocks = (streamSize + BOOT_BLOCK_SIZE - 1U) / BOOT_BLOCK_SIZE;
+  uint32_t crc;
+  uint8_t args[4];
+  uint8_t status;
+  uint32_t i;
+
+  /* Finish blocks still queued behind the END command */
+  while (sessionOpen && (programSeq != fillSeq))
+  {
+    Boot_ProgramStep();
+  }
+  if (!sessionOpen || (filling != NULL))
+  {
+    Boot_Respond(BOOT_CMD_END, BOOT_ERR_STATE, NULL, 0);
+    return;
+  }
+
+  if (deltaMode)
+  {
+    status = Boot_DeltaStatus(Delta_Finish(&delta));
+    if ((status == BOOT_OK) && (delta.newSize < sizeof(imageVectors)))
+    {
+      status = BOOT_ERR_PATCH;
+    }
+    if (status != BOOT_OK)
+    {
+      Boot_Respond(BOOT_CMD_END, status, NULL, 0);
+      return;
+    }
+    imageSize = delta.newSize;
+    imageCrc = delta.newCrc;
+  }
+  else
+  {
+    for (i = 0; i < blocks; i++)
+    {
+      if ((doneMap[i / 32U] & (1UL << (i % 32U))) == 0U)
+      {
+        Boot_Respond(BOOT_CMD_END, BOOT_ERR_INCOMPLETE, NULL, 0);
+        return;
+      }
+    }
+  }
+
+  crc = Boot_Crc32((const uint8_t *)imageVectors, sizeof(imageVectors),
+                   (const uint8_t *)(BOOT_APP_BASE + sizeof(imageVectors)), imageSize - sizeof(imageVectors));
+  args[0] = (uint8_t)crc;
+  args[1] = (uint8_t)(crc >> 8);
+  args[2] = (uint8_t)(crc >> 16);
+  args[3] = (uint8_t)(crc >> 24);
+  if (crc != imageCrc)
+  {
+    Boot_Respond(BOOT_CMD_END, BOOT_ERR_VERIFY, args, sizeof(args));
+    return;
+  }
+
+  if ((HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, BOOT_APP_BASE, imageVectors[0]) != HAL_OK) ||
+      (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, BOOT_APP_BASE + 4U, imageVectors[1]) != HAL_OK))
+  {
+    Boot_Respond(BOOT_CMD_END, BOOT_ERR_FLASH, args, sizeof(args));
+    return;
+  }
+  HAL_FLASH_Lock();
+  sessionOpen = 0;
+  Boot_Respond(BOOT_CMD_END, BOOT_OK, args, sizeof(args));
+}
+
+static void Boot_HandleCommand(const CAN_Frame *frame)
+{
+  hostAddress = (uint8_t)BOOT_ID_SA(frame->id);
+
+  switch (frame->data[0])
+  {
+    case BOOT_CMD_PING:
+      Boot_Ping();
+      break;
+    case BOOT_CMD_START:
+      Boot_Start(frame);
+      break;
+    case BOOT_CMD_DELTA:
+      Boot_Delta(frame);
+      break;
+    case BOOT_CMD_BLOCK:
+      Boot_BlockHeader(frame);
+      break;
+    case BOOT_CMD_END:
+      Boot_End();
+      break;
+    case BOOT_CMD_RUN:
+      Boot_Respond(BOOT_CMD_RUN, Boot_AppValid() ? BOOT_OK : BOOT_ERR_STATE, NULL, 0);
+      if (Boot_AppValid())
+      {
+        HAL_Delay(10);    // let the response leave the mailbox
+        HAL_NVIC_SystemReset();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+  * @brief  The bootloader entry point.
+  * @retval int
+  */
+int main(void)
+{
+  CAN_Frame frame;
+  CAN_FilterTypeDef canfil = {0};
+  uint32_t filterId = (BOOT_CAN_ID(0, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, 0) << 3) | CAN_ID_EXT;
+  uint32_t filterMask = ((0xFFUL << 16) | (0xFFUL << 8)) << 3 | CAN_ID_EXT;
+  int stay;
+
+  HAL_Init();
+
+  /* Decide before touching the clocks, the application configures its own */
+  HAL_PWR_EnableBkUpAccess();
+  stay = (RTC->BKP0R == BOOT_REQUEST_MAGIC);
+  RTC->BKP0R = 0;
+  if (!stay && Boot_AppValid())
+  {
+    Boot_JumpToApp();
+  }
+
+  SystemClock_Config();
+  MX_CAN_Init();
+  MX_CRC_Init();
+
+  /* Accept only PGN 0xEF00/0x1EF00 frames addressed to this node */
+  canfil.FilterMode = CAN_FILTERMODE_IDMASK;
+  canfil.FilterScale = CAN_FILTERSCALE_32BIT;
+  canfil.FilterFIFOAssignment = CAN_RX_FIFO0;
+  canfil.FilterActivation = ENABLE;
+  canfil.SlaveStartFilterBank = 14;
+  canfil.FilterIdHigh = filterId >> 16;
+  canfil.FilterIdLow = filterId & 0xFFFFU;
+  canfil.FilterMaskIdHigh = filterMask >> 16;
+  canfil.FilterMaskIdLow = filterMask & 0xFFFFU;
+  HAL_CAN_ConfigFilter(&hcan, &canfil);
+  HAL_CAN_Start(&hcan);
+  CAN_StartQueues();
+
+  /* Unsolicited PING response to the global address: the uploader waits for it after ENTER */
+  Boot_Ping();
+
+  while (1)
+  {
+    while (CAN_Receive(&frame))
+    {
+      if (BOOT_ID_PGN(frame.id & CAN_FRAME_ID_MASK) == BOOT_PGN_DATA)
+      {
+        Boot_BlockData(&frame);
+      }
+      else if (frame.dlc >= 1U)
+      {
+        Boot_HandleCommand(&frame);
+      }
+    }
+    Boot_ProgramStep();
+
+    /* Nothing received and nothing left to program: sleep until the next
+     * frame; with PRIMASK set a pending interrupt still ends WFI */
+    __disable_irq();
+    if (!CAN_RxPending() && (programSeq == fillSeq))
+    {
+      __WFI();
+    }
+    __enable_irq();
+  }
+}
+
+/**
+  * @brief System Clock Configuration, same as the application (HSE x4:
+  *        HCLK 64 MHz, PCLK1 32 MHz), which MX_CAN_Init() takes the
+  *        prescaler from (boot_can.c)
+  * @retval None
+  */
+void SystemClock_Config(void)
+{
+  RCC_OscInitTypeDef RCC_OscInitStruct = {0};
+  RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+
+  RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+  RCC_OscInitStruct.HSEState = RCC_HSE_ON;
+  RCC_OscInitStruct.HSEPredivValue = RCC_HSE_PREDIV_DIV1;
+  RCC_OscInitStruct.HSIState = RCC_HSI_ON;
+  RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
+  RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSE;
+  RCC_OscInitStruct.PLL.PLLMUL = RCC_PLL_MUL4;
+  if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK|RCC_CLOCKTYPE_SYSCLK
+                              |RCC_CLOCKTYPE_PCLK1|RCC_CLOCKTYPE_PCLK2;
+  RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+  RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV2;
+  RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
+
+  if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/**
+  * @brief CRC Initialization: CRC-32 (0x04C11DB7), reflected in and out, so
+  *        that ~result matches zlib's crc32() on the host
+  * @retval None
+  */
+static void MX_CRC_Init(void)
+{
+  hcrc.Instance = CRC;
+  hcrc.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_ENABLE;
+  hcrc.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_ENABLE;
+  hcrc.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_BYTE;
+  hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+  hcrc.InputDataFormat = CRC_INPUTDATA_FORMAT_BYTES;
+  if (HAL_CRC_Init(&hcrc) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+void HAL_CRC_MspInit(CRC_HandleTypeDef *crcHandle)
+{
+  if (crcHandle->Instance == CRC)
+  {
+    __HAL_RCC_CRC_CLK_ENABLE();
+  }
+}
+
+/**
+  * @brief  This function is executed in case of error occurrence.
+  * @retval None
+  */
+void Error_Handler(void)
+{
+  __disable_irq();
+  while (1)
+  {
+  }
+}
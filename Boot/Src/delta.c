@@ -0,0 +1,323 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : delta.c
+  * @brief          : Streaming in-place delta patch applier (format in delta.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Plain C without HAL calls: the bootloader passes the memory-mapped
+  * application area and a flash page writer, Tools/candelta passes a RAM copy
+  * of the old image to check every patch it produces with this same code.
+  *
+  * The patch may be fed in pieces of any size; op headers and varints that
+  * straddle two pieces are carried over in the applier state.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "delta.h"
+
+/* Private define ------------------------------------------------------------*/
+enum
+{
+  STATE_HEADER = 0,
+  STATE_OP,
+  STATE_LENGTH,
+  STATE_SOURCE,
+  STATE_RUN_COPY,
+  STATE_RUN_ADD,
+  STATE_ADD_BYTES,
+  STATE_INSERT_BYTES,
+  STATE_ERROR
+};
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t le32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+  * @brief  Collects one varint byte
+  * @retval 1 when the value is complete, 0 if more bytes follow, -1 if too long
+  */
+static int varintByte(Delta_Applier *delta, uint8_t byte)
+{
+  if (delta->shift > 28U)
+  {
+    return -1;
+  }
+  delta->value |= (uint32_t)(byte & 0x7FU) << delta->shift;
+  delta->shift += 7U;
+  if ((byte & 0x80U) != 0U)
+  {
+    return 0;
+  }
+  delta->shift = 0;
+  return 1;
+}
+
+/**
+  * @brief  Reads an old image byte from flash or, if its page has already
+  *         been overwritten, from the history
+  * @retval byte value, -1 if no longer available
+  */
+static int readOld(Delta_Applier *delta, uint32_t offset)
+{
+  uint32_t current = delta->out / DELTA_PAGE_SIZE;
+  uint32_t page = offset / DELTA_PAGE_SIZE;
+
+  if (page >= current)
+  {
+    return delta->image[offset];
+  }
+  if ((page + DELTA_HISTORY_PAGES) < current)
+  {
+    return -1;
+  }
+  return delta->history[((page % DELTA_HISTORY_PAGES) * DELTA_PAGE_SIZE) + (offset % DELTA_PAGE_SIZE)];
+}
+
+/**
+  * @brief  Writes the assembled page, keeping the old one in the history first
+  */
+static int flushPage(Delta_Applier *delta, uint32_t length)
+{
+  uint32_t offset = ((delta->out - 1U) / DELTA_PAGE_SIZE) * DELTA_PAGE_SIZE;
+  uint32_t slot = ((offset / DELTA_PAGE_SIZE) % DELTA_HISTORY_PAGES) * DELTA_PAGE_SIZE;
+
+  memcpy(&delta->history[slot], &delta->image[offset], DELTA_PAGE_SIZE);
+  return (delta->write(offset, delta->page, length) == 0) ? DELTA_OK : DELTA_ERR_WRITE;
+}
+
+static int emit(Delta_Applier *delta, uint8_t byte)
+{
+  delta->page[delta->out % DELTA_PAGE_SIZE] = byte;
+  delta->out++;
+  if ((delta->out % DELTA_PAGE_SIZE) == 0U)
+  {
+    return flushPage(delta, DELTA_PAGE_SIZE);
+  }
+  return DELTA_OK;
+}
+
+static int parseHeader(Delta_Applier *delta)
+{
+  delta->oldSize = le32(&delta->header[4]);
+  delta->oldCrc = le32(&delta->header[8]);
+  delta->newSize = le32(&delta->header[12]);
+  delta->newCrc = le32(&delta->header[16]);
+
+  if ((le32(&delta->header[0]) != DELTA_MAGIC) ||
+      (delta->oldSize == 0U) || (delta->oldSize > BOOT_APP_MAX_SIZE) ||
+      (delta->newSize == 0U) || (delta->newSize > BOOT_APP_MAX_SIZE))
+  {
+    return DELTA_ERR_FORMAT;
+  }
+  if (delta->crc(delta->image, delta->oldSize) != delta->oldCrc)
+  {
+    return DELTA_ERR_BASE;
+  }
+  return DELTA_OK;
+}
+
+static int feedByte(Delta_Applier *delta, uint8_t byte)
+{
+  int value;
+  int result = DELTA_OK;
+
+  switch (delta->state)
+  {
+    case STATE_HEADER:
+      delta->header[delta->headerFill++] = byte;
+      if (delta->headerFill == DELTA_HEADER_SIZE)
+      {
+        result = parseHeader(delta);
+        delta->state = STATE_OP;
+      }
+      break;
+
+    case STATE_OP:
+      if ((delta->out >= delta->newSize) || ((byte != DELTA_OP_ADD) && (byte != DELTA_OP_INSERT)))
+      {
+        return DELTA_ERR_FORMAT;
+      }
+      delta->op = byte;
+      delta->value = 0;
+      delta->state = STATE_LENGTH;
+      break;
+
+    case STATE_LENGTH:
+      value = varintByte(delta, byte);
+      if (value <= 0)
+      {
+        return (value < 0) ? DELTA_ERR_FORMAT : DELTA_OK;
+      }
+      if ((delta->value == 0U) || (delta->value > (delta->newSize - delta->out)))
+      {
+        return DELTA_ERR_FORMAT;
+      }
+      delta->remaining = delta->value;
+      delta->opLeft = delta->value;
+      delta->value = 0;
+      delta->state = (delta->op == DELTA_OP_INSERT) ? STATE_INSERT_BYTES : STATE_SOURCE;
+      break;
+
+    case STATE_SOURCE:
+      value = varintByte(delta, byte);
+      if (value <= 0)
+      {
+        return (value < 0) ? DELTA_ERR_FORMAT : DELTA_OK;
+      }
+      {
+        int32_t rel = (int32_t)(delta->value >> 1) ^ -(int32_t)(delta->value & 1U);
+        int64_t source = (int64_t)delta->out + rel;
+
+        if ((source < 0) || ((source + delta->opLeft) > (int64_t)delta->oldSize))
+        {
+          return DELTA_ERR_FORMAT;
+        }
+        delta->source = (uint32_t)source;
+      }
+      delta->value = 0;
+      delta->state = STATE_RUN_COPY;
+      break;
+
+    case STATE_RUN_COPY:
+      value = varintByte(delta, byte);
+      if (value <= 0)
+      {
+        return (value < 0) ? DELTA_ERR_FORMAT : DELTA_OK;
+      }
+      if (delta->value > delta->opLeft)
+      {
+        return DELTA_ERR_FORMAT;
+      }
+      delta->opLeft -= delta->value;
+      while ((delta->value != 0U) && (result == DELTA_OK))
+      {
+        value = readOld(delta, delta->source++);
+        result = (value < 0) ? DELTA_ERR_FORMAT : emit(delta, (uint8_t)value);
+        delta->value--;
+      }
+      delta->state = (delta->opLeft != 0U) ? STATE_RUN_ADD : STATE_OP;
+      break;
+
+    case STATE_RUN_ADD:
+      value = varintByte(delta, byte);
+      if (value <= 0)
+      {
+        return (value < 0) ? DELTA_ERR_FORMAT : DELTA_OK;
+      }
+      if ((delta->value == 0U) || (delta->value > delta->opLeft))
+      {
+        return DELTA_ERR_FORMAT;
+      }
+      delta->remaining = delta->value;
+      delta->value = 0;
+      delta->state = STATE_ADD_BYTES;
+      break;
+
+    case STATE_ADD_BYTES:
+      value = readOld(delta, delta->source++);
+      if (value < 0)
+      {
+        return DELTA_ERR_FORMAT;
+      }
+      result = emit(delta, (uint8_t)(value + byte));
+      delta->opLeft--;
+      if (--delta->remaining == 0U)
+      {
+        delta->state = (delta->opLeft != 0U) ? STATE_RUN_COPY : STATE_OP;
+      }
+      break;
+
+    case STATE_INSERT_BYTES:
+      result = emit(delta, byte);
+      if (--delta->remaining == 0U)
+      {
+        delta->state = STATE_OP;
+      }
+      break;
+
+    default:
+      return DELTA_ERR_FORMAT;
+  }
+  return result;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Prepares an applier for a new patch
+  * @param  delta: applier state (holds the page and history buffers)
+  * @param  image: installed image, read directly and overwritten through write
+  * @param  write: page writer
+  * @param  crc: CRC-32 used to check the installed image against the header
+  * @retval None
+  */
+void Delta_Init(Delta_Applier *delta, const uint8_t *image, Delta_WriteFn write, Delta_CrcFn crc)
+{
+  memset(delta, 0, offsetof(Delta_Applier, page));
+  delta->image = image;
+  delta->write = write;
+  delta->crc = crc;
+  delta->state = STATE_HEADER;
+}
+
+/**
+  * @brief  Applies the next piece of the patch
+  * @param  delta: applier state
+  * @param  data: patch bytes
+  * @param  length: number of bytes
+  * @retval DELTA_OK or a DELTA_ERR_ code; errors are sticky
+  */
+int Delta_Feed(Delta_Applier *delta, const uint8_t *data, uint32_t length)
+{
+  uint32_t i;
+  int result = DELTA_OK;
+
+  if (delta->state == STATE_ERROR)
+  {
+    return DELTA_ERR_FORMAT;
+  }
+  for (i = 0; (i < length) && (result == DELTA_OK); i++)
+  {
+    result = feedByte(delta, data[i]);
+  }
+  if (result != DELTA_OK)
+  {
+    delta->state = STATE_ERROR;
+  }
+  return result;
+}
+
+/**
+  * @brief  Checks that the patch is complete and writes the last partial page
+  * @param  delta: applier state
+  * @retval DELTA_OK or a DELTA_ERR_ code
+  */
+int Delta_Finish(Delta_Applier *delta)
+{
+  if ((delta->state != STATE_OP) || (delta->out != delta->newSize))
+  {
+    return DELTA_ERR_FORMAT;
+  }
+  if ((delta->out % DELTA_PAGE_SIZE) != 0U)
+  {
+    return flushPage(delta, delta->out % DELTA_PAGE_SIZE);
+  }
+  return DELTA_OK;
+}
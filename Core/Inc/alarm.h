@@ -0,0 +1,131 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : alarm.h
+  * @brief          : Temperature alarms on the ADC1 analog watchdog, alarm PGN
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Analog watchdog 1 watches the temperature sensor channel in hardware, so
+  * the conversion that leaves the window raises the ADC interrupt and the
+  * alarm goes out from there; nothing compares readings in software. The
+  * window is the range of raw codes for the thresholds PARAM_ALARM_HIGH and
+  * PARAM_ALARM_LOW (0.1 degC, the temperature as PGN 130312 reports it,
+  * PARAM_TEMP_OFFSET included), translated through the factory calibration
+  * words as temperature.c reads them. The sensor's codes fall as the
+  * temperature rises, so the high threshold is the window's low edge.
+  *
+  * The interrupt moves the window for the hysteresis: in a high alarm the
+  * window runs from PARAM_ALARM_HYST below the high threshold to the hot
+  * end, in a low alarm from the cold end to the hysteresis above the low
+  * threshold, so the next interrupt is the clearing one. A threshold
+  * counts as crossed one code past its own code (about 0.2 degC).
+  *
+  * Alarm, PGN 65282 (proprietary B, single frame), priority 1, from
+  * PARAM_SOURCE_ADDRESS on every change and on ISO request:
+  *
+  *   byte 0      ALARM_STATE_x
+  *   byte 1      changes so far, modulo 256
+  *   byte 2..3   temperature of the conversion, 0.01 K, as in PGN 130312
+  *   byte 4..5   raw code of the conversion
+  *   byte 6      ALARM_FLAG_x, reserved bits 1
+  *   byte 7      reserved, 0xFF
+  *
+  * A change goes into the first free mailbox ahead of the TX queue, from
+  * the CAN TX interrupt, as the ping echoes do (ping.h). Alarms are off,
+  * and the flag says so, while the calibration words are equal or the low
+  * threshold is not below the high one.
+  *
+  * The codec at the top has no HAL dependencies and is compiled into the
+  * host tools with BOOT_HOST (Tools/alarmcodes.c).
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __ALARM_H
+#define __ALARM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define ALARM_PGN               65282UL   /* 0xFF02, proprietary B */
+#define ALARM_PRIO              1UL
+
+#define ALARM_CODE_MAX          4095U     /* 12-bit conversions */
+
+#define ALARM_STATE_NORMAL      0U
+#define ALARM_STATE_HIGH        1U
+#define ALARM_STATE_LOW         2U
+
+/* Alarm byte 6 */
+#define ALARM_FLAG_REQUEST      0x01U     /* answers an ISO request, no change */
+#define ALARM_FLAG_OFF          0x02U     /* no valid window, alarms off */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Thresholds as raw codes on a scale that rises with the
+  *        temperature: the code itself or, for a sensor whose codes fall,
+  *        ALARM_CODE_MAX less it
+  */
+typedef struct
+{
+  uint16_t high;          /* above: high alarm */
+  uint16_t highClear;     /* below, in a high alarm: cleared */
+  uint16_t low;           /* below: low alarm */
+  uint16_t lowClear;      /* above, in a low alarm: cleared */
+  uint8_t  falling;       /* codes fall as the temperature rises */
+  uint8_t  valid;
+} Alarm_Codes;
+
+/**
+  * @brief Alarm counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t interrupts;    /* analog watchdog interrupts */
+  uint32_t raised;        /* high or low alarms */
+  uint32_t cleared;       /* back to normal */
+  uint32_t queued;        /* alarm messages handed to the TX interrupt */
+  uint32_t lost;          /* overwritten before a mailbox freed, or silent */
+} Alarm_Stats;
+
+/* Exported functions prototypes ---------------------------------------------*/
+uint16_t Alarm_Code(int32_t centiC, uint16_t cal30, uint16_t cal110);
+int32_t Alarm_CentiC(uint16_t code, uint16_t cal30, uint16_t cal110);
+uint8_t Alarm_Thresholds(Alarm_Codes *codes, int32_t highDeciC, int32_t lowDeciC, int32_t hystDeciC,
+                         int32_t offsetCentiK, uint16_t cal30, uint16_t cal110);
+uint8_t Alarm_Classify(const Alarm_Codes *codes, uint8_t state, uint16_t code);
+void Alarm_Window(const Alarm_Codes *codes, uint8_t state, uint16_t *lowCode, uint16_t *highCode);
+
+#ifndef BOOT_HOST
+#include "can.h"
+
+extern volatile Alarm_Stats alarmStats;
+
+void Alarm_Init(void);
+void Alarm_Poll(void);
+void Alarm_IRQ(void);
+uint8_t Alarm_Next(CAN_Frame *frame);
+uint8_t Alarm_State(void);
+void Alarm_SendState(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ALARM_H */
@@ -0,0 +1,125 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : boot.h
+  * @brief          : CAN bootloader flash map and protocol, shared by the
+  *                   bootloader, the application and the host uploader
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Protocol (all frames 29-bit, addressed, DLC 8):
+  *
+  *   Commands and responses use PGN 61184 (Proprietary A, 0xEF00), priority 6:
+  *     byte 0      command (host -> node) or command | BOOT_RSP (node -> host)
+  *     byte 1..7   arguments, little endian
+  *
+  *   Image data uses PGN 126720 (Proprietary A2, 0x1EF00), priority 7, eight
+  *   payload bytes per frame with no header: a BLOCK command announces block
+  *   number and CRC, and the next ceil(length / 8) data frames carry it. CAN
+  *   keeps one sender's frames in order, so a lost frame shows up as a block
+  *   CRC error and the block is sent again.
+  *
+  *   PING   -> [rsp, status, version, window, block size / 256, app valid, app max KB]
+  *   START  size[1..3] crc32[4..7]  -> erases the application area, [rsp, status]
+  *   BLOCK  block[1..2] crc32[3..6] -> [rsp, status, block lo, block hi] once the
+  *          block is programmed and read back
+  *   END    -> verifies the whole image, writes the vector table last,
+  *             [rsp, status, crc32[2..5]]
+  *   RUN    -> [rsp, status], then resets into the application
+  *   DELTA  size[1..3] -> opens a patch session instead of START; the blocks
+  *          carry a delta patch (Boot/Inc/delta.h) and must arrive in order
+  *   ENTER  (to the application) -> resets into the bootloader
+  *   PARAM_GET/PARAM_SET (0x10/0x11, to the application) -> see params.h
+  *
+  * Up to BOOT_WINDOW blocks may be outstanding without a response: block k+1
+  * is received while block k is being programmed. DELTA sessions rewrite
+  * pages while blocks are processed and allow only one.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* Flash map: bootloader in pages 0-3, application behind it, parameter
+ * store (params.h) in the last two pages */
+#define BOOT_FLASH_BASE         0x08000000UL
+#define BOOT_SIZE               0x2000UL
+#define BOOT_APP_BASE           (BOOT_FLASH_BASE + BOOT_SIZE)
+#define BOOT_APP_MAX_SIZE       (52UL * 1024UL)
+#define BOOT_PAGE_SIZE          2048UL
+
+#define BOOT_VERSION            2U        /* 2: DELTA */
+#define BOOT_BLOCK_SIZE         1024U
+#define BOOT_WINDOW             4U        /* block buffers = blocks in flight */
+
+/* Service address of this node for bootloader and parameter commands; also
+ * the default T1 source address (PARAM_SOURCE_ADDRESS) */
+#define BOOT_NODE_ADDRESS       0x01U
+
+/* RTC backup register value asking the bootloader to stay resident */
+#define BOOT_REQUEST_MAGIC      0xB007B007UL
+
+#define BOOT_PGN_CMD            0x0EF00UL
+#define BOOT_PGN_DATA           0x1EF00UL
+#define BOOT_PRIO_CMD           6UL
+#define BOOT_PRIO_DATA          7UL
+
+/* 29-bit identifier of an addressed (PDU1) frame */
+#define BOOT_CAN_ID(prio, pgn, da, sa) \
+  (((uint32_t)(prio) << 26) | ((uint32_t)(pgn) << 8) | ((uint32_t)(da) << 8) | (uint32_t)(sa))
+#define BOOT_ID_PGN(id)         ((((id) >> 8) & 0x3FF00UL))
+#define BOOT_ID_DA(id)          (((id) >> 8) & 0xFFU)
+#define BOOT_ID_SA(id)          ((id) & 0xFFU)
+
+/* Commands */
+#define BOOT_CMD_PING           0x01U
+#define BOOT_CMD_ENTER          0x02U
+#define BOOT_CMD_START          0x03U
+#define BOOT_CMD_BLOCK          0x04U
+#define BOOT_CMD_END            0x05U
+#define BOOT_CMD_RUN            0x06U
+#define BOOT_CMD_DELTA          0x07U
+#define BOOT_RSP                0x80U
+
+/* Response status */
+#define BOOT_OK                 0x00U
+#define BOOT_ERR_CRC            0x01U     /* block CRC mismatch, resend */
+#define BOOT_ERR_INCOMPLETE     0x02U     /* next BLOCK arrived before all data */
+#define BOOT_ERR_RANGE          0x03U     /* size or block number out of range */
+#define BOOT_ERR_FLASH          0x04U     /* erase/program/read-back failed */
+#define BOOT_ERR_BUSY           0x05U     /* no free block buffer */
+#define BOOT_ERR_STATE          0x06U     /* command not valid now */
+#define BOOT_ERR_VERIFY         0x07U     /* image CRC mismatch at END */
+#define BOOT_ERR_PATCH          0x08U     /* malformed delta patch */
+#define BOOT_ERR_BASE           0x09U     /* installed image is not the patch base */
+#define BOOT_ERR_SEQUENCE       0x0AU     /* delta block ahead of the next expected one */
+
+/* Exported functions prototypes ---------------------------------------------*/
+#ifndef BOOT_HOST
+#include "can.h"
+
+void Boot_HandleFrame(const CAN_Frame *frame);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOT_H */
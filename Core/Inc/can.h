@@ -35,13 +35,61 @@ extern "C" {
 extern CAN_HandleTypeDef hcan;
 
 /* USER CODE BEGIN Private defines */
+/* Software queue depths (frames, power of two) */
+#define CAN_RX_QUEUE_LEN      32U
+#define CAN_TX_QUEUE_LEN      16U
 
+/* Flags carried in CAN_Frame.id above the 29-bit identifier */
+#define CAN_FRAME_EXT         0x80000000UL
+#define CAN_FRAME_RTR         0x40000000UL
+#define CAN_FRAME_ID_MASK     0x1FFFFFFFUL
+
+/**
+  * @brief Compact CAN frame as stored in the RX/TX queues (16 bytes)
+  */
+typedef struct
+{
+  uint32_t id;        /* identifier | CAN_FRAME_EXT | CAN_FRAME_RTR */
+  uint8_t  dlc;       /* data length code (0..8) */
+  uint8_t  filter;    /* RX: filter match index */
+  uint16_t time;      /* RX: bxCAN time stamp, bit times at the start of
+                         frame (time-triggered mode, ping.h), milliseconds
+                         modulo 60000 with SLCAN_ENABLE */
+  uint8_t  data[8];
+} CAN_Frame;
+
+/**
+  * @brief Traffic counters maintained by the CAN interrupt handlers
+  */
+typedef struct
+{
+  uint32_t rxFrames;    /* frames moved from FIFO0 into the RX queue */
+  uint32_t rxDropped;   /* frames lost because the RX queue was full */
+  uint32_t rxOverruns;  /* hardware FIFO0 overrun events */
+  uint32_t txFrames;    /* frames handed to a transmit mailbox */
+  uint32_t txDropped;   /* frames rejected because the TX queue was full */
+  uint32_t txSilenced;  /* frames discarded in silent mode (CAN_SetSilent) */
+  uint32_t txFailed;    /* mailboxes completed without TXOK: arbitration lost or
+                           error, not retried (NART) */
+} CAN_Stats;
+
+extern volatile CAN_Stats canStats;
 /* USER CODE END Private defines */
 
 void MX_CAN_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-
+void CAN_StartQueues(void);
+HAL_StatusTypeDef CAN_Transmit(const CAN_TxHeaderTypeDef *header, const uint8_t *data);
+HAL_StatusTypeDef CAN_TransmitFrame(const CAN_Frame *frame);
+uint8_t CAN_Receive(CAN_Frame *frame);
+uint8_t CAN_RxPending(void);
+uint32_t CAN_LastRxTick(void);
+uint32_t CAN_TxQueueFree(void);
+void CAN_RxFifo0_IRQ(void);
+void CAN_TxMailbox_IRQ(void);
+void CAN_SetSilent(uint8_t on);
+uint8_t CAN_Silent(void);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
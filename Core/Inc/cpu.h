@@ -0,0 +1,180 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : cpu.h
+  * @brief          : CPU time accounting and load figures, diagnostics PGN
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Time is counted in core cycles on DWT->CYCCNT, started by Cpu_Init(),
+  * and split into:
+  *
+  *   idle     the scheduler's idle wait (scheduler.h), Sleep or polling,
+  *            less the handlers taken during it
+  *   stop     Stop mode, where CYCCNT does not count; the scheduler's
+  *            stopUs, converted at SystemCoreClock. The RTC measures it
+  *            in whole milliseconds, so each Stop reads up to 1 ms short;
+  *            the clock restart after it runs from the 8 MHz HSI and
+  *            counts as idle at that rate, a ninth of its 1.2 ms
+  *   sources  the interrupt handlers and the polled temperature conversion,
+  *            each bracketed by Cpu_Enter()/Cpu_Exit(), less the handlers
+  *            that preempted it, so nothing is counted twice
+  *   busy     the rest: tasks and the scheduler itself
+  *
+  * so the four add up to the time since Cpu_Init(). A handler costs two
+  * counter reads and a few adds, each with interrupts masked; the exception
+  * entry and exit, about 12 cycles each, fall to the code interrupted.
+  * The scheduler closes a window on the first pass CPU_WINDOW_MS or more
+  * after the last one and keeps the busy share of the last CPU_WINDOWS
+  * windows, giving the load over 1 s, 10 s and 60 s (fewer windows until
+  * that many have closed).
+  *
+  * Diagnostics, PGN 65281 (proprietary B, single frame), priority 7, from
+  * PARAM_SOURCE_ADDRESS every PARAM_DIAG_MS and on ISO request:
+  *
+  *   byte 0..1   load over the last window, 0.1 %
+  *   byte 2..3   load over the last 10 windows, 0.1 %
+  *   byte 4..5   load over the last 60 windows, 0.1 %
+  *   byte 6      handler share of the last window, 0.5 %
+  *   byte 7      CPU_DIAG_x flags, reserved bits 1
+  *
+  * Loads are 0xFFFF and the handler share 0xFF until the first window has
+  * closed. The 32-bit counter wraps after about 67 s at 64 MHz; the
+  * scheduler reads it on every pass, far more often.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CPU_H
+#define __CPU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define CPU_PGN_DIAG            65281UL   /* 0xFF01, proprietary B */
+#define CPU_PRIO_DIAG           7UL
+
+#define CPU_WINDOW_MS           1000U
+#define CPU_WINDOWS             60U       /* windows kept, the longest figure */
+
+#define CPU_LOAD_NA             0xFFFFU
+#define CPU_SHARE_NA            0xFFU
+
+/* Diagnostics byte 7 */
+#define CPU_DIAG_FULL           0x01U     /* CPU_WINDOWS windows have closed */
+#define CPU_DIAG_STOP           0x02U     /* Stop mode in the last window */
+
+/* Accounted sections */
+#define CPU_SRC_CAN_RX          0U
+#define CPU_SRC_CAN_TX          1U
+#define CPU_SRC_CAN_SCE         2U
+#define CPU_SRC_SYSTICK         3U
+#define CPU_SRC_OTHER           4U        /* RTC wake-up, EXTI, ADC, SLCAN */
+#define CPU_SRC_ADC             5U        /* polled conversion, thread mode */
+#define CPU_SOURCES             6U
+#define CPU_SRC_HANDLERS        5U        /* sources below are handlers */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Cycles since Cpu_Init() and load figures, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint64_t totalCycles;               /* Stop mode included */
+  uint64_t idleCycles;
+  uint64_t stopCycles;
+  uint64_t cycles[CPU_SOURCES];       /* CPU_SRC_x */
+  uint32_t counts[CPU_SOURCES];
+  uint32_t nested;                    /* cycles of all sections, wraps */
+  uint32_t windows;                   /* windows closed */
+  uint16_t load1;                     /* 0.1 %, CPU_LOAD_NA before a window */
+  uint16_t load10;
+  uint16_t load60;
+  uint8_t  handlerShare;              /* 0.5 %, last window */
+  uint8_t  flags;                     /* CPU_DIAG_x, last window */
+  uint32_t diags;                     /* diagnostics messages queued */
+} Cpu_Stats;
+
+/**
+  * @brief State of one section between Cpu_Enter() and Cpu_Exit()
+  */
+typedef struct
+{
+  uint32_t start;
+  uint32_t nested;
+} Cpu_Section;
+
+/* Exported functions prototypes ---------------------------------------------*/
+extern Cpu_Stats cpuStats;
+
+#ifndef BOOT_HOST
+#include "stm32f3xx_hal.h"
+
+#ifndef CPU_CYCLES
+#define CPU_CYCLES()            (DWT->CYCCNT)
+#endif
+
+/**
+  * @brief  Starts a section; first thing in a handler
+  * @param  s: section state, on the caller's stack
+  * @retval None
+  *
+  * Forced inline, like Cpu_Exit(), so the CCM RAM handlers stay in CCM RAM.
+  */
+__STATIC_FORCEINLINE void Cpu_Enter(Cpu_Section *s)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  /* Both read with no handler in between */
+  __disable_irq();
+  s->start = CPU_CYCLES();
+  s->nested = cpuStats.nested;
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Ends a section and books its cycles, less those of the sections
+  *         that preempted it; last thing in a handler
+  * @param  s: section state from Cpu_Enter()
+  * @param  source: CPU_SRC_x
+  * @retval None
+  */
+__STATIC_FORCEINLINE void Cpu_Exit(const Cpu_Section *s, uint32_t source)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t own;
+
+  __disable_irq();
+  own = (CPU_CYCLES() - s->start) - (cpuStats.nested - s->nested);
+  cpuStats.nested += own;
+  cpuStats.cycles[source] += own;
+  cpuStats.counts[source]++;
+  __set_PRIMASK(primask);
+}
+
+void Cpu_Init(void);
+void Cpu_Update(void);
+void Cpu_IdleEnter(Cpu_Section *s);
+void Cpu_IdleExit(const Cpu_Section *s);
+void Cpu_SendDiag(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CPU_H */
@@ -0,0 +1,169 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : crash.h
+  * @brief          : Fault and Error_Handler capture with a crash report
+  *                   over CAN
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * HardFault, MemManage, BusFault, UsageFault and Error_Handler() save a
+  * Crash_Report in the last CRASH_NOINIT_SIZE bytes of CCMRAM, which neither
+  * the startup code nor the bootloader writes, and reset the node at once.
+  * The report holds the stacked registers, the fault status registers,
+  * CRASH_STACK_WORDS words of the stack above the exception frame and the
+  * last CRASH_TRACE_EVENTS events of the trace RAM log (trace.h). A CRC
+  * tells a saved report from what CCMRAM holds after power-on.
+  *
+  * Retrieval uses the bootloader command PGN (boot.h), addressed to
+  * BOOT_NODE_ADDRESS, and the transfer of the temperature history
+  * (history.h):
+  *
+  *   CRASH_GET    -> [rsp, status, kind, bytes lo, bytes hi, crc16 lo,
+  *                    crc16 hi, 0xFF]
+  *                   then ceil(bytes / 7) frames on the data PGN, each
+  *                   [frame number, 7 bytes] of the Crash_Report, little
+  *                   endian, unused bytes of the last frame 0xFF
+  *   CRASH_CLEAR  -> [rsp, status]   forgets the report
+  *
+  * After a reset with a report not sent yet, the node sends it once, as
+  * the response to a CRASH_GET from the global address 0xFF. The report is
+  * kept for later requests until cleared or overwritten by the next crash.
+  * The data frames of a crash report wait for a history transfer to end.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CRASH_H
+#define __CRASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define CRASH_NOINIT_SIZE       512U      /* .noinit region of the linker scripts */
+#define CRASH_STACK_WORDS       16U
+#define CRASH_TRACE_EVENTS      16U
+#define CRASH_MAGIC             0x48535243UL  /* "CRSH" */
+
+/* Report kinds; plain numbers, they are pasted into assembly */
+#define CRASH_KIND_HARDFAULT    1
+#define CRASH_KIND_MEMMANAGE    2
+#define CRASH_KIND_BUSFAULT     3
+#define CRASH_KIND_USAGEFAULT   4
+#define CRASH_KIND_ERROR        5         /* Error_Handler(), pc is its caller */
+
+#define CRASH_CMD_GET           0x40U
+#define CRASH_CMD_CLEAR         0x41U
+
+#define CRASH_OK                0U
+#define CRASH_ERR_NONE          1U        /* no report saved */
+#define CRASH_ERR_BUSY          2U        /* sending to another node */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Crash report, sent as is; registers 0 when not captured
+  */
+typedef struct
+{
+  uint8_t kind;           /* CRASH_KIND_x */
+  uint8_t task;           /* running scheduler task (watchdog.h), 0xFF none */
+  uint8_t stackWords;     /* valid words in stack[] */
+  uint8_t traceEvents;    /* valid records in trace[] */
+  uint32_t uptimeMs;      /* HAL_GetTick() */
+  uint32_t excReturn;     /* EXC_RETURN, 0 for Error_Handler() */
+  uint32_t r0;            /* exception frame */
+  uint32_t r1;
+  uint32_t r2;
+  uint32_t r3;
+  uint32_t r12;
+  uint32_t lr;
+  uint32_t pc;
+  uint32_t xpsr;
+  uint32_t sp;            /* stack pointer before the exception */
+  uint32_t cfsr;
+  uint32_t hfsr;
+  uint32_t mmfar;
+  uint32_t bfar;
+  uint32_t stack[CRASH_STACK_WORDS];  /* from sp up */
+  struct
+  {
+    uint32_t event;       /* Trace_Record, oldest first */
+    uint32_t time;
+  } trace[CRASH_TRACE_EVENTS];
+} Crash_Report;
+
+/**
+  * @brief Report as kept in the .noinit region
+  */
+typedef struct
+{
+  uint32_t magic;         /* CRASH_MAGIC while a report is saved */
+  uint16_t crc;           /* CRC-16/CCITT of the report, as in the response */
+  uint8_t reported;       /* start-up report sent */
+  uint8_t reserved;
+  Crash_Report report;
+} Crash_Record;
+
+/**
+  * @brief Transfer counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t requests;      /* CRASH_GET answered */
+  uint32_t frames;        /* data frames queued */
+} Crash_Stats;
+
+/* Exported macro ------------------------------------------------------------*/
+#define CRASH_STR_(x)           #x
+#define CRASH_STR(x)            CRASH_STR_(x)
+
+/**
+  * @brief First and only statement of a fault handler declared CRASH_NAKED:
+  *        passes the exception frame, the kind and EXC_RETURN to
+  *        Crash_Fault() before anything is pushed
+  */
+#ifndef CRASH_FAULT_ENTRY
+#define CRASH_NAKED             __attribute__((naked))
+#define CRASH_FAULT_ENTRY(kind)                 \
+  __asm volatile ("tst lr, #4               \n" \
+                  "ite eq                   \n" \
+                  "mrseq r0, msp            \n" \
+                  "mrsne r0, psp            \n" \
+                  "movs r1, #" CRASH_STR(kind) "\n" \
+                  "mov r2, lr               \n" \
+                  "b Crash_Fault            \n")
+#endif
+
+/* Exported functions prototypes ---------------------------------------------*/
+#ifndef BOOT_HOST
+#include "can.h"
+
+extern Crash_Record crashRecord;
+extern Crash_Stats crashStats;
+
+void Crash_Init(void);
+void Crash_Fault(const uint32_t *frame, uint32_t kind, uint32_t excReturn) __attribute__((__noreturn__, __used__));
+void Crash_Error(uint32_t caller) __attribute__((__noreturn__));
+void Crash_HandleFrame(const CAN_Frame *frame);
+uint8_t Crash_Poll(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRASH_H */
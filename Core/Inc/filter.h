@@ -0,0 +1,112 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : filter.h
+  * @brief          : Temperature sensor filter stage on CMSIS-DSP kernels
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * With PARAM_FILTER_MODE other than off, every T1 period takes a batch of
+  * PARAM_FILTER_BATCH polled conversions back to back and reduces it to the
+  * one value PGN 130312 reports:
+  *
+  *   FILTER_MODE_OFF     the single conversion, as without a filter
+  *   FILTER_MODE_MEAN    mean of the batch, arm_mean_q15()
+  *   FILTER_MODE_IIR     second-order Butterworth low-pass, one
+  *                       arm_biquad_cascade_df1_q31() stage, run over the
+  *                       conversions as one evenly spaced stream; the value
+  *                       is its output at the last conversion of the batch
+  *   FILTER_MODE_MEDIAN  median of the batch, the middle two averaged for an
+  *                       even batch (no CMSIS kernel)
+  *
+  * The IIR cutoff, PARAM_FILTER_CUTOFF, is in per mille of the conversion
+  * rate as the filter sees it, so 50 is 0.05 conversions: at the default
+  * batch of 8 a step settles in about 4 T1 periods. Its coefficients are
+  * worked out in float when the parameters change, in Q2.30 (postShift 1)
+  * with b1 trimmed for a DC gain of exactly one, and the state starts at
+  * the first conversion so there is no run-up from zero. A parameter change
+  * starts the filter again.
+  *
+  * Conversions go in as codes scaled up by 3 bits (q15) for the mean and 18
+  * bits (q31, headroom for the overshoot) for the IIR. Values come out in
+  * eighths of a code, FILTER_FRAC_BITS, which keeps the extra resolution of
+  * the average for the temperature.
+  *
+  * The codec at the top has no HAL dependencies and is compiled into the
+  * host tools with BOOT_HOST (Tools/tempfilter.c), on the same CMSIS-DSP
+  * sources with the simulator's stand-ins for the SIMD intrinsics.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FILTER_H
+#define __FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#ifndef BOOT_HOST
+#include "stm32f3xx.h"    /* __FPU_PRESENT before core_cm4.h */
+#endif
+#include "arm_math.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define FILTER_MODE_OFF         0U
+#define FILTER_MODE_MEAN        1U
+#define FILTER_MODE_IIR         2U
+#define FILTER_MODE_MEDIAN      3U
+#define FILTER_MODES            4U
+
+#define FILTER_BATCH_MAX        16U       /* conversions per T1 period */
+#define FILTER_CUTOFF_MIN       5U        /* per mille of the conversion rate */
+#define FILTER_CUTOFF_MAX       400U
+
+#define FILTER_FRAC_BITS        3U        /* values in 1/8 code */
+#define FILTER_IIR_SHIFT        18U       /* code to q31 */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief One filter; Filter_Configure() before the first Filter_Run()
+  */
+typedef struct
+{
+  arm_biquad_casd_df1_inst_q31 iir;
+  q31_t coeffs[5];        /* b0, b1, b2, a1, a2 as arm_biquad_cascade_df1_q31() takes them */
+  q31_t state[4];         /* x[n-1], x[n-2], y[n-1], y[n-2] */
+  union
+  {
+    q15_t q15[FILTER_BATCH_MAX];
+    q31_t q31[FILTER_BATCH_MAX];
+    uint16_t codes[FILTER_BATCH_MAX];
+  } work;
+  uint8_t mode;           /* FILTER_MODE_x */
+  uint8_t batch;          /* conversions per Filter_Run(), 1 when off */
+  uint8_t primed;         /* IIR state holds a conversion */
+} Filter_State;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Filter_Configure(Filter_State *filter, uint32_t mode, uint32_t batch, uint32_t cutoffPermille);
+uint32_t Filter_Batch(const Filter_State *filter);
+uint32_t Filter_Run(Filter_State *filter, const uint16_t *codes, uint32_t count);
+
+#ifndef BOOT_HOST
+uint32_t Filter_Read(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FILTER_H */
@@ -0,0 +1,154 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : history.h
+  * @brief          : Temperature history ring, block format and bulk
+  *                   retrieval over CAN, shared with the host tools
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Every T1 sample (0.01 K, as sent in PGN 130312) is appended to a ring of
+  * HISTORY_BLOCKS fixed-size blocks in RAM; when the ring is full the oldest
+  * block is dropped. A block holds samples taken at a constant interval:
+  *
+  *   header   start (uptime ms of the first sample), interval ms, first
+  *            value, sample count, payload length (12 bytes, little endian)
+  *   payload  varint tokens (7 bits per byte, low bits first):
+  *              1..7     that many samples equal to the previous one
+  *              0, n     n samples equal to the previous one
+  *              8 and up zigzag(value - previous value) + 7, one sample
+  *
+  * A steady temperature costs two or three bytes per run; a change of up to
+  * 0.60 K, a few ADC steps, costs one byte. A block is closed when it is full, when a sample does
+  * not arrive on the block's interval (T1 period changed, overrun) and when
+  * history is requested, so a closed block never changes again.
+  *
+  * Retrieval uses the bootloader command PGN (boot.h), addressed to
+  * BOOT_NODE_ADDRESS:
+  *
+  *   HIST_GET  from[1..3] to[4..6]  seconds of uptime, to 0xFFFFFF = now
+  *             -> [rsp, status, blocks, bytes lo, bytes hi, now[5..7] seconds]
+  *   then ceil(bytes / 7) frames on the data PGN to the requester, each
+  *   [frame number mod 256, 7 bytes], carrying the header and payload of
+  *   every closed block that overlaps the range, oldest first, unused bytes
+  *   of the last frame 0xFF, and finally
+  *   HIST_END  [rsp, status, crc16 lo, crc16 hi] (CRC-16/CCITT of the bytes)
+  *
+  * Frames are queued from the main loop in bursts of CAN_TX_QUEUE_LEN -
+  * HISTORY_TX_RESERVE, the next once the previous has been sent. bxCAN
+  * sends equal identifiers lowest mailbox first, so frames may arrive out of
+  * order within a burst: the requester places them by frame number.
+  *
+  * Blocks outside the range are skipped by their header alone; the node never
+  * decodes a block, the requester does.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __HISTORY_H
+#define __HISTORY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define HISTORY_BLOCK_SIZE      128U
+#define HISTORY_HEADER_SIZE     12U
+#define HISTORY_PAYLOAD_SIZE    (HISTORY_BLOCK_SIZE - HISTORY_HEADER_SIZE)
+#define HISTORY_BLOCKS          24U       /* 3 KB of RAM */
+
+/* CAN transmit queue entries left free for the periodic messages; the
+ * rest is one burst */
+#define HISTORY_TX_RESERVE      4U
+
+#define HISTORY_CMD_GET         0x20U
+#define HISTORY_CMD_END         0x21U     /* response only, ends a transfer */
+#define HISTORY_TIME_NOW        0xFFFFFFUL
+
+/* HIST_GET and HIST_END status */
+#define HISTORY_OK              0x00U
+#define HISTORY_ERR_BUSY        0x01U     /* transfer to another node running */
+#define HISTORY_ERR_RANGE       0x02U     /* from is after to */
+#define HISTORY_ERR_OVERRUN     0x03U     /* block dropped during the transfer, ask again */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Block header, sent as is (little endian on both ends)
+  */
+typedef struct
+{
+  uint32_t startMs;       /* HAL_GetTick() of the first sample */
+  uint16_t intervalMs;    /* time between samples, 0 while only one */
+  uint16_t first;         /* first sample */
+  uint16_t count;         /* samples in the block */
+  uint16_t length;        /* payload bytes used */
+} History_Header;
+
+typedef struct
+{
+  History_Header header;
+  uint8_t payload[HISTORY_PAYLOAD_SIZE];
+} History_Block;
+
+/**
+  * @brief Append state of the block being filled
+  */
+typedef struct
+{
+  History_Block *block;
+  uint16_t last;          /* newest sample */
+  uint16_t runAt;         /* payload offset of the trailing run token */
+  uint16_t run;           /* samples in that run, 0 = no trailing run */
+} History_Encoder;
+
+/**
+  * @brief Ring counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t samples;       /* samples appended */
+  uint32_t blocks;        /* blocks closed */
+  uint32_t dropped;       /* oldest blocks overwritten */
+  uint32_t gaps;          /* blocks closed early by an off-interval sample */
+  uint32_t requests;      /* HIST_GET served */
+  uint32_t frames;        /* data frames queued */
+  uint32_t overruns;      /* transfers ended by HISTORY_ERR_OVERRUN */
+} History_Stats;
+
+/* Exported functions prototypes ---------------------------------------------*/
+/* Block codec, also built into the host tools */
+void History_BlockStart(History_Encoder *enc, History_Block *block, uint32_t timeMs, uint16_t value);
+uint8_t History_BlockAppend(History_Encoder *enc, uint32_t timeMs, uint16_t value);
+int32_t History_BlockDecode(const History_Header *header, const uint8_t *payload,
+                            uint16_t *values, uint32_t maxValues);
+uint16_t History_Crc16(uint16_t crc, const uint8_t *data, uint32_t length);
+
+#ifndef BOOT_HOST
+#include "can.h"
+
+extern History_Stats historyStats;
+
+void History_Add(uint16_t value);
+void History_HandleFrame(const CAN_Frame *frame);
+uint8_t History_Poll(void);
+uint32_t History_Used(uint32_t *samples, uint32_t *spanMs);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HISTORY_H */
@@ -46,14 +46,29 @@ extern "C" {
 
 /* Exported macro ------------------------------------------------------------*/
 /* USER CODE BEGIN EM */
+/* Placement in the 4 KB core-coupled RAM (zero wait states).
+ * .ccmram is copied from flash and .ccmbss is zeroed by the startup code.
+ * Build with CCMRAM=0 to keep everything in flash/RAM for A/B comparisons. */
+#ifndef CCMRAM_ENABLE
+#define CCMRAM_ENABLE 1
+#endif
 
+#if CCMRAM_ENABLE
+#define CCMRAM_FUNC   __attribute__((section(".ccmram.text"), noinline))
+#define CCMRAM_DATA   __attribute__((section(".ccmram.data")))
+#define CCMRAM_BSS    __attribute__((section(".ccmbss")))
+#else
+#define CCMRAM_FUNC
+#define CCMRAM_DATA
+#define CCMRAM_BSS
+#endif
 /* USER CODE END EM */
 
 /* Exported functions prototypes ---------------------------------------------*/
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
-
+void SystemClock_Config(void); // also restores HSE/PLL after Stop mode
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
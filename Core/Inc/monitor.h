@@ -0,0 +1,197 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : monitor.h
+  * @brief          : Bus monitor: per-identifier traffic statistics
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * During a monitor window the CAN RX interrupt counts every frame read
+  * from FIFO0 in a table of MONITOR_SLOTS entries keyed by the arbitration
+  * field (identifier, IDE and RTR as in CAN_RIxR): frame count, smallest
+  * and largest time between frames in microseconds and the DLCs seen. The
+  * table is open addressing with linear probing and is only cleared as a
+  * whole, so there are no deletions; a frame looks at most at MONITOR_PROBES
+  * slots and is counted as overflow when none holds its identifier or is
+  * free. Times are taken when the interrupt drains the FIFO, so frames read
+  * in one go are a few microseconds apart whatever their spacing on the bus.
+  * The node's own frames are not received and not counted. While a window
+  * runs the node stays awake (Scheduler_KeepAwake()).
+  *
+  * Error interrupts count the bxCAN last error codes (stuff, form,
+  * acknowledgement, bit recessive, bit dominant, CRC) and bus-off entries,
+  * and record the highest error counters.
+  *
+  * With MONITOR_SILENT the bxCAN runs in silent mode for the window: it
+  * neither acknowledges nor sends anything, and frames the node queues
+  * meanwhile are discarded (CAN_SetSilent()). It switches once the TX queue
+  * and the mailboxes are empty, and back for the report; frames on the bus
+  * while the controller passes through initialization mode are missed.
+  * Silent windows and the bus-stress generator (stress.h) exclude each
+  * other.
+  *
+  * Commands on the bootloader command PGN (boot.h), addressed to
+  * BOOT_NODE_ADDRESS:
+  *
+  *   MONITOR_START [cmd, flags, seconds (2 bytes), top n] -> [rsp, status]
+  *                 starts a window, 0 seconds = until MONITOR_STOP; n talkers
+  *                 1..MONITOR_TOP_MAX, 0 = MONITOR_TOP_DEFAULT. A window
+  *                 that ends on time sends its report to the requester, and
+  *                 with MONITOR_REPEAT starts the next one
+  *   MONITOR_STOP  -> [rsp, status]   ends the window
+  *   MONITOR_GET   [cmd, top n] -> [rsp, status, talkers, bytes lo,
+  *                 bytes hi, crc16 lo, crc16 hi, 0xFF]
+  *                 then ceil(bytes / 7) frames on the data PGN, as a crash
+  *                 report (crash.h): a Monitor_Header and the n busiest
+  *                 identifiers as Monitor_Talker, most frames first. A
+  *                 running window goes on unless silent, which ends it
+  *
+  * The table code at the top has no HAL dependencies and is compiled into
+  * the host tools with BOOT_HOST (Tools/canmon.c).
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MONITOR_H
+#define __MONITOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#ifdef BOOT_HOST
+/* can.h needs the HAL; the host tools get the identifier flags here */
+#define CAN_FRAME_EXT         0x80000000UL
+#define CAN_FRAME_RTR         0x40000000UL
+#define CAN_FRAME_ID_MASK     0x1FFFFFFFUL
+#else
+#include "can.h"
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define MONITOR_CMD_START       0x60U
+#define MONITOR_CMD_STOP        0x61U
+#define MONITOR_CMD_GET         0x62U
+
+/* MONITOR_START flags */
+#define MONITOR_SILENT          0x01U     /* bxCAN silent mode for the window */
+#define MONITOR_REPEAT          0x02U     /* next window after each report */
+
+#define MONITOR_SLOT_BITS       6U
+#define MONITOR_SLOTS           (1UL << MONITOR_SLOT_BITS)  /* 1.5 KB of RAM */
+#define MONITOR_PROBES          8U        /* slots a frame looks at, at most */
+#define MONITOR_TOP_MAX         16U
+#define MONITOR_TOP_DEFAULT     8U
+#define MONITOR_KEY_USED        0x00000001UL  /* CAN_RIxR bit 0 is reserved */
+
+/* bxCAN last error codes 1..6 */
+#define MONITOR_ERRORS          6U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief One identifier in the table
+  */
+typedef struct
+{
+  uint32_t key;           /* CAN_RIxR | MONITOR_KEY_USED, 0 = free */
+  uint32_t count;
+  uint32_t lastUs;
+  uint32_t minGapUs;      /* UINT32_MAX after one frame */
+  uint32_t maxGapUs;
+  uint16_t dlcMask;       /* bit n: a frame with DLC n */
+  uint16_t probes;        /* distance from the home slot */
+} Monitor_Entry;
+
+/**
+  * @brief Window statistics, cleared at MONITOR_START
+  */
+typedef struct
+{
+  Monitor_Entry slots[MONITOR_SLOTS];
+  uint32_t frames;
+  uint32_t overflow;      /* frames of identifiers that found no slot */
+  uint16_t ids;           /* slots in use */
+  uint16_t maxProbes;
+  uint16_t errors[MONITOR_ERRORS];
+  uint16_t busOff;
+  uint8_t tecPeak;
+  uint8_t recPeak;
+} Monitor_Table;
+
+/**
+  * @brief Report header, sent as is (32 bytes, little endian)
+  */
+typedef struct
+{
+  uint32_t windowMs;
+  uint32_t frames;
+  uint32_t overflow;
+  uint16_t ids;
+  uint8_t talkers;        /* Monitor_Talker records that follow */
+  uint8_t flags;          /* MONITOR_START flags, bit 7 while still running */
+  uint16_t errors[MONITOR_ERRORS];  /* stuff, form, ack, bit 1, bit 0, CRC */
+  uint8_t tecPeak;
+  uint8_t recPeak;
+  uint16_t busOff;
+} Monitor_Header;
+
+/**
+  * @brief One busy identifier in a report (20 bytes)
+  */
+typedef struct
+{
+  uint32_t id;            /* identifier | CAN_FRAME_EXT | CAN_FRAME_RTR */
+  uint32_t count;
+  uint32_t minGapUs;      /* UINT32_MAX after one frame */
+  uint32_t maxGapUs;
+  uint16_t dlcMask;
+  uint16_t probes;
+} Monitor_Talker;
+
+#define MONITOR_RUNNING         0x80U     /* Monitor_Header.flags */
+#define MONITOR_REPORT_MAX      (sizeof(Monitor_Header) + (MONITOR_TOP_MAX * sizeof(Monitor_Talker)))
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Monitor_Clear(Monitor_Table *table);
+void Monitor_Update(Monitor_Table *table, uint32_t key, uint32_t dlc, uint32_t nowUs);
+uint32_t Monitor_Top(const Monitor_Table *table, Monitor_Talker *out, uint32_t n);
+uint32_t Monitor_Key(uint32_t id);
+uint32_t Monitor_Id(uint32_t key);
+
+#ifndef BOOT_HOST
+/**
+  * @brief Monitor counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t windows;
+  uint32_t reports;
+  uint32_t frames;        /* report frames queued */
+} Monitor_Stats;
+
+extern Monitor_Stats monitorStats;
+
+void Monitor_Frame(uint32_t rir, uint32_t rdtr);
+void Monitor_Error_IRQ(void);
+void Monitor_HandleFrame(const CAN_Frame *frame);
+uint8_t Monitor_Poll(void);
+uint8_t Monitor_Silent(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MONITOR_H */
@@ -0,0 +1,129 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : nmea.h
+  * @brief          : NMEA 2000 Heartbeat and Product Information
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Both messages go out from PARAM_SOURCE_ADDRESS, like T1.
+  *
+  *   Heartbeat, PGN 126993, priority 7, every PARAM_HEARTBEAT_MS:
+  *     byte 0..1   interval, 0.01 s
+  *     byte 2      sequence counter, 0..252
+  *     byte 3      bits 0-1 controller state (0 error active, 1 error
+  *                 passive, 2 bus off), bits 2-3 second controller (3, none),
+  *                 bits 4-5 equipment status (0 operational, 1 fault: CAN
+  *                 frames lost or a parameter store error since the last
+  *                 heartbeat), bits 6-7 reserved (1)
+  *     byte 4..7   reserved (0xFF)
+  *
+  *   Product Information, PGN 126996, priority 6, fast packet of
+  *   NMEA_PRODUCT_INFO_SIZE bytes: NMEA 2000 version (0.001), product code,
+  *   then 32-byte strings padded with 0xFF: model ID, software version,
+  *   model version (with the silicon revision) and serial code (the 96-bit
+  *   unique ID in hex), then certification level and load equivalency
+  *   (50 mA). Sent once after reset and on request.
+  *
+  * Fast packet: frame 0 is [sequence << 5 | 0, length, 6 bytes], frame n is
+  * [sequence << 5 | n, 7 bytes], unused bytes of the last frame 0xFF. Nothing
+  * in the payload changes while the node runs, so the frames are built once,
+  * on the first transfer, and kept in RAM; a transfer only adds the sequence
+  * bits and the source address. A receiver reassembles by frame counter but
+  * expects the frames in order, and bxCAN sends equal identifiers lowest
+  * mailbox first, so a frame is only queued when the controller is idle
+  * (see history.h for the burst alternative).
+  *
+  * An ISO Request (PGN 59904) for either PGN, for the RAM or CPU
+  * diagnostics (ram.h, cpu.h), for the temperature alarm (alarm.h) or for
+  * the trend (trend.h), to this node or to all, is answered with the
+  * message; a request addressed to this node for any other PGN is answered
+  * with an ISO Acknowledgement (PGN 59392) NAK.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NMEA_H
+#define __NMEA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define NMEA_PGN_ISO_ACK        59392UL   /* 0xE800, addressed */
+#define NMEA_PGN_ISO_REQUEST    59904UL   /* 0xEA00, addressed */
+#define NMEA_PGN_HEARTBEAT      126993UL  /* 0x1F011 */
+#define NMEA_PGN_PRODUCT_INFO   126996UL  /* 0x1F014, fast packet */
+
+#define NMEA_PRIO_HEARTBEAT     7UL
+#define NMEA_PRIO_PRODUCT_INFO  6UL
+#define NMEA_PRIO_ISO           6UL
+
+#define NMEA_GLOBAL             0xFFU
+#define NMEA_SEQUENCE_MAX       252U
+
+#define NMEA_PRODUCT_INFO_SIZE  134U
+#define NMEA_STRING_SIZE        32U
+#define NMEA_PRODUCT_FRAMES     (1U + ((NMEA_PRODUCT_INFO_SIZE - 6U + 7U - 1U) / 7U))
+
+/* Product Information contents */
+#define NMEA_DATABASE_VERSION   2100U     /* NMEA 2000 version 2.100 */
+#define NMEA_PRODUCT_CODE       334U
+#define NMEA_MODEL_ID           "STM32F334 CAN temperature"
+#ifndef NMEA_SOFTWARE_VERSION
+#define NMEA_SOFTWARE_VERSION   "1.0.0"
+#endif
+#define NMEA_CERTIFICATION      0U        /* not certified */
+#define NMEA_LOAD_EQUIVALENCY   1U        /* 50 mA */
+
+/* Heartbeat byte 3 */
+#define NMEA_CTRL_ERROR_ACTIVE  0U
+#define NMEA_CTRL_ERROR_PASSIVE 1U
+#define NMEA_CTRL_BUS_OFF       2U
+#define NMEA_CTRL_NONE          3U
+#define NMEA_STATUS_OPERATIONAL 0U
+#define NMEA_STATUS_FAULT       1U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Message counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t heartbeats;    /* heartbeats queued */
+  uint32_t faults;        /* of which reported an equipment fault */
+  uint32_t requests;      /* ISO requests answered, NAKs included */
+  uint32_t productInfos;  /* Product Information transfers completed */
+  uint32_t frames;        /* fast-packet frames queued */
+} Nmea_Stats;
+
+/* Exported functions prototypes ---------------------------------------------*/
+#ifndef BOOT_HOST
+#include "can.h"
+
+extern Nmea_Stats nmeaStats;
+
+void Nmea_SendHeartbeat(void);
+void Nmea_SendProductInfo(void);
+void Nmea_HandleFrame(const CAN_Frame *frame);
+uint8_t Nmea_Poll(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NMEA_H */
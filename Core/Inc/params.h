@@ -0,0 +1,145 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : params.h
+  * @brief          : Persistent runtime parameters (EEPROM emulation in the
+  *                   last two flash pages)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Page layout (half-words, little endian):
+  *
+  *   header   magic "PRM1" (2), generation (2); generation is programmed
+  *            first and the magic last, so a page only becomes valid once
+  *            everything before it is in place
+  *   records  key, value lo, value hi, CRC-16/CCITT of the first six bytes,
+  *            appended in that order; the latest record of a key wins
+  *
+  * The active page is the valid one with the higher generation. When it is
+  * full, the other page is erased, the live values are copied into it and
+  * its header is written with generation + 1; a power failure at any point
+  * leaves the previous page active and intact.
+  *
+  * Values are served from RAM. Params_Set() only marks a key dirty and
+  * Params_Poll() programs the records a few half-words at a time from the
+  * main loop, so a write never holds off the CAN interrupts for longer than
+  * one half-word (about 50 us). The exception is the page erase once per
+  * compaction, which stalls flash fetches for 20-40 ms. The vector table is
+  * in flash, so no interrupt is taken meanwhile and FIFO0 keeps the first
+  * three frames received; bxCAN acknowledges the rest and drops them. On a
+  * saturated 1 Mbit/s bus of 8-byte extended frames (about 6700 a second)
+  * that is 130 to 270 frames lost per erase. The erase therefore waits for a quiet bus, no
+  * frame for PARAMS_ERASE_QUIET_MS, but at most PARAMS_ERASE_DEFER_MS.
+  *
+  * CAN access uses the bootloader command PGN (boot.h), addressed to
+  * BOOT_NODE_ADDRESS whatever the configured source address:
+  *
+  *   PARAM_GET  key[1..2]            -> [rsp, status, key lo, key hi, value[4..7]]
+  *   PARAM_SET  key[1..2] value[3..6] -> same response with the value now in use
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PARAMS_H
+#define __PARAMS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define PARAMS_FLASH_BASE       0x0800F000UL      /* pages 30 and 31 */
+#define PARAMS_PAGE_SIZE        2048UL
+#define PARAMS_MAGIC            0x314D5250UL      /* "PRM1" */
+#define PARAMS_HEADER_SIZE      8U
+#define PARAMS_RECORD_SIZE      8U
+#define PARAMS_RECORDS_PER_PAGE ((PARAMS_PAGE_SIZE - PARAMS_HEADER_SIZE) / PARAMS_RECORD_SIZE)
+
+/* Half-words programmed per Params_Poll() call (one record) */
+#define PARAMS_POLL_HALFWORDS   4U
+
+/* Bus silence a compaction erase waits for, and the longest it waits */
+#define PARAMS_ERASE_QUIET_MS   10U
+#define PARAMS_ERASE_DEFER_MS   500U
+
+#define PARAMS_CMD_GET          0x10U
+#define PARAMS_CMD_SET          0x11U
+
+/* Params_Set() and CAN response status */
+#define PARAMS_OK               0x00U
+#define PARAMS_ERR_KEY          0x01U     /* unknown key */
+#define PARAMS_ERR_RANGE        0x02U     /* value outside the key's limits */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Parameter keys; the numbers are stored in flash, append only
+  */
+typedef enum
+{
+  PARAM_SOURCE_ADDRESS = 0,   /* NMEA 2000 source address of T1 */
+  PARAM_A1_PERIOD_MS,         /* main loop / A1 period */
+  PARAM_T1_PERIOD_MS,         /* T1 period */
+  PARAM_TEMP_INSTANCE,        /* PGN 130312 temperature instance */
+  PARAM_TEMP_SOURCE,          /* PGN 130312 temperature source */
+  PARAM_TEMP_OFFSET,          /* calibration offset, signed, 0.01 K */
+  PARAM_HEARTBEAT_MS,         /* PGN 126993 heartbeat interval */
+  PARAM_DIAG_MS,              /* PGN 65281/65284 diagnostics interval */
+  PARAM_ALARM_HIGH,           /* high temperature alarm, signed, 0.1 degC (alarm.h) */
+  PARAM_ALARM_LOW,            /* low temperature alarm, signed, 0.1 degC */
+  PARAM_ALARM_HYST,           /* alarm hysteresis, 0.1 degC */
+  PARAM_FILTER_MODE,          /* temperature filter, FILTER_MODE_x (filter.h) */
+  PARAM_FILTER_BATCH,         /* conversions per T1 period when filtering */
+  PARAM_FILTER_CUTOFF,        /* IIR cutoff, per mille of the conversion rate */
+  PARAM_TREND_WINDOW,         /* T1 values in the trend fit (trend.h) */
+  PARAM_COUNT
+} Params_Key;
+
+/**
+  * @brief Store counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t generation;    /* generation of the active page */
+  uint32_t bootRecords;   /* valid records found by Params_Init() */
+  uint32_t bootSkipped;   /* torn, corrupt or out of range records skipped */
+  uint32_t updates;       /* value changes accepted by Params_Set() */
+  uint32_t records;       /* records appended (not counting compaction) */
+  uint32_t halfwords;     /* half-words programmed, compaction included */
+  uint32_t erases;        /* page erases */
+  uint32_t compactions;   /* completed page switches */
+  uint32_t deferred;      /* erases that waited for a quiet bus */
+  uint32_t forced;        /* of those, erases started at PARAMS_ERASE_DEFER_MS */
+  uint32_t errors;        /* failed program, erase or read-back */
+} Params_Stats;
+
+extern Params_Stats paramsStats;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Params_Init(void);
+uint32_t Params_Get(Params_Key key);
+uint8_t Params_Set(Params_Key key, uint32_t value);
+void Params_Poll(void);
+
+#ifndef BOOT_HOST
+#include "can.h"
+
+void Params_HandleFrame(const CAN_Frame *frame);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PARAMS_H */
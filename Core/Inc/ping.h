@@ -0,0 +1,100 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : ping.h
+  * @brief          : Ping/echo answered from the CAN interrupts, for round-trip
+  *                   latency measurements
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * A ping on the bootloader command PGN (boot.h), addressed to
+  * BOOT_NODE_ADDRESS, is answered without the main loop: the CAN RX
+  * interrupt recognises it while draining FIFO0, instead of queueing it,
+  * puts the echo in a ring of PING_SLOTS and pends the CAN TX interrupt,
+  * which loads the echo into the next free mailbox ahead of the TX queue and
+  * the bus-stress generator. The echo has the ping's priority.
+  *
+  * The bxCAN runs in time-triggered communication mode (TTCM) for its time
+  * stamps: a 16-bit counter of bit times captured at the start of frame of
+  * every frame received or sent. The echo carries the ping's stamp, and the
+  * controller writes the echo's own stamp into its last two bytes as it
+  * sends it (TGT), so their difference is the time from the start of the
+  * ping on the wire to the start of the echo, whatever the interrupts and
+  * the mailboxes did in between. It wraps after 65536 bit times, 65 ms at
+  * 1 Mbit/s.
+  *
+  *   PING_CMD_ECHO [cmd, sequence, any] -> answered as
+  *
+  *   byte 0      PING_CMD_ECHO | BOOT_RSP
+  *   byte 1      sequence, from the ping
+  *   byte 2..3   RX time stamp of the ping, bit times, little endian
+  *   byte 4      frames waiting in the CAN TX queue when the ping came in
+  *   byte 5      bits 0..1 transmit mailboxes pending, bits 2..3 echoes
+  *               ahead of this one in the ring, when the ping came in;
+  *               bits 4..7 set
+  *   byte 6..7   TX time stamp of the echo, bit times, little endian
+  *
+  * A ping that finds the ring full, or the controller in silent mode
+  * (monitor.h), is queued like any other frame and not answered. Builds
+  * that idle in Stop mode miss the frame that wakes them, often the ping
+  * itself. The SLCAN adapter (SLCAN_ENABLE) is no node and passes pings on
+  * to the host.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PING_H
+#define __PING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define PING_CMD_ECHO           0x70U
+
+#define PING_SLOTS              4U        /* echoes in flight, power of two */
+
+/* Echo byte 5 */
+#define PING_MAILBOXES_MASK     0x03U
+#define PING_AHEAD_Pos          2U
+#define PING_AHEAD_MASK         0x0CU
+#define PING_RESERVED           0xF0U
+
+#ifndef BOOT_HOST
+#include "can.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Ping counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t echoes;        /* pings answered */
+  uint32_t busy;          /* pings not answered: ring full or silent */
+} Ping_Stats;
+
+extern volatile Ping_Stats pingStats;
+
+/* Exported functions prototypes ---------------------------------------------*/
+uint8_t Ping_Frame(uint32_t rir, uint32_t rdtr, uint32_t rdlr);
+uint8_t Ping_Next(CAN_Frame *frame);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PING_H */
@@ -0,0 +1,98 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : ram.h
+  * @brief          : Stack and heap high-water marks, diagnostics PGN
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * SRAM above .bss is shared by the newlib heap, growing up from _end, and
+  * the MSP stack, growing down from _estack:
+  *
+  *   .data | .bss | heap -> ...... free ...... <- stack | _estack
+  *                ^ _end    ^ break     ^ deepest stack word so far
+  *
+  * Reset_Handler fills everything from _end to _estack with RAM_PAINT
+  * once .bss is cleared. Ram_Scan() then looks for the lowest
+  * word above the heap break that no longer holds the pattern, checking
+  * RAM_SCAN_WORDS words per call from the service task; a pass restarts at
+  * the break whenever it finds a deeper word, and ends at the deepest one
+  * known. _sbrk() (sysmem.c) keeps the break, its peak and the refused
+  * requests in ramStats.
+  *
+  * Diagnostics, PGN 65284 (proprietary B, single frame), priority 7, from
+  * PARAM_SOURCE_ADDRESS every PARAM_DIAG_MS and on ISO request:
+  *
+  *   byte 0..1   stack high-water mark, bytes below _estack
+  *   byte 2..3   headroom, bytes between the heap break and the deepest
+  *               stack word
+  *   byte 4..5   heap high-water mark, bytes above _end
+  *   byte 6      _sbrk() requests refused, saturated at 255
+  *   byte 7      RAM_DIAG_x flags, reserved bits 1
+  *
+  * The pattern can only show where the stack has been, not that a value
+  * written there equalled RAM_PAINT, so the mark may read a word short; it
+  * never reads deeper than the stack went. Tools/stackest.c gives the
+  * static bound from the compiler's call graph for comparison.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RAM_H
+#define __RAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define RAM_PAINT               0xA5A5A5A5UL  /* also in Reset_Handler */
+#define RAM_SCAN_WORDS          16U           /* words checked per Ram_Scan() */
+#define RAM_HEADROOM_MIN        128U          /* bytes, RAM_DIAG_LOW below */
+
+#define RAM_PGN_DIAG            65284UL   /* 0xFF04, proprietary B; 65280 is the UWB distance's */
+#define RAM_PRIO_DIAG           7UL
+
+/* Diagnostics byte 7 */
+#define RAM_DIAG_SCANNED        0x01U     /* a full pass has completed */
+#define RAM_DIAG_STACK_OVER     0x02U     /* stack deeper than _Min_Stack_Size */
+#define RAM_DIAG_LOW            0x04U     /* headroom below RAM_HEADROOM_MIN */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief High-water marks and counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t stackPeak;     /* bytes below _estack */
+  uint32_t headroom;      /* bytes between the heap break and the stack */
+  uint32_t heapUsed;      /* bytes above _end, kept by _sbrk() */
+  uint32_t heapPeak;
+  uint32_t heapFailures;  /* _sbrk() requests refused */
+  uint32_t passes;        /* scan passes completed */
+  uint32_t diags;         /* diagnostics messages queued */
+} Ram_Stats;
+
+/* Exported functions prototypes ---------------------------------------------*/
+extern Ram_Stats ramStats;
+
+void Ram_Scan(void);
+void Ram_SendDiag(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RAM_H */
@@ -0,0 +1,51 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : rtc.h
+  * @brief          : Header for rtc.c file.
+  *                   RTC on the LSI, used as the Stop mode time base.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RTC_H
+#define __RTC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* LSI 40 kHz / (39 + 1) / (999 + 1) = 1 Hz calendar, SSR counts milliseconds */
+#define RTC_ASYNCH_PREDIV       39U
+#define RTC_SYNCH_PREDIV        999U
+
+/* Wake-up timer on RTCCLK / 16: 2.5 kHz, 0.4 ms per count, up to 26 s */
+#define RTC_WAKEUP_HZ           (LSI_VALUE / 16U)
+
+/* Exported types ------------------------------------------------------------*/
+extern RTC_HandleTypeDef hrtc;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MX_RTC_Init(void);
+uint32_t RTC_GetMillis(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RTC_H */
@@ -0,0 +1,112 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : scheduler.h
+  * @brief          : Cooperative periodic task scheduler with a low-power
+  *                   idle path
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Tasks run to completion from the main loop, in the order they were added.
+  * A periodic task runs when its deadline has passed and the next deadline
+  * is one period later, so periods do not drift with the task run time. A
+  * task with period 0 runs on every pass, i.e. after every wake-up.
+  * Every task is also registered with the watchdog (watchdog.h), which
+  * expects it to complete at least every two periods.
+  *
+  * Between passes the scheduler idles until the earliest deadline in the
+  * mode chosen at build time (SCHEDULER_IDLE_MODE):
+  *
+  *   RUN    polls HAL_GetTick(), like the HAL_Delay() loop it replaces
+  *   SLEEP  WFI in Sleep mode; SysTick (every ms) and CAN interrupts wake
+  *          the core, peripherals and clocks keep running
+  *   STOP   for waits of SCHEDULER_STOP_MIN_MS or more: bxCAN in sleep
+  *          mode, Stop mode until the RTC wake-up timer or a falling edge
+  *          on CAN_RX (EXTI11), then HSE/PLL are restored before bxCAN
+  *          leaves sleep mode, so it never runs with the wrong bit timing.
+  *          The frame that wakes the node is lost, so the node then stays
+  *          in SLEEP for SCHEDULER_CAN_AWAKE_MS after bus activity. Shorter
+  *          waits, and the time until the transmit mailboxes drain, use SLEEP.
+  *          Time in Stop is measured on the LSI-clocked RTC and added to
+  *          uwTick; the LSI is only accurate to about +-25 %, so periods
+  *          stretch or shrink by up to that much while the node idles.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define SCHEDULER_IDLE_RUN      0
+#define SCHEDULER_IDLE_SLEEP    1
+#define SCHEDULER_IDLE_STOP     2
+
+#ifndef SCHEDULER_IDLE_MODE
+#define SCHEDULER_IDLE_MODE     SCHEDULER_IDLE_SLEEP
+#endif
+
+#define SCHEDULER_MAX_TASKS     8U
+
+/* Stop mode: shortest wait worth the clock restart, and how early to wake
+ * for it (HSE start-up and PLL lock, about 1.2 ms) */
+#define SCHEDULER_STOP_MIN_MS   5U
+#define SCHEDULER_STOP_WAKE_MS  2U
+
+/* Sleep instead of Stop for this long after a frame was received or the
+ * node was woken by CAN, so that retries and replies are not lost */
+#define SCHEDULER_CAN_AWAKE_MS  100U
+
+/* Task trace id for tasks that should not appear in the SWO trace */
+#define SCHEDULER_NO_TRACE      0xFFU
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (*Scheduler_TaskFn)(void);
+
+/**
+  * @brief Idle residency counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t passes;        /* scheduler passes (wake-ups) */
+  uint32_t taskRuns;      /* task functions called */
+  uint32_t sleeps;        /* WFI in Sleep mode */
+  uint32_t stops;         /* Stop mode entries */
+  uint32_t canWakeups;    /* Stop mode left on CAN bus activity */
+  uint64_t idleUs;        /* time spent idle, all modes */
+  uint64_t stopUs;        /* part of idleUs in Stop mode, the clock
+                           * restart after it not included */
+  uint32_t stopAborts;    /* Stop given up: bxCAN did not reach sleep mode */
+} Scheduler_Stats;
+
+extern Scheduler_Stats schedulerStats;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Scheduler_Init(void);
+uint8_t Scheduler_Add(Scheduler_TaskFn fn, uint32_t periodMs, uint8_t traceId);
+void Scheduler_SetPeriod(uint8_t task, uint32_t periodMs);
+void Scheduler_KeepAwake(void);
+void Scheduler_Poll(void);
+uint32_t Scheduler_Micros(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCHEDULER_H */
@@ -0,0 +1,182 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : slcan.h
+  * @brief          : SLCAN (LAWICEL) adapter mode on USART3
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Built with SLCAN_ENABLE=1 (make SLCAN=1) the board is a serial CAN
+  * adapter for slcand on USART3 (PB10 TX, PB11 RX, 8N1 at SLCAN_BAUD)
+  * instead of a sensor node:
+  *
+  *   slcand -o -c -s8 -S 4000000 /dev/ttyUSB0 slcan0
+  *
+  * Commands, each ended by CR; CR answers success, BEL (0x07) failure:
+  *   Sn          bit rate, closed only: 0 10k, 1 20k, 2 50k, 3 100k,
+  *               4 125k, 5 250k, 6 500k, 7 800k, 8 1M, each refused
+  *               if PCLK1 does not divide into its 8 time quanta
+  *   O / L / C   open, open listen-only (bxCAN silent mode), close
+  *   tiiildd..   send a standard frame, answered z CR
+  *   Tiiiiiiiildd..  extended frame, answered Z CR
+  *   riiil / Riiiiiiiil  remote frames, answered z / Z
+  *   Zn          time stamps off/on, closed only
+  *   F           status flags, cleared by reading: FXX
+  *   V / N       version V0101 / serial number NF334
+  *
+  * Received frames go out in the same t/T/r/R form, with four hex digits of
+  * milliseconds (0..59999) appended when time stamps are on. A frame lost
+  * on the way, in the bxCAN FIFO or in the RX queue behind a slow serial
+  * link, is never dropped silently: the status flags record it and the
+  * stream carries an "e1o" CR error line (rx overflow in the Linux slcan
+  * driver) where the encoder noticed it.
+  *
+  * The codec at the top has no HAL dependencies and is compiled into the
+  * host tools with BOOT_HOST (Tools/slcansim.c).
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SLCAN_H
+#define __SLCAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#ifdef BOOT_HOST
+/* can.h needs the HAL; the host tools get the same frame layout here */
+#define CAN_FRAME_EXT         0x80000000UL
+#define CAN_FRAME_RTR         0x40000000UL
+#define CAN_FRAME_ID_MASK     0x1FFFFFFFUL
+
+typedef struct
+{
+  uint32_t id;
+  uint8_t  dlc;
+  uint8_t  filter;
+  uint16_t time;
+  uint8_t  data[8];
+} CAN_Frame;
+#else
+#include "can.h"
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#ifndef SLCAN_ENABLE
+#define SLCAN_ENABLE            0
+#endif
+#ifndef SLCAN_BAUD
+#define SLCAN_BAUD              4000000UL /* PCLK1 / 8, the USART3 limit */
+#endif
+
+#define SLCAN_FRAME_MAX         31U   /* T + 8 id + dlc + 16 data + 4 stamp + CR */
+#define SLCAN_LINE_MAX          32U   /* longest command, CR included */
+#define SLCAN_REPLY_MAX         6U    /* V0101 CR */
+#define SLCAN_STAMP_WRAP        60000U
+
+#define SLCAN_TX_RING           512U  /* bytes, power of two */
+#define SLCAN_RX_DMA            128U  /* bytes, even, circular DMA buffer */
+
+/* Channel modes */
+#define SLCAN_CLOSED            0U
+#define SLCAN_OPEN              1U
+#define SLCAN_LISTEN            2U
+
+/* Slcan_Command() results, what the caller has to do before replying */
+#define SLCAN_ERROR             0U    /* nothing, reply BEL */
+#define SLCAN_OK                1U    /* nothing, reply CR */
+#define SLCAN_APPLY             2U    /* set up bxCAN from the new state */
+#define SLCAN_SEND              3U    /* transmit the frame */
+#define SLCAN_STATUS            4U    /* reply with the status flags */
+#define SLCAN_VERSION           5U
+#define SLCAN_SERIAL            6U
+
+/* F status flags (LAWICEL) */
+#define SLCAN_FLAG_RX_FULL      0x01U /* RX queue full, frames lost */
+#define SLCAN_FLAG_TX_FULL      0x02U /* TX queue full, t/T refused */
+#define SLCAN_FLAG_WARNING      0x04U /* bxCAN error warning */
+#define SLCAN_FLAG_OVERRUN      0x08U /* bxCAN FIFO overrun, frames lost */
+#define SLCAN_FLAG_PASSIVE      0x20U /* bxCAN error passive */
+#define SLCAN_FLAG_BUS_ERROR    0x80U /* last error code set, or bus-off */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Channel state kept by Slcan_Command()
+  */
+typedef struct
+{
+  uint8_t mode;           /* SLCAN_CLOSED, SLCAN_OPEN, SLCAN_LISTEN */
+  uint8_t bitrate;        /* Sn index */
+  uint8_t stamps;         /* Z1 */
+  uint8_t flags;          /* SLCAN_FLAG_x since the last F */
+  uint32_t pclk1;         /* bxCAN clock the Sn prescalers divide */
+} Slcan_State;
+
+/**
+  * @brief Command line being assembled from received characters
+  */
+typedef struct
+{
+  char text[SLCAN_LINE_MAX];
+  uint8_t length;
+  uint8_t overflow;       /* longer than SLCAN_LINE_MAX, answered BEL */
+  uint8_t complete;       /* CR seen, the next character starts a line */
+} Slcan_Line;
+
+/**
+  * @brief Frame source for Slcan_EncodeBatch(), CAN_Receive() on the target
+  */
+typedef uint8_t (*Slcan_Source)(CAN_Frame *frame);
+
+/* Exported functions prototypes ---------------------------------------------*/
+uint32_t Slcan_Encode(char *out, const CAN_Frame *frame, uint8_t stamps);
+uint32_t Slcan_EncodeBatch(char *out, uint32_t space, Slcan_Source source, uint8_t stamps, uint32_t *frames);
+uint8_t Slcan_Decode(const char *line, uint32_t length, CAN_Frame *frame, uint8_t *stamped);
+uint8_t Slcan_Accept(Slcan_Line *line, char c);
+uint8_t Slcan_Command(Slcan_State *state, const char *line, uint32_t length, CAN_Frame *frame);
+uint32_t Slcan_Reply(char *out, uint8_t result, const CAN_Frame *frame, uint8_t flags);
+uint16_t Slcan_Prescaler(uint8_t bitrate, uint32_t pclk1);
+
+#ifndef BOOT_HOST
+/**
+  * @brief Adapter counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t framesOut;     /* frames encoded for the host */
+  uint32_t framesIn;      /* t/T/r/R frames queued for transmission */
+  uint32_t bytesOut;
+  uint32_t batches;       /* DMA transfers started */
+  uint32_t lostReports;   /* e1o lines sent */
+  uint32_t commands;
+  uint32_t refused;       /* commands answered BEL */
+  uint32_t rxOverruns;    /* host bytes lost: USART3 ORE or DMA lapped */
+} Slcan_Stats;
+
+extern Slcan_Stats slcanStats;
+
+void Slcan_Init(void);
+uint8_t Slcan_Poll(void);
+void Slcan_TxDma_IRQ(void);
+void Slcan_RxDma_IRQ(void);
+void Slcan_Uart_IRQ(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SLCAN_H */
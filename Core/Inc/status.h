@@ -0,0 +1,125 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : status.h
+  * @brief          : Multiplexed status pages in the A1 frame
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The A1 frame (0x0A1, 8 bytes, every PARAM_A1_PERIOD_MS) carries one page
+  * of the node's status at a time instead of a fixed pattern, so the same
+  * bus load gives a full snapshot every STATUS_PAGES frames, 167 ms at the
+  * default 30 Hz. The eight bytes are one little-endian 64-bit word of bit
+  * fields, [first, last] bit:
+  *
+  *   [0, 3]    page, 0..STATUS_PAGES-1, in turn
+  *   [4, 7]    round, counting complete turns, modulo 16
+  *
+  *   UPTIME    [8, 47]   milliseconds since reset
+  *             [48, 63]  A1 period, ms
+  *   TRAFFIC   [8, 35]   canStats.txFrames, modulo 2^28
+  *             [36, 63]  canStats.rxFrames, modulo 2^28
+  *   ERRORS    [8, 19]   canStats.rxDropped, saturated
+  *             [20, 31]  canStats.txDropped, saturated
+  *             [32, 39]  canStats.rxOverruns, saturated
+  *             [40, 47]  TEC
+  *             [48, 55]  REC
+  *             [56, 58]  LEC, last error code
+  *             [59, 61]  EWGF, EPVF, BOFF
+  *   LOAD      [8, 17]   CPU load, 0.1 %, since the previous LOAD page
+  *             [18, 33]  loop jitter, largest difference between an A1
+  *                       interval and the period, us, saturated, since the
+  *                       previous LOAD page
+  *   MEMORY    [8, 19]   last temperature sensor conversion, ADC counts
+  *             [20, 35]  stack high-water mark, bytes (ram.h)
+  *             [36, 51]  heap high-water mark, bytes
+  *
+  * Bits not listed are 1. The CPU load is the busy share as cpu.h
+  * accounts it, handlers included. The pages of one snapshot are
+  * taken a period apart; a receiver should take pages 0..STATUS_PAGES-1 of
+  * one round, in order, as a snapshot and drop a round with a gap. While
+  * the bus-stress generator runs (stress.h) or the controller listens in
+  * silent mode (monitor.h) no A1 frames are sent, and the pages resume
+  * where they left off.
+  *
+  * The codec at the top has no HAL dependencies and is compiled into the
+  * host tools with BOOT_HOST (Tools/canstatus.c).
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STATUS_H
+#define __STATUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define STATUS_ID               0x0A1UL   /* standard identifier */
+
+#define STATUS_PAGE_UPTIME      0U
+#define STATUS_PAGE_TRAFFIC     1U
+#define STATUS_PAGE_ERRORS      2U
+#define STATUS_PAGE_LOAD        3U
+#define STATUS_PAGE_MEMORY      4U
+#define STATUS_PAGES            5U
+
+#define STATUS_ROUNDS           16U       /* round counter modulus */
+
+/* ERRORS flags, bits 59..61 */
+#define STATUS_FLAG_EWGF        0x01U
+#define STATUS_FLAG_EPVF        0x02U
+#define STATUS_FLAG_BOFF        0x04U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief All the fields of the pages; Status_Pack() saturates or wraps
+  *        them to their widths
+  */
+typedef struct
+{
+  uint64_t uptimeMs;
+  uint16_t periodMs;
+  uint32_t txFrames;
+  uint32_t rxFrames;
+  uint32_t rxDropped;
+  uint32_t txDropped;
+  uint32_t rxOverruns;
+  uint8_t  tec;
+  uint8_t  rec;
+  uint8_t  lec;
+  uint8_t  flags;         /* STATUS_FLAG_x */
+  uint16_t loadPermille;
+  uint32_t jitterUs;
+  uint16_t adc;
+  uint32_t stackPeak;
+  uint32_t heapPeak;
+} Status_Snapshot;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Status_Pack(uint8_t page, uint8_t round, const Status_Snapshot *status, uint8_t *data);
+uint8_t Status_Unpack(const uint8_t *data, uint8_t *round, Status_Snapshot *status);
+
+#ifndef BOOT_HOST
+void Status_Tick(void);
+void Status_Next(uint8_t *data);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STATUS_H */
@@ -56,7 +56,15 @@ void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
 /* USER CODE BEGIN EFP */
-
+void CAN_RX0_IRQHandler(void);
+void CAN_TX_IRQHandler(void);
+void CAN_SCE_IRQHandler(void);
+void RTC_WKUP_IRQHandler(void);
+void EXTI15_10_IRQHandler(void);
+void ADC1_2_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
+void DMA1_Channel3_IRQHandler(void);
+void USART3_IRQHandler(void);
 /* USER CODE END EFP */
 
 #ifdef __cplusplus
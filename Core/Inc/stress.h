@@ -0,0 +1,128 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : stress.h
+  * @brief          : Bus-stress traffic generator
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * While running, the generator takes the place of the A1 frame (status.h)
+  * and loads a target share of the bus with frames of its own. They
+  * are made in the CAN TX interrupt whenever a mailbox is free and the TX
+  * queue is empty, so the node's own messages still go first and the
+  * generator alone can fill the bus; SysTick pends the TX interrupt every
+  * millisecond to restart it after a pause.
+  *
+  * Pacing is a token bucket in bit times: credit grows at load % of the bit
+  * rate and every frame costs its exact length on the wire, stuff bits and
+  * interframe space included. With n = 1 frames are spread evenly and are
+  * charged when loaded, up to two ahead of the credit (one on the wire, one
+  * waiting in a mailbox), so the bus stays full at 100 %. A burst of n > 1
+  * frames starts once the mailboxes are empty and the credit covers all of
+  * it, and then goes out back to back, giving idle gaps at the same average
+  * load. A gap ends at a TX interrupt or a SysTick, so gaps shorter than a
+  * millisecond come out as none or up to one: at high loads bursts run
+  * together now and then, the average load still holds. Credit is capped at
+  * one burst plus a SysTick period: time the bus was taken by other nodes
+  * is not made up for later.
+  *
+  * Every frame starts with a header for the receivers, truncated by DLCs
+  * below 4, and the payload pattern fills the rest:
+  *
+  *   byte 0..1   sequence number, little endian, 0 at STRESS_START
+  *   byte 2..3   microseconds (Scheduler_Micros(), low 16 bits) when the
+  *               frame was loaded into a mailbox
+  *   byte 4..7   counter (a byte counter running across frames), PRBS-15
+  *               (x^15 + x^14 + 1, running across frames) or stuff: bits
+  *               that continue the run left by the header to a stuff bit
+  *               and then alternate in fours, one stuff bit per four bits
+  *
+  * The bxCAN sends mailboxes in request order (TXFP) while the generator
+  * runs, so the sequence numbers arrive in order whatever the identifiers.
+  *
+  * Commands on the bootloader command PGN (boot.h), addressed to
+  * BOOT_NODE_ADDRESS; the configuration is kept in RAM only:
+  *
+  *   STRESS_START  [cmd, load %, burst, flags, dlc min << 4 | dlc max]
+  *                 -> [rsp, status]    load 1..100, burst 1..255
+  *   STRESS_IDS    [cmd, first id (4 bytes, bit 31 extended), count
+  *                 (3 bytes)] -> [rsp, status]    stopped only
+  *   STRESS_STOP   -> status response, then stopped
+  *   STRESS_STATUS -> [rsp, status, running, frames (4 bytes), load %]
+  *                    load achieved since STRESS_START
+  *
+  * Identifiers default to the A1 frame, 0x0A1 alone. The generator needs
+  * SysTick and is refused (BOOT_ERR_STATE) in builds that idle in Stop mode
+  * and during a silent bus monitor window (monitor.h). The constants are
+  * shared with the host tools (BOOT_HOST, Tools/canping.c).
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STRESS_H
+#define __STRESS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define STRESS_CMD_START        0x50U
+#define STRESS_CMD_IDS          0x51U
+#define STRESS_CMD_STOP         0x52U
+#define STRESS_CMD_STATUS       0x53U
+
+#define STRESS_HEADER_SIZE      4U        /* sequence number and time stamp */
+#define STRESS_FRAME_BITS_MAX   160U      /* extended, 8 bytes, worst stuffing */
+#define STRESS_DEFAULT_ID       0x0A1UL   /* the A1 frame */
+
+/* STRESS_START flags */
+#define STRESS_PATTERN_MASK     0x03U
+#define STRESS_PATTERN_COUNTER  0x00U
+#define STRESS_PATTERN_PRBS     0x01U
+#define STRESS_PATTERN_STUFF    0x02U
+#define STRESS_RANDOM_ID        0x04U     /* else identifiers in turn */
+#define STRESS_RANDOM_DLC       0x08U     /* else DLCs in turn, min to max */
+
+#ifndef BOOT_HOST
+#include "can.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Generator counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t frames;        /* frames loaded since STRESS_START */
+  uint32_t bursts;
+  uint32_t clipped;       /* bucket full: the bus could not take the rate */
+  uint64_t bits;          /* bit times of the frames, for the achieved load */
+} Stress_Stats;
+
+/* Exported functions prototypes ---------------------------------------------*/
+extern Stress_Stats stressStats;
+
+uint8_t Stress_Running(void);
+uint8_t Stress_Next(CAN_Frame *frame);
+void Stress_Tick(void);
+void Stress_HandleFrame(const CAN_Frame *frame);
+uint32_t Stress_FrameBits(const CAN_Frame *frame);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STRESS_H */
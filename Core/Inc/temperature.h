@@ -34,9 +34,12 @@ extern "C" {
 /* Exported types ------------------------------------------------------------*/
 
 /* Exported constants --------------------------------------------------------*/
-/* STM32F334 Temperature Sensor Calibration Addresses */
+/* STM32F334 Temperature Sensor Calibration Addresses (the host simulation
+ * provides its own calibration words) */
+#ifndef TEMP30_CAL_ADDR
 #define TEMP30_CAL_ADDR   ((uint16_t*) ((uint32_t) 0x1FFFF7B8))
 #define TEMP110_CAL_ADDR  ((uint16_t*) ((uint32_t) 0x1FFFF7C2))
+#endif
 
 /* Calibration temperature values */
 #define TEMP30_CAL_TEMP   30.0f
@@ -47,6 +50,7 @@ extern "C" {
 
 /* Exported functions prototypes ---------------------------------------------*/
 uint16_t Temperature_ReadADC(void);
+uint16_t Temperature_LastADC(void);
 float Temperature_GetCelsius(void);
 int16_t Temperature_GetCelsiusInt(void);
 
@@ -0,0 +1,137 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : trace.h
+  * @brief          : Header for trace.c file.
+  *                   Binary event trace over the SWO/ITM stimulus ports,
+  *                   the last events also kept in RAM for crash reports.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Trace event identifiers (8 bits on the wire)
+  *
+  * Keep in sync with the name tables in Tools/swo_decode.c and
+  * Tools/crashdump.c. DWT->CYCCNT does not count in Stop mode, so a Stop
+  * IDLE_ENTER/EXIT pair shows only the entry and clock restart time, not
+  * the time spent stopped.
+  */
+typedef enum
+{
+  TRACE_EVT_CAN_TX_ENQUEUE   = 0x01, /* arg0: mailbox index, arg1: CAN ID low 16 bits */
+  TRACE_EVT_CAN_TX_COMPLETE  = 0x02, /* arg0: mailbox index */
+  TRACE_EVT_CAN_RX_ISR_ENTER = 0x03, /* arg0: FIFO number, arg1: FIFO fill level */
+  TRACE_EVT_CAN_RX_ISR_EXIT  = 0x04, /* arg0: FIFO number, arg1: frames drained */
+  TRACE_EVT_ADC_DONE         = 0x05, /* arg1: raw 12-bit conversion result */
+  TRACE_EVT_TASK_START       = 0x06, /* arg0: task id */
+  TRACE_EVT_TASK_STOP        = 0x07, /* arg0: task id */
+  TRACE_EVT_IDLE_ENTER       = 0x08, /* arg0: SCHEDULER_IDLE_SLEEP or _STOP */
+  TRACE_EVT_IDLE_EXIT        = 0x09  /* arg0: idle mode, arg1: 1 = woken by CAN (Stop) */
+} Trace_EventId;
+
+/**
+  * @brief Task identifiers reported with TRACE_EVT_TASK_START/STOP
+  */
+#define TRACE_TASK_A1           0U
+#define TRACE_TASK_T1           1U
+
+/**
+  * @brief One event as kept in RAM: the two words sent to the ITM ports
+  */
+typedef struct
+{
+  uint32_t event;         /* id[31:24] | arg0[23:16] | arg1[15:0] */
+  uint32_t time;          /* DWT->CYCCNT */
+} Trace_Record;
+
+/* Exported constants --------------------------------------------------------*/
+/* Set to 0 to compile every trace point out of the image */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE            1
+#endif
+
+/* ITM stimulus ports used by the trace (port 0 is left for printf) */
+#define TRACE_PORT_EVENT        1U  /* id[31:24] | arg0[23:16] | arg1[15:0] */
+#define TRACE_PORT_TIME         2U  /* DWT->CYCCNT at the time of the event */
+#define TRACE_PORT_MASK         ((1UL << TRACE_PORT_EVENT) | (1UL << TRACE_PORT_TIME))
+
+/* Events kept in RAM whether or not a debugger listens, power of two */
+#define TRACE_LOG_LEN           16U
+
+/* Exported macro ------------------------------------------------------------*/
+/**
+  * @brief Emit one trace record.
+  *
+  * When the debugger has not enabled both stimulus ports this is a single
+  * load of ITM->TER and a compare, so trace points can stay in hot paths.
+  * The record also goes to the RAM log, except idle entry and exit: in
+  * Sleep they come with every SysTick and would push everything else out.
+  */
+#if TRACE_ENABLE
+#define TRACE_EVENT(id, arg0, arg1)                                   \
+  do {                                                                \
+    if ((id) < TRACE_EVT_IDLE_ENTER)                                  \
+    {                                                                 \
+      Trace_Log(((uint32_t)(uint8_t)(id) << 24) |                     \
+                ((uint32_t)(uint8_t)(arg0) << 16) | (uint16_t)(arg1)); \
+    }                                                                 \
+    if ((ITM->TER & TRACE_PORT_MASK) == TRACE_PORT_MASK)              \
+    {                                                                 \
+      Trace_Emit((uint8_t)(id), (uint8_t)(arg0), (uint16_t)(arg1));   \
+    }                                                                 \
+  } while (0)
+#else
+#define TRACE_EVENT(id, arg0, arg1)  do { } while (0)
+#endif
+
+/* Exported functions prototypes ---------------------------------------------*/
+extern Trace_Record traceLog[TRACE_LOG_LEN];
+extern uint32_t traceLogCount;
+
+void Trace_Init(void);
+void Trace_Emit(uint8_t id, uint8_t arg0, uint16_t arg1);
+uint32_t Trace_Recent(Trace_Record *out, uint32_t max);
+
+/**
+  * @brief  Adds an event to the RAM log; an interrupt between the two
+  *         stores can leave one record with the other's time, which a
+  *         post-mortem can live with
+  * @param  event: event word as sent to TRACE_PORT_EVENT
+  * @retval None
+  */
+__STATIC_INLINE void Trace_Log(uint32_t event)
+{
+  Trace_Record *record = &traceLog[traceLogCount++ & (TRACE_LOG_LEN - 1U)];
+
+  record->event = event;
+  record->time = DWT->CYCCNT;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRACE_H */
@@ -0,0 +1,134 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : trend.h
+  * @brief          : Temperature rate of change and time to an alarm threshold,
+  *                   trend PGN
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Every temperature PGN 130312 sends is added to a window of the last
+  * PARAM_TREND_WINDOW of them, and a least-squares line through the window
+  * gives the rate of change. The window keeps the sum of the values and the
+  * sum of each value times its place in the window (0 the oldest), in
+  * integers, so a new value updates both in constant time however long the
+  * window is:
+  *
+  *   Sxy' = Sxy - (Sy - oldest) + (n - 1) * newest,  Sy' = Sy - oldest + newest
+  *
+  * The slope and the fitted value at the newest sample then come from the
+  * two sums and constants of n alone, in 64-bit integers, without a pass
+  * over the window. The T1 period turns the slope per sample into one per
+  * minute; a change of the window, the T1 period or PARAM_TEMP_OFFSET
+  * starts the window again.
+  *
+  * The line is also extended to the alarm threshold it is heading for,
+  * PARAM_ALARM_HIGH when rising, PARAM_ALARM_LOW when falling (alarm.h),
+  * for the time left until the fitted temperature gets there; zero once it
+  * is there. The analog watchdog raises the alarm a code past the threshold
+  * (about 0.2 degC), so the prediction is that much early.
+  *
+  * Trend, PGN 65283 (proprietary B, single frame), priority 7 so that it
+  * loses arbitration to the PGN 130312 it follows, from
+  * PARAM_SOURCE_ADDRESS after every PGN 130312 and on ISO request:
+  *
+  *   byte 0      SID of the PGN 130312 it follows
+  *   byte 1      samples in the window
+  *   byte 2..3   slope, signed, 0.001 K/min, TREND_SLOPE_NA below two samples
+  *   byte 4..5   time to the threshold, s, TREND_TIME_NA without one,
+  *               TREND_TIME_OVER beyond TREND_TIME_MAX
+  *   byte 6      TREND_TARGET_x, the threshold heading for
+  *   byte 7      TREND_FLAG_x, reserved bits 1
+  *
+  * The codec at the top has no HAL dependencies and is compiled into the
+  * host tools with BOOT_HOST (Tools/temptrend.c).
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TREND_H
+#define __TREND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define TREND_PGN               65283UL   /* 0xFF03, proprietary B */
+#define TREND_PRIO              7UL
+
+#define TREND_WINDOW_MIN        2U        /* samples */
+#define TREND_WINDOW_MAX        64U
+
+#define TREND_SLOPE_MAX         32766     /* 0.001 K/min, saturated beyond */
+#define TREND_SLOPE_NA          0x7FFF
+#define TREND_TIME_MAX          0xFFFDU   /* s */
+#define TREND_TIME_OVER         0xFFFEU
+#define TREND_TIME_NA           0xFFFFU
+
+/* Trend byte 6, as ALARM_STATE_x */
+#define TREND_TARGET_NONE       0U        /* steady, too few samples or alarms off */
+#define TREND_TARGET_HIGH       1U
+#define TREND_TARGET_LOW        2U
+
+/* Trend byte 7 */
+#define TREND_FLAG_REQUEST      0x01U     /* answers an ISO request */
+#define TREND_FLAG_FULL         0x02U     /* window full */
+#define TREND_FLAG_CLAMPED      0x04U     /* slope saturated */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Window of samples and its running sums; Trend_Start() first
+  */
+typedef struct
+{
+  uint16_t samples[TREND_WINDOW_MAX];   /* 0.01 K, ring */
+  uint32_t sumY;          /* sum of the samples */
+  uint32_t sumXY;         /* sum of each times its place, 0 the oldest */
+  uint8_t  window;        /* samples when full */
+  uint8_t  count;         /* samples so far, up to window */
+  uint8_t  head;          /* oldest sample once full, next slot */
+} Trend_State;
+
+/**
+  * @brief What the trend message reports
+  */
+typedef struct
+{
+  int32_t  slope;         /* 0.001 K/min, TREND_SLOPE_NA */
+  int32_t  fitted;        /* fitted line at the newest sample, 0.01 K */
+  uint32_t seconds;       /* to the target, TREND_TIME_x */
+  uint8_t  target;        /* TREND_TARGET_x */
+  uint8_t  samples;
+  uint8_t  flags;         /* TREND_FLAG_FULL, TREND_FLAG_CLAMPED */
+} Trend_Result;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Trend_Start(Trend_State *trend, uint32_t window);
+void Trend_Add(Trend_State *trend, uint16_t centiK);
+void Trend_Estimate(const Trend_State *trend, uint32_t periodMs, int32_t highCentiK, int32_t lowCentiK,
+                    Trend_Result *result);
+void Trend_Encode(const Trend_Result *result, uint8_t sid, uint8_t flags, uint8_t *data);
+
+#ifndef BOOT_HOST
+void Trend_Update(uint16_t centiK, uint8_t sid);
+void Trend_SendState(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TREND_H */
@@ -0,0 +1,134 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : watchdog.h
+  * @brief          : IWDG supervisor with per-task check-ins and reset cause
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The IWDG runs from the LSI with a timeout of WATCHDOG_TIMEOUT_MS and is
+  * refreshed once per scheduler pass, but only while every registered task
+  * has checked in within two of its periods plus WATCHDOG_GRACE_MS. The
+  * scheduler registers each task it is given and checks it in after every
+  * run, so a task stuck in a loop, an interrupt handler that never returns
+  * and a task that is never run again all end in a watchdog reset.
+  *
+  * The passes never idle for more than WATCHDOG_MAX_IDLE_MS, also in Stop
+  * mode, where the IWDG keeps counting. The timeout covers the 40 ms page
+  * erase of the parameter store and the LSI tolerance (30-50 kHz).
+  *
+  * RTC backup register 1 survives the reset (backup register 0 belongs to
+  * the bootloader):
+  *
+  *   bits 31..24  WATCHDOG_RECORD_MAGIC
+  *   bits 23..16  watchdog resets since the backup domain was last reset
+  *   bits 15..8   task whose check-in was missed, WATCHDOG_NONE if none
+  *   bits 7..0    task running, WATCHDOG_NONE between tasks (idle or an
+  *                interrupt handler)
+  *
+  * Tasks are numbered in the order they were added to the scheduler. At
+  * start-up the node reports why it was reset, once to the global address
+  * and then on request, on the bootloader command PGN (boot.h):
+  *
+  *   RESET_CAUSE  -> [rsp, cause, task, starved task, watchdog resets,
+  *                    RCC_CSR[31:24], 0xFF, 0xFF]
+  *
+  * The bootloader does not need to refresh the watchdog: a reset stops it.
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __WATCHDOG_H
+#define __WATCHDOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* LSI 40 kHz / 64 / 2500: 4 s, 3.2 to 5.3 s over the LSI tolerance */
+#define WATCHDOG_PRESCALER      4U        /* IWDG_PR: divide by 64 */
+#define WATCHDOG_RELOAD         2499U
+#define WATCHDOG_TIMEOUT_MS     4000U
+
+#define WATCHDOG_GRACE_MS       2000U     /* check-in slack on top of two periods */
+#define WATCHDOG_MAX_IDLE_MS    1000U     /* longest scheduler idle */
+#define WATCHDOG_MAX_TASKS      8U
+
+#define WATCHDOG_NONE           0xFFU
+#define WATCHDOG_RECORD_MAGIC   0xA5U
+
+#define WATCHDOG_CMD_RESET      0x30U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Reset causes, from the RCC_CSR flags of the last reset
+  */
+typedef enum
+{
+  WATCHDOG_CAUSE_UNKNOWN = 0,
+  WATCHDOG_CAUSE_POWER_ON,
+  WATCHDOG_CAUSE_PIN,           /* NRST pin */
+  WATCHDOG_CAUSE_SOFTWARE,      /* bootloader ENTER and RUN */
+  WATCHDOG_CAUSE_IWDG,
+  WATCHDOG_CAUSE_WWDG,
+  WATCHDOG_CAUSE_LOW_POWER,
+  WATCHDOG_CAUSE_OPTION_BYTES
+} Watchdog_Cause;
+
+/**
+  * @brief Why the node was last reset, as reported over CAN
+  */
+typedef struct
+{
+  uint8_t cause;          /* Watchdog_Cause */
+  uint8_t task;           /* task running at a watchdog reset */
+  uint8_t starved;        /* task that missed its check-in at a watchdog reset */
+  uint8_t resets;         /* watchdog resets, saturating at 255 */
+  uint32_t csr;           /* RCC_CSR as found at start-up */
+} Watchdog_ResetInfo;
+
+/**
+  * @brief Supervisor counters, in the style of CAN_Stats
+  */
+typedef struct
+{
+  uint32_t refreshes;     /* IWDG reloads */
+  uint32_t withheld;      /* passes without a reload (check-in missed) */
+} Watchdog_Stats;
+
+/* Exported functions prototypes ---------------------------------------------*/
+#ifndef BOOT_HOST
+#include "can.h"
+
+extern Watchdog_ResetInfo watchdogReset;
+extern Watchdog_Stats watchdogStats;
+
+void Watchdog_Init(void);
+uint8_t Watchdog_Register(uint32_t periodMs);
+void Watchdog_SetPeriod(uint8_t task, uint32_t periodMs);
+void Watchdog_Running(uint8_t task);
+void Watchdog_CheckIn(uint8_t task);
+void Watchdog_Supervise(void);
+uint8_t Watchdog_Current(void);
+void Watchdog_HandleFrame(const CAN_Frame *frame);
+void Watchdog_Report(uint8_t requester);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WATCHDOG_H */
@@ -78,6 +78,11 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc)
   {
     /* Peripheral clock enable */
     __HAL_RCC_ADC1_CLK_ENABLE();
+
+    /* Analog watchdog interrupt (alarm.h), preempts the CAN TX interrupt
+     * that sends the alarm */
+    HAL_NVIC_SetPriority(ADC1_2_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(ADC1_2_IRQn);
   }
 }
 
@@ -92,5 +97,6 @@ void HAL_ADC_MspDeInit(ADC_HandleTypeDef* hadc)
   {
     /* Peripheral clock disable */
     __HAL_RCC_ADC1_CLK_DISABLE();
+    HAL_NVIC_DisableIRQ(ADC1_2_IRQn);
   }
 }
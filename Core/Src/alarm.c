@@ -0,0 +1,424 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : alarm.c
+  * @brief          : Temperature alarms on the ADC1 analog watchdog (see
+  *                   alarm.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The window registers may only be written with no conversion running;
+  * conversions are started and awaited in Temperature_ReadADC() alone, so
+  * the interrupt, at the end of one, and the main loop outside it both
+  * qualify. The interrupt reads the data register, which clears EOC; the
+  * EOS flag stays set for HAL_ADC_PollForConversion(), which waits for
+  * either, and HAL_ADC_GetValue() reads the same data.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "alarm.h"
+
+#ifndef BOOT_HOST
+#include "params.h"
+#include "temperature.h"
+#endif
+
+/* Private define ------------------------------------------------------------*/
+#define ALARM_ADC_CHANNEL       16UL      /* ADC1_IN16, temperature sensor */
+#define ALARM_CAL30_CENTI       3000      /* calibration points, 0.01 degC */
+#define ALARM_CAL110_CENTI      11000
+
+#define ALARM_ID(src) \
+  (CAN_FRAME_EXT | (ALARM_PRIO << 26) | (ALARM_PGN << 8) | (uint32_t)(src))
+
+/* Private functions ---------------------------------------------------------*/
+
+/* n / d rounded to the nearest, halves away from zero; d > 0 */
+static int32_t divRound(int32_t n, int32_t d)
+{
+  return (n >= 0) ? ((n + (d / 2)) / d) : -((-n + (d / 2)) / d);
+}
+
+/* Code on the rising scale of Alarm_Codes */
+static uint16_t rising(const Alarm_Codes *codes, uint16_t code)
+{
+  return codes->falling ? (uint16_t)(ALARM_CODE_MAX - code) : code;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Raw code of a sensor temperature, through the factory calibration
+  * @param  centiC: temperature, 0.01 degC
+  * @param  cal30: TS_CAL1, code at 30 degC
+  * @param  cal110: TS_CAL2, code at 110 degC, not equal to cal30
+  * @retval nearest code, 0..ALARM_CODE_MAX
+  */
+uint16_t Alarm_Code(int32_t centiC, uint16_t cal30, uint16_t cal110)
+{
+  int32_t diff = (int32_t)cal110 - (int32_t)cal30;
+  int32_t span = ALARM_CAL110_CENTI - ALARM_CAL30_CENTI;
+  int32_t code;
+
+  /* Saturated well outside the sensor's range, so the product fits */
+  if (centiC > 100000)
+  {
+    centiC = 100000;
+  }
+  if (centiC < -100000)
+  {
+    centiC = -100000;
+  }
+  if (diff < 0)
+  {
+    code = (int32_t)cal30 - divRound((centiC - ALARM_CAL30_CENTI) * -diff, span);
+  }
+  else
+  {
+    code = (int32_t)cal30 + divRound((centiC - ALARM_CAL30_CENTI) * diff, span);
+  }
+  if (code < 0)
+  {
+    code = 0;
+  }
+  if (code > (int32_t)ALARM_CODE_MAX)
+  {
+    code = (int32_t)ALARM_CODE_MAX;
+  }
+  return (uint16_t)code;
+}
+
+/**
+  * @brief  Sensor temperature of a raw code, the integer form of
+  *         Temperature_GetCelsius()
+  * @param  code: conversion result
+  * @param  cal30: TS_CAL1
+  * @param  cal110: TS_CAL2, not equal to cal30
+  * @retval temperature, 0.01 degC, rounded
+  */
+int32_t Alarm_CentiC(uint16_t code, uint16_t cal30, uint16_t cal110)
+{
+  int32_t diff = (int32_t)cal110 - (int32_t)cal30;
+  int32_t n = ((int32_t)code - (int32_t)cal30) * (ALARM_CAL110_CENTI - ALARM_CAL30_CENTI);
+
+  return ALARM_CAL30_CENTI + ((diff < 0) ? divRound(-n, -diff) : divRound(n, diff));
+}
+
+/**
+  * @brief  Translates the alarm thresholds into codes
+  * @param  codes: destination
+  * @param  highDeciC: high threshold, 0.1 degC as reported
+  * @param  lowDeciC: low threshold, 0.1 degC as reported
+  * @param  hystDeciC: hysteresis, 0.1 degC, 0 or more
+  * @param  offsetCentiK: PARAM_TEMP_OFFSET, added to what the sensor reads
+  * @param  cal30: TS_CAL1
+  * @param  cal110: TS_CAL2
+  * @retval 1 if the window is valid, 0 if alarms are off
+  */
+uint8_t Alarm_Thresholds(Alarm_Codes *codes, int32_t highDeciC, int32_t lowDeciC, int32_t hystDeciC,
+                         int32_t offsetCentiK, uint16_t cal30, uint16_t cal110)
+{
+  codes->valid = (uint8_t)((cal30 != cal110) && (lowDeciC < highDeciC) && (hystDeciC >= 0));
+  codes->falling = (uint8_t)(cal110 < cal30);
+  if (!codes->valid)
+  {
+    /* A window that never fires */
+    codes->high = ALARM_CODE_MAX;
+    codes->highClear = ALARM_CODE_MAX;
+    codes->low = 0;
+    codes->lowClear = 0;
+    return 0;
+  }
+
+  /* The sensor reads the reported temperature less the offset */
+  codes->high = rising(codes, Alarm_Code((highDeciC * 10) - offsetCentiK, cal30, cal110));
+  codes->highClear = rising(codes, Alarm_Code(((highDeciC - hystDeciC) * 10) - offsetCentiK, cal30, cal110));
+  codes->low = rising(codes, Alarm_Code((lowDeciC * 10) - offsetCentiK, cal30, cal110));
+  codes->lowClear = rising(codes, Alarm_Code(((lowDeciC + hystDeciC) * 10) - offsetCentiK, cal30, cal110));
+  return 1;
+}
+
+/**
+  * @brief  State after a conversion, with the hysteresis
+  * @param  codes: thresholds
+  * @param  state: ALARM_STATE_x before it
+  * @param  code: conversion result
+  * @retval ALARM_STATE_x; the same state exactly while the code is inside
+  *         that state's window (Alarm_Window())
+  */
+uint8_t Alarm_Classify(const Alarm_Codes *codes, uint8_t state, uint16_t code)
+{
+  uint16_t r = rising(codes, code);
+
+  if ((state == ALARM_STATE_HIGH) && (r >= codes->highClear))
+  {
+    return ALARM_STATE_HIGH;
+  }
+  if ((state == ALARM_STATE_LOW) && (r <= codes->lowClear))
+  {
+    return ALARM_STATE_LOW;
+  }
+  if (r > codes->high)
+  {
+    return ALARM_STATE_HIGH;
+  }
+  if (r < codes->low)
+  {
+    return ALARM_STATE_LOW;
+  }
+  return ALARM_STATE_NORMAL;
+}
+
+/**
+  * @brief  Analog watchdog window of a state, as raw codes
+  * @param  codes: thresholds
+  * @param  state: ALARM_STATE_x
+  * @param  lowCode: destination for the lowest code inside (LT1)
+  * @param  highCode: destination for the highest code inside (HT1)
+  * @retval None
+  */
+void Alarm_Window(const Alarm_Codes *codes, uint8_t state, uint16_t *lowCode, uint16_t *highCode)
+{
+  uint16_t from;
+  uint16_t to;
+
+  if (state == ALARM_STATE_HIGH)
+  {
+    from = codes->highClear;
+    to = ALARM_CODE_MAX;
+  }
+  else if (state == ALARM_STATE_LOW)
+  {
+    from = 0;
+    to = codes->lowClear;
+  }
+  else
+  {
+    from = codes->low;
+    to = codes->high;
+  }
+  *lowCode = codes->falling ? (uint16_t)(ALARM_CODE_MAX - to) : from;
+  *highCode = codes->falling ? (uint16_t)(ALARM_CODE_MAX - from) : to;
+}
+
+#ifndef BOOT_HOST
+
+/* Private variables ---------------------------------------------------------*/
+volatile Alarm_Stats alarmStats;
+
+static Alarm_Codes codes;
+static uint32_t configured[4];    /* high, low, hysteresis, offset in use */
+static volatile uint8_t state;
+static uint8_t changes;
+
+/* One alarm message for the TX interrupt, the latest one */
+static CAN_Frame pending;
+static volatile uint8_t pendingFull;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Programs the window of the state, or turns the watchdog off */
+static void setWindow(void)
+{
+  uint16_t lowCode;
+  uint16_t highCode;
+
+  Alarm_Window(&codes, state, &lowCode, &highCode);
+  ADC1->TR1 = ((uint32_t)highCode << ADC_TR1_HT1_Pos) | ((uint32_t)lowCode << ADC_TR1_LT1_Pos);
+  if (codes.valid)
+  {
+    ADC1->CFGR = (ADC1->CFGR & ~ADC_CFGR_AWD1CH) | (ALARM_ADC_CHANNEL << ADC_CFGR_AWD1CH_Pos) |
+                 ADC_CFGR_AWD1SGL | ADC_CFGR_AWD1EN;
+  }
+  else
+  {
+    ADC1->CFGR &= ~ADC_CFGR_AWD1EN;
+  }
+}
+
+/* Takes the parameters in use and programs the window of the state, with
+ * interrupts masked; the state stays, the next conversion outside its new
+ * window moves it */
+static void configure(void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  configured[0] = Params_Get(PARAM_ALARM_HIGH);
+  configured[1] = Params_Get(PARAM_ALARM_LOW);
+  configured[2] = Params_Get(PARAM_ALARM_HYST);
+  configured[3] = Params_Get(PARAM_TEMP_OFFSET);
+
+  __disable_irq();
+  (void)Alarm_Thresholds(&codes, (int32_t)configured[0], (int32_t)configured[1], (int32_t)configured[2],
+                         (int32_t)configured[3], *TEMP30_CAL_ADDR, *TEMP110_CAL_ADDR);
+  setWindow();
+  __set_PRIMASK(primask);
+}
+
+static void buildFrame(CAN_Frame *frame, uint16_t code, uint8_t flags)
+{
+  int32_t centiK = 0xFFFF;
+  uint16_t cal30 = *TEMP30_CAL_ADDR;
+  uint16_t cal110 = *TEMP110_CAL_ADDR;
+
+  if (cal30 != cal110)
+  {
+    centiK = Alarm_CentiC(code, cal30, cal110) + (int32_t)Params_Get(PARAM_TEMP_OFFSET) + 27315;
+    if ((centiK < 0) || (centiK > 0xFFFE))
+    {
+      centiK = 0xFFFF;
+    }
+  }
+
+  frame->id = ALARM_ID(Params_Get(PARAM_SOURCE_ADDRESS) & 0xFFUL);
+  frame->dlc = 8;
+  frame->filter = 0;
+  frame->time = 0;
+  frame->data[0] = state;
+  frame->data[1] = changes;
+  frame->data[2] = (uint8_t)centiK;
+  frame->data[3] = (uint8_t)(centiK >> 8);
+  frame->data[4] = (uint8_t)code;
+  frame->data[5] = (uint8_t)(code >> 8);
+  frame->data[6] = (uint8_t)(0xFCU | flags | (codes.valid ? 0U : ALARM_FLAG_OFF));
+  frame->data[7] = 0xFF;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Sets up the window from the parameters and enables the analog
+  *         watchdog interrupt; after Params_Init() and the ADC calibration
+  * @retval None
+  */
+void Alarm_Init(void)
+{
+  state = ALARM_STATE_NORMAL;
+  configure();
+
+  ADC1->ISR = ADC_ISR_AWD1;
+  ADC1->IER |= ADC_IER_AWD1IE;
+}
+
+/**
+  * @brief  Moves the window when a threshold, the hysteresis or the offset
+  *         has changed; from the main loop, outside a conversion
+  * @retval None
+  */
+void Alarm_Poll(void)
+{
+  if ((Params_Get(PARAM_ALARM_HIGH) != configured[0]) || (Params_Get(PARAM_ALARM_LOW) != configured[1]) ||
+      (Params_Get(PARAM_ALARM_HYST) != configured[2]) || (Params_Get(PARAM_TEMP_OFFSET) != configured[3]))
+  {
+    configure();
+  }
+}
+
+/**
+  * @brief  ADC interrupt body: a conversion left the window, so the state
+  *         changes, the window follows it and the alarm goes to the TX
+  *         interrupt
+  * @retval None
+  */
+void Alarm_IRQ(void)
+{
+  uint16_t code;
+  uint8_t next;
+
+  if ((ADC1->ISR & ADC_ISR_AWD1) == 0U)
+  {
+    return;
+  }
+  ADC1->ISR = ADC_ISR_AWD1;
+  code = (uint16_t)(ADC1->DR & ALARM_CODE_MAX);
+  alarmStats.interrupts++;
+
+  next = Alarm_Classify(&codes, state, code);
+  if (next == state)
+  {
+    return;
+  }
+  if (next == ALARM_STATE_NORMAL)
+  {
+    alarmStats.cleared++;
+  }
+  else
+  {
+    alarmStats.raised++;
+  }
+  state = next;
+  changes++;
+  setWindow();
+
+  if (CAN_Silent() != 0U)
+  {
+    alarmStats.lost++;
+    return;
+  }
+  if (pendingFull)
+  {
+    alarmStats.lost++;
+  }
+  buildFrame(&pending, code, 0);
+  pendingFull = 1;
+  alarmStats.queued++;
+  HAL_NVIC_SetPendingIRQ(CAN_TX_IRQn);
+}
+
+/**
+  * @brief  Takes the alarm message; call from the CAN TX interrupt with a
+  *         mailbox free, ahead of everything else
+  * @param  frame: destination
+  * @retval 1 if a message was returned
+  */
+CCMRAM_FUNC uint8_t Alarm_Next(CAN_Frame *frame)
+{
+  uint32_t primask;
+
+  if (!pendingFull)
+  {
+    return 0;
+  }
+
+  /* The ADC interrupt preempts this one */
+  primask = __get_PRIMASK();
+  __disable_irq();
+  *frame = pending;
+  pendingFull = 0;
+  __set_PRIMASK(primask);
+  return 1;
+}
+
+/**
+  * @brief  Current alarm state
+  * @retval ALARM_STATE_x
+  */
+uint8_t Alarm_State(void)
+{
+  return state;
+}
+
+/**
+  * @brief  Queues the alarm message with the current state and the last
+  *         conversion, for an ISO request
+  * @retval None
+  */
+void Alarm_SendState(void)
+{
+  CAN_Frame frame;
+
+  buildFrame(&frame, Temperature_LastADC(), ALARM_FLAG_REQUEST);
+  (void)CAN_TransmitFrame(&frame);
+}
+
+#endif /* BOOT_HOST */
@@ -0,0 +1,47 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : boot.c
+  * @brief          : Application side of the CAN bootloader: enter on request
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "boot.h"
+
+/**
+  * @brief  Checks a received frame for a bootloader ENTER command addressed to
+  *         this node and, if so, resets into the bootloader
+  * @param  frame: frame taken from the CAN RX queue
+  * @retval None (does not return on ENTER)
+  *
+  * The request survives the reset in RTC backup register 0, which the
+  * bootloader reads and clears. PING is answered by the bootloader only, so
+  * the uploader can tell when the node has switched over.
+  */
+void Boot_HandleFrame(const CAN_Frame *frame)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  if (((frame->id & CAN_FRAME_EXT) == 0U) || (frame->dlc < 1U) ||
+      (BOOT_ID_PGN(id) != BOOT_PGN_CMD) || (BOOT_ID_DA(id) != BOOT_NODE_ADDRESS) ||
+      (frame->data[0] != BOOT_CMD_ENTER))
+  {
+    return;
+  }
+
+  HAL_PWR_EnableBkUpAccess();
+  RTC->BKP0R = BOOT_REQUEST_MAGIC;
+  HAL_NVIC_SystemReset();
+}
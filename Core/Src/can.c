@@ -21,8 +21,29 @@
 #include "can.h"
 
 /* USER CODE BEGIN 0 */
+#include "trace.h"
+#include "slcan.h"
+#include "stress.h"
+#include "monitor.h"
+#include "ping.h"
+#include "alarm.h"
+
 extern CAN_TxHeaderTypeDef txHeaderA1; // CAN Bus Transmit Header for A1
 extern CAN_FilterTypeDef canfil; // CAN Bus Filter
+
+volatile CAN_Stats canStats;
+
+/* Single-producer/single-consumer queues, indices run freely and are masked */
+static CAN_Frame rxQueue[CAN_RX_QUEUE_LEN] CCMRAM_BSS;
+static volatile uint32_t rxHead CCMRAM_BSS; // written by CAN_RxFifo0_IRQ
+static volatile uint32_t rxTail CCMRAM_BSS; // written by CAN_Receive
+static CAN_Frame txQueue[CAN_TX_QUEUE_LEN] CCMRAM_BSS;
+static volatile uint32_t txHead CCMRAM_BSS; // written by CAN_TransmitFrame
+static volatile uint32_t txTail CCMRAM_BSS; // written by CAN_TxMailbox_IRQ
+static volatile uint8_t silent; // BTR.SILM set by CAN_SetSilent
+static volatile uint32_t lastRxTick; // HAL tick of the last FIFO0 interrupt
+
+#define CAN_TSR_TME_ALL   (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)
 /* USER CODE END 0 */
 
 CAN_HandleTypeDef hcan;
@@ -60,7 +81,7 @@ void MX_CAN_Init(void)
   hcan.Init.SyncJumpWidth = CAN_SJW_1TQ;
   hcan.Init.TimeSeg1 = CAN_BS1_3TQ;
   hcan.Init.TimeSeg2 = CAN_BS2_4TQ;
-  hcan.Init.TimeTriggeredMode = DISABLE;
+  hcan.Init.TimeTriggeredMode = ENABLE;
   hcan.Init.AutoBusOff = DISABLE;
   hcan.Init.AutoWakeUp = DISABLE;
   hcan.Init.AutoRetransmission = DISABLE;
@@ -101,7 +122,14 @@ void HAL_CAN_MspInit(CAN_HandleTypeDef* canHandle)
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
   /* USER CODE BEGIN CAN_MspInit 1 */
-
+    /* CAN interrupt Init: RX drains FIFO0 before TX refills mailboxes */
+    HAL_NVIC_SetPriority(CAN_RX0_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(CAN_RX0_IRQn);
+    HAL_NVIC_SetPriority(CAN_TX_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(CAN_TX_IRQn);
+    /* Error interrupts, enabled in CAN_IER by the bus monitor (monitor.h) */
+    HAL_NVIC_SetPriority(CAN_SCE_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(CAN_SCE_IRQn);
   /* USER CODE END CAN_MspInit 1 */
   }
 }
@@ -124,11 +152,362 @@ void HAL_CAN_MspDeInit(CAN_HandleTypeDef* canHandle)
     HAL_GPIO_DeInit(GPIOA, GPIO_PIN_11|GPIO_PIN_12);
 
   /* USER CODE BEGIN CAN_MspDeInit 1 */
-
+    HAL_NVIC_DisableIRQ(CAN_RX0_IRQn);
+    HAL_NVIC_DisableIRQ(CAN_TX_IRQn);
+    HAL_NVIC_DisableIRQ(CAN_SCE_IRQn);
   /* USER CODE END CAN_MspDeInit 1 */
   }
 }
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief  Enables the interrupts that feed the RX queue and drain the TX queue
+  * @note   Call after HAL_CAN_Start()
+  * @retval None
+  */
+void CAN_StartQueues(void)
+{
+  if (HAL_CAN_ActivateNotification(&hcan, CAN_IT_TX_MAILBOX_EMPTY |
+                                          CAN_IT_RX_FIFO0_MSG_PENDING |
+                                          CAN_IT_RX_FIFO0_OVERRUN) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/**
+  * @brief  Loads a frame into a free transmit mailbox and requests transmission
+  * @param  mailbox: mailbox number (0..2), must be empty
+  * @param  frame: frame to send
+  * @param  tgt: CAN_TDT0R_TGT to have the controller write its time stamp
+  *         into data bytes 6 and 7 (DLC 8 only), else 0
+  * @retval None
+  */
+static CCMRAM_FUNC void CAN_LoadMailbox(uint32_t mailbox, const CAN_Frame *frame, uint32_t tgt)
+{
+  CAN_TxMailBox_TypeDef *mb = &hcan.Instance->sTxMailBox[mailbox];
+  uint32_t tir;
+
+  if ((frame->id & CAN_FRAME_EXT) != 0U)
+  {
+    tir = ((frame->id & CAN_FRAME_ID_MASK) << CAN_TI0R_EXID_Pos) | CAN_ID_EXT;
+  }
+  else
+  {
+    tir = (frame->id & 0x7FFU) << CAN_TI0R_STID_Pos;
+  }
+  if ((frame->id & CAN_FRAME_RTR) != 0U)
+  {
+    tir |= CAN_RTR_REMOTE;
+  }
+
+  mb->TDTR = frame->dlc | tgt;
+  mb->TDLR = ((uint32_t)frame->data[3] << 24) | ((uint32_t)frame->data[2] << 16) |
+             ((uint32_t)frame->data[1] << 8)  | frame->data[0];
+  mb->TDHR = ((uint32_t)frame->data[7] << 24) | ((uint32_t)frame->data[6] << 16) |
+             ((uint32_t)frame->data[5] << 8)  | frame->data[4];
+  mb->TIR = tir | CAN_TI0R_TXRQ;
+
+  canStats.txFrames++;
+}
+
+/**
+  * @brief  Queues a frame for transmission
+  * @param  frame: frame to send
+  * @retval HAL_OK when loaded into a mailbox or queued, HAL_BUSY when the
+  *         TX queue is full (counted in canStats.txDropped)
+  *
+  * The frame goes straight into a mailbox when one is free and nothing is
+  * waiting, otherwise CAN_TxMailbox_IRQ() sends it once a mailbox empties.
+  * In silent mode it is discarded and counted in canStats.txSilenced.
+  */
+CCMRAM_FUNC HAL_StatusTypeDef CAN_TransmitFrame(const CAN_Frame *frame)
+{
+  HAL_StatusTypeDef status = HAL_OK;
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (silent)
+  {
+    canStats.txSilenced++;
+  }
+  else if ((txHead == txTail) && ((hcan.Instance->TSR & CAN_TSR_TME_ALL) != 0U))
+  {
+    uint32_t mailbox = (hcan.Instance->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+
+    CAN_LoadMailbox(mailbox, frame, 0);
+    TRACE_EVENT(TRACE_EVT_CAN_TX_ENQUEUE, mailbox, frame->id);
+  }
+  else if ((txHead - txTail) < CAN_TX_QUEUE_LEN)
+  {
+    txQueue[txHead & (CAN_TX_QUEUE_LEN - 1U)] = *frame;
+    txHead++;
+    TRACE_EVENT(TRACE_EVT_CAN_TX_ENQUEUE, 0xFF, frame->id);
+  }
+  else
+  {
+    canStats.txDropped++;
+    status = HAL_BUSY;
+  }
+  __set_PRIMASK(primask);
+
+  return status;
+}
+
+/**
+  * @brief  Queues a frame described by a HAL transmit header
+  * @param  header: HAL transmit header (StdId/ExtId, IDE, RTR, DLC)
+  * @param  data: payload, DLC bytes
+  * @retval See CAN_TransmitFrame()
+  */
+HAL_StatusTypeDef CAN_Transmit(const CAN_TxHeaderTypeDef *header, const uint8_t *data)
+{
+  CAN_Frame frame;
+  uint32_t i;
+
+  if (header->IDE == CAN_ID_EXT)
+  {
+    frame.id = (header->ExtId & CAN_FRAME_ID_MASK) | CAN_FRAME_EXT;
+  }
+  else
+  {
+    frame.id = header->StdId & 0x7FFU;
+  }
+  if (header->RTR == CAN_RTR_REMOTE)
+  {
+    frame.id |= CAN_FRAME_RTR;
+  }
+  frame.dlc = (uint8_t)((header->DLC > 8U) ? 8U : header->DLC);
+  frame.filter = 0;
+  frame.time = 0;
+  for (i = 0; i < 8U; i++)
+  {
+    frame.data[i] = (i < frame.dlc) ? data[i] : 0U;
+  }
+
+  return CAN_TransmitFrame(&frame);
+}
+
+/**
+  * @brief  Takes the oldest received frame from the RX queue
+  * @param  frame: destination
+  * @retval 1 if a frame was returned, 0 if the queue is empty
+  */
+CCMRAM_FUNC uint8_t CAN_Receive(CAN_Frame *frame)
+{
+  uint32_t tail = rxTail;
+
+  if (tail == rxHead)
+  {
+    return 0;
+  }
+  *frame = rxQueue[tail & (CAN_RX_QUEUE_LEN - 1U)];
+  rxTail = tail + 1U;
+
+  return 1;
+}
+
+/**
+  * @brief  Tells whether CAN_Receive() has a frame to return
+  * @retval 1 if the RX queue is not empty
+  */
+CCMRAM_FUNC uint8_t CAN_RxPending(void)
+{
+  return (rxTail != rxHead) ? 1U : 0U;
+}
+
+/**
+  * @brief  Free entries in the TX queue, for senders of long frame sequences
+  * @retval number of frames CAN_TransmitFrame() accepts without HAL_BUSY
+  */
+uint32_t CAN_TxQueueFree(void)
+{
+  return CAN_TX_QUEUE_LEN - (txHead - txTail);
+}
+
+/**
+  * @brief  Switches the controller in or out of silent mode (BTR.SILM): it
+  *         receives without acknowledging and sends nothing
+  * @param  on: 1 for silent mode, 0 for normal mode
+  * @note   The controller passes through initialization mode, frames on the
+  *         bus meanwhile are missed. Call with the TX queue and the mailboxes
+  *         empty, frames queued in silent mode are discarded
+  * @retval None
+  */
+void CAN_SetSilent(uint8_t on)
+{
+  (void)HAL_CAN_Stop(&hcan);
+  if (on)
+  {
+    hcan.Instance->BTR |= CAN_BTR_SILM;
+  }
+  else
+  {
+    hcan.Instance->BTR &= ~CAN_BTR_SILM;
+  }
+  silent = on;
+  (void)HAL_CAN_Start(&hcan);
+}
+
+/**
+  * @brief  Tells whether CAN_SetSilent() put the controller in silent mode
+  * @retval 1 in silent mode
+  */
+uint8_t CAN_Silent(void)
+{
+  return silent;
+}
+
+/**
+  * @brief  Tells when the node last received a frame, for work that stalls
+  *         the CPU and is best started while the bus is quiet
+  * @retval HAL tick of the last RX FIFO0 interrupt
+  */
+uint32_t CAN_LastRxTick(void)
+{
+  return lastRxTick;
+}
+
+/**
+  * @brief  CAN RX FIFO0 interrupt body: moves every pending frame to the queue
+  * @retval None
+  */
+CCMRAM_FUNC void CAN_RxFifo0_IRQ(void)
+{
+  CAN_TypeDef *can = hcan.Instance;
+  uint32_t drained = 0;
+
+  TRACE_EVENT(TRACE_EVT_CAN_RX_ISR_ENTER, 0, can->RF0R & CAN_RF0R_FMP0);
+  lastRxTick = HAL_GetTick();
+
+  if ((can->RF0R & CAN_RF0R_FOVR0) != 0U)
+  {
+    can->RF0R = CAN_RF0R_FOVR0;
+    canStats.rxOverruns++;
+  }
+
+  while ((can->RF0R & CAN_RF0R_FMP0) != 0U)
+  {
+    const CAN_FIFOMailBox_TypeDef *mb = &can->sFIFOMailBox[0];
+    uint32_t head = rxHead;
+    uint32_t rir = mb->RIR;
+    uint32_t rdtr = mb->RDTR;
+    uint32_t rdlr = mb->RDLR;
+
+    Monitor_Frame(rir, rdtr);
+    if (Ping_Frame(rir, rdtr, rdlr) != 0U)
+    {
+      /* Answered from the TX interrupt, not queued */
+    }
+    else if ((head - rxTail) < CAN_RX_QUEUE_LEN)
+    {
+      CAN_Frame *f = &rxQueue[head & (CAN_RX_QUEUE_LEN - 1U)];
+      uint32_t rdhr = mb->RDHR;
+
+      if ((rir & CAN_RI0R_IDE) != 0U)
+      {
+        f->id = (rir >> CAN_RI0R_EXID_Pos) | CAN_FRAME_EXT;
+      }
+      else
+      {
+        f->id = rir >> CAN_RI0R_STID_Pos;
+      }
+      if ((rir & CAN_RI0R_RTR) != 0U)
+      {
+        f->id |= CAN_FRAME_RTR;
+      }
+      f->dlc = (uint8_t)(rdtr & CAN_RDT0R_DLC);
+      f->filter = (uint8_t)((rdtr & CAN_RDT0R_FMI) >> CAN_RDT0R_FMI_Pos);
+#if SLCAN_ENABLE
+      f->time = (uint16_t)(HAL_GetTick() % SLCAN_STAMP_WRAP);
+#else
+      f->time = (uint16_t)(rdtr >> CAN_RDT0R_TIME_Pos);
+#endif
+      f->data[0] = (uint8_t)rdlr;
+      f->data[1] = (uint8_t)(rdlr >> 8);
+      f->data[2] = (uint8_t)(rdlr >> 16);
+      f->data[3] = (uint8_t)(rdlr >> 24);
+      f->data[4] = (uint8_t)rdhr;
+      f->data[5] = (uint8_t)(rdhr >> 8);
+      f->data[6] = (uint8_t)(rdhr >> 16);
+      f->data[7] = (uint8_t)(rdhr >> 24);
+
+      rxHead = head + 1U;
+      canStats.rxFrames++;
+    }
+    else
+    {
+      canStats.rxDropped++;
+    }
+
+    /* Release the output mailbox and wait until FMP0 reflects it */
+    can->RF0R = CAN_RF0R_RFOM0;
+    while ((can->RF0R & CAN_RF0R_RFOM0) != 0U)
+    {
+    }
+    drained++;
+  }
+
+  TRACE_EVENT(TRACE_EVT_CAN_RX_ISR_EXIT, 0, drained);
+}
+
+/**
+  * @brief  CAN TX interrupt body: acknowledges completed mailboxes, counts
+  *         those that failed in canStats.txFailed, and refills empty ones
+  *         with the temperature alarm (alarm.h), ping echoes (ping.h), from
+  *         the TX queue, then from the bus-stress generator (stress.h)
+  * @retval None
+  */
+CCMRAM_FUNC void CAN_TxMailbox_IRQ(void)
+{
+  CAN_TypeDef *can = hcan.Instance;
+  uint32_t tsr = can->TSR;
+  uint32_t done = tsr & (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2);
+  uint32_t mailbox;
+  CAN_Frame frame;
+
+  /* Writing RQCPx also clears TXOKx, ALSTx and TERRx */
+  can->TSR = done;
+  for (mailbox = 0; mailbox < 3U; mailbox++)
+  {
+    if ((done & (CAN_TSR_RQCP0 << (8U * mailbox))) != 0U)
+    {
+      uint32_t ok = (tsr >> (CAN_TSR_TXOK0_Pos + (8U * mailbox))) & 1U;
+
+      /* AutoRetransmission is disabled: a lost frame is not sent again */
+      if (ok == 0U)
+      {
+        canStats.txFailed++;
+      }
+      TRACE_EVENT(TRACE_EVT_CAN_TX_COMPLETE, mailbox, ok);
+    }
+  }
+
+  if (((can->TSR & CAN_TSR_TME_ALL) != 0U) && (Alarm_Next(&frame) != 0U))
+  {
+    mailbox = (can->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+    CAN_LoadMailbox(mailbox, &frame, 0);
+  }
+
+  while (((can->TSR & CAN_TSR_TME_ALL) != 0U) && (Ping_Next(&frame) != 0U))
+  {
+    mailbox = (can->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+    CAN_LoadMailbox(mailbox, &frame, CAN_TDT0R_TGT);
+  }
+
+  while ((txTail != txHead) && ((can->TSR & CAN_TSR_TME_ALL) != 0U))
+  {
+    mailbox = (can->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+    CAN_LoadMailbox(mailbox, &txQueue[txTail & (CAN_TX_QUEUE_LEN - 1U)], 0);
+    txTail++;
+  }
+
+  while ((txTail == txHead) && ((can->TSR & CAN_TSR_TME_ALL) != 0U) && (Stress_Next(&frame) != 0U))
+  {
+    mailbox = (can->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+    CAN_LoadMailbox(mailbox, &frame, 0);
+  }
+}
+
 /* USER CODE END 1 */
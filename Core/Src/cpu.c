@@ -0,0 +1,216 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : cpu.c
+  * @brief          : CPU time accounting and load figures, diagnostics PGN
+  *                   (see cpu.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The handlers only add to their own counters (Cpu_Exit() in cpu.h); the
+  * totals, the Stop mode time and the windows are brought up to date at
+  * the start of every idle wait, in thread mode, where no section is open.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cpu.h"
+#include "can.h"
+#include "params.h"
+#include "scheduler.h"
+
+/* Private define ------------------------------------------------------------*/
+#define CPU_DIAG_ID(src) \
+  (CAN_FRAME_EXT | (CPU_PRIO_DIAG << 26) | (CPU_PGN_DIAG << 8) | (uint32_t)(src))
+
+/* Private variables ---------------------------------------------------------*/
+Cpu_Stats cpuStats;
+
+static uint32_t lastCycles;       /* CYCCNT at the last update */
+static uint64_t lastStopUs;       /* schedulerStats.stopUs at the last update */
+
+/* Open window: the figures at its start */
+static uint64_t windowTotal;
+static uint64_t windowIdle;
+static uint64_t windowStop;
+static uint64_t windowAdc;
+static uint32_t windowNested;
+
+static uint16_t loads[CPU_WINDOWS];   /* 0.1 %, by window modulo CPU_WINDOWS */
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Mean load of the last n closed windows, or of as many as there are */
+static uint16_t meanLoad(uint32_t n)
+{
+  uint32_t sum = 0;
+  uint32_t i;
+
+  if (n > cpuStats.windows)
+  {
+    n = cpuStats.windows;
+  }
+  for (i = 1U; i <= n; i++)
+  {
+    sum += loads[(cpuStats.windows - i) % CPU_WINDOWS];
+  }
+  return (uint16_t)((sum + (n / 2U)) / n);
+}
+
+static void closeWindow(void)
+{
+  uint64_t total = cpuStats.totalCycles - windowTotal;
+  uint64_t stop = cpuStats.stopCycles - windowStop;
+  uint64_t spare = (cpuStats.idleCycles - windowIdle) + stop;
+  uint64_t handlers = (uint64_t)(cpuStats.nested - windowNested) - (cpuStats.cycles[CPU_SRC_ADC] - windowAdc);
+
+  if (spare > total)
+  {
+    spare = total;
+  }
+  if (handlers > total)
+  {
+    handlers = total;
+  }
+  loads[cpuStats.windows % CPU_WINDOWS] = (uint16_t)(((total - spare) * 1000U + (total / 2U)) / total);
+  cpuStats.windows++;
+  cpuStats.load1 = meanLoad(1U);
+  cpuStats.load10 = meanLoad(10U);
+  cpuStats.load60 = meanLoad(CPU_WINDOWS);
+  cpuStats.handlerShare = (uint8_t)((handlers * 200U + (total / 2U)) / total);
+  cpuStats.flags = (uint8_t)(((cpuStats.windows >= CPU_WINDOWS) ? CPU_DIAG_FULL : 0U) |
+                             ((stop != 0U) ? CPU_DIAG_STOP : 0U));
+
+  windowTotal = cpuStats.totalCycles;
+  windowIdle = cpuStats.idleCycles;
+  windowStop = cpuStats.stopCycles;
+  windowAdc = cpuStats.cycles[CPU_SRC_ADC];
+  windowNested = cpuStats.nested;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Adds the cycles since the last update, Stop mode included, and
+  *         closes the window once it is CPU_WINDOW_MS long; from thread mode
+  * @retval None
+  *
+  * Cpu_IdleEnter() calls it on every scheduler pass, often enough for the
+  * counter; call it before reading the totals between passes.
+  */
+void Cpu_Update(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t now;
+  uint64_t stopUs = schedulerStats.stopUs;
+  uint64_t stop = (stopUs - lastStopUs) * (SystemCoreClock / 1000000U);
+
+  /* A handler between the reads would fall outside the window's total */
+  __disable_irq();
+  now = CPU_CYCLES();
+  cpuStats.stopCycles += stop;
+  cpuStats.totalCycles += (uint64_t)(now - lastCycles) + stop;
+  lastCycles = now;
+  lastStopUs = stopUs;
+
+  if ((cpuStats.totalCycles - windowTotal) >= (uint64_t)CPU_WINDOW_MS * (SystemCoreClock / 1000U))
+  {
+    closeWindow();
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Starts the cycle counter, if the trace has not, and the
+  *         accounting from now
+  * @retval None
+  */
+void Cpu_Init(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t i;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /* Handlers taken before now do not count */
+  __disable_irq();
+  for (i = 0; i < CPU_SOURCES; i++)
+  {
+    cpuStats.cycles[i] = 0;
+    cpuStats.counts[i] = 0;
+  }
+  windowNested = cpuStats.nested;
+  lastCycles = CPU_CYCLES();
+  __set_PRIMASK(primask);
+
+  lastStopUs = schedulerStats.stopUs;
+  cpuStats.load1 = CPU_LOAD_NA;
+  cpuStats.load10 = CPU_LOAD_NA;
+  cpuStats.load60 = CPU_LOAD_NA;
+  cpuStats.handlerShare = CPU_SHARE_NA;
+}
+
+/**
+  * @brief  Brings the totals up to date and starts the idle section; the
+  *         scheduler calls it when it starts to wait
+  * @param  s: section state, on the caller's stack
+  * @retval None
+  */
+void Cpu_IdleEnter(Cpu_Section *s)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  /* No handler between the update and the start of the section */
+  __disable_irq();
+  Cpu_Update();
+  s->start = lastCycles;
+  s->nested = cpuStats.nested;
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Ends the idle section; the handlers taken during it are theirs
+  * @param  s: section state from Cpu_IdleEnter()
+  * @retval None
+  */
+void Cpu_IdleExit(const Cpu_Section *s)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  cpuStats.idleCycles += (CPU_CYCLES() - s->start) - (cpuStats.nested - s->nested);
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Queues the diagnostics message (PGN 65281)
+  * @retval None
+  */
+void Cpu_SendDiag(void)
+{
+  CAN_Frame frame;
+
+  frame.id = CPU_DIAG_ID(Params_Get(PARAM_SOURCE_ADDRESS) & 0xFFUL);
+  frame.dlc = 8;
+  frame.data[0] = (uint8_t)cpuStats.load1;
+  frame.data[1] = (uint8_t)(cpuStats.load1 >> 8);
+  frame.data[2] = (uint8_t)cpuStats.load10;
+  frame.data[3] = (uint8_t)(cpuStats.load10 >> 8);
+  frame.data[4] = (uint8_t)cpuStats.load60;
+  frame.data[5] = (uint8_t)(cpuStats.load60 >> 8);
+  frame.data[6] = cpuStats.handlerShare;
+  frame.data[7] = (uint8_t)(0xFCU | cpuStats.flags);
+  (void)CAN_TransmitFrame(&frame);
+
+  cpuStats.diags++;
+}
@@ -0,0 +1,319 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : crash.c
+  * @brief          : Fault and Error_Handler capture with a crash report
+  *                   over CAN (see crash.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The capture runs with interrupts off on whatever stack the fault left,
+  * touches no peripheral but the SCB and RTC backup registers and resets
+  * through the SCB: a few hundred cycles, not the watchdog timeout. Stack
+  * words are only read inside SRAM, so a corrupt stack pointer costs the
+  * snapshot, not a second fault.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "crash.h"
+#include "boot.h"
+#include "history.h"
+#include "trace.h"
+#include "watchdog.h"
+
+/* Private define ------------------------------------------------------------*/
+#define EXC_RETURN_NO_FPU       (1UL << 4)    /* clear: FPU registers stacked too */
+#define XPSR_STACK_ALIGN        (1UL << 9)    /* a padding word was pushed first */
+#define FRAME_WORDS             8U
+#define FRAME_WORDS_FPU         26U
+
+#define CRASH_REPORT_SIZE       ((uint32_t)sizeof(Crash_Report))
+
+/* Private variables ---------------------------------------------------------*/
+extern uint32_t _estack;          /* top of SRAM, from the linker script */
+
+Crash_Record crashRecord __attribute__((section(".noinit")));
+Crash_Stats crashStats;
+
+static struct
+{
+  uint8_t active;
+  uint8_t requester;
+  uint32_t offset;                /* next byte of the report */
+  uint32_t frame;                 /* data frames queued */
+} transfer;
+
+/* Private functions ---------------------------------------------------------*/
+static uint16_t reportCrc(void)
+{
+  return History_Crc16(0xFFFFU, (const uint8_t *)&crashRecord.report, CRASH_REPORT_SIZE);
+}
+
+/* 1 if words 32-bit words from address lie in SRAM below the initial stack */
+static uint8_t inStack(uint32_t address, uint32_t words)
+{
+  return (address >= SRAM_BASE) && ((address & 3U) == 0U) &&
+         ((uintptr_t)address + (words * 4U) <= (uintptr_t)&_estack);
+}
+
+static void clearReport(Crash_Report *report)
+{
+  uint32_t *word = (uint32_t *)report;
+  uint32_t i;
+
+  for (i = 0; i < (CRASH_REPORT_SIZE / 4U); i++)
+  {
+    word[i] = 0;
+  }
+}
+
+static void snapshotStack(Crash_Report *report)
+{
+  const uint32_t *stack = (const uint32_t *)(uintptr_t)report->sp;
+  uint32_t words = CRASH_STACK_WORDS;
+
+  while ((words != 0U) && !inStack(report->sp, words))
+  {
+    words--;
+  }
+  for (report->stackWords = 0; report->stackWords < words; report->stackWords++)
+  {
+    report->stack[report->stackWords] = stack[report->stackWords];
+  }
+}
+
+static void __attribute__((__noreturn__)) saveAndReset(Crash_Report *report)
+{
+  report->task = Watchdog_Current();
+  report->uptimeMs = HAL_GetTick();
+  report->cfsr = SCB->CFSR;
+  report->hfsr = SCB->HFSR;
+  report->mmfar = SCB->MMFAR;
+  report->bfar = SCB->BFAR;
+  report->traceEvents = (uint8_t)Trace_Recent((Trace_Record *)report->trace, CRASH_TRACE_EVENTS);
+
+  crashRecord.crc = reportCrc();
+  crashRecord.reported = 0;
+  crashRecord.magic = CRASH_MAGIC;
+
+  HAL_NVIC_SystemReset();
+  while (1)
+  {
+  }
+}
+
+static void sendResponse(uint8_t requester, const uint8_t *data)
+{
+  CAN_Frame response;
+  uint32_t i;
+
+  response.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, requester, BOOT_NODE_ADDRESS);
+  response.dlc = 8;
+  for (i = 0; i < 8U; i++)
+  {
+    response.data[i] = data[i];
+  }
+  (void)CAN_TransmitFrame(&response);
+}
+
+static void sendReport(uint8_t requester)
+{
+  uint8_t status = CRASH_OK;
+  uint8_t kind = 0;
+  uint32_t bytes = 0;
+  uint16_t crc = 0;
+
+  if (crashRecord.magic != CRASH_MAGIC)
+  {
+    status = CRASH_ERR_NONE;
+  }
+  else if (transfer.active && (transfer.requester != requester))
+  {
+    status = CRASH_ERR_BUSY;
+  }
+  else
+  {
+    kind = crashRecord.report.kind;
+    bytes = CRASH_REPORT_SIZE;
+    crc = crashRecord.crc;
+    transfer.active = 1;
+    transfer.requester = requester;
+    transfer.offset = 0;
+    transfer.frame = 0;
+    crashStats.requests++;
+  }
+
+  {
+    uint8_t rsp[8] = { CRASH_CMD_GET | BOOT_RSP, status, kind, (uint8_t)bytes, (uint8_t)(bytes >> 8),
+                       (uint8_t)crc, (uint8_t)(crc >> 8), 0xFF };
+
+    sendResponse(requester, rsp);
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Checks the report left by the last reset and sends it to the
+  *         global address if it has not been sent yet; call once CAN runs
+  * @retval None
+  */
+void Crash_Init(void)
+{
+  /* After power-on CCMRAM holds noise, which the CRC tells apart */
+  if ((crashRecord.magic != CRASH_MAGIC) || (crashRecord.crc != reportCrc()))
+  {
+    crashRecord.magic = 0;
+    return;
+  }
+  if (!crashRecord.reported)
+  {
+    sendReport(0xFF);
+  }
+}
+
+/**
+  * @brief  Saves a report of a fault exception and resets the node; entered
+  *         from CRASH_FAULT_ENTRY()
+  * @param  frame: exception frame on the stack in use when the fault hit
+  * @param  kind: CRASH_KIND_x
+  * @param  excReturn: EXC_RETURN of the handler
+  * @retval None, does not return
+  */
+void Crash_Fault(const uint32_t *frame, uint32_t kind, uint32_t excReturn)
+{
+  Crash_Report *report = &crashRecord.report;
+  uint32_t address = (uint32_t)(uintptr_t)frame;
+  uint32_t words = ((excReturn & EXC_RETURN_NO_FPU) != 0U) ? FRAME_WORDS : FRAME_WORDS_FPU;
+
+  __disable_irq();
+  clearReport(report);
+  report->kind = (uint8_t)kind;
+  report->excReturn = excReturn;
+
+  if (inStack(address, words))
+  {
+    report->r0 = frame[0];
+    report->r1 = frame[1];
+    report->r2 = frame[2];
+    report->r3 = frame[3];
+    report->r12 = frame[4];
+    report->lr = frame[5];
+    report->pc = frame[6];
+    report->xpsr = frame[7];
+    report->sp = address + (words * 4U) + (((report->xpsr & XPSR_STACK_ALIGN) != 0U) ? 4U : 0U);
+    snapshotStack(report);
+  }
+  saveAndReset(report);
+}
+
+/**
+  * @brief  Saves a report of an Error_Handler() call and resets the node
+  * @param  caller: return address of Error_Handler()
+  * @retval None, does not return
+  */
+void Crash_Error(uint32_t caller)
+{
+  Crash_Report *report = &crashRecord.report;
+
+  __disable_irq();
+  clearReport(report);
+  report->kind = CRASH_KIND_ERROR;
+  report->pc = caller;
+  report->sp = __get_MSP();
+  snapshotStack(report);
+  saveAndReset(report);
+}
+
+/**
+  * @brief  Serves CRASH_GET and CRASH_CLEAR addressed to this node
+  * @param  frame: frame taken from the CAN RX queue
+  * @retval None
+  *
+  * A repeated request from the same node restarts its transfer.
+  */
+void Crash_HandleFrame(const CAN_Frame *frame)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  uint8_t requester = (uint8_t)BOOT_ID_SA(id);
+
+  if (((frame->id & CAN_FRAME_EXT) == 0U) || (frame->dlc < 1U) ||
+      (BOOT_ID_PGN(id) != BOOT_PGN_CMD) || (BOOT_ID_DA(id) != BOOT_NODE_ADDRESS))
+  {
+    return;
+  }
+
+  if (frame->data[0] == CRASH_CMD_GET)
+  {
+    sendReport(requester);
+  }
+  else if (frame->data[0] == CRASH_CMD_CLEAR)
+  {
+    uint8_t rsp[8] = { CRASH_CMD_CLEAR | BOOT_RSP, CRASH_OK, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+    if (transfer.active && (transfer.requester != requester))
+    {
+      rsp[1] = CRASH_ERR_BUSY;
+    }
+    else
+    {
+      transfer.active = 0;
+      crashRecord.magic = 0;
+    }
+    sendResponse(requester, rsp);
+  }
+}
+
+/**
+  * @brief  Queues the next burst of a running transfer once the previous
+  *         one has left the mailboxes, as History_Poll()
+  * @retval 1 while a transfer is running
+  */
+uint8_t Crash_Poll(void)
+{
+  uint32_t burst = CAN_TX_QUEUE_LEN - HISTORY_TX_RESERVE;
+
+  if (!transfer.active || (CAN_TxQueueFree() != CAN_TX_QUEUE_LEN) ||
+      (HAL_CAN_GetTxMailboxesFreeLevel(&hcan) != 3U))
+  {
+    return transfer.active;
+  }
+
+  while (transfer.active && (burst-- != 0U))
+  {
+    CAN_Frame data;
+    uint32_t i;
+
+    data.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_DATA, BOOT_PGN_DATA, transfer.requester, BOOT_NODE_ADDRESS);
+    data.dlc = 8;
+    data.data[0] = (uint8_t)transfer.frame++;
+    for (i = 1; i < 8U; i++)
+    {
+      data.data[i] = (transfer.offset < CRASH_REPORT_SIZE) ?
+                     ((const uint8_t *)&crashRecord.report)[transfer.offset++] : 0xFFU;
+    }
+    (void)CAN_TransmitFrame(&data);
+    crashStats.frames++;
+
+    if (transfer.offset == CRASH_REPORT_SIZE)
+    {
+      transfer.active = 0;
+      if (transfer.requester == 0xFFU)
+      {
+        crashRecord.reported = 1;
+      }
+    }
+  }
+
+  return transfer.active;
+}
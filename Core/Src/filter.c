@@ -0,0 +1,233 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : filter.c
+  * @brief          : Temperature sensor filter stage on CMSIS-DSP kernels (see
+  *                   filter.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Only arm_mean_q15(), arm_biquad_cascade_df1_q31() and its init function
+  * are linked from CMSIS-DSP (Drivers/CMSIS/DSP), compiled with the rest of
+  * the application for the Cortex-M4 (ARM_MATH_CM4), not the prebuilt
+  * library.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "filter.h"
+
+#ifndef BOOT_HOST
+#include "params.h"
+#include "temperature.h"
+#endif
+
+/* Private define ------------------------------------------------------------*/
+#define FILTER_Q30_ONE          (1L << 30)
+#define FILTER_SQRT2            1.41421356f
+#define FILTER_CODE_MAX         4095U
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Q2.30, rounded to the nearest */
+static q31_t toQ30(float value)
+{
+  float scaled = value * (float)FILTER_Q30_ONE;
+
+  return (q31_t)((scaled >= 0.0f) ? (scaled + 0.5f) : (scaled - 0.5f));
+}
+
+/* Median of a batch, in 1/8 code; sorts a copy in the work buffer */
+static uint32_t median(Filter_State *filter, const uint16_t *codes, uint32_t count)
+{
+  uint16_t *sorted = filter->work.codes;
+  uint32_t i;
+  uint32_t j;
+
+  for (i = 0; i < count; i++)
+  {
+    uint16_t code = codes[i];
+
+    for (j = i; (j > 0U) && (sorted[j - 1U] > code); j--)
+    {
+      sorted[j] = sorted[j - 1U];
+    }
+    sorted[j] = code;
+  }
+  if ((count & 1U) != 0U)
+  {
+    return (uint32_t)sorted[count / 2U] << FILTER_FRAC_BITS;
+  }
+  return ((uint32_t)sorted[(count / 2U) - 1U] + sorted[count / 2U]) << (FILTER_FRAC_BITS - 1U);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Sets the mode, the batch and the IIR coefficients and starts
+  *         the filter again; values out of range take the nearest limit,
+  *         an unknown mode is off
+  * @param  filter: filter to set up
+  * @param  mode: FILTER_MODE_x
+  * @param  batch: conversions per Filter_Run(), 1 to FILTER_BATCH_MAX
+  * @param  cutoffPermille: IIR cutoff, FILTER_CUTOFF_MIN to FILTER_CUTOFF_MAX
+  *         per mille of the conversion rate
+  * @retval None
+  */
+void Filter_Configure(Filter_State *filter, uint32_t mode, uint32_t batch, uint32_t cutoffPermille)
+{
+  float k;
+  float k2;
+  float norm;
+  q31_t b0;
+  q31_t a1;
+  q31_t a2;
+
+  filter->mode = (uint8_t)((mode < FILTER_MODES) ? mode : FILTER_MODE_OFF);
+  batch = (batch < 1U) ? 1U : ((batch > FILTER_BATCH_MAX) ? FILTER_BATCH_MAX : batch);
+  filter->batch = (uint8_t)((filter->mode == FILTER_MODE_OFF) ? 1U : batch);
+  cutoffPermille = (cutoffPermille < FILTER_CUTOFF_MIN) ? FILTER_CUTOFF_MIN :
+                   ((cutoffPermille > FILTER_CUTOFF_MAX) ? FILTER_CUTOFF_MAX : cutoffPermille);
+
+  /* Butterworth through the bilinear transform, prewarped; the feedback
+   * coefficients go in negated, as the kernel adds them */
+  k = tanf(PI * (float)cutoffPermille / 1000.0f);
+  k2 = k * k;
+  norm = 1.0f / (1.0f + (FILTER_SQRT2 * k) + k2);
+  b0 = toQ30(k2 * norm);
+  a1 = toQ30(2.0f * (1.0f - k2) * norm);
+  a2 = toQ30(-(1.0f - (FILTER_SQRT2 * k) + k2) * norm);
+  filter->coeffs[0] = b0;
+  filter->coeffs[1] = (q31_t)((int64_t)FILTER_Q30_ONE - b0 - b0 - a1 - a2);
+  filter->coeffs[2] = b0;
+  filter->coeffs[3] = a1;
+  filter->coeffs[4] = a2;
+  arm_biquad_cascade_df1_init_q31(&filter->iir, 1U, filter->coeffs, filter->state, 1);
+  filter->primed = 0;
+}
+
+/**
+  * @brief  Conversions Filter_Run() takes at a time
+  * @param  filter: configured filter
+  * @retval 1 to FILTER_BATCH_MAX
+  */
+uint32_t Filter_Batch(const Filter_State *filter)
+{
+  return filter->batch;
+}
+
+/**
+  * @brief  Reduces a batch of conversions to one value
+  * @param  filter: configured filter
+  * @param  codes: conversions, oldest first
+  * @param  count: number of conversions, Filter_Batch(); only the last
+  *         FILTER_BATCH_MAX count
+  * @retval Filtered code in 1/8 code (FILTER_FRAC_BITS), 0 without
+  *         conversions
+  */
+uint32_t Filter_Run(Filter_State *filter, const uint16_t *codes, uint32_t count)
+{
+  uint32_t i;
+  q15_t mean;
+  q31_t y;
+
+  if (count == 0U)
+  {
+    return 0U;
+  }
+  if (count > FILTER_BATCH_MAX)
+  {
+    codes += count - FILTER_BATCH_MAX;
+    count = FILTER_BATCH_MAX;
+  }
+
+  switch (filter->mode)
+  {
+    case FILTER_MODE_MEAN:
+      for (i = 0; i < count; i++)
+      {
+        filter->work.q15[i] = (q15_t)(codes[i] << FILTER_FRAC_BITS);
+      }
+      arm_mean_q15(filter->work.q15, count, &mean);
+      return (uint32_t)mean;
+
+    case FILTER_MODE_IIR:
+      for (i = 0; i < count; i++)
+      {
+        filter->work.q31[i] = (q31_t)((uint32_t)codes[i] << FILTER_IIR_SHIFT);
+      }
+      if (!filter->primed)
+      {
+        /* Steady state at the first conversion */
+        for (i = 0; i < 4U; i++)
+        {
+          filter->state[i] = filter->work.q31[0];
+        }
+        filter->primed = 1;
+      }
+      arm_biquad_cascade_df1_q31(&filter->iir, filter->work.q31, filter->work.q31, count);
+      y = filter->work.q31[count - 1U];
+      if (y <= 0)
+      {
+        return 0U;
+      }
+      if (y >= (q31_t)(FILTER_CODE_MAX << FILTER_IIR_SHIFT))
+      {
+        return FILTER_CODE_MAX << FILTER_FRAC_BITS;
+      }
+      return ((uint32_t)y + (1UL << (FILTER_IIR_SHIFT - FILTER_FRAC_BITS - 1U))) >>
+             (FILTER_IIR_SHIFT - FILTER_FRAC_BITS);
+
+    case FILTER_MODE_MEDIAN:
+      return median(filter, codes, count);
+
+    default:
+      return (uint32_t)codes[count - 1U] << FILTER_FRAC_BITS;
+  }
+}
+
+#ifndef BOOT_HOST
+
+/* Private variables ---------------------------------------------------------*/
+static Filter_State filter;
+static uint32_t configured[3];    /* mode, batch, cutoff in use */
+static uint8_t ready;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Takes a batch of conversions through the filter the parameters
+  *         select, set up again when they have changed
+  * @retval Filtered code in 1/8 code (FILTER_FRAC_BITS)
+  */
+uint32_t Filter_Read(void)
+{
+  uint16_t codes[FILTER_BATCH_MAX];
+  uint32_t i;
+
+  if (!ready || (Params_Get(PARAM_FILTER_MODE) != configured[0]) ||
+      (Params_Get(PARAM_FILTER_BATCH) != configured[1]) || (Params_Get(PARAM_FILTER_CUTOFF) != configured[2]))
+  {
+    configured[0] = Params_Get(PARAM_FILTER_MODE);
+    configured[1] = Params_Get(PARAM_FILTER_BATCH);
+    configured[2] = Params_Get(PARAM_FILTER_CUTOFF);
+    Filter_Configure(&filter, configured[0], configured[1], configured[2]);
+    ready = 1;
+  }
+  for (i = 0; i < Filter_Batch(&filter); i++)
+  {
+    codes[i] = Temperature_ReadADC();
+  }
+  return Filter_Run(&filter, codes, Filter_Batch(&filter));
+}
+
+#endif /* BOOT_HOST */
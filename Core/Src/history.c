@@ -0,0 +1,567 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : history.c
+  * @brief          : Temperature history ring and bulk retrieval (format in
+  *                   history.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The block codec at the top has no HAL dependencies and is compiled into
+  * the host tools with BOOT_HOST. Blocks are numbered with a running sequence
+  * number: closed blocks are [tailSeq, headSeq), the open one is headSeq. A
+  * transfer walks the sequence numbers, so it notices when the block it is
+  * sending has been dropped to make room.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "history.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Runs up to this long are a single token byte */
+#define SHORT_RUN_MAX           7U
+
+/* Samples are accepted this far from the block's interval grid, so a task
+ * delayed by a flash erase does not close the block */
+#define INTERVAL_TOLERANCE(ms)  ((ms) / 8U)
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t varintSize(uint32_t value)
+{
+  uint32_t size = 1;
+
+  while (value >= 0x80U)
+  {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+static void putVarint(uint8_t *p, uint32_t value)
+{
+  while (value >= 0x80U)
+  {
+    *p++ = (uint8_t)(value | 0x80U);
+    value >>= 7;
+  }
+  *p = (uint8_t)value;
+}
+
+static int getVarint(const uint8_t *p, uint32_t length, uint32_t *pos, uint32_t *value)
+{
+  uint32_t shift = 0;
+  uint8_t byte;
+
+  *value = 0;
+  do
+  {
+    if ((*pos >= length) || (shift > 28U))
+    {
+      return -1;
+    }
+    byte = p[(*pos)++];
+    *value |= (uint32_t)(byte & 0x7FU) << shift;
+    shift += 7U;
+  } while ((byte & 0x80U) != 0U);
+
+  return 0;
+}
+
+static uint32_t runSize(uint32_t run)
+{
+  return (run <= SHORT_RUN_MAX) ? 1U : (1U + varintSize(run));
+}
+
+static void putRun(uint8_t *p, uint32_t run)
+{
+  if (run <= SHORT_RUN_MAX)
+  {
+    *p = (uint8_t)run;
+  }
+  else
+  {
+    *p = 0;
+    putVarint(p + 1, run);
+  }
+}
+
+/* Exported functions: block codec ------------------------------------------*/
+
+/**
+  * @brief  Starts a block with its first sample
+  * @param  enc: append state, tied to the block until the next start
+  * @param  block: block to fill
+  * @param  timeMs: uptime of the sample
+  * @param  value: sample, 0.01 K
+  * @retval None
+  */
+void History_BlockStart(History_Encoder *enc, History_Block *block, uint32_t timeMs, uint16_t value)
+{
+  block->header.startMs = timeMs;
+  block->header.intervalMs = 0;
+  block->header.first = value;
+  block->header.count = 1;
+  block->header.length = 0;
+  enc->block = block;
+  enc->last = value;
+  enc->runAt = 0;
+  enc->run = 0;
+}
+
+/**
+  * @brief  Appends a sample to the block
+  * @param  enc: append state from History_BlockStart()
+  * @param  timeMs: uptime of the sample
+  * @param  value: sample, 0.01 K
+  * @retval 1 if appended, 0 if the block is full or the sample is off the
+  *         block's interval; start a new block with it
+  *
+  * The second sample sets the interval. A repeated value extends the
+  * trailing run token in place, which may grow it by a byte or two.
+  */
+uint8_t History_BlockAppend(History_Encoder *enc, uint32_t timeMs, uint16_t value)
+{
+  History_Header *header = &enc->block->header;
+  uint8_t *payload = enc->block->payload;
+  uint32_t elapsed = timeMs - header->startMs;
+  int32_t delta = (int32_t)value - (int32_t)enc->last;
+  uint32_t token = 0;
+  uint32_t size;
+  uint32_t at;
+
+  if (header->count == 0xFFFFU)
+  {
+    return 0;
+  }
+  if (header->count == 1U)
+  {
+    if ((elapsed == 0U) || (elapsed > 0xFFFFU))
+    {
+      return 0;
+    }
+  }
+  else
+  {
+    int32_t offGrid = (int32_t)(elapsed - ((uint32_t)header->count * header->intervalMs));
+
+    if ((offGrid < 0 ? -offGrid : offGrid) > (int32_t)INTERVAL_TOLERANCE(header->intervalMs))
+    {
+      return 0;
+    }
+  }
+
+  if (delta == 0)
+  {
+    at = (enc->run != 0U) ? enc->runAt : header->length;
+    size = runSize(enc->run + 1U);
+  }
+  else
+  {
+    /* zigzag keeps small negative deltas small */
+    token = (((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31)) + SHORT_RUN_MAX;
+    at = header->length;
+    size = varintSize(token);
+  }
+  if ((at + size) > HISTORY_PAYLOAD_SIZE)
+  {
+    return 0;
+  }
+
+  if (delta == 0)
+  {
+    putRun(&payload[at], enc->run + 1U);
+    enc->runAt = (uint16_t)at;
+    enc->run++;
+  }
+  else
+  {
+    putVarint(&payload[at], token);
+    enc->run = 0;
+  }
+  header->length = (uint16_t)(at + size);
+  if (header->count == 1U)
+  {
+    header->intervalMs = (uint16_t)elapsed;
+  }
+  header->count++;
+  enc->last = value;
+
+  return 1;
+}
+
+/**
+  * @brief  Decodes the samples of a block
+  * @param  header: block header
+  * @param  payload: header->length payload bytes
+  * @param  values: destination, header->count entries
+  * @param  maxValues: size of values
+  * @retval number of samples (header->count), -1 if the block is malformed
+  *         or values is too small
+  *
+  * Sample i was taken at header->startMs + i * header->intervalMs.
+  */
+int32_t History_BlockDecode(const History_Header *header, const uint8_t *payload,
+                            uint16_t *values, uint32_t maxValues)
+{
+  uint32_t count = header->count;
+  uint32_t n = 1;
+  uint32_t pos = 0;
+  uint16_t previous = header->first;
+
+  if ((count == 0U) || (count > maxValues) || (header->length > HISTORY_PAYLOAD_SIZE))
+  {
+    return -1;
+  }
+  values[0] = previous;
+
+  while (pos < header->length)
+  {
+    uint32_t token;
+    uint32_t run;
+
+    if (getVarint(payload, header->length, &pos, &token) != 0)
+    {
+      return -1;
+    }
+    if (token > SHORT_RUN_MAX)
+    {
+      uint32_t zigzag = token - SHORT_RUN_MAX;
+
+      if (n >= count)
+      {
+        return -1;
+      }
+      previous = (uint16_t)((int32_t)previous + ((int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1U)));
+      values[n++] = previous;
+      continue;
+    }
+
+    /* Run: short form, or the count behind a 0 token */
+    run = token;
+    if ((run == 0U) && (getVarint(payload, header->length, &pos, &run) != 0))
+    {
+      return -1;
+    }
+    if ((run == 0U) || (run > (count - n)))
+    {
+      return -1;
+    }
+    while (run-- != 0U)
+    {
+      values[n++] = previous;
+    }
+  }
+
+  return (n == count) ? (int32_t)n : -1;
+}
+
+/**
+  * @brief  CRC-16/CCITT (polynomial 0x1021, MSB first)
+  * @param  crc: 0xFFFF to start, the previous result to continue
+  * @param  data: bytes to add
+  * @param  length: number of bytes
+  * @retval updated CRC
+  */
+uint16_t History_Crc16(uint16_t crc, const uint8_t *data, uint32_t length)
+{
+  uint32_t i;
+  uint32_t bit;
+
+  for (i = 0; i < length; i++)
+  {
+    crc ^= (uint16_t)((uint16_t)data[i] << 8);
+    for (bit = 0; bit < 8U; bit++)
+    {
+      crc = ((crc & 0x8000U) != 0U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+#ifndef BOOT_HOST
+#include "boot.h"
+
+/* Private variables ---------------------------------------------------------*/
+static History_Block ring[HISTORY_BLOCKS];
+static History_Encoder encoder;
+static uint32_t tailSeq;          /* oldest block */
+static uint32_t headSeq;          /* open block, or the next one to open */
+static uint8_t blockOpen;
+
+static struct
+{
+  uint8_t active;
+  uint8_t requester;
+  uint32_t seq;                   /* block being sent */
+  uint32_t lastSeq;
+  uint32_t offset;                /* next byte of that block */
+  uint32_t frame;                 /* data frames queued */
+  uint16_t crc;
+} transfer;
+
+History_Stats historyStats;
+
+/* Private functions ---------------------------------------------------------*/
+static History_Block *blockAt(uint32_t seq)
+{
+  return &ring[seq % HISTORY_BLOCKS];
+}
+
+static uint32_t blockBytes(uint32_t seq)
+{
+  return HISTORY_HEADER_SIZE + blockAt(seq)->header.length;
+}
+
+static void closeBlock(void)
+{
+  if (blockOpen)
+  {
+    blockOpen = 0;
+    headSeq++;
+    historyStats.blocks++;
+  }
+}
+
+static void sendResponse(uint8_t requester, const uint8_t *data)
+{
+  CAN_Frame response;
+  uint32_t i;
+
+  response.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, requester, BOOT_NODE_ADDRESS);
+  response.dlc = 8;
+  for (i = 0; i < 8U; i++)
+  {
+    response.data[i] = data[i];
+  }
+  (void)CAN_TransmitFrame(&response);
+}
+
+static void endTransfer(uint8_t status)
+{
+  uint8_t end[8] = { HISTORY_CMD_END | BOOT_RSP, status, (uint8_t)transfer.crc,
+                     (uint8_t)(transfer.crc >> 8), 0xFF, 0xFF, 0xFF, 0xFF };
+
+  sendResponse(transfer.requester, end);
+  transfer.active = 0;
+  if (status == HISTORY_ERR_OVERRUN)
+  {
+    historyStats.overruns++;
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Appends a sample taken now, opening a new block when needed
+  * @param  value: temperature, 0.01 K
+  * @retval None
+  */
+void History_Add(uint16_t value)
+{
+  uint32_t now = HAL_GetTick();
+
+  if (blockOpen && History_BlockAppend(&encoder, now, value))
+  {
+    historyStats.samples++;
+    return;
+  }
+
+  if (blockOpen && ((encoder.block->header.length + 3U) <= HISTORY_PAYLOAD_SIZE))
+  {
+    /* Room left for any token: the sample was off the interval */
+    historyStats.gaps++;
+  }
+  closeBlock();
+  /* Keep a block free: a request closes the open block and the next sample
+   * must not drop the oldest one while the transfer still has to send it */
+  while ((headSeq - tailSeq) >= (transfer.active ? HISTORY_BLOCKS : (HISTORY_BLOCKS - 1U)))
+  {
+    tailSeq++;
+    historyStats.dropped++;
+  }
+  History_BlockStart(&encoder, blockAt(headSeq), now, value);
+  blockOpen = 1;
+  historyStats.samples++;
+}
+
+/**
+  * @brief  Serves HIST_GET addressed to this node
+  * @param  frame: frame taken from the CAN RX queue
+  * @retval None
+  *
+  * The open block is closed first so that everything sent stays unchanged.
+  * A repeated request from the same node restarts its transfer.
+  */
+void History_HandleFrame(const CAN_Frame *frame)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  uint8_t requester = (uint8_t)BOOT_ID_SA(id);
+  uint64_t fromMs;
+  uint64_t toMs;
+  uint32_t nowS = HAL_GetTick() / 1000U;
+  uint32_t firstSeq = headSeq;
+  uint32_t blocks = 0;
+  uint32_t bytes = 0;
+  uint32_t seq;
+  uint8_t status = HISTORY_OK;
+
+  if (((frame->id & CAN_FRAME_EXT) == 0U) || (frame->dlc < 7U) ||
+      (BOOT_ID_PGN(id) != BOOT_PGN_CMD) || (BOOT_ID_DA(id) != BOOT_NODE_ADDRESS) ||
+      (frame->data[0] != HISTORY_CMD_GET))
+  {
+    return;
+  }
+
+  fromMs = (uint64_t)(frame->data[1] | ((uint32_t)frame->data[2] << 8) | ((uint32_t)frame->data[3] << 16)) * 1000U;
+  toMs = frame->data[4] | ((uint32_t)frame->data[5] << 8) | ((uint32_t)frame->data[6] << 16);
+  toMs = (toMs == HISTORY_TIME_NOW) ? UINT64_MAX : ((toMs * 1000U) + 999U);
+
+  if (transfer.active && (transfer.requester != requester))
+  {
+    status = HISTORY_ERR_BUSY;
+  }
+  else if (fromMs > toMs)
+  {
+    status = HISTORY_ERR_RANGE;
+  }
+  else
+  {
+    closeBlock();
+    /* Blocks are in time order; only headers are looked at */
+    for (seq = tailSeq; seq != headSeq; seq++)
+    {
+      const History_Header *header = &blockAt(seq)->header;
+      uint64_t endMs = (uint64_t)header->startMs + ((uint32_t)(header->count - 1U) * header->intervalMs);
+
+      if ((header->startMs <= toMs) && (endMs >= fromMs))
+      {
+        if (blocks++ == 0U)
+        {
+          firstSeq = seq;
+        }
+        bytes += blockBytes(seq);
+      }
+    }
+    transfer.active = 1;
+    transfer.requester = requester;
+    transfer.seq = firstSeq;
+    transfer.lastSeq = firstSeq + blocks;
+    transfer.offset = 0;
+    transfer.frame = 0;
+    transfer.crc = 0xFFFFU;
+    historyStats.requests++;
+  }
+
+  {
+    uint8_t rsp[8] = { HISTORY_CMD_GET | BOOT_RSP, status, (uint8_t)blocks, (uint8_t)bytes,
+                       (uint8_t)(bytes >> 8), (uint8_t)nowS, (uint8_t)(nowS >> 8), (uint8_t)(nowS >> 16) };
+
+    sendResponse(requester, rsp);
+  }
+}
+
+/**
+  * @brief  Queues the next burst of a running transfer once the previous
+  *         one has left the mailboxes
+  * @retval 1 while a transfer is running
+  *
+  * bxCAN sends equal identifiers lowest mailbox first, so a frame can wait
+  * in a mailbox while later ones pass it; bursts bound that to the burst
+  * length. HISTORY_TX_RESERVE queue entries stay free for the periodic
+  * messages.
+  */
+uint8_t History_Poll(void)
+{
+  uint32_t burst = CAN_TX_QUEUE_LEN - HISTORY_TX_RESERVE;
+
+  if ((CAN_TxQueueFree() != CAN_TX_QUEUE_LEN) || (HAL_CAN_GetTxMailboxesFreeLevel(&hcan) != 3U))
+  {
+    return transfer.active;
+  }
+
+  while (transfer.active && (burst-- != 0U))
+  {
+    CAN_Frame data;
+    uint32_t used = 0;
+    uint32_t i;
+
+    if (transfer.seq == transfer.lastSeq)
+    {
+      endTransfer(HISTORY_OK);
+      break;
+    }
+    if ((int32_t)(transfer.seq - tailSeq) < 0)
+    {
+      endTransfer(HISTORY_ERR_OVERRUN);
+      break;
+    }
+
+    data.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_DATA, BOOT_PGN_DATA, transfer.requester, BOOT_NODE_ADDRESS);
+    data.dlc = 8;
+    data.data[0] = (uint8_t)transfer.frame++;
+    for (i = 1; i < 8U; i++)
+    {
+      if (transfer.seq == transfer.lastSeq)
+      {
+        data.data[i] = 0xFF;
+        continue;
+      }
+      data.data[i] = ((const uint8_t *)blockAt(transfer.seq))[transfer.offset];
+      used++;
+      if (++transfer.offset == blockBytes(transfer.seq))
+      {
+        transfer.seq++;
+        transfer.offset = 0;
+      }
+    }
+    transfer.crc = History_Crc16(transfer.crc, &data.data[1], used);
+    (void)CAN_TransmitFrame(&data);
+    historyStats.frames++;
+  }
+
+  return transfer.active;
+}
+
+/**
+  * @brief  Ring occupancy, for reports
+  * @param  samples: samples held, or NULL
+  * @param  spanMs: time from the oldest to the newest sample, or NULL
+  * @retval bytes of header and payload held
+  */
+uint32_t History_Used(uint32_t *samples, uint32_t *spanMs)
+{
+  uint32_t end = headSeq + (blockOpen ? 1U : 0U);
+  uint32_t bytes = 0;
+  uint32_t count = 0;
+  uint32_t seq;
+
+  for (seq = tailSeq; seq != end; seq++)
+  {
+    bytes += blockBytes(seq);
+    count += blockAt(seq)->header.count;
+  }
+  if (samples != NULL)
+  {
+    *samples = count;
+  }
+  if (spanMs != NULL)
+  {
+    const History_Header *newest = &blockAt(end - 1U)->header;
+
+    *spanMs = (end == tailSeq) ? 0U :
+              (newest->startMs + ((uint32_t)(newest->count - 1U) * newest->intervalMs) - blockAt(tailSeq)->header.startMs);
+  }
+  return bytes;
+}
+#endif /* BOOT_HOST */
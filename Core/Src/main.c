@@ -26,6 +26,22 @@
 #include <stdio.h>
 #include "adc.h"
 #include "temperature.h"
+#include "trace.h"
+#include "boot.h"
+#include "params.h"
+#include "scheduler.h"
+#include "history.h"
+#include "nmea.h"
+#include "watchdog.h"
+#include "crash.h"
+#include "ram.h"
+#include "slcan.h"
+#include "stress.h"
+#include "monitor.h"
+#include "status.h"
+#include "cpu.h"
+#include "alarm.h"
+#include "trend.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -47,24 +63,175 @@
 
 /* USER CODE BEGIN PV */
 CAN_RxHeaderTypeDef rxHeader; // CAN Bus Receive Header
-CAN_TxHeaderTypeDef txHeaderA1; // CAN Bus Transmit Header for A1 (DEADBEEF)
+CAN_TxHeaderTypeDef txHeaderA1; // CAN Bus Transmit Header for A1 (status pages)
 CAN_TxHeaderTypeDef txHeaderT1; // CAN Bus Transmit Header for T1 (Temperature NMEA 2000)
-uint32_t canMailbox; // CAN Bus Mail box variable
 CAN_FilterTypeDef canfil; // CAN Bus Filter
-uint32_t a1Counter = 0; // Counter for A1 transmission (30 Hz = every 3-4 cycles)
-uint32_t t1Counter = 0; // Counter for T1 transmission (1 Hz = every 30 cycles)
+uint32_t a1Counter = 0; // Number of A1 transmissions
 uint8_t nmea2000_sid = 0; // NMEA 2000 Sequence ID
+uint8_t taskA1; // Scheduler handles, periods follow the parameters
+uint8_t taskT1;
+uint8_t taskHeartbeat;
+uint8_t taskDiag;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
-
+#if SLCAN_ENABLE
+static void Task_Slcan(void);
+#else
+static void Task_A1(void);
+static void Task_T1(void);
+static void Task_Heartbeat(void);
+static void Task_Diag(void);
+static void Task_Service(void);
+#endif
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+#if SLCAN_ENABLE
+
+/**
+  * @brief  SLCAN task, runs after every wake-up: host commands, received
+  *         frames out on USART3 (slcan.h), a step of the stack scan
+  * @retval None
+  */
+static void Task_Slcan(void)
+{
+  if (Slcan_Poll() != 0U)
+  {
+    Scheduler_KeepAwake();
+  }
+  Ram_Scan();
+}
+
+#else
+
+/**
+  * @brief  A1 task: heartbeat LED and A1 message (status pages, status.h) at
+  *         30 Hz, the message left out while the bus-stress generator runs
+  *         or the controller is silent (monitor.h)
+  * @retval None
+  */
+static void Task_A1(void)
+{
+  uint8_t a1Data[8];
 
+  (void) HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_2);
+  Status_Tick();
+  if ((Stress_Running() == 0U) && (CAN_Silent() == 0U))
+  {
+    a1Counter++;
+    Status_Next(a1Data);
+    CAN_Transmit(&txHeaderA1, a1Data);
+  }
+}
+
+/**
+  * @brief  T1 task: temperature message (NMEA 2000 PGN 130312) at 1 Hz
+  * @retval None
+  */
+static void Task_T1(void)
+{
+  // Read temperature sensor
+  float tempCelsius = Temperature_GetCelsius();
+
+  // NMEA 2000 PGN 130312 - Temperature format
+  // Temperature in Kelvin with 0.01K resolution: temp_value = (Celsius + 273.15) * 100
+  // plus the calibration offset PARAM_TEMP_OFFSET (0.01K, signed)
+  uint16_t tempKelvin = (uint16_t)((tempCelsius + 273.15f) * 100.0f + (float)(int32_t)Params_Get(PARAM_TEMP_OFFSET));
+
+  uint8_t t1Data[8];
+  t1Data[0] = nmea2000_sid++;              // SID (Sequence ID) - increment each message
+  t1Data[1] = (uint8_t)Params_Get(PARAM_TEMP_INSTANCE); // Temperature Instance (default 0 = single sensor)
+  t1Data[2] = (uint8_t)Params_Get(PARAM_TEMP_SOURCE);   // Temperature Source (default 1 = Inside Temperature)
+  t1Data[3] = (uint8_t)(tempKelvin & 0xFF); // Temperature low byte
+  t1Data[4] = (uint8_t)(tempKelvin >> 8);   // Temperature high byte
+  t1Data[5] = 0xFF;                         // Reserved
+  t1Data[6] = 0xFF;                         // Reserved
+  t1Data[7] = 0xFF;                         // Reserved
+
+  // Send NMEA 2000 temperature message
+  txHeaderT1.ExtId = (txHeaderT1.ExtId & ~0xFFUL) | (Params_Get(PARAM_SOURCE_ADDRESS) & 0xFFUL);
+  CAN_Transmit(&txHeaderT1, t1Data);
+
+  // Keep the same value for late joiners (HIST_GET)
+  History_Add(tempKelvin);
+
+  // and fit it into the trend, PGN 65283 right behind
+  Trend_Update(tempKelvin, t1Data[0]);
+}
+
+/**
+  * @brief  Heartbeat task: NMEA 2000 PGN 126993 every PARAM_HEARTBEAT_MS
+  * @retval None
+  */
+static void Task_Heartbeat(void)
+{
+  Nmea_SendHeartbeat();
+}
+
+/**
+  * @brief  Diagnostics task: stack and heap high-water marks (PGN 65284)
+  *         and CPU load (PGN 65281) every PARAM_DIAG_MS
+  * @retval None
+  */
+static void Task_Diag(void)
+{
+  Ram_SendDiag();
+  Cpu_SendDiag();
+}
+
+/**
+  * @brief  Service task, runs after every wake-up: received frames,
+  *         parameter writes, period and alarm threshold changes, history
+  *         and Product Information transfers, a step of the stack scan
+  * @retval None
+  */
+static void Task_Service(void)
+{
+  CAN_Frame rxFrame;
+
+  // Drain received frames: bootloader ENTER, parameter, history, reset
+  // cause, crash report, bus-stress and monitor commands, ISO requests
+  while (CAN_Receive(&rxFrame))
+  {
+    Boot_HandleFrame(&rxFrame);
+    Params_HandleFrame(&rxFrame);
+    History_HandleFrame(&rxFrame);
+    Nmea_HandleFrame(&rxFrame);
+    Watchdog_HandleFrame(&rxFrame);
+    Crash_HandleFrame(&rxFrame);
+    Stress_HandleFrame(&rxFrame);
+    Monitor_HandleFrame(&rxFrame);
+  }
+
+  // Refill the TX queue with history frames, then crash report frames, then
+  // bus monitor reports; no Stop mode until sent or while a window runs
+  if ((History_Poll() != 0U) || (Crash_Poll() != 0U) || (Monitor_Poll() != 0U))
+  {
+    Scheduler_KeepAwake();
+  }
+  // Product Information goes out a frame per wake-up, same rule
+  if (Nmea_Poll() != 0U)
+  {
+    Scheduler_KeepAwake();
+  }
+
+  // Periods may have changed; write pending parameters a record at a time
+  Scheduler_SetPeriod(taskA1, Params_Get(PARAM_A1_PERIOD_MS));
+  Scheduler_SetPeriod(taskT1, Params_Get(PARAM_T1_PERIOD_MS));
+  Scheduler_SetPeriod(taskHeartbeat, Params_Get(PARAM_HEARTBEAT_MS));
+  Scheduler_SetPeriod(taskDiag, Params_Get(PARAM_DIAG_MS));
+  Alarm_Poll(); // and the alarm window with its thresholds
+  Params_Poll();
+
+  // Stack high-water mark, RAM_SCAN_WORDS words at a time
+  Ram_Scan();
+}
+
+#endif /* SLCAN_ENABLE */
 /* USER CODE END 0 */
 
 /**
@@ -91,7 +258,9 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-
+  Trace_Init();
+  Cpu_Init(); // CPU time accounting from here on
+  Watchdog_Init(); // Reset cause, then the IWDG covers the rest of the start-up
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
@@ -99,10 +268,12 @@ int main(void)
   MX_CAN_Init();
   MX_ADC1_Init();
   /* USER CODE BEGIN 2 */
+  Params_Init(); // Persistent configuration, before anything uses it
   HAL_CAN_ConfigFilter(&hcan, &canfil); // Initialize CAN Filter
   HAL_CAN_Start(&hcan);//
+  CAN_StartQueues(); // Interrupt-driven RX/TX queues
   
-  /* Setup A1 CAN message header (DEADBEEF pattern) */
+  /* Setup A1 CAN message header (status pages) */
   txHeaderA1.DLC = 8;
   txHeaderA1.IDE = CAN_ID_STD;
   txHeaderA1.RTR = CAN_RTR_DATA;
@@ -113,54 +284,41 @@ int main(void)
   txHeaderT1.DLC = 8;
   txHeaderT1.IDE = CAN_ID_EXT; // NMEA 2000 uses extended CAN ID
   txHeaderT1.RTR = CAN_RTR_DATA;
-  // NMEA 2000 format: Priority=6, PGN=130312 (0x1FD08), Source=0x01
-  // 29-bit ID = (Priority << 26) | (PGN << 8) | Source
-  txHeaderT1.ExtId = (6UL << 26) | (130312UL << 8) | 0x01; // 0x19FD0801
+  // NMEA 2000 format: Priority=6, PGN=130312 (0x1FD08), Source=PARAM_SOURCE_ADDRESS
+  // 29-bit ID = (Priority << 26) | (PGN << 8) | Source, the source is filled in per message
+  txHeaderT1.ExtId = (6UL << 26) | (130312UL << 8) | 0x01; // 0x19FD0801 with the default source
   txHeaderT1.TransmitGlobalTime = DISABLE;
   
   /* Calibrate ADC */
   HAL_ADCEx_Calibration_Start(&hadc1, ADC_SINGLE_ENDED);
+#if !SLCAN_ENABLE
+  Alarm_Init(); // Temperature alarms on the analog watchdog
+#endif
+
+  /* Periodic tasks; the scheduler sleeps in between (SCHEDULER_IDLE_MODE) */
+  Scheduler_Init();
+#if SLCAN_ENABLE
+  /* Serial CAN adapter instead of the sensor node */
+  Slcan_Init();
+  (void)Scheduler_Add(Task_Slcan, 0, SCHEDULER_NO_TRACE);
+#else
+  taskA1 = Scheduler_Add(Task_A1, Params_Get(PARAM_A1_PERIOD_MS), TRACE_TASK_A1);
+  taskT1 = Scheduler_Add(Task_T1, Params_Get(PARAM_T1_PERIOD_MS), TRACE_TASK_T1);
+  taskHeartbeat = Scheduler_Add(Task_Heartbeat, Params_Get(PARAM_HEARTBEAT_MS), SCHEDULER_NO_TRACE);
+  taskDiag = Scheduler_Add(Task_Diag, Params_Get(PARAM_DIAG_MS), SCHEDULER_NO_TRACE);
+  (void)Scheduler_Add(Task_Service, 0, SCHEDULER_NO_TRACE);
+  Nmea_SendProductInfo(); // Announce the node once after reset
+  Watchdog_Report(0xFF); // and why it was reset
+  Crash_Init(); // and what crashed, if that was the reason
+#endif
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-   // Main loop runs every ~33ms for 30Hz A1 transmission
-   HAL_Delay(33U);
-   (void) HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_2);
-
-   // Send A1 message (DEADBEEF) at 30 Hz
-   a1Counter++;
-   uint8_t a1Data[8] = {0xDE, 0xAD, 0xBE, 0xEF, 0x00, 0x00, 0x00, 0x00};
-   HAL_CAN_AddTxMessage(&hcan, &txHeaderA1, a1Data, &canMailbox);
-
-   // Send T1 message (Temperature NMEA 2000 PGN 130312) at 1 Hz
-   t1Counter++;
-   if (t1Counter >= 30) // 30 cycles * 33ms ≈ 1 second
-   {
-     t1Counter = 0;
-     
-     // Read temperature sensor
-     float tempCelsius = Temperature_GetCelsius();
-     
-     // NMEA 2000 PGN 130312 - Temperature format
-     // Temperature in Kelvin with 0.01K resolution: temp_value = (Celsius + 273.15) * 100
-     uint16_t tempKelvin = (uint16_t)((tempCelsius + 273.15f) * 100.0f);
-     
-     uint8_t t1Data[8];
-     t1Data[0] = nmea2000_sid++;              // SID (Sequence ID) - increment each message
-     t1Data[1] = 0;                            // Temperature Instance (0 = single sensor)
-     t1Data[2] = 1;                            // Temperature Source (1 = Inside Temperature)
-     t1Data[3] = (uint8_t)(tempKelvin & 0xFF); // Temperature low byte
-     t1Data[4] = (uint8_t)(tempKelvin >> 8);   // Temperature high byte
-     t1Data[5] = 0xFF;                         // Reserved
-     t1Data[6] = 0xFF;                         // Reserved
-     t1Data[7] = 0xFF;                         // Reserved
-     
-     // Send NMEA 2000 temperature message
-     HAL_CAN_AddTxMessage(&hcan, &txHeaderT1, t1Data, &canMailbox);
-   }
+   // Run due tasks, then idle until the next deadline or CAN frame
+   Scheduler_Poll();
 
     /* USER CODE END WHILE */
 
@@ -220,10 +378,7 @@ void Error_Handler(void)
 {
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
-  __disable_irq();
-  while (1)
-  {
-  }
+  Crash_Error((uint32_t)(uintptr_t)__builtin_return_address(0)); // Saves a crash report and resets
   /* USER CODE END Error_Handler_Debug */
 }
 #ifdef USE_FULL_ASSERT
@@ -0,0 +1,535 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : monitor.c
+  * @brief          : Bus monitor: per-identifier traffic statistics (see monitor.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Monitor_Update() runs in the CAN RX interrupt for every frame: one
+  * multiplicative hash and at most MONITOR_PROBES slot compares, so its time
+  * is bounded whatever the traffic. Reports are built in the service task
+  * while frames are still counted; a running window's counters may be a
+  * frame apart from each other.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "monitor.h"
+
+/* Private define ------------------------------------------------------------*/
+/* CAN_RIxR fields, also for the host tools */
+#define RIR_RTR                 0x00000002UL
+#define RIR_IDE                 0x00000004UL
+#define RIR_EXID_POS            3U
+#define RIR_STID_POS            21U
+
+#define HASH_MULTIPLIER         0x9E3779B1UL    /* 2^32 / golden ratio */
+
+#ifdef BOOT_HOST
+#define CCMRAM_FUNC
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t homeSlot(uint32_t key)
+{
+  return ((key ^ (key >> 16)) * HASH_MULTIPLIER) >> (32U - MONITOR_SLOT_BITS);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Empties the table and clears the window counters
+  * @param  table: table to clear
+  * @retval None
+  */
+void Monitor_Clear(Monitor_Table *table)
+{
+  uint32_t *word = (uint32_t *)table;
+  uint32_t i;
+
+  for (i = 0; i < (sizeof(*table) / 4U); i++)
+  {
+    word[i] = 0;
+  }
+}
+
+/**
+  * @brief  Counts one frame
+  * @param  table: table of the window
+  * @param  key: Monitor_Key() of the identifier, or CAN_RIxR | MONITOR_KEY_USED
+  * @param  dlc: data length code, 0..15
+  * @param  nowUs: microseconds, free running
+  * @retval None
+  */
+CCMRAM_FUNC void Monitor_Update(Monitor_Table *table, uint32_t key, uint32_t dlc, uint32_t nowUs)
+{
+  uint32_t home = homeSlot(key);
+  uint32_t probe;
+
+  table->frames++;
+  for (probe = 0; probe < MONITOR_PROBES; probe++)
+  {
+    Monitor_Entry *entry = &table->slots[(home + probe) & (MONITOR_SLOTS - 1U)];
+
+    if (entry->key == 0U)
+    {
+      entry->key = key;
+      entry->minGapUs = UINT32_MAX;
+      entry->probes = (uint16_t)probe;
+      table->ids++;
+      if (probe > table->maxProbes)
+      {
+        table->maxProbes = (uint16_t)probe;
+      }
+    }
+    else if (entry->key != key)
+    {
+      continue;
+    }
+    else
+    {
+      uint32_t gap = nowUs - entry->lastUs;
+
+      entry->minGapUs = (gap < entry->minGapUs) ? gap : entry->minGapUs;
+      entry->maxGapUs = (gap > entry->maxGapUs) ? gap : entry->maxGapUs;
+    }
+    entry->count++;
+    entry->lastUs = nowUs;
+    entry->dlcMask |= (uint16_t)(1UL << (dlc & 0x0FU));
+    return;
+  }
+  table->overflow++;
+}
+
+/**
+  * @brief  Busiest identifiers, most frames first, the lower identifier
+  *         first on equal counts
+  * @param  table: table of the window
+  * @param  out: n records
+  * @param  n: records wanted
+  * @retval records written, fewer when the table holds fewer identifiers
+  */
+uint32_t Monitor_Top(const Monitor_Table *table, Monitor_Talker *out, uint32_t n)
+{
+  uint64_t taken = 0;             /* one bit per slot, MONITOR_SLOTS <= 64 */
+  uint32_t written;
+
+  for (written = 0; written < n; written++)
+  {
+    const Monitor_Entry *best = NULL;
+    uint32_t bestSlot = 0;
+    uint32_t slot;
+
+    for (slot = 0; slot < MONITOR_SLOTS; slot++)
+    {
+      const Monitor_Entry *entry = &table->slots[slot];
+
+      if ((entry->key == 0U) || ((taken & (1ULL << slot)) != 0U))
+      {
+        continue;
+      }
+      if ((best == NULL) || (entry->count > best->count) ||
+          ((entry->count == best->count) && (Monitor_Id(entry->key) < Monitor_Id(best->key))))
+      {
+        best = entry;
+        bestSlot = slot;
+      }
+    }
+    if (best == NULL)
+    {
+      break;
+    }
+    taken |= 1ULL << bestSlot;
+    out[written].id = Monitor_Id(best->key);
+    out[written].count = best->count;
+    out[written].minGapUs = best->minGapUs;
+    out[written].maxGapUs = best->maxGapUs;
+    out[written].dlcMask = best->dlcMask;
+    out[written].probes = best->probes;
+  }
+  return written;
+}
+
+/**
+  * @brief  Table key of an identifier
+  * @param  id: identifier | CAN_FRAME_EXT | CAN_FRAME_RTR
+  * @retval CAN_RIxR of a frame with that identifier | MONITOR_KEY_USED
+  */
+uint32_t Monitor_Key(uint32_t id)
+{
+  uint32_t key = MONITOR_KEY_USED;
+
+  if ((id & CAN_FRAME_EXT) != 0U)
+  {
+    key |= ((id & CAN_FRAME_ID_MASK) << RIR_EXID_POS) | RIR_IDE;
+  }
+  else
+  {
+    key |= (id & 0x7FFU) << RIR_STID_POS;
+  }
+  if ((id & CAN_FRAME_RTR) != 0U)
+  {
+    key |= RIR_RTR;
+  }
+  return key;
+}
+
+/**
+  * @brief  Identifier of a table key, the inverse of Monitor_Key()
+  * @param  key: table key
+  * @retval identifier | CAN_FRAME_EXT | CAN_FRAME_RTR
+  */
+uint32_t Monitor_Id(uint32_t key)
+{
+  uint32_t id;
+
+  if ((key & RIR_IDE) != 0U)
+  {
+    id = ((key >> RIR_EXID_POS) & CAN_FRAME_ID_MASK) | CAN_FRAME_EXT;
+  }
+  else
+  {
+    id = key >> RIR_STID_POS;
+  }
+  if ((key & RIR_RTR) != 0U)
+  {
+    id |= CAN_FRAME_RTR;
+  }
+  return id;
+}
+
+#ifndef BOOT_HOST
+#include "boot.h"
+#include "history.h"
+#include "scheduler.h"
+#include "stress.h"
+
+/* Private define ------------------------------------------------------------*/
+#define MONITOR_ERROR_IRQS      (CAN_IER_ERRIE | CAN_IER_LECIE | CAN_IER_BOFIE)
+
+/* Private variables ---------------------------------------------------------*/
+static Monitor_Table table;
+static volatile uint8_t counting;
+static uint8_t busOffSeen;
+
+static struct
+{
+  uint8_t flags;                  /* MONITOR_START flags */
+  uint8_t top;                    /* talkers in a report at the end */
+  uint8_t requester;
+  uint32_t periodMs;              /* 0 = until MONITOR_STOP */
+  uint32_t startTick;
+  uint32_t endTick;
+} window;
+
+static uint32_t report[MONITOR_REPORT_MAX / 4U];
+
+static struct
+{
+  uint8_t active;
+  uint8_t requester;
+  uint32_t bytes;
+  uint32_t offset;                /* next byte of the report */
+  uint32_t frame;                 /* data frames queued */
+} transfer;
+
+Monitor_Stats monitorStats;
+
+/* Private functions ---------------------------------------------------------*/
+static void sendResponse(uint8_t requester, const uint8_t *data)
+{
+  CAN_Frame response;
+  uint32_t i;
+
+  response.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, requester, BOOT_NODE_ADDRESS);
+  response.dlc = 8;
+  for (i = 0; i < 8U; i++)
+  {
+    response.data[i] = data[i];
+  }
+  (void)CAN_TransmitFrame(&response);
+}
+
+static void startWindow(void)
+{
+  counting = 0;
+  Monitor_Clear(&table);
+  busOffSeen = ((hcan.Instance->ESR & CAN_ESR_BOFF) != 0U) ? 1U : 0U;
+  hcan.Instance->ESR = CAN_ESR_LEC;       /* 7: set by software, no error since */
+  hcan.Instance->IER |= MONITOR_ERROR_IRQS;
+  window.startTick = HAL_GetTick();
+  monitorStats.windows++;
+  counting = 1;
+}
+
+static void endWindow(void)
+{
+  if (!counting)
+  {
+    return;
+  }
+  counting = 0;
+  window.endTick = HAL_GetTick();
+  hcan.Instance->IER &= ~MONITOR_ERROR_IRQS;
+  if (CAN_Silent())
+  {
+    CAN_SetSilent(0);
+  }
+}
+
+/* Builds the report of the current or last window, returns its length */
+static uint32_t snapshot(uint32_t top)
+{
+  Monitor_Header *header = (Monitor_Header *)report;
+  uint32_t i;
+
+  header->windowMs = (counting ? HAL_GetTick() : window.endTick) - window.startTick;
+  header->frames = table.frames;
+  header->overflow = table.overflow;
+  header->ids = table.ids;
+  header->flags = (uint8_t)(window.flags | (counting ? MONITOR_RUNNING : 0U));
+  for (i = 0; i < MONITOR_ERRORS; i++)
+  {
+    header->errors[i] = table.errors[i];
+  }
+  header->tecPeak = table.tecPeak;
+  header->recPeak = table.recPeak;
+  header->busOff = table.busOff;
+  header->talkers = (uint8_t)Monitor_Top(&table, (Monitor_Talker *)&header[1], top);
+
+  return sizeof(*header) + (header->talkers * sizeof(Monitor_Talker));
+}
+
+static void sendReport(uint8_t requester, uint32_t top)
+{
+  uint8_t rsp[8] = { MONITOR_CMD_GET | BOOT_RSP, BOOT_OK, 0, 0, 0, 0, 0, 0xFF };
+
+  if (monitorStats.windows == 0U)
+  {
+    rsp[1] = BOOT_ERR_STATE;
+  }
+  else if (transfer.active && (transfer.requester != requester))
+  {
+    rsp[1] = BOOT_ERR_BUSY;
+  }
+  else
+  {
+    uint16_t crc;
+
+    if ((window.flags & MONITOR_SILENT) != 0U)
+    {
+      endWindow();
+    }
+    transfer.bytes = snapshot(top);
+    crc = History_Crc16(0xFFFFU, (const uint8_t *)report, transfer.bytes);
+    transfer.active = 1;
+    transfer.requester = requester;
+    transfer.offset = 0;
+    transfer.frame = 0;
+    monitorStats.reports++;
+
+    rsp[2] = ((const Monitor_Header *)report)->talkers;
+    rsp[3] = (uint8_t)transfer.bytes;
+    rsp[4] = (uint8_t)(transfer.bytes >> 8);
+    rsp[5] = (uint8_t)crc;
+    rsp[6] = (uint8_t)(crc >> 8);
+  }
+  sendResponse(requester, rsp);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Counts a frame read from FIFO0; called by the CAN RX interrupt
+  *         before the frame is released
+  * @param  rir: CAN_RI0R of the frame
+  * @param  rdtr: CAN_RDT0R of the frame
+  * @retval None
+  */
+CCMRAM_FUNC void Monitor_Frame(uint32_t rir, uint32_t rdtr)
+{
+  if (counting)
+  {
+    Monitor_Update(&table, rir | MONITOR_KEY_USED, rdtr & CAN_RDT0R_DLC, Scheduler_Micros());
+  }
+}
+
+/**
+  * @brief  CAN status change and error interrupt body: counts the last error
+  *         code and bus-off entries and records the error counter peaks
+  * @retval None
+  */
+void Monitor_Error_IRQ(void)
+{
+  CAN_TypeDef *can = hcan.Instance;
+  uint32_t esr = can->ESR;
+  uint32_t lec = (esr & CAN_ESR_LEC) >> CAN_ESR_LEC_Pos;
+  uint8_t tec = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+  uint8_t rec = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+  uint8_t busOff = ((esr & CAN_ESR_BOFF) != 0U) ? 1U : 0U;
+
+  can->MSR = CAN_MSR_ERRI;
+  if ((lec >= 1U) && (lec <= MONITOR_ERRORS))
+  {
+    can->ESR = CAN_ESR_LEC;
+    if (counting && (table.errors[lec - 1U] != UINT16_MAX))
+    {
+      table.errors[lec - 1U]++;
+    }
+  }
+  if (counting)
+  {
+    table.tecPeak = (tec > table.tecPeak) ? tec : table.tecPeak;
+    table.recPeak = (rec > table.recPeak) ? rec : table.recPeak;
+    if (busOff && !busOffSeen)
+    {
+      table.busOff++;
+    }
+  }
+  busOffSeen = busOff;
+}
+
+/**
+  * @brief  Serves MONITOR_START, MONITOR_STOP and MONITOR_GET addressed to
+  *         this node
+  * @param  frame: frame taken from the CAN RX queue
+  * @retval None
+  */
+void Monitor_HandleFrame(const CAN_Frame *frame)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  uint8_t requester = (uint8_t)BOOT_ID_SA(id);
+  uint8_t command = frame->data[0];
+  uint8_t rsp[8] = { command | BOOT_RSP, BOOT_OK, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+  if (((frame->id & CAN_FRAME_EXT) == 0U) || (frame->dlc < 1U) ||
+      (BOOT_ID_PGN(id) != BOOT_PGN_CMD) || (BOOT_ID_DA(id) != BOOT_NODE_ADDRESS) ||
+      (command < MONITOR_CMD_START) || (command > MONITOR_CMD_GET))
+  {
+    return;
+  }
+
+  if (command == MONITOR_CMD_GET)
+  {
+    uint32_t top = ((frame->dlc >= 2U) && (frame->data[1] != 0U)) ? frame->data[1] : window.top;
+
+    if (top > MONITOR_TOP_MAX)
+    {
+      rsp[1] = BOOT_ERR_RANGE;
+      rsp[2] = 0;
+      sendResponse(requester, rsp);
+      return;
+    }
+    sendReport(requester, (top != 0U) ? top : MONITOR_TOP_DEFAULT);
+    return;
+  }
+
+  if (command == MONITOR_CMD_START)
+  {
+    uint8_t flags = frame->data[1];
+    uint32_t seconds = frame->data[2] | ((uint32_t)frame->data[3] << 8);
+
+    if ((frame->dlc < 5U) || ((flags & (uint8_t)~(MONITOR_SILENT | MONITOR_REPEAT)) != 0U) ||
+        (frame->data[4] > MONITOR_TOP_MAX) || (((flags & MONITOR_REPEAT) != 0U) && (seconds == 0U)))
+    {
+      rsp[1] = BOOT_ERR_RANGE;
+    }
+    else if (((flags & MONITOR_SILENT) != 0U) && Stress_Running())
+    {
+      rsp[1] = BOOT_ERR_STATE;
+    }
+    else
+    {
+      endWindow();
+      window.flags = flags;
+      window.top = (frame->data[4] != 0U) ? frame->data[4] : MONITOR_TOP_DEFAULT;
+      window.requester = requester;
+      window.periodMs = seconds * 1000U;
+      startWindow();
+    }
+  }
+  else
+  {
+    endWindow();
+  }
+  sendResponse(requester, rsp);
+}
+
+/**
+  * @brief  Ends a window on time, switches to silent mode once the node's
+  *         frames are out and queues the next burst of a report transfer, as
+  *         Crash_Poll()
+  * @retval 1 while a window or a transfer runs
+  */
+uint8_t Monitor_Poll(void)
+{
+  uint32_t burst = CAN_TX_QUEUE_LEN - HISTORY_TX_RESERVE;
+  uint8_t idle = (CAN_TxQueueFree() == CAN_TX_QUEUE_LEN) && (HAL_CAN_GetTxMailboxesFreeLevel(&hcan) == 3U);
+
+  if (counting && (window.periodMs != 0U) && ((HAL_GetTick() - window.startTick) >= window.periodMs))
+  {
+    uint8_t repeat = ((window.flags & MONITOR_REPEAT) != 0U) ? 1U : 0U;
+
+    endWindow();
+    sendReport(window.requester, window.top);
+    if (repeat)
+    {
+      startWindow();
+    }
+    return 1;
+  }
+
+  if (counting && ((window.flags & MONITOR_SILENT) != 0U) && !CAN_Silent() && !transfer.active && idle)
+  {
+    CAN_SetSilent(1);
+  }
+
+  if (!transfer.active || !idle)
+  {
+    return (counting || transfer.active) ? 1U : 0U;
+  }
+
+  while (transfer.active && (burst-- != 0U))
+  {
+    CAN_Frame data;
+    uint32_t i;
+
+    data.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_DATA, BOOT_PGN_DATA, transfer.requester, BOOT_NODE_ADDRESS);
+    data.dlc = 8;
+    data.data[0] = (uint8_t)transfer.frame++;
+    for (i = 1; i < 8U; i++)
+    {
+      data.data[i] = (transfer.offset < transfer.bytes) ? ((const uint8_t *)report)[transfer.offset++] : 0xFFU;
+    }
+    (void)CAN_TransmitFrame(&data);
+    monitorStats.frames++;
+
+    if (transfer.offset == transfer.bytes)
+    {
+      transfer.active = 0;
+    }
+  }
+
+  return (counting || transfer.active) ? 1U : 0U;
+}
+
+/**
+  * @brief  Tells whether a silent window runs, for the bus-stress generator
+  * @retval 1 while a MONITOR_SILENT window runs
+  */
+uint8_t Monitor_Silent(void)
+{
+  return (counting && ((window.flags & MONITOR_SILENT) != 0U)) ? 1U : 0U;
+}
+#endif
@@ -0,0 +1,316 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : nmea.c
+  * @brief          : NMEA 2000 Heartbeat and Product Information (format in
+  *                   nmea.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The Product Information frames take NMEA_PRODUCT_FRAMES * 8 bytes of RAM
+  * once built; the payload is assembled on the stack and dropped. The flash
+  * map has no spare page to cache them in, and building them costs less
+  * than one T1 conversion.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "nmea.h"
+#include "boot.h"
+#include "params.h"
+#include "ram.h"
+#include "cpu.h"
+#include "alarm.h"
+#include "trend.h"
+
+/* Private define ------------------------------------------------------------*/
+#define NMEA_ID(prio, pgn, src) \
+  (CAN_FRAME_EXT | ((uint32_t)(prio) << 26) | ((uint32_t)(pgn) << 8) | (uint32_t)(src))
+
+#define ISO_ACK_NAK             1U
+
+/* Private variables ---------------------------------------------------------*/
+Nmea_Stats nmeaStats;
+
+static uint8_t heartbeatSequence;
+static uint32_t lostAtHeartbeat;
+
+/* Fast-packet frames with the sequence bits clear */
+static uint8_t productFrames[NMEA_PRODUCT_FRAMES][8];
+static uint8_t productBuilt;
+static uint8_t productActive;
+static uint8_t productNext;
+static uint8_t productSequence;
+
+/* Private functions ---------------------------------------------------------*/
+static uint8_t *putLe16(uint8_t *p, uint16_t value)
+{
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)(value >> 8);
+  return p + 2;
+}
+
+/* Fixed-length string field, 0xFF after the text */
+static uint8_t *putText(uint8_t *p, const char *text)
+{
+  uint32_t i;
+
+  for (i = 0; i < NMEA_STRING_SIZE; i++)
+  {
+    p[i] = (*text != '\0') ? (uint8_t)*text++ : 0xFFU;
+  }
+  return p + NMEA_STRING_SIZE;
+}
+
+static char *putHex(char *p, uint32_t value, uint32_t digits)
+{
+  static const char hex[] = "0123456789ABCDEF";
+
+  while (digits-- != 0U)
+  {
+    *p++ = hex[(value >> (digits * 4U)) & 0xFU];
+  }
+  return p;
+}
+
+static void buildProductInfo(void)
+{
+  static const char modelVersion[] = "STM32F334C8T6 rev ";
+  uint8_t payload[NMEA_PRODUCT_INFO_SIZE];
+  char text[NMEA_STRING_SIZE + 1U];
+  uint8_t *p = payload;
+  char *t;
+  uint32_t frame;
+  uint32_t offset;
+  uint32_t i;
+
+  p = putLe16(p, NMEA_DATABASE_VERSION);
+  p = putLe16(p, NMEA_PRODUCT_CODE);
+  p = putText(p, NMEA_MODEL_ID);
+  p = putText(p, NMEA_SOFTWARE_VERSION);
+
+  for (i = 0, t = text; modelVersion[i] != '\0'; i++)
+  {
+    *t++ = modelVersion[i];
+  }
+  t = putHex(t, HAL_GetREVID(), 4);
+  *t = '\0';
+  p = putText(p, text);
+
+  /* Most significant word first, as ST prints the unique ID */
+  t = putHex(text, HAL_GetUIDw2(), 8);
+  t = putHex(t, HAL_GetUIDw1(), 8);
+  t = putHex(t, HAL_GetUIDw0(), 8);
+  *t = '\0';
+  p = putText(p, text);
+
+  *p++ = NMEA_CERTIFICATION;
+  *p = NMEA_LOAD_EQUIVALENCY;
+
+  /* Frame 0 carries the length and six bytes, the others seven */
+  offset = 0;
+  for (frame = 0; frame < NMEA_PRODUCT_FRAMES; frame++)
+  {
+    uint8_t *data = productFrames[frame];
+
+    data[0] = (uint8_t)frame;
+    i = 1;
+    if (frame == 0U)
+    {
+      data[i++] = NMEA_PRODUCT_INFO_SIZE;
+    }
+    for (; i < 8U; i++)
+    {
+      data[i] = (offset < NMEA_PRODUCT_INFO_SIZE) ? payload[offset++] : 0xFFU;
+    }
+  }
+  productBuilt = 1;
+}
+
+static void sendNak(uint8_t requester, uint32_t pgn)
+{
+  CAN_Frame nak;
+  uint8_t source = (uint8_t)Params_Get(PARAM_SOURCE_ADDRESS);
+
+  nak.id = CAN_FRAME_EXT | BOOT_CAN_ID(NMEA_PRIO_ISO, NMEA_PGN_ISO_ACK, requester, source);
+  nak.dlc = 8;
+  nak.data[0] = ISO_ACK_NAK;
+  nak.data[1] = 0xFF;       /* group function */
+  nak.data[2] = 0xFF;
+  nak.data[3] = 0xFF;
+  nak.data[4] = 0xFF;
+  nak.data[5] = (uint8_t)pgn;
+  nak.data[6] = (uint8_t)(pgn >> 8);
+  nak.data[7] = (uint8_t)(pgn >> 16);
+  (void)CAN_TransmitFrame(&nak);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Queues a heartbeat with the current interval and status
+  * @retval None
+  *
+  * The equipment status is a fault when frames were lost in either
+  * direction or a parameter write failed since the previous heartbeat.
+  */
+void Nmea_SendHeartbeat(void)
+{
+  CAN_Frame frame;
+  uint32_t esr = hcan.Instance->ESR;
+  uint32_t interval = Params_Get(PARAM_HEARTBEAT_MS) / 10U;
+  uint32_t lost = canStats.rxDropped + canStats.rxOverruns + canStats.txDropped + paramsStats.errors;
+  uint8_t controller = NMEA_CTRL_ERROR_ACTIVE;
+  uint8_t status = NMEA_STATUS_OPERATIONAL;
+
+  if ((esr & CAN_ESR_BOFF) != 0U)
+  {
+    controller = NMEA_CTRL_BUS_OFF;
+  }
+  else if ((esr & CAN_ESR_EPVF) != 0U)
+  {
+    controller = NMEA_CTRL_ERROR_PASSIVE;
+  }
+  if (lost != lostAtHeartbeat)
+  {
+    status = NMEA_STATUS_FAULT;
+    lostAtHeartbeat = lost;
+    nmeaStats.faults++;
+  }
+
+  frame.id = NMEA_ID(NMEA_PRIO_HEARTBEAT, NMEA_PGN_HEARTBEAT, Params_Get(PARAM_SOURCE_ADDRESS) & 0xFFUL);
+  frame.dlc = 8;
+  frame.data[0] = (uint8_t)interval;
+  frame.data[1] = (uint8_t)(interval >> 8);
+  frame.data[2] = heartbeatSequence;
+  frame.data[3] = (uint8_t)(0xC0U | (status << 4) | (NMEA_CTRL_NONE << 2) | controller);
+  frame.data[4] = 0xFF;
+  frame.data[5] = 0xFF;
+  frame.data[6] = 0xFF;
+  frame.data[7] = 0xFF;
+  (void)CAN_TransmitFrame(&frame);
+
+  heartbeatSequence = (heartbeatSequence == NMEA_SEQUENCE_MAX) ? 0U : (uint8_t)(heartbeatSequence + 1U);
+  nmeaStats.heartbeats++;
+}
+
+/**
+  * @brief  Starts a Product Information transfer, sent by Nmea_Poll()
+  * @retval None
+  *
+  * A request while a transfer is running is served by that transfer.
+  */
+void Nmea_SendProductInfo(void)
+{
+  if (productActive)
+  {
+    return;
+  }
+  if (!productBuilt)
+  {
+    buildProductInfo();
+  }
+  productSequence = (uint8_t)((productSequence + 1U) & 0x07U);
+  productNext = 0;
+  productActive = 1;
+}
+
+/**
+  * @brief  Answers ISO Requests for the heartbeat and Product Information
+  * @param  frame: received frame, anything else is ignored
+  * @retval None
+  */
+void Nmea_HandleFrame(const CAN_Frame *frame)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  uint8_t da = (uint8_t)BOOT_ID_DA(id);
+  uint32_t pgn;
+
+  if (((frame->id & CAN_FRAME_EXT) == 0U) || (frame->dlc < 3U) ||
+      (BOOT_ID_PGN(id) != NMEA_PGN_ISO_REQUEST) ||
+      ((da != NMEA_GLOBAL) && (da != (uint8_t)Params_Get(PARAM_SOURCE_ADDRESS))))
+  {
+    return;
+  }
+
+  pgn = frame->data[0] | ((uint32_t)frame->data[1] << 8) | ((uint32_t)frame->data[2] << 16);
+  if (pgn == NMEA_PGN_HEARTBEAT)
+  {
+    Nmea_SendHeartbeat();
+  }
+  else if (pgn == NMEA_PGN_PRODUCT_INFO)
+  {
+    Nmea_SendProductInfo();
+  }
+  else if (pgn == RAM_PGN_DIAG)
+  {
+    Ram_SendDiag();
+  }
+  else if (pgn == CPU_PGN_DIAG)
+  {
+    Cpu_SendDiag();
+  }
+  else if (pgn == ALARM_PGN)
+  {
+    Alarm_SendState();
+  }
+  else if (pgn == TREND_PGN)
+  {
+    Trend_SendState();
+  }
+  else if (da != NMEA_GLOBAL)
+  {
+    sendNak((uint8_t)BOOT_ID_SA(id), pgn);
+  }
+  else
+  {
+    return;
+  }
+  nmeaStats.requests++;
+}
+
+/**
+  * @brief  Queues the next Product Information frame once the controller
+  *         is idle
+  * @retval 1 while a transfer is running
+  *
+  * One frame at a time keeps them in order (nmea.h); the TX interrupt of
+  * each frame wakes the main loop for the next.
+  */
+uint8_t Nmea_Poll(void)
+{
+  CAN_Frame frame;
+  uint32_t i;
+
+  if (!productActive || (CAN_TxQueueFree() != CAN_TX_QUEUE_LEN) ||
+      (HAL_CAN_GetTxMailboxesFreeLevel(&hcan) != 3U))
+  {
+    return productActive;
+  }
+
+  frame.id = NMEA_ID(NMEA_PRIO_PRODUCT_INFO, NMEA_PGN_PRODUCT_INFO, Params_Get(PARAM_SOURCE_ADDRESS) & 0xFFUL);
+  frame.dlc = 8;
+  for (i = 0; i < 8U; i++)
+  {
+    frame.data[i] = productFrames[productNext][i];
+  }
+  frame.data[0] |= (uint8_t)(productSequence << 5);
+  (void)CAN_TransmitFrame(&frame);
+  nmeaStats.frames++;
+
+  if (++productNext == NMEA_PRODUCT_FRAMES)
+  {
+    productActive = 0;
+    nmeaStats.productInfos++;
+  }
+  return productActive;
+}
@@ -0,0 +1,538 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : params.c
+  * @brief          : Persistent runtime parameters (format in params.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Flash work is queued as a job of up to four half-word writes (one record
+  * or one page header) and run by Params_Poll(). Interrupts stay enabled
+  * throughout; the CPU only waits for the flash while a half-word is being
+  * programmed, and for the whole erase that starts a compaction. That erase
+  * is held back until CAN_LastRxTick() is PARAMS_ERASE_QUIET_MS old, so a
+  * burst of frames is not cut off by a 20-40 ms stall with only FIFO0's
+  * three slots to catch it, or until it has waited PARAMS_ERASE_DEFER_MS.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "params.h"
+#include "boot.h"
+
+#if (BOOT_APP_BASE + BOOT_APP_MAX_SIZE) > PARAMS_FLASH_BASE
+#error "application area overlaps the parameter pages"
+#endif
+
+/* Private define ------------------------------------------------------------*/
+#define PAGE_ADDRESS(page)      (PARAMS_FLASH_BASE + ((page) * PARAMS_PAGE_SIZE))
+#define RECORD_ADDRESS(page, i) (PAGE_ADDRESS(page) + PARAMS_HEADER_SIZE + ((i) * PARAMS_RECORD_SIZE))
+#define FLASH_HALFWORD(address) (*(volatile const uint16_t *)(address))
+#define KEY_BIT(key)            (1UL << (uint32_t)(key))
+
+enum
+{
+  STATE_IDLE = 0,
+  STATE_APPEND,       /* record job on the active page */
+  STATE_ERASE,        /* compaction: erase the spare page */
+  STATE_COPY,         /* compaction: record jobs on the spare page */
+  STATE_HEADER        /* compaction: header job on the spare page */
+};
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  int32_t def;
+  int32_t min;
+  int32_t max;
+} Params_Limits;
+
+/* Private variables ---------------------------------------------------------*/
+static const Params_Limits limits[PARAM_COUNT] =
+{
+  [PARAM_SOURCE_ADDRESS] = { BOOT_NODE_ADDRESS, 0, 251 },
+  [PARAM_A1_PERIOD_MS]   = { 33, 10, 1000 },
+  [PARAM_T1_PERIOD_MS]   = { 1000, 100, 60000 },
+  [PARAM_TEMP_INSTANCE]  = { 0, 0, 252 },
+  [PARAM_TEMP_SOURCE]    = { 1, 0, 252 },
+  [PARAM_TEMP_OFFSET]    = { 0, -1000, 1000 },
+  [PARAM_HEARTBEAT_MS]   = { 60000, 1000, 600000 },
+  [PARAM_DIAG_MS]        = { 10000, 1000, 600000 },
+  [PARAM_ALARM_HIGH]     = { 850, -550, 1500 },
+  [PARAM_ALARM_LOW]      = { -400, -550, 1500 },
+  [PARAM_ALARM_HYST]     = { 20, 0, 500 },
+  [PARAM_FILTER_MODE]    = { 0, 0, 3 },
+  [PARAM_FILTER_BATCH]   = { 8, 1, 16 },
+  [PARAM_FILTER_CUTOFF]  = { 50, 5, 400 },
+  [PARAM_TREND_WINDOW]   = { 30, 2, 64 },
+};
+
+static uint32_t values[PARAM_COUNT];
+static uint32_t storedKeys;       /* keys with a record on the active page */
+static uint32_t dirtyKeys;        /* keys changed since their last record */
+static uint32_t copiedKeys;       /* keys with a record on the spare page */
+
+static uint32_t activePage;
+static uint32_t writeIndex;       /* next free record slot on the active page */
+static uint32_t copyKey;
+static uint32_t copyIndex;
+static uint8_t state;
+static uint8_t eraseWaiting;      /* STATE_ERASE held back for a quiet bus */
+static uint32_t eraseSince;       /* HAL tick the erase was first due */
+
+static struct
+{
+  uint32_t address[4];
+  uint16_t data[4];
+  uint8_t count;
+  uint8_t done;
+} job;
+
+Params_Stats paramsStats;
+
+/* Private functions ---------------------------------------------------------*/
+static uint16_t crc16(const uint16_t *words, uint32_t count)
+{
+  uint16_t crc = 0xFFFFU;
+  uint32_t i;
+  uint32_t bit;
+
+  for (i = 0; i < (count * 2U); i++)
+  {
+    crc ^= (uint16_t)(((words[i / 2U] >> ((i % 2U) * 8U)) & 0xFFU) << 8);
+    for (bit = 0; bit < 8U; bit++)
+    {
+      crc = ((crc & 0x8000U) != 0U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static int pageValid(uint32_t page)
+{
+  uint32_t base = PAGE_ADDRESS(page);
+
+  return (FLASH_HALFWORD(base) | ((uint32_t)FLASH_HALFWORD(base + 2U) << 16)) == PARAMS_MAGIC;
+}
+
+static uint32_t pageGeneration(uint32_t page)
+{
+  uint32_t base = PAGE_ADDRESS(page);
+
+  return FLASH_HALFWORD(base + 4U) | ((uint32_t)FLASH_HALFWORD(base + 6U) << 16);
+}
+
+static int inRange(Params_Key key, uint32_t value)
+{
+  return ((int32_t)value >= limits[key].min) && ((int32_t)value <= limits[key].max);
+}
+
+static int programHalfword(uint32_t address, uint16_t data)
+{
+  HAL_StatusTypeDef status;
+
+  HAL_FLASH_Unlock();
+  status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address, data);
+  HAL_FLASH_Lock();
+  paramsStats.halfwords++;
+  return ((status == HAL_OK) && (FLASH_HALFWORD(address) == data)) ? 0 : -1;
+}
+
+static int erasePage(uint32_t page)
+{
+  FLASH_EraseInitTypeDef erase;
+  uint32_t pageError = 0;
+  HAL_StatusTypeDef status;
+
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.PageAddress = PAGE_ADDRESS(page);
+  erase.NbPages = 1;
+  HAL_FLASH_Unlock();
+  status = HAL_FLASHEx_Erase(&erase, &pageError);
+  HAL_FLASH_Lock();
+  paramsStats.erases++;
+  return (status == HAL_OK) ? 0 : -1;
+}
+
+static void loadRecord(uint32_t address, Params_Key key, uint32_t value)
+{
+  uint32_t i;
+
+  job.data[0] = (uint16_t)key;
+  job.data[1] = (uint16_t)value;
+  job.data[2] = (uint16_t)(value >> 16);
+  job.data[3] = crc16(job.data, 3U);
+  for (i = 0; i < 4U; i++)
+  {
+    job.address[i] = address + (i * 2U);
+  }
+  job.count = 4;
+  job.done = 0;
+}
+
+/* Generation first, magic last: the page is valid once the magic is there */
+static void loadHeader(uint32_t page, uint32_t generation)
+{
+  uint32_t base = PAGE_ADDRESS(page);
+
+  job.address[0] = base + 4U;
+  job.data[0] = (uint16_t)generation;
+  job.address[1] = base + 6U;
+  job.data[1] = (uint16_t)(generation >> 16);
+  job.address[2] = base;
+  job.data[2] = (uint16_t)PARAMS_MAGIC;
+  job.address[3] = base + 2U;
+  job.data[3] = (uint16_t)(PARAMS_MAGIC >> 16);
+  job.count = 4;
+  job.done = 0;
+}
+
+/**
+  * @brief  Decides whether the compaction erase may stall the CPU now
+  * @retval 1 once the bus is quiet or the erase has waited long enough
+  */
+static int eraseAllowed(void)
+{
+  uint32_t now = HAL_GetTick();
+  int quiet = ((now - CAN_LastRxTick()) >= PARAMS_ERASE_QUIET_MS);
+
+  if (!eraseWaiting)
+  {
+    if (quiet)
+    {
+      return 1;
+    }
+    eraseWaiting = 1;
+    eraseSince = now;
+    paramsStats.deferred++;
+    return 0;
+  }
+  if (!quiet && ((now - eraseSince) < PARAMS_ERASE_DEFER_MS))
+  {
+    return 0;
+  }
+  if (!quiet)
+  {
+    paramsStats.forced++;
+  }
+  eraseWaiting = 0;
+  return 1;
+}
+
+/**
+  * @brief  Takes the lowest key from a mask and snapshots its value
+  * @retval PARAM_COUNT if the mask is empty
+  */
+static Params_Key takeKey(uint32_t mask, uint32_t from)
+{
+  uint32_t key;
+
+  for (key = from; key < (uint32_t)PARAM_COUNT; key++)
+  {
+    if ((mask & KEY_BIT(key)) != 0U)
+    {
+      dirtyKeys &= ~KEY_BIT(key);
+      return (Params_Key)key;
+    }
+  }
+  return PARAM_COUNT;
+}
+
+/**
+  * @brief  Finishes the current job and queues the next one
+  * @retval 1 if a job was queued, 0 if there is nothing to do, the call
+  *         already spent its time on a page erase or the erase is waiting
+  *         for a quiet bus
+  */
+static int nextJob(void)
+{
+  Params_Key key;
+
+  switch (state)
+  {
+    case STATE_APPEND:
+      storedKeys |= KEY_BIT(job.data[0]);
+      writeIndex++;
+      paramsStats.records++;
+      state = STATE_IDLE;
+      /* fall through */
+
+    case STATE_IDLE:
+      if (dirtyKeys == 0U)
+      {
+        return 0;
+      }
+      if (writeIndex >= PARAMS_RECORDS_PER_PAGE)
+      {
+        state = STATE_ERASE;
+        return nextJob();
+      }
+      key = takeKey(dirtyKeys, 0);
+      loadRecord(RECORD_ADDRESS(activePage, writeIndex), key, values[key]);
+      state = STATE_APPEND;
+      return 1;
+
+    case STATE_ERASE:
+      if (!eraseAllowed())
+      {
+        return 0;
+      }
+      if (erasePage(activePage ^ 1U) != 0)
+      {
+        paramsStats.errors++;
+        return 0;
+      }
+      copyKey = 0;
+      copyIndex = 0;
+      copiedKeys = 0;
+      state = STATE_COPY;
+      return 0;
+
+    case STATE_COPY:
+      key = takeKey(storedKeys | dirtyKeys, copyKey);
+      if (key == PARAM_COUNT)
+      {
+        loadHeader(activePage ^ 1U, paramsStats.generation + 1U);
+        state = STATE_HEADER;
+        return 1;
+      }
+      loadRecord(RECORD_ADDRESS(activePage ^ 1U, copyIndex), key, values[key]);
+      copiedKeys |= KEY_BIT(key);
+      copyKey = (uint32_t)key + 1U;
+      copyIndex++;
+      return 1;
+
+    case STATE_HEADER:
+    default:
+      storedKeys = copiedKeys;
+      activePage ^= 1U;
+      writeIndex = copyIndex;
+      paramsStats.generation++;
+      paramsStats.compactions++;
+      state = STATE_IDLE;
+      return nextJob();
+  }
+}
+
+/**
+  * @brief  Applies the valid records of the active page to the RAM copy
+  * @retval None
+  */
+static void loadPage(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < PARAMS_RECORDS_PER_PAGE; i++)
+  {
+    uint32_t address = RECORD_ADDRESS(activePage, i);
+    uint16_t words[4];
+    uint32_t value;
+
+    words[0] = FLASH_HALFWORD(address);
+    words[1] = FLASH_HALFWORD(address + 2U);
+    words[2] = FLASH_HALFWORD(address + 4U);
+    words[3] = FLASH_HALFWORD(address + 6U);
+    if ((words[0] & words[1] & words[2] & words[3]) == 0xFFFFU)
+    {
+      continue;
+    }
+    writeIndex = i + 1U;
+
+    value = words[1] | ((uint32_t)words[2] << 16);
+    if ((crc16(words, 3U) != words[3]) || (words[0] >= (uint16_t)PARAM_COUNT) ||
+        !inRange((Params_Key)words[0], value))
+    {
+      paramsStats.bootSkipped++;
+      continue;
+    }
+    values[words[0]] = value;
+    storedKeys |= KEY_BIT(words[0]);
+    paramsStats.bootRecords++;
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Loads the parameters, formatting the store on first use
+  * @retval None
+  *
+  * Runs before the main loop, so a needed page erase is done here directly.
+  */
+void Params_Init(void)
+{
+  uint32_t key;
+  uint32_t i;
+
+  for (key = 0; key < (uint32_t)PARAM_COUNT; key++)
+  {
+    values[key] = (uint32_t)limits[key].def;
+  }
+
+  if (pageValid(0U) && (!pageValid(1U) || ((int32_t)(pageGeneration(0U) - pageGeneration(1U)) > 0)))
+  {
+    activePage = 0;
+  }
+  else if (pageValid(1U))
+  {
+    activePage = 1;
+  }
+  else
+  {
+    activePage = 0;
+    loadHeader(0U, 1U);
+    if (erasePage(0U) != 0)
+    {
+      paramsStats.errors++;
+    }
+    for (i = 0; i < job.count; i++)
+    {
+      if (programHalfword(job.address[i], job.data[i]) != 0)
+      {
+        paramsStats.errors++;
+      }
+    }
+    job.count = 0;
+  }
+
+  paramsStats.generation = pageGeneration(activePage);
+  loadPage();
+}
+
+/**
+  * @brief  Returns a parameter from the RAM copy
+  * @param  key: parameter key
+  * @retval current value, 0 for an unknown key
+  */
+uint32_t Params_Get(Params_Key key)
+{
+  return ((uint32_t)key < (uint32_t)PARAM_COUNT) ? values[key] : 0U;
+}
+
+/**
+  * @brief  Changes a parameter; it takes effect at once and is written to
+  *         flash by Params_Poll()
+  * @param  key: parameter key
+  * @param  value: new value (signed keys in two's complement)
+  * @retval PARAMS_OK or a PARAMS_ERR_ code
+  *
+  * Setting a key again before its record is written only replaces the
+  * pending value, so fast updates cost one record per poll at most.
+  */
+uint8_t Params_Set(Params_Key key, uint32_t value)
+{
+  if ((uint32_t)key >= (uint32_t)PARAM_COUNT)
+  {
+    return PARAMS_ERR_KEY;
+  }
+  if (!inRange(key, value))
+  {
+    return PARAMS_ERR_RANGE;
+  }
+  if (values[key] != value)
+  {
+    values[key] = value;
+    dirtyKeys |= KEY_BIT(key);
+    paramsStats.updates++;
+  }
+  return PARAMS_OK;
+}
+
+/**
+  * @brief  Programs up to PARAMS_POLL_HALFWORDS half-words of pending work
+  * @retval None
+  *
+  * Call from the main loop. A failed write starts a compaction, which moves
+  * the store to a freshly erased page.
+  */
+void Params_Poll(void)
+{
+  uint32_t budget = PARAMS_POLL_HALFWORDS;
+
+  while (budget > 0U)
+  {
+    if (job.done < job.count)
+    {
+      if (programHalfword(job.address[job.done], job.data[job.done]) != 0)
+      {
+        paramsStats.errors++;
+        job.count = 0;
+        if (state == STATE_APPEND)
+        {
+          dirtyKeys |= KEY_BIT(job.data[0]);
+          writeIndex++;
+        }
+        if (state == STATE_COPY)
+        {
+          storedKeys |= KEY_BIT(job.data[0]);
+        }
+        state = STATE_ERASE;
+        return;
+      }
+      job.done++;
+      budget--;
+      continue;
+    }
+    job.count = 0;
+    job.done = 0;
+    if (!nextJob())
+    {
+      return;
+    }
+  }
+}
+
+/**
+  * @brief  Serves PARAM_GET/PARAM_SET commands addressed to this node
+  * @param  frame: frame taken from the CAN RX queue
+  * @retval None
+  */
+void Params_HandleFrame(const CAN_Frame *frame)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  CAN_Frame response;
+  Params_Key key;
+  uint32_t value;
+  uint8_t status = PARAMS_OK;
+
+  if (((frame->id & CAN_FRAME_EXT) == 0U) || (frame->dlc < 3U) ||
+      (BOOT_ID_PGN(id) != BOOT_PGN_CMD) || (BOOT_ID_DA(id) != BOOT_NODE_ADDRESS) ||
+      ((frame->data[0] != PARAMS_CMD_GET) && (frame->data[0] != PARAMS_CMD_SET)))
+  {
+    return;
+  }
+
+  key = (Params_Key)(frame->data[1] | ((uint32_t)frame->data[2] << 8));
+  if ((uint32_t)key >= (uint32_t)PARAM_COUNT)
+  {
+    status = PARAMS_ERR_KEY;
+  }
+  else if (frame->data[0] == PARAMS_CMD_SET)
+  {
+    value = frame->data[3] | ((uint32_t)frame->data[4] << 8) |
+            ((uint32_t)frame->data[5] << 16) | ((uint32_t)frame->data[6] << 24);
+    status = (frame->dlc < 7U) ? PARAMS_ERR_RANGE : Params_Set(key, value);
+  }
+  value = Params_Get(key);
+
+  response.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_ID_SA(id), BOOT_NODE_ADDRESS);
+  response.dlc = 8;
+  response.data[0] = frame->data[0] | BOOT_RSP;
+  response.data[1] = status;
+  response.data[2] = frame->data[1];
+  response.data[3] = frame->data[2];
+  response.data[4] = (uint8_t)value;
+  response.data[5] = (uint8_t)(value >> 8);
+  response.data[6] = (uint8_t)(value >> 16);
+  response.data[7] = (uint8_t)(value >> 24);
+  (void)CAN_TransmitFrame(&response);
+}
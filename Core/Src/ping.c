@@ -0,0 +1,111 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : ping.c
+  * @brief          : Ping/echo answered from the CAN interrupts (see ping.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The ring has one producer, the CAN RX interrupt, and one consumer, the
+  * CAN TX interrupt, which RX preempts; indices run freely and are masked
+  * as in the CAN queues. RX only pends TX, so the mailboxes are loaded from
+  * one interrupt alone.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ping.h"
+#include "boot.h"
+#include "slcan.h"
+
+/* Private define ------------------------------------------------------------*/
+/* CAN_RI0R of a ping: command PGN to this node, any priority and source */
+#define PING_RIR_MASK   ((0x03FFFF00UL << CAN_RI0R_EXID_Pos) | CAN_RI0R_IDE | CAN_RI0R_RTR)
+#define PING_RIR        ((BOOT_CAN_ID(0, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, 0) << CAN_RI0R_EXID_Pos) | CAN_RI0R_IDE)
+#define PING_PRIO_MASK  (7UL << 26)
+
+/* Private variables ---------------------------------------------------------*/
+volatile Ping_Stats pingStats;
+
+static CAN_Frame ring[PING_SLOTS];
+static volatile uint32_t head;    // written by Ping_Frame
+static volatile uint32_t tail;    // written by Ping_Next
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Answers a ping read from FIFO0; called by the CAN RX interrupt
+  *         for every frame before it is queued
+  * @param  rir: CAN_RI0R of the frame
+  * @param  rdtr: CAN_RDT0R of the frame, with the time stamp
+  * @param  rdlr: CAN_RDL0R of the frame, data bytes 0..3
+  * @retval 1 if the frame was a ping and is answered, so not to be queued
+  */
+CCMRAM_FUNC uint8_t Ping_Frame(uint32_t rir, uint32_t rdtr, uint32_t rdlr)
+{
+  uint32_t id = rir >> CAN_RI0R_EXID_Pos;
+  uint32_t ahead = head - tail;
+  CAN_Frame *echo;
+
+#if SLCAN_ENABLE
+  return 0;
+#endif
+  if (((rir & PING_RIR_MASK) != PING_RIR) || ((rdtr & CAN_RDT0R_DLC) < 2U) ||
+      ((uint8_t)rdlr != PING_CMD_ECHO))
+  {
+    return 0;
+  }
+  if ((ahead >= PING_SLOTS) || (CAN_Silent() != 0U))
+  {
+    pingStats.busy++;
+    return 0;
+  }
+
+  echo = &ring[head & (PING_SLOTS - 1U)];
+  echo->id = (id & PING_PRIO_MASK) | BOOT_CAN_ID(0, BOOT_PGN_CMD, BOOT_ID_SA(id), BOOT_NODE_ADDRESS) | CAN_FRAME_EXT;
+  echo->dlc = 8;              /* TGT needs DLC 8 */
+  echo->filter = 0;
+  echo->time = 0;
+  echo->data[0] = PING_CMD_ECHO | BOOT_RSP;
+  echo->data[1] = (uint8_t)(rdlr >> 8);
+  echo->data[2] = (uint8_t)(rdtr >> CAN_RDT0R_TIME_Pos);
+  echo->data[3] = (uint8_t)(rdtr >> (CAN_RDT0R_TIME_Pos + 8U));
+  echo->data[4] = (uint8_t)(CAN_TX_QUEUE_LEN - CAN_TxQueueFree());
+  echo->data[5] = (uint8_t)(PING_RESERVED | (ahead << PING_AHEAD_Pos) |
+                            ((3U - HAL_CAN_GetTxMailboxesFreeLevel(&hcan)) & PING_MAILBOXES_MASK));
+  echo->data[6] = 0xFF;       /* written by the controller */
+  echo->data[7] = 0xFF;
+  head++;
+  pingStats.echoes++;
+
+  HAL_NVIC_SetPendingIRQ(CAN_TX_IRQn);
+  return 1;
+}
+
+/**
+  * @brief  Takes the next echo; call from the CAN TX interrupt with a
+  *         mailbox free, and load it with TGT set
+  * @param  frame: destination
+  * @retval 1 if an echo was returned
+  */
+CCMRAM_FUNC uint8_t Ping_Next(CAN_Frame *frame)
+{
+  uint32_t t = tail;
+
+  if (t == head)
+  {
+    return 0;
+  }
+  *frame = ring[t & (PING_SLOTS - 1U)];
+  tail = t + 1U;
+  return 1;
+}
@@ -0,0 +1,135 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : ram.c
+  * @brief          : Stack and heap high-water marks, diagnostics PGN (see
+  *                   ram.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * A pass over the free area costs one compare per word, RAM_SCAN_WORDS per
+  * call. The service task runs once per scheduler pass, every 33 ms with the
+  * default A1 period, so a pass over 6 KB takes about 3 s, well inside the
+  * default PARAM_DIAG_MS; a new deepest word shows in the next message.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ram.h"
+#include "can.h"
+#include "params.h"
+
+/* Private define ------------------------------------------------------------*/
+#define RAM_DIAG_ID(src) \
+  (CAN_FRAME_EXT | (RAM_PRIO_DIAG << 26) | (RAM_PGN_DIAG << 8) | (uint32_t)(src))
+
+/* Private variables ---------------------------------------------------------*/
+extern uint32_t _end;             /* heap start, from the linker script */
+extern uint32_t _estack;          /* top of SRAM */
+extern uint32_t _Min_Stack_Size;  /* absolute symbol, its address is the size */
+
+Ram_Stats ramStats;
+
+static const uint32_t *deepest;   /* lowest word found changed */
+static const uint32_t *cursor;    /* next word of the pass */
+
+/* Private functions ---------------------------------------------------------*/
+static uint16_t clamp16(uint32_t value)
+{
+  return (value > 0xFFFFU) ? 0xFFFFU : (uint16_t)value;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Checks the next RAM_SCAN_WORDS words of the painted area and
+  *         updates the stack high-water mark and the headroom
+  * @retval None
+  *
+  * Memory handed back by a negative _sbrk() keeps what the heap wrote and
+  * reads as stack; newlib-nano's malloc never does that.
+  */
+void Ram_Scan(void)
+{
+  const uint32_t *floor = (const uint32_t *)(((uintptr_t)&_end + ramStats.heapUsed + 3U) & ~(uintptr_t)3U);
+  uint32_t words = RAM_SCAN_WORDS;
+
+  if (deepest == NULL)
+  {
+    deepest = &_estack;
+    cursor = floor;
+  }
+  if (cursor < floor)
+  {
+    cursor = floor;               /* the heap has grown over the pass */
+  }
+
+  while (words-- != 0U)
+  {
+    if (cursor >= deepest)
+    {
+      ramStats.passes++;
+      cursor = floor;
+      break;
+    }
+    if (*cursor != RAM_PAINT)
+    {
+      deepest = cursor;           /* only a deeper word can change the mark */
+      cursor = floor;
+      break;
+    }
+    cursor++;
+  }
+
+  ramStats.stackPeak = (uint32_t)((uintptr_t)&_estack - (uintptr_t)deepest);
+  ramStats.headroom = (deepest > floor) ? (uint32_t)((uintptr_t)deepest - (uintptr_t)floor) : 0U;
+}
+
+/**
+  * @brief  Queues the diagnostics message (PGN 65284)
+  * @retval None
+  */
+void Ram_SendDiag(void)
+{
+  CAN_Frame frame;
+  uint16_t stack = clamp16(ramStats.stackPeak);
+  uint16_t headroom = clamp16(ramStats.headroom);
+  uint16_t heap = clamp16(ramStats.heapPeak);
+  uint8_t flags = 0;
+
+  if (ramStats.passes != 0U)
+  {
+    flags |= RAM_DIAG_SCANNED;
+  }
+  if (ramStats.stackPeak > (uint32_t)(uintptr_t)&_Min_Stack_Size)
+  {
+    flags |= RAM_DIAG_STACK_OVER;
+  }
+  if (ramStats.headroom < RAM_HEADROOM_MIN)
+  {
+    flags |= RAM_DIAG_LOW;
+  }
+
+  frame.id = RAM_DIAG_ID(Params_Get(PARAM_SOURCE_ADDRESS) & 0xFFUL);
+  frame.dlc = 8;
+  frame.data[0] = (uint8_t)stack;
+  frame.data[1] = (uint8_t)(stack >> 8);
+  frame.data[2] = (uint8_t)headroom;
+  frame.data[3] = (uint8_t)(headroom >> 8);
+  frame.data[4] = (uint8_t)heap;
+  frame.data[5] = (uint8_t)(heap >> 8);
+  frame.data[6] = (ramStats.heapFailures > 0xFFU) ? 0xFFU : (uint8_t)ramStats.heapFailures;
+  frame.data[7] = (uint8_t)(0xF8U | flags);
+  (void)CAN_TransmitFrame(&frame);
+
+  ramStats.diags++;
+}
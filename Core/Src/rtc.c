@@ -0,0 +1,132 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : rtc.c
+  * @brief          : RTC initialization and millisecond time of day
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "rtc.h"
+#include "main.h"
+
+/* RTC handler declaration */
+RTC_HandleTypeDef hrtc;
+
+/**
+  * @brief RTC Initialization Function
+  * @param None
+  * @retval None
+  */
+void MX_RTC_Init(void)
+{
+  /* Calendar at 1 Hz from the LSI; the date and time are never set, only
+   * differences are used */
+  hrtc.Instance = RTC;
+  hrtc.Init.HourFormat = RTC_HOURFORMAT_24;
+  hrtc.Init.AsynchPrediv = RTC_ASYNCH_PREDIV;
+  hrtc.Init.SynchPrediv = RTC_SYNCH_PREDIV;
+  hrtc.Init.OutPut = RTC_OUTPUT_DISABLE;
+  hrtc.Init.OutPutPolarity = RTC_OUTPUT_POLARITY_HIGH;
+  hrtc.Init.OutPutType = RTC_OUTPUT_TYPE_OPENDRAIN;
+
+  if (HAL_RTC_Init(&hrtc) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  /* Read SSR/TR directly: the shadow registers are stale right after Stop */
+  if (HAL_RTCEx_EnableBypassShadow(&hrtc) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/**
+  * @brief Milliseconds since midnight of the RTC calendar
+  * @param None
+  * @retval 0 .. 86399999, wraps once a day
+  */
+uint32_t RTC_GetMillis(void)
+{
+  uint32_t ssr;
+  uint32_t tr;
+  uint32_t seconds;
+
+  /* With BYPSHAD the registers are read live: retry until SSR did not move */
+  do
+  {
+    ssr = RTC->SSR;
+    tr = RTC->TR;
+  } while (ssr != RTC->SSR);
+
+  seconds = (RTC_Bcd2ToByte((uint8_t)((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos)) * 3600U) +
+            (RTC_Bcd2ToByte((uint8_t)((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos)) * 60U) +
+            RTC_Bcd2ToByte((uint8_t)((tr & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos));
+
+  return (seconds * 1000U) + (RTC_SYNCH_PREDIV - (ssr & RTC_SSR_SS));
+}
+
+/**
+  * @brief RTC MSP Initialization
+  * @param rtcHandle: RTC handle pointer
+  * @retval None
+  */
+void HAL_RTC_MspInit(RTC_HandleTypeDef* rtcHandle)
+{
+  RCC_OscInitTypeDef RCC_OscInitStruct = {0};
+  RCC_PeriphCLKInitTypeDef PeriphClkInit = {0};
+
+  if(rtcHandle->Instance == RTC)
+  {
+    /* LSI on, PLL left alone */
+    RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_LSI;
+    RCC_OscInitStruct.LSIState = RCC_LSI_ON;
+    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
+    if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+    PeriphClkInit.RTCClockSelection = RCC_RTCCLKSOURCE_LSI;
+    if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    /* Peripheral clock enable */
+    __HAL_RCC_RTC_ENABLE();
+
+    /* Wake-up timer interrupt (EXTI line 20) */
+    HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+  }
+}
+
+/**
+  * @brief RTC MSP De-Initialization
+  * @param rtcHandle: RTC handle pointer
+  * @retval None
+  */
+void HAL_RTC_MspDeInit(RTC_HandleTypeDef* rtcHandle)
+{
+  if(rtcHandle->Instance == RTC)
+  {
+    /* Peripheral clock disable */
+    __HAL_RCC_RTC_DISABLE();
+
+    HAL_NVIC_DisableIRQ(RTC_WKUP_IRQn);
+  }
+}
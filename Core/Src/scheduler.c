@@ -0,0 +1,412 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : scheduler.c
+  * @brief          : Cooperative periodic task scheduler with a low-power
+  *                   idle path
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The idle decision is taken with PRIMASK set: an interrupt that arrives
+  * after the last check still ends WFI at once (it is pending, just not
+  * taken), so a received frame or an elapsed deadline is never slept over.
+  * The handlers run when PRIMASK is cleared again after the wake-up.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "scheduler.h"
+#include "main.h"
+#include "can.h"
+#include "cpu.h"
+#include "trace.h"
+#include "watchdog.h"
+#if SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP
+#include "rtc.h"
+#endif
+
+#if (SCHEDULER_IDLE_MODE != SCHEDULER_IDLE_RUN) && (SCHEDULER_IDLE_MODE != SCHEDULER_IDLE_SLEEP) && \
+    (SCHEDULER_IDLE_MODE != SCHEDULER_IDLE_STOP)
+#error "SCHEDULER_IDLE_MODE must be SCHEDULER_IDLE_RUN, _SLEEP or _STOP"
+#endif
+
+/* Private define ------------------------------------------------------------*/
+/* Longest wait handled in one pass: each pass refreshes the watchdog */
+#define MAX_WAIT_MS             WATCHDOG_MAX_IDLE_MS
+
+/* bxCAN enters sleep mode at the end of the frame on the wire (< 0.3 ms) */
+#define CAN_SLEEP_TIMEOUT_MS    2U
+
+#define RTC_DAY_MS              86400000UL
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  Scheduler_TaskFn fn;
+  uint32_t periodMs;      /* 0 = every pass */
+  uint32_t nextMs;        /* HAL_GetTick() deadline of the next run */
+  uint8_t traceId;
+  uint8_t watchdogId;     /* Watchdog_Register() number */
+} Scheduler_Task;
+
+/* Private variables ---------------------------------------------------------*/
+static Scheduler_Task tasks[SCHEDULER_MAX_TASKS];
+static uint8_t taskCount;
+static uint8_t keepAwake;         /* end the next idle at the first interrupt */
+#if SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP
+static uint32_t awakeUntil;       /* no Stop before this tick (CAN activity) */
+static uint32_t lastRxFrames;
+#endif
+
+Scheduler_Stats schedulerStats;
+
+/* Private functions ---------------------------------------------------------*/
+static void runTask(Scheduler_Task *task)
+{
+  if (task->traceId != SCHEDULER_NO_TRACE)
+  {
+    TRACE_EVENT(TRACE_EVT_TASK_START, task->traceId, 0);
+  }
+  Watchdog_Running(task->watchdogId);
+  task->fn();
+  Watchdog_CheckIn(task->watchdogId);
+  if (task->traceId != SCHEDULER_NO_TRACE)
+  {
+    TRACE_EVENT(TRACE_EVT_TASK_STOP, task->traceId, 0);
+  }
+  schedulerStats.taskRuns++;
+}
+
+static int deadlineReached(uint32_t deadline)
+{
+  return (int32_t)(HAL_GetTick() - deadline) >= 0;
+}
+
+#if SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP
+/**
+  * @brief  Stop mode until the RTC wake-up shortly before the deadline or
+  *         until CAN bus activity
+  * @param  deadline: HAL_GetTick() value to be awake by
+  * @retval 1 if the node was stopped, 0 if Stop was not possible now
+  */
+static uint8_t enterStop(uint32_t deadline)
+{
+  uint32_t tickstart;
+  uint32_t wakeMs;
+  uint32_t startMs;
+  uint32_t sleptMs;
+  uint32_t stopMs;
+  uint8_t canWake;
+
+  /* Sleep mode freezes bxCAN between frames, and it only leaves it from
+   * HAL_CAN_WakeUp() once the clocks are back */
+  if (HAL_CAN_RequestSleep(&hcan) != HAL_OK)
+  {
+    schedulerStats.stopAborts++;
+    return 0;
+  }
+  tickstart = HAL_GetTick();
+  while (HAL_CAN_IsSleepActive(&hcan) == 0U)
+  {
+    if ((HAL_GetTick() - tickstart) > CAN_SLEEP_TIMEOUT_MS)
+    {
+      /* Bus busy: do not poll for sleep mode again on every tick */
+      (void)HAL_CAN_WakeUp(&hcan);
+      awakeUntil = HAL_GetTick() + SCHEDULER_CAN_AWAKE_MS;
+      schedulerStats.stopAborts++;
+      return 0;
+    }
+  }
+
+  /* Wake up early enough for the HSE and PLL to be running at the deadline */
+  wakeMs = deadline - HAL_GetTick() - SCHEDULER_STOP_WAKE_MS;
+  if ((int32_t)wakeMs < (int32_t)(SCHEDULER_STOP_MIN_MS - SCHEDULER_STOP_WAKE_MS))
+  {
+    (void)HAL_CAN_WakeUp(&hcan);
+    return 0;
+  }
+  if (wakeMs > ((0x10000UL * 1000U) / RTC_WAKEUP_HZ))
+  {
+    wakeMs = (0x10000UL * 1000U) / RTC_WAKEUP_HZ;
+  }
+  if (HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, ((wakeMs * RTC_WAKEUP_HZ) / 1000U) - 1U,
+                                  RTC_WAKEUPCLOCK_RTCCLK_DIV16) != HAL_OK)
+  {
+    (void)HAL_CAN_WakeUp(&hcan);
+    schedulerStats.stopAborts++;
+    return 0;
+  }
+
+  __disable_irq();
+  if (CAN_RxPending() != 0U)
+  {
+    __enable_irq();
+    (void)HAL_RTCEx_DeactivateWakeUpTimer(&hrtc);
+    (void)HAL_CAN_WakeUp(&hcan);
+    return 0;
+  }
+
+  TRACE_EVENT(TRACE_EVT_IDLE_ENTER, SCHEDULER_IDLE_STOP, 0);
+  EXTI->PR = EXTI_PR_PR11;
+  EXTI->IMR |= EXTI_IMR_MR11;
+  startMs = RTC_GetMillis();
+  HAL_SuspendTick();
+
+  HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+  sleptMs = (RTC_GetMillis() + RTC_DAY_MS - startMs) % RTC_DAY_MS;
+
+  /* Running from HSI now: HSE and PLL first, bxCAN stays asleep meanwhile */
+  SystemClock_Config();
+  stopMs = (RTC_GetMillis() + RTC_DAY_MS - startMs) % RTC_DAY_MS;
+  uwTick += stopMs;
+  HAL_ResumeTick();
+
+  canWake = ((EXTI->PR & EXTI_PR_PR11) != 0U) ? 1U : 0U;
+  EXTI->IMR &= ~EXTI_IMR_MR11;
+  EXTI->PR = EXTI_PR_PR11;
+  HAL_NVIC_ClearPendingIRQ(EXTI15_10_IRQn);
+
+  /* Back on the bus with the 1 Mbit/s timing once 11 recessive bits pass */
+  (void)HAL_CAN_WakeUp(&hcan);
+  TRACE_EVENT(TRACE_EVT_IDLE_EXIT, SCHEDULER_IDLE_STOP, canWake);
+  __enable_irq();
+  (void)HAL_RTCEx_DeactivateWakeUpTimer(&hrtc);
+
+  /* The frame that woke us is lost: stay reachable for the sender's retry */
+  if (canWake != 0U)
+  {
+    awakeUntil = HAL_GetTick() + SCHEDULER_CAN_AWAKE_MS;
+  }
+  schedulerStats.stops++;
+  schedulerStats.canWakeups += canWake;
+  schedulerStats.stopUs += (uint64_t)sleptMs * 1000U;
+  return 1;
+}
+#endif /* SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP */
+
+/**
+  * @brief  Waits for the deadline or a received frame in the configured mode
+  * @param  deadline: HAL_GetTick() value of the next task run
+  * @retval None
+  */
+static void idle(uint32_t deadline)
+{
+  uint32_t start = Scheduler_Micros();
+  Cpu_Section cpu;
+
+  Cpu_IdleEnter(&cpu);
+
+#if SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP
+  if (canStats.rxFrames != lastRxFrames)
+  {
+    lastRxFrames = canStats.rxFrames;
+    awakeUntil = HAL_GetTick() + SCHEDULER_CAN_AWAKE_MS;
+  }
+#endif
+
+#if SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_RUN
+  while (!deadlineReached(deadline) && (CAN_RxPending() == 0U) && !keepAwake)
+  {
+  }
+#else
+  TRACE_EVENT(TRACE_EVT_IDLE_ENTER, SCHEDULER_IDLE_SLEEP, 0);
+  for (;;)
+  {
+#if SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP
+    /* Stop once the mailboxes are empty (a frame left in one would wait for
+     * the next wake-up), unless the wait is too short or the bus is busy */
+    if (((int32_t)(deadline - HAL_GetTick()) >= (int32_t)SCHEDULER_STOP_MIN_MS) &&
+        ((int32_t)(HAL_GetTick() - awakeUntil) >= 0) &&
+        (HAL_CAN_GetTxMailboxesFreeLevel(&hcan) == 3U) && (enterStop(deadline) != 0U))
+    {
+      continue;
+    }
+#endif
+    __disable_irq();
+    if (deadlineReached(deadline) || (CAN_RxPending() != 0U))
+    {
+      __enable_irq();
+      break;
+    }
+    schedulerStats.sleeps++;
+    HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    __enable_irq();
+    if (keepAwake)
+    {
+      break;
+    }
+  }
+  TRACE_EVENT(TRACE_EVT_IDLE_EXIT, SCHEDULER_IDLE_SLEEP, 0);
+#endif
+
+  keepAwake = 0;
+  schedulerStats.idleUs += Scheduler_Micros() - start;
+  Cpu_IdleExit(&cpu);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Prepares the idle path; call once the clocks and CAN are set up
+  * @retval None
+  */
+void Scheduler_Init(void)
+{
+#if SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP
+  MX_RTC_Init();
+
+  /* CAN_RX (PA11) falling edge on EXTI line 11, unmasked only while in Stop */
+  SYSCFG->EXTICR[2] &= ~SYSCFG_EXTICR3_EXTI11;
+  EXTI->FTSR |= EXTI_FTSR_TR11;
+  EXTI->IMR &= ~EXTI_IMR_MR11;
+  HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+#endif
+}
+
+/**
+  * @brief  Adds a task; tasks run in the order they were added
+  * @param  fn: task function, runs to completion
+  * @param  periodMs: run period, 0 to run on every pass
+  * @param  traceId: TRACE_TASK_xxx for TASK_START/STOP events, or
+  *         SCHEDULER_NO_TRACE
+  * @retval task handle for Scheduler_SetPeriod(), 0xFF if the table is full
+  */
+uint8_t Scheduler_Add(Scheduler_TaskFn fn, uint32_t periodMs, uint8_t traceId)
+{
+  Scheduler_Task *task;
+
+  if (taskCount >= SCHEDULER_MAX_TASKS)
+  {
+    return 0xFFU;
+  }
+  task = &tasks[taskCount];
+  task->fn = fn;
+  task->periodMs = periodMs;
+  task->nextMs = HAL_GetTick() + periodMs;
+  task->traceId = traceId;
+  task->watchdogId = Watchdog_Register(periodMs);
+  return taskCount++;
+}
+
+/**
+  * @brief  Changes the period of a task; the next run is one new period
+  *         from now
+  * @param  task: handle from Scheduler_Add()
+  * @param  periodMs: run period, 0 to run on every pass
+  * @retval None
+  */
+void Scheduler_SetPeriod(uint8_t task, uint32_t periodMs)
+{
+  if ((task < taskCount) && (tasks[task].periodMs != periodMs))
+  {
+    tasks[task].periodMs = periodMs;
+    tasks[task].nextMs = HAL_GetTick() + periodMs;
+    Watchdog_SetPeriod(tasks[task].watchdogId, periodMs);
+  }
+}
+
+/**
+  * @brief  For tasks that are streaming frames: the next idle ends at the
+  *         first interrupt (a transmit mailbox emptying, at the latest the
+  *         next SysTick), and no Stop mode for SCHEDULER_CAN_AWAKE_MS
+  * @retval None
+  */
+void Scheduler_KeepAwake(void)
+{
+  keepAwake = 1;
+#if SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP
+  awakeUntil = HAL_GetTick() + SCHEDULER_CAN_AWAKE_MS;
+#endif
+}
+
+/**
+  * @brief  Runs every task that is due, then idles until the next deadline
+  *         or until a frame is received. Call from the main loop.
+  * @retval None
+  */
+void Scheduler_Poll(void)
+{
+  uint32_t now;
+  uint32_t wait = MAX_WAIT_MS;
+  uint8_t i;
+
+  schedulerStats.passes++;
+  for (i = 0; i < taskCount; i++)
+  {
+    Scheduler_Task *task = &tasks[i];
+
+    if (task->periodMs == 0U)
+    {
+      runTask(task);
+    }
+    else if (deadlineReached(task->nextMs))
+    {
+      runTask(task);
+      /* Fixed rate; after an overrun restart from now instead of catching up */
+      task->nextMs += task->periodMs;
+      if (deadlineReached(task->nextMs))
+      {
+        task->nextMs = HAL_GetTick() + task->periodMs;
+      }
+    }
+  }
+
+  Watchdog_Supervise();
+
+  now = HAL_GetTick();
+  for (i = 0; i < taskCount; i++)
+  {
+    if (tasks[i].periodMs != 0U)
+    {
+      int32_t left = (int32_t)(tasks[i].nextMs - now);
+
+      if (left <= 0)
+      {
+        return;
+      }
+      if ((uint32_t)left < wait)
+      {
+        wait = (uint32_t)left;
+      }
+    }
+  }
+  idle(now + wait);
+}
+
+/**
+  * @brief  Microsecond time base from uwTick and the SysTick counter
+  * @retval microseconds, wraps every 71.6 minutes (use differences)
+  */
+uint32_t Scheduler_Micros(void)
+{
+  uint32_t ms;
+  uint32_t val;
+  uint32_t pending;
+  uint32_t load = SysTick->LOAD + 1U;
+
+  do
+  {
+    ms = uwTick;
+    val = SysTick->VAL;
+    pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+  } while ((ms != uwTick) || (SysTick->VAL > val));
+
+  /* Counter reloaded but the SysTick handler has not run yet, however long
+   * interrupts have been masked; no reload between the reads, so val is
+   * from after it */
+  if (pending != 0U)
+  {
+    ms++;
+  }
+  return (ms * 1000U) + (((load - 1U - val) * 1000U) / load);
+}
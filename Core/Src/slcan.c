@@ -0,0 +1,791 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : slcan.c
+  * @brief          : SLCAN (LAWICEL) adapter mode on USART3 (see slcan.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * A fully loaded 1 Mbit/s bus carries about 9000 frames/s, 8-byte
+  * standard frames, or 7600 extended ones: 27 and 31 characters each with
+  * time stamps, some 240 kB/s, so the link needs 2.4 Mbaud and runs at 4.
+  * The service pass encodes whatever the RX queue holds straight into a
+  * ring, and DMA1 channel 2 sends the ring a contiguous run at a time,
+  * chaining the next run from its transfer-complete interrupt; the CPU
+  * never touches a character on the way out and the line idles only when
+  * the ring is empty. When the host reads slower than the bus delivers,
+  * frames wait in the RX queue rather than in the ring, and the queue's own
+  * drop counter turns into an e1o line.
+  *
+  * Host characters arrive through DMA1 channel 3 into a circular buffer;
+  * the half and full transfer interrupts and the USART3 idle line interrupt
+  * only wake the scheduler, which reads the buffer up to the DMA position.
+  * DMA cannot reach CCMRAM, so the buffers are in SRAM.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "slcan.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SLCAN_LOST_LINE         "e1o\r"
+#define SLCAN_LOST_LENGTH       4U
+#define SLCAN_BIT_TQ            8U    /* 1 + BS1 3 + BS2 4, as MX_CAN_Init() */
+#define SLCAN_BRP_MAX           1024U
+
+/* Private variables ---------------------------------------------------------*/
+static const char hexDigits[16] = "0123456789ABCDEF";
+
+/* Sn bit rates; the prescaler comes from PCLK1 */
+static const uint32_t bitrates[9] = {10000, 20000, 50000, 100000, 125000, 250000, 500000, 800000, 1000000};
+
+/* Private functions ---------------------------------------------------------*/
+static char *putHex(char *p, uint32_t value, uint32_t digits)
+{
+  while (digits-- != 0U)
+  {
+    *p++ = hexDigits[(value >> (4U * digits)) & 0x0FU];
+  }
+  return p;
+}
+
+static uint8_t getHex(const char *p, uint32_t digits, uint32_t *value)
+{
+  uint32_t v = 0;
+
+  while (digits-- != 0U)
+  {
+    char c = *p++;
+
+    if ((c >= '0') && (c <= '9'))
+    {
+      v = (v << 4) | (uint32_t)(c - '0');
+    }
+    else if ((c >= 'A') && (c <= 'F'))
+    {
+      v = (v << 4) | (uint32_t)(c - 'A' + 10);
+    }
+    else if ((c >= 'a') && (c <= 'f'))
+    {
+      v = (v << 4) | (uint32_t)(c - 'a' + 10);
+    }
+    else
+    {
+      return 0;
+    }
+  }
+  *value = v;
+  return 1;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Writes a frame as a t/T/r/R line
+  * @param  out: destination, SLCAN_FRAME_MAX bytes
+  * @param  frame: frame to encode, frame->time is the millisecond stamp
+  * @param  stamps: nonzero to append the stamp
+  * @retval characters written, CR included
+  */
+uint32_t Slcan_Encode(char *out, const CAN_Frame *frame, uint8_t stamps)
+{
+  char *p = out;
+  uint32_t dlc = (frame->dlc > 8U) ? 8U : frame->dlc;
+  uint8_t rtr = ((frame->id & CAN_FRAME_RTR) != 0U) ? 1U : 0U;
+  uint32_t i;
+
+  if ((frame->id & CAN_FRAME_EXT) != 0U)
+  {
+    *p++ = rtr ? 'R' : 'T';
+    p = putHex(p, frame->id & CAN_FRAME_ID_MASK, 8U);
+  }
+  else
+  {
+    *p++ = rtr ? 'r' : 't';
+    p = putHex(p, frame->id & 0x7FFU, 3U);
+  }
+  *p++ = (char)('0' + dlc);
+  if (!rtr)
+  {
+    for (i = 0; i < dlc; i++)
+    {
+      *p++ = hexDigits[frame->data[i] >> 4];
+      *p++ = hexDigits[frame->data[i] & 0x0FU];
+    }
+  }
+  if (stamps)
+  {
+    p = putHex(p, frame->time, 4U);
+  }
+  *p++ = '\r';
+
+  return (uint32_t)(p - out);
+}
+
+/**
+  * @brief  Encodes frames from a source until it is empty or the space left
+  *         could not hold the longest line
+  * @param  out: destination
+  * @param  space: bytes available at out
+  * @param  source: frame source, CAN_Receive() on the target
+  * @param  stamps: nonzero to append the stamps
+  * @param  frames: incremented per frame encoded
+  * @retval characters written
+  *
+  * A frame is only taken from the source when it fits, so nothing taken is
+  * ever lost here.
+  */
+uint32_t Slcan_EncodeBatch(char *out, uint32_t space, Slcan_Source source, uint8_t stamps, uint32_t *frames)
+{
+  uint32_t used = 0;
+  CAN_Frame frame;
+
+  while (((space - used) >= SLCAN_FRAME_MAX) && source(&frame))
+  {
+    used += Slcan_Encode(&out[used], &frame, stamps);
+    (*frames)++;
+  }
+  return used;
+}
+
+/**
+  * @brief  Parses a t/T/r/R line
+  * @param  line: line without the CR
+  * @param  length: characters in line
+  * @param  frame: the frame, time holds the stamp if there was one
+  * @param  stamped: set to 1 if four stamp digits followed the data
+  * @retval 1 if the line is a well-formed frame
+  */
+uint8_t Slcan_Decode(const char *line, uint32_t length, CAN_Frame *frame, uint8_t *stamped)
+{
+  uint32_t idDigits;
+  uint32_t value;
+  uint32_t dataDigits;
+  uint32_t i;
+  uint8_t rtr;
+
+  if (length == 0U)
+  {
+    return 0;
+  }
+  switch (line[0])
+  {
+    case 't': idDigits = 3U; rtr = 0U; break;
+    case 'T': idDigits = 8U; rtr = 0U; break;
+    case 'r': idDigits = 3U; rtr = 1U; break;
+    case 'R': idDigits = 8U; rtr = 1U; break;
+    default:
+      return 0;
+  }
+  if ((length < (2U + idDigits)) || !getHex(&line[1], idDigits, &value))
+  {
+    return 0;
+  }
+  if (idDigits == 3U)
+  {
+    if (value > 0x7FFU)
+    {
+      return 0;
+    }
+    frame->id = value;
+  }
+  else
+  {
+    if (value > CAN_FRAME_ID_MASK)
+    {
+      return 0;
+    }
+    frame->id = value | CAN_FRAME_EXT;
+  }
+  if (rtr)
+  {
+    frame->id |= CAN_FRAME_RTR;
+  }
+
+  if ((line[1U + idDigits] < '0') || (line[1U + idDigits] > '8'))
+  {
+    return 0;
+  }
+  frame->dlc = (uint8_t)(line[1U + idDigits] - '0');
+  dataDigits = rtr ? 0U : (2U * frame->dlc);
+  if ((length != (2U + idDigits + dataDigits)) && (length != (6U + idDigits + dataDigits)))
+  {
+    return 0;
+  }
+
+  frame->filter = 0;
+  frame->time = 0;
+  for (i = 0; i < 8U; i++)
+  {
+    frame->data[i] = 0;
+  }
+  for (i = 0; i < (dataDigits / 2U); i++)
+  {
+    if (!getHex(&line[2U + idDigits + (2U * i)], 2U, &value))
+    {
+      return 0;
+    }
+    frame->data[i] = (uint8_t)value;
+  }
+
+  *stamped = 0;
+  if (length == (6U + idDigits + dataDigits))
+  {
+    if (!getHex(&line[2U + idDigits + dataDigits], 4U, &value) || (value >= SLCAN_STAMP_WRAP))
+    {
+      return 0;
+    }
+    frame->time = (uint16_t)value;
+    *stamped = 1;
+  }
+  return 1;
+}
+
+/**
+  * @brief  Adds a received character to the line being assembled; LF is
+  *         ignored, so CR LF terminals work too
+  * @param  line: line state
+  * @param  c: character
+  * @retval 1 when c was the CR ending the line
+  */
+uint8_t Slcan_Accept(Slcan_Line *line, char c)
+{
+  if (line->complete)
+  {
+    line->length = 0;
+    line->overflow = 0;
+    line->complete = 0;
+  }
+  if (c == '\r')
+  {
+    line->complete = 1;
+    return 1;
+  }
+  if (c == '\n')
+  {
+    return 0;
+  }
+  if (line->length < (SLCAN_LINE_MAX - 1U))
+  {
+    line->text[line->length++] = c;
+  }
+  else
+  {
+    line->overflow = 1;
+  }
+  return 0;
+}
+
+/**
+  * @brief  Checks a command against the channel state and updates the state
+  * @param  state: channel state
+  * @param  line: command without the CR
+  * @param  length: characters in line
+  * @param  frame: the frame to transmit for SLCAN_SEND
+  * @retval SLCAN_x, what the caller does before Slcan_Reply()
+  */
+uint8_t Slcan_Command(Slcan_State *state, const char *line, uint32_t length, CAN_Frame *frame)
+{
+  uint8_t stamped;
+
+  if (length == 0U)
+  {
+    return SLCAN_OK;                /* a bare CR, slcand's line flush */
+  }
+  switch (line[0])
+  {
+    case 'S':
+      if ((length != 2U) || (state->mode != SLCAN_CLOSED) || (line[1] < '0') || (line[1] > '8') ||
+          (Slcan_Prescaler((uint8_t)(line[1] - '0'), state->pclk1) == 0U))
+      {
+        return SLCAN_ERROR;
+      }
+      state->bitrate = (uint8_t)(line[1] - '0');
+      return SLCAN_OK;
+
+    case 'O':
+    case 'L':
+      if ((length != 1U) || (state->mode != SLCAN_CLOSED))
+      {
+        return SLCAN_ERROR;
+      }
+      state->mode = (line[0] == 'O') ? SLCAN_OPEN : SLCAN_LISTEN;
+      return SLCAN_APPLY;
+
+    case 'C':
+      if ((length != 1U) || (state->mode == SLCAN_CLOSED))
+      {
+        return SLCAN_ERROR;
+      }
+      state->mode = SLCAN_CLOSED;
+      return SLCAN_APPLY;
+
+    case 't':
+    case 'T':
+    case 'r':
+    case 'R':
+      if ((state->mode != SLCAN_OPEN) || !Slcan_Decode(line, length, frame, &stamped) || stamped)
+      {
+        return SLCAN_ERROR;
+      }
+      return SLCAN_SEND;
+
+    case 'Z':
+      if ((length != 2U) || (state->mode != SLCAN_CLOSED) || ((line[1] != '0') && (line[1] != '1')))
+      {
+        return SLCAN_ERROR;
+      }
+      state->stamps = (uint8_t)(line[1] - '0');
+      return SLCAN_OK;
+
+    case 'F':
+      return ((length == 1U) && (state->mode != SLCAN_CLOSED)) ? SLCAN_STATUS : SLCAN_ERROR;
+
+    case 'V':
+      return (length == 1U) ? SLCAN_VERSION : SLCAN_ERROR;
+
+    case 'N':
+      return (length == 1U) ? SLCAN_SERIAL : SLCAN_ERROR;
+
+    default:
+      return SLCAN_ERROR;
+  }
+}
+
+/**
+  * @brief  Writes the answer to a command
+  * @param  out: destination, SLCAN_REPLY_MAX bytes
+  * @param  result: Slcan_Command() result, SLCAN_ERROR if the caller failed
+  * @param  frame: the frame sent for SLCAN_SEND
+  * @param  flags: status flags for SLCAN_STATUS
+  * @retval characters written
+  */
+uint32_t Slcan_Reply(char *out, uint8_t result, const CAN_Frame *frame, uint8_t flags)
+{
+  const char *text;
+  uint32_t length = 0;
+
+  switch (result)
+  {
+    case SLCAN_SEND:
+      out[0] = ((frame->id & CAN_FRAME_EXT) != 0U) ? 'Z' : 'z';
+      out[1] = '\r';
+      return 2U;
+    case SLCAN_STATUS:
+      out[0] = 'F';
+      (void)putHex(&out[1], flags, 2U);
+      out[3] = '\r';
+      return 4U;
+    case SLCAN_VERSION: text = "V0101\r"; break;
+    case SLCAN_SERIAL: text = "NF334\r"; break;
+    case SLCAN_ERROR: text = "\a"; break;
+    default: text = "\r"; break;
+  }
+  while (text[length] != '\0')
+  {
+    out[length] = text[length];
+    length++;
+  }
+  return length;
+}
+
+/**
+  * @brief  bxCAN prescaler for an Sn bit rate
+  * @param  bitrate: n of Sn
+  * @param  pclk1: bxCAN clock in Hz, HAL_RCC_GetPCLK1Freq()
+  * @retval prescaler, 0 if the rate is not available
+  */
+uint16_t Slcan_Prescaler(uint8_t bitrate, uint32_t pclk1)
+{
+  uint32_t tq;
+
+  if (bitrate >= 9U)
+  {
+    return 0U;
+  }
+  tq = bitrates[bitrate] * SLCAN_BIT_TQ;
+  if (((pclk1 % tq) != 0U) || ((pclk1 / tq) == 0U) || ((pclk1 / tq) > SLCAN_BRP_MAX))
+  {
+    return 0U;
+  }
+  return (uint16_t)(pclk1 / tq);
+}
+
+#ifndef BOOT_HOST
+#include "scheduler.h"
+
+#if SLCAN_ENABLE && (SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP)
+#error "Stop mode halts USART3, build SLCAN=1 with IDLE_MODE 0 or 1"
+#endif
+#if SLCAN_BAUD > 4000000UL
+#error "USART3 runs from PCLK1 (32 MHz) and reaches 4 Mbaud with 8x oversampling"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+Slcan_Stats slcanStats;
+
+static Slcan_State state;
+static Slcan_Line line;
+
+/* Ring with a frame of slack behind it: a batch may run past the end and
+   the overhang is copied to the start before it is published */
+static char txRing[SLCAN_TX_RING + SLCAN_FRAME_MAX];
+static volatile uint32_t txHead;    // written by the service task
+static volatile uint32_t txTail;    // written by Slcan_TxDma_IRQ
+static volatile uint32_t txBusy;    // bytes of the transfer under way, 0 idle
+
+static char rxDma[SLCAN_RX_DMA];
+static volatile uint32_t rxHalves;  // half transfers completed, Slcan_RxDma_IRQ
+static uint32_t rxRead;             // characters taken, runs freely
+
+static uint32_t droppedSeen;        // canStats counters already reported
+static uint32_t overrunsSeen;
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t txFree(void)
+{
+  return SLCAN_TX_RING - (txHead - txTail);
+}
+
+/* Starts DMA on the next contiguous run of the ring; IRQs masked or in the
+   transfer-complete interrupt */
+static void txStart(void)
+{
+  uint32_t offset = txTail & (SLCAN_TX_RING - 1U);
+  uint32_t count = txHead - txTail;
+
+  if (count > (SLCAN_TX_RING - offset))
+  {
+    count = SLCAN_TX_RING - offset;
+  }
+  txBusy = count;
+  if (count == 0U)
+  {
+    return;
+  }
+  DMA1_Channel2->CCR &= ~DMA_CCR_EN;
+  DMA1_Channel2->CMAR = (uint32_t)(uintptr_t)&txRing[offset];
+  DMA1_Channel2->CNDTR = count;
+  DMA1_Channel2->CCR |= DMA_CCR_EN;
+  slcanStats.batches++;
+}
+
+static void txKick(void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (txBusy == 0U)
+  {
+    txStart();
+  }
+  __set_PRIMASK(primask);
+}
+
+/* Publishes length bytes written at the head, moving any overhang */
+static void txCommit(uint32_t length)
+{
+  uint32_t offset = txHead & (SLCAN_TX_RING - 1U);
+  uint32_t i;
+
+  for (i = SLCAN_TX_RING; i < (offset + length); i++)
+  {
+    txRing[i - SLCAN_TX_RING] = txRing[i];
+  }
+  txHead += length;
+  slcanStats.bytesOut += length;
+}
+
+static void txPut(const char *text, uint32_t length)
+{
+  uint32_t i;
+
+  for (i = 0; i < length; i++)
+  {
+    txRing[(txHead & (SLCAN_TX_RING - 1U)) + i] = text[i];
+  }
+  txCommit(length);
+}
+
+/* Takes the channel state to bxCAN: closed is initialisation mode */
+static void canApply(void)
+{
+  CAN_Frame frame;
+
+  (void)HAL_CAN_Stop(&hcan);
+  while (CAN_Receive(&frame))
+  {
+  }
+  if (state.mode == SLCAN_CLOSED)
+  {
+    return;
+  }
+
+  hcan.Instance->BTR = (hcan.Instance->BTR & ~(CAN_BTR_BRP | CAN_BTR_SILM)) |
+                       (uint32_t)(Slcan_Prescaler(state.bitrate, state.pclk1) - 1U) |
+                       ((state.mode == SLCAN_LISTEN) ? CAN_BTR_SILM : 0U);
+  droppedSeen = canStats.rxDropped;
+  overrunsSeen = canStats.rxOverruns;
+  (void)HAL_CAN_Start(&hcan);
+}
+
+static void execute(void)
+{
+  CAN_Frame frame = {0};
+  char reply[SLCAN_REPLY_MAX];
+  uint8_t result = SLCAN_ERROR;
+
+  if (!line.overflow)
+  {
+    result = Slcan_Command(&state, line.text, line.length, &frame);
+  }
+  if (result == SLCAN_APPLY)
+  {
+    canApply();
+  }
+  else if (result == SLCAN_SEND)
+  {
+    if (CAN_TransmitFrame(&frame) == HAL_OK)
+    {
+      slcanStats.framesIn++;
+    }
+    else
+    {
+      state.flags |= SLCAN_FLAG_TX_FULL;
+      result = SLCAN_ERROR;
+    }
+  }
+
+  slcanStats.commands++;
+  if (result == SLCAN_ERROR)
+  {
+    slcanStats.refused++;
+  }
+  txPut(reply, Slcan_Reply(reply, result, &frame, state.flags));
+  if (result == SLCAN_STATUS)
+  {
+    state.flags = 0;
+  }
+}
+
+/* Reads host characters up to the DMA position, a command at a time while
+   the ring has room for the answer */
+static void rxService(void)
+{
+  uint32_t halves;
+  uint32_t remaining;
+  uint32_t received;
+
+  do
+  {
+    halves = rxHalves;
+    remaining = DMA1_Channel3->CNDTR;
+  } while (halves != rxHalves);
+
+  /* An interrupt still pending at the boundary reads half a buffer short,
+     which the next pass makes up */
+  received = (halves * (SLCAN_RX_DMA / 2U)) + ((SLCAN_RX_DMA - remaining) % (SLCAN_RX_DMA / 2U));
+  if ((int32_t)(received - rxRead) <= 0)
+  {
+    return;
+  }
+  if ((received - rxRead) > SLCAN_RX_DMA)
+  {
+    slcanStats.rxOverruns++;        /* lapped: what is left is not one stream */
+    rxRead = received;
+    line.complete = 0;
+    line.overflow = 1;
+    return;
+  }
+
+  while ((rxRead != received) && (txFree() >= SLCAN_REPLY_MAX))
+  {
+    if (Slcan_Accept(&line, rxDma[rxRead & (SLCAN_RX_DMA - 1U)]))
+    {
+      execute();
+    }
+    rxRead++;
+  }
+}
+
+/* Status flags from the bxCAN error state and the lost frame counters */
+static uint8_t lostFrames(void)
+{
+  uint32_t esr = hcan.Instance->ESR;
+  uint32_t dropped = canStats.rxDropped;
+  uint32_t overruns = canStats.rxOverruns;
+  uint8_t lost = 0;
+
+  if ((esr & CAN_ESR_EWGF) != 0U)
+  {
+    state.flags |= SLCAN_FLAG_WARNING;
+  }
+  if ((esr & CAN_ESR_EPVF) != 0U)
+  {
+    state.flags |= SLCAN_FLAG_PASSIVE;
+  }
+  if ((esr & (CAN_ESR_BOFF | CAN_ESR_LEC)) != 0U)
+  {
+    state.flags |= SLCAN_FLAG_BUS_ERROR;
+  }
+  if (dropped != droppedSeen)
+  {
+    state.flags |= SLCAN_FLAG_RX_FULL;
+    lost = 1;
+  }
+  if (overruns != overrunsSeen)
+  {
+    state.flags |= SLCAN_FLAG_OVERRUN;
+    lost = 1;
+  }
+  droppedSeen = dropped;
+  overrunsSeen = overruns;
+
+  return lost;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Sets up USART3 and its DMA channels and closes the channel;
+  *         call after MX_GPIO_Init() and MX_CAN_Init()
+  * @retval None
+  */
+void Slcan_Init(void)
+{
+  uint32_t div;
+
+  __HAL_RCC_USART3_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* 8x oversampling: USARTDIV = 2 * PCLK1 / baud, BRR[3:0] = USARTDIV[3:0] / 2 */
+  div = ((2U * HAL_RCC_GetPCLK1Freq()) + (SLCAN_BAUD / 2U)) / SLCAN_BAUD;
+  USART3->CR1 = 0;
+  USART3->BRR = (div & ~0x0FU) | ((div & 0x0FU) >> 1);
+  USART3->CR3 = USART_CR3_DMAT | USART_CR3_DMAR | USART_CR3_EIE;
+
+  /* RX: circular, half and full transfer interrupts */
+  DMA1_Channel3->CPAR = (uint32_t)(uintptr_t)&USART3->RDR;
+  DMA1_Channel3->CMAR = (uint32_t)(uintptr_t)rxDma;
+  DMA1_Channel3->CNDTR = SLCAN_RX_DMA;
+  DMA1_Channel3->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_EN;
+
+  /* TX: memory to peripheral, a run per transfer */
+  DMA1_Channel2->CPAR = (uint32_t)(uintptr_t)&USART3->TDR;
+  DMA1_Channel2->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_TCIE;
+
+  USART3->CR1 = USART_CR1_OVER8 | USART_CR1_IDLEIE | USART_CR1_TE | USART_CR1_RE | USART_CR1_UE;
+
+  /* Below the CAN interrupts: frames into the queue come first */
+  HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 3, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+  HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 3, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+  HAL_NVIC_SetPriority(USART3_IRQn, 3, 0);
+  HAL_NVIC_EnableIRQ(USART3_IRQn);
+
+  /* An adapter starts closed, at 1 Mbit/s as MX_CAN_Init() */
+  state.pclk1 = HAL_RCC_GetPCLK1Freq();
+  state.bitrate = 8U;
+  state.mode = SLCAN_CLOSED;
+  canApply();
+}
+
+/**
+  * @brief  Service pass: host commands, then received frames into the ring,
+  *         then DMA if it is idle
+  * @retval 1 while frames or characters are still waiting
+  */
+uint8_t Slcan_Poll(void)
+{
+  rxService();
+
+  if (state.mode != SLCAN_CLOSED)
+  {
+    /* Counters only move on once the report fits */
+    if ((txFree() >= SLCAN_LOST_LENGTH) && lostFrames())
+    {
+      txPut(SLCAN_LOST_LINE, SLCAN_LOST_LENGTH);
+      slcanStats.lostReports++;
+    }
+
+    if (txFree() >= SLCAN_FRAME_MAX)
+    {
+      uint32_t offset = txHead & (SLCAN_TX_RING - 1U);
+      uint32_t space = txFree();
+      uint32_t frames = 0;
+      uint32_t used;
+
+      /* Stop within the slack, the overhang must land in free space */
+      if (space > (SLCAN_TX_RING - offset + SLCAN_FRAME_MAX))
+      {
+        space = SLCAN_TX_RING - offset + SLCAN_FRAME_MAX;
+      }
+      used = Slcan_EncodeBatch(&txRing[offset], space, CAN_Receive, state.stamps, &frames);
+
+      txCommit(used);
+      slcanStats.framesOut += frames;
+    }
+  }
+  txKick();
+
+  return (CAN_RxPending() || (txHead != txTail)) ? 1U : 0U;
+}
+
+/**
+  * @brief  DMA1 channel 2 interrupt body: a run has gone to USART3, the
+  *         next one starts at once
+  * @retval None
+  */
+void Slcan_TxDma_IRQ(void)
+{
+  if ((DMA1->ISR & DMA_ISR_TCIF2) != 0U)
+  {
+    DMA1->IFCR = DMA_IFCR_CGIF2;
+    txTail += txBusy;
+    txStart();
+  }
+}
+
+/**
+  * @brief  DMA1 channel 3 interrupt body: counts the half buffers received,
+  *         the wake-up does the rest
+  * @retval None
+  */
+void Slcan_RxDma_IRQ(void)
+{
+  uint32_t isr = DMA1->ISR & (DMA_ISR_HTIF3 | DMA_ISR_TCIF3);
+
+  /* Both flags at once: the interrupt was held off past a boundary */
+  if (isr != 0U)
+  {
+    DMA1->IFCR = isr;
+    rxHalves += ((isr & DMA_ISR_HTIF3) != 0U) ? 1U : 0U;
+    rxHalves += ((isr & DMA_ISR_TCIF3) != 0U) ? 1U : 0U;
+  }
+}
+
+/**
+  * @brief  USART3 interrupt body: the host has paused, wake the scheduler;
+  *         counts overruns, which stop DMA reception until cleared
+  * @retval None
+  */
+void Slcan_Uart_IRQ(void)
+{
+  if ((USART3->ISR & USART_ISR_ORE) != 0U)
+  {
+    slcanStats.rxOverruns++;
+  }
+  USART3->ICR = USART_ICR_IDLECF | USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NCF;
+}
+
+#endif /* BOOT_HOST */
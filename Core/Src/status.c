@@ -0,0 +1,277 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : status.c
+  * @brief          : Multiplexed status pages in the A1 frame (see status.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The page codec at the top has no HAL dependencies and is compiled into
+  * the host tools with BOOT_HOST. The rest runs from the A1 task: every run
+  * measures the loop, and each frame sent gathers only the fields of its
+  * own page.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "status.h"
+
+/* Private define ------------------------------------------------------------*/
+#define FIELD_MASK(bits)        ((1ULL << (bits)) - 1ULL)
+
+/* Private functions ---------------------------------------------------------*/
+static uint64_t put(uint64_t word, uint32_t pos, uint32_t bits, uint64_t value)
+{
+  return (word & ~(FIELD_MASK(bits) << pos)) | ((value & FIELD_MASK(bits)) << pos);
+}
+
+static uint64_t get(uint64_t word, uint32_t pos, uint32_t bits)
+{
+  return (word >> pos) & FIELD_MASK(bits);
+}
+
+static uint64_t saturate(uint64_t value, uint32_t bits)
+{
+  return (value > FIELD_MASK(bits)) ? FIELD_MASK(bits) : value;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Packs one page of a snapshot into an A1 frame
+  * @param  page: STATUS_PAGE_x
+  * @param  round: round counter, taken modulo STATUS_ROUNDS
+  * @param  status: fields; only those of the page are read
+  * @param  data: 8 bytes
+  * @retval None
+  */
+void Status_Pack(uint8_t page, uint8_t round, const Status_Snapshot *status, uint8_t *data)
+{
+  uint64_t word = ~0ULL;
+  uint32_t i;
+
+  word = put(word, 0, 4, page);
+  word = put(word, 4, 4, round);
+  switch (page)
+  {
+    case STATUS_PAGE_UPTIME:
+      word = put(word, 8, 40, status->uptimeMs);
+      word = put(word, 48, 16, status->periodMs);
+      break;
+    case STATUS_PAGE_TRAFFIC:
+      word = put(word, 8, 28, status->txFrames);
+      word = put(word, 36, 28, status->rxFrames);
+      break;
+    case STATUS_PAGE_ERRORS:
+      word = put(word, 8, 12, saturate(status->rxDropped, 12));
+      word = put(word, 20, 12, saturate(status->txDropped, 12));
+      word = put(word, 32, 8, saturate(status->rxOverruns, 8));
+      word = put(word, 40, 8, status->tec);
+      word = put(word, 48, 8, status->rec);
+      word = put(word, 56, 3, status->lec);
+      word = put(word, 59, 3, status->flags);
+      break;
+    case STATUS_PAGE_LOAD:
+      word = put(word, 8, 10, saturate(status->loadPermille, 10));
+      word = put(word, 18, 16, saturate(status->jitterUs, 16));
+      break;
+    default:
+      word = put(word, 8, 12, status->adc);
+      word = put(word, 20, 16, saturate(status->stackPeak, 16));
+      word = put(word, 36, 16, saturate(status->heapPeak, 16));
+      break;
+  }
+  for (i = 0; i < 8U; i++)
+  {
+    data[i] = (uint8_t)(word >> (8U * i));
+  }
+}
+
+/**
+  * @brief  Unpacks an A1 frame into the fields of its page
+  * @param  data: 8 bytes
+  * @param  round: destination for the round counter
+  * @param  status: destination; fields of other pages are left as they are
+  * @retval page, STATUS_PAGES if the frame is no status page (a page out of
+  *         range or reserved bits clear, e.g. the old DEADBEEF pattern)
+  */
+uint8_t Status_Unpack(const uint8_t *data, uint8_t *round, Status_Snapshot *status)
+{
+  uint64_t word = 0;
+  uint8_t page;
+  uint32_t i;
+
+  for (i = 0; i < 8U; i++)
+  {
+    word |= (uint64_t)data[i] << (8U * i);
+  }
+  page = (uint8_t)get(word, 0, 4);
+  *round = (uint8_t)get(word, 4, 4);
+  switch (page)
+  {
+    case STATUS_PAGE_UPTIME:
+      status->uptimeMs = get(word, 8, 40);
+      status->periodMs = (uint16_t)get(word, 48, 16);
+      break;
+    case STATUS_PAGE_TRAFFIC:
+      status->txFrames = (uint32_t)get(word, 8, 28);
+      status->rxFrames = (uint32_t)get(word, 36, 28);
+      break;
+    case STATUS_PAGE_ERRORS:
+      if (get(word, 62, 2) != 3U)
+      {
+        return STATUS_PAGES;
+      }
+      status->rxDropped = (uint32_t)get(word, 8, 12);
+      status->txDropped = (uint32_t)get(word, 20, 12);
+      status->rxOverruns = (uint32_t)get(word, 32, 8);
+      status->tec = (uint8_t)get(word, 40, 8);
+      status->rec = (uint8_t)get(word, 48, 8);
+      status->lec = (uint8_t)get(word, 56, 3);
+      status->flags = (uint8_t)get(word, 59, 3);
+      break;
+    case STATUS_PAGE_LOAD:
+      if (get(word, 34, 30) != FIELD_MASK(30))
+      {
+        return STATUS_PAGES;
+      }
+      status->loadPermille = (uint16_t)get(word, 8, 10);
+      status->jitterUs = (uint32_t)get(word, 18, 16);
+      break;
+    case STATUS_PAGE_MEMORY:
+      if (get(word, 52, 12) != FIELD_MASK(12))
+      {
+        return STATUS_PAGES;
+      }
+      status->adc = (uint16_t)get(word, 8, 12);
+      status->stackPeak = (uint32_t)get(word, 20, 16);
+      status->heapPeak = (uint32_t)get(word, 36, 16);
+      break;
+    default:
+      return STATUS_PAGES;
+  }
+  return page;
+}
+
+#ifndef BOOT_HOST
+#include "can.h"
+#include "cpu.h"
+#include "params.h"
+#include "ram.h"
+#include "scheduler.h"
+#include "temperature.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t page;
+static uint8_t round;
+
+static uint64_t uptimeMs;
+static uint32_t lastTick;
+
+static uint8_t loopStarted;
+static uint32_t lastLoopUs;
+static uint32_t jitterUs;       // since the last LOAD page
+
+static uint64_t loadStartTotal;     // cpuStats at the last LOAD page
+static uint64_t loadStartSpare;
+
+/**
+  * @brief  Measures the loop; call on every run of the A1 task, whether a
+  *         frame is sent or not
+  * @retval None
+  */
+void Status_Tick(void)
+{
+  uint32_t now = Scheduler_Micros();
+  uint32_t tick = HAL_GetTick();
+  uint32_t periodUs = Params_Get(PARAM_A1_PERIOD_MS) * 1000U;
+  uint32_t interval;
+  uint32_t deviation;
+
+  uptimeMs += tick - lastTick;
+  lastTick = tick;
+
+  if (loopStarted != 0U)
+  {
+    interval = now - lastLoopUs;
+    deviation = (interval > periodUs) ? (interval - periodUs) : (periodUs - interval);
+    if (deviation > jitterUs)
+    {
+      jitterUs = deviation;
+    }
+  }
+  else
+  {
+    loopStarted = 1;
+  }
+  lastLoopUs = now;
+}
+
+/**
+  * @brief  Fills the next status page
+  * @param  data: 8 bytes of the A1 frame
+  * @retval None
+  */
+void Status_Next(uint8_t *data)
+{
+  Status_Snapshot status = { 0 };
+  uint32_t esr = hcan.Instance->ESR;
+  uint64_t total;
+  uint64_t spare;
+
+  switch (page)
+  {
+    case STATUS_PAGE_UPTIME:
+      status.uptimeMs = uptimeMs;
+      status.periodMs = (uint16_t)Params_Get(PARAM_A1_PERIOD_MS);
+      break;
+    case STATUS_PAGE_TRAFFIC:
+      status.txFrames = canStats.txFrames;
+      status.rxFrames = canStats.rxFrames;
+      break;
+    case STATUS_PAGE_ERRORS:
+      status.rxDropped = canStats.rxDropped;
+      status.txDropped = canStats.txDropped;
+      status.rxOverruns = canStats.rxOverruns;
+      status.tec = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+      status.rec = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+      status.lec = (uint8_t)((esr & CAN_ESR_LEC) >> CAN_ESR_LEC_Pos);
+      status.flags = (uint8_t)((((esr & CAN_ESR_EWGF) != 0U) ? STATUS_FLAG_EWGF : 0U) |
+                               (((esr & CAN_ESR_EPVF) != 0U) ? STATUS_FLAG_EPVF : 0U) |
+                               (((esr & CAN_ESR_BOFF) != 0U) ? STATUS_FLAG_BOFF : 0U));
+      break;
+    case STATUS_PAGE_LOAD:
+      Cpu_Update();
+      total = cpuStats.totalCycles - loadStartTotal;
+      spare = (cpuStats.idleCycles + cpuStats.stopCycles) - loadStartSpare;
+      status.loadPermille = (total == 0U) ? 0U : (spare >= total) ? 0U :
+                            (uint16_t)(((total - spare) * 1000U) / total);
+      status.jitterUs = jitterUs;
+      loadStartTotal = cpuStats.totalCycles;
+      loadStartSpare = cpuStats.idleCycles + cpuStats.stopCycles;
+      jitterUs = 0;
+      break;
+    default:
+      status.adc = Temperature_LastADC();
+      status.stackPeak = ramStats.stackPeak;
+      status.heapPeak = ramStats.heapPeak;
+      break;
+  }
+  Status_Pack(page, round, &status, data);
+
+  if (++page == STATUS_PAGES)
+  {
+    page = 0;
+    round = (uint8_t)((round + 1U) % STATUS_ROUNDS);
+  }
+}
+#endif /* BOOT_HOST */
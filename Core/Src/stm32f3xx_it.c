@@ -22,6 +22,14 @@
 #include "stm32f3xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "can.h"
+#include "rtc.h"
+#include "crash.h"
+#include "slcan.h"
+#include "stress.h"
+#include "monitor.h"
+#include "cpu.h"
+#include "alarm.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -46,7 +54,11 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
-
+/* The fault handlers read the exception frame before anything is pushed */
+void HardFault_Handler(void) CRASH_NAKED;
+void MemManage_Handler(void) CRASH_NAKED;
+void BusFault_Handler(void) CRASH_NAKED;
+void UsageFault_Handler(void) CRASH_NAKED;
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -84,7 +96,7 @@ void NMI_Handler(void)
 void HardFault_Handler(void)
 {
   /* USER CODE BEGIN HardFault_IRQn 0 */
-
+  CRASH_FAULT_ENTRY(CRASH_KIND_HARDFAULT); // Saves a crash report and resets
   /* USER CODE END HardFault_IRQn 0 */
   while (1)
   {
@@ -99,7 +111,7 @@ void HardFault_Handler(void)
 void MemManage_Handler(void)
 {
   /* USER CODE BEGIN MemoryManagement_IRQn 0 */
-
+  CRASH_FAULT_ENTRY(CRASH_KIND_MEMMANAGE); // Saves a crash report and resets
   /* USER CODE END MemoryManagement_IRQn 0 */
   while (1)
   {
@@ -114,7 +126,7 @@ void MemManage_Handler(void)
 void BusFault_Handler(void)
 {
   /* USER CODE BEGIN BusFault_IRQn 0 */
-
+  CRASH_FAULT_ENTRY(CRASH_KIND_BUSFAULT); // Saves a crash report and resets
   /* USER CODE END BusFault_IRQn 0 */
   while (1)
   {
@@ -129,7 +141,7 @@ void BusFault_Handler(void)
 void UsageFault_Handler(void)
 {
   /* USER CODE BEGIN UsageFault_IRQn 0 */
-
+  CRASH_FAULT_ENTRY(CRASH_KIND_USAGEFAULT); // Saves a crash report and resets
   /* USER CODE END UsageFault_IRQn 0 */
   while (1)
   {
@@ -183,11 +195,14 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
+  Cpu_Section cpu;
 
+  Cpu_Enter(&cpu);
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  Stress_Tick();
+  Cpu_Exit(&cpu, CPU_SRC_SYSTICK);
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -200,4 +215,114 @@ void SysTick_Handler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles CAN RX0 interrupt.
+  */
+CCMRAM_FUNC void CAN_RX0_IRQHandler(void)
+{
+  Cpu_Section cpu;
+
+  Cpu_Enter(&cpu);
+  CAN_RxFifo0_IRQ();
+  Cpu_Exit(&cpu, CPU_SRC_CAN_RX);
+}
+
+/**
+  * @brief This function handles CAN TX interrupt.
+  */
+CCMRAM_FUNC void CAN_TX_IRQHandler(void)
+{
+  Cpu_Section cpu;
+
+  Cpu_Enter(&cpu);
+  CAN_TxMailbox_IRQ();
+  Cpu_Exit(&cpu, CPU_SRC_CAN_TX);
+}
+
+/**
+  * @brief This function handles CAN SCE interrupt (errors, bus monitor).
+  */
+void CAN_SCE_IRQHandler(void)
+{
+  Cpu_Section cpu;
+
+  Cpu_Enter(&cpu);
+  Monitor_Error_IRQ();
+  Cpu_Exit(&cpu, CPU_SRC_CAN_SCE);
+}
+
+/**
+  * @brief This function handles RTC wake-up interrupt through EXTI line 20.
+  */
+void RTC_WKUP_IRQHandler(void)
+{
+  Cpu_Section cpu;
+
+  Cpu_Enter(&cpu);
+  HAL_RTCEx_WakeUpTimerIRQHandler(&hrtc);
+  Cpu_Exit(&cpu, CPU_SRC_OTHER);
+}
+
+/**
+  * @brief This function handles EXTI line[15:10] interrupts (CAN_RX edge).
+  */
+void EXTI15_10_IRQHandler(void)
+{
+  Cpu_Section cpu;
+
+  Cpu_Enter(&cpu);
+  HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_11);
+  Cpu_Exit(&cpu, CPU_SRC_OTHER);
+}
+
+/**
+  * @brief This function handles ADC1 and ADC2 interrupts (analog watchdog 1).
+  */
+void ADC1_2_IRQHandler(void)
+{
+  Cpu_Section cpu;
+
+  Cpu_Enter(&cpu);
+  Alarm_IRQ();
+  Cpu_Exit(&cpu, CPU_SRC_OTHER);
+}
+
+#if SLCAN_ENABLE
+/**
+  * @brief This function handles DMA1 channel2 global interrupt (USART3_TX).
+  */
+void DMA1_Channel2_IRQHandler(void)
+{
+  Cpu_Section cpu;
+
+  Cpu_Enter(&cpu);
+  Slcan_TxDma_IRQ();
+  Cpu_Exit(&cpu, CPU_SRC_OTHER);
+}
+
+/**
+  * @brief This function handles DMA1 channel3 global interrupt (USART3_RX).
+  */
+void DMA1_Channel3_IRQHandler(void)
+{
+  Cpu_Section cpu;
+
+  Cpu_Enter(&cpu);
+  Slcan_RxDma_IRQ();
+  Cpu_Exit(&cpu, CPU_SRC_OTHER);
+}
+
+/**
+  * @brief This function handles USART3 global interrupt.
+  */
+void USART3_IRQHandler(void)
+{
+  Cpu_Section cpu;
+
+  Cpu_Enter(&cpu);
+  Slcan_Uart_IRQ();
+  Cpu_Exit(&cpu, CPU_SRC_OTHER);
+}
+#endif
+
 /* USER CODE END 1 */
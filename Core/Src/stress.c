@@ -0,0 +1,515 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : stress.c
+  * @brief          : Bus-stress traffic generator (see stress.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Stress_Next() runs in the CAN TX interrupt, once per frame: it serialises
+  * the frame bit by bit for the CRC and the stuff bits, about 130 steps for
+  * an 8-byte frame. Credit is kept in 1e-8 bit times so that a millisecond
+  * at 1 Mbit/s and 100 % is an exact integer.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stress.h"
+#include "boot.h"
+#include "scheduler.h"
+#include "monitor.h"
+
+/* Private define ------------------------------------------------------------*/
+#define STRESS_CREDIT_PER_BIT   100000000LL   /* 100 % x 1e6 us */
+#define STRESS_ID_MAX_STD       0x7FFUL
+#define STRESS_PRBS_SEED        0x7FFFU
+#define STRESS_TICK_US          1000      /* SysTick, Stress_Tick() */
+
+/* Private variables ---------------------------------------------------------*/
+Stress_Stats stressStats;
+
+static struct
+{
+  uint8_t load;           /* % of the bit rate */
+  uint8_t burst;          /* frames per burst */
+  uint8_t flags;          /* STRESS_PATTERN_x, STRESS_RANDOM_x */
+  uint8_t dlcMin;
+  uint8_t dlcMax;
+  uint32_t firstId;       /* identifier | CAN_FRAME_EXT */
+  uint32_t idCount;
+} config = { 100U, 1U, STRESS_PATTERN_COUNTER, 8U, 8U, STRESS_DEFAULT_ID, 1U };
+
+static volatile uint8_t running;
+static uint32_t bitrate;
+static int64_t credit;
+static uint32_t lastUs;
+static uint32_t meanBits;         /* frame cost, 16 x running mean, sizes a burst */
+static uint32_t remaining;        /* frames left in the current burst */
+static uint32_t startTick;
+static uint16_t sequence;
+static uint32_t idIndex;
+static uint8_t dlcNext;
+static uint8_t counter;
+static uint16_t prbs = STRESS_PRBS_SEED;
+static uint32_t rng = 1U;
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t nextRandom(void)
+{
+  /* xorshift32 */
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static uint8_t prbsByte(void)
+{
+  uint8_t value = 0;
+  uint32_t i;
+
+  for (i = 0; i < 8U; i++)
+  {
+    uint16_t bit = (uint16_t)(((prbs >> 14) ^ (prbs >> 13)) & 1U);
+
+    prbs = (uint16_t)(((prbs << 1) | bit) & 0x7FFFU);
+    value = (uint8_t)((value << 1) | bit);
+  }
+  return value;
+}
+
+/* Appends width bits of value, MSB first */
+static uint32_t pushBits(uint8_t *bits, uint32_t n, uint32_t value, uint32_t width)
+{
+  while (width > 0U)
+  {
+    width--;
+    bits[n++] = (uint8_t)((value >> width) & 1U);
+  }
+  return n;
+}
+
+/* SOF, arbitration and control field */
+static uint32_t pushHeader(uint8_t *bits, const CAN_Frame *frame)
+{
+  uint32_t rtr = ((frame->id & CAN_FRAME_RTR) != 0U) ? 1U : 0U;
+  uint32_t n = pushBits(bits, 0, 0U, 1U);
+
+  if ((frame->id & CAN_FRAME_EXT) != 0U)
+  {
+    n = pushBits(bits, n, (frame->id >> 18) & 0x7FFU, 11U);
+    n = pushBits(bits, n, 3U, 2U);                      /* SRR, IDE */
+    n = pushBits(bits, n, frame->id & 0x3FFFFU, 18U);
+    n = pushBits(bits, n, rtr, 1U);
+    n = pushBits(bits, n, 0U, 2U);                      /* r1, r0 */
+  }
+  else
+  {
+    n = pushBits(bits, n, frame->id & 0x7FFU, 11U);
+    n = pushBits(bits, n, rtr, 1U);
+    n = pushBits(bits, n, 0U, 2U);                      /* IDE, r0 */
+  }
+  return pushBits(bits, n, frame->dlc, 4U);
+}
+
+/* Fills data[from..dlc-1] so that a stuff bit follows every four bits */
+static void stuffPattern(CAN_Frame *frame, uint32_t from)
+{
+  uint8_t bits[128];
+  uint32_t n = pushHeader(bits, frame);
+  uint32_t i;
+  uint8_t last;
+  uint32_t run = 1;
+  uint32_t left;
+
+  for (i = 0; i < from; i++)
+  {
+    n = pushBits(bits, n, frame->data[i], 8U);
+  }
+  /* Stuff state at the end of the header, as on the wire */
+  last = bits[0];
+  for (i = 1; i < n; i++)
+  {
+    if (bits[i] != last)
+    {
+      last = bits[i];
+      run = 1;
+    }
+    else if (++run == 5U)
+    {
+      last ^= 1U;
+      run = 1;
+    }
+  }
+
+  /* Complete the run, then runs of four after each stuff bit */
+  left = 5U - run;
+  for (i = from; i < frame->dlc; i++)
+  {
+    uint32_t b;
+    uint8_t value = 0;
+
+    for (b = 0; b < 8U; b++)
+    {
+      value = (uint8_t)((value << 1) | last);
+      if (--left == 0U)
+      {
+        last ^= 1U;
+        left = 4U;
+      }
+    }
+    frame->data[i] = value;
+  }
+}
+
+static void buildFrame(CAN_Frame *frame)
+{
+  uint32_t stamp = Scheduler_Micros();
+  uint32_t i;
+
+  if ((config.flags & STRESS_RANDOM_ID) != 0U)
+  {
+    idIndex = nextRandom() % config.idCount;
+  }
+  else if (++idIndex >= config.idCount)
+  {
+    idIndex = 0;
+  }
+  frame->id = config.firstId + idIndex;
+  frame->filter = 0;
+  frame->time = 0;
+
+  if ((config.flags & STRESS_RANDOM_DLC) != 0U)
+  {
+    frame->dlc = (uint8_t)(config.dlcMin + (nextRandom() % (uint32_t)(config.dlcMax - config.dlcMin + 1U)));
+  }
+  else
+  {
+    frame->dlc = dlcNext;
+    dlcNext = (dlcNext >= config.dlcMax) ? config.dlcMin : (uint8_t)(dlcNext + 1U);
+  }
+
+  frame->data[0] = (uint8_t)sequence;
+  frame->data[1] = (uint8_t)(sequence >> 8);
+  frame->data[2] = (uint8_t)stamp;
+  frame->data[3] = (uint8_t)(stamp >> 8);
+  sequence++;
+
+  if ((config.flags & STRESS_PATTERN_MASK) == STRESS_PATTERN_STUFF)
+  {
+    stuffPattern(frame, (frame->dlc < STRESS_HEADER_SIZE) ? frame->dlc : STRESS_HEADER_SIZE);
+  }
+  else
+  {
+    for (i = STRESS_HEADER_SIZE; i < frame->dlc; i++)
+    {
+      frame->data[i] = ((config.flags & STRESS_PATTERN_MASK) == STRESS_PATTERN_PRBS) ? prbsByte() : counter++;
+    }
+  }
+  for (i = frame->dlc; i < 8U; i++)
+  {
+    frame->data[i] = 0;
+  }
+}
+
+static uint32_t canBitrate(void)
+{
+  uint32_t tq = 1U + ((hcan.Init.TimeSeg1 >> CAN_BTR_TS1_Pos) + 1U) + ((hcan.Init.TimeSeg2 >> CAN_BTR_TS2_Pos) + 1U);
+
+  return HAL_RCC_GetPCLK1Freq() / (hcan.Init.Prescaler * tq);
+}
+
+/* Load achieved since STRESS_START, % of the bit rate */
+static uint8_t achievedLoad(void)
+{
+  uint32_t ms = HAL_GetTick() - startTick;
+  uint64_t load;
+
+  if ((ms == 0U) || (bitrate == 0U))
+  {
+    return 0;
+  }
+  load = (stressStats.bits * 100000ULL) / ((uint64_t)ms * bitrate);
+  return (load > 255U) ? 255U : (uint8_t)load;
+}
+
+static void start(void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  bitrate = canBitrate();
+  credit = 0;
+  lastUs = Scheduler_Micros();
+  meanBits = 0;
+  remaining = 0;
+  sequence = 0;
+  idIndex = config.idCount - 1U;
+  dlcNext = config.dlcMin;
+  stressStats.frames = 0;
+  stressStats.bursts = 0;
+  stressStats.clipped = 0;
+  stressStats.bits = 0;
+  startTick = HAL_GetTick();
+  /* Mailboxes in request order, so frames keep their sequence */
+  hcan.Instance->MCR |= CAN_MCR_TXFP;
+  running = 1;
+  __set_PRIMASK(primask);
+
+  HAL_NVIC_SetPendingIRQ(CAN_TX_IRQn);
+}
+
+static void stop(void)
+{
+  running = 0;
+  if (hcan.Init.TransmitFifoPriority == DISABLE)
+  {
+    hcan.Instance->MCR &= ~CAN_MCR_TXFP;
+  }
+}
+
+static void sendResponse(uint8_t requester, uint8_t command, uint8_t status)
+{
+  CAN_Frame response;
+  uint32_t i;
+
+  response.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, requester, BOOT_NODE_ADDRESS);
+  response.dlc = 8;
+  response.data[0] = command | BOOT_RSP;
+  response.data[1] = status;
+  for (i = 2; i < 8U; i++)
+  {
+    response.data[i] = 0xFF;
+  }
+  if ((command == STRESS_CMD_STOP) || (command == STRESS_CMD_STATUS))
+  {
+    response.data[2] = running;
+    response.data[3] = (uint8_t)stressStats.frames;
+    response.data[4] = (uint8_t)(stressStats.frames >> 8);
+    response.data[5] = (uint8_t)(stressStats.frames >> 16);
+    response.data[6] = (uint8_t)(stressStats.frames >> 24);
+    response.data[7] = achievedLoad();
+  }
+  (void)CAN_TransmitFrame(&response);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Tells whether the generator is running
+  * @retval 1 between STRESS_START and STRESS_STOP
+  */
+uint8_t Stress_Running(void)
+{
+  return running;
+}
+
+/**
+  * @brief  Makes the next frame if the bucket allows; call from the CAN TX
+  *         interrupt with a mailbox free and the TX queue empty
+  * @param  frame: destination
+  * @retval 1 if a frame was made, 0 if not running or not due yet
+  */
+uint8_t Stress_Next(CAN_Frame *frame)
+{
+  uint32_t now;
+  uint32_t bits;
+  int64_t limit;
+
+  if (!running)
+  {
+    return 0;
+  }
+
+  now = Scheduler_Micros();
+  credit += (int64_t)(now - lastUs) * (int64_t)bitrate * (int64_t)config.load;
+  lastUs = now;
+  limit = ((int64_t)config.burst * STRESS_FRAME_BITS_MAX * STRESS_CREDIT_PER_BIT) +
+          ((int64_t)STRESS_TICK_US * bitrate * config.load);
+  if (credit > limit)
+  {
+    credit = limit;
+    stressStats.clipped++;
+  }
+
+  if (remaining == 0U)
+  {
+    if (config.burst == 1U)
+    {
+      /* Two frames may be charged ahead: one on the wire, one waiting */
+      if (credit < -((int64_t)meanBits * (STRESS_CREDIT_PER_BIT / 16)))
+      {
+        return 0;
+      }
+    }
+    else if ((credit < ((int64_t)config.burst * meanBits * (STRESS_CREDIT_PER_BIT / 16))) ||
+             ((hcan.Instance->TSR & CAN_TSR_TME) != CAN_TSR_TME))
+    {
+      /* A burst waits for the one before to leave the mailboxes, otherwise
+       * it would run on from it */
+      return 0;
+    }
+    remaining = config.burst;
+    stressStats.bursts++;
+  }
+
+  buildFrame(frame);
+  bits = Stress_FrameBits(frame);
+  meanBits += bits - (meanBits / 16U);
+  credit -= (int64_t)bits * STRESS_CREDIT_PER_BIT;
+  remaining--;
+  stressStats.frames++;
+  stressStats.bits += bits;
+
+  return 1;
+}
+
+/**
+  * @brief  Restarts the generator after a pause; call from SysTick
+  * @retval None
+  */
+void Stress_Tick(void)
+{
+  if (running)
+  {
+    HAL_NVIC_SetPendingIRQ(CAN_TX_IRQn);
+  }
+}
+
+/**
+  * @brief  Handles STRESS_START, STRESS_IDS, STRESS_STOP and STRESS_STATUS
+  * @param  frame: received frame, anything else is ignored
+  * @retval None
+  */
+void Stress_HandleFrame(const CAN_Frame *frame)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  uint8_t requester = (uint8_t)BOOT_ID_SA(id);
+  uint8_t command = frame->data[0];
+  uint8_t status = BOOT_OK;
+
+  if (((frame->id & CAN_FRAME_EXT) == 0U) || (frame->dlc < 1U) ||
+      (BOOT_ID_PGN(id) != BOOT_PGN_CMD) || (BOOT_ID_DA(id) != BOOT_NODE_ADDRESS) ||
+      (command < STRESS_CMD_START) || (command > STRESS_CMD_STATUS))
+  {
+    return;
+  }
+
+  if (command == STRESS_CMD_START)
+  {
+    uint8_t dlcMin = frame->data[4] >> 4;
+    uint8_t dlcMax = frame->data[4] & 0x0FU;
+
+    if ((SCHEDULER_IDLE_MODE == SCHEDULER_IDLE_STOP) || Monitor_Silent())
+    {
+      status = BOOT_ERR_STATE;
+    }
+    else if ((frame->dlc < 5U) || (frame->data[1] == 0U) || (frame->data[1] > 100U) ||
+             (frame->data[2] == 0U) || ((frame->data[3] & STRESS_PATTERN_MASK) > STRESS_PATTERN_STUFF) ||
+             (dlcMin > dlcMax) || (dlcMax > 8U))
+    {
+      status = BOOT_ERR_RANGE;
+    }
+    else
+    {
+      stop();
+      config.load = frame->data[1];
+      config.burst = frame->data[2];
+      config.flags = frame->data[3];
+      config.dlcMin = dlcMin;
+      config.dlcMax = dlcMax;
+      start();
+    }
+  }
+  else if (command == STRESS_CMD_IDS)
+  {
+    uint32_t first = frame->data[1] | ((uint32_t)frame->data[2] << 8) |
+                     ((uint32_t)frame->data[3] << 16) | ((uint32_t)frame->data[4] << 24);
+    uint32_t count = frame->data[5] | ((uint32_t)frame->data[6] << 8) | ((uint32_t)frame->data[7] << 16);
+    uint32_t max = ((first & CAN_FRAME_EXT) != 0U) ? CAN_FRAME_ID_MASK : STRESS_ID_MAX_STD;
+
+    if (running)
+    {
+      status = BOOT_ERR_STATE;
+    }
+    else if ((frame->dlc < 8U) || (count == 0U) || ((first & ~CAN_FRAME_EXT) > max) ||
+             ((count - 1U) > (max - (first & ~CAN_FRAME_EXT))))
+    {
+      status = BOOT_ERR_RANGE;
+    }
+    else
+    {
+      config.firstId = first;
+      config.idCount = count;
+    }
+  }
+  else if (command == STRESS_CMD_STOP)
+  {
+    stop();
+  }
+  sendResponse(requester, command, status);
+}
+
+/**
+  * @brief  Length of a frame on the wire, stuff bits and interframe space
+  *         included
+  * @param  frame: frame to measure
+  * @retval bit times
+  */
+uint32_t Stress_FrameBits(const CAN_Frame *frame)
+{
+  uint8_t bits[128];
+  uint32_t n = pushHeader(bits, frame);
+  uint32_t crc = 0;
+  uint32_t stuff = 0;
+  uint32_t run = 1;
+  uint8_t last;
+  uint32_t i;
+
+  for (i = 0; ((frame->id & CAN_FRAME_RTR) == 0U) && (i < frame->dlc); i++)
+  {
+    n = pushBits(bits, n, frame->data[i], 8U);
+  }
+
+  /* CRC-15, polynomial 0x4599 */
+  for (i = 0; i < n; i++)
+  {
+    uint32_t next = bits[i] ^ ((crc >> 14) & 1U);
+
+    crc = (crc << 1) & 0x7FFFU;
+    if (next != 0U)
+    {
+      crc ^= 0x4599U;
+    }
+  }
+  n = pushBits(bits, n, crc, 15U);
+
+  /* A stuff bit follows every five equal bits and starts the next run */
+  last = bits[0];
+  for (i = 1; i < n; i++)
+  {
+    if (bits[i] != last)
+    {
+      last = bits[i];
+      run = 1;
+    }
+    else if (++run == 5U)
+    {
+      stuff++;
+      last ^= 1U;
+      run = 1;
+    }
+  }
+
+  /* CRC delimiter, ACK slot and delimiter, EOF, intermission */
+  return n + stuff + 1U + 2U + 7U + 3U;
+}
@@ -19,6 +19,12 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "temperature.h"
+#include "cpu.h"
+#include "filter.h"
+#include "trace.h"
+
+/* Last conversion, for the status pages (status.h) */
+static uint16_t lastAdc;
 
 /**
   * @brief  Reads raw ADC value from internal temperature sensor
@@ -27,7 +33,11 @@
 uint16_t Temperature_ReadADC(void)
 {
   uint16_t adcValue = 0;
+  Cpu_Section cpu;
   
+  /* The polled conversion is accounted like a handler (cpu.h) */
+  Cpu_Enter(&cpu);
+
   /* Start ADC conversion */
   if (HAL_ADC_Start(&hadc1) == HAL_OK)
   {
@@ -36,30 +46,45 @@ uint16_t Temperature_ReadADC(void)
     {
       /* Read the converted value */
       adcValue = (uint16_t)HAL_ADC_GetValue(&hadc1);
+      lastAdc = adcValue;
+      TRACE_EVENT(TRACE_EVT_ADC_DONE, 0, adcValue);
     }
     
     /* Stop ADC */
     HAL_ADC_Stop(&hadc1);
   }
+  Cpu_Exit(&cpu, CPU_SRC_ADC);
   
   return adcValue;
 }
 
+/**
+  * @brief  Returns the last reading without a new conversion
+  * @retval 12-bit ADC reading, 0 before the first conversion
+  */
+uint16_t Temperature_LastADC(void)
+{
+  return lastAdc;
+}
+
 /**
   * @brief  Calculates temperature in Celsius using factory calibration
   * @retval Temperature in degrees Celsius (float)
   * 
   * Formula: Temperature = ((110 - 30) / (CAL_110 - CAL_30)) * (ADC_reading - CAL_30) + 30
+  * 
+  * The reading is a batch of conversions through the filter stage when one
+  * is selected (filter.h), in 1/8 code
   */
 float Temperature_GetCelsius(void)
 {
-  uint16_t adcValue;
+  uint32_t adcValue;
   uint16_t cal30;
   uint16_t cal110;
   float temperature;
   
-  /* Read current ADC value */
-  adcValue = Temperature_ReadADC();
+  /* Read current ADC value, filtered */
+  adcValue = Filter_Read();
   
   /* Read factory calibration values from system memory */
   cal30 = *TEMP30_CAL_ADDR;
@@ -75,7 +100,7 @@ float Temperature_GetCelsius(void)
   if (cal110 != cal30)  // Avoid division by zero
   {
     temperature = ((TEMP110_CAL_TEMP - TEMP30_CAL_TEMP) / (float)(cal110 - cal30)) 
-                  * (float)(adcValue - cal30) + TEMP30_CAL_TEMP;
+                  * ((float)adcValue / (float)(1UL << FILTER_FRAC_BITS) - (float)cal30) + TEMP30_CAL_TEMP;
   }
   else
   {
@@ -0,0 +1,114 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : trace.c
+  * @brief          : Binary event trace over the SWO/ITM stimulus ports
+  *                   and the RAM log of the last events
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "trace.h"
+
+/* Private variables ---------------------------------------------------------*/
+Trace_Record traceLog[TRACE_LOG_LEN];
+uint32_t traceLogCount;           /* events logged, the next slot modulo TRACE_LOG_LEN */
+
+/**
+  * @brief  Starts the DWT cycle counter used to timestamp trace records
+  * @retval None
+  *
+  * The SWO pin (PB3) and the ITM ports are normally set up by the debug probe
+  * (e.g. OpenOCD "itm ports on"). Building with -DTRACE_SWO_BAUD=<baud> makes
+  * the firmware configure TPIU/ITM itself so a bare SWO receiver can capture.
+  */
+void Trace_Init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#ifdef TRACE_SWO_BAUD
+  /* Route TRACESWO to PB3, asynchronous mode */
+  DBGMCU->CR = (DBGMCU->CR & ~DBGMCU_CR_TRACE_MODE) | DBGMCU_CR_TRACE_IOEN;
+
+  /* TPIU: NRZ (UART) encoding, formatter bypassed */
+  TPI->SPPR = 2U;
+  TPI->ACPR = (SystemCoreClock / TRACE_SWO_BAUD) - 1U;
+  TPI->FFCR = 0x100U;
+
+  /* ITM: unlock, enable with SWO output and turn on the trace ports */
+  ITM->LAR = 0xC5ACCE55U;
+  ITM->TCR = ITM_TCR_ITMENA_Msk | ITM_TCR_SWOENA_Msk | (1UL << ITM_TCR_TraceBusID_Pos);
+  ITM->TPR = 0U;
+  ITM->TER |= TRACE_PORT_MASK;
+#endif
+}
+
+/**
+  * @brief  Writes one record (event word + timestamp word) to the ITM
+  * @param  id: event identifier (Trace_EventId)
+  * @param  arg0: 8-bit event argument
+  * @param  arg1: 16-bit event argument
+  * @retval None
+  *
+  * Interrupts are masked for the two port writes so a record emitted from an
+  * ISR cannot split the event/timestamp pair of a record in thread mode.
+  */
+void Trace_Emit(uint8_t id, uint8_t arg0, uint16_t arg1)
+{
+  uint32_t primask;
+  uint32_t timestamp;
+
+  if ((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0U)
+  {
+    return;
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  timestamp = DWT->CYCCNT;
+
+  while (ITM->PORT[TRACE_PORT_EVENT].u32 == 0U)
+  {
+  }
+  ITM->PORT[TRACE_PORT_EVENT].u32 = ((uint32_t)id << 24) | ((uint32_t)arg0 << 16) | arg1;
+
+  while (ITM->PORT[TRACE_PORT_TIME].u32 == 0U)
+  {
+  }
+  ITM->PORT[TRACE_PORT_TIME].u32 = timestamp;
+
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Copies the newest events of the RAM log, oldest first
+  * @param  out: destination, max records
+  * @param  max: records wanted
+  * @retval records copied
+  */
+uint32_t Trace_Recent(Trace_Record *out, uint32_t max)
+{
+  uint32_t count = (traceLogCount < TRACE_LOG_LEN) ? traceLogCount : TRACE_LOG_LEN;
+  uint32_t i;
+
+  count = (count < max) ? count : max;
+  for (i = 0; i < count; i++)
+  {
+    out[i] = traceLog[(traceLogCount - count + i) & (TRACE_LOG_LEN - 1U)];
+  }
+  return count;
+}
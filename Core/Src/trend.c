@@ -0,0 +1,251 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : trend.c
+  * @brief          : Temperature rate of change and time to an alarm threshold
+  *                   (see trend.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * With places 0 to n - 1, Sx = n(n - 1)/2 and n Sxx - Sx^2 = n^2(n^2 - 1)/12,
+  * so the least-squares slope per sample is (n Sxy - Sx Sy) / D with that D,
+  * and the fitted value at place n - 1 is (Sy D + (n Sxy - Sx Sy) Sx) / (n D).
+  * Both sums fit 32 bits (64 samples of 0xFFFF at most); the products take
+  * 64 bits, worked out once per T1 period.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "trend.h"
+
+#ifndef BOOT_HOST
+#include "can.h"
+#include "params.h"
+#endif
+
+/* Private define ------------------------------------------------------------*/
+#define TREND_ID(src) \
+  (CAN_FRAME_EXT | (TREND_PRIO << 26) | (TREND_PGN << 8) | (uint32_t)(src))
+
+/* Private functions ---------------------------------------------------------*/
+
+/* n / d rounded to the nearest, halves away from zero; d > 0 */
+static int64_t divRound(int64_t n, int64_t d)
+{
+  return (n >= 0) ? ((n + (d / 2)) / d) : -((-n + (d / 2)) / d);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Empties the window
+  * @param  trend: window to start
+  * @param  window: samples to fit, TREND_WINDOW_MIN to TREND_WINDOW_MAX;
+  *         values out of range take the nearest limit
+  * @retval None
+  */
+void Trend_Start(Trend_State *trend, uint32_t window)
+{
+  window = (window < TREND_WINDOW_MIN) ? TREND_WINDOW_MIN :
+           ((window > TREND_WINDOW_MAX) ? TREND_WINDOW_MAX : window);
+  trend->window = (uint8_t)window;
+  trend->count = 0;
+  trend->head = 0;
+  trend->sumY = 0;
+  trend->sumXY = 0;
+}
+
+/**
+  * @brief  Adds the newest sample, dropping the oldest once the window is
+  *         full, in constant time
+  * @param  trend: started window
+  * @param  centiK: temperature, 0.01 K
+  * @retval None
+  */
+void Trend_Add(Trend_State *trend, uint16_t centiK)
+{
+  if (trend->count < trend->window)
+  {
+    trend->sumXY += (uint32_t)trend->count * centiK;
+    trend->sumY += centiK;
+    trend->samples[trend->count] = centiK;
+    trend->count++;
+    return;
+  }
+
+  /* Every other sample moves a place down; Sxy >= Sy - oldest */
+  trend->sumXY = trend->sumXY - (trend->sumY - trend->samples[trend->head]) +
+                 ((uint32_t)(trend->window - 1U) * centiK);
+  trend->sumY = trend->sumY - trend->samples[trend->head] + centiK;
+  trend->samples[trend->head] = centiK;
+  trend->head = (uint8_t)((trend->head + 1U < trend->window) ? (trend->head + 1U) : 0U);
+}
+
+/**
+  * @brief  Slope of the window and the time to the threshold it heads for
+  * @param  trend: started window
+  * @param  periodMs: time between samples, not 0
+  * @param  highCentiK: high alarm threshold, 0.01 K
+  * @param  lowCentiK: low alarm threshold, 0.01 K; no target unless below
+  *         highCentiK
+  * @param  result: destination
+  * @retval None
+  */
+void Trend_Estimate(const Trend_State *trend, uint32_t periodMs, int32_t highCentiK, int32_t lowCentiK,
+                    Trend_Result *result)
+{
+  int64_t n = trend->count;
+  int64_t sx = (n * (n - 1)) / 2;
+  int64_t d = (n * n * ((n * n) - 1)) / 12;
+  int64_t num;
+  int64_t fitN;
+  int64_t slope;
+  int64_t rem;
+  int64_t seconds;
+  int32_t threshold;
+
+  result->samples = trend->count;
+  result->flags = (trend->count == trend->window) ? TREND_FLAG_FULL : 0U;
+  result->target = TREND_TARGET_NONE;
+  result->seconds = TREND_TIME_NA;
+  if (n < 2)
+  {
+    result->slope = TREND_SLOPE_NA;
+    result->fitted = (n == 1) ? (int32_t)trend->sumY : 0;
+    return;
+  }
+
+  /* Slope n D times over; the fit n D times over */
+  num = (n * (int64_t)trend->sumXY) - (sx * (int64_t)trend->sumY);
+  fitN = ((int64_t)trend->sumY * d) + (num * sx);
+  result->fitted = (int32_t)divRound(fitN, n * d);
+
+  /* 0.01 K per sample to 0.001 K per minute */
+  slope = divRound(num * 600000, d * (int64_t)periodMs);
+  if ((slope > TREND_SLOPE_MAX) || (slope < -TREND_SLOPE_MAX))
+  {
+    slope = (slope > 0) ? TREND_SLOPE_MAX : -TREND_SLOPE_MAX;
+    result->flags |= TREND_FLAG_CLAMPED;
+  }
+  result->slope = (int32_t)slope;
+
+  if ((num == 0) || (lowCentiK >= highCentiK))
+  {
+    return;
+  }
+  result->target = (num > 0) ? TREND_TARGET_HIGH : TREND_TARGET_LOW;
+  threshold = (num > 0) ? highCentiK : lowCentiK;
+
+  /* Distance n D times over, divided by the slope per millisecond */
+  rem = ((int64_t)threshold * n * d) - fitN;
+  if ((rem == 0) || ((rem > 0) != (num > 0)))
+  {
+    result->seconds = 0;
+    return;
+  }
+  seconds = divRound(((rem < 0) ? -rem : rem) * (int64_t)periodMs, n * ((num < 0) ? -num : num) * 1000);
+  result->seconds = (seconds > (int64_t)TREND_TIME_MAX) ? TREND_TIME_OVER : (uint32_t)seconds;
+}
+
+/**
+  * @brief  Writes the trend message data
+  * @param  result: Trend_Estimate() result
+  * @param  sid: SID of the PGN 130312 it follows
+  * @param  flags: TREND_FLAG_REQUEST or 0
+  * @param  data: destination, 8 bytes
+  * @retval None
+  */
+void Trend_Encode(const Trend_Result *result, uint8_t sid, uint8_t flags, uint8_t *data)
+{
+  uint16_t slope = (uint16_t)(int16_t)result->slope;
+
+  data[0] = sid;
+  data[1] = result->samples;
+  data[2] = (uint8_t)slope;
+  data[3] = (uint8_t)(slope >> 8);
+  data[4] = (uint8_t)result->seconds;
+  data[5] = (uint8_t)(result->seconds >> 8);
+  data[6] = result->target;
+  data[7] = (uint8_t)(0xF8U | flags | result->flags);
+}
+
+#ifndef BOOT_HOST
+
+/* Private variables ---------------------------------------------------------*/
+static Trend_State trend;
+static uint32_t configured[3];    /* window, T1 period, offset in use */
+static uint8_t ready;
+static uint8_t lastSid;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Starts the window again when its parameters have changed */
+static void configure(void)
+{
+  if (ready && (Params_Get(PARAM_TREND_WINDOW) == configured[0]) &&
+      (Params_Get(PARAM_T1_PERIOD_MS) == configured[1]) && (Params_Get(PARAM_TEMP_OFFSET) == configured[2]))
+  {
+    return;
+  }
+  configured[0] = Params_Get(PARAM_TREND_WINDOW);
+  configured[1] = Params_Get(PARAM_T1_PERIOD_MS);
+  configured[2] = Params_Get(PARAM_TEMP_OFFSET);
+  Trend_Start(&trend, configured[0]);
+  ready = 1;
+}
+
+static void send(uint8_t flags)
+{
+  CAN_Frame frame;
+  Trend_Result result;
+
+  /* Thresholds as PGN 130312 reports the temperature */
+  Trend_Estimate(&trend, configured[1], ((int32_t)Params_Get(PARAM_ALARM_HIGH) * 10) + 27315,
+                 ((int32_t)Params_Get(PARAM_ALARM_LOW) * 10) + 27315, &result);
+
+  frame.id = TREND_ID(Params_Get(PARAM_SOURCE_ADDRESS) & 0xFFUL);
+  frame.dlc = 8;
+  frame.filter = 0;
+  frame.time = 0;
+  Trend_Encode(&result, lastSid, flags, frame.data);
+  (void)CAN_TransmitFrame(&frame);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Adds the temperature PGN 130312 has just reported and sends the
+  *         trend message after it; from the T1 task
+  * @param  centiK: temperature as reported, 0.01 K
+  * @param  sid: SID of that PGN 130312
+  * @retval None
+  */
+void Trend_Update(uint16_t centiK, uint8_t sid)
+{
+  configure();
+  Trend_Add(&trend, centiK);
+  lastSid = sid;
+  send(0);
+}
+
+/**
+  * @brief  Queues the trend message for the window as it is, for an ISO
+  *         request
+  * @retval None
+  */
+void Trend_SendState(void)
+{
+  configure();
+  send(TREND_FLAG_REQUEST);
+}
+
+#endif /* BOOT_HOST */
@@ -0,0 +1,269 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : watchdog.c
+  * @brief          : IWDG supervisor with per-task check-ins (see watchdog.h)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The IWDG is programmed through its registers: the HAL driver only adds a
+  * busy wait on the same status flags. A missed check-in is final; the
+  * supervisor records the task and stops refreshing, so the reset follows
+  * at most WATCHDOG_TIMEOUT_MS later even if the task recovers.
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "watchdog.h"
+#include "boot.h"
+
+/* Private define ------------------------------------------------------------*/
+#define IWDG_KEY_RELOAD         0xAAAAU
+#define IWDG_KEY_ENABLE         0xCCCCU
+#define IWDG_KEY_WRITE_ACCESS   0x5555U
+
+#define RECORD(resets, starved) \
+  (((uint32_t)WATCHDOG_RECORD_MAGIC << 24) | ((uint32_t)(resets) << 16) | ((uint32_t)(starved) << 8))
+
+/* Private variables ---------------------------------------------------------*/
+Watchdog_ResetInfo watchdogReset;
+Watchdog_Stats watchdogStats;
+
+static uint32_t checkInMs[WATCHDOG_MAX_TASKS];    /* HAL_GetTick() of the last check-in */
+static uint32_t limitMs[WATCHDOG_MAX_TASKS];      /* longest time between check-ins */
+static uint8_t taskCount;
+static uint8_t starved = WATCHDOG_NONE;
+static uint32_t record;                           /* backup register without the running task */
+
+/* Private functions ---------------------------------------------------------*/
+static uint8_t causeOf(uint32_t csr)
+{
+  /* Every internal reset also drives NRST, so the pin flag comes last */
+  if ((csr & RCC_CSR_LPWRRSTF) != 0U)
+  {
+    return WATCHDOG_CAUSE_LOW_POWER;
+  }
+  if ((csr & RCC_CSR_WWDGRSTF) != 0U)
+  {
+    return WATCHDOG_CAUSE_WWDG;
+  }
+  if ((csr & RCC_CSR_IWDGRSTF) != 0U)
+  {
+    return WATCHDOG_CAUSE_IWDG;
+  }
+  if ((csr & RCC_CSR_SFTRSTF) != 0U)
+  {
+    return WATCHDOG_CAUSE_SOFTWARE;
+  }
+  if ((csr & RCC_CSR_PORRSTF) != 0U)
+  {
+    return WATCHDOG_CAUSE_POWER_ON;
+  }
+  if ((csr & RCC_CSR_OBLRSTF) != 0U)
+  {
+    return WATCHDOG_CAUSE_OPTION_BYTES;
+  }
+  if ((csr & RCC_CSR_PINRSTF) != 0U)
+  {
+    return WATCHDOG_CAUSE_PIN;
+  }
+  return WATCHDOG_CAUSE_UNKNOWN;
+}
+
+static uint32_t limitFor(uint32_t periodMs)
+{
+  return (2U * periodMs) + WATCHDOG_GRACE_MS;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Records why the node was reset and starts the IWDG; call before
+  *         the peripherals are initialised, so that a hang there resets too
+  * @retval None
+  */
+void Watchdog_Init(void)
+{
+  uint32_t previous;
+  uint8_t resets = 0;
+
+  watchdogReset.csr = RCC->CSR;
+  RCC->CSR |= RCC_CSR_RMVF;
+  watchdogReset.cause = causeOf(watchdogReset.csr);
+  watchdogReset.task = WATCHDOG_NONE;
+  watchdogReset.starved = WATCHDOG_NONE;
+
+  HAL_PWR_EnableBkUpAccess();
+  previous = RTC->BKP1R;
+  if ((previous >> 24) == WATCHDOG_RECORD_MAGIC)
+  {
+    resets = (uint8_t)(previous >> 16);
+    /* The record only describes the reset if the watchdog caused it */
+    if (watchdogReset.cause == WATCHDOG_CAUSE_IWDG)
+    {
+      watchdogReset.task = (uint8_t)previous;
+      watchdogReset.starved = (uint8_t)(previous >> 8);
+    }
+  }
+  if ((watchdogReset.cause == WATCHDOG_CAUSE_IWDG) && (resets != 0xFFU))
+  {
+    resets++;
+  }
+  watchdogReset.resets = resets;
+  record = RECORD(resets, WATCHDOG_NONE);
+  RTC->BKP1R = record | WATCHDOG_NONE;
+
+  /* Frozen while a debugger halts the core */
+  DBGMCU->APB1FZ |= DBGMCU_APB1_FZ_DBG_IWDG_STOP;
+
+  IWDG->KR = IWDG_KEY_ENABLE;
+  IWDG->KR = IWDG_KEY_WRITE_ACCESS;
+  IWDG->PR = WATCHDOG_PRESCALER;
+  IWDG->RLR = WATCHDOG_RELOAD;
+  while ((IWDG->SR & (IWDG_SR_PVU | IWDG_SR_RVU)) != 0U)
+  {
+  }
+  IWDG->KR = IWDG_KEY_RELOAD;
+}
+
+/**
+  * @brief  Adds a task to the supervision
+  * @param  periodMs: expected time between check-ins, 0 for every pass
+  * @retval task number, WATCHDOG_NONE if the table is full
+  */
+uint8_t Watchdog_Register(uint32_t periodMs)
+{
+  if (taskCount >= WATCHDOG_MAX_TASKS)
+  {
+    return WATCHDOG_NONE;
+  }
+  checkInMs[taskCount] = HAL_GetTick();
+  limitMs[taskCount] = limitFor(periodMs);
+  return taskCount++;
+}
+
+/**
+  * @brief  Changes the expected check-in period of a task; the time since
+  *         its last check-in keeps counting
+  * @param  task: number from Watchdog_Register()
+  * @param  periodMs: new period, 0 for every pass
+  * @retval None
+  */
+void Watchdog_SetPeriod(uint8_t task, uint32_t periodMs)
+{
+  if (task < taskCount)
+  {
+    limitMs[task] = limitFor(periodMs);
+  }
+}
+
+/**
+  * @brief  Notes the task about to run in the backup register, for the
+  *         report after a watchdog reset
+  * @param  task: number from Watchdog_Register(), or WATCHDOG_NONE
+  * @retval None
+  */
+void Watchdog_Running(uint8_t task)
+{
+  RTC->BKP1R = record | task;
+}
+
+/**
+  * @brief  Marks a task alive
+  * @param  task: number from Watchdog_Register()
+  * @retval None
+  */
+void Watchdog_CheckIn(uint8_t task)
+{
+  if (task < taskCount)
+  {
+    checkInMs[task] = HAL_GetTick();
+  }
+  RTC->BKP1R = record | WATCHDOG_NONE;
+}
+
+/**
+  * @brief  Refreshes the IWDG if every task has checked in in time; call
+  *         once per scheduler pass
+  * @retval None
+  */
+void Watchdog_Supervise(void)
+{
+  uint32_t now = HAL_GetTick();
+  uint8_t i;
+
+  for (i = 0; (i < taskCount) && (starved == WATCHDOG_NONE); i++)
+  {
+    if ((now - checkInMs[i]) > limitMs[i])
+    {
+      starved = i;
+      record = RECORD(watchdogReset.resets, starved);
+      RTC->BKP1R = record | WATCHDOG_NONE;
+    }
+  }
+  if (starved != WATCHDOG_NONE)
+  {
+    watchdogStats.withheld++;
+    return;
+  }
+  IWDG->KR = IWDG_KEY_RELOAD;
+  watchdogStats.refreshes++;
+}
+
+/**
+  * @brief  Task running, as noted by Watchdog_Running(), for crash reports
+  * @retval task number, WATCHDOG_NONE between tasks
+  */
+uint8_t Watchdog_Current(void)
+{
+  return (uint8_t)RTC->BKP1R;
+}
+
+/**
+  * @brief  Answers RESET_CAUSE addressed to this node
+  * @param  frame: received frame, anything else is ignored
+  * @retval None
+  */
+void Watchdog_HandleFrame(const CAN_Frame *frame)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  if (((frame->id & CAN_FRAME_EXT) == 0U) || (frame->dlc < 1U) ||
+      (BOOT_ID_PGN(id) != BOOT_PGN_CMD) || (BOOT_ID_DA(id) != BOOT_NODE_ADDRESS) ||
+      (frame->data[0] != WATCHDOG_CMD_RESET))
+  {
+    return;
+  }
+  Watchdog_Report((uint8_t)BOOT_ID_SA(id));
+}
+
+/**
+  * @brief  Sends the RESET_CAUSE response
+  * @param  requester: destination address, 0xFF for the start-up report
+  * @retval None
+  */
+void Watchdog_Report(uint8_t requester)
+{
+  CAN_Frame response;
+
+  response.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, requester, BOOT_NODE_ADDRESS);
+  response.dlc = 8;
+  response.data[0] = WATCHDOG_CMD_RESET | BOOT_RSP;
+  response.data[1] = watchdogReset.cause;
+  response.data[2] = watchdogReset.task;
+  response.data[3] = watchdogReset.starved;
+  response.data[4] = watchdogReset.resets;
+  response.data[5] = (uint8_t)(watchdogReset.csr >> 24);
+  response.data[6] = 0xFF;
+  response.data[7] = 0xFF;
+  (void)CAN_TransmitFrame(&response);
+}
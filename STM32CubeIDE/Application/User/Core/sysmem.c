@@ -22,7 +22,9 @@
 
 /* Includes */
 #include <errno.h>
+#include <stddef.h>
 #include <stdint.h>
+#include "ram.h"
 
 /**
  * Pointer to the current high watermark of the heap usage
@@ -46,6 +48,8 @@ static uint8_t *__sbrk_heap_end = NULL;
  * The implementation considers '_estack' linker symbol to be RAM end
  * NOTE: If the MSP stack, at any point during execution, grows larger than the
  * reserved size, please increase the '_Min_Stack_Size'.
+ * The break, its peak and the refused requests are kept in ramStats (ram.h)
+ * for the diagnostics PGN.
  *
  * @param incr Memory size
  * @return Pointer to allocated memory
@@ -55,7 +59,7 @@ void *_sbrk(ptrdiff_t incr)
   extern uint8_t _end; /* Symbol defined in the linker script */
   extern uint8_t _estack; /* Symbol defined in the linker script */
   extern uint32_t _Min_Stack_Size; /* Symbol defined in the linker script */
-  const uint32_t stack_limit = (uint32_t)&_estack - (uint32_t)&_Min_Stack_Size;
+  const uintptr_t stack_limit = (uintptr_t)&_estack - (uintptr_t)&_Min_Stack_Size;
   const uint8_t *max_heap = (uint8_t *)stack_limit;
   uint8_t *prev_heap_end;
 
@@ -68,6 +72,7 @@ void *_sbrk(ptrdiff_t incr)
   /* Protect heap from growing into the reserved MSP stack */
   if (__sbrk_heap_end + incr > max_heap)
   {
+    ramStats.heapFailures++;
     errno = ENOMEM;
     return (void *)-1;
   }
@@ -75,5 +80,11 @@ void *_sbrk(ptrdiff_t incr)
   prev_heap_end = __sbrk_heap_end;
   __sbrk_heap_end += incr;
 
+  ramStats.heapUsed = (uint32_t)(__sbrk_heap_end - &_end);
+  if (ramStats.heapUsed > ramStats.heapPeak)
+  {
+    ramStats.heapPeak = ramStats.heapUsed;
+  }
+
   return (void *)prev_heap_end;
 }
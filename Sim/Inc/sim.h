@@ -0,0 +1,244 @@
+/**
+  ******************************************************************************
+  * @file           : sim.h
+  * @brief          : Host simulation core: virtual time, peripheral models
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __SIM_H
+#define __SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include "can.h"
+
+/* Simulated clock tree, as SystemClock_Config(): HSE 16 MHz x 4 = HCLK,
+ * used for DWT->CYCCNT and SysTick, and APB1 = HCLK / 2 for bxCAN/USART3 */
+#define SIM_CPU_HZ            64000000UL
+#define SIM_PCLK1_HZ          (SIM_CPU_HZ / 2UL)
+
+/**
+  * @brief Run-time configuration of the simulated board
+  */
+typedef struct
+{
+  uint64_t durationUs;    /* virtual run time, 0 = forever */
+  double tempC;           /* die temperature at t = 0 */
+  double rampCPerMin;     /* linear temperature ramp */
+  double noiseLsb;        /* peak ADC noise in LSB */
+  uint32_t seed;          /* noise generator seed */
+  uint32_t bitrate;       /* CAN bit rate used for frame timing */
+  uint16_t cal30;         /* TS_CAL1 word */
+  uint16_t cal110;        /* TS_CAL2 word */
+  double timeScale;       /* virtual/wall clock ratio, 0 = free-running */
+  const char *flashPath;  /* parameter pages kept between runs, NULL = erased */
+  double paramRateHz;     /* PARAM_SET writer rate, 0 = off */
+  uint32_t powerCutOp;    /* cut the power during this flash operation, 0 = never */
+  double historyPeriodS;  /* HIST_GET requester period, 0 = off */
+  const char *replayPath; /* candump log replayed onto the bus, NULL = none */
+  double replaySpeed;     /* replay speed-up, 0 = back to back */
+  const char *hangSpec;   /* -W kind@seconds, NULL = no hang */
+  const char *resetSpec;  /* -Y csr:bkp1 of the previous reset, NULL = power-on */
+  const char *crashSpec;  /* -C kind@seconds, NULL = no crash */
+  const char *crashPath;  /* crash record kept between runs, NULL = power-on */
+  const char *ramSpec;    /* -S stack[,heap]@seconds, NULL = no injection */
+  const char *stressSpec; /* -G load[,burst[,flags]]@seconds, NULL = off */
+  const char *monitorSpec; /* -M seconds[,flags[,ids]]@seconds, NULL = off */
+  const char *pingSpec;   /* -E rate[,prio]@seconds, NULL = off */
+  const char *alarmSpec;  /* -A high,low[,hyst]@seconds, NULL = as stored */
+  const char *filterSpec; /* -T mode[,batch[,cutoff]]@seconds, NULL = as stored */
+  const char *trendSpec;  /* -w window@seconds, NULL = as stored */
+  const char *uploadPath; /* -U image file or size (BOOT=1 build), NULL = none */
+  int quiet;              /* suppress the end-of-run report */
+} Sim_Config;
+
+extern Sim_Config Sim_Cfg;
+extern uint64_t Sim_NowUs;
+
+/* Virtual time and interrupts ---------------------------------------------*/
+void Sim_Start(void);
+void Sim_RaiseIrq(IRQn_Type irq);
+void Sim_AdvanceTo(uint64_t targetUs);
+void Sim_WaitForInterrupt(void);
+void Sim_Finish(void) __attribute__((__noreturn__));
+uint64_t Sim_WallUs(void);
+
+/* Low-power model: CPU residency, Stop mode and RTC wake-up -----------------*/
+void SimPower_CanOnline(void);
+void SimPower_Report(FILE *out, double seconds);
+
+/* ADC temperature sensor model ---------------------------------------------*/
+double Sim_AdcModel(void);
+uint16_t Sim_AdcSample(void);
+uint32_t Sim_AdcFlags(void);
+
+/* Cycle counter model: handlers and conversions take no virtual time, their
+ * modelled cycles are added to DWT->CYCCNT -----------------------------------*/
+#define SIM_ADC_CYCLES          1000U     /* polled conversion, sampling included */
+
+/**
+  * @brief What the model added to DWT->CYCCNT since it was enabled
+  */
+typedef struct
+{
+  uint64_t startUs;         /* enabled at, UINT64_MAX if never */
+  uint64_t stopUs;          /* Stop mode since, the counter frozen */
+  uint32_t stops;           /* Stop mode entries */
+  uint64_t lastStopUs;      /* the last one so far, it may still run */
+  uint64_t modelledCycles;  /* handlers and conversions, in the counter so far */
+  uint32_t conversions;     /* ADC conversions polled */
+} Sim_CycleModel;
+
+void Sim_CycleModelGet(Sim_CycleModel *model);
+uint32_t Sim_IrqRuns(IRQn_Type irq, uint32_t *cycles);
+
+/* Register blocks whose writes have side effects (Sim/Src/sim_mmio.c) -------*/
+typedef void (*SimMmio_WriteFn)(uint32_t offset, uint32_t value, uint32_t old);
+
+void *SimMmio_Map(uintptr_t base, size_t size, SimMmio_WriteFn onWrite);
+
+/* CAN controller and bus model (Sim/Src/sim_can.c) -------------------------*/
+/* Where a frame on the simulated bus came from */
+#define SIM_CAN_ORIGIN_NODE     0U    /* this node's transmit mailboxes */
+#define SIM_CAN_ORIGIN_SOCKET   1U    /* SocketCAN bridge */
+#define SIM_CAN_ORIGIN_MODEL    2U    /* simulated nodes, e.g. the PARAM_SET writer */
+#define SIM_CAN_ORIGIN_REPLAY   3U    /* frames from a -R log */
+
+typedef void (*SimCan_TapFn)(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx);
+
+void SimCan_Init(void);
+void SimCan_AddTap(SimCan_TapFn fn, void *ctx);
+int SimCan_Inject(const CAN_Frame *frame, uint64_t readyUs, uint32_t origin);
+uint32_t SimCan_Bitrate(void);
+uint64_t SimCan_NextEventUs(void);
+uint64_t SimCan_NextActivityUs(void);
+uint32_t SimCan_FramesLostAsleep(void);
+uint32_t SimCan_FramesLostOverrun(void);
+void SimCan_Process(uint64_t nowUs);
+uint32_t SimCan_FrameBits(const CAN_Frame *frame);
+uint16_t SimCan_BitClock(uint64_t us);
+void SimCan_InjectError(uint32_t lec);
+void SimCan_Report(FILE *out, double seconds);
+
+/* SocketCAN bridge (Sim/Src/sim_socketcan.c) */
+void SimSocketCan_Open(const char *ifname);
+int SimSocketCan_Wait(uint64_t timeoutUs);
+void SimSocketCan_Report(FILE *out);
+
+/* Parameter flash and PARAM_SET writer (Sim/Src/sim_flash.c) */
+void SimFlash_Init(void);
+int SimFlash_Close(void);
+void SimFlash_Report(FILE *out, double seconds);
+
+/* Temperature history requester and check (Sim/Src/sim_history.c) */
+void SimHistory_Init(void);
+int SimHistory_Close(void);
+void SimHistory_Report(FILE *out, double seconds);
+
+/* IWDG model and hang injection (Sim/Src/sim_watchdog.c) */
+#define SIM_HANG_NONE           0U
+#define SIM_HANG_ADC            1U    /* HAL_ADC_PollForConversion() never returns */
+#define SIM_HANG_RX             2U    /* the CAN RX0 handler never returns */
+#define SIM_HANG_STARVE         3U    /* T1 kept from running by PARAM_SET */
+
+void SimWatchdog_Init(void);
+int SimWatchdog_Close(void);
+void SimWatchdog_Report(FILE *out, double seconds);
+uint64_t SimWatchdog_NextEventUs(void);
+void SimWatchdog_Process(uint64_t nowUs);
+int SimWatchdog_Hang(uint32_t kind);
+
+/* Crash injection and crash report check (Sim/Src/sim_crash.c) */
+#define SIM_CRASH_NONE          0U
+#define SIM_CRASH_FAULT         1U    /* HAL_ADC_Start() takes a precise bus fault */
+#define SIM_CRASH_ERROR         2U    /* HAL_ADC_Start() ends in Error_Handler() */
+
+void SimCrash_Init(void);
+int SimCrash_Close(void);
+void SimCrash_Report(FILE *out, double seconds);
+int SimCrash_Due(uint32_t kind);
+void SimCrash_Fault(uint32_t pc, uint32_t lr) __attribute__((__noreturn__));
+
+/* Painted SRAM and high-water mark check (Sim/Src/sim_ram.c) */
+void SimRam_Init(void);
+int SimRam_Close(void);
+void SimRam_Report(FILE *out, double seconds);
+void SimRam_Use(void);
+
+/* Bus-stress generator control and receiver check (Sim/Src/sim_stress.c) */
+void SimStress_Init(void);
+int SimStress_Close(void);
+void SimStress_Report(FILE *out, double seconds);
+
+/* Bus monitor traffic and report check (Sim/Src/sim_monitor.c) */
+void SimMonitor_Init(void);
+int SimMonitor_Close(void);
+void SimMonitor_Report(FILE *out, double seconds);
+
+/* Ping sender and echo check (Sim/Src/sim_ping.c) */
+void SimPing_Init(void);
+int SimPing_Close(void);
+void SimPing_Report(FILE *out, double seconds);
+
+/* Status page check on the A1 frames (Sim/Src/sim_status.c) */
+void SimStatus_Init(void);
+int SimStatus_Close(void);
+void SimStatus_Report(FILE *out, double seconds);
+
+/* CPU accounting check (Sim/Src/sim_cpu.c) */
+void SimCpu_Init(void);
+int SimCpu_Close(void);
+void SimCpu_Report(FILE *out, double seconds);
+
+/* Temperature alarm check on the analog watchdog (Sim/Src/sim_alarm.c) */
+void SimAlarm_Init(void);
+void SimAlarm_Conversion(uint16_t code);
+int SimAlarm_Close(void);
+void SimAlarm_Report(FILE *out, double seconds);
+
+/* Temperature filter check (Sim/Src/sim_filter.c) */
+void SimFilter_Init(void);
+void SimFilter_Conversion(uint16_t code);
+int SimFilter_Close(void);
+void SimFilter_Report(FILE *out, double seconds);
+
+/* Temperature trend check (Sim/Src/sim_trend.c) */
+void SimTrend_Init(void);
+int SimTrend_Close(void);
+void SimTrend_Report(FILE *out, double seconds);
+
+/* Uploader model and update check, BOOT=1 build only (Sim/Src/sim_boot.c) */
+void SimBoot_Init(void);
+int SimBoot_Close(void);
+void SimBoot_Report(FILE *out, double seconds);
+uint64_t SimBoot_NextEventUs(void);
+void SimBoot_Process(uint64_t nowUs);
+
+/* candump log replay (Sim/Src/sim_replay.c) */
+void SimReplay_Init(void);
+void SimReplay_Close(void);
+void SimReplay_Report(FILE *out, double seconds);
+
+/* candump -L style log of bus traffic */
+void SimLog_Open(const char *path, const char *ifname);
+void SimLog_Close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_H */
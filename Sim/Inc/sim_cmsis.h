@@ -0,0 +1,152 @@
+/**
+  ******************************************************************************
+  * @file           : sim_cmsis.h
+  * @brief          : Host replacement for cmsis_gcc.h (force-included)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The real cmsis_gcc.h implements the core intrinsics with Thumb inline
+  * assembly. The host build defines its include guard up front and supplies
+  * C equivalents operating on the simulated core state instead.
+  */
+
+#ifndef __SIM_CMSIS_H
+#define __SIM_CMSIS_H
+
+#include <stdint.h>
+
+#define __CMSIS_GCC_H
+
+#define __ASM                       __asm
+#define __INLINE                    inline
+#define __STATIC_INLINE             static inline
+#define __STATIC_FORCEINLINE        __attribute__((always_inline)) static inline
+#define __NO_RETURN                 __attribute__((__noreturn__))
+#define __USED                      __attribute__((used))
+#define __WEAK                      __attribute__((weak))
+#define __PACKED                    __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT             struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION              union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)                __attribute__((aligned(x)))
+#define __RESTRICT                  __restrict
+#define __COMPILER_BARRIER()        __asm volatile("" ::: "memory")
+
+/* Simulated core state (Sim/Src/sim_hal.c) */
+extern volatile uint32_t Sim_Primask;
+void Sim_SetPrimask(uint32_t mask);
+void Sim_WaitForInterrupt(void);
+void Sim_SystemReset(void) __attribute__((__noreturn__));
+
+/* Fault handlers (Core/Inc/crash.h): the frame comes from Sim/Src/sim_crash.c */
+void Sim_FaultEntry(uint32_t kind) __attribute__((__noreturn__));
+#define CRASH_NAKED
+#define CRASH_FAULT_ENTRY(kind)     Sim_FaultEntry(kind)
+
+/* Heap start (Core/Inc/ram.h): the host linker keeps _end for its own .bss */
+#define _end                        Sim_HeapStart
+
+__STATIC_FORCEINLINE void __enable_irq(void)             { Sim_SetPrimask(0U); }
+__STATIC_FORCEINLINE void __disable_irq(void)            { Sim_Primask = 1U; }
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void)        { return Sim_Primask; }
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t m)      { Sim_SetPrimask(m); }
+__STATIC_FORCEINLINE uint32_t __get_IPSR(void)           { return 0U; }
+__STATIC_FORCEINLINE uint32_t __get_CONTROL(void)        { return 0U; }
+__STATIC_FORCEINLINE uint32_t __get_MSP(void)            { return (uint32_t)(uintptr_t)__builtin_frame_address(0); }
+__STATIC_FORCEINLINE uint32_t __get_PSP(void)            { return 0U; }
+__STATIC_FORCEINLINE void __set_MSP(uint32_t v)          { (void)v; }
+__STATIC_FORCEINLINE uint32_t __get_BASEPRI(void)        { return 0U; }
+__STATIC_FORCEINLINE void __set_BASEPRI(uint32_t v)      { (void)v; }
+__STATIC_FORCEINLINE uint32_t __get_FPSCR(void)          { return 0U; }
+__STATIC_FORCEINLINE void __set_FPSCR(uint32_t v)        { (void)v; }
+
+__STATIC_FORCEINLINE void __NOP(void)                    { }
+__STATIC_FORCEINLINE void __WFI(void)                    { Sim_WaitForInterrupt(); }
+__STATIC_FORCEINLINE void __WFE(void)                    { Sim_WaitForInterrupt(); }
+__STATIC_FORCEINLINE void __SEV(void)                    { }
+__STATIC_FORCEINLINE void __ISB(void)                    { __COMPILER_BARRIER(); }
+__STATIC_FORCEINLINE void __DSB(void)                    { __COMPILER_BARRIER(); }
+__STATIC_FORCEINLINE void __DMB(void)                    { __COMPILER_BARRIER(); }
+#define __BKPT(value)               ((void)(value))
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t v)          { return __builtin_bswap32(v); }
+__STATIC_FORCEINLINE uint32_t __REV16(uint32_t v)
+{
+  return ((v & 0xFF00FF00U) >> 8) | ((v & 0x00FF00FFU) << 8);
+}
+__STATIC_FORCEINLINE int16_t __REVSH(int16_t v)          { return (int16_t)__builtin_bswap16((uint16_t)v); }
+__STATIC_FORCEINLINE uint32_t __ROR(uint32_t v, uint32_t n)
+{
+  n %= 32U;
+  return (n == 0U) ? v : ((v >> n) | (v << (32U - n)));
+}
+__STATIC_FORCEINLINE uint32_t __RBIT(uint32_t v)
+{
+  uint32_t r = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < 32U; i++)
+  {
+    r = (r << 1) | ((v >> i) & 1U);
+  }
+  return r;
+}
+#define __CLZ(v)                    ((uint8_t)(((v) == 0U) ? 32U : (uint32_t)__builtin_clz(v)))
+
+__STATIC_FORCEINLINE int32_t __SSAT(int32_t val, uint32_t sat)
+{
+  if ((sat >= 1U) && (sat <= 32U))
+  {
+    const int32_t max = (int32_t)((1U << (sat - 1U)) - 1U);
+    const int32_t min = -1 - max;
+
+    return (val > max) ? max : ((val < min) ? min : val);
+  }
+  return val;
+}
+
+__STATIC_FORCEINLINE uint32_t __USAT(int32_t val, uint32_t sat)
+{
+  if (sat <= 31U)
+  {
+    const uint32_t max = ((1U << sat) - 1U);
+
+    return (val > (int32_t)max) ? max : ((val < 0) ? 0U : (uint32_t)val);
+  }
+  return (uint32_t)val;
+}
+
+/* SIMD intrinsics that arm_math.h (CMSIS-DSP) uses with ARM_MATH_CM4 */
+__STATIC_FORCEINLINE int32_t __QADD(int32_t a, int32_t b)
+{
+  int64_t sum = (int64_t)a + b;
+
+  return (sum > INT32_MAX) ? INT32_MAX : ((sum < INT32_MIN) ? INT32_MIN : (int32_t)sum);
+}
+
+__STATIC_FORCEINLINE int32_t __QSUB(int32_t a, int32_t b)
+{
+  int64_t diff = (int64_t)a - b;
+
+  return (diff > INT32_MAX) ? INT32_MAX : ((diff < INT32_MIN) ? INT32_MIN : (int32_t)diff);
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUAD(uint32_t a, uint32_t b)
+{
+  return (uint32_t)(((int32_t)(int16_t)a * (int16_t)b) + ((int32_t)(int16_t)(a >> 16) * (int16_t)(b >> 16)));
+}
+
+__STATIC_FORCEINLINE uint64_t __SMLALD(uint32_t a, uint32_t b, uint64_t acc)
+{
+  return acc + (uint64_t)(((int64_t)(int16_t)a * (int16_t)b) + ((int64_t)(int16_t)(a >> 16) * (int16_t)(b >> 16)));
+}
+
+#endif /* __SIM_CMSIS_H */
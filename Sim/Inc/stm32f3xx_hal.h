@@ -0,0 +1,140 @@
+/**
+  ******************************************************************************
+  * @file           : stm32f3xx_hal.h (host simulation)
+  * @brief          : Wraps the real HAL header for the host build
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Sim/Inc is searched before the driver directories, so every Core module
+  * that includes "stm32f3xx_hal.h" gets the real HAL types, constants and
+  * prototypes, with the peripheral instance macros re-pointed at plain
+  * memory owned by the simulator (Sim/Src/sim_hal.c). Register accesses in
+  * application code then read and write that memory instead of faulting.
+  * CAN keeps its real address: Sim/Src/sim_can.c maps the bxCAN registers
+  * there through Sim/Src/sim_mmio.c, so Core/Src/can.c runs unchanged.
+  */
+
+#ifndef __SIM_STM32F3xx_HAL_H
+#define __SIM_STM32F3xx_HAL_H
+
+#include_next "stm32f3xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Simulated peripheral register blocks --------------------------------------*/
+extern RCC_TypeDef          Sim_RCC;
+extern GPIO_TypeDef         Sim_GPIOA;
+extern GPIO_TypeDef         Sim_GPIOB;
+extern GPIO_TypeDef         Sim_GPIOF;
+extern ADC_TypeDef          Sim_ADC1;
+extern ADC_Common_TypeDef   Sim_ADC12_COMMON;
+extern FLASH_TypeDef        Sim_FLASH;
+extern PWR_TypeDef          Sim_PWR;
+extern RTC_TypeDef          Sim_RTC;
+extern SYSCFG_TypeDef       Sim_SYSCFG;
+extern EXTI_TypeDef         Sim_EXTI;
+extern CRC_TypeDef          Sim_CRC;
+extern IWDG_TypeDef         Sim_IWDG;
+extern USART_TypeDef        Sim_USART3;
+extern DMA_Channel_TypeDef  Sim_DMA1_Channel[7];
+extern DBGMCU_TypeDef       Sim_DBGMCU;
+extern SCB_Type             Sim_SCB;
+extern SysTick_Type         Sim_SysTick;
+extern NVIC_Type            Sim_NVIC;
+extern ITM_Type             Sim_ITM;
+extern DWT_Type             Sim_DWT;
+extern TPI_Type             Sim_TPI;
+extern CoreDebug_Type       Sim_CoreDebug;
+
+#undef RCC
+#undef GPIOA
+#undef GPIOB
+#undef GPIOF
+#undef ADC1
+#undef ADC12_COMMON
+#undef FLASH
+#undef PWR
+#undef RTC
+#undef SYSCFG
+#undef EXTI
+#undef CRC
+#undef IWDG
+#undef USART3
+#undef DMA1_Channel1
+#undef DMA1_Channel2
+#undef DMA1_Channel3
+#undef DMA1_Channel4
+#undef DMA1_Channel5
+#undef DMA1_Channel6
+#undef DMA1_Channel7
+#undef DBGMCU
+#undef SCB
+#undef SysTick
+#undef NVIC
+#undef ITM
+#undef DWT
+#undef TPI
+#undef CoreDebug
+
+#define RCC                 (&Sim_RCC)
+#define GPIOA               (&Sim_GPIOA)
+#define GPIOB               (&Sim_GPIOB)
+#define GPIOF               (&Sim_GPIOF)
+#define ADC1                (&Sim_ADC1)
+#define ADC12_COMMON        (&Sim_ADC12_COMMON)
+#define FLASH               (&Sim_FLASH)
+#define PWR                 (&Sim_PWR)
+#define RTC                 (&Sim_RTC)
+#define SYSCFG              (&Sim_SYSCFG)
+#define EXTI                (&Sim_EXTI)
+#define CRC                 (&Sim_CRC)
+#define IWDG                (&Sim_IWDG)
+#define USART3              (&Sim_USART3)
+#define DMA1_Channel1       (&Sim_DMA1_Channel[0])
+#define DMA1_Channel2       (&Sim_DMA1_Channel[1])
+#define DMA1_Channel3       (&Sim_DMA1_Channel[2])
+#define DMA1_Channel4       (&Sim_DMA1_Channel[3])
+#define DMA1_Channel5       (&Sim_DMA1_Channel[4])
+#define DMA1_Channel6       (&Sim_DMA1_Channel[5])
+#define DMA1_Channel7       (&Sim_DMA1_Channel[6])
+#define DBGMCU              (&Sim_DBGMCU)
+#define SCB                 (&Sim_SCB)
+#define SysTick             (&Sim_SysTick)
+#define NVIC                (&Sim_NVIC)
+#define ITM                 (&Sim_ITM)
+#define DWT                 (&Sim_DWT)
+#define TPI                 (&Sim_TPI)
+#define CoreDebug           (&Sim_CoreDebug)
+
+/* Bit-band aliases have no host equivalent, write the register instead */
+#undef __HAL_RCC_RTC_ENABLE
+#undef __HAL_RCC_RTC_DISABLE
+#define __HAL_RCC_RTC_ENABLE()      SET_BIT(RCC->BDCR, RCC_BDCR_RTCEN)
+#define __HAL_RCC_RTC_DISABLE()     CLEAR_BIT(RCC->BDCR, RCC_BDCR_RTCEN)
+
+/* Factory calibration words live in system memory on the target */
+extern uint16_t Sim_Temp30Cal;
+extern uint16_t Sim_Temp110Cal;
+#define TEMP30_CAL_ADDR     (&Sim_Temp30Cal)
+#define TEMP110_CAL_ADDR    (&Sim_Temp110Cal)
+
+/* The CPU accounting reads the cycle counter through the handler model */
+uint32_t Sim_CpuCycles(void);
+#define CPU_CYCLES()        Sim_CpuCycles()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_STM32F3xx_HAL_H */
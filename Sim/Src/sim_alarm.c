@@ -0,0 +1,406 @@
+/**
+  ******************************************************************************
+  * @file           : sim_alarm.c
+  * @brief          : Temperature alarm check on the analog watchdog model
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Always on. sim_hal.c models analog watchdog 1 on the polled conversions
+  * and calls SimAlarm_Conversion() with each code before it raises the ADC
+  * interrupt. A reference state machine runs on the same codes, with the
+  * thresholds the parameters give at that time, and checks that:
+  *
+  *   - the window in ADC1 TR1 is the one for the reference state, or the
+  *     analog watchdog is off without valid thresholds; a threshold change
+  *     may take up to SIM_ALARM_STALE_MAX conversions to reach it
+  *   - the interrupt left no AWD1 flag behind
+  *   - every change goes onto the bus as one alarm message (PGN 65282),
+  *     in order, with its state, count, code and temperature, within
+  *     SIM_ALARM_LATENCY_US of the conversion; a message the firmware
+  *     counts as lost may be missing
+  *   - the firmware's counters and state end where the reference does
+  *
+  * -A high,low[,hyst]@seconds sends the thresholds and the hysteresis, in
+  * degC, as PARAM_SET commands at that time. A failed check makes the run
+  * exit with status 1.
+  */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "alarm.h"
+#include "boot.h"
+#include "params.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_ALARM_ADDRESS       0x86U
+#define SIM_ALARM_LATENCY_US    2000U     /* conversion to the end of the message */
+#define SIM_ALARM_STALE_MAX     2U        /* conversions before a change applies */
+#define SIM_ALARM_EXPECTED      64U       /* changes not yet on the bus */
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t state;
+  uint8_t seq;
+  uint16_t code;
+  int32_t offset;           /* PARAM_TEMP_OFFSET at the conversion */
+  uint64_t timeUs;
+} SimAlarm_Change;
+
+/* Private variables ---------------------------------------------------------*/
+static int32_t setDeciC[3];               /* -A high, low, hysteresis */
+static uint64_t setAtUs;
+
+static Alarm_Codes codes;                 /* reference thresholds */
+static int started;
+static uint32_t stale;
+static uint8_t state = ALARM_STATE_NORMAL;
+static uint32_t changes;
+static uint32_t raised;
+static uint32_t cleared;
+static uint32_t conversions;
+static uint32_t outside;
+
+static SimAlarm_Change expected[SIM_ALARM_EXPECTED];
+static uint32_t head;
+static uint32_t tail;
+static uint32_t skipped;                  /* expected, counted lost */
+
+static uint32_t messages;
+static uint32_t latencyMaxUs;
+
+static uint32_t failures;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  if (failures == 0U)
+  {
+    fprintf(stderr, "sim: alarm: %s at %.6f s\n", what, (double)Sim_NowUs / 1e6);
+  }
+  failures++;
+}
+
+static void sendParam(uint16_t key, int32_t value, uint64_t timeUs)
+{
+  CAN_Frame set;
+
+  memset(&set, 0xFF, sizeof(set));
+  set.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, SIM_ALARM_ADDRESS);
+  set.dlc = 8;
+  set.data[0] = PARAMS_CMD_SET;
+  set.data[1] = (uint8_t)key;
+  set.data[2] = (uint8_t)(key >> 8);
+  set.data[3] = (uint8_t)value;
+  set.data[4] = (uint8_t)((uint32_t)value >> 8);
+  set.data[5] = (uint8_t)((uint32_t)value >> 16);
+  set.data[6] = (uint8_t)((uint32_t)value >> 24);
+  if (SimCan_Inject(&set, timeUs, SIM_CAN_ORIGIN_MODEL) != 0)
+  {
+    fprintf(stderr, "sim: alarm: cannot queue PARAM_SET\n");
+    exit(2);
+  }
+}
+
+static void thresholds(Alarm_Codes *want)
+{
+  (void)Alarm_Thresholds(want, (int32_t)Params_Get(PARAM_ALARM_HIGH), (int32_t)Params_Get(PARAM_ALARM_LOW),
+                         (int32_t)Params_Get(PARAM_ALARM_HYST), (int32_t)Params_Get(PARAM_TEMP_OFFSET),
+                         Sim_Cfg.cal30, Sim_Cfg.cal110);
+}
+
+static int sameCodes(const Alarm_Codes *a, const Alarm_Codes *b)
+{
+  return (a->high == b->high) && (a->highClear == b->highClear) && (a->low == b->low) &&
+         (a->lowClear == b->lowClear) && (a->falling == b->falling) && (a->valid == b->valid);
+}
+
+/* The analog watchdog is set up as the reference expects */
+static int windowMatches(const Alarm_Codes *want)
+{
+  uint16_t low;
+  uint16_t high;
+
+  if (!want->valid)
+  {
+    return (ADC1->CFGR & ADC_CFGR_AWD1EN) == 0U;
+  }
+  Alarm_Window(want, state, &low, &high);
+  return ((ADC1->CFGR & (ADC_CFGR_AWD1EN | ADC_CFGR_AWD1SGL)) == (ADC_CFGR_AWD1EN | ADC_CFGR_AWD1SGL)) &&
+         (((ADC1->CFGR & ADC_CFGR_AWD1CH) >> ADC_CFGR_AWD1CH_Pos) == 16U) &&
+         (ADC1->TR1 == (((uint32_t)high << ADC_TR1_HT1_Pos) | ((uint32_t)low << ADC_TR1_LT1_Pos)));
+}
+
+static void onAlarm(const CAN_Frame *frame, uint64_t timeUs)
+{
+  const SimAlarm_Change *change;
+  uint16_t code = (uint16_t)(frame->data[4] | ((uint16_t)frame->data[5] << 8));
+  uint16_t centiK = (uint16_t)(frame->data[2] | ((uint16_t)frame->data[3] << 8));
+  double tempC;
+  uint32_t latency;
+
+  if ((frame->data[6] & ALARM_FLAG_REQUEST) != 0U)
+  {
+    return;                       /* state on request, no change */
+  }
+  messages++;
+
+  /* Changes the firmware counted as lost never come */
+  while ((head != tail) && (expected[head % SIM_ALARM_EXPECTED].seq != frame->data[1]) &&
+         (skipped < alarmStats.lost))
+  {
+    head++;
+    skipped++;
+  }
+  if (head == tail)
+  {
+    fail("alarm message without a change");
+    return;
+  }
+  change = &expected[head % SIM_ALARM_EXPECTED];
+  head++;
+
+  tempC = 30.0 + ((double)change->code - (double)Sim_Cfg.cal30) * 80.0 /
+          ((double)Sim_Cfg.cal110 - (double)Sim_Cfg.cal30) + (double)change->offset / 100.0;
+  if ((frame->dlc != 8U) || (frame->data[0] != change->state) || (frame->data[1] != change->seq) ||
+      (code != change->code) || (frame->data[6] != 0xFCU) || (frame->data[7] != 0xFFU) ||
+      (fabs((double)centiK / 100.0 - 273.15 - tempC) > 0.006))
+  {
+    fail("alarm message differs from the change");
+  }
+  latency = (uint32_t)(timeUs - change->timeUs);
+  latencyMaxUs = (latency > latencyMaxUs) ? latency : latencyMaxUs;
+  if (latency > SIM_ALARM_LATENCY_US)
+  {
+    fail("alarm message late");
+  }
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  (void)ctx;
+  if ((origin == SIM_CAN_ORIGIN_NODE) && ((frame->id & CAN_FRAME_EXT) != 0U) &&
+      (((id >> 8) & 0x3FFFFUL) == ALARM_PGN))
+  {
+    if (((id >> 26) & 7U) != ALARM_PRIO)
+    {
+      fail("alarm message priority");
+    }
+    onAlarm(frame, timeUs);
+  }
+}
+
+static const char *stateName(uint8_t s)
+{
+  return (s == ALARM_STATE_HIGH) ? "high" : ((s == ALARM_STATE_LOW) ? "low" : "normal");
+}
+
+static double degC(uint16_t rising)
+{
+  double code = codes.falling ? (double)(ALARM_CODE_MAX - rising) : (double)rising;
+
+  return 30.0 + (code - (double)Sim_Cfg.cal30) * 80.0 / ((double)Sim_Cfg.cal110 - (double)Sim_Cfg.cal30) +
+         (double)(int32_t)Params_Get(PARAM_TEMP_OFFSET) / 100.0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Parses -A, queues its PARAM_SET commands and taps the bus
+  * @retval None
+  */
+void SimAlarm_Init(void)
+{
+  if (Sim_Cfg.alarmSpec != NULL)
+  {
+    const char *p = Sim_Cfg.alarmSpec;
+    char *end;
+    double value[3] = { 0.0, 0.0, 0.0 };
+    uint32_t n;
+
+    for (n = 0; n < 3U; n++)
+    {
+      value[n] = strtod(p, &end);
+      if ((end == p) || ((*end != ',') && (*end != '@') && (*end != '\0')))
+      {
+        n = 0;
+        break;
+      }
+      p = end + 1;
+      if (*end != ',')
+      {
+        n++;
+        break;
+      }
+    }
+    if ((n < 2U) || (*end == ','))
+    {
+      fprintf(stderr, "sim: -A %s: high,low[,hyst]@seconds, degC\n", Sim_Cfg.alarmSpec);
+      exit(2);
+    }
+    setAtUs = (*end == '@') ? (uint64_t)(strtod(end + 1, NULL) * 1e6) : 0U;
+    for (n = 0; n < 3U; n++)
+    {
+      setDeciC[n] = (int32_t)lround(value[n] * 10.0);
+    }
+    sendParam(PARAM_ALARM_HIGH, setDeciC[0], setAtUs);
+    sendParam(PARAM_ALARM_LOW, setDeciC[1], setAtUs);
+    sendParam(PARAM_ALARM_HYST, setDeciC[2], setAtUs);
+  }
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Runs the reference on a conversion, before the analog watchdog
+  *         looks at it
+  * @param  code: converted code
+  * @retval None
+  */
+void SimAlarm_Conversion(uint16_t code)
+{
+  Alarm_Codes want;
+  uint16_t low;
+  uint16_t high;
+  uint8_t next;
+
+  conversions++;
+  if ((Sim_AdcFlags() & ADC_ISR_AWD1) != 0U)
+  {
+    fail("analog watchdog flag left set");
+  }
+
+  thresholds(&want);
+  if (!started || sameCodes(&want, &codes) || windowMatches(&want))
+  {
+    codes = want;
+    stale = 0;
+    started = 1;
+  }
+  else if (++stale > SIM_ALARM_STALE_MAX)
+  {
+    fail("threshold change not applied");
+  }
+  if (!windowMatches(&codes))
+  {
+    fail("analog watchdog window differs from the reference");
+  }
+  if (!codes.valid)
+  {
+    return;
+  }
+
+  next = Alarm_Classify(&codes, state, code);
+  Alarm_Window(&codes, state, &low, &high);
+  if ((code < low) || (code > high))
+  {
+    outside++;
+  }
+  else if (next != state)
+  {
+    fail("state changes inside the window");
+  }
+  if (next == state)
+  {
+    return;
+  }
+  if (next == ALARM_STATE_NORMAL)
+  {
+    cleared++;
+  }
+  else
+  {
+    raised++;
+  }
+  state = next;
+  changes++;
+  if ((tail - head) < SIM_ALARM_EXPECTED)
+  {
+    SimAlarm_Change *change = &expected[tail % SIM_ALARM_EXPECTED];
+
+    change->state = next;
+    change->seq = (uint8_t)changes;
+    change->code = code;
+    change->offset = (int32_t)Params_Get(PARAM_TEMP_OFFSET);
+    change->timeUs = Sim_NowUs;
+    tail++;
+  }
+  else
+  {
+    fail("too many alarm messages outstanding");
+  }
+}
+
+/**
+  * @brief  Checks the firmware's counters and that every change went out
+  * @retval 1 if a check failed
+  */
+int SimAlarm_Close(void)
+{
+  if ((Sim_AdcFlags() & ADC_ISR_AWD1) != 0U)
+  {
+    fail("analog watchdog flag left set");
+  }
+  if ((alarmStats.raised != raised) || (alarmStats.cleared != cleared) || (Alarm_State() != state))
+  {
+    fail("firmware alarms differ from the reference");
+  }
+  if (alarmStats.interrupts != outside)
+  {
+    fail("analog watchdog interrupts differ from the conversions outside the window");
+  }
+  while ((head != tail) && (Sim_NowUs - expected[head % SIM_ALARM_EXPECTED].timeUs > SIM_ALARM_LATENCY_US))
+  {
+    if (skipped < alarmStats.lost)
+    {
+      skipped++;
+    }
+    else
+    {
+      fail("alarm message missing");
+    }
+    head++;
+  }
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints the thresholds, the changes and the messages
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimAlarm_Report(FILE *out, double seconds)
+{
+  (void)seconds;
+  fprintf(out, "===== Temperature alarms =====\n");
+  if (codes.valid)
+  {
+    fprintf(out, "  thresholds   %10.1f degC high, cleared at %.1f; %.1f degC low, cleared at %.1f\n",
+            degC(codes.high), degC(codes.highClear), degC(codes.low), degC(codes.lowClear));
+  }
+  else
+  {
+    fprintf(out, "  thresholds   %10s\n", "off");
+  }
+  fprintf(out, "  conversions  %10lu, %lu outside the window\n", (unsigned long)conversions,
+          (unsigned long)outside);
+  fprintf(out, "  alarms       %10lu raised, %lu cleared, %s now\n", (unsigned long)raised,
+          (unsigned long)cleared, stateName(state));
+  fprintf(out, "  messages     %10lu, %lu lost, latency max %lu us\n", (unsigned long)messages,
+          (unsigned long)alarmStats.lost, (unsigned long)latencyMaxUs);
+  fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+}
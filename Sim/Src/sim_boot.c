@@ -0,0 +1,673 @@
+/**
+  ******************************************************************************
+  * @file           : sim_boot.c
+  * @brief          : Uploader model and update check for the bootloader build
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Only in the BOOT=1 build, which runs Boot/Src/bootloader.c instead of the
+  * application over the same bus and flash models; the flash model then
+  * covers the application area as well as the parameter pages.
+  *
+  * -U file|bytes sends an image the way Tools/canboot.c does: PING until
+  * the bootloader answers, START, the blocks with up to the node's window
+  * unacknowledged (go-back-N on a NAK or after SIM_BOOT_ACK_US without a
+  * response), END and RUN. A number instead of a file name sends a
+  * synthetic image of that many bytes, seeded with -s, with a vector table
+  * the bootloader accepts. The backup register is set as the application
+  * does for ENTER, so the bootloader stays even over a valid image.
+  *
+  * The update time is taken from the first PING to the END response, in
+  * virtual time, and split into erase, stream and verify. The check wants
+  * the END response OK, the application area equal to the image and the
+  * RUN response OK; an image larger than BOOT_APP_MAX_SIZE must be refused
+  * at START instead. A failed check makes the run exit with status 1.
+  *
+  * Without -U the bootloader starts the application if one is valid: the
+  * run ends at the hand-over, in HAL_DeInit().
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "boot.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_BOOT_ADDRESS        0xFEU     /* the uploader, canboot's default */
+#define SIM_BOOT_IMAGE_MAX      (64UL * 1024UL)   /* offered, not accepted */
+#define SIM_BOOT_BLOCKS         (SIM_BOOT_IMAGE_MAX / BOOT_BLOCK_SIZE)
+#define SIM_BOOT_AHEAD          8U        /* frames queued ahead of the bus */
+#define SIM_BOOT_PING_US        250000U
+#define SIM_BOOT_PINGS          20U
+#define SIM_BOOT_ACK_US         1000000U
+#define SIM_BOOT_ERASE_US       10000000U
+#define SIM_BOOT_RETRIES        8U
+#define SIM_BOOT_END_US         100000U   /* run on after the session */
+
+enum
+{
+  SIM_BOOT_OFF = 0,
+  SIM_BOOT_PING,
+  SIM_BOOT_START,
+  SIM_BOOT_STREAM,
+  SIM_BOOT_END,
+  SIM_BOOT_RUN,
+  SIM_BOOT_DONE
+};
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t image[SIM_BOOT_IMAGE_MAX];
+static uint32_t imageSize;
+static uint32_t imageCrc;
+static int synthetic;
+
+static uint32_t state;
+static uint64_t deadlineUs = UINT64_MAX;
+static uint32_t pings;
+static uint32_t window;
+
+/* Go-back-N stream, as canboot's streamBlocks() */
+static uint32_t blocks;
+static uint8_t acked[SIM_BOOT_BLOCKS];
+static uint8_t retries[SIM_BOOT_BLOCKS];
+static uint32_t base;
+static uint32_t next;
+static uint32_t inFlight;
+static uint32_t done;
+static uint32_t sends;
+
+/* Block being handed to the bus, SIM_BOOT_AHEAD frames at a time */
+static uint32_t sending = UINT32_MAX;
+static uint32_t sendingFrame;
+static uint32_t queued;
+
+static uint64_t startUs = UINT64_MAX;
+static uint64_t erasedUs;
+static uint64_t streamedUs;
+static uint64_t verifiedUs;
+static uint8_t startStatus = 0xFFU;
+static uint8_t endStatus = 0xFFU;
+static uint8_t runStatus = 0xFFU;
+static uint32_t nodeCrc;
+static uint32_t mismatch = UINT32_MAX;    /* first byte differing from the image */
+static uint32_t frameBits;
+static uint32_t appStarted;
+
+static uint32_t failures;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  fprintf(stderr, "sim: boot: %s\n", what);
+  failures++;
+}
+
+/* CRC-32 register, reflected, without the final XOR: the CRC unit as the
+ * bootloader sets it up */
+static uint32_t crcUpdate(uint32_t crc, const uint8_t *data, uint32_t length)
+{
+  uint32_t i;
+  int k;
+
+  for (i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    for (k = 0; k < 8; k++)
+    {
+      crc = ((crc & 1U) != 0U) ? (0xEDB88320UL ^ (crc >> 1)) : (crc >> 1);
+    }
+  }
+  return crc;
+}
+
+/* zlib crc32(), as canboot computes it */
+static uint32_t crc32(const uint8_t *data, uint32_t length)
+{
+  return ~crcUpdate(0xFFFFFFFFUL, data, length);
+}
+
+static void putLe32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+/* A code-like image: xorshift words, the odd erased word the bootloader
+ * skips, an initial SP at the top of SRAM and a Thumb reset vector */
+static void makeImage(uint32_t size)
+{
+  uint32_t x = (Sim_Cfg.seed != 0U) ? Sim_Cfg.seed : 1U;
+  uint32_t i;
+
+  for (i = 0; i < size; i += 4U)
+  {
+    uint32_t word;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    word = ((x & 0x3FU) == 0U) ? 0xFFFFFFFFUL : x;
+    memcpy(&image[i], &word, ((size - i) < 4U) ? (size - i) : 4U);
+  }
+  putLe32(&image[0], SRAM_BASE + (12UL * 1024UL));
+  putLe32(&image[4], (BOOT_APP_BASE + 0x1C4UL) | 1U);
+  imageSize = size;
+}
+
+static void loadImage(const char *spec)
+{
+  char *end;
+  unsigned long size = strtoul(spec, &end, 0);
+  FILE *f;
+
+  if ((*end == '\0') && (end != spec))
+  {
+    if ((size < 8U) || (size > SIM_BOOT_IMAGE_MAX))
+    {
+      fprintf(stderr, "sim: -U %s: 8..%lu bytes\n", spec, (unsigned long)SIM_BOOT_IMAGE_MAX);
+      exit(2);
+    }
+    makeImage((uint32_t)size);
+    synthetic = 1;
+    return;
+  }
+  f = fopen(spec, "rb");
+  if (f == NULL)
+  {
+    perror(spec);
+    exit(2);
+  }
+  imageSize = (uint32_t)fread(image, 1, sizeof(image), f);
+  if ((fgetc(f) != EOF) || (imageSize < 8U))
+  {
+    fprintf(stderr, "sim: -U %s: file must be 8..%lu bytes\n", spec, (unsigned long)SIM_BOOT_IMAGE_MAX);
+    exit(2);
+  }
+  fclose(f);
+}
+
+static void fillFrame(CAN_Frame *frame, uint32_t prio, uint32_t pgn, const uint8_t *data, uint32_t count)
+{
+  memset(frame, 0, sizeof(*frame));
+  frame->id = BOOT_CAN_ID(prio, pgn, BOOT_NODE_ADDRESS, SIM_BOOT_ADDRESS) | CAN_FRAME_EXT;
+  frame->dlc = 8;
+  memset(frame->data, 0xFF, sizeof(frame->data));
+  memcpy(frame->data, data, count);
+}
+
+static void sendCommand(const uint8_t *data, uint32_t count, uint64_t timeoutUs)
+{
+  CAN_Frame frame;
+
+  fillFrame(&frame, BOOT_PRIO_CMD, BOOT_PGN_CMD, data, count);
+  if (SimCan_Inject(&frame, Sim_NowUs, SIM_CAN_ORIGIN_MODEL) == 0)
+  {
+    queued++;
+  }
+  deadlineUs = Sim_NowUs + timeoutUs;
+}
+
+/* Header plus data frames of the block, the last one short */
+static uint32_t blockFrames(uint32_t number)
+{
+  uint32_t length = imageSize - (number * BOOT_BLOCK_SIZE);
+
+  length = (length < BOOT_BLOCK_SIZE) ? length : BOOT_BLOCK_SIZE;
+  return 1U + ((length + 7U) / 8U);
+}
+
+/* Hands the next frames of the window to the bus, keeping SIM_BOOT_AHEAD
+ * queued; canboot's sendmmsg() of a whole block blocks the same way on the
+ * short netdev queue */
+static void feed(void)
+{
+  while ((state == SIM_BOOT_STREAM) && (queued < SIM_BOOT_AHEAD))
+  {
+    uint32_t offset;
+    CAN_Frame frame;
+
+    if (sending == UINT32_MAX)
+    {
+      while ((next < blocks) && acked[next])
+      {
+        next++;
+      }
+      if ((inFlight >= window) || (next >= blocks))
+      {
+        return;
+      }
+      sending = next++;
+      sendingFrame = 0;
+      sends++;
+      inFlight++;
+    }
+
+    offset = sending * BOOT_BLOCK_SIZE;
+    if (sendingFrame == 0U)
+    {
+      uint32_t length = ((imageSize - offset) < BOOT_BLOCK_SIZE) ? (imageSize - offset) : BOOT_BLOCK_SIZE;
+      uint8_t header[7] = { BOOT_CMD_BLOCK, (uint8_t)sending, (uint8_t)(sending >> 8) };
+
+      putLe32(&header[3], crc32(&image[offset], length));
+      fillFrame(&frame, BOOT_PRIO_CMD, BOOT_PGN_CMD, header, sizeof(header));
+    }
+    else
+    {
+      uint32_t at = offset + ((sendingFrame - 1U) * 8U);
+
+      fillFrame(&frame, BOOT_PRIO_DATA, BOOT_PGN_DATA, &image[at], ((imageSize - at) < 8U) ? (imageSize - at) : 8U);
+    }
+    if (SimCan_Inject(&frame, Sim_NowUs, SIM_CAN_ORIGIN_MODEL) != 0)
+    {
+      return;
+    }
+    queued++;
+    if (++sendingFrame == blockFrames(sending))
+    {
+      sending = UINT32_MAX;
+      deadlineUs = Sim_NowUs + SIM_BOOT_ACK_US;
+    }
+  }
+}
+
+/* Go-back-N: the stream starts again at the given block */
+static void restart(uint32_t number)
+{
+  next = number;
+  inFlight = 0;
+}
+
+static void finish(void)
+{
+  state = SIM_BOOT_DONE;
+  deadlineUs = UINT64_MAX;
+  if ((Sim_Cfg.durationUs == 0U) || (Sim_Cfg.durationUs > (Sim_NowUs + SIM_BOOT_END_US)))
+  {
+    Sim_Cfg.durationUs = Sim_NowUs + SIM_BOOT_END_US;
+  }
+}
+
+static void startStream(void)
+{
+  state = SIM_BOOT_STREAM;
+  erasedUs = Sim_NowUs;
+  blocks = (imageSize + BOOT_BLOCK_SIZE - 1U) / BOOT_BLOCK_SIZE;
+  deadlineUs = Sim_NowUs + SIM_BOOT_ACK_US;
+  feed();
+}
+
+static void onBlockResponse(const uint8_t *rsp)
+{
+  uint32_t number = (uint32_t)rsp[2] | ((uint32_t)rsp[3] << 8);
+
+  deadlineUs = Sim_NowUs + SIM_BOOT_ACK_US;
+  if (inFlight != 0U)
+  {
+    inFlight--;
+  }
+  if ((number >= blocks) || acked[number])
+  {
+    return;
+  }
+  switch (rsp[1])
+  {
+    case BOOT_OK:
+      acked[number] = 1;
+      done++;
+      while ((base < blocks) && acked[base])
+      {
+        base++;
+      }
+      break;
+    case BOOT_ERR_CRC:
+    case BOOT_ERR_INCOMPLETE:
+    case BOOT_ERR_BUSY:
+      if ((rsp[1] != BOOT_ERR_BUSY) && (++retries[number] > SIM_BOOT_RETRIES))
+      {
+        fail("block NAKed too often");
+        finish();
+        return;
+      }
+      if (number < next)
+      {
+        restart(number);
+      }
+      break;
+    default:
+      fail("block refused");
+      finish();
+      return;
+  }
+
+  if (done == blocks)
+  {
+    uint8_t cmd = BOOT_CMD_END;
+
+    state = SIM_BOOT_END;
+    streamedUs = Sim_NowUs;
+    sendCommand(&cmd, 1, 2U * SIM_BOOT_ACK_US);
+  }
+}
+
+static void onResponse(const uint8_t *rsp)
+{
+  uint8_t cmd[8];
+
+  switch (state)
+  {
+    case SIM_BOOT_PING:
+      if (rsp[0] != (BOOT_CMD_PING | BOOT_RSP))
+      {
+        return;
+      }
+      window = ((rsp[3] == 0U) || (rsp[3] > BOOT_WINDOW)) ? 1U : rsp[3];
+      cmd[0] = BOOT_CMD_START;
+      cmd[1] = (uint8_t)imageSize;
+      cmd[2] = (uint8_t)(imageSize >> 8);
+      cmd[3] = (uint8_t)(imageSize >> 16);
+      putLe32(&cmd[4], imageCrc);
+      state = SIM_BOOT_START;
+      sendCommand(cmd, 8, SIM_BOOT_ERASE_US);
+      break;
+    case SIM_BOOT_START:
+      if (rsp[0] != (BOOT_CMD_START | BOOT_RSP))
+      {
+        return;
+      }
+      startStatus = rsp[1];
+      if (startStatus == BOOT_OK)
+      {
+        startStream();
+      }
+      else
+      {
+        finish();
+      }
+      break;
+    case SIM_BOOT_STREAM:
+      if (rsp[0] == (BOOT_CMD_BLOCK | BOOT_RSP))
+      {
+        onBlockResponse(rsp);
+      }
+      break;
+    case SIM_BOOT_END:
+      if (rsp[0] == (BOOT_CMD_BLOCK | BOOT_RSP))
+      {
+        return;       /* late duplicates */
+      }
+      if (rsp[0] != (BOOT_CMD_END | BOOT_RSP))
+      {
+        return;
+      }
+      endStatus = rsp[1];
+      nodeCrc = (uint32_t)rsp[2] | ((uint32_t)rsp[3] << 8) | ((uint32_t)rsp[4] << 16) | ((uint32_t)rsp[5] << 24);
+      verifiedUs = Sim_NowUs;
+      if (endStatus != BOOT_OK)
+      {
+        finish();
+        return;
+      }
+      for (mismatch = 0; mismatch < imageSize; mismatch++)
+      {
+        if (((const uint8_t *)BOOT_APP_BASE)[mismatch] != image[mismatch])
+        {
+          break;
+        }
+      }
+      cmd[0] = BOOT_CMD_RUN;
+      state = SIM_BOOT_RUN;
+      sendCommand(cmd, 1, SIM_BOOT_ACK_US);
+      break;
+    case SIM_BOOT_RUN:
+      if (rsp[0] == (BOOT_CMD_RUN | BOOT_RSP))
+      {
+        runStatus = rsp[1];
+        finish();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  (void)timeUs;
+  (void)ctx;
+
+  if ((frame->id & CAN_FRAME_EXT) == 0U)
+  {
+    return;
+  }
+  if ((origin == SIM_CAN_ORIGIN_MODEL) && (BOOT_ID_SA(id) == SIM_BOOT_ADDRESS))
+  {
+    queued--;
+    frameBits += SimCan_FrameBits(frame);
+    feed();
+  }
+  else if ((origin == SIM_CAN_ORIGIN_NODE) && (BOOT_ID_PGN(id) == BOOT_PGN_CMD) &&
+           (BOOT_ID_SA(id) == BOOT_NODE_ADDRESS) && (frame->dlc >= 2U) && ((frame->data[0] & BOOT_RSP) != 0U) &&
+           ((BOOT_ID_DA(id) == SIM_BOOT_ADDRESS) || (BOOT_ID_DA(id) == 0xFFU)))
+  {
+    onResponse(frame->data);
+    feed();
+  }
+}
+
+static const char *statusName(uint8_t status)
+{
+  static const char *names[] = { "ok", "block crc", "incomplete", "out of range",
+                                 "flash error", "busy", "bad state", "image crc",
+                                 "malformed patch", "installed image is not the patch base",
+                                 "out of sequence" };
+
+  if (status == 0xFFU)
+  {
+    return "no response";
+  }
+  return (status < (sizeof(names) / sizeof(names[0]))) ? names[status] : "unknown";
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Loads or makes the -U image, asks the bootloader to stay and
+  *         queues the first PING; call after Sim_Cfg is set
+  * @retval None
+  */
+void SimBoot_Init(void)
+{
+  uint8_t cmd = BOOT_CMD_PING;
+
+  if (Sim_Cfg.uploadPath == NULL)
+  {
+    return;
+  }
+  loadImage(Sim_Cfg.uploadPath);
+  imageCrc = crc32(image, imageSize);
+  Sim_RTC.BKP0R = BOOT_REQUEST_MAGIC;
+
+  SimCan_AddTap(busTap, NULL);
+  state = SIM_BOOT_PING;
+  startUs = Sim_NowUs;
+  pings = 1;
+  sendCommand(&cmd, 1, SIM_BOOT_PING_US);
+}
+
+/**
+  * @brief  Time of the next uploader timeout
+  * @retval absolute virtual time, UINT64_MAX if none
+  */
+uint64_t SimBoot_NextEventUs(void)
+{
+  return deadlineUs;
+}
+
+/**
+  * @brief  Uploader timeouts: PING again, restart the stream at the oldest
+  *         unacknowledged block, or give up
+  * @param  nowUs: current virtual time
+  * @retval None
+  */
+void SimBoot_Process(uint64_t nowUs)
+{
+  uint8_t cmd = BOOT_CMD_PING;
+
+  if (nowUs < deadlineUs)
+  {
+    return;
+  }
+  deadlineUs = UINT64_MAX;
+  switch (state)
+  {
+    case SIM_BOOT_PING:
+      if (pings++ < SIM_BOOT_PINGS)
+      {
+        sendCommand(&cmd, 1, SIM_BOOT_PING_US);
+        return;
+      }
+      fail("no bootloader response");
+      break;
+    case SIM_BOOT_STREAM:
+      if (++retries[base] <= SIM_BOOT_RETRIES)
+      {
+        restart(base);
+        deadlineUs = nowUs + SIM_BOOT_ACK_US;
+        feed();
+        return;
+      }
+      fail("block not acknowledged");
+      break;
+    default:
+      break;
+  }
+  finish();
+}
+
+/**
+  * @brief  Checks the session: image in flash, or a too large one refused
+  * @retval 1 if a check failed
+  */
+int SimBoot_Close(void)
+{
+  if (Sim_Cfg.uploadPath == NULL)
+  {
+    return 0;
+  }
+  if (imageSize > BOOT_APP_MAX_SIZE)
+  {
+    if (startStatus != BOOT_ERR_RANGE)
+    {
+      fail("image larger than the application area not refused");
+    }
+    return failures != 0U;
+  }
+  if (startStatus != BOOT_OK)
+  {
+    fail("START failed");
+  }
+  else if (endStatus != BOOT_OK)
+  {
+    fail("END failed");
+  }
+  else if (mismatch != imageSize)
+  {
+    fail("flash differs from the image");
+  }
+  else if (runStatus != BOOT_OK)
+  {
+    fail("RUN failed");
+  }
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints the update time and its parts
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimBoot_Report(FILE *out, double seconds)
+{
+  double total = (double)(verifiedUs - startUs) / 1e3;
+
+  (void)seconds;
+  if (Sim_Cfg.uploadPath == NULL)
+  {
+    fprintf(out, "===== Bootloader =====\n");
+    fprintf(out, "  application  %10s\n", appStarted ? "started" : "none valid, waiting for an update");
+    return;
+  }
+  fprintf(out, "===== Bootloader update (%lu bit/s) =====\n", (unsigned long)SimCan_Bitrate());
+  fprintf(out, "  image        %10lu bytes%s, crc32 %08lX, %lu KB application area\n", (unsigned long)imageSize,
+          synthetic ? " (synthetic)" : "", (unsigned long)imageCrc, (unsigned long)(BOOT_APP_MAX_SIZE / 1024U));
+  fprintf(out, "  START        %10s\n", statusName(startStatus));
+  if (startStatus == BOOT_OK)
+  {
+    fprintf(out, "  blocks       %10lu, window %lu, %lu resent\n", (unsigned long)blocks, (unsigned long)window,
+            (unsigned long)(sends - blocks));
+    fprintf(out, "  END          %10s, node crc32 %08lX\n", statusName(endStatus), (unsigned long)nodeCrc);
+    fprintf(out, "  RUN          %10s\n", statusName(runStatus));
+  }
+  if (endStatus == BOOT_OK)
+  {
+    fprintf(out, "  erase        %10.1f ms (PING to START response)\n", (double)(erasedUs - startUs) / 1e3);
+    fprintf(out, "  stream       %10.1f ms (START response to the last ACK)\n", (double)(streamedUs - erasedUs) / 1e3);
+    fprintf(out, "  verify       %10.1f ms (END)\n", (double)(verifiedUs - streamedUs) / 1e3);
+    fprintf(out, "  update       %10.1f ms, %.1f KB/s, uploader frames %.1f %% of the bus\n", total,
+            (total > 0.0) ? ((double)imageSize / 1024.0) / (total / 1e3) : 0.0,
+            (total > 0.0) ? (100.0 * (double)frameBits * 1e3 / (double)SimCan_Bitrate()) / total : 0.0);
+  }
+  fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+}
+
+/* HAL API the bootloader uses beyond the application's ----------------------*/
+
+/**
+  * @brief  The bootloader hands over to the application: the run ends
+  * @retval Does not return
+  */
+HAL_StatusTypeDef HAL_DeInit(void)
+{
+  const uint32_t *vectors = (const uint32_t *)BOOT_APP_BASE;
+
+  appStarted = 1;
+  fprintf(stderr, "sim: bootloader starts the application at %.6f s: SP 0x%08lX, reset 0x%08lX\n",
+          (double)Sim_NowUs / 1e6, (unsigned long)vectors[0], (unsigned long)vectors[1]);
+  Sim_Finish();
+}
+
+/* Bytes in, CRC_DR the register value without final XOR */
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc)
+{
+  HAL_CRC_MspInit(hcrc);
+  Sim_CRC.DR = 0xFFFFFFFFUL;
+  return HAL_OK;
+}
+
+uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength)
+{
+  (void)hcrc;
+  Sim_CRC.DR = crcUpdate(Sim_CRC.DR, (const uint8_t *)pBuffer, BufferLength);
+  return Sim_CRC.DR;
+}
+
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength)
+{
+  Sim_CRC.DR = 0xFFFFFFFFUL;
+  return HAL_CRC_Accumulate(hcrc, pBuffer, BufferLength);
+}
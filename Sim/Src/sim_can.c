@@ -0,0 +1,1029 @@
+/**
+  ******************************************************************************
+  * @file           : sim_can.c
+  * @brief          : Simulated bxCAN registers and bus under Core/Src/can.c
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Models the controller at register level, so the firmware's own can.c
+  * runs on it unchanged. The register block is mapped at CAN_BASE through
+  * sim_mmio.c: a TIR write with TXRQ takes the mailbox before the next
+  * instruction, RFOM0 releases the FIFO0 output mailbox at once, and the
+  * write-1-to-clear flags of MSR, TSR and RF0R, the read-only receive
+  * mailboxes and the write protection of pending transmit mailboxes behave
+  * as on the target. Three transmit mailboxes are sent by identifier or,
+  * with MCR.TXFP, in request order, and with MCR.NART the one that loses
+  * arbitration to another node completes with ALST instead of TXOK and is
+  * not retried. Receive FIFO0 is three deep and
+  * overruns as MCR.RFLM selects, and 32-bit filter banks assigned to FIFO0
+  * are matched. The HAL_CAN_xxx functions the driver calls are stubs on the
+  * same registers.
+  *
+  * The bus arbitrates by identifier and holds each frame for its exact
+  * length on the wire, bit stuffing included, at the bit rate programmed in
+  * BTR (or Sim_Cfg.bitrate). Every completed frame is passed to the
+  * registered taps (candump log, external bridges); frames from other nodes
+  * enter through SimCan_Inject(). Time stamps are taken at the start of
+  * frame in bit times as in time-triggered mode, for received frames and
+  * for mailboxes loaded with TGT (ping.h). Error frames take no bus time:
+  * SimCan_InjectError() only sets the error status and raises the status
+  * change and error interrupt.
+  */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "can.h"
+#include "sim.h"
+
+#define SIM_CAN_INBOUND_LEN   256U    /* frames from other nodes, power of two */
+#define SIM_CAN_MAX_TAPS      16U
+#define SIM_CAN_MAX_IDS       32U     /* identifiers tracked for the report */
+#define SIM_CAN_FILTER_BANKS  14U
+
+#define CAN_TSR_TME_ALL   (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)
+
+/* Register offsets in the block, as passed to regWrite() */
+#define CAN_REG(field)    ((uint32_t)offsetof(CAN_TypeDef, field))
+
+/* Reset values (RM0364 CAN register map) */
+#define SIM_CAN_MCR_DBF   0x00010000UL    /* debug freeze, not in the device header */
+#define SIM_CAN_MCR_RESET (SIM_CAN_MCR_DBF | CAN_MCR_SLEEP)
+#define SIM_CAN_MSR_RESET 0x00000C02UL    /* SAMP, RX, SLAK */
+#define SIM_CAN_TSR_RESET CAN_TSR_TME_ALL
+#define SIM_CAN_BTR_RESET 0x01230000UL
+
+/* Controller model: the registers as the firmware sees them, written here */
+static CAN_TypeDef *regs;
+static CAN_Frame mailbox[3];            /* decoded at the transmit request */
+static uint32_t mailboxFull;            /* bit per mailbox with TXRQ set */
+static uint32_t mailboxTgt;             /* bit per mailbox loaded with TGT */
+static uint32_t mailboxOrder[3];        /* request count, for MCR.TXFP */
+static uint32_t loads;
+static CAN_Frame fifo0[3];
+static uint32_t fifo0Count;
+static uint32_t fifo0Overruns;          /* frames lost to a full FIFO0 */
+static int joinedMidFrame;              /* woken during a frame: it is missed */
+static uint32_t framesLostAsleep;
+
+/* Bus model */
+typedef struct
+{
+  CAN_Frame frame;
+  uint64_t readyUs;
+  uint32_t origin;
+} InboundFrame;
+
+static InboundFrame inbound[SIM_CAN_INBOUND_LEN];
+static uint32_t inHead;
+static uint32_t inTail;
+
+static struct
+{
+  int active;
+  int source;                           /* mailbox 0..2, or -1 for inbound */
+  uint32_t origin;
+  CAN_Frame frame;
+  uint64_t startUs;
+  uint64_t doneUs;
+} bus;
+static uint64_t busIdleUs;
+static uint64_t busBusyUs;
+static uint32_t busFrames;
+static uint32_t inboundDropped;
+static uint32_t arbitrationLost;         /* mailboxes dropped under NART */
+
+static struct
+{
+  SimCan_TapFn fn;
+  void *ctx;
+} taps[SIM_CAN_MAX_TAPS];
+static uint32_t tapCount;
+
+static struct
+{
+  uint32_t id;
+  uint32_t count;
+  uint64_t firstUs;
+  uint64_t lastUs;
+} idStats[SIM_CAN_MAX_IDS];
+static uint32_t idCount;
+
+static FILE *logFile;
+static char logIfName[16];
+
+/* Bus timing ----------------------------------------------------------------*/
+
+/**
+  * @brief  Bit rate used for frame timing
+  * @retval bit/s, from Sim_Cfg.bitrate or PCLK1 / (BTR prescaler * bit time in tq)
+  */
+uint32_t SimCan_Bitrate(void)
+{
+  uint32_t tq;
+
+  if (Sim_Cfg.bitrate != 0U)
+  {
+    return Sim_Cfg.bitrate;
+  }
+  tq = 1U + (((regs->BTR & CAN_BTR_TS1) >> CAN_BTR_TS1_Pos) + 1U) + (((regs->BTR & CAN_BTR_TS2) >> CAN_BTR_TS2_Pos) + 1U);
+  return (uint32_t)SIM_PCLK1_HZ / (((regs->BTR & CAN_BTR_BRP) + 1U) * tq);
+}
+
+/**
+  * @brief  Length of a frame on the wire, stuff bits and interframe space included
+  * @param  frame: frame to measure
+  * @retval bit times
+  */
+uint32_t SimCan_FrameBits(const CAN_Frame *frame)
+{
+  uint8_t bits[128];
+  uint32_t n = 0;
+  uint32_t rtr = ((frame->id & CAN_FRAME_RTR) != 0U) ? 1U : 0U;
+  uint32_t dlc = (frame->dlc > 8U) ? 8U : frame->dlc;
+  uint32_t crc = 0;
+  uint32_t stuff = 0;
+  uint32_t run = 1;
+  uint8_t last;
+  uint32_t i;
+
+#define PUSH(value, width) \
+  do { int b_; for (b_ = (int)(width) - 1; b_ >= 0; b_--) { bits[n++] = (uint8_t)(((value) >> b_) & 1U); } } while (0)
+
+  PUSH(0U, 1);                                          /* SOF */
+  if ((frame->id & CAN_FRAME_EXT) != 0U)
+  {
+    PUSH((frame->id >> 18) & 0x7FFU, 11);
+    PUSH(3U, 2);                                        /* SRR, IDE */
+    PUSH(frame->id & 0x3FFFFU, 18);
+    PUSH(rtr, 1);
+    PUSH(0U, 2);                                        /* r1, r0 */
+  }
+  else
+  {
+    PUSH(frame->id & 0x7FFU, 11);
+    PUSH(rtr, 1);
+    PUSH(0U, 2);                                        /* IDE, r0 */
+  }
+  PUSH(dlc, 4);
+  for (i = 0; (rtr == 0U) && (i < dlc); i++)
+  {
+    PUSH(frame->data[i], 8);
+  }
+
+  /* CRC-15, polynomial 0x4599 */
+  for (i = 0; i < n; i++)
+  {
+    uint32_t next = bits[i] ^ ((crc >> 14) & 1U);
+
+    crc = (crc << 1) & 0x7FFFU;
+    if (next != 0U)
+    {
+      crc ^= 0x4599U;
+    }
+  }
+  PUSH(crc, 15);
+#undef PUSH
+
+  /* A stuff bit follows every five equal bits and starts the next run */
+  last = bits[0];
+  for (i = 1; i < n; i++)
+  {
+    if (bits[i] != last)
+    {
+      last = bits[i];
+      run = 1;
+    }
+    else if (++run == 5U)
+    {
+      stuff++;
+      last ^= 1U;
+      run = 1;
+    }
+  }
+
+  /* CRC delimiter, ACK slot and delimiter, EOF, intermission */
+  return n + stuff + 1U + 2U + 7U + 3U;
+}
+
+static uint64_t frameTimeUs(const CAN_Frame *frame)
+{
+  uint64_t bitrate = SimCan_Bitrate();
+
+  return (((uint64_t)SimCan_FrameBits(frame) * 1000000ULL) + bitrate - 1U) / bitrate;
+}
+
+/**
+  * @brief  Time-triggered mode counter of the controller
+  * @param  us: absolute virtual time
+  * @retval bit times since the start of the run, low 16 bits
+  */
+uint16_t SimCan_BitClock(uint64_t us)
+{
+  return (uint16_t)((us * SimCan_Bitrate()) / 1000000ULL);
+}
+
+/* Arbitration field as sent on the wire: lower value wins */
+static uint32_t arbitrationKey(uint32_t id)
+{
+  uint32_t rtr = ((id & CAN_FRAME_RTR) != 0U) ? 1U : 0U;
+
+  if ((id & CAN_FRAME_EXT) != 0U)
+  {
+    return (((id >> 18) & 0x7FFU) << 21) | (3UL << 19) | ((id & 0x3FFFFU) << 1) | rtr;
+  }
+  return ((id & 0x7FFU) << 21) | (rtr << 20);
+}
+
+/* Controller model ----------------------------------------------------------*/
+/* CAN_RI0R of a frame */
+static uint32_t frameRir(const CAN_Frame *frame)
+{
+  uint32_t rir;
+
+  if ((frame->id & CAN_FRAME_EXT) != 0U)
+  {
+    rir = ((frame->id & CAN_FRAME_ID_MASK) << CAN_RI0R_EXID_Pos) | CAN_RI0R_IDE;
+  }
+  else
+  {
+    rir = (frame->id & 0x7FFU) << CAN_RI0R_STID_Pos;
+  }
+  if ((frame->id & CAN_FRAME_RTR) != 0U)
+  {
+    rir |= CAN_RI0R_RTR;
+  }
+  return rir;
+}
+
+static void updateTsr(void)
+{
+  uint32_t tsr = regs->TSR & ~(CAN_TSR_TME_ALL | CAN_TSR_CODE);
+  uint32_t mb;
+
+  for (mb = 0; mb < 3U; mb++)
+  {
+    if ((mailboxFull & (1UL << mb)) == 0U)
+    {
+      tsr |= CAN_TSR_TME0 << mb;
+    }
+  }
+  for (mb = 0; (mb < 3U) && ((mailboxFull & (1UL << mb)) != 0U); mb++)
+  {
+  }
+  regs->TSR = tsr | (((mb < 3U) ? mb : 0U) << CAN_TSR_CODE_Pos);
+}
+
+/* FMP0 and the output mailbox, which shows the oldest frame */
+static void updateRf0r(void)
+{
+  CAN_FIFOMailBox_TypeDef *out = &regs->sFIFOMailBox[0];
+  const CAN_Frame *f = &fifo0[0];
+
+  regs->RF0R = (regs->RF0R & ~(CAN_RF0R_FMP0 | CAN_RF0R_RFOM0)) | fifo0Count;
+  if (fifo0Count == 0U)
+  {
+    return;
+  }
+  out->RIR = frameRir(f);
+  out->RDTR = f->dlc | ((uint32_t)f->filter << CAN_RDT0R_FMI_Pos) | ((uint32_t)f->time << CAN_RDT0R_TIME_Pos);
+  out->RDLR = f->data[0] | ((uint32_t)f->data[1] << 8) | ((uint32_t)f->data[2] << 16) | ((uint32_t)f->data[3] << 24);
+  out->RDHR = f->data[4] | ((uint32_t)f->data[5] << 8) | ((uint32_t)f->data[6] << 16) | ((uint32_t)f->data[7] << 24);
+}
+
+/* The interrupt lines are levels: pending while a flag and its enable bit
+ * are both set */
+static void raiseIrqs(void)
+{
+  uint32_t ier = regs->IER;
+
+  if (((ier & CAN_IER_TMEIE) != 0U) && ((regs->TSR & (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2)) != 0U))
+  {
+    Sim_RaiseIrq(CAN_TX_IRQn);
+  }
+  if ((((ier & CAN_IER_FMPIE0) != 0U) && ((regs->RF0R & CAN_RF0R_FMP0) != 0U)) ||
+      (((ier & CAN_IER_FFIE0) != 0U) && ((regs->RF0R & CAN_RF0R_FULL0) != 0U)) ||
+      (((ier & CAN_IER_FOVIE0) != 0U) && ((regs->RF0R & CAN_RF0R_FOVR0) != 0U)))
+  {
+    Sim_RaiseIrq(CAN_RX0_IRQn);
+  }
+  if (((ier & CAN_IER_ERRIE) != 0U) && ((regs->MSR & CAN_MSR_ERRI) != 0U))
+  {
+    Sim_RaiseIrq(CAN_SCE_IRQn);
+  }
+}
+
+static int filterMatch(const CAN_Frame *frame, uint8_t *index)
+{
+  uint32_t rir = frameRir(frame);
+  uint8_t bank;
+
+  /* Only 32-bit banks assigned to FIFO0 are modelled */
+  for (bank = 0; bank < SIM_CAN_FILTER_BANKS; bank++)
+  {
+    uint32_t bit = 1UL << bank;
+    uint32_t fr1 = regs->sFilterRegister[bank].FR1;
+    uint32_t fr2 = regs->sFilterRegister[bank].FR2;
+
+    if (((regs->FA1R & bit) == 0U) || ((regs->FS1R & bit) == 0U) || ((regs->FFA1R & bit) != 0U))
+    {
+      continue;
+    }
+    if (((regs->FM1R & bit) == 0U) ? (((rir ^ fr1) & fr2 & ~1UL) == 0U)
+                                   : (((rir & ~1UL) == (fr1 & ~1UL)) || ((rir & ~1UL) == (fr2 & ~1UL))))
+    {
+      *index = bank;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void receiveFrame(const CAN_Frame *frame)
+{
+  CAN_Frame f = *frame;
+
+  if (((regs->MSR & CAN_MSR_INAK) != 0U) || !filterMatch(frame, &f.filter))
+  {
+    return;
+  }
+  if (((regs->MSR & CAN_MSR_SLAK) != 0U) || joinedMidFrame)
+  {
+    joinedMidFrame = 0;
+    framesLostAsleep++;
+    return;
+  }
+  f.time = SimCan_BitClock(bus.startUs);
+
+  if (fifo0Count == 3U)
+  {
+    /* RFLM = 0: the last message in the FIFO is overwritten, RFLM = 1: the
+     * new one is discarded */
+    if ((regs->MCR & CAN_MCR_RFLM) == 0U)
+    {
+      fifo0[2] = f;
+    }
+    regs->RF0R |= CAN_RF0R_FOVR0;
+    fifo0Overruns++;
+  }
+  else
+  {
+    fifo0[fifo0Count++] = f;
+    regs->RF0R |= (fifo0Count == 3U) ? CAN_RF0R_FULL0 : 0U;
+  }
+  updateRf0r();
+  raiseIrqs();
+}
+
+/* TXRQ written: the mailbox registers hold the frame */
+static void requestTx(uint32_t mb)
+{
+  const CAN_TxMailBox_TypeDef *tx = &regs->sTxMailBox[mb];
+  CAN_Frame *f = &mailbox[mb];
+  uint32_t i;
+
+  if ((tx->TIR & CAN_TI0R_IDE) != 0U)
+  {
+    f->id = ((tx->TIR >> CAN_TI0R_EXID_Pos) & CAN_FRAME_ID_MASK) | CAN_FRAME_EXT;
+  }
+  else
+  {
+    f->id = (tx->TIR >> CAN_TI0R_STID_Pos) & 0x7FFU;
+  }
+  if ((tx->TIR & CAN_TI0R_RTR) != 0U)
+  {
+    f->id |= CAN_FRAME_RTR;
+  }
+  f->dlc = (uint8_t)(tx->TDTR & CAN_TDT0R_DLC);
+  f->filter = 0;
+  f->time = 0;
+  for (i = 0; i < 4U; i++)
+  {
+    f->data[i] = (uint8_t)(tx->TDLR >> (8U * i));
+    f->data[4U + i] = (uint8_t)(tx->TDHR >> (8U * i));
+  }
+
+  /* TGT is only active in time-triggered mode */
+  mailboxFull |= 1UL << mb;
+  mailboxTgt = (((tx->TDTR & CAN_TDT0R_TGT) != 0U) && ((regs->MCR & CAN_MCR_TTCM) != 0U))
+               ? (mailboxTgt | (1UL << mb)) : (mailboxTgt & ~(1UL << mb));
+  mailboxOrder[mb] = loads++;
+  updateTsr();
+}
+
+/* Called by sim_mmio.c after each firmware write to the block; value is
+ * what was written, the model stores what the register takes */
+static void regWrite(uint32_t offset, uint32_t value, uint32_t old)
+{
+  volatile uint32_t *reg = (volatile uint32_t *)((uint8_t *)regs + offset);
+  uint32_t mb;
+
+  if (offset == CAN_REG(MSR))
+  {
+    /* ERRI, WKUI and SLAKI are cleared by writing 1, the rest is read-only */
+    *reg = old & ~(value & (CAN_MSR_ERRI | CAN_MSR_WKUI | CAN_MSR_SLAKI));
+  }
+  else if (offset == CAN_REG(TSR))
+  {
+    /* Writing RQCPx also clears TXOKx, ALSTx and TERRx; aborts are not modelled */
+    uint32_t clear = 0;
+
+    for (mb = 0; mb < 3U; mb++)
+    {
+      if ((value & (CAN_TSR_RQCP0 << (8U * mb))) != 0U)
+      {
+        clear |= (CAN_TSR_RQCP0 | CAN_TSR_TXOK0 | CAN_TSR_ALST0 | CAN_TSR_TERR0) << (8U * mb);
+      }
+    }
+    *reg = old & ~clear;
+  }
+  else if (offset == CAN_REG(RF0R))
+  {
+    /* FULL0 and FOVR0 are cleared by writing 1, RFOM0 releases the output
+     * mailbox before the next instruction */
+    *reg = old & ~(value & (CAN_RF0R_FULL0 | CAN_RF0R_FOVR0));
+    if (((value & CAN_RF0R_RFOM0) != 0U) && (fifo0Count != 0U))
+    {
+      memmove(&fifo0[0], &fifo0[1], sizeof(fifo0[0]) * 2U);
+      fifo0Count--;
+    }
+    updateRf0r();
+  }
+  else if (offset == CAN_REG(IER))
+  {
+    raiseIrqs();
+  }
+  else if (offset == CAN_REG(ESR))
+  {
+    /* Only LEC is writable */
+    *reg = (old & ~CAN_ESR_LEC) | (value & CAN_ESR_LEC);
+  }
+  else if ((offset >= CAN_REG(sTxMailBox)) && (offset < CAN_REG(sFIFOMailBox)))
+  {
+    mb = (offset - CAN_REG(sTxMailBox)) / (uint32_t)sizeof(CAN_TxMailBox_TypeDef);
+    if ((mailboxFull & (1UL << mb)) != 0U)
+    {
+      /* Write-protected while the transmission is pending */
+      *reg = old;
+    }
+    else if ((offset == CAN_REG(sTxMailBox[0].TIR) + (mb * (uint32_t)sizeof(CAN_TxMailBox_TypeDef))) &&
+             ((value & CAN_TI0R_TXRQ) != 0U))
+    {
+      requestTx(mb);
+    }
+  }
+  else if ((offset >= CAN_REG(sFIFOMailBox)) && (offset < CAN_REG(FMR)))
+  {
+    /* Receive mailboxes are read-only */
+    *reg = old;
+  }
+}
+
+static void countId(uint32_t id)
+{
+  uint32_t i;
+
+  for (i = 0; (i < idCount) && (idStats[i].id != id); i++)
+  {
+  }
+  if (i == idCount)
+  {
+    if (idCount == SIM_CAN_MAX_IDS)
+    {
+      return;
+    }
+    idStats[idCount].id = id;
+    idStats[idCount].firstUs = Sim_NowUs;
+    idCount++;
+  }
+  idStats[i].count++;
+  idStats[i].lastUs = Sim_NowUs;
+}
+
+static void completeFrame(void)
+{
+  uint32_t i;
+
+  bus.active = 0;
+  busIdleUs = bus.doneUs;
+  busFrames++;
+  countId(bus.frame.id);
+
+  if (bus.source >= 0)
+  {
+    uint32_t mb = (uint32_t)bus.source;
+    CAN_TxMailBox_TypeDef *tx = &regs->sTxMailBox[mb];
+
+    /* TIME holds the counter captured at the start of frame */
+    mailboxFull &= ~(1UL << mb);
+    tx->TIR &= ~CAN_TI0R_TXRQ;
+    tx->TDTR = (tx->TDTR & ~CAN_TDT0R_TIME) | ((uint32_t)SimCan_BitClock(bus.startUs) << CAN_TDT0R_TIME_Pos);
+    regs->TSR |= (CAN_TSR_RQCP0 | CAN_TSR_TXOK0) << (8U * mb);
+    updateTsr();
+    raiseIrqs();
+  }
+  else
+  {
+    receiveFrame(&bus.frame);
+  }
+
+  /* A sleep request takes effect once the frame on the wire is complete */
+  if ((regs->MCR & CAN_MCR_SLEEP) != 0U)
+  {
+    regs->MSR |= CAN_MSR_SLAK;
+  }
+
+  for (i = 0; i < tapCount; i++)
+  {
+    taps[i].fn(&bus.frame, Sim_NowUs, bus.origin, taps[i].ctx);
+  }
+}
+
+static uint64_t nextStartUs(void)
+{
+  uint64_t t = UINT64_MAX;
+
+  if (mailboxFull != 0U)
+  {
+    t = Sim_NowUs;
+  }
+  if ((inHead != inTail) && (inbound[inTail & (SIM_CAN_INBOUND_LEN - 1U)].readyUs < t))
+  {
+    t = inbound[inTail & (SIM_CAN_INBOUND_LEN - 1U)].readyUs;
+  }
+  if ((t != UINT64_MAX) && (t < busIdleUs))
+  {
+    t = busIdleUs;
+  }
+  return t;
+}
+
+/* MCR.NART: a mailbox that loses arbitration is not retried, it completes
+ * with ALST set and TXOK clear */
+static void loseArbitration(uint32_t mb)
+{
+  mailboxFull &= ~(1UL << mb);
+  regs->sTxMailBox[mb].TIR &= ~CAN_TI0R_TXRQ;
+  regs->TSR = (regs->TSR & ~(CAN_TSR_TXOK0 << (8U * mb))) | ((CAN_TSR_RQCP0 | CAN_TSR_ALST0) << (8U * mb));
+  arbitrationLost++;
+  updateTsr();
+  raiseIrqs();
+}
+
+static void startFrame(void)
+{
+  uint32_t bestKey = UINT32_MAX;
+  uint32_t mb;
+  int contender;
+
+  bus.source = -2;
+  for (mb = 0; mb < 3U; mb++)
+  {
+    /* TXFP = 0: lowest identifier first, then lowest mailbox number;
+     * TXFP = 1: the mailbox loaded first */
+    uint32_t key = ((regs->MCR & CAN_MCR_TXFP) != 0U) ? (mailboxOrder[mb] - loads) : arbitrationKey(mailbox[mb].id);
+
+    if (((mailboxFull & (1UL << mb)) != 0U) && ((bus.source < 0) || (key < bestKey)))
+    {
+      bestKey = key;
+      bus.source = (int)mb;
+    }
+  }
+  if (bus.source >= 0)
+  {
+    bestKey = arbitrationKey(mailbox[bus.source].id);
+  }
+  contender = bus.source;
+  if ((inHead != inTail) && (inbound[inTail & (SIM_CAN_INBOUND_LEN - 1U)].readyUs <= Sim_NowUs) &&
+      (arbitrationKey(inbound[inTail & (SIM_CAN_INBOUND_LEN - 1U)].frame.id) < bestKey))
+  {
+    bus.source = -1;
+    if ((contender >= 0) && ((regs->MCR & CAN_MCR_NART) != 0U))
+    {
+      loseArbitration((uint32_t)contender);
+    }
+  }
+
+  if (bus.source == -1)
+  {
+    bus.frame = inbound[inTail & (SIM_CAN_INBOUND_LEN - 1U)].frame;
+    bus.origin = inbound[inTail & (SIM_CAN_INBOUND_LEN - 1U)].origin;
+    inTail++;
+  }
+  else
+  {
+    bus.frame = mailbox[bus.source];
+    bus.origin = SIM_CAN_ORIGIN_NODE;
+    if ((mailboxTgt & (1UL << bus.source)) != 0U)
+    {
+      uint16_t stamp = SimCan_BitClock(Sim_NowUs);
+
+      bus.frame.data[6] = (uint8_t)stamp;
+      bus.frame.data[7] = (uint8_t)(stamp >> 8);
+    }
+  }
+  bus.active = 1;
+  bus.startUs = Sim_NowUs;
+  bus.doneUs = Sim_NowUs + frameTimeUs(&bus.frame);
+  busBusyUs += bus.doneUs - Sim_NowUs;
+}
+
+/**
+  * @brief  Time of the next bus event (end of frame or start of arbitration)
+  * @retval absolute virtual time in us, UINT64_MAX when the bus stays idle
+  */
+uint64_t SimCan_NextEventUs(void)
+{
+  return bus.active ? bus.doneUs : nextStartUs();
+}
+
+/**
+  * @brief  Runs every bus event due at the current virtual time
+  * @param  nowUs: current virtual time
+  * @retval None
+  */
+void SimCan_Process(uint64_t nowUs)
+{
+  for (;;)
+  {
+    if (bus.active && (bus.doneUs <= nowUs))
+    {
+      completeFrame();
+    }
+    else if (!bus.active && (nextStartUs() <= nowUs))
+    {
+      startFrame();
+    }
+    else
+    {
+      break;
+    }
+  }
+}
+
+/**
+  * @brief  Next falling edge on CAN_RX: now while a frame is on the wire,
+  *         else the start of the next frame from another node
+  * @retval absolute virtual time in us, UINT64_MAX when none is queued
+  */
+uint64_t SimCan_NextActivityUs(void)
+{
+  uint64_t t;
+
+  if (bus.active)
+  {
+    return Sim_NowUs;
+  }
+  if (inHead == inTail)
+  {
+    return UINT64_MAX;
+  }
+  t = inbound[inTail & (SIM_CAN_INBOUND_LEN - 1U)].readyUs;
+  return (t < busIdleUs) ? busIdleUs : t;
+}
+
+/**
+  * @brief  Frames that passed the filters while bxCAN was asleep, or that
+  *         were already on the wire when it woke up
+  * @retval frame count
+  */
+uint32_t SimCan_FramesLostAsleep(void)
+{
+  return framesLostAsleep;
+}
+
+/**
+  * @brief  Frames that found FIFO0 full, as with the CPU stalled by a flash
+  *         erase and the RX interrupt held off
+  * @retval frame count
+  */
+uint32_t SimCan_FramesLostOverrun(void)
+{
+  return fifo0Overruns;
+}
+
+/**
+  * @brief  Queues a frame sent by another node
+  * @param  frame: frame as seen on the bus
+  * @param  readyUs: earliest start of transmission; frames go out in order
+  *         of readyUs, and in the order of the calls for equal times
+  * @param  origin: SIM_CAN_ORIGIN_xxx tag handed back to the taps
+  * @retval 0 on success, -1 when the inbound queue is full
+  */
+int SimCan_Inject(const CAN_Frame *frame, uint64_t readyUs, uint32_t origin)
+{
+  uint32_t i = inHead;
+
+  if ((inHead - inTail) >= SIM_CAN_INBOUND_LEN)
+  {
+    inboundDropped++;
+    return -1;
+  }
+  readyUs = (readyUs < Sim_NowUs) ? Sim_NowUs : readyUs;
+  while ((i != inTail) && (inbound[(i - 1U) & (SIM_CAN_INBOUND_LEN - 1U)].readyUs > readyUs))
+  {
+    inbound[i & (SIM_CAN_INBOUND_LEN - 1U)] = inbound[(i - 1U) & (SIM_CAN_INBOUND_LEN - 1U)];
+    i--;
+  }
+  inbound[i & (SIM_CAN_INBOUND_LEN - 1U)].frame = *frame;
+  inbound[i & (SIM_CAN_INBOUND_LEN - 1U)].readyUs = readyUs;
+  inbound[i & (SIM_CAN_INBOUND_LEN - 1U)].origin = origin;
+  inHead++;
+  return 0;
+}
+
+/**
+  * @brief  Records a bus error as the controller would: sets the last error
+  *         code, counts the receive error counter up by one (frames received
+  *         do not count it down), sets ERRI if LECIE is enabled and raises
+  *         the error interrupt if ERRIE is
+  * @param  lec: last error code, 1..6
+  * @retval None
+  */
+void SimCan_InjectError(uint32_t lec)
+{
+  uint32_t rec = (regs->ESR & CAN_ESR_REC) >> CAN_ESR_REC_Pos;
+
+  rec = (rec < 255U) ? (rec + 1U) : rec;
+  regs->ESR = (regs->ESR & ~(CAN_ESR_LEC | CAN_ESR_REC)) | ((lec << CAN_ESR_LEC_Pos) & CAN_ESR_LEC) |
+              (rec << CAN_ESR_REC_Pos);
+  if ((regs->IER & CAN_IER_LECIE) != 0U)
+  {
+    regs->MSR |= CAN_MSR_ERRI;
+  }
+  raiseIrqs();
+}
+
+/**
+  * @brief  Registers a callback for every frame completed on the bus
+  * @param  fn: callback
+  * @param  ctx: passed back to fn
+  * @retval None
+  */
+void SimCan_AddTap(SimCan_TapFn fn, void *ctx)
+{
+  if (tapCount < SIM_CAN_MAX_TAPS)
+  {
+    taps[tapCount].fn = fn;
+    taps[tapCount].ctx = ctx;
+    tapCount++;
+  }
+}
+
+/**
+  * @brief  Prints bus and driver statistics
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimCan_Report(FILE *out, double seconds)
+{
+  uint32_t i;
+
+  fprintf(out, "===== CAN bus (%lu bit/s) =====\n", (unsigned long)SimCan_Bitrate());
+  fprintf(out, "  frames       %10lu\n", (unsigned long)busFrames);
+  fprintf(out, "  bus load     %10.2f %%\n", (seconds > 0.0) ? 100.0 * ((double)busBusyUs / 1e6) / seconds : 0.0);
+  if (inboundDropped != 0U)
+  {
+    fprintf(out, "  inbound lost %10lu\n", (unsigned long)inboundDropped);
+  }
+  if (arbitrationLost != 0U)
+  {
+    fprintf(out, "  arbitration  %10lu mailboxes lost, not retried (NART)\n", (unsigned long)arbitrationLost);
+  }
+  if (fifo0Overruns != 0U)
+  {
+    fprintf(out, "  FIFO0 lost   %10lu frames, overrun\n", (unsigned long)fifo0Overruns);
+  }
+  fprintf(out, "  %-10s %10s %10s\n", "id", "frames", "rate Hz");
+  for (i = 0; i < idCount; i++)
+  {
+    double span = (double)(idStats[i].lastUs - idStats[i].firstUs) / 1e6;
+
+    fprintf(out, "  %-10lX %10lu %10.3f\n", (unsigned long)(idStats[i].id & CAN_FRAME_ID_MASK),
+            (unsigned long)idStats[i].count,
+            ((idStats[i].count > 1U) && (span > 0.0)) ? (double)(idStats[i].count - 1U) / span : 0.0);
+  }
+#if !SIM_BOOT
+  fprintf(out, "===== CAN driver =====\n");
+  fprintf(out, "  rxFrames %lu  rxDropped %lu  rxOverruns %lu  txFrames %lu  txDropped %lu\n",
+          (unsigned long)canStats.rxFrames, (unsigned long)canStats.rxDropped,
+          (unsigned long)canStats.rxOverruns, (unsigned long)canStats.txFrames,
+          (unsigned long)canStats.txDropped);
+  if ((canStats.txSilenced != 0U) || (canStats.txFailed != 0U))
+  {
+    fprintf(out, "  txSilenced %lu  txFailed %lu\n", (unsigned long)canStats.txSilenced,
+            (unsigned long)canStats.txFailed);
+  }
+#endif
+}
+
+/* candump log ---------------------------------------------------------------*/
+static void logTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t i;
+
+  (void)origin;
+  (void)ctx;
+  fprintf(logFile, "(%010llu.%06llu) %s ", (unsigned long long)(timeUs / 1000000U),
+          (unsigned long long)(timeUs % 1000000U), logIfName);
+  if ((frame->id & CAN_FRAME_EXT) != 0U)
+  {
+    fprintf(logFile, "%08lX#", (unsigned long)(frame->id & CAN_FRAME_ID_MASK));
+  }
+  else
+  {
+    fprintf(logFile, "%03lX#", (unsigned long)(frame->id & 0x7FFU));
+  }
+  if ((frame->id & CAN_FRAME_RTR) != 0U)
+  {
+    fputc('R', logFile);
+  }
+  else
+  {
+    for (i = 0; (i < frame->dlc) && (i < 8U); i++)
+    {
+      fprintf(logFile, "%02X", frame->data[i]);
+    }
+  }
+  fputc('\n', logFile);
+}
+
+/**
+  * @brief  Logs all bus traffic in candump -L format
+  * @param  path: output file, "-" for stdout
+  * @param  ifname: interface name written on each line
+  * @retval None
+  */
+void SimLog_Open(const char *path, const char *ifname)
+{
+  logFile = (strcmp(path, "-") == 0) ? stdout : fopen(path, "w");
+  if (logFile == NULL)
+  {
+    perror(path);
+    exit(2);
+  }
+  snprintf(logIfName, sizeof(logIfName), "%s", ifname);
+  SimCan_AddTap(logTap, NULL);
+}
+
+void SimLog_Close(void)
+{
+  if ((logFile != NULL) && (logFile != stdout))
+  {
+    fclose(logFile);
+  }
+  else if (logFile != NULL)
+  {
+    fflush(logFile);
+  }
+  logFile = NULL;
+}
+
+/* Controller and HAL stubs --------------------------------------------------*/
+
+/**
+  * @brief  Maps the bxCAN registers at CAN_BASE with their reset values
+  * @retval None
+  */
+void SimCan_Init(void)
+{
+  regs = (CAN_TypeDef *)SimMmio_Map(CAN_BASE, sizeof(CAN_TypeDef), regWrite);
+  regs->MCR = SIM_CAN_MCR_RESET;
+  regs->MSR = SIM_CAN_MSR_RESET;
+  regs->TSR = SIM_CAN_TSR_RESET;
+  regs->BTR = SIM_CAN_BTR_RESET;
+}
+
+/* Initialization mode is entered and left at once, and leaving sleep mode
+ * does not wait for bus idle */
+HAL_StatusTypeDef HAL_CAN_Init(CAN_HandleTypeDef *hcan_)
+{
+  const CAN_InitTypeDef *init = &hcan_->Init;
+
+  if (hcan_->State == HAL_CAN_STATE_RESET)
+  {
+    HAL_CAN_MspInit(hcan_);
+  }
+  regs->MCR = CAN_MCR_INRQ | (regs->MCR & SIM_CAN_MCR_DBF) |
+              ((init->TimeTriggeredMode == ENABLE) ? CAN_MCR_TTCM : 0U) |
+              ((init->AutoBusOff == ENABLE) ? CAN_MCR_ABOM : 0U) |
+              ((init->AutoWakeUp == ENABLE) ? CAN_MCR_AWUM : 0U) |
+              ((init->AutoRetransmission == DISABLE) ? CAN_MCR_NART : 0U) |
+              ((init->ReceiveFifoLocked == ENABLE) ? CAN_MCR_RFLM : 0U) |
+              ((init->TransmitFifoPriority == ENABLE) ? CAN_MCR_TXFP : 0U);
+  regs->MSR = (regs->MSR & ~CAN_MSR_SLAK) | CAN_MSR_INAK;
+  regs->BTR = init->Mode | init->SyncJumpWidth | init->TimeSeg1 | init->TimeSeg2 | (init->Prescaler - 1U);
+  hcan_->ErrorCode = HAL_CAN_ERROR_NONE;
+  hcan_->State = HAL_CAN_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_ConfigFilter(CAN_HandleTypeDef *hcan_, const CAN_FilterTypeDef *sFilterConfig)
+{
+  uint32_t bank = sFilterConfig->FilterBank;
+  uint32_t bit = 1UL << bank;
+
+  (void)hcan_;
+  if (bank >= SIM_CAN_FILTER_BANKS)
+  {
+    return HAL_ERROR;
+  }
+  regs->FMR |= CAN_FMR_FINIT;
+  regs->FA1R &= ~bit;
+  regs->FS1R = (sFilterConfig->FilterScale == CAN_FILTERSCALE_32BIT) ? (regs->FS1R | bit) : (regs->FS1R & ~bit);
+  regs->FM1R = (sFilterConfig->FilterMode == CAN_FILTERMODE_IDLIST) ? (regs->FM1R | bit) : (regs->FM1R & ~bit);
+  regs->FFA1R = (sFilterConfig->FilterFIFOAssignment == CAN_RX_FIFO1) ? (regs->FFA1R | bit) : (regs->FFA1R & ~bit);
+  regs->sFilterRegister[bank].FR1 = (sFilterConfig->FilterIdHigh << 16) | (sFilterConfig->FilterIdLow & 0xFFFFU);
+  regs->sFilterRegister[bank].FR2 = (sFilterConfig->FilterMaskIdHigh << 16) | (sFilterConfig->FilterMaskIdLow & 0xFFFFU);
+  if (sFilterConfig->FilterActivation == ENABLE)
+  {
+    regs->FA1R |= bit;
+  }
+  regs->FMR &= ~CAN_FMR_FINIT;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef *hcan_)
+{
+  if (hcan_->State != HAL_CAN_STATE_READY)
+  {
+    hcan_->ErrorCode |= HAL_CAN_ERROR_NOT_READY;
+    return HAL_ERROR;
+  }
+  regs->MCR &= ~CAN_MCR_INRQ;
+  regs->MSR &= ~CAN_MSR_INAK;
+  hcan_->State = HAL_CAN_STATE_LISTENING;
+  hcan_->ErrorCode = HAL_CAN_ERROR_NONE;
+  return HAL_OK;
+}
+
+/* The pass through initialization mode takes no time, so CAN_SetSilent()
+ * misses no frame */
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef *hcan_)
+{
+  if (hcan_->State != HAL_CAN_STATE_LISTENING)
+  {
+    hcan_->ErrorCode |= HAL_CAN_ERROR_NOT_STARTED;
+    return HAL_ERROR;
+  }
+  regs->MCR = (regs->MCR | CAN_MCR_INRQ) & ~CAN_MCR_SLEEP;
+  regs->MSR = (regs->MSR | CAN_MSR_INAK) & ~CAN_MSR_SLAK;
+  hcan_->State = HAL_CAN_STATE_READY;
+  return HAL_OK;
+}
+
+/* Sleep mode: entered at the end of the frame on the wire, left at once on
+ * request but the frame in progress at that moment is not received */
+HAL_StatusTypeDef HAL_CAN_RequestSleep(CAN_HandleTypeDef *hcan_)
+{
+  (void)hcan_;
+  regs->MCR |= CAN_MCR_SLEEP;
+  if (!bus.active)
+  {
+    regs->MSR |= CAN_MSR_SLAK;
+  }
+  return HAL_OK;
+}
+
+uint32_t HAL_CAN_IsSleepActive(const CAN_HandleTypeDef *hcan_)
+{
+  (void)hcan_;
+  return ((regs->MSR & CAN_MSR_SLAK) != 0U) ? 1U : 0U;
+}
+
+HAL_StatusTypeDef HAL_CAN_WakeUp(CAN_HandleTypeDef *hcan_)
+{
+  (void)hcan_;
+  if (((regs->MSR & CAN_MSR_SLAK) != 0U) && bus.active)
+  {
+    joinedMidFrame = 1;
+  }
+  regs->MCR &= ~CAN_MCR_SLEEP;
+  regs->MSR &= ~CAN_MSR_SLAK;
+  SimPower_CanOnline();
+  return HAL_OK;
+}
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(const CAN_HandleTypeDef *hcan_)
+{
+  (void)hcan_;
+  return (uint32_t)__builtin_popcount(regs->TSR & CAN_TSR_TME_ALL);
+}
+
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef *hcan_, uint32_t ActiveITs)
+{
+  (void)hcan_;
+  regs->IER |= ActiveITs;
+  raiseIrqs();
+  return HAL_OK;
+}
@@ -0,0 +1,268 @@
+/**
+  ******************************************************************************
+  * @file           : sim_cpu.c
+  * @brief          : CPU accounting check against the cycle counter model
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Always on. Handlers and ADC conversions take no virtual time in the
+  * simulator; instead DWT->CYCCNT gains their modelled cycles (sim_hal.c),
+  * so the firmware's accounting (Core/Src/cpu.c) is checked at the end of
+  * the run against what the model put in:
+  *
+  *   - every source ran as often as the model dispatched it and has
+  *     exactly its modelled cycles per run
+  *   - the total, Stop mode included, equals the virtual time since the
+  *     counter was enabled plus the modelled cycles, within
+  *     SIM_CPU_STOP_SLACK_US per Stop, which the RTC measures in whole
+  *     milliseconds
+  *   - the idle cycles and the Stop time equal the scheduler's own idleUs,
+  *     measured on SysTick, within the same slack and a microsecond a pass
+  *   - idle, Stop and the sources leave a busy rest of zero or more
+  *
+  * Every diagnostics message (PGN 65281) is checked as it goes onto the
+  * bus: reserved bits set, loads of at most 100 %, and a handler share no
+  * larger than the load it is part of. A failed check makes the run exit
+  * with status 1.
+  */
+
+#include <string.h>
+#include "main.h"
+#include "cpu.h"
+#include "scheduler.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_CPU_STOP_SLACK_US   1000U     /* RTC millisecond step */
+#define SIM_CPU_CYCLES_PER_US   (SIM_CPU_HZ / 1000000UL)
+
+/* Private variables ---------------------------------------------------------*/
+static const struct
+{
+  const char *name;
+  IRQn_Type irqs[3];
+  uint32_t irqCount;
+} sources[CPU_SRC_HANDLERS] =
+{
+  [CPU_SRC_CAN_RX]  = { "CAN RX",  { CAN_RX0_IRQn },                                1U },
+  [CPU_SRC_CAN_TX]  = { "CAN TX",  { CAN_TX_IRQn },                                 1U },
+  [CPU_SRC_CAN_SCE] = { "CAN SCE", { CAN_SCE_IRQn },                                1U },
+  [CPU_SRC_SYSTICK] = { "SysTick", { SysTick_IRQn },                                1U },
+  [CPU_SRC_OTHER]   = { "other",   { RTC_WKUP_IRQn, EXTI15_10_IRQn, ADC1_2_IRQn },  3U },
+};
+
+static uint32_t failures;
+static uint32_t diagsSeen;
+static uint32_t diagErrors;
+static uint8_t diag[8];
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  fprintf(stderr, "sim: cpu: %s\n", what);
+  failures++;
+}
+
+static uint32_t le16(const uint8_t *p)
+{
+  return p[0] | ((uint32_t)p[1] << 8);
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  uint32_t load1;
+  int na;
+
+  (void)ctx;
+  if ((origin != SIM_CAN_ORIGIN_NODE) || ((frame->id & CAN_FRAME_EXT) == 0U) ||
+      (((id >> 8) & 0x3FFFFUL) != CPU_PGN_DIAG) || (frame->dlc != 8U))
+  {
+    return;
+  }
+  diagsSeen++;
+  memcpy(diag, frame->data, sizeof(diag));
+
+  load1 = le16(&diag[0]);
+  na = (load1 == CPU_LOAD_NA);
+  if (((diag[7] & 0xFCU) != 0xFCU) ||
+      (na != (le16(&diag[2]) == CPU_LOAD_NA)) || (na != (le16(&diag[4]) == CPU_LOAD_NA)) ||
+      (na != (diag[6] == CPU_SHARE_NA)) ||
+      (!na && ((load1 > 1000U) || (le16(&diag[2]) > 1000U) || (le16(&diag[4]) > 1000U) ||
+               (diag[6] > 200U) || ((uint32_t)diag[6] * 5U > load1 + 5U))))
+  {
+    if (diagErrors == 0U)
+    {
+      fprintf(stderr, "sim: cpu: diagnostics message out of range at %.6f s\n", (double)timeUs / 1e6);
+    }
+    diagErrors++;
+  }
+}
+
+/* Cycles the model put into a handler source, and its runs */
+static uint64_t modelled(uint32_t source, uint32_t *runs)
+{
+  uint64_t cycles = 0;
+  uint32_t cost;
+  uint32_t i;
+
+  *runs = 0;
+  for (i = 0; i < sources[source].irqCount; i++)
+  {
+    uint32_t n = Sim_IrqRuns(sources[source].irqs[i], &cost);
+
+    *runs += n;
+    cycles += (uint64_t)n * cost;
+  }
+  return cycles;
+}
+
+static double share(uint64_t cycles)
+{
+  return (cpuStats.totalCycles != 0U) ? 100.0 * (double)cycles / (double)cpuStats.totalCycles : 0.0;
+}
+
+static double permille(uint32_t value)
+{
+  return (value == CPU_LOAD_NA) ? 0.0 : (double)value / 10.0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Taps the bus for the diagnostics messages
+  * @retval None
+  */
+void SimCpu_Init(void)
+{
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Brings the firmware's totals up to date and checks them against
+  *         the model
+  * @retval 1 if a check failed
+  */
+int SimCpu_Close(void)
+{
+  Sim_CycleModel model;
+  uint64_t accounted;
+  uint64_t wallUs;
+  int64_t diff;
+  uint32_t booked;
+  uint32_t source;
+
+  Sim_CycleModelGet(&model);
+  if (model.startUs == UINT64_MAX)
+  {
+    return 0;                     /* ended before the counter was enabled */
+  }
+  Cpu_Update();
+
+  for (source = 0; source < CPU_SRC_HANDLERS; source++)
+  {
+    uint32_t runs;
+    uint64_t cycles = modelled(source, &runs);
+
+    /* A hang (-W) ends the run inside a handler */
+    if ((runs != cpuStats.counts[source]) && ((Sim_Cfg.hangSpec == NULL) || (runs != cpuStats.counts[source] + 1U)))
+    {
+      fail("handler runs differ from the dispatches");
+    }
+    else if ((runs == cpuStats.counts[source]) && (cycles != cpuStats.cycles[source]))
+    {
+      fail("handler cycles differ from the modelled ones");
+    }
+  }
+  if (model.conversions != cpuStats.counts[CPU_SRC_ADC])
+  {
+    fail("conversions differ from the polled ones");
+  }
+  else if (cpuStats.cycles[CPU_SRC_ADC] != (uint64_t)cpuStats.counts[CPU_SRC_ADC] * SIM_ADC_CYCLES)
+  {
+    fail("conversion cycles differ from the modelled ones");
+  }
+
+  /* The last Stop may not be booked yet when the run ends */
+  booked = schedulerStats.stops;
+  wallUs = Sim_NowUs - model.startUs - ((model.stops > booked) ? model.lastStopUs : 0U);
+  diff = (int64_t)(cpuStats.totalCycles - model.modelledCycles) - (int64_t)(wallUs * SIM_CPU_CYCLES_PER_US);
+  if ((uint64_t)((diff < 0) ? -diff : diff) >
+      ((uint64_t)booked * SIM_CPU_STOP_SLACK_US + 1U) * SIM_CPU_CYCLES_PER_US)
+  {
+    fail("total cycles do not add up to the virtual time");
+  }
+
+  diff = (int64_t)(cpuStats.idleCycles / SIM_CPU_CYCLES_PER_US + schedulerStats.stopUs) - (int64_t)schedulerStats.idleUs;
+  if ((uint64_t)((diff < 0) ? -diff : diff) > (uint64_t)booked * SIM_CPU_STOP_SLACK_US + schedulerStats.passes + 1U)
+  {
+    fail("idle cycles differ from the scheduler's idle time");
+  }
+
+  accounted = cpuStats.idleCycles + cpuStats.stopCycles;
+  for (source = 0; source < CPU_SOURCES; source++)
+  {
+    accounted += cpuStats.cycles[source];
+  }
+  if (accounted > cpuStats.totalCycles)
+  {
+    fail("idle, Stop and the sources exceed the total");
+  }
+
+  if ((cpuStats.windows != 0U) &&
+      ((cpuStats.load1 > 1000U) || (cpuStats.load10 > 1000U) || (cpuStats.load60 > 1000U)))
+  {
+    fail("load above 100 %");
+  }
+  if ((cpuStats.diags != 0U) && (diagsSeen == 0U) && (canStats.txFailed == 0U))
+  {
+    fail("no diagnostics message on the bus");
+  }
+  return (failures + diagErrors) != 0U;
+}
+
+/**
+  * @brief  Prints where the cycles went and the load figures
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimCpu_Report(FILE *out, double seconds)
+{
+  Sim_CycleModel model;
+  uint64_t busy = cpuStats.totalCycles - cpuStats.idleCycles - cpuStats.stopCycles;
+  uint32_t source;
+
+  (void)seconds;
+  Sim_CycleModelGet(&model);
+  fprintf(out, "===== CPU accounting =====\n");
+  fprintf(out, "  total        %10.3f s at %lu MHz, %.3f ms of it modelled handlers and conversions\n",
+          (double)cpuStats.totalCycles / (double)SIM_CPU_HZ, (unsigned long)SIM_CPU_CYCLES_PER_US,
+          (double)model.modelledCycles / (double)SIM_CPU_CYCLES_PER_US / 1e3);
+  fprintf(out, "  idle         %10.3f %%\n", share(cpuStats.idleCycles));
+  fprintf(out, "  stop         %10.3f %%\n", share(cpuStats.stopCycles));
+  for (source = 0; source < CPU_SOURCES; source++)
+  {
+    busy -= cpuStats.cycles[source];
+    fprintf(out, "  %-12s %10.3f %%, %lu runs, %.0f cycles each\n",
+            (source < CPU_SRC_HANDLERS) ? sources[source].name : "ADC", share(cpuStats.cycles[source]),
+            (unsigned long)cpuStats.counts[source],
+            (cpuStats.counts[source] != 0U) ? (double)cpuStats.cycles[source] / cpuStats.counts[source] : 0.0);
+  }
+  fprintf(out, "  busy         %10.3f %% (tasks and scheduler)\n", share(busy));
+  fprintf(out, "  load         %10.1f %% 1 s, %.1f %% 10 s, %.1f %% 60 s, %lu windows\n",
+          permille(cpuStats.load1), permille(cpuStats.load10), permille(cpuStats.load60),
+          (unsigned long)cpuStats.windows);
+  fprintf(out, "  diagnostics  %10lu messages, %lu out of range\n", (unsigned long)diagsSeen,
+          (unsigned long)diagErrors);
+  fprintf(out, "  check        %10s\n", ((failures + diagErrors) == 0U) ? "ok" : "FAILED");
+}
@@ -0,0 +1,415 @@
+/**
+  ******************************************************************************
+  * @file           : sim_crash.c
+  * @brief          : Crash injection and crash report check
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * SRAM is mapped at its real address, so that Crash_Fault() takes the same
+  * range checks as on the target; the host build is linked without PIE, so
+  * code addresses fit the 32-bit report fields too.
+  *
+  * -C kind@seconds makes the next HAL_ADC_Start() (inside T1) crash:
+  *
+  *   fault   a precise bus fault escalated to HardFault: an exception frame
+  *           with known registers is stacked at the top of SRAM, above it
+  *           CRASH_STACK_WORDS known words, the SCB fault registers are set
+  *           and HardFault_Handler() is called
+  *   error   Error_Handler() is called
+  *
+  * The report checks the saved record against what was injected. -Z keeps
+  * the record in a file, as CCMRAM keeps it across the reset: the run that
+  * boots from it checks that the report reaches the global address intact
+  * and is marked sent. A failed check makes the run exit with status 1.
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "main.h"
+#include "stm32f3xx_it.h"
+#include "boot.h"
+#include "crash.h"
+#include "history.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_SRAM_SIZE           (12U * 1024U)
+#define SIM_EXC_RETURN          0xFFFFFFF9UL  /* thread mode, MSP, no FPU state */
+#define SIM_XPSR                0x01000000UL  /* Thumb state */
+#define SIM_BFAR                0x48001800UL  /* unmapped, above GPIOF */
+#define SIM_STACK_PATTERN       0x57AC0000UL
+#define SIM_CALLER_SPAN         256U          /* Error_Handler() call within HAL_ADC_Start() */
+#define SIM_REPORT_FRAMES       ((sizeof(Crash_Report) + 6U) / 7U)
+
+/* Private variables ---------------------------------------------------------*/
+extern uint8_t taskT1;                    /* main.c, the T1 task number */
+
+static const char *const kindNames[] = { "none", "fault", "error" };
+static const char *const reportNames[] =
+{
+  "none", "HardFault", "MemManage", "BusFault", "UsageFault", "Error_Handler"
+};
+
+static uint32_t crashKind;
+static uint64_t crashAtUs;
+static uint64_t crashedUs = UINT64_MAX;
+static uint32_t injected[8];              /* stacked r0-r3, r12, lr, pc, xPSR */
+static const uint32_t *faultFrame;        /* for the next Sim_FaultEntry() */
+
+static Crash_Record booted;               /* record found at start-up */
+static int bootReport;                    /* booted with a report not sent yet */
+
+static int responseSeen;
+static uint8_t response[8];
+static uint8_t data[SIM_REPORT_FRAMES * 7U];
+static uint8_t seen[SIM_REPORT_FRAMES];
+static uint32_t received;
+static uint64_t sentUs;                   /* last data frame */
+
+static uint32_t failures;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  fprintf(stderr, "sim: crash: %s\n", what);
+  failures++;
+}
+
+static uint16_t recordCrc(const Crash_Record *record)
+{
+  return History_Crc16(0xFFFFU, (const uint8_t *)&record->report, sizeof(record->report));
+}
+
+static const char *reportName(uint8_t kind)
+{
+  return (kind < sizeof(reportNames) / sizeof(reportNames[0])) ? reportNames[kind] : "unknown";
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  uint32_t n;
+
+  (void)ctx;
+
+  if ((origin != SIM_CAN_ORIGIN_NODE) || ((frame->id & CAN_FRAME_EXT) == 0U) ||
+      (BOOT_ID_DA(id) != 0xFFU) || (BOOT_ID_SA(id) != BOOT_NODE_ADDRESS))
+  {
+    return;
+  }
+  if ((BOOT_ID_PGN(id) == BOOT_PGN_CMD) && (frame->data[0] == (CRASH_CMD_GET | BOOT_RSP)))
+  {
+    responseSeen++;
+    memcpy(response, frame->data, sizeof(response));
+  }
+  else if ((BOOT_ID_PGN(id) == BOOT_PGN_DATA) && responseSeen && (frame->data[0] < SIM_REPORT_FRAMES))
+  {
+    n = frame->data[0];
+    memcpy(&data[n * 7U], &frame->data[1], 7);
+    if (!seen[n])
+    {
+      seen[n] = 1;
+      received++;
+    }
+    sentUs = timeUs;
+  }
+}
+
+/* What the crash must have saved */
+static void checkSaved(void)
+{
+  const Crash_Report *report = &crashRecord.report;
+  uint32_t i;
+
+  if ((crashRecord.magic != CRASH_MAGIC) || (crashRecord.crc != recordCrc(&crashRecord)))
+  {
+    fail("no valid record after the crash");
+    return;
+  }
+  if (crashRecord.reported)
+  {
+    fail("new record marked sent");
+  }
+  if (report->task != taskT1)
+  {
+    fail("record does not name T1 as running");
+  }
+  if (report->traceEvents == 0U)
+  {
+    fail("no trace events in the record");
+  }
+
+  if (crashKind == SIM_CRASH_ERROR)
+  {
+    if ((report->kind != CRASH_KIND_ERROR) || (report->pc <= (uint32_t)(uintptr_t)HAL_ADC_Start) ||
+        (report->pc > (uint32_t)(uintptr_t)HAL_ADC_Start + SIM_CALLER_SPAN))
+    {
+      fail("record does not name the Error_Handler() call in HAL_ADC_Start()");
+    }
+    return;
+  }
+
+  if ((report->kind != CRASH_KIND_HARDFAULT) || (report->excReturn != SIM_EXC_RETURN) ||
+      (memcmp(&report->r0, injected, sizeof(injected)) != 0))
+  {
+    fail("stacked registers do not match the fault");
+  }
+  if ((report->sp != (uint32_t)(uintptr_t)(faultFrame + 8)) || (report->stackWords != CRASH_STACK_WORDS))
+  {
+    fail("stack pointer or snapshot size does not match the fault");
+  }
+  for (i = 0; i < report->stackWords; i++)
+  {
+    if (report->stack[i] != (SIM_STACK_PATTERN | i))
+    {
+      fail("stack snapshot does not match the stack");
+      break;
+    }
+  }
+  if ((report->cfsr != (SCB_CFSR_PRECISERR_Msk | SCB_CFSR_BFARVALID_Msk)) ||
+      (report->hfsr != SCB_HFSR_FORCED_Msk) || (report->bfar != SIM_BFAR))
+  {
+    fail("fault status registers do not match the fault");
+  }
+}
+
+/* What the node must send for the record it booted with */
+static void checkSent(void)
+{
+  uint32_t bytes = sizeof(Crash_Report);
+
+  if (!responseSeen)
+  {
+    fail("no crash report at start-up");
+    return;
+  }
+  if ((response[1] != CRASH_OK) || (response[2] != booted.report.kind) ||
+      ((response[3] | ((uint32_t)response[4] << 8)) != bytes) ||
+      ((response[5] | ((uint16_t)response[6] << 8)) != booted.crc))
+  {
+    fail("crash report response does not match the record");
+  }
+  if (received != SIM_REPORT_FRAMES)
+  {
+    fail("crash report incomplete");
+  }
+  else if ((memcmp(data, &booted.report, bytes) != 0) || (History_Crc16(0xFFFFU, data, bytes) != booted.crc))
+  {
+    fail("crash report does not match the record");
+  }
+  else if (!crashRecord.reported)
+  {
+    fail("crash report not marked sent");
+  }
+}
+
+static void save(void)
+{
+  FILE *f;
+
+  if (Sim_Cfg.crashPath == NULL)
+  {
+    return;
+  }
+  f = fopen(Sim_Cfg.crashPath, "wb");
+  if ((f == NULL) || (fwrite(&crashRecord, sizeof(crashRecord), 1, f) != 1U))
+  {
+    perror(Sim_Cfg.crashPath);
+    exit(2);
+  }
+  fclose(f);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Maps SRAM, parses -C and loads the -Z record
+  * @retval None
+  */
+void SimCrash_Init(void)
+{
+  void *sram;
+  FILE *f;
+
+  sram = mmap((void *)SRAM_BASE, SIM_SRAM_SIZE, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  if ((sram == MAP_FAILED) || (sram != (void *)SRAM_BASE))
+  {
+    perror("sim: cannot map SRAM at 0x20000000");
+    exit(2);
+  }
+
+  if (Sim_Cfg.crashSpec != NULL)
+  {
+    const char *at = strchr(Sim_Cfg.crashSpec, '@');
+    size_t len = (at != NULL) ? (size_t)(at - Sim_Cfg.crashSpec) : strlen(Sim_Cfg.crashSpec);
+    uint32_t kind;
+
+    for (kind = SIM_CRASH_FAULT; kind < sizeof(kindNames) / sizeof(kindNames[0]); kind++)
+    {
+      if ((strlen(kindNames[kind]) == len) && (strncmp(Sim_Cfg.crashSpec, kindNames[kind], len) == 0))
+      {
+        crashKind = kind;
+      }
+    }
+    if (crashKind == SIM_CRASH_NONE)
+    {
+      fprintf(stderr, "sim: -C %s: kind is fault or error\n", Sim_Cfg.crashSpec);
+      exit(2);
+    }
+    crashAtUs = (at != NULL) ? (uint64_t)(strtod(at + 1, NULL) * 1e6) : 0U;
+  }
+
+  if ((Sim_Cfg.crashPath != NULL) && ((f = fopen(Sim_Cfg.crashPath, "rb")) != NULL))
+  {
+    if (fread(&crashRecord, sizeof(crashRecord), 1, f) != 1U)
+    {
+      fprintf(stderr, "sim: %s is not a crash record\n", Sim_Cfg.crashPath);
+      exit(2);
+    }
+    fclose(f);
+    booted = crashRecord;
+    bootReport = (booted.magic == CRASH_MAGIC) && (booted.crc == recordCrc(&booted)) && !booted.reported;
+  }
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Checks the saved record and the start-up report, writes the -Z
+  *         file
+  * @retval 1 if a check failed
+  */
+int SimCrash_Close(void)
+{
+  if (crashedUs != UINT64_MAX)
+  {
+    checkSaved();
+  }
+  else if (crashKind != SIM_CRASH_NONE)
+  {
+    fail("crash never injected");
+  }
+  if (bootReport)
+  {
+    checkSent();
+  }
+  else if (responseSeen)
+  {
+    fail("crash report sent without a new record");
+  }
+  save();
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints the crash record and the start-up report
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimCrash_Report(FILE *out, double seconds)
+{
+  const Crash_Report *report = &crashRecord.report;
+
+  (void)seconds;
+  if ((crashKind == SIM_CRASH_NONE) && (Sim_Cfg.crashPath == NULL))
+  {
+    return;
+  }
+  fprintf(out, "===== Crash report =====\n");
+  if (bootReport)
+  {
+    fprintf(out, "  booted with  %10s record, %lu of %lu frames sent to 0xFF, last at %.3f s%s\n",
+            reportName(booted.report.kind), (unsigned long)received, (unsigned long)SIM_REPORT_FRAMES,
+            (double)sentUs / 1e6, crashRecord.reported ? ", marked sent" : "");
+  }
+  if (crashedUs != UINT64_MAX)
+  {
+    fprintf(out, "  crash        %10s at %.3f s\n", kindNames[crashKind], (double)crashedUs / 1e6);
+  }
+  if (crashRecord.magic == CRASH_MAGIC)
+  {
+    fprintf(out, "  record       %10s, pc 0x%08lX, lr 0x%08lX, sp 0x%08lX, task %u\n",
+            reportName(report->kind), (unsigned long)report->pc, (unsigned long)report->lr,
+            (unsigned long)report->sp, report->task);
+    fprintf(out, "  fault        CFSR 0x%08lX, HFSR 0x%08lX, BFAR 0x%08lX, %u stack words, %u trace events\n",
+            (unsigned long)report->cfsr, (unsigned long)report->hfsr, (unsigned long)report->bfar,
+            report->stackWords, report->traceEvents);
+    if ((crashedUs != UINT64_MAX) && (Sim_Cfg.crashPath != NULL))
+    {
+      fprintf(out, "  next boot    -Z %s\n", Sim_Cfg.crashPath);
+    }
+  }
+  fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+}
+
+/**
+  * @brief  Crash hook for the HAL models
+  * @param  kind: SIM_CRASH_FAULT or SIM_CRASH_ERROR
+  * @retval 1 if the caller must crash now
+  */
+int SimCrash_Due(uint32_t kind)
+{
+  if ((kind != crashKind) || (Sim_NowUs < crashAtUs) || (crashedUs != UINT64_MAX))
+  {
+    return 0;
+  }
+  crashedUs = Sim_NowUs;
+  return 1;
+}
+
+/**
+  * @brief  Takes a precise bus fault, escalated to HardFault
+  * @param  pc: faulting instruction
+  * @param  lr: return address of the faulting function
+  * @retval None, does not return
+  */
+void SimCrash_Fault(uint32_t pc, uint32_t lr)
+{
+  uint32_t *top = (uint32_t *)(SRAM_BASE + SIM_SRAM_SIZE);
+  uint32_t *stacked = top - CRASH_STACK_WORDS - 8U;
+  uint32_t i;
+
+  for (i = 0; i < 5U; i++)
+  {
+    injected[i] = 0x11111111UL * i;       /* r0-r3, r12 */
+  }
+  injected[5] = lr;
+  injected[6] = pc;
+  injected[7] = SIM_XPSR;
+  memcpy(stacked, injected, sizeof(injected));
+  for (i = 0; i < CRASH_STACK_WORDS; i++)
+  {
+    stacked[8U + i] = SIM_STACK_PATTERN | i;
+  }
+
+  Sim_SCB.CFSR = SCB_CFSR_PRECISERR_Msk | SCB_CFSR_BFARVALID_Msk;
+  Sim_SCB.HFSR = SCB_HFSR_FORCED_Msk;
+  Sim_SCB.BFAR = SIM_BFAR;
+  faultFrame = stacked;
+  HardFault_Handler();
+  for (;;)
+  {
+  }
+}
+
+/**
+  * @brief  CRASH_FAULT_ENTRY() of the fault handlers: the frame stacked by
+  *         SimCrash_Fault(), none if a handler is called otherwise
+  * @param  kind: CRASH_KIND_x
+  * @retval None, does not return
+  */
+void Sim_FaultEntry(uint32_t kind)
+{
+  Crash_Fault(faultFrame, kind, SIM_EXC_RETURN);
+}
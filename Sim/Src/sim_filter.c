@@ -0,0 +1,369 @@
+/**
+  ******************************************************************************
+  * @file           : sim_filter.c
+  * @brief          : Temperature filter check against a reference in double
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Always on. sim_hal.c calls SimFilter_Conversion() with each code, which
+  * keeps the last FILTER_BATCH_MAX of them, the model temperature without
+  * noise, the filter parameters and a reference IIR in double that starts
+  * again whenever they change. Every T1 frame (PGN 130312) is checked:
+  *
+  *   - it follows a whole number of batches of Filter_Batch() conversions,
+  *     one when the filter is off; more than one batch when T1 frames were
+  *     held back (silent mode, a full TX queue)
+  *   - its temperature is the reference's for the mode within an eighth of
+  *     a code and the 0.01 K of the frame: last code, mean, median, or the
+  *     Butterworth low-pass run over every conversion
+  *
+  * The error of the raw conversions and of the T1 values against the model
+  * is reported as an RMS, leaving out SIM_FILTER_SETTLE frames after a
+  * change. With noise, a batch of 4 or more or the IIR, the T1 error has
+  * to be the smaller.
+  *
+  * -T mode[,batch[,cutoff]]@seconds sends PARAM_FILTER_MODE, and the batch
+  * and cutoff if given, as PARAM_SET commands at that time. A failed check
+  * makes the run exit with status 1.
+  */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "boot.h"
+#include "filter.h"
+#include "params.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_FILTER_ADDRESS      0x87U
+#define SIM_T1_PGN              130312UL
+#define SIM_FILTER_SETTLE       10U       /* T1 frames left out of the RMS */
+#define SIM_FILTER_MIN_FRAMES   10U       /* for the noise check */
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t setValue[3];              /* -T mode, batch, cutoff */
+static uint32_t setCount;
+static uint64_t setAtUs;
+
+static uint16_t codes[FILTER_BATCH_MAX];  /* last conversions, ring */
+static uint32_t conversions;
+static uint32_t pending;                  /* since the last T1 frame */
+static uint32_t params[4];                /* mode, batch, cutoff, offset at the last conversion */
+static double modelCode;                  /* without noise, at the last conversion */
+static int started;
+
+/* Reference IIR */
+static double coeff[5];
+static double xPrev[2];                   /* x[n-1], x[n-2] */
+static double yPrev[2];
+static double iirOut;
+
+static uint32_t frames;
+static uint32_t settle;
+static uint32_t counted;
+static double diffMax;
+static double rawSquares;
+static uint32_t rawCount;
+static double t1Squares;
+
+static uint32_t failures;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  if (failures == 0U)
+  {
+    fprintf(stderr, "sim: filter: %s at %.6f s\n", what, (double)Sim_NowUs / 1e6);
+  }
+  failures++;
+}
+
+static void sendParam(uint16_t key, uint32_t value, uint64_t timeUs)
+{
+  CAN_Frame set;
+
+  memset(&set, 0xFF, sizeof(set));
+  set.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, SIM_FILTER_ADDRESS);
+  set.dlc = 8;
+  set.data[0] = PARAMS_CMD_SET;
+  set.data[1] = (uint8_t)key;
+  set.data[2] = (uint8_t)(key >> 8);
+  set.data[3] = (uint8_t)value;
+  set.data[4] = (uint8_t)(value >> 8);
+  set.data[5] = (uint8_t)(value >> 16);
+  set.data[6] = (uint8_t)(value >> 24);
+  if (SimCan_Inject(&set, timeUs, SIM_CAN_ORIGIN_MODEL) != 0)
+  {
+    fprintf(stderr, "sim: filter: cannot queue PARAM_SET\n");
+    exit(2);
+  }
+}
+
+static uint32_t batchOf(const uint32_t *p)
+{
+  return (p[0] == FILTER_MODE_OFF) ? 1U : p[1];
+}
+
+/* Degrees per code, magnitude */
+static double codeC(void)
+{
+  return 80.0 / fabs((double)Sim_Cfg.cal110 - (double)Sim_Cfg.cal30);
+}
+
+static double toC(double code, int32_t offset)
+{
+  return 30.0 + (code - (double)Sim_Cfg.cal30) * 80.0 / ((double)Sim_Cfg.cal110 - (double)Sim_Cfg.cal30) +
+         (double)offset / 100.0;
+}
+
+/* Butterworth as filter.h describes it, from the same formula in double */
+static void iirStart(uint32_t cutoff, double x)
+{
+  double k = tan(M_PI * (double)cutoff / 1000.0);
+  double norm = 1.0 / (1.0 + M_SQRT2 * k + k * k);
+
+  coeff[0] = k * k * norm;
+  coeff[1] = 2.0 * coeff[0];
+  coeff[2] = coeff[0];
+  coeff[3] = 2.0 * (1.0 - k * k) * norm;
+  coeff[4] = -(1.0 - M_SQRT2 * k + k * k) * norm;
+  xPrev[0] = xPrev[1] = yPrev[0] = yPrev[1] = x;
+}
+
+/* Reference value for the last batch, in codes */
+static double reference(void)
+{
+  uint32_t batch = batchOf(params);
+  double sorted[FILTER_BATCH_MAX];
+  double sum = 0.0;
+  uint32_t i;
+  uint32_t j;
+
+  switch (params[0])
+  {
+    case FILTER_MODE_MEAN:
+      for (i = 0; i < batch; i++)
+      {
+        sum += codes[(conversions - 1U - i) % FILTER_BATCH_MAX];
+      }
+      return sum / (double)batch;
+
+    case FILTER_MODE_IIR:
+      return iirOut;
+
+    case FILTER_MODE_MEDIAN:
+      for (i = 0; i < batch; i++)
+      {
+        sorted[i] = codes[(conversions - 1U - i) % FILTER_BATCH_MAX];
+      }
+      for (i = 1; i < batch; i++)
+      {
+        for (j = i; (j > 0U) && (sorted[j - 1U] > sorted[j]); j--)
+        {
+          double t = sorted[j];
+
+          sorted[j] = sorted[j - 1U];
+          sorted[j - 1U] = t;
+        }
+      }
+      return ((batch & 1U) != 0U) ? sorted[batch / 2U] : (sorted[batch / 2U - 1U] + sorted[batch / 2U]) / 2.0;
+
+    default:
+      return codes[(conversions - 1U) % FILTER_BATCH_MAX];
+  }
+}
+
+static void onT1(const CAN_Frame *frame)
+{
+  uint16_t centiK = (uint16_t)(frame->data[3] | ((uint16_t)frame->data[4] << 8));
+  double t1C = (double)centiK / 100.0 - 273.15;
+  int32_t offset = (int32_t)params[3];
+  double diff;
+
+  frames++;
+  if (!started || (conversions < batchOf(params)))
+  {
+    return;
+  }
+  if ((pending == 0U) || ((pending % batchOf(params)) != 0U))
+  {
+    fail("T1 after a batch of the wrong size");
+  }
+  pending = 0;
+
+  /* The frame truncates to 0.01 K, the mean to 1/8 code */
+  diff = fabs(t1C - toC(reference(), offset));
+  diffMax = (diff > diffMax) ? diff : diffMax;
+  if (diff > (codeC() / 8.0) + 0.012)
+  {
+    fail("T1 temperature differs from the reference filter");
+  }
+  if (settle > 0U)
+  {
+    settle--;
+    return;
+  }
+  t1Squares += (t1C - toC(modelCode, offset)) * (t1C - toC(modelCode, offset));
+  counted++;
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  (void)timeUs;
+  (void)ctx;
+  if ((origin == SIM_CAN_ORIGIN_NODE) && ((frame->id & CAN_FRAME_EXT) != 0U) &&
+      (((id >> 8) & 0x3FFFFUL) == SIM_T1_PGN) && (frame->dlc >= 5U))
+  {
+    onT1(frame);
+  }
+}
+
+static const char *modeName(uint32_t mode)
+{
+  static const char *const names[FILTER_MODES] = { "off", "mean", "IIR", "median" };
+
+  return (mode < FILTER_MODES) ? names[mode] : "?";
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Parses -T, queues its PARAM_SET commands and taps the bus
+  * @retval None
+  */
+void SimFilter_Init(void)
+{
+  if (Sim_Cfg.filterSpec != NULL)
+  {
+    const char *p = Sim_Cfg.filterSpec;
+    char *end = NULL;
+
+    for (setCount = 0; setCount < 3U; setCount++)
+    {
+      setValue[setCount] = (uint32_t)strtoul(p, &end, 0);
+      if ((end == p) || ((*end != ',') && (*end != '@') && (*end != '\0')))
+      {
+        fprintf(stderr, "sim: -T %s: mode[,batch[,cutoff]]@seconds\n", Sim_Cfg.filterSpec);
+        exit(2);
+      }
+      p = end + 1;
+      if (*end != ',')
+      {
+        setCount++;
+        break;
+      }
+    }
+    setAtUs = (*end == '@') ? (uint64_t)(strtod(end + 1, NULL) * 1e6) : 0U;
+    sendParam(PARAM_FILTER_MODE, setValue[0], setAtUs);
+    if (setCount > 1U)
+    {
+      sendParam(PARAM_FILTER_BATCH, setValue[1], setAtUs);
+    }
+    if (setCount > 2U)
+    {
+      sendParam(PARAM_FILTER_CUTOFF, setValue[2], setAtUs);
+    }
+  }
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Records a conversion and runs the reference IIR on it
+  * @param  code: converted code
+  * @retval None
+  */
+void SimFilter_Conversion(uint16_t code)
+{
+  uint32_t now[4];
+
+  now[0] = Params_Get(PARAM_FILTER_MODE);
+  now[1] = Params_Get(PARAM_FILTER_BATCH);
+  now[2] = Params_Get(PARAM_FILTER_CUTOFF);
+  now[3] = Params_Get(PARAM_TEMP_OFFSET);
+  if (!started || (memcmp(now, params, 3U * sizeof(now[0])) != 0))
+  {
+    memcpy(params, now, sizeof(params));
+    iirStart(params[2], (double)code);
+    pending = 0;
+    settle = SIM_FILTER_SETTLE;
+    started = 1;
+  }
+  params[3] = now[3];
+
+  codes[conversions % FILTER_BATCH_MAX] = code;
+  conversions++;
+  pending++;
+  modelCode = Sim_AdcModel();
+  rawSquares += (toC(code, 0) - toC(modelCode, 0)) * (toC(code, 0) - toC(modelCode, 0));
+  rawCount++;
+
+  iirOut = coeff[0] * code + coeff[1] * xPrev[0] + coeff[2] * xPrev[1] + coeff[3] * yPrev[0] +
+           coeff[4] * yPrev[1];
+  xPrev[1] = xPrev[0];
+  xPrev[0] = code;
+  yPrev[1] = yPrev[0];
+  yPrev[0] = iirOut;
+}
+
+/**
+  * @brief  Checks that the filter took the noise down
+  * @retval 1 if a check failed
+  */
+int SimFilter_Close(void)
+{
+  if ((Sim_Cfg.noiseLsb > 0.0) && (counted >= SIM_FILTER_MIN_FRAMES) && (rawCount > 0U) &&
+      ((params[0] == FILTER_MODE_IIR) || ((params[0] != FILTER_MODE_OFF) && (params[1] >= 4U))) &&
+      (sqrt(t1Squares / counted) >= sqrt(rawSquares / rawCount)))
+  {
+    fail("filtered T1 no less noisy than the conversions");
+  }
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints the filter in use and the errors against the model
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimFilter_Report(FILE *out, double seconds)
+{
+  double rawRms = (rawCount > 0U) ? sqrt(rawSquares / rawCount) : 0.0;
+  double t1Rms = (counted > 0U) ? sqrt(t1Squares / counted) : 0.0;
+
+  (void)seconds;
+  fprintf(out, "===== Temperature filter =====\n");
+  fprintf(out, "  filter       %10s", modeName(params[0]));
+  if (params[0] != FILTER_MODE_OFF)
+  {
+    fprintf(out, ", batch %lu", (unsigned long)params[1]);
+  }
+  if (params[0] == FILTER_MODE_IIR)
+  {
+    fprintf(out, ", cutoff %lu per mille", (unsigned long)params[2]);
+  }
+  fprintf(out, "\n");
+  fprintf(out, "  conversions  %10lu, %lu T1 frames, reference within %.4f degC\n", (unsigned long)conversions,
+          (unsigned long)frames, diffMax);
+  fprintf(out, "  RMS error    %10.4f degC raw, %.4f degC T1 over %lu frames", rawRms, t1Rms,
+          (unsigned long)counted);
+  if ((rawRms > 0.0) && (t1Rms > 0.0))
+  {
+    fprintf(out, " (%.1f dB)", 20.0 * log10(rawRms / t1Rms));
+  }
+  fprintf(out, "\n");
+  fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+}
@@ -0,0 +1,421 @@
+/**
+  ******************************************************************************
+  * @file           : sim_flash.c
+  * @brief          : Flash model for the parameter pages and a PARAM_SET writer
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The two parameter pages are mapped at their target address, so params.c
+  * reads them exactly as on the part. Programming follows the F3 rules (the
+  * controller must be unlocked, a half-word must be erased unless it is set
+  * to zero) and each operation holds the CPU for its datasheet time with
+  * interrupts held off, like the flash fetch stall of the single-bank part:
+  * CAN frames that arrive meanwhile pile up in the three-deep FIFO, and the
+  * interrupt is taken between two operations.
+  *
+  * The BOOT=1 build maps the application area in front of the pages as well
+  * and has no parameter store: no writer, no recovery check.
+  *
+  * -F keeps the pages in a file between runs. -k cuts the power in the
+  * middle of the nth flash operation of the run: a half-word program is
+  * lost, a page erase only clears the first half of the page.
+  *
+  * -P adds a node sending PARAM_SET for PARAM_TEMP_OFFSET at the given rate,
+  * counting up through the key's range from the value found at start.
+  *
+  * Power-fail check: the model follows the programming order to know which
+  * PARAM_TEMP_OFFSET value is durable. A record counts once its last
+  * half-word is written on a page whose header is complete, or when the
+  * header of its page is completed later. The durable value is kept behind
+  * the pages in the -F file and the next run fails if the store recovers
+  * anything else.
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "main.h"
+#include "params.h"
+#include "boot.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#if SIM_BOOT
+#define SIM_FLASH_BASE          BOOT_APP_BASE
+#else
+#define SIM_FLASH_BASE          PARAMS_FLASH_BASE
+#endif
+#define SIM_FLASH_SIZE          ((PARAMS_FLASH_BASE - SIM_FLASH_BASE) + (2U * PARAMS_PAGE_SIZE))
+#define SIM_FLASH_PROGRAM_US    53U       /* tPROG, typical */
+#define SIM_FLASH_ERASE_US      30000U    /* tERASE, 20..40 ms */
+#define SIM_FLASH_ENDURANCE     10000U    /* erase cycles per page */
+#define SIM_FLASH_FILE_MAGIC    0x464D4953UL  /* "SIMF" */
+#define SIM_FLASH_PAGE(address) (((address) - PARAMS_FLASH_BASE) / PARAMS_PAGE_SIZE)
+
+#define SIM_WRITER_ADDRESS      0x80U
+#define SIM_WRITER_AHEAD_US     100000U   /* writes queued ahead of the bus */
+#define SIM_WRITER_MIN          (-1000)   /* PARAM_TEMP_OFFSET limits */
+#define SIM_WRITER_MAX          1000
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t *flash;
+static int locked = 1;
+static uint32_t operations;
+static uint32_t halfwords;
+static uint32_t erases;
+static uint64_t stallUs;
+static uint32_t stallLost;        /* FIFO0 overruns while the CPU stalled */
+
+/* Power-fail oracle, kept behind the pages in the -F file */
+static struct
+{
+  uint32_t magic;
+  uint32_t durable;     /* PARAM_TEMP_OFFSET the store must recover */
+} oracle;
+
+static uint32_t pageValue[2];     /* newest complete record on each page */
+static uint8_t pageHasValue[2];
+static int failed;
+
+#if !SIM_BOOT
+static int started;
+static int32_t lastSent;
+static uint64_t nextWriteUs;
+static uint32_t writesSent;
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+static uint16_t halfword(uint32_t address)
+{
+  return *(const uint16_t *)(uintptr_t)address;
+}
+
+static int headerComplete(uint32_t page)
+{
+  uint32_t base = PARAMS_FLASH_BASE + (page * PARAMS_PAGE_SIZE);
+
+  return (halfword(base) | ((uint32_t)halfword(base + 2U) << 16)) == PARAMS_MAGIC;
+}
+
+/* Oracle update after each half-word the firmware programs */
+static void track(uint32_t address)
+{
+  uint32_t page = SIM_FLASH_PAGE(address);
+  uint32_t offset = address - PARAMS_FLASH_BASE - (page * PARAMS_PAGE_SIZE);
+  uint32_t record = address - ((offset - PARAMS_HEADER_SIZE) % PARAMS_RECORD_SIZE);
+
+  if (address < PARAMS_FLASH_BASE)
+  {
+    return;
+  }
+  if ((offset >= PARAMS_HEADER_SIZE) && (((offset - PARAMS_HEADER_SIZE) % PARAMS_RECORD_SIZE) == 6U))
+  {
+    if (halfword(record) == (uint16_t)PARAM_TEMP_OFFSET)
+    {
+      pageValue[page] = halfword(record + 2U) | ((uint32_t)halfword(record + 4U) << 16);
+      pageHasValue[page] = 1;
+      if (headerComplete(page))
+      {
+        oracle.durable = pageValue[page];
+      }
+    }
+  }
+  else if ((offset < PARAMS_HEADER_SIZE) && headerComplete(page) && pageHasValue[page])
+  {
+    oracle.durable = pageValue[page];
+  }
+}
+
+static void save(void)
+{
+  FILE *f;
+
+  if (Sim_Cfg.flashPath == NULL)
+  {
+    return;
+  }
+  f = fopen(Sim_Cfg.flashPath, "wb");
+  if ((f == NULL) || (fwrite(flash, 1, SIM_FLASH_SIZE, f) != SIM_FLASH_SIZE) ||
+      (fwrite(&oracle, sizeof(oracle), 1, f) != 1U))
+  {
+    perror(Sim_Cfg.flashPath);
+  }
+  if (f != NULL)
+  {
+    fclose(f);
+  }
+}
+
+/* Every program or erase goes through here: counts it, cuts the power on
+ * the requested one, then stalls the CPU for its duration; what became
+ * pending meanwhile is taken once it ends */
+static int operation(uint64_t durationUs)
+{
+  uint32_t primask = Sim_Primask;
+  uint32_t lost = SimCan_FramesLostOverrun();
+
+  operations++;
+  if (operations == Sim_Cfg.powerCutOp)
+  {
+    return -1;
+  }
+  stallUs += durationUs;
+  Sim_Primask = 1U;
+  Sim_AdvanceTo(Sim_NowUs + durationUs);
+  stallLost += SimCan_FramesLostOverrun() - lost;
+  Sim_SetPrimask(primask);
+  return 0;
+}
+
+static void powerCut(void)
+{
+  fprintf(stderr, "sim: power cut during flash operation %lu at %.6f s\n",
+          (unsigned long)operations, (double)Sim_NowUs / 1e6);
+  Sim_Finish();
+}
+
+#if !SIM_BOOT
+/* Recovery check and PARAM_SET writer, driven by the bus taps -------------*/
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  CAN_Frame set;
+
+  (void)frame;
+  (void)origin;
+  (void)ctx;
+
+  if (!started)
+  {
+    /* Params_Init() has run once the node is on the bus */
+    started = 1;
+    if (Params_Get(PARAM_TEMP_OFFSET) != oracle.durable)
+    {
+      fprintf(stderr, "sim: PARAM_TEMP_OFFSET recovered as %ld, %ld was durable\n",
+              (long)(int32_t)Params_Get(PARAM_TEMP_OFFSET), (long)(int32_t)oracle.durable);
+      failed = 1;
+    }
+    lastSent = (int32_t)Params_Get(PARAM_TEMP_OFFSET);
+    nextWriteUs = timeUs;
+  }
+
+  while ((Sim_Cfg.paramRateHz > 0.0) && (nextWriteUs <= (timeUs + SIM_WRITER_AHEAD_US)))
+  {
+    int32_t value = (lastSent >= SIM_WRITER_MAX) ? SIM_WRITER_MIN : (lastSent + 1);
+
+    memset(&set, 0xFF, sizeof(set));
+    set.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, SIM_WRITER_ADDRESS);
+    set.dlc = 8;
+    set.data[0] = PARAMS_CMD_SET;
+    set.data[1] = (uint8_t)PARAM_TEMP_OFFSET;
+    set.data[2] = 0;
+    set.data[3] = (uint8_t)value;
+    set.data[4] = (uint8_t)((uint32_t)value >> 8);
+    set.data[5] = (uint8_t)((uint32_t)value >> 16);
+    set.data[6] = (uint8_t)((uint32_t)value >> 24);
+    if (SimCan_Inject(&set, nextWriteUs, SIM_CAN_ORIGIN_MODEL) != 0)
+    {
+      break;
+    }
+    lastSent = value;
+    writesSent++;
+    nextWriteUs += (uint64_t)(1e6 / Sim_Cfg.paramRateHz);
+  }
+}
+#endif /* !SIM_BOOT */
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Maps the parameter pages (and the application area in the BOOT=1
+  *         build), loads them from the -F file and starts the -P writer
+  * @retval None
+  */
+void SimFlash_Init(void)
+{
+  FILE *f;
+
+  flash = mmap((void *)SIM_FLASH_BASE, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  if ((flash == MAP_FAILED) || (flash != (uint8_t *)SIM_FLASH_BASE))
+  {
+    perror("sim: cannot map the flash pages");
+    exit(2);
+  }
+  memset(flash, 0xFF, SIM_FLASH_SIZE);
+  oracle.magic = SIM_FLASH_FILE_MAGIC;
+  oracle.durable = 0;     /* PARAM_TEMP_OFFSET default */
+
+  if ((Sim_Cfg.flashPath != NULL) && ((f = fopen(Sim_Cfg.flashPath, "rb")) != NULL))
+  {
+    if (fread(flash, 1, SIM_FLASH_SIZE, f) != SIM_FLASH_SIZE)
+    {
+      fprintf(stderr, "sim: %s is not a flash image of this build\n", Sim_Cfg.flashPath);
+      exit(2);
+    }
+    if ((fread(&oracle, sizeof(oracle), 1, f) != 1U) || (oracle.magic != SIM_FLASH_FILE_MAGIC))
+    {
+      fprintf(stderr, "sim: %s has no power-fail oracle\n", Sim_Cfg.flashPath);
+      exit(2);
+    }
+    fclose(f);
+  }
+#if !SIM_BOOT
+  SimCan_AddTap(busTap, NULL);
+#endif
+}
+
+/**
+  * @brief  Writes the pages back to the -F file
+  * @retval 0, or 1 when a power-fail check failed
+  */
+int SimFlash_Close(void)
+{
+  save();
+  return failed;
+}
+
+/**
+  * @brief  Prints flash wear and parameter store statistics
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimFlash_Report(FILE *out, double seconds)
+{
+  double hours = seconds / 3600.0;
+
+#if SIM_BOOT
+  (void)hours;
+  fprintf(out, "===== Flash =====\n");
+  fprintf(out, "  programmed   %10lu bytes\n", (unsigned long)halfwords * 2UL);
+  fprintf(out, "  erases       %10lu pages\n", (unsigned long)erases);
+  fprintf(out, "  CPU stalled  %10.3f ms\n", (double)stallUs / 1e3);
+  fprintf(out, "  RX lost      %10lu frames, FIFO0 overrun while stalled\n", (unsigned long)stallLost);
+#else
+  fprintf(out, "===== Parameter flash =====\n");
+  fprintf(out, "  at start     generation %lu, %lu records, %lu skipped\n",
+          (unsigned long)paramsStats.generation - paramsStats.compactions,
+          (unsigned long)paramsStats.bootRecords, (unsigned long)paramsStats.bootSkipped);
+  if (Sim_Cfg.paramRateHz > 0.0)
+  {
+    fprintf(out, "  writer       %10lu PARAM_SET sent, offset now %ld\n",
+            (unsigned long)writesSent, (long)(int32_t)Params_Get(PARAM_TEMP_OFFSET));
+  }
+  fprintf(out, "  updates      %10lu\n", (unsigned long)paramsStats.updates);
+  fprintf(out, "  records      %10lu (%lu updates coalesced)\n", (unsigned long)paramsStats.records,
+          (unsigned long)((paramsStats.updates > paramsStats.records) ? (paramsStats.updates - paramsStats.records) : 0U));
+  fprintf(out, "  programmed   %10lu bytes\n", (unsigned long)paramsStats.halfwords * 2UL);
+  fprintf(out, "  erases       %10lu (%lu compactions)\n", (unsigned long)paramsStats.erases,
+          (unsigned long)paramsStats.compactions);
+  if (paramsStats.records != 0U)
+  {
+    fprintf(out, "  write ampl.  %10.2f (bytes programmed per record byte)\n",
+            (double)paramsStats.halfwords * 2.0 / ((double)paramsStats.records * PARAMS_RECORD_SIZE));
+  }
+  if (paramsStats.updates != 0U)
+  {
+    fprintf(out, "  per update   %10.2f bytes\n", (double)paramsStats.halfwords * 2.0 / (double)paramsStats.updates);
+  }
+  if ((paramsStats.compactions != 0U) && (hours > 0.0))
+  {
+    fprintf(out, "  endurance    %10.0f h at this rate (%u cycles per page)\n",
+            2.0 * SIM_FLASH_ENDURANCE * hours / (double)paramsStats.compactions, SIM_FLASH_ENDURANCE);
+  }
+  fprintf(out, "  erase waits  %10lu for a quiet bus (%lu cut short at %u ms)\n",
+          (unsigned long)paramsStats.deferred, (unsigned long)paramsStats.forced, PARAMS_ERASE_DEFER_MS);
+  fprintf(out, "  CPU stalled  %10.3f ms\n", (double)stallUs / 1e3);
+  fprintf(out, "  RX lost      %10lu frames, FIFO0 overrun while stalled\n", (unsigned long)stallLost);
+  if (paramsStats.errors != 0U)
+  {
+    fprintf(out, "  errors       %10lu\n", (unsigned long)paramsStats.errors);
+  }
+#endif
+}
+
+/* HAL API -------------------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+  locked = 0;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+  locked = 1;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+  uint32_t count = (TypeProgram == FLASH_TYPEPROGRAM_HALFWORD) ? 1U :
+                   ((TypeProgram == FLASH_TYPEPROGRAM_WORD) ? 2U : 4U);
+  uint32_t i;
+
+  if (locked || ((Address & 1U) != 0U) || (Address < SIM_FLASH_BASE) ||
+      ((Address + (count * 2U)) > (SIM_FLASH_BASE + SIM_FLASH_SIZE)))
+  {
+    return HAL_ERROR;
+  }
+  for (i = 0; i < count; i++)
+  {
+    uint16_t *cell = (uint16_t *)(uintptr_t)(Address + (i * 2U));
+    uint16_t value = (uint16_t)(Data >> (i * 16U));
+
+    if (operation(SIM_FLASH_PROGRAM_US) != 0)
+    {
+      powerCut();
+    }
+    /* PGERR: the half-word is not erased and the new value is not zero */
+    if ((*cell != 0xFFFFU) && (value != 0U))
+    {
+      return HAL_ERROR;
+    }
+    *cell = value;
+    halfwords++;
+    track(Address + (i * 2U));
+  }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+  uint32_t page;
+
+  *PageError = 0xFFFFFFFFUL;
+  if (locked)
+  {
+    return HAL_ERROR;
+  }
+  for (page = 0; page < pEraseInit->NbPages; page++)
+  {
+    uint32_t address = pEraseInit->PageAddress + (page * PARAMS_PAGE_SIZE);
+
+    if ((address < SIM_FLASH_BASE) || (address >= (SIM_FLASH_BASE + SIM_FLASH_SIZE)))
+    {
+      *PageError = address;
+      return HAL_ERROR;
+    }
+    if (operation(SIM_FLASH_ERASE_US) != 0)
+    {
+      memset((void *)(uintptr_t)address, 0xFF, PARAMS_PAGE_SIZE / 2U);
+      powerCut();
+    }
+    memset((void *)(uintptr_t)address, 0xFF, PARAMS_PAGE_SIZE);
+    erases++;
+    if (address >= PARAMS_FLASH_BASE)
+    {
+      pageHasValue[SIM_FLASH_PAGE(address)] = 0;
+    }
+  }
+  return HAL_OK;
+}
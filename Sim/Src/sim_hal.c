@@ -0,0 +1,1225 @@
+/**
+  ******************************************************************************
+  * @file           : sim_hal.c
+  * @brief          : Simulated HAL, core peripherals and virtual time
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Time only moves when the firmware waits (HAL_Delay, __WFI). Code between
+  * two waits runs in zero virtual time, so results are deterministic and a
+  * run is limited by host CPU speed rather than by the wall clock.
+  *
+  * Interrupts are raised by the peripheral models with Sim_RaiseIrq() and
+  * taken in NVIC priority order whenever PRIMASK is clear and time advances.
+  *
+  * With Sim_Cfg.timeScale set, virtual time is held back to the (scaled)
+  * wall clock instead, so the node can share a bus with real tools.
+  *
+  * For the power report every microsecond is booked to the CPU state it
+  * was spent in: Sleep while in __WFI, Stop inside HAL_PWR_EnterSTOPMode()
+  * and active otherwise (HAL_Delay, busy polling, clock start-up). Handler
+  * and task run times are not simulated and are added from a cycle model.
+  *
+  * The BOOT=1 build (SIM_BOOT) runs the bootloader: only the models and
+  * handlers it has, and no ADC or RTC calendar.
+  */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+#include "main.h"
+#include "stm32f3xx_it.h"
+#include "scheduler.h"
+#include "rtc.h"
+#include "sim.h"
+
+/* HAL_GetTick() calls without time moving before the caller counts as busy
+ * polling and time skips to the next event */
+#define SIM_SPIN_LIMIT        64U
+
+/* HSE start-up and PLL lock after Stop mode */
+#define SIM_HSE_RESTART_US    1200U
+
+/* The RTC (LSI) and SysTick (HSE) share virtual time here, so their phase
+ * is fixed; half a millisecond apart, Stop compensation by RTC milliseconds
+ * rounds as often up as down, as it does with the clocks unlocked */
+#define SIM_RTC_PHASE_US      500U
+
+/* Cycle model for the power report (not simulated in virtual time) */
+#define SIM_SLEEP_WAKE_CYCLES 12U     /* exception entry from Sleep */
+#define SIM_TASK_CYCLES       500U    /* average task run incl. the pass */
+
+enum
+{
+  SIM_CPU_ACTIVE = 0,
+  SIM_CPU_SLEEP,
+  SIM_CPU_STOP,
+  SIM_CPU_STATES
+};
+
+/* Register blocks -----------------------------------------------------------*/
+RCC_TypeDef          Sim_RCC;
+GPIO_TypeDef         Sim_GPIOA;
+GPIO_TypeDef         Sim_GPIOB;
+GPIO_TypeDef         Sim_GPIOF;
+ADC_TypeDef          Sim_ADC1;
+ADC_Common_TypeDef   Sim_ADC12_COMMON;
+FLASH_TypeDef        Sim_FLASH;
+PWR_TypeDef          Sim_PWR;
+RTC_TypeDef          Sim_RTC;
+SYSCFG_TypeDef       Sim_SYSCFG;
+EXTI_TypeDef         Sim_EXTI;
+CRC_TypeDef          Sim_CRC;
+IWDG_TypeDef         Sim_IWDG;
+USART_TypeDef        Sim_USART3;
+DMA_Channel_TypeDef  Sim_DMA1_Channel[7];
+DBGMCU_TypeDef       Sim_DBGMCU;
+SCB_Type             Sim_SCB;
+SysTick_Type         Sim_SysTick;
+NVIC_Type            Sim_NVIC;
+ITM_Type             Sim_ITM;
+DWT_Type             Sim_DWT;
+TPI_Type             Sim_TPI;
+CoreDebug_Type       Sim_CoreDebug;
+
+uint16_t Sim_Temp30Cal;
+uint16_t Sim_Temp110Cal;
+
+volatile uint32_t Sim_Primask;
+
+/* HAL globals normally provided by stm32f3xx_hal.c and system_stm32f3xx.c */
+uint32_t SystemCoreClock = 8000000U;
+__IO uint32_t uwTick;
+uint32_t uwTickPrio = (1UL << __NVIC_PRIO_BITS);
+HAL_TickFreqTypeDef uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+
+/* Simulation state ----------------------------------------------------------*/
+Sim_Config Sim_Cfg =
+{
+  .durationUs = 60ULL * 1000000ULL,
+  .tempC = 25.0,
+  .rampCPerMin = 0.0,
+  .noiseLsb = 0.0,
+  .timeScale = 0.0,
+  .seed = 1U,
+  .bitrate = 0U,
+  .cal30 = 1774U,
+  .cal110 = 1348U,
+  .flashPath = NULL,
+  .paramRateHz = 0.0,
+  .powerCutOp = 0U,
+  .replaySpeed = 1.0,
+  .quiet = 0,
+};
+
+uint64_t Sim_NowUs;
+
+static uint64_t nextTickUs = UINT64_MAX;
+static uint64_t pendingIrqs;          /* bit (IRQn + 16) per pending source */
+static uint32_t noiseState;
+
+/* ADC1 ISR flags are cleared by writing 1; the model keeps them here and
+ * shows them with a reserved bit set, which any firmware write clears */
+#define SIM_ADC_ISR_UNWRITTEN   (1UL << 31)
+#define SIM_ADC_CHANNEL         16UL      /* temperature sensor */
+#if !SIM_BOOT
+static uint16_t adcLatched;
+static uint32_t adcFlags;
+#endif
+static struct timespec hostStart;
+static volatile sig_atomic_t stopRequested;
+static int dispatching;
+
+/* Low-power model */
+static uint32_t cpuState = SIM_CPU_ACTIVE;
+static uint64_t residencyUs[SIM_CPU_STATES];
+static uint64_t handlerCycles;
+static uint32_t wakeups;
+static int hseStopped;
+static uint64_t stopWakeUs = UINT64_MAX;
+static uint64_t stopLatencySumUs;
+static uint64_t stopLatencyMaxUs;
+static uint32_t stopLatencyCount;
+static int rtcRunning;
+static uint64_t rtcStartUs;
+static uint64_t rtcWakeUs = UINT64_MAX;
+static uint64_t rtcWakePeriodUs;
+
+/* Cycle counter model, from the enable of DWT->CYCCNT */
+static Sim_CycleModel cycleModel = { .startUs = UINT64_MAX };
+static uint32_t handlerPending;       /* modelled cycles of the running handler */
+static uint32_t handlerReads;         /* its reads of the counter so far */
+
+/* Handlers in descending priority: CAN RX and the ADC before TX (see
+ * HAL_CAN_MspInit, HAL_ADC_MspInit), SysTick last (TICK_INT_PRIORITY);
+ * cycles feed the power report */
+static const struct
+{
+  IRQn_Type irq;
+  void (*handler)(void);
+  uint32_t cycles;
+} irqTable[] =
+{
+#if SIM_BOOT
+  { CAN_RX0_IRQn,     CAN_RX0_IRQHandler,   300U },
+  { SysTick_IRQn,     SysTick_Handler,       50U },
+#else
+  { CAN_RX0_IRQn,     CAN_RX0_IRQHandler,   300U },
+  { CAN_SCE_IRQn,     CAN_SCE_IRQHandler,   100U },
+  { ADC1_2_IRQn,      ADC1_2_IRQHandler,    150U },
+  { CAN_TX_IRQn,      CAN_TX_IRQHandler,    200U },
+  { RTC_WKUP_IRQn,    RTC_WKUP_IRQHandler,  150U },
+  { EXTI15_10_IRQn,   EXTI15_10_IRQHandler, 100U },
+  { SysTick_IRQn,     SysTick_Handler,       50U },
+#endif
+};
+
+static uint32_t irqRuns[sizeof(irqTable) / sizeof(irqTable[0])];   /* since startUs */
+
+static void onSignal(int sig)
+{
+  (void)sig;
+  stopRequested = 1;
+}
+
+/**
+  * @brief  Records the host start time and installs the Ctrl-C handler
+  * @retval None
+  */
+void Sim_Start(void)
+{
+  Sim_Temp30Cal = Sim_Cfg.cal30;
+  Sim_Temp110Cal = Sim_Cfg.cal110;
+  Sim_DBGMCU.IDCODE = 0x10000438U;    /* STM32F334, revision 0x1000 */
+  noiseState = (Sim_Cfg.seed != 0U) ? Sim_Cfg.seed : 1U;
+  SimCan_Init();
+  SimFlash_Init();
+#if SIM_BOOT
+  SimBoot_Init();
+#else
+  SimHistory_Init();
+  SimReplay_Init();
+  SimWatchdog_Init();
+  SimCrash_Init();
+  SimRam_Init();
+  SimStress_Init();
+  SimMonitor_Init();
+  SimPing_Init();
+  SimStatus_Init();
+  SimCpu_Init();
+  SimAlarm_Init();
+  SimFilter_Init();
+  SimTrend_Init();
+#endif
+  Sim_ADC1.ISR = SIM_ADC_ISR_UNWRITTEN;
+  clock_gettime(CLOCK_MONOTONIC, &hostStart);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+}
+
+/**
+  * @brief  Prints the end-of-run report and exits
+  * @retval None
+  */
+void Sim_Finish(void)
+{
+  struct timespec now;
+  double host;
+  double virt = (double)Sim_NowUs / 1e6;
+#if SIM_BOOT
+  int failed = SimFlash_Close() | SimBoot_Close();
+#else
+  int failed = SimFlash_Close() | SimHistory_Close() | SimWatchdog_Close() | SimCrash_Close() | SimRam_Close() |
+               SimStress_Close() | SimMonitor_Close() | SimPing_Close() |
+               SimStatus_Close() | SimCpu_Close() | SimAlarm_Close() | SimFilter_Close() |
+               SimTrend_Close();
+#endif
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  host = (double)(now.tv_sec - hostStart.tv_sec) + (double)(now.tv_nsec - hostStart.tv_nsec) / 1e9;
+
+  SimLog_Close();
+#if !SIM_BOOT
+  SimReplay_Close();
+#endif
+  if (!Sim_Cfg.quiet)
+  {
+    fprintf(stderr, "===== Simulation =====\n");
+    fprintf(stderr, "  virtual time %10.3f s\n", virt);
+    fprintf(stderr, "  host time    %10.3f s (%.0fx real time)\n", host,
+            (host > 0.0) ? virt / host : 0.0);
+    fprintf(stderr, "  HAL ticks    %10lu\n", (unsigned long)uwTick);
+    SimCan_Report(stderr, virt);
+    SimSocketCan_Report(stderr);
+    SimFlash_Report(stderr, virt);
+#if SIM_BOOT
+    SimBoot_Report(stderr, virt);
+#else
+    SimHistory_Report(stderr, virt);
+    SimReplay_Report(stderr, virt);
+    SimWatchdog_Report(stderr, virt);
+    SimCrash_Report(stderr, virt);
+    SimRam_Report(stderr, virt);
+    SimStress_Report(stderr, virt);
+    SimMonitor_Report(stderr, virt);
+    SimPing_Report(stderr, virt);
+    SimStatus_Report(stderr, virt);
+    SimCpu_Report(stderr, virt);
+    SimAlarm_Report(stderr, virt);
+    SimFilter_Report(stderr, virt);
+    SimTrend_Report(stderr, virt);
+#endif
+    SimPower_Report(stderr, virt);
+  }
+  exit(failed);
+}
+
+void Sim_SystemReset(void)
+{
+  fprintf(stderr, "sim: system reset requested at %.6f s\n", (double)Sim_NowUs / 1e6);
+  Sim_Finish();
+}
+
+/**
+  * @brief  Marks an interrupt pending; it is taken on the next time advance
+  * @param  irq: CMSIS interrupt number
+  * @retval None
+  */
+void Sim_RaiseIrq(IRQn_Type irq)
+{
+  pendingIrqs |= 1ULL << ((int32_t)irq + 16);
+}
+
+static uint64_t nextEventUs(void);
+
+static void dispatchIrqs(void)
+{
+  size_t i;
+
+  /* Handlers do not preempt each other; a PRIMASK restore inside one must
+   * not start the next */
+  if (dispatching)
+  {
+    return;
+  }
+  dispatching = 1;
+  for (i = 0; (i < sizeof(irqTable) / sizeof(irqTable[0])) && (Sim_Primask == 0U); i++)
+  {
+    uint64_t bit = 1ULL << ((int32_t)irqTable[i].irq + 16);
+
+    if ((pendingIrqs & bit) != 0U)
+    {
+      pendingIrqs &= ~bit;
+      if (irqTable[i].irq == SysTick_IRQn)
+      {
+        Sim_SCB.ICSR &= ~SCB_ICSR_PENDSTSET_Msk;
+      }
+      handlerCycles += irqTable[i].cycles;
+      if ((Sim_DWT.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0U)
+      {
+        irqRuns[i]++;
+        handlerPending = irqTable[i].cycles;
+        handlerReads = 0;
+        cycleModel.modelledCycles += handlerPending;
+      }
+#if !SIM_BOOT
+      if ((irqTable[i].irq == CAN_RX0_IRQn) && SimWatchdog_Hang(SIM_HANG_RX))
+      {
+        /* The handler never returns: time goes on, nothing else is taken */
+        for (;;)
+        {
+          Sim_AdvanceTo(nextEventUs());
+        }
+      }
+#endif
+      irqTable[i].handler();
+      Sim_DWT.CYCCNT += handlerPending;   /* a handler that never read it */
+      handlerPending = 0;
+      i = (size_t)-1;   /* rescan: the handler may have raised a higher priority */
+    }
+  }
+  dispatching = 0;
+}
+
+/**
+  * @brief  __enable_irq/__set_PRIMASK: pending interrupts are taken as soon
+  *         as PRIMASK is cleared
+  * @param  mask: new PRIMASK value
+  * @retval None
+  */
+void Sim_SetPrimask(uint32_t mask)
+{
+  Sim_Primask = mask & 1U;
+  if ((Sim_Primask == 0U) && (pendingIrqs != 0U))
+  {
+    dispatchIrqs();
+  }
+}
+
+/**
+  * @brief  DWT->CYCCNT as read by the CPU accounting (CPU_CYCLES() in cpu.h)
+  * @retval cycle count
+  *
+  * Handlers take no virtual time; the modelled cycles of the one running
+  * pass at its second read, between Cpu_Enter() and Cpu_Exit(), so the
+  * accounting sees them as the handler's own.
+  */
+uint32_t Sim_CpuCycles(void)
+{
+  if (dispatching && (handlerReads++ != 0U))
+  {
+    Sim_DWT.CYCCNT += handlerPending;
+    handlerPending = 0;
+  }
+  return Sim_DWT.CYCCNT;
+}
+
+/**
+  * @brief  The cycle counter model so far, for the accounting check
+  * @param  model: destination
+  * @retval None
+  */
+void Sim_CycleModelGet(Sim_CycleModel *model)
+{
+  *model = cycleModel;
+  model->modelledCycles -= handlerPending;  /* a hung handler's, not counted yet */
+}
+
+/**
+  * @brief  Runs of a handler since the cycle counter was enabled
+  * @param  irq: handler, as in the dispatch table
+  * @param  cycles: destination for its modelled cycles per run
+  * @retval runs, 0 for a handler not in the table
+  */
+uint32_t Sim_IrqRuns(IRQn_Type irq, uint32_t *cycles)
+{
+  size_t i;
+
+  *cycles = 0;
+  for (i = 0; i < sizeof(irqTable) / sizeof(irqTable[0]); i++)
+  {
+    if (irqTable[i].irq == irq)
+    {
+      *cycles = irqTable[i].cycles;
+      return irqRuns[i];
+    }
+  }
+  return 0;
+}
+
+static void setNow(uint64_t nowUs)
+{
+  residencyUs[cpuState] += nowUs - Sim_NowUs;
+
+  /* DWT->CYCCNT counts from its enable at SIM_CPU_HZ, except in Stop */
+  if ((Sim_DWT.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0U)
+  {
+    if (cycleModel.startUs == UINT64_MAX)
+    {
+      cycleModel.startUs = Sim_NowUs;
+    }
+    if (cpuState == SIM_CPU_STOP)
+    {
+      cycleModel.stopUs += nowUs - Sim_NowUs;
+      cycleModel.lastStopUs += nowUs - Sim_NowUs;
+    }
+    else
+    {
+      Sim_DWT.CYCCNT += (uint32_t)((nowUs - Sim_NowUs) * (SIM_CPU_HZ / 1000000UL));
+    }
+  }
+  Sim_NowUs = nowUs;
+
+  /* SysTick counts down to the next tick */
+  if (nextTickUs != UINT64_MAX)
+  {
+    uint64_t left = (nextTickUs > nowUs) ? (nextTickUs - nowUs) : 0U;
+
+    Sim_SysTick.VAL = (uint32_t)((left * (Sim_SysTick.LOAD + 1U)) / (1000U * (uint64_t)uwTickFreq));
+    if (Sim_SysTick.VAL > Sim_SysTick.LOAD)
+    {
+      Sim_SysTick.VAL = Sim_SysTick.LOAD;
+    }
+  }
+
+  /* RTC calendar, read live by RTC_GetMillis() (BYPSHAD) */
+  if (rtcRunning)
+  {
+    uint64_t ms = ((nowUs - rtcStartUs + SIM_RTC_PHASE_US) / 1000U) % 86400000ULL;
+    uint32_t sec = (uint32_t)(ms / 1000U);
+
+    Sim_RTC.SSR = RTC_SYNCH_PREDIV - (uint32_t)(ms % 1000U);
+    Sim_RTC.TR = ((uint32_t)RTC_ByteToBcd2((uint8_t)(sec / 3600U)) << RTC_TR_HU_Pos) |
+                 ((uint32_t)RTC_ByteToBcd2((uint8_t)((sec / 60U) % 60U)) << RTC_TR_MNU_Pos) |
+                 ((uint32_t)RTC_ByteToBcd2((uint8_t)(sec % 60U)) << RTC_TR_SU_Pos);
+  }
+}
+
+/* Earliest model event: bus, SysTick, RTC wake-up timer or IWDG (the
+ * uploader's timeouts in the bootloader build) */
+static uint64_t nextEventUs(void)
+{
+  uint64_t next = SimCan_NextEventUs();
+#if SIM_BOOT
+  uint64_t iwdg = SimBoot_NextEventUs();
+#else
+  uint64_t iwdg = SimWatchdog_NextEventUs();
+#endif
+
+  if (nextTickUs < next)
+  {
+    next = nextTickUs;
+  }
+  if (rtcWakeUs < next)
+  {
+    next = rtcWakeUs;
+  }
+  if (iwdg < next)
+  {
+    next = iwdg;
+  }
+  return next;
+}
+
+/**
+  * @brief  Host time since Sim_Start(), in virtual microseconds
+  * @retval wall clock scaled by Sim_Cfg.timeScale
+  */
+uint64_t Sim_WallUs(void)
+{
+  struct timespec now;
+  double us;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  us = (double)(now.tv_sec - hostStart.tv_sec) * 1e6 + (double)(now.tv_nsec - hostStart.tv_nsec) / 1e3;
+  return (uint64_t)(us * Sim_Cfg.timeScale);
+}
+
+/* Holds virtual time back to the scaled wall clock; returns early, at the
+ * time of arrival, when the SocketCAN bridge injected frames */
+static uint64_t paceTo(uint64_t stepUs)
+{
+  for (;;)
+  {
+    uint64_t wall = Sim_WallUs();
+
+    if ((wall >= stepUs) || stopRequested)
+    {
+      return stepUs;
+    }
+    if (SimSocketCan_Wait((uint64_t)((double)(stepUs - wall) / Sim_Cfg.timeScale) + 1U) > 0)
+    {
+      wall = Sim_WallUs();
+      return (wall < Sim_NowUs) ? Sim_NowUs : ((wall > stepUs) ? stepUs : wall);
+    }
+  }
+}
+
+/**
+  * @brief  Advances virtual time, running every model event and interrupt
+  *         that falls due on the way
+  * @param  targetUs: absolute virtual time in microseconds
+  * @retval None
+  */
+void Sim_AdvanceTo(uint64_t targetUs)
+{
+  for (;;)
+  {
+    uint64_t next = nextEventUs();
+    uint64_t step;
+
+    if ((Sim_Cfg.durationUs != 0U) && (next > Sim_Cfg.durationUs) && (targetUs >= Sim_Cfg.durationUs))
+    {
+      setNow(Sim_Cfg.durationUs);
+      Sim_Finish();
+    }
+    if (stopRequested)
+    {
+      Sim_Finish();
+    }
+
+    step = (next > targetUs) ? targetUs : next;
+    if (Sim_Cfg.timeScale > 0.0)
+    {
+      uint64_t reached = paceTo(step);
+
+      if (reached < step)
+      {
+        setNow(reached);
+        SimCan_Process(Sim_NowUs);
+        dispatchIrqs();
+        continue;
+      }
+    }
+    setNow(step);
+    if (next > targetUs)
+    {
+      break;
+    }
+
+    if (next == nextTickUs)
+    {
+      nextTickUs += 1000U * (uint64_t)uwTickFreq;
+      /* Reloaded; PENDSTSET tells Scheduler_Micros() that uwTick lags */
+      Sim_SysTick.VAL = Sim_SysTick.LOAD;
+      /* Cleared by HAL_SuspendTick() */
+      if ((Sim_SysTick.CTRL & SysTick_CTRL_TICKINT_Msk) != 0U)
+      {
+        Sim_SCB.ICSR |= SCB_ICSR_PENDSTSET_Msk;
+        Sim_RaiseIrq(SysTick_IRQn);
+      }
+    }
+    if (next == rtcWakeUs)
+    {
+      rtcWakeUs += rtcWakePeriodUs;
+      Sim_RTC.ISR |= RTC_ISR_WUTF;
+      Sim_EXTI.PR |= EXTI_PR_PR20;
+      Sim_RaiseIrq(RTC_WKUP_IRQn);
+    }
+#if SIM_BOOT
+    SimBoot_Process(Sim_NowUs);
+#else
+    SimWatchdog_Process(Sim_NowUs);
+#endif
+    SimCan_Process(Sim_NowUs);
+    dispatchIrqs();
+  }
+
+  dispatchIrqs();
+}
+
+/* Runs time forward to the next event, or takes pending interrupts */
+static void waitForEvent(void)
+{
+  static uint64_t lastUs;
+  static uint32_t spins;
+  uint64_t next = nextEventUs();
+
+  if (Sim_NowUs != lastUs)
+  {
+    lastUs = Sim_NowUs;
+    spins = 0;
+  }
+  if (pendingIrqs != 0U)
+  {
+    /* With PRIMASK set a pending interrupt still ends WFI, untaken; a WFI
+     * loop with interrupts off only waits for the IWDG */
+    if (Sim_Primask == 0U)
+    {
+      dispatchIrqs();
+      return;
+    }
+    if (++spins < SIM_SPIN_LIMIT)
+    {
+      return;
+    }
+    spins = 0;
+  }
+  if (next == UINT64_MAX)
+  {
+    fprintf(stderr, "sim: __WFI with no event left to wake up\n");
+    Sim_Finish();
+  }
+  Sim_AdvanceTo(next);
+}
+
+/**
+  * @brief  __WFI/__WFE: sleeps until the next event, or returns at once when
+  *         an interrupt is already pending
+  * @retval None
+  */
+void Sim_WaitForInterrupt(void)
+{
+  if (pendingIrqs == 0U)
+  {
+    wakeups++;
+  }
+  cpuState = SIM_CPU_SLEEP;
+  waitForEvent();
+  cpuState = SIM_CPU_ACTIVE;
+}
+
+/* ADC temperature sensor model ----------------------------------------------*/
+static uint32_t xorshift32(void)
+{
+  noiseState ^= noiseState << 13;
+  noiseState ^= noiseState >> 17;
+  noiseState ^= noiseState << 5;
+  return noiseState;
+}
+
+/**
+  * @brief  Modelled die temperature now, through the factory calibration
+  *         line (inverse of temperature.c), before noise and rounding
+  * @retval ADC counts, not clamped
+  */
+double Sim_AdcModel(void)
+{
+  double minutes = (double)Sim_NowUs / 60e6;
+  double tempC = Sim_Cfg.tempC + Sim_Cfg.rampCPerMin * minutes;
+
+  return (double)Sim_Cfg.cal30 + (tempC - 30.0) * ((double)Sim_Cfg.cal110 - (double)Sim_Cfg.cal30) / 80.0;
+}
+
+/**
+  * @brief  Converts the modelled die temperature to a raw 12-bit reading
+  * @retval ADC counts
+  */
+uint16_t Sim_AdcSample(void)
+{
+  double raw = Sim_AdcModel();
+
+  if (Sim_Cfg.noiseLsb > 0.0)
+  {
+    raw += Sim_Cfg.noiseLsb * (2.0 * ((double)xorshift32() / 4294967295.0) - 1.0);
+  }
+  if (raw < 0.0)
+  {
+    raw = 0.0;
+  }
+  if (raw > 4095.0)
+  {
+    raw = 4095.0;
+  }
+  return (uint16_t)(raw + 0.5);
+}
+
+/* HAL core ------------------------------------------------------------------*/
+HAL_StatusTypeDef HAL_Init(void)
+{
+  HAL_InitTick(TICK_INT_PRIORITY);
+  HAL_MspInit();
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+  uwTickPrio = TickPriority;
+  nextTickUs = Sim_NowUs + 1000U * (uint64_t)uwTickFreq;
+  Sim_SysTick.LOAD = (SIM_CPU_HZ / 1000U) - 1U;
+  Sim_SysTick.VAL = Sim_SysTick.LOAD;   /* a whole tick to go */
+  Sim_SysTick.CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+  return HAL_OK;
+}
+
+void HAL_IncTick(void)
+{
+  uwTick += (uint32_t)uwTickFreq;
+}
+
+uint32_t HAL_GetTick(void)
+{
+  static uint64_t lastUs;
+  static uint32_t spins;
+
+  if (Sim_NowUs != lastUs)
+  {
+    lastUs = Sim_NowUs;
+    spins = 0;
+  }
+  else if (++spins >= SIM_SPIN_LIMIT)
+  {
+    /* Polling loop: nothing changes before the next event */
+    spins = 0;
+    waitForEvent();
+  }
+  return uwTick;
+}
+
+/* Device identification, normally read from DBGMCU and system memory; the
+ * unique ID is that of a real F334 */
+uint32_t HAL_GetREVID(void)
+{
+  return DBGMCU->IDCODE >> 16;
+}
+
+uint32_t HAL_GetUIDw0(void)
+{
+  return 0x00420031U;
+}
+
+uint32_t HAL_GetUIDw1(void)
+{
+  return 0x3236510BU;
+}
+
+uint32_t HAL_GetUIDw2(void)
+{
+  return 0x20353850U;
+}
+
+void HAL_SuspendTick(void)
+{
+  Sim_SysTick.CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+}
+
+void HAL_ResumeTick(void)
+{
+  Sim_SysTick.CTRL |= SysTick_CTRL_TICKINT_Msk;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+  uint32_t tickstart = HAL_GetTick();
+  uint32_t wait = Delay;
+
+  /* Same minimum-wait rule as the real HAL_Delay() */
+  if (wait < HAL_MAX_DELAY)
+  {
+    wait += (uint32_t)uwTickFreq;
+  }
+  /* Busy wait: the CPU stays active */
+  while ((HAL_GetTick() - tickstart) < wait)
+  {
+    waitForEvent();
+  }
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  (void)IRQn;
+  (void)PreemptPriority;
+  (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+  Sim_RaiseIrq(IRQn);
+}
+
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+  pendingIrqs &= ~(1ULL << ((int32_t)IRQn + 16));
+}
+
+void HAL_NVIC_SystemReset(void)
+{
+  Sim_SystemReset();
+}
+
+/* PWR -----------------------------------------------------------------------*/
+void HAL_PWR_EnableBkUpAccess(void)
+{
+  Sim_PWR.CR |= PWR_CR_DBP;
+}
+
+void HAL_PWR_EnterSLEEPMode(uint32_t Regulator, uint8_t SLEEPEntry)
+{
+  (void)Regulator;
+  (void)SLEEPEntry;
+  __WFI();
+}
+
+/**
+  * @brief  Stop mode: time runs on with SysTick and bxCAN frozen until the RTC
+  *         wake-up timer or a falling edge on CAN_RX (EXTI line 11, when
+  *         unmasked); the core then runs from HSI until HSE/PLL are restarted
+  * @retval None
+  */
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry)
+{
+  (void)Regulator;
+  (void)STOPEntry;
+
+  /* PR is write-1-to-clear on the chip; plain memory keeps the firmware's
+   * clearing write, so the line starts clear */
+  Sim_EXTI.PR &= ~EXTI_PR_PR11;
+  hseStopped = 1;
+  cpuState = SIM_CPU_STOP;
+  if ((Sim_DWT.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0U)
+  {
+    cycleModel.stops++;
+    cycleModel.lastStopUs = 0;
+  }
+  while (pendingIrqs == 0U)
+  {
+    uint64_t edge = UINT64_MAX;
+    uint64_t next = nextEventUs();
+
+    if (((Sim_EXTI.IMR & EXTI_IMR_MR11) != 0U) && ((Sim_EXTI.FTSR & EXTI_FTSR_TR11) != 0U))
+    {
+      edge = SimCan_NextActivityUs();
+    }
+    if (edge <= Sim_NowUs)
+    {
+      Sim_EXTI.PR |= EXTI_PR_PR11;
+      Sim_RaiseIrq(EXTI15_10_IRQn);
+      break;
+    }
+    Sim_AdvanceTo((edge < next) ? edge : next);
+  }
+  cpuState = SIM_CPU_ACTIVE;
+  wakeups++;
+  stopWakeUs = Sim_NowUs;
+}
+
+/**
+  * @brief  Called when bxCAN leaves sleep mode: ends a Stop wake-up
+  * @retval None
+  */
+void SimPower_CanOnline(void)
+{
+  if (stopWakeUs != UINT64_MAX)
+  {
+    uint64_t latency = Sim_NowUs - stopWakeUs;
+
+    stopLatencySumUs += latency;
+    stopLatencyCount++;
+    if (latency > stopLatencyMaxUs)
+    {
+      stopLatencyMaxUs = latency;
+    }
+    stopWakeUs = UINT64_MAX;
+  }
+}
+
+/**
+  * @brief  Prints CPU state residency, wake-ups and wake latency
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimPower_Report(FILE *out, double seconds)
+{
+  static const char *const modes[] = { "run", "sleep", "stop" };
+  double total = (double)Sim_NowUs;
+#if SIM_BOOT
+  double modelled = (double)handlerCycles / ((double)SIM_CPU_HZ / 1e6);
+#else
+  double modelled = ((double)handlerCycles + (double)schedulerStats.taskRuns * SIM_TASK_CYCLES) /
+                    ((double)SIM_CPU_HZ / 1e6);
+#endif
+  double active = (double)residencyUs[SIM_CPU_ACTIVE] + modelled;
+  double sleep = (double)residencyUs[SIM_CPU_SLEEP] - modelled;
+
+  if (total <= 0.0)
+  {
+    return;
+  }
+  if (sleep < 0.0)
+  {
+    active += sleep;
+    sleep = 0.0;
+  }
+#if SIM_BOOT
+  (void)modes;
+  fprintf(out, "===== Power (bootloader) =====\n");
+#else
+  fprintf(out, "===== Power (idle mode %s) =====\n", modes[SCHEDULER_IDLE_MODE]);
+#endif
+  fprintf(out, "  active       %10.3f %%  (handlers and tasks modelled: %.3f %%)\n",
+          100.0 * active / total, 100.0 * modelled / total);
+  fprintf(out, "  sleep        %10.3f %%\n", 100.0 * sleep / total);
+  fprintf(out, "  stop         %10.3f %%\n", 100.0 * (double)residencyUs[SIM_CPU_STOP] / total);
+  fprintf(out, "  wake-ups     %10.1f /s\n", (seconds > 0.0) ? (double)wakeups / seconds : 0.0);
+  if (SCHEDULER_IDLE_MODE != SCHEDULER_IDLE_RUN)
+  {
+    fprintf(out, "  wake latency %10.3f us from Sleep (%u cycles)\n",
+            (double)SIM_SLEEP_WAKE_CYCLES * 1e6 / (double)SIM_CPU_HZ, SIM_SLEEP_WAKE_CYCLES);
+  }
+  if (stopLatencyCount != 0U)
+  {
+    fprintf(out, "  stop wake    %10.3f ms avg, %.3f ms max to CAN online\n",
+            (double)stopLatencySumUs / (double)stopLatencyCount / 1e3, (double)stopLatencyMaxUs / 1e3);
+  }
+  fprintf(out, "  frames lost  %10lu while bxCAN slept\n", (unsigned long)SimCan_FramesLostAsleep());
+#if !SIM_BOOT
+  fprintf(out, "  firmware     passes %lu  sleeps %lu  stops %lu (CAN %lu, aborted %lu)  idle %.3f %%\n",
+          (unsigned long)schedulerStats.passes, (unsigned long)schedulerStats.sleeps,
+          (unsigned long)schedulerStats.stops, (unsigned long)schedulerStats.canWakeups,
+          (unsigned long)schedulerStats.stopAborts,
+          100.0 * (double)schedulerStats.idleUs / total);
+#endif
+}
+
+/* RCC -----------------------------------------------------------------------*/
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+  /* After Stop the HSE has to start again and the PLL to lock */
+  if (((RCC_OscInitStruct->OscillatorType & RCC_OSCILLATORTYPE_HSE) != 0U) && hseStopped)
+  {
+    hseStopped = 0;
+    Sim_AdvanceTo(Sim_NowUs + SIM_HSE_RESTART_US);
+  }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+  (void)PeriphClkInit;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency)
+{
+  (void)RCC_ClkInitStruct;
+  (void)FLatency;
+  SystemCoreClock = SIM_CPU_HZ;
+  return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+  return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+  return (SystemCoreClock == SIM_CPU_HZ) ? SIM_PCLK1_HZ : SystemCoreClock;
+}
+
+#if !SIM_BOOT
+/* RTC -----------------------------------------------------------------------*/
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef *hrtc_)
+{
+  HAL_RTC_MspInit(hrtc_);
+  rtcRunning = 1;
+  rtcStartUs = Sim_NowUs;
+  setNow(Sim_NowUs);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTCEx_EnableBypassShadow(RTC_HandleTypeDef *hrtc_)
+{
+  (void)hrtc_;
+  Sim_RTC.CR |= RTC_CR_BYPSHAD;
+  return HAL_OK;
+}
+
+/* Only RTC_WAKEUPCLOCK_RTCCLK_DIV16 is modelled */
+HAL_StatusTypeDef HAL_RTCEx_SetWakeUpTimer_IT(RTC_HandleTypeDef *hrtc_, uint32_t WakeUpCounter, uint32_t WakeUpClock)
+{
+  (void)hrtc_;
+  (void)WakeUpClock;
+  rtcWakePeriodUs = ((uint64_t)WakeUpCounter + 1U) * 1000000U / RTC_WAKEUP_HZ;
+  rtcWakeUs = Sim_NowUs + rtcWakePeriodUs;
+  Sim_RTC.CR |= RTC_CR_WUTE | RTC_CR_WUTIE;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTCEx_DeactivateWakeUpTimer(RTC_HandleTypeDef *hrtc_)
+{
+  (void)hrtc_;
+  rtcWakeUs = UINT64_MAX;
+  Sim_RTC.CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+  return HAL_OK;
+}
+
+void HAL_RTCEx_WakeUpTimerIRQHandler(RTC_HandleTypeDef *hrtc_)
+{
+  (void)hrtc_;
+  Sim_RTC.ISR &= ~RTC_ISR_WUTF;
+  Sim_EXTI.PR &= ~EXTI_PR_PR20;
+}
+
+uint8_t RTC_ByteToBcd2(uint8_t number)
+{
+  return (uint8_t)(((number / 10U) << 4) | (number % 10U));
+}
+
+uint8_t RTC_Bcd2ToByte(uint8_t number)
+{
+  return (uint8_t)(((number >> 4) * 10U) + (number & 0x0FU));
+}
+#endif /* !SIM_BOOT */
+
+/* GPIO ----------------------------------------------------------------------*/
+void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin)
+{
+  Sim_EXTI.PR &= ~(uint32_t)GPIO_Pin;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+  uint32_t pin;
+
+  for (pin = 0; pin < 16U; pin++)
+  {
+    if ((GPIO_Init->Pin & (1UL << pin)) != 0U)
+    {
+      GPIOx->MODER = (GPIOx->MODER & ~(3UL << (2U * pin))) | ((GPIO_Init->Mode & 3UL) << (2U * pin));
+    }
+  }
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+  uint32_t pin;
+
+  for (pin = 0; pin < 16U; pin++)
+  {
+    if ((GPIO_Pin & (1UL << pin)) != 0U)
+    {
+      GPIOx->MODER |= 3UL << (2U * pin);    /* analog, the reset state */
+    }
+  }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  return ((GPIOx->IDR & GPIO_Pin) != 0U) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+  if (PinState != GPIO_PIN_RESET)
+  {
+    GPIOx->ODR |= GPIO_Pin;
+  }
+  else
+  {
+    GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+  }
+  GPIOx->IDR = GPIOx->ODR;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  GPIOx->ODR ^= GPIO_Pin;
+  GPIOx->IDR = GPIOx->ODR;
+}
+
+#if !SIM_BOOT
+/* ADC -----------------------------------------------------------------------*/
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc)
+{
+  HAL_ADC_MspInit(hadc);
+  hadc->State = HAL_ADC_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig)
+{
+  (void)hadc;
+  (void)sConfig;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc, uint32_t SingleDiff)
+{
+  (void)hadc;
+  (void)SingleDiff;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start(ADC_HandleTypeDef *hadc)
+{
+  (void)hadc;
+  if (SimCrash_Due(SIM_CRASH_ERROR))
+  {
+    Error_Handler();
+  }
+  if (SimCrash_Due(SIM_CRASH_FAULT))
+  {
+    SimCrash_Fault((uint32_t)(uintptr_t)HAL_ADC_Start, (uint32_t)(uintptr_t)__builtin_return_address(0));
+  }
+  SimRam_Use();
+  adcLatched = Sim_AdcSample();
+  return HAL_OK;
+}
+
+/* Applies a firmware write to ADC1 ISR, if there was one, to the flags */
+static void adcSyncFlags(void)
+{
+  if ((Sim_ADC1.ISR & SIM_ADC_ISR_UNWRITTEN) == 0U)
+  {
+    adcFlags &= ~Sim_ADC1.ISR;
+  }
+  Sim_ADC1.ISR = adcFlags | SIM_ADC_ISR_UNWRITTEN;
+}
+
+/**
+  * @brief  ADC1 ISR flags, with the firmware's writes so far applied
+  * @retval ADC_ISR_x flags
+  */
+uint32_t Sim_AdcFlags(void)
+{
+  adcSyncFlags();
+  return adcFlags;
+}
+
+/* Analog watchdog 1: the conversion is outside TR1 on a watched channel */
+static int adcWatchdogFires(void)
+{
+  uint32_t cfgr = Sim_ADC1.CFGR;
+  uint32_t low = (Sim_ADC1.TR1 & ADC_TR1_LT1) >> ADC_TR1_LT1_Pos;
+  uint32_t high = (Sim_ADC1.TR1 & ADC_TR1_HT1) >> ADC_TR1_HT1_Pos;
+
+  if (((cfgr & ADC_CFGR_AWD1EN) == 0U) ||
+      (((cfgr & ADC_CFGR_AWD1SGL) != 0U) && (((cfgr & ADC_CFGR_AWD1CH) >> ADC_CFGR_AWD1CH_Pos) != SIM_ADC_CHANNEL)))
+  {
+    return 0;
+  }
+  return (adcLatched < low) || (adcLatched > high);
+}
+
+HAL_StatusTypeDef HAL_ADC_PollForConversion(ADC_HandleTypeDef *hadc, uint32_t Timeout)
+{
+  (void)hadc;
+  (void)Timeout;
+  if (SimWatchdog_Hang(SIM_HANG_ADC))
+  {
+    /* End of conversion never comes; interrupts still run */
+    for (;;)
+    {
+      waitForEvent();
+    }
+  }
+  if ((Sim_DWT.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0U)
+  {
+    Sim_DWT.CYCCNT += SIM_ADC_CYCLES;
+    cycleModel.modelledCycles += SIM_ADC_CYCLES;
+    cycleModel.conversions++;
+  }
+
+  /* End of conversion; the watchdog interrupt is taken before the poll
+   * returns, as interrupts are enabled around it */
+  Sim_ADC1.DR = adcLatched;
+  adcSyncFlags();
+  SimAlarm_Conversion(adcLatched);
+  SimFilter_Conversion(adcLatched);
+  if (adcWatchdogFires())
+  {
+    adcFlags |= ADC_ISR_AWD1;
+    Sim_ADC1.ISR = adcFlags | SIM_ADC_ISR_UNWRITTEN;
+    if ((Sim_ADC1.IER & ADC_IER_AWD1IE) != 0U)
+    {
+      Sim_RaiseIrq(ADC1_2_IRQn);
+      dispatchIrqs();
+    }
+    adcSyncFlags();
+  }
+  return HAL_OK;
+}
+
+uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef *hadc)
+{
+  (void)hadc;
+  return adcLatched;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop(ADC_HandleTypeDef *hadc)
+{
+  (void)hadc;
+  return HAL_OK;
+}
+#endif /* !SIM_BOOT */
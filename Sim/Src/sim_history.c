@@ -0,0 +1,408 @@
+/**
+  ******************************************************************************
+  * @file           : sim_history.c
+  * @brief          : Simulated display node fetching the temperature history
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * -H adds a node that sends HIST_GET every given number of seconds,
+  * alternating between the whole history and the last two periods, and
+  * retries after SIM_HISTORY_RETRY_US without a response (in Stop mode the
+  * frame that wakes the node is lost). Every T1 frame on the bus is kept as
+  * the reference: each decoded sample must match the T1 value sent at that
+  * time, and the newest one must be one of the last two T1 frames before
+  * the response (the response may overtake a T1 frame in the mailboxes).
+  * A failed check makes the run exit with status 1.
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "boot.h"
+#include "history.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_HISTORY_ADDRESS     0x81U
+#define SIM_HISTORY_AHEAD_US    100000U   /* request queued ahead of the bus */
+#define SIM_HISTORY_RETRY_US    50000U
+#define SIM_HISTORY_RETRIES     4U
+#define SIM_HISTORY_MAX_BYTES   (HISTORY_BLOCKS * HISTORY_BLOCK_SIZE)
+#define SIM_T1_PGN              130312UL
+
+/* Private variables ---------------------------------------------------------*/
+typedef struct
+{
+  uint64_t timeUs;        /* end of the T1 frame, node time (uwTick) */
+  uint16_t value;
+} Sim_T1Sample;
+
+static Sim_T1Sample *t1;
+static uint32_t t1Count;
+static uint32_t t1Size;
+
+static struct
+{
+  int waiting;            /* request sent, no response yet */
+  int receiving;          /* response seen, END or data outstanding */
+  int endSeen;
+  uint8_t endStatus;
+  uint16_t endCrc;
+  uint32_t retries;
+  uint32_t t1Before;      /* T1 frames seen before the response */
+  uint64_t sentUs;
+  uint32_t fromS;
+  uint32_t toS;
+  uint32_t bytes;
+  uint32_t frames;        /* data frames expected */
+  uint32_t received;      /* data frames received */
+  uint8_t seen[(SIM_HISTORY_MAX_BYTES / 7U) + 1U];
+  uint8_t data[SIM_HISTORY_MAX_BYTES + 7U];
+} req;
+
+static uint64_t nextRequestUs;
+static uint32_t requestCount;
+static uint32_t transfers;
+static uint32_t retriesTotal;
+static uint32_t unanswered;
+static uint32_t failures;
+static uint64_t samplesChecked;
+static uint64_t bytesTotal;
+static uint64_t transferUs;
+static uint64_t transferMaxUs;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  fprintf(stderr, "sim: history request %lu at %.3f s: %s\n", (unsigned long)requestCount,
+          (double)req.sentUs / 1e6, what);
+  failures++;
+}
+
+static void sendRequest(uint64_t readyUs)
+{
+  CAN_Frame get;
+
+  memset(&get, 0xFF, sizeof(get));
+  get.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, SIM_HISTORY_ADDRESS);
+  get.dlc = 8;
+  get.data[0] = HISTORY_CMD_GET;
+  get.data[1] = (uint8_t)req.fromS;
+  get.data[2] = (uint8_t)(req.fromS >> 8);
+  get.data[3] = (uint8_t)(req.fromS >> 16);
+  get.data[4] = (uint8_t)req.toS;
+  get.data[5] = (uint8_t)(req.toS >> 8);
+  get.data[6] = (uint8_t)(req.toS >> 16);
+  if (SimCan_Inject(&get, readyUs, SIM_CAN_ORIGIN_MODEL) == 0)
+  {
+    req.sentUs = readyUs;
+    req.waiting = 1;
+  }
+}
+
+/* T1 frame nearest to a sample time */
+static const Sim_T1Sample *t1Near(uint64_t timeUs)
+{
+  uint32_t lo = 0;
+  uint32_t hi = t1Count;
+
+  while (lo < hi)
+  {
+    uint32_t mid = (lo + hi) / 2U;
+
+    if (t1[mid].timeUs < timeUs)
+    {
+      lo = mid + 1U;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  if ((lo > 0U) && ((lo == t1Count) || ((timeUs - t1[lo - 1U].timeUs) < (t1[lo].timeUs - timeUs))))
+  {
+    lo--;
+  }
+  return (lo < t1Count) ? &t1[lo] : NULL;
+}
+
+/* Decodes the received blocks and compares them with the T1 frames */
+static void checkTransfer(void)
+{
+  static uint16_t values[0x10000];
+  uint32_t pos = 0;
+  const Sim_T1Sample *newest = NULL;
+
+  if (req.endStatus != HISTORY_OK)
+  {
+    fail((req.endStatus == HISTORY_ERR_OVERRUN) ? "overrun" : "bad END status");
+    return;
+  }
+  if (History_Crc16(0xFFFFU, req.data, req.bytes) != req.endCrc)
+  {
+    fail("CRC mismatch");
+    return;
+  }
+
+  while (pos < req.bytes)
+  {
+    History_Header header;
+    int32_t count;
+    int32_t i;
+
+    memcpy(&header, &req.data[pos], sizeof(header));
+    if (((pos + HISTORY_HEADER_SIZE + header.length) > req.bytes) ||
+        ((count = History_BlockDecode(&header, &req.data[pos + HISTORY_HEADER_SIZE], values, 0x10000U)) < 0))
+    {
+      fail("malformed block");
+      return;
+    }
+    /* Range requests: every block must overlap [from, to] */
+    if ((req.toS != HISTORY_TIME_NOW) &&
+        ((header.startMs > ((uint64_t)req.toS * 1000U + 999U)) ||
+         ((header.startMs + (uint32_t)(count - 1) * header.intervalMs) < (uint64_t)req.fromS * 1000U)))
+    {
+      fail("block outside the requested range");
+    }
+    for (i = 0; i < count; i++)
+    {
+      uint64_t sampleUs = ((uint64_t)header.startMs + (uint64_t)i * header.intervalMs) * 1000U;
+      const Sim_T1Sample *ref = t1Near(sampleUs);
+
+      /* The T1 frame ends shortly after the sample was taken */
+      if ((ref == NULL) || (ref->value != values[i]) || (ref->timeUs < sampleUs) ||
+          ((ref->timeUs - sampleUs) > 20000U + (header.intervalMs * 1000U / 8U)))
+      {
+        fail("sample does not match the T1 frames");
+        return;
+      }
+      newest = ref;
+      samplesChecked++;
+    }
+    pos += HISTORY_HEADER_SIZE + header.length;
+  }
+
+  if ((req.t1Before != 0U) && ((newest == NULL) || ((uint32_t)(newest - t1) + 2U < req.t1Before)))
+  {
+    fail("newest sample is older than the last T1 frames");
+  }
+  transfers++;
+  bytesTotal += req.bytes;
+}
+
+static void finishIfComplete(uint64_t timeUs)
+{
+  if (req.receiving && req.endSeen && (req.received == req.frames))
+  {
+    req.receiving = 0;
+    checkTransfer();
+    transferUs += timeUs - req.sentUs;
+    if ((timeUs - req.sentUs) > transferMaxUs)
+    {
+      transferMaxUs = timeUs - req.sentUs;
+    }
+  }
+}
+
+static void onNodeFrame(const CAN_Frame *frame, uint64_t timeUs)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  if (((id >> 8) & 0x3FFFFUL) == SIM_T1_PGN)
+  {
+    if (t1Count == t1Size)
+    {
+      t1Size = (t1Size == 0U) ? 4096U : (t1Size * 2U);
+      t1 = realloc(t1, t1Size * sizeof(*t1));
+      if (t1 == NULL)
+      {
+        perror("sim: history reference");
+        exit(2);
+      }
+    }
+    /* HAL ticks start after the clock set-up and follow the RTC across
+     * Stop mode, so convert to the node's time base */
+    t1[t1Count].timeUs = timeUs - (Sim_NowUs - ((uint64_t)uwTick * 1000U));
+    t1[t1Count].value = (uint16_t)(frame->data[3] | ((uint16_t)frame->data[4] << 8));
+    t1Count++;
+    return;
+  }
+  if (BOOT_ID_DA(id) != SIM_HISTORY_ADDRESS)
+  {
+    return;
+  }
+
+  if ((BOOT_ID_PGN(id) == BOOT_PGN_CMD) && (frame->data[0] == (HISTORY_CMD_GET | BOOT_RSP)) && req.waiting)
+  {
+    req.waiting = 0;
+    if (frame->data[1] != HISTORY_OK)
+    {
+      fail("HIST_GET refused");
+      return;
+    }
+    req.receiving = 1;
+    req.endSeen = 0;
+    req.t1Before = t1Count;
+    req.bytes = frame->data[3] | ((uint32_t)frame->data[4] << 8);
+    req.frames = (req.bytes + 6U) / 7U;
+    req.received = 0;
+    memset(req.seen, 0, sizeof(req.seen));
+    if (req.bytes > SIM_HISTORY_MAX_BYTES)
+    {
+      req.receiving = 0;
+      fail("more bytes than the ring holds");
+    }
+  }
+  else if ((BOOT_ID_PGN(id) == BOOT_PGN_CMD) && (frame->data[0] == (HISTORY_CMD_END | BOOT_RSP)) && req.receiving)
+  {
+    req.endSeen = 1;
+    req.endStatus = frame->data[1];
+    req.endCrc = (uint16_t)(frame->data[2] | ((uint16_t)frame->data[3] << 8));
+    if (req.endStatus != HISTORY_OK)
+    {
+      req.received = req.frames;
+    }
+    finishIfComplete(timeUs);
+  }
+  else if ((BOOT_ID_PGN(id) == BOOT_PGN_DATA) && req.receiving)
+  {
+    /* Frame number mod 256; frames are out of order within a burst only */
+    uint32_t n = (req.received & ~0xFFUL) | frame->data[0];
+
+    if (n + 128U < req.received)
+    {
+      n += 256U;
+    }
+    else if ((n > req.received + 128U) && (n >= 256U))
+    {
+      n -= 256U;
+    }
+    if ((n >= req.frames) || req.seen[n])
+    {
+      fail("unexpected data frame");
+      req.receiving = 0;
+      return;
+    }
+    req.seen[n] = 1;
+    memcpy(&req.data[n * 7U], &frame->data[1], 7);
+    req.received++;
+    finishIfComplete(timeUs);
+  }
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  (void)ctx;
+
+  if (origin == SIM_CAN_ORIGIN_NODE)
+  {
+    onNodeFrame(frame, timeUs);
+  }
+
+  if (req.waiting && (timeUs >= (req.sentUs + SIM_HISTORY_RETRY_US)))
+  {
+    if (req.retries++ < SIM_HISTORY_RETRIES)
+    {
+      retriesTotal++;
+      sendRequest(timeUs);
+    }
+    else
+    {
+      req.waiting = 0;
+      unanswered++;
+      fail("no response");
+    }
+  }
+
+  if ((Sim_Cfg.historyPeriodS > 0.0) && (nextRequestUs <= (timeUs + SIM_HISTORY_AHEAD_US)))
+  {
+    uint32_t nowS = (uint32_t)(nextRequestUs / 1000000U);
+    uint32_t spanS = (uint32_t)(2.0 * Sim_Cfg.historyPeriodS);
+
+    if (req.waiting || req.receiving)
+    {
+      unanswered++;
+      fail("previous transfer not finished");
+      req.waiting = 0;
+      req.receiving = 0;
+    }
+    requestCount++;
+    req.retries = 0;
+    req.fromS = ((requestCount & 1U) || (nowS < spanS)) ? 0U : (nowS - spanS);
+    req.toS = HISTORY_TIME_NOW;
+    sendRequest(nextRequestUs);
+    nextRequestUs += (uint64_t)(Sim_Cfg.historyPeriodS * 1e6);
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Starts the -H requester
+  * @retval None
+  */
+void SimHistory_Init(void)
+{
+  if (Sim_Cfg.historyPeriodS > 0.0)
+  {
+    nextRequestUs = (uint64_t)(Sim_Cfg.historyPeriodS * 1e6);
+    SimCan_AddTap(busTap, NULL);
+  }
+}
+
+/**
+  * @brief  Result of the history checks
+  * @retval 0, or 1 when a transfer did not match the T1 frames
+  */
+int SimHistory_Close(void)
+{
+  return (failures != 0U) ? 1 : 0;
+}
+
+/**
+  * @brief  Prints ring occupancy, compression and transfer statistics
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimHistory_Report(FILE *out, double seconds)
+{
+  uint32_t samples;
+  uint32_t spanMs;
+  uint32_t bytes = History_Used(&samples, &spanMs);
+
+  (void)seconds;
+  fprintf(out, "===== Temperature history =====\n");
+  fprintf(out, "  samples      %10lu appended, %lu held over %.2f h\n", (unsigned long)historyStats.samples,
+          (unsigned long)samples, (double)spanMs / 3.6e6);
+  fprintf(out, "  blocks       %10lu closed, %lu dropped, %lu after a gap\n", (unsigned long)historyStats.blocks,
+          (unsigned long)historyStats.dropped, (unsigned long)historyStats.gaps);
+  if (samples != 0U)
+  {
+    fprintf(out, "  compression  %10.2f bytes per sample (%lu bytes, raw 2 per sample)\n",
+            (double)bytes / (double)samples, (unsigned long)bytes);
+  }
+  if (Sim_Cfg.historyPeriodS > 0.0)
+  {
+    fprintf(out, "  requests     %10lu (%lu retries, %lu unanswered)\n", (unsigned long)requestCount,
+            (unsigned long)retriesTotal, (unsigned long)unanswered);
+    fprintf(out, "  transfers    %10lu checked, %llu samples, %llu bytes, %lu frames queued\n",
+            (unsigned long)transfers, (unsigned long long)samplesChecked, (unsigned long long)bytesTotal,
+            (unsigned long)historyStats.frames);
+    if (transfers != 0U)
+    {
+      fprintf(out, "  duration     %10.1f ms avg, %.1f ms max (request to last frame)\n",
+              (double)transferUs / 1e3 / (double)transfers, (double)transferMaxUs / 1e3);
+    }
+    fprintf(out, "  check        %s\n", (failures == 0U) ? "all samples match the T1 frames" : "FAILED");
+  }
+}
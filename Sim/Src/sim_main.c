@@ -0,0 +1,151 @@
+/**
+  ******************************************************************************
+  * @file           : sim_main.c
+  * @brief          : Host entry point: options, then the unmodified firmware
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Core/Src/main.c is compiled with -Dmain=Firmware_Main; it never returns,
+  * the run ends inside Sim_AdvanceTo() once the virtual duration is reached.
+  * The BOOT=1 build (bootloader_host) runs Boot/Src/bootloader.c instead.
+  *
+  * Usage: simplecan_host [-d seconds] [-t degC] [-r degC/min] [-n lsb]
+  *                       [-s seed] [-b bitrate] [-l file|-] [-i ifname]
+  *                       [-c canif] [-x scale] [-F file] [-P hz] [-k n] [-H s]
+  *                       [-R log] [-X speed] [-W kind@s] [-Y csr:bkp1]
+  *                       [-C kind@s] [-Z file] [-S stack[,heap]@s]
+  *                       [-G load[,burst[,flags]]@s]
+  *                       [-M s[,flags[,ids]]@s] [-E rate[,prio]@s]
+  *                       [-A high,low[,hyst]@s] [-T mode[,batch[,cutoff]]@s]
+  *                       [-w window@s] [-U file|bytes] [-q]
+  */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/personality.h>
+#include "sim.h"
+
+int Firmware_Main(void);
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-d seconds] [-t degC] [-r degC/min] [-n lsb] [-s seed]\n"
+          "          [-b bitrate] [-l file|-] [-i ifname] [-c canif] [-x scale]\n"
+          "          [-F file] [-P hz] [-k n] [-H seconds] [-R log] [-X speed]\n"
+          "          [-W kind@seconds] [-Y csr:bkp1] [-C kind@seconds] [-Z file]\n"
+          "          [-S stack[,heap]@seconds] [-G load[,burst[,flags]]@seconds]\n"
+          "          [-M seconds[,flags[,ids]]@seconds] [-E rate[,prio]@seconds]\n"
+          "          [-A high,low[,hyst]@seconds] [-T mode[,batch[,cutoff]]@seconds]\n"
+          "          [-w window@seconds] [-U file|bytes] [-q]\n"
+          "  -d  virtual run time, 0 runs until Ctrl-C or the end of -R (default 60)\n"
+          "  -t  die temperature at start (default 25)\n"
+          "  -r  temperature ramp (default 0)\n"
+          "  -n  peak ADC noise in LSB (default 0)\n"
+          "  -s  noise seed (default 1)\n"
+          "  -b  CAN bit rate, default from the bxCAN timing in can.c\n"
+          "  -l  write bus traffic as a candump -L log\n"
+          "  -i  interface name in the log (default vcan0)\n"
+          "  -c  attach to a SocketCAN interface (vcan0, can0, ...), implies -x 1\n"
+          "  -x  run at this multiple of real time instead of free-running\n"
+          "  -F  keep the parameter flash pages (BOOT=1: and the application) in this file\n"
+          "  -P  send PARAM_SET (temperature offset) at this rate in Hz\n"
+          "  -k  cut the power during the nth flash program/erase\n"
+          "  -H  request and check the temperature history this often\n"
+          "  -R  replay a candump log or pcap capture onto the bus\n"
+          "  -X  replay speed, 1 = original timing, 0 = back to back (default 1)\n"
+          "  -W  hang at this time until the watchdog resets: adc, rx, starve\n"
+          "  -Y  boot as after this reset: RCC_CSR:RTC_BKP1R, as printed after -W\n"
+          "  -C  crash at this time: fault (bus fault) or error (Error_Handler)\n"
+          "  -Z  keep the crash record in this file between runs\n"
+          "  -S  at this time use this many stack bytes and ask _sbrk() for heap bytes\n"
+          "  -G  at this time start the bus-stress generator and check its frames\n"
+          "  -M  at this time start a bus monitor window, send traffic and check the report\n"
+          "  -E  from this time ping the node at this rate in Hz and check the echoes\n"
+          "  -A  at this time set the alarm thresholds and hysteresis, degC\n"
+          "  -T  at this time set the temperature filter: mode, batch, IIR cutoff\n"
+          "  -w  at this time request the trend message, then set the trend window\n"
+          "  -U  bootloader build: upload this image, or a synthetic one of this size\n"
+          "  -q  no report at exit\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+  const char *logPath = NULL;
+  const char *ifName = "vcan0";
+  const char *canIf = NULL;
+  int opt;
+
+  /* Flash, SRAM and the bxCAN registers are mapped at their target
+   * addresses, which the randomized start of the heap can cover: run again
+   * without address randomization */
+  if ((personality(0xFFFFFFFFUL) & ADDR_NO_RANDOMIZE) == 0)
+  {
+    (void)personality((unsigned long)personality(0xFFFFFFFFUL) | ADDR_NO_RANDOMIZE);
+    execv("/proc/self/exe", argv);
+  }
+
+  while ((opt = getopt(argc, argv, "d:t:r:n:s:b:l:i:c:x:F:P:k:H:R:X:W:Y:C:Z:S:G:M:E:A:T:w:U:qh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'd': Sim_Cfg.durationUs = (uint64_t)(strtod(optarg, NULL) * 1e6); break;
+      case 't': Sim_Cfg.tempC = strtod(optarg, NULL); break;
+      case 'r': Sim_Cfg.rampCPerMin = strtod(optarg, NULL); break;
+      case 'n': Sim_Cfg.noiseLsb = strtod(optarg, NULL); break;
+      case 's': Sim_Cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'b': Sim_Cfg.bitrate = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'l': logPath = optarg; break;
+      case 'i': ifName = optarg; break;
+      case 'c': canIf = optarg; break;
+      case 'x': Sim_Cfg.timeScale = strtod(optarg, NULL); break;
+      case 'F': Sim_Cfg.flashPath = optarg; break;
+      case 'P': Sim_Cfg.paramRateHz = strtod(optarg, NULL); break;
+      case 'k': Sim_Cfg.powerCutOp = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'H': Sim_Cfg.historyPeriodS = strtod(optarg, NULL); break;
+      case 'R': Sim_Cfg.replayPath = optarg; break;
+      case 'X': Sim_Cfg.replaySpeed = strtod(optarg, NULL); break;
+      case 'W': Sim_Cfg.hangSpec = optarg; break;
+      case 'Y': Sim_Cfg.resetSpec = optarg; break;
+      case 'C': Sim_Cfg.crashSpec = optarg; break;
+      case 'Z': Sim_Cfg.crashPath = optarg; break;
+      case 'S': Sim_Cfg.ramSpec = optarg; break;
+      case 'G': Sim_Cfg.stressSpec = optarg; break;
+      case 'M': Sim_Cfg.monitorSpec = optarg; break;
+      case 'E': Sim_Cfg.pingSpec = optarg; break;
+      case 'A': Sim_Cfg.alarmSpec = optarg; break;
+      case 'T': Sim_Cfg.filterSpec = optarg; break;
+      case 'w': Sim_Cfg.trendSpec = optarg; break;
+      case 'U': Sim_Cfg.uploadPath = optarg; break;
+      case 'q': Sim_Cfg.quiet = 1; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+
+  if (logPath != NULL)
+  {
+    SimLog_Open(logPath, ifName);
+  }
+  if (canIf != NULL)
+  {
+    SimSocketCan_Open(canIf);
+    if (Sim_Cfg.timeScale <= 0.0)
+    {
+      Sim_Cfg.timeScale = 1.0;
+    }
+  }
+  Sim_Start();
+
+  return Firmware_Main();
+}
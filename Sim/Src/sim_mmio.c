@@ -0,0 +1,282 @@
+/**
+  ******************************************************************************
+  * @file           : sim_mmio.c
+  * @brief          : Register blocks whose writes have side effects
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Most simulated registers are plain memory, which is enough when the
+  * model only looks at them when time moves. Drivers that expect the
+  * hardware to answer a write at once (a transmit request that takes the
+  * mailbox, a FIFO release the code then waits for) need the model to run
+  * between two instructions.
+  *
+  * A block registered here is mapped at its real address, as sim_flash.c
+  * and sim_crash.c map flash and SRAM, but read-only, with a second
+  * writable view of the same pages for the model. Reads go straight to
+  * memory, so the model keeps the registers current. A write faults, and
+  * the handler passes the word offset, the value written and the value
+  * before to the model, which stores what the register really takes.
+  *
+  * The plain MOV stores the compiler emits for register writes are decoded
+  * and done on the model's view in the handler. Any other instruction runs
+  * on the firmware's view made writable for one single step (trap flag),
+  * which costs two more system calls.
+  *
+  * The model runs inside the signal handlers: it may raise interrupts and
+  * change its own state, but must not call into the firmware.
+  */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "sim.h"
+
+#if !defined(__x86_64__)
+#error "sim_mmio.c single-steps register writes with the x86-64 trap flag"
+#endif
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_MMIO_BLOCKS       4U
+#define SIM_MMIO_EFL_TF       0x100UL     /* EFLAGS trap flag */
+#define SIM_MMIO_ERR_WRITE    0x2UL       /* page fault error code: write access */
+
+/* x86-64 register numbers (ModRM reg + REX.R) in the signal context */
+static const int gregIndex[16] =
+{
+  REG_RAX, REG_RCX, REG_RDX, REG_RBX, REG_RSP, REG_RBP, REG_RSI, REG_RDI,
+  REG_R8,  REG_R9,  REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15
+};
+
+/* Private variables ---------------------------------------------------------*/
+static struct
+{
+  uintptr_t base;                 /* first register */
+  uintptr_t pages;                /* firmware view, page aligned */
+  size_t length;
+  uint8_t *model;                 /* writable view of the same pages */
+  SimMmio_WriteFn onWrite;
+} blocks[SIM_MMIO_BLOCKS];
+static uint32_t blockCount;
+
+/* The store being single-stepped */
+static int stepBlock = -1;
+static uint32_t stepOffset;
+static uint32_t stepOld;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Decodes MOV r/m8, r8 (88), MOV r/m, r (89), MOV r/m8, imm8 (C6 /0) and
+ * MOV r/m, imm (C7 /0) with the operand size prefix and REX; returns the
+ * instruction length, or 0 for anything else */
+static uint32_t decodeStore(const uint8_t *code, const greg_t *gregs, uint64_t *value, uint32_t *width)
+{
+  const uint8_t *p = code;
+  uint32_t rex = 0;
+  uint32_t wide = 4U;
+  uint32_t op;
+  uint32_t mod;
+  uint32_t reg;
+  uint32_t rm;
+
+  if (*p == 0x66U)
+  {
+    wide = 2U;
+    p++;
+  }
+  if ((*p & 0xF0U) == 0x40U)
+  {
+    rex = *p++;
+    wide = ((rex & 0x08U) != 0U) ? 8U : wide;
+  }
+  op = *p++;
+  mod = *p >> 6;
+  reg = (*p >> 3) & 7U;
+  rm = *p & 7U;
+  p++;
+  if ((mod == 3U) || ((op != 0x88U) && (op != 0x89U) && (op != 0xC6U) && (op != 0xC7U)) ||
+      (((op == 0xC6U) || (op == 0xC7U)) && (reg != 0U)))
+  {
+    return 0;
+  }
+  if (rm == 4U)
+  {
+    rm = *p++ & 7U;           /* SIB: base 5 with mod 0 takes a disp32 */
+  }
+  p += (mod == 1U) ? 1U : (((mod == 2U) || (rm == 5U && mod == 0U)) ? 4U : 0U);
+
+  *width = ((op == 0x88U) || (op == 0xC6U)) ? 1U : wide;
+  if (op == 0x89U)
+  {
+    *value = (uint64_t)gregs[gregIndex[reg | (((rex & 0x04U) != 0U) ? 8U : 0U)]];
+  }
+  else if (op == 0x88U)
+  {
+    /* Without REX, 4-7 are AH, CH, DH, BH */
+    reg |= ((rex & 0x04U) != 0U) ? 8U : 0U;
+    *value = ((rex == 0U) && (reg >= 4U)) ? ((uint64_t)gregs[gregIndex[reg - 4U]] >> 8)
+                                           : (uint64_t)gregs[gregIndex[reg]];
+  }
+  else
+  {
+    uint32_t imm = (*width == 1U) ? 1U : ((*width == 2U) ? 2U : 4U);
+
+    *value = 0;
+    memcpy(value, p, imm);
+    if ((imm == 4U) && (*width == 8U) && ((*value & 0x80000000ULL) != 0U))
+    {
+      *value |= 0xFFFFFFFF00000000ULL;    /* imm32 sign-extended */
+    }
+    p += imm;
+  }
+  return (uint32_t)(p - code);
+}
+
+static void onFault(int sig, siginfo_t *info, void *context)
+{
+  ucontext_t *uc = (ucontext_t *)context;
+  uintptr_t addr = (uintptr_t)info->si_addr;
+  uint8_t *word;
+  uint64_t stored;
+  uint32_t offset;
+  uint32_t old;
+  uint32_t length;
+  uint32_t width;
+  uint32_t i;
+
+  for (i = 0; i < blockCount; i++)
+  {
+    if ((addr >= blocks[i].pages) && (addr < (blocks[i].pages + blocks[i].length)) &&
+        ((uc->uc_mcontext.gregs[REG_ERR] & SIM_MMIO_ERR_WRITE) != 0))
+    {
+      break;
+    }
+  }
+  if ((i == blockCount) || (stepBlock >= 0))
+  {
+    /* Not a register write: fault again with the default action */
+    signal(sig, SIG_DFL);
+    return;
+  }
+
+  offset = (uint32_t)((addr & ~(uintptr_t)3U) - blocks[i].base);
+  word = blocks[i].model + ((addr & ~(uintptr_t)3U) - blocks[i].pages);
+  memcpy(&old, word, sizeof(old));
+
+  length = decodeStore((const uint8_t *)uc->uc_mcontext.gregs[REG_RIP], uc->uc_mcontext.gregs, &stored, &width);
+  if ((length != 0U) && ((addr & 3U) + width <= 4U))
+  {
+    uint32_t value;
+
+    memcpy(blocks[i].model + (addr - blocks[i].pages), &stored, width);
+    memcpy(&value, word, sizeof(value));
+    uc->uc_mcontext.gregs[REG_RIP] += length;
+    blocks[i].onWrite(offset, value, old);
+    return;
+  }
+
+  stepBlock = (int)i;
+  stepOffset = offset;
+  stepOld = old;
+  mprotect((void *)blocks[i].pages, blocks[i].length, PROT_READ | PROT_WRITE);
+  uc->uc_mcontext.gregs[REG_EFL] |= SIM_MMIO_EFL_TF;
+}
+
+static void onStep(int sig, siginfo_t *info, void *context)
+{
+  ucontext_t *uc = (ucontext_t *)context;
+  uint32_t value;
+  int i = stepBlock;
+
+  (void)info;
+  if (i < 0)
+  {
+    signal(sig, SIG_DFL);
+    return;
+  }
+  uc->uc_mcontext.gregs[REG_EFL] &= ~(greg_t)SIM_MMIO_EFL_TF;
+  mprotect((void *)blocks[i].pages, blocks[i].length, PROT_READ);
+  stepBlock = -1;
+
+  memcpy(&value, blocks[i].model + (blocks[i].base - blocks[i].pages) + stepOffset, sizeof(value));
+  blocks[i].onWrite(stepOffset, value, stepOld);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Maps a register block at its real address, read-only for the
+  *         firmware, and routes every write through the model
+  * @param  base: address of the first register
+  * @param  size: size of the block in bytes
+  * @param  onWrite: called after each firmware write with the word offset
+  *         from base, the value written and the value before; it stores
+  *         the value the register takes through the returned view
+  * @retval writable view of the block for the model
+  */
+void *SimMmio_Map(uintptr_t base, size_t size, SimMmio_WriteFn onWrite)
+{
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  uintptr_t pages = base & ~(uintptr_t)(page - 1U);
+  size_t length = (((base + size) - pages) + page - 1U) & ~(page - 1U);
+  struct sigaction sa;
+  void *view;
+  int fd;
+
+  if (blockCount == SIM_MMIO_BLOCKS)
+  {
+    fprintf(stderr, "sim: too many register blocks\n");
+    exit(2);
+  }
+  fd = memfd_create("sim-mmio", MFD_CLOEXEC);
+  if ((fd < 0) || (ftruncate(fd, (off_t)length) != 0))
+  {
+    perror("sim: register block");
+    exit(2);
+  }
+  view = mmap((void *)pages, length, PROT_READ, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+  if ((view == MAP_FAILED) || (view != (void *)pages))
+  {
+    fprintf(stderr, "sim: cannot map the registers at 0x%08lX: %s\n", (unsigned long)base, strerror(errno));
+    exit(2);
+  }
+  view = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (view == MAP_FAILED)
+  {
+    perror("sim: register block");
+    exit(2);
+  }
+  close(fd);
+
+  if (blockCount == 0U)
+  {
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_SIGINFO;
+    sa.sa_sigaction = onFault;
+    sigaction(SIGSEGV, &sa, NULL);
+    sa.sa_sigaction = onStep;
+    sigaction(SIGTRAP, &sa, NULL);
+  }
+  blocks[blockCount].base = base;
+  blocks[blockCount].pages = pages;
+  blocks[blockCount].length = length;
+  blocks[blockCount].model = (uint8_t *)view;
+  blocks[blockCount].onWrite = onWrite;
+  blockCount++;
+
+  return (uint8_t *)view + (base - pages);
+}
@@ -0,0 +1,629 @@
+/**
+  ******************************************************************************
+  * @file           : sim_monitor.c
+  * @brief          : Bus monitor traffic and report check
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * -M seconds[,flags[,extra]]@at adds a node that sends MONITOR_START with
+  * those MONITOR_START flags at that time and, once it is answered, a dozen
+  * periodic identifiers (standard, extended, remote, DLC 0 to 8, 2 ms to
+  * 1 s) plus extra extended ones at 10 Hz, from SIM_MONITOR_SETTLE_US after
+  * the start to as long before the end of the window. Every
+  * SIM_MONITOR_ERROR_EVERY frames a bus error is raised, the error codes in
+  * turn. A window of 0 seconds gets MONITOR_GET after SIM_MONITOR_OPEN_US of
+  * traffic, then MONITOR_STOP; otherwise the node sends the report itself.
+  *
+  * The first report is checked against what the bus carried from the node
+  * model: CRC, frame and identifier counts, and for every talker the count,
+  * the DLCs and the gaps (within SIM_MONITOR_GAP_TOL, the RX interrupt times
+  * frames a little after their end), most frames first. Errors must match
+  * those raised and, with MONITOR_SILENT, the node must send nothing from
+  * SIM_MONITOR_SETTLE_US after the start until the report. With
+  * MONITOR_REPEAT a second report must follow. The identifiers fill part of
+  * MONITOR_SLOTS; with enough extra ones the table overflows, and then only
+  * the totals and the talkers reported are checked. A failed check makes the
+  * run exit with status 1.
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "boot.h"
+#include "history.h"
+#include "monitor.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_MONITOR_ADDRESS     0x84U
+#define SIM_MONITOR_SETTLE_US   20000U    /* traffic starts after START, ends before the window */
+#define SIM_MONITOR_OPEN_US     2000000U  /* traffic of a window without an end */
+#define SIM_MONITOR_WINDOW_TOL  50U       /* ms, service task latency */
+#define SIM_MONITOR_GAP_TOL     2U        /* us */
+#define SIM_MONITOR_ERROR_EVERY 97U
+#define SIM_MONITOR_EXTRA_MAX   1000U
+#define SIM_MONITOR_EXTRA_FIRST (CAN_FRAME_EXT | 0x18FF0000UL)
+#define SIM_MONITOR_EXTRA_US    100000U
+#define SIM_MONITOR_MAX_IDS     (16U + SIM_MONITOR_EXTRA_MAX)
+#define SIM_MONITOR_FRAMES      ((MONITOR_REPORT_MAX + 6U) / 7U)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t id;
+  uint32_t periodUs;
+  uint8_t dlcMin;
+  uint8_t dlcMax;
+} Source;
+
+typedef struct
+{
+  uint32_t id;
+  uint32_t count;
+  uint64_t lastUs;
+  uint32_t minGapUs;
+  uint32_t maxGapUs;
+  uint16_t dlcMask;
+} Seen;
+
+/* Private variables ---------------------------------------------------------*/
+static const Source baseSources[] =
+{
+  { 0x300U,                                        2000U, 8U, 8U },
+  { 0x050U,                                        5000U, 6U, 8U },
+  { CAN_FRAME_EXT | 0x0CF00400UL,                 10000U, 8U, 8U },
+  { 0x100U,                                       10000U, 8U, 8U },
+  { 0x101U,                                       10000U, 8U, 8U },
+  { 0x200U,                                       20000U, 4U, 4U },
+  { CAN_FRAME_EXT | 0x00000001UL,                 25000U, 3U, 3U },
+  { CAN_FRAME_RTR | 0x123U,                       50000U, 2U, 2U },
+  { CAN_FRAME_EXT | 0x18FEF100UL,                100000U, 8U, 8U },
+  { 0x7FFU,                                      100000U, 0U, 0U },
+  { CAN_FRAME_EXT | CAN_FRAME_ID_MASK,           200000U, 1U, 1U },
+  { CAN_FRAME_EXT | CAN_FRAME_RTR | 0x18EAFF00UL, 1000000U, 0U, 3U },
+};
+
+static uint32_t windowS;                  /* -M window length, 0 = open */
+static uint32_t flags;
+static uint32_t extra;
+static uint64_t startAtUs;
+
+static Source sources[SIM_MONITOR_MAX_IDS];
+static uint64_t nextUs[SIM_MONITOR_MAX_IDS];
+static uint8_t nextDlc[SIM_MONITOR_MAX_IDS];
+static uint32_t sourceCount;
+static uint64_t trafficEndUs;
+static int pending;                       /* a traffic frame is queued */
+static int observing;                     /* model frames count as in the window */
+static int getSent;
+static int stopSent;
+
+static Seen seen[SIM_MONITOR_MAX_IDS];
+static uint32_t seenCount;
+static uint32_t frames;
+static uint32_t errors[MONITOR_ERRORS];
+static uint32_t errorTotal;
+
+static int started;
+static uint64_t startedUs;
+static uint64_t closedUs;                 /* last frame of the window */
+static uint32_t refused;
+static uint32_t reports;
+static uint8_t response[8];
+static uint8_t data[SIM_MONITOR_FRAMES * 7U];
+static uint8_t received[SIM_MONITOR_FRAMES];
+static uint32_t receivedCount;
+static uint32_t nodeFramesSilent;         /* node frames while it should be silent */
+
+static Monitor_Header header;
+static Monitor_Talker talkers[MONITOR_TOP_MAX];
+static int reportValid;
+
+static uint32_t failures;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  fprintf(stderr, "sim: monitor: %s\n", what);
+  failures++;
+}
+
+static void inject(const CAN_Frame *frame, uint64_t readyUs)
+{
+  if (SimCan_Inject(frame, readyUs, SIM_CAN_ORIGIN_MODEL) != 0)
+  {
+    fprintf(stderr, "sim: monitor: frame not queued\n");
+    exit(2);
+  }
+}
+
+static void sendCommand(uint8_t command, uint64_t readyUs)
+{
+  CAN_Frame frame;
+
+  memset(&frame, 0xFF, sizeof(frame));
+  frame.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, SIM_MONITOR_ADDRESS);
+  frame.dlc = 8;
+  frame.data[0] = command;
+  if (command == MONITOR_CMD_START)
+  {
+    frame.data[1] = (uint8_t)flags;
+    frame.data[2] = (uint8_t)windowS;
+    frame.data[3] = (uint8_t)(windowS >> 8);
+    frame.data[4] = MONITOR_TOP_MAX;
+  }
+  else if (command == MONITOR_CMD_GET)
+  {
+    frame.data[1] = MONITOR_TOP_MAX;
+  }
+  inject(&frame, readyUs);
+}
+
+/* Queues the next traffic frame, or the end of the window */
+static void injectNext(void)
+{
+  CAN_Frame frame;
+  uint32_t best = 0;
+  uint32_t i;
+
+  for (i = 1; i < sourceCount; i++)
+  {
+    if (nextUs[i] < nextUs[best])
+    {
+      best = i;
+    }
+  }
+  if (nextUs[best] > trafficEndUs)
+  {
+    if (windowS == 0U)
+    {
+      sendCommand(MONITOR_CMD_GET, Sim_NowUs);
+      getSent = 1;
+    }
+    return;
+  }
+
+  memset(&frame, 0, sizeof(frame));
+  frame.id = sources[best].id;
+  frame.dlc = nextDlc[best];
+  for (i = 0; i < frame.dlc; i++)
+  {
+    frame.data[i] = (uint8_t)(frames + i);
+  }
+  inject(&frame, nextUs[best]);
+  pending = 1;
+
+  nextUs[best] += sources[best].periodUs;
+  nextDlc[best] = (nextDlc[best] < sources[best].dlcMax) ? (uint8_t)(nextDlc[best] + 1U) : sources[best].dlcMin;
+}
+
+static void startTraffic(uint64_t timeUs)
+{
+  uint32_t i;
+
+  started = 1;
+  startedUs = timeUs;
+  observing = 1;
+  trafficEndUs = (windowS != 0U) ? (timeUs + (uint64_t)windowS * 1000000ULL - SIM_MONITOR_SETTLE_US)
+                                  : (timeUs + SIM_MONITOR_SETTLE_US + SIM_MONITOR_OPEN_US);
+  for (i = 0; i < sourceCount; i++)
+  {
+    nextUs[i] = timeUs + SIM_MONITOR_SETTLE_US + ((uint64_t)i * 1009U) % sources[i].periodUs;
+    nextDlc[i] = sources[i].dlcMin;
+  }
+  injectNext();
+}
+
+/* What a receiver counting every frame of the window would have */
+static void observe(const CAN_Frame *frame, uint64_t timeUs)
+{
+  Seen *s;
+  uint32_t i;
+
+  for (i = 0; (i < seenCount) && (seen[i].id != frame->id); i++)
+  {
+  }
+  if (i == SIM_MONITOR_MAX_IDS)
+  {
+    return;
+  }
+  s = &seen[i];
+  if (i == seenCount)
+  {
+    seenCount++;
+    s->id = frame->id;
+    s->minGapUs = UINT32_MAX;
+  }
+  else
+  {
+    uint32_t gap = (uint32_t)(timeUs - s->lastUs);
+
+    s->minGapUs = (gap < s->minGapUs) ? gap : s->minGapUs;
+    s->maxGapUs = (gap > s->maxGapUs) ? gap : s->maxGapUs;
+  }
+  s->count++;
+  s->lastUs = timeUs;
+  s->dlcMask |= (uint16_t)(1U << frame->dlc);
+  frames++;
+  closedUs = timeUs;
+}
+
+static void onNodeFrame(const CAN_Frame *frame, uint64_t timeUs)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  int toUs = ((frame->id & CAN_FRAME_EXT) != 0U) && (BOOT_ID_DA(id) == SIM_MONITOR_ADDRESS);
+
+  if (toUs && (BOOT_ID_PGN(id) == BOOT_PGN_CMD) && ((frame->data[0] & BOOT_RSP) != 0U))
+  {
+    uint8_t command = frame->data[0] & (uint8_t)~BOOT_RSP;
+
+    if (frame->data[1] != BOOT_OK)
+    {
+      refused++;
+    }
+    else if ((command == MONITOR_CMD_START) && !started)
+    {
+      startTraffic(timeUs);
+    }
+    else if (command == MONITOR_CMD_GET)
+    {
+      if (reports++ == 0U)
+      {
+        memcpy(response, frame->data, sizeof(response));
+      }
+      if (getSent && !stopSent)
+      {
+        sendCommand(MONITOR_CMD_STOP, timeUs);
+        stopSent = 1;
+      }
+    }
+    return;
+  }
+  if (toUs && (BOOT_ID_PGN(id) == BOOT_PGN_DATA))
+  {
+    uint32_t n = frame->data[0];
+
+    if ((reports == 1U) && (n < SIM_MONITOR_FRAMES) && !received[n])
+    {
+      memcpy(&data[n * 7U], &frame->data[1], 7);
+      received[n] = 1;
+      receivedCount++;
+    }
+    return;
+  }
+  if (started && (reports == 0U) && ((flags & MONITOR_SILENT) != 0U) &&
+      (timeUs > startedUs + SIM_MONITOR_SETTLE_US))
+  {
+    nodeFramesSilent++;
+  }
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  (void)ctx;
+
+  if (origin == SIM_CAN_ORIGIN_NODE)
+  {
+    onNodeFrame(frame, timeUs);
+    return;
+  }
+  if ((origin != SIM_CAN_ORIGIN_MODEL) || !observing)
+  {
+    return;
+  }
+  if (((frame->id & CAN_FRAME_EXT) != 0U) && (BOOT_ID_SA(frame->id & CAN_FRAME_ID_MASK) == SIM_MONITOR_ADDRESS) &&
+      (BOOT_ID_PGN(frame->id & CAN_FRAME_ID_MASK) == BOOT_PGN_CMD))
+  {
+    /* MONITOR_GET is counted before it is served, MONITOR_STOP is not */
+    if (frame->data[0] == MONITOR_CMD_GET)
+    {
+      observe(frame, timeUs);
+      observing = 0;
+    }
+    return;
+  }
+  observe(frame, timeUs);
+  if (pending)
+  {
+    pending = 0;
+    if ((frames % SIM_MONITOR_ERROR_EVERY) == 0U)
+    {
+      uint32_t lec = errorTotal % MONITOR_ERRORS;
+
+      errors[lec]++;
+      errorTotal++;
+      SimCan_InjectError(lec + 1U);
+    }
+    injectNext();
+  }
+}
+
+static const Seen *findSeen(uint32_t id)
+{
+  uint32_t i;
+
+  for (i = 0; i < seenCount; i++)
+  {
+    if (seen[i].id == id)
+    {
+      return &seen[i];
+    }
+  }
+  return NULL;
+}
+
+/* 1 if a goes before b in a report */
+static int before(const Seen *a, const Seen *b)
+{
+  return (a->count > b->count) || ((a->count == b->count) && (a->id < b->id));
+}
+
+static void decodeReport(void)
+{
+  uint32_t bytes = response[3] | ((uint32_t)response[4] << 8);
+  uint16_t crc = (uint16_t)(response[5] | ((uint16_t)response[6] << 8));
+
+  if ((bytes < sizeof(header)) || (bytes > MONITOR_REPORT_MAX) || (receivedCount < (bytes + 6U) / 7U))
+  {
+    fail("report incomplete");
+    return;
+  }
+  if (History_Crc16(0xFFFFU, data, bytes) != crc)
+  {
+    fail("report CRC mismatch");
+    return;
+  }
+  memcpy(&header, data, sizeof(header));
+  if ((header.talkers != response[2]) || (header.talkers > MONITOR_TOP_MAX) ||
+      (bytes != sizeof(header) + header.talkers * sizeof(Monitor_Talker)))
+  {
+    fail("report length does not match its talkers");
+    return;
+  }
+  memcpy(talkers, &data[sizeof(header)], header.talkers * sizeof(Monitor_Talker));
+  reportValid = 1;
+}
+
+static void checkTalkers(void)
+{
+  uint8_t used[SIM_MONITOR_MAX_IDS] = { 0 };
+  uint32_t k;
+
+  for (k = 0; k < header.talkers; k++)
+  {
+    const Monitor_Talker *t = &talkers[k];
+    const Seen *s = findSeen(t->id);
+
+    if (s == NULL)
+    {
+      fprintf(stderr, "sim: monitor: talker 0x%lX was not on the bus\n", (unsigned long)t->id);
+      failures++;
+      continue;
+    }
+    if ((t->count != s->count) || (t->dlcMask != s->dlcMask) ||
+        ((s->count == 1U) ? ((t->minGapUs != UINT32_MAX) || (t->maxGapUs != 0U)) :
+         ((t->minGapUs + SIM_MONITOR_GAP_TOL < s->minGapUs) || (t->minGapUs > s->minGapUs + SIM_MONITOR_GAP_TOL) ||
+          (t->maxGapUs + SIM_MONITOR_GAP_TOL < s->maxGapUs) || (t->maxGapUs > s->maxGapUs + SIM_MONITOR_GAP_TOL))))
+    {
+      fprintf(stderr, "sim: monitor: talker 0x%lX: %lu frames, gaps %lu..%lu us, DLCs 0x%X; bus: %lu, %lu..%lu, 0x%X\n",
+              (unsigned long)t->id, (unsigned long)t->count, (unsigned long)t->minGapUs,
+              (unsigned long)t->maxGapUs, t->dlcMask, (unsigned long)s->count, (unsigned long)s->minGapUs,
+              (unsigned long)s->maxGapUs, s->dlcMask);
+      failures++;
+    }
+    if ((k != 0U) && (t->count > talkers[k - 1U].count))
+    {
+      fail("talkers not in order");
+    }
+    used[s - seen] = 1;
+  }
+
+  /* Without overflow the talkers are the busiest identifiers of all */
+  if (header.overflow == 0U)
+  {
+    for (k = 0; k < seenCount; k++)
+    {
+      if (!used[k] && (header.talkers != 0U) && before(&seen[k], findSeen(talkers[header.talkers - 1U].id)))
+      {
+        fprintf(stderr, "sim: monitor: 0x%lX missing from the talkers\n", (unsigned long)seen[k].id);
+        failures++;
+      }
+    }
+    if ((header.talkers != ((seenCount < MONITOR_TOP_MAX) ? seenCount : MONITOR_TOP_MAX)) ||
+        (header.ids != seenCount))
+    {
+      fail("identifier count differs from the bus");
+    }
+  }
+  else if (header.ids >= seenCount)
+  {
+    fail("overflow reported with every identifier held");
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Parses -M and queues MONITOR_START; call after Sim_Cfg is set
+  * @retval None
+  */
+void SimMonitor_Init(void)
+{
+  const char *at;
+  char *end;
+  uint32_t i;
+
+  if (Sim_Cfg.monitorSpec == NULL)
+  {
+    return;
+  }
+  at = strchr(Sim_Cfg.monitorSpec, '@');
+  windowS = (uint32_t)strtoul(Sim_Cfg.monitorSpec, &end, 0);
+  if (*end == ',')
+  {
+    flags = (uint32_t)strtoul(end + 1, &end, 0);
+  }
+  if (*end == ',')
+  {
+    extra = (uint32_t)strtoul(end + 1, &end, 0);
+  }
+  if ((windowS > 3600U) || ((flags & ~(uint32_t)(MONITOR_SILENT | MONITOR_REPEAT)) != 0U) ||
+      (((flags & MONITOR_REPEAT) != 0U) && (windowS == 0U)) || (extra > SIM_MONITOR_EXTRA_MAX) ||
+      ((*end != '@') && (*end != '\0')))
+  {
+    fprintf(stderr, "sim: -M %s: seconds 0..3600, MONITOR_START flags, extra ids 0..%u\n",
+            Sim_Cfg.monitorSpec, SIM_MONITOR_EXTRA_MAX);
+    exit(2);
+  }
+  startAtUs = (at != NULL) ? (uint64_t)(strtod(at + 1, NULL) * 1e6) : 0U;
+  if ((Sim_Cfg.durationUs != 0U) &&
+      (Sim_Cfg.durationUs < startAtUs + ((windowS != 0U) ? (uint64_t)windowS * 1000000ULL : SIM_MONITOR_OPEN_US) +
+                            500000U))
+  {
+    fprintf(stderr, "sim: -M %s: the window does not end before the run\n", Sim_Cfg.monitorSpec);
+    exit(2);
+  }
+
+  memcpy(sources, baseSources, sizeof(baseSources));
+  sourceCount = sizeof(baseSources) / sizeof(baseSources[0]);
+  for (i = 0; i < extra; i++)
+  {
+    sources[sourceCount].id = SIM_MONITOR_EXTRA_FIRST + i;
+    sources[sourceCount].periodUs = SIM_MONITOR_EXTRA_US;
+    sources[sourceCount].dlcMin = 8U;
+    sources[sourceCount].dlcMax = 8U;
+    sourceCount++;
+  }
+
+  sendCommand(MONITOR_CMD_START, startAtUs);
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Checks the first report against the traffic sent
+  * @retval 1 if a check failed
+  */
+int SimMonitor_Close(void)
+{
+  uint32_t windowMs;
+  uint32_t i;
+
+  if (Sim_Cfg.monitorSpec == NULL)
+  {
+    return 0;
+  }
+  if (!started || (refused != 0U))
+  {
+    fail("MONITOR_START refused or not answered");
+    return 1;
+  }
+  if (reports == 0U)
+  {
+    fail("no report");
+    return 1;
+  }
+  decodeReport();
+  if (!reportValid)
+  {
+    return 1;
+  }
+
+  if (header.frames != frames)
+  {
+    fail("frame count differs from the bus");
+  }
+  checkTalkers();
+  for (i = 0; i < MONITOR_ERRORS; i++)
+  {
+    if (header.errors[i] != errors[i])
+    {
+      fail("error counts differ from the errors raised");
+      break;
+    }
+  }
+  if (header.recPeak != ((errorTotal < 255U) ? errorTotal : 255U))
+  {
+    fail("receive error counter peak off");
+  }
+
+  windowMs = (uint32_t)(((windowS != 0U) ? (uint64_t)windowS * 1000000ULL : (closedUs - startedUs)) / 1000U);
+  if ((header.windowMs + SIM_MONITOR_WINDOW_TOL < windowMs) || (header.windowMs > windowMs + SIM_MONITOR_WINDOW_TOL))
+  {
+    fail("window length off");
+  }
+  if ((header.flags & (uint8_t)~MONITOR_RUNNING) != flags)
+  {
+    fail("flags differ from MONITOR_START");
+  }
+  if (((header.flags & MONITOR_RUNNING) != 0U) != ((windowS == 0U) && ((flags & MONITOR_SILENT) == 0U)))
+  {
+    fail("running flag wrong");
+  }
+  if ((flags & MONITOR_SILENT) != 0U)
+  {
+    if (nodeFramesSilent != 0U)
+    {
+      fail("node sent frames in silent mode");
+    }
+    if (canStats.txSilenced == 0U)
+    {
+      fail("no frames discarded in silent mode");
+    }
+  }
+  if (((flags & MONITOR_REPEAT) != 0U) && (Sim_Cfg.durationUs != 0U) &&
+      (Sim_Cfg.durationUs > startAtUs + (uint64_t)windowS * 2000000ULL + 500000U) && (reports < 2U))
+  {
+    fail("no report of the next window");
+  }
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints the first report beside the traffic sent
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimMonitor_Report(FILE *out, double seconds)
+{
+  uint32_t k;
+
+  (void)seconds;
+  if (Sim_Cfg.monitorSpec == NULL)
+  {
+    return;
+  }
+  fprintf(out, "===== Bus monitor =====\n");
+  fprintf(out, "  window       %10lu s, flags 0x%02lX, %lu identifiers (%lu extra)\n", (unsigned long)windowS,
+          (unsigned long)flags, (unsigned long)sourceCount, (unsigned long)extra);
+  fprintf(out, "  bus          %10lu frames, %lu identifiers, %lu errors raised\n", (unsigned long)frames,
+          (unsigned long)seenCount, (unsigned long)errorTotal);
+  if (reportValid)
+  {
+    fprintf(out, "  report       %10lu frames in %lu ms, %u identifiers, %lu overflow\n",
+            (unsigned long)header.frames, (unsigned long)header.windowMs, header.ids,
+            (unsigned long)header.overflow);
+    fprintf(out, "  errors       %10u stuff, %u form, %u ack, %u bit 1, %u bit 0, %u CRC, REC peak %u\n",
+            header.errors[0], header.errors[1], header.errors[2], header.errors[3], header.errors[4],
+            header.errors[5], header.recPeak);
+    fprintf(out, "  %-10s %10s %10s %10s %6s %6s\n", "id", "frames", "min us", "max us", "dlcs", "probe");
+    for (k = 0; k < header.talkers; k++)
+    {
+      fprintf(out, "  %-10lX %10lu %10lu %10lu %6X %6u\n", (unsigned long)talkers[k].id,
+              (unsigned long)talkers[k].count, (unsigned long)talkers[k].minGapUs,
+              (unsigned long)talkers[k].maxGapUs, talkers[k].dlcMask, talkers[k].probes);
+    }
+  }
+  fprintf(out, "  node         %10lu reports, %lu windows, %lu frames silenced\n", (unsigned long)reports,
+          (unsigned long)monitorStats.windows, (unsigned long)canStats.txSilenced);
+  fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+}
@@ -0,0 +1,327 @@
+/**
+  ******************************************************************************
+  * @file           : sim_ping.c
+  * @brief          : Ping sender and echo check
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * -E rate[,prio]@seconds adds a node that pings this one (ping.h) at that
+  * rate from that time until SIM_PING_DRAIN_US before the end of the run,
+  * with the given priority (default BOOT_PRIO_CMD). Run it with -G to see
+  * the latency under load.
+  *
+  * Every echo is checked against the bus: it must answer a ping still
+  * open, with the ping's priority, and both time stamps must equal the bit
+  * clock at the start of frame of the ping and of the echo. The report
+  * gives the round trip, from the time the ping was queued to the end of
+  * the echo, and the turnaround the stamps give, from the start of the ping
+  * to the start of the echo, as histograms, and checks that every ping was
+  * answered and the node counted as many. A failed check makes the run exit
+  * with status 1.
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "boot.h"
+#include "ping.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_PING_ADDRESS        0x85U
+#define SIM_PING_DRAIN_US       100000U   /* last ping before the end */
+#define SIM_PING_SAMPLES        65536U
+#define SIM_PING_RATE_MAX       2000.0
+
+/* Private variables ---------------------------------------------------------*/
+static double rate;
+static uint32_t prio = BOOT_PRIO_CMD;
+static uint64_t startAtUs;
+static uint64_t stopAtUs;
+static uint64_t nextUs;
+
+static uint8_t sequence;
+static uint64_t queuedUs[256];            /* by sequence, while open */
+static uint64_t startUs[256];             /* start of frame of the ping */
+static uint8_t open[256];
+
+static uint32_t sent;
+static uint32_t echoes;
+static uint32_t stampErrors;
+static uint32_t unexpected;
+static uint32_t prioErrors;
+static uint32_t aheadMax;
+static uint32_t mailboxesMax;
+static uint32_t queueMax;
+static uint32_t *rtt;
+static uint32_t *turnaround;
+static uint32_t samples;
+
+static uint32_t failures;
+
+/* Histogram bucket upper bounds, us */
+static const uint32_t edges[] = { 250U, 500U, 750U, 1000U, 1500U, 2000U, 3000U, 5000U, 10000U, 20000U, 50000U };
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  fprintf(stderr, "sim: ping: %s\n", what);
+  failures++;
+}
+
+static uint64_t wireUs(const CAN_Frame *frame)
+{
+  uint64_t bitrate = SimCan_Bitrate();
+
+  return (((uint64_t)SimCan_FrameBits(frame) * 1000000ULL) + bitrate - 1U) / bitrate;
+}
+
+/* Queues pings up to the next one after now, the rest as they go out */
+static void sendPings(uint64_t nowUs)
+{
+  CAN_Frame ping;
+
+  while ((nextUs <= nowUs + (uint64_t)(1e6 / rate)) && (nextUs < stopAtUs))
+  {
+    memset(&ping, 0xFF, sizeof(ping));
+    ping.id = CAN_FRAME_EXT | BOOT_CAN_ID(prio, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, SIM_PING_ADDRESS);
+    ping.dlc = 8;
+    ping.data[0] = PING_CMD_ECHO;
+    ping.data[1] = sequence;
+    if (SimCan_Inject(&ping, nextUs, SIM_CAN_ORIGIN_MODEL) != 0)
+    {
+      return;
+    }
+    queuedUs[sequence] = nextUs;
+    open[sequence] = 1;
+    sequence++;
+    sent++;
+    nextUs = startAtUs + (uint64_t)((double)sent * 1e6 / rate);
+  }
+}
+
+static void onEcho(const CAN_Frame *frame, uint64_t timeUs)
+{
+  uint8_t seq = frame->data[1];
+  uint16_t rxStamp = (uint16_t)(frame->data[2] | ((uint16_t)frame->data[3] << 8));
+  uint16_t txStamp = (uint16_t)(frame->data[6] | ((uint16_t)frame->data[7] << 8));
+  uint64_t echoStartUs = timeUs - wireUs(frame);
+  uint32_t ahead = (frame->data[5] & PING_AHEAD_MASK) >> PING_AHEAD_Pos;
+  uint32_t mailboxes = frame->data[5] & PING_MAILBOXES_MASK;
+
+  if (!open[seq] || (frame->dlc != 8U))
+  {
+    unexpected++;
+    return;
+  }
+  open[seq] = 0;
+  echoes++;
+  if (((frame->id >> 26) & 7U) != prio)
+  {
+    prioErrors++;
+  }
+  if ((rxStamp != SimCan_BitClock(startUs[seq])) || (txStamp != SimCan_BitClock(echoStartUs)) ||
+      ((frame->data[5] & PING_RESERVED) != PING_RESERVED))
+  {
+    stampErrors++;
+  }
+  aheadMax = (ahead > aheadMax) ? ahead : aheadMax;
+  mailboxesMax = (mailboxes > mailboxesMax) ? mailboxes : mailboxesMax;
+  queueMax = (frame->data[4] > queueMax) ? frame->data[4] : queueMax;
+  if (samples < SIM_PING_SAMPLES)
+  {
+    rtt[samples] = (uint32_t)(timeUs - queuedUs[seq]);
+    turnaround[samples] = (uint32_t)(((uint64_t)(uint16_t)(txStamp - rxStamp) * 1000000ULL) / SimCan_Bitrate());
+    samples++;
+  }
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  (void)ctx;
+
+  if (((frame->id & CAN_FRAME_EXT) == 0U) || (BOOT_ID_PGN(id) != BOOT_PGN_CMD))
+  {
+    return;
+  }
+  if ((origin == SIM_CAN_ORIGIN_MODEL) && (BOOT_ID_SA(id) == SIM_PING_ADDRESS) &&
+      (frame->data[0] == PING_CMD_ECHO))
+  {
+    startUs[frame->data[1]] = timeUs - wireUs(frame);
+    sendPings(timeUs);
+  }
+  else if ((origin == SIM_CAN_ORIGIN_NODE) && (BOOT_ID_DA(id) == SIM_PING_ADDRESS) &&
+           (frame->data[0] == (PING_CMD_ECHO | BOOT_RSP)))
+  {
+    onEcho(frame, timeUs);
+  }
+}
+
+static int compareU32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+/* Percentiles and a histogram of sorted samples */
+static void printDistribution(FILE *out, const char *name, uint32_t *values, uint32_t count)
+{
+  uint32_t buckets = sizeof(edges) / sizeof(edges[0]);
+  uint32_t bucket;
+  uint32_t bar;
+  uint32_t i = 0;
+
+  qsort(values, count, sizeof(values[0]), compareU32);
+  fprintf(out, "  %-12s %10lu us min, %lu p50, %lu p90, %lu p99, %lu max\n", name, (unsigned long)values[0],
+          (unsigned long)values[count / 2U], (unsigned long)values[(count * 9U) / 10U],
+          (unsigned long)values[(count * 99U) / 100U], (unsigned long)values[count - 1U]);
+  for (bucket = 0; bucket <= buckets; bucket++)
+  {
+    uint32_t n = 0;
+
+    while ((i < count) && ((bucket == buckets) || (values[i] <= edges[bucket])))
+    {
+      n++;
+      i++;
+    }
+    if (n == 0U)
+    {
+      continue;
+    }
+    if (bucket < buckets)
+    {
+      fprintf(out, "    <= %5lu us %8lu  ", (unsigned long)edges[bucket], (unsigned long)n);
+    }
+    else
+    {
+      fprintf(out, "     > %5lu us %8lu  ", (unsigned long)edges[bucket - 1U], (unsigned long)n);
+    }
+    for (bar = 0; bar < (n * 40U + count - 1U) / count; bar++)
+    {
+      fputc('#', out);
+    }
+    fputc('\n', out);
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Parses -E and queues the first pings; call after Sim_Cfg is set
+  * @retval None
+  */
+void SimPing_Init(void)
+{
+  const char *at;
+  char *end;
+
+  if (Sim_Cfg.pingSpec == NULL)
+  {
+    return;
+  }
+  at = strchr(Sim_Cfg.pingSpec, '@');
+  rate = strtod(Sim_Cfg.pingSpec, &end);
+  if (*end == ',')
+  {
+    prio = (uint32_t)strtoul(end + 1, &end, 0);
+  }
+  if ((rate <= 0.0) || (rate > SIM_PING_RATE_MAX) || (prio > 7U) || ((*end != '@') && (*end != '\0')))
+  {
+    fprintf(stderr, "sim: -E %s: rate up to %.0f Hz, priority 0..7\n", Sim_Cfg.pingSpec, SIM_PING_RATE_MAX);
+    exit(2);
+  }
+  startAtUs = (at != NULL) ? (uint64_t)(strtod(at + 1, NULL) * 1e6) : 0U;
+  stopAtUs = (Sim_Cfg.durationUs != 0U) ? (Sim_Cfg.durationUs - SIM_PING_DRAIN_US) : UINT64_MAX;
+  if ((Sim_Cfg.durationUs != 0U) && (Sim_Cfg.durationUs < startAtUs + 2U * SIM_PING_DRAIN_US))
+  {
+    fprintf(stderr, "sim: -E %s: starts too close to the end of the run\n", Sim_Cfg.pingSpec);
+    exit(2);
+  }
+  rtt = malloc(SIM_PING_SAMPLES * sizeof(rtt[0]));
+  turnaround = malloc(SIM_PING_SAMPLES * sizeof(turnaround[0]));
+  if ((rtt == NULL) || (turnaround == NULL))
+  {
+    exit(2);
+  }
+
+  nextUs = startAtUs;
+  sendPings(startAtUs);
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Checks the echoes seen against the pings sent
+  * @retval 1 if a check failed
+  */
+int SimPing_Close(void)
+{
+  if (Sim_Cfg.pingSpec == NULL)
+  {
+    return 0;
+  }
+  if (sent == 0U)
+  {
+    fail("no pings sent");
+    return 1;
+  }
+  if ((echoes != sent) || (unexpected != 0U))
+  {
+    fail("pings not answered, or echoes without a ping");
+  }
+  if ((pingStats.echoes != echoes) || (pingStats.busy != 0U))
+  {
+    fail("node counters differ from the echoes seen");
+  }
+  if (prioErrors != 0U)
+  {
+    fail("echo priority differs from the ping's");
+  }
+  if (stampErrors != 0U)
+  {
+    fail("time stamps differ from the bit clock at the start of frame");
+  }
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints the round trip and turnaround distributions
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimPing_Report(FILE *out, double seconds)
+{
+  (void)seconds;
+  if (Sim_Cfg.pingSpec == NULL)
+  {
+    return;
+  }
+  fprintf(out, "===== Ping =====\n");
+  fprintf(out, "  pings        %10lu at %.0f Hz, priority %lu, %lu echoes, %lu unexpected\n", (unsigned long)sent,
+          rate, (unsigned long)prio, (unsigned long)echoes, (unsigned long)unexpected);
+  fprintf(out, "  node         %10lu echoes, %lu busy\n", (unsigned long)pingStats.echoes,
+          (unsigned long)pingStats.busy);
+  fprintf(out, "  at the ping  %10lu frames in the TX queue, %lu mailboxes, %lu echoes ahead at most\n",
+          (unsigned long)queueMax, (unsigned long)mailboxesMax, (unsigned long)aheadMax);
+  if (samples != 0U)
+  {
+    printDistribution(out, "round trip", rtt, samples);
+    printDistribution(out, "turnaround", turnaround, samples);
+  }
+  fprintf(out, "  stamps       %10lu errors, %lu priority errors\n", (unsigned long)stampErrors,
+          (unsigned long)prioErrors);
+  fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+}
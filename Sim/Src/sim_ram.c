@@ -0,0 +1,244 @@
+/**
+  ******************************************************************************
+  * @file           : sim_ram.c
+  * @brief          : Painted SRAM, stack and heap use injection and the
+  *                   high-water mark check
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The firmware runs on the host stack, so nothing but this model touches
+  * the SRAM that Src/sim_crash.c maps: _end and _estack come from the sim
+  * Makefile, and the area between them is painted as Reset_Handler does.
+  *
+  * -S stack[,heap]@seconds makes the next HAL_ADC_Start() (inside T1) write
+  * the word stack bytes below _estack, as a call chain that deep would,
+  * and ask _sbrk() for heap bytes. The report checks that Ram_Scan() found
+  * exactly that depth, that _sbrk() granted or refused the request as its
+  * limit says, and that a later diagnostics message (PGN 65284) carried the
+  * same figures. A failed check makes the run exit with status 1.
+  */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "ram.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_STACK_WORD          0x57AC57ACUL  /* anything but RAM_PAINT */
+
+/* Private variables ---------------------------------------------------------*/
+extern uint32_t _end;
+extern uint32_t _estack;
+extern uint32_t _Min_Stack_Size;
+
+void *_sbrk(ptrdiff_t incr);
+
+static uint32_t stackBytes;
+static uint32_t heapBytes;
+static uint64_t useAtUs;
+static uint64_t usedUs = UINT64_MAX;
+static int heapGranted;
+
+static uint32_t diagsSeen;
+static uint64_t diagUs;                   /* last diagnostics message */
+static uint8_t diag[8];
+
+static uint32_t failures;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  fprintf(stderr, "sim: ram: %s\n", what);
+  failures++;
+}
+
+static uint32_t le16(const uint8_t *p)
+{
+  return p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t heapLimit(void)
+{
+  return (uint32_t)((uintptr_t)&_estack - (uintptr_t)&_Min_Stack_Size - (uintptr_t)&_end);
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  (void)ctx;
+
+  if ((origin != SIM_CAN_ORIGIN_NODE) || ((frame->id & CAN_FRAME_EXT) == 0U) ||
+      (((id >> 8) & 0x3FFFFUL) != RAM_PGN_DIAG) || (frame->dlc != 8U))
+  {
+    return;
+  }
+  diagsSeen++;
+  diagUs = timeUs;
+  memcpy(diag, frame->data, sizeof(diag));
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Paints SRAM from _end to _estack and parses -S; call after
+  *         SimCrash_Init(), which maps SRAM
+  * @retval None
+  */
+void SimRam_Init(void)
+{
+  uint32_t *word;
+
+  for (word = &_end; word < &_estack; word++)
+  {
+    *word = RAM_PAINT;
+  }
+
+  if (Sim_Cfg.ramSpec != NULL)
+  {
+    char *end;
+    const char *at = strchr(Sim_Cfg.ramSpec, '@');
+
+    stackBytes = (uint32_t)strtoul(Sim_Cfg.ramSpec, &end, 0);
+    if (*end == ',')
+    {
+      heapBytes = (uint32_t)strtoul(end + 1, &end, 0);
+    }
+    if ((stackBytes < 4U) || ((stackBytes & 3U) != 0U) ||
+        (stackBytes > (uint32_t)((uintptr_t)&_estack - (uintptr_t)&_end)) || ((*end != '@') && (*end != '\0')))
+    {
+      fprintf(stderr, "sim: -S %s: stack is a multiple of 4 below %lu, heap optional\n", Sim_Cfg.ramSpec,
+              (unsigned long)((uintptr_t)&_estack - (uintptr_t)&_end));
+      exit(2);
+    }
+    useAtUs = (at != NULL) ? (uint64_t)(strtod(at + 1, NULL) * 1e6) : 0U;
+  }
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Checks the marks found against what -S injected
+  * @retval 1 if a check failed
+  */
+int SimRam_Close(void)
+{
+  if (Sim_Cfg.ramSpec == NULL)
+  {
+    return 0;
+  }
+  if (usedUs == UINT64_MAX)
+  {
+    fail("stack and heap use never injected");
+    return 1;
+  }
+
+  if (ramStats.stackPeak != stackBytes)
+  {
+    fail("stack high-water mark differs from the injected depth");
+  }
+  if (heapGranted != (heapBytes <= heapLimit()))
+  {
+    fail("_sbrk() did not honour its limit");
+  }
+  if (ramStats.heapPeak != (heapGranted ? heapBytes : 0U))
+  {
+    fail("heap high-water mark differs from the granted request");
+  }
+  if (ramStats.heapFailures != (heapGranted ? 0U : 1U))
+  {
+    fail("refused heap requests miscounted");
+  }
+  if (ramStats.passes == 0U)
+  {
+    fail("no scan pass completed");
+  }
+  if ((diagsSeen == 0U) || (diagUs <= usedUs))
+  {
+    fail("no diagnostics message after the injection");
+  }
+  else if ((le16(&diag[0]) != stackBytes) || (le16(&diag[4]) != ramStats.heapPeak) ||
+           (diag[6] != ramStats.heapFailures) || ((diag[7] & RAM_DIAG_SCANNED) == 0U) ||
+           (((diag[7] & RAM_DIAG_STACK_OVER) != 0U) != (stackBytes > (uint32_t)(uintptr_t)&_Min_Stack_Size)))
+  {
+    fail("diagnostics message does not match the marks");
+  }
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints the marks and the last diagnostics message
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimRam_Report(FILE *out, double seconds)
+{
+  (void)seconds;
+  fprintf(out, "===== RAM =====\n");
+  fprintf(out, "  painted      %10lu bytes from 0x%08lX, heap limit %lu bytes\n",
+          (unsigned long)((uintptr_t)&_estack - (uintptr_t)&_end), (unsigned long)(uintptr_t)&_end,
+          (unsigned long)heapLimit());
+  if (usedUs != UINT64_MAX)
+  {
+    fprintf(out, "  injected     %10lu stack bytes, %lu heap bytes (%s) at %.3f s\n",
+            (unsigned long)stackBytes, (unsigned long)heapBytes, heapGranted ? "granted" : "refused",
+            (double)usedUs / 1e6);
+  }
+  fprintf(out, "  stack peak   %10lu bytes, headroom %lu bytes, %lu scan passes\n",
+          (unsigned long)ramStats.stackPeak, (unsigned long)ramStats.headroom, (unsigned long)ramStats.passes);
+  fprintf(out, "  heap peak    %10lu bytes, %lu requests refused\n",
+          (unsigned long)ramStats.heapPeak, (unsigned long)ramStats.heapFailures);
+  fprintf(out, "  diagnostics  %10lu sent, %lu seen", (unsigned long)ramStats.diags, (unsigned long)diagsSeen);
+  if (diagsSeen != 0U)
+  {
+    fprintf(out, ", last at %.3f s: stack %lu, headroom %lu, heap %lu, refused %u, flags 0x%02X",
+            (double)diagUs / 1e6, (unsigned long)le16(&diag[0]), (unsigned long)le16(&diag[2]),
+            (unsigned long)le16(&diag[4]), diag[6], diag[7] & 0x07U);
+  }
+  fprintf(out, "\n");
+  if (Sim_Cfg.ramSpec != NULL)
+  {
+    fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+  }
+}
+
+/**
+  * @brief  Stack and heap use hook for HAL_ADC_Start(), once -S is due
+  * @retval None
+  */
+void SimRam_Use(void)
+{
+  uint32_t *deepest = (uint32_t *)((uintptr_t)&_estack - stackBytes);
+  uint32_t i;
+
+  if ((Sim_Cfg.ramSpec == NULL) || (Sim_NowUs < useAtUs) || (usedUs != UINT64_MAX))
+  {
+    return;
+  }
+  usedUs = Sim_NowUs;
+
+  /* A frame writes a few words at the bottom and leaves others painted */
+  for (i = 0; (i < 4U) && (&deepest[i] < &_estack); i += 2U)
+  {
+    deepest[i] = SIM_STACK_WORD;
+  }
+  if (heapBytes != 0U)
+  {
+    heapGranted = (_sbrk((ptrdiff_t)heapBytes) != (void *)-1);
+  }
+  else
+  {
+    heapGranted = 1;
+  }
+}
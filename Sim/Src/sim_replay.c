@@ -0,0 +1,300 @@
+/**
+  ******************************************************************************
+  * @file           : sim_replay.c
+  * @brief          : Replays a captured candump log onto the simulated bus
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * -R streams a candump log or pcap capture (read with Tools/n2klog.c, mapped,
+  * not loaded) onto the bus as frames from other nodes, so they go through
+  * arbitration, the bxCAN filters and FIFO0 like live traffic. The first
+  * frame goes out when the node first transmits; each later one at its
+  * original offset divided by the -X speed (1 = original timing, 10 = ten
+  * times faster, 0 = back to back as fast as the bus carries them). Beyond
+  * line rate the bus is the limit: raise it with -b.
+  *
+  * Frames the node itself sent in the capture (A1, and 29-bit identifiers
+  * with its source or service address) are skipped. Frames are queued at
+  * most SIM_REPLAY_AHEAD_US ahead of the bus, refilled from the bus tap,
+  * but at least one is always queued; like the other simulated nodes, a
+  * frame far ahead holds back the -P and -H frames queued after it.
+  *
+  * The report gives the bus delay of the replayed frames against their
+  * schedule, the node's responses and the frames lost between the bus and
+  * the application during the replay. With -l the log records the replayed
+  * frames and the node's responses interleaved, in bus order.
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "boot.h"
+#include "params.h"
+#include "ping.h"
+#include "n2klog.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_REPLAY_AHEAD_US     10000U    /* frames queued ahead of the bus */
+#define SIM_REPLAY_PENDING      256U      /* schedule of queued frames, power of two */
+#define SIM_REPLAY_A1_ID        0x0A1UL
+#define SIM_REPLAY_END_US       1000000U  /* -d 0: run on this long after the last frame,
+                                             or the start if there is none */
+
+/* Private variables ---------------------------------------------------------*/
+static N2k_Log replayLog;
+static size_t replayPos;
+static int replayOpen;
+static int replayDone;
+static int started;
+
+static CAN_Frame next;                    /* read but not yet queued */
+static uint64_t nextLogUs;
+static int haveNext;
+static uint64_t firstLogUs;
+static uint64_t startUs;
+static uint64_t lastReadyUs;
+
+/* Scheduled times of the frames in the bus queue, in bus order */
+static uint64_t pending[SIM_REPLAY_PENDING];
+static uint32_t pendingHead;
+static uint32_t pendingTail;
+
+static uint32_t framesRead;
+static uint32_t framesSkipped;
+static uint32_t framesSent;
+static uint64_t delaySumUs;
+static uint64_t delayMaxUs;
+static uint64_t endUs;
+
+static uint32_t nodeFrames;
+static uint32_t nodeResponses;
+static CAN_Stats canAtStart;
+static uint32_t echoesAtStart;
+static uint32_t lostAsleepAtStart;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Frames this node sends itself; replaying them would duplicate its traffic */
+static int ownFrame(const N2k_Frame *frame)
+{
+  uint8_t src = (uint8_t)frame->id;
+
+  if (!frame->ext)
+  {
+    return frame->id == SIM_REPLAY_A1_ID;
+  }
+  return (src == (uint8_t)Params_Get(PARAM_SOURCE_ADDRESS)) || (src == BOOT_NODE_ADDRESS);
+}
+
+/* Reads the next frame to replay into next; 0 at the end of the log */
+static int readNext(void)
+{
+  N2k_Frame frame;
+
+  while (N2k_Next(&replayLog, &replayPos, replayLog.size, &frame))
+  {
+    uint64_t logUs = frame.sec * 1000000U + frame.usec;
+
+    framesRead++;
+    if (framesRead == 1U)
+    {
+      firstLogUs = logUs;
+    }
+    if (ownFrame(&frame))
+    {
+      framesSkipped++;
+      continue;
+    }
+    next.id = frame.id | (frame.ext ? CAN_FRAME_EXT : 0U) | (frame.rtr ? CAN_FRAME_RTR : 0U);
+    next.dlc = frame.dlc;
+    next.filter = 0;
+    next.time = 0;
+    memcpy(next.data, frame.data, sizeof(next.data));
+    /* A log that steps back in time (concatenated captures) replays on */
+    nextLogUs = (logUs < firstLogUs) ? firstLogUs : logUs;
+    return 1;
+  }
+  return 0;
+}
+
+/* Queues every frame due before the lookahead, as far as the bus queue allows */
+static void refill(uint64_t timeUs)
+{
+  while (haveNext)
+  {
+    uint64_t readyUs = lastReadyUs;
+
+    if (Sim_Cfg.replaySpeed > 0.0)
+    {
+      readyUs = startUs + (uint64_t)((double)(nextLogUs - firstLogUs) / Sim_Cfg.replaySpeed);
+      /* Keep the order of the log if it is not sorted */
+      readyUs = (readyUs < lastReadyUs) ? lastReadyUs : readyUs;
+    }
+    /* One frame always stays queued, however far ahead: it brings the next
+     * tap when the node is quiet, and its start wakes the node from Stop */
+    if (((readyUs > (timeUs + SIM_REPLAY_AHEAD_US)) && (pendingHead != pendingTail)) ||
+        ((pendingHead - pendingTail) >= SIM_REPLAY_PENDING) ||
+        (SimCan_Inject(&next, readyUs, SIM_CAN_ORIGIN_REPLAY) != 0))
+    {
+      return;
+    }
+    pending[pendingHead++ & (SIM_REPLAY_PENDING - 1U)] = (readyUs < Sim_NowUs) ? Sim_NowUs : readyUs;
+    lastReadyUs = readyUs;
+    framesSent++;
+    haveNext = readNext();
+  }
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  (void)ctx;
+
+  if (!started)
+  {
+    started = 1;
+    startUs = timeUs;
+    lastReadyUs = timeUs;
+    canAtStart = canStats;
+    echoesAtStart = pingStats.echoes;
+    lostAsleepAtStart = SimCan_FramesLostAsleep();
+  }
+
+  if (origin == SIM_CAN_ORIGIN_REPLAY)
+  {
+    /* Frames leave the bus queue in order: delay from schedule to end of
+     * arbitration, i.e. the bus time the frame had to wait */
+    uint64_t onWireUs = ((uint64_t)SimCan_FrameBits(frame) * 1000000U) / SimCan_Bitrate();
+    uint64_t scheduledUs = pending[pendingTail++ & (SIM_REPLAY_PENDING - 1U)];
+    uint64_t delayUs = ((timeUs - onWireUs) > scheduledUs) ? (timeUs - onWireUs - scheduledUs) : 0U;
+
+    delaySumUs += delayUs;
+    if (delayUs > delayMaxUs)
+    {
+      delayMaxUs = delayUs;
+    }
+    if (!haveNext && (pendingTail == pendingHead))
+    {
+      replayDone = 1;
+      endUs = timeUs;
+      if (Sim_Cfg.durationUs == 0U)
+      {
+        Sim_Cfg.durationUs = timeUs + SIM_REPLAY_END_US;
+      }
+    }
+  }
+  else if ((origin == SIM_CAN_ORIGIN_NODE) && !replayDone)
+  {
+    nodeFrames++;
+    if (((frame->id & CAN_FRAME_EXT) != 0U) && (BOOT_ID_PGN(frame->id & CAN_FRAME_ID_MASK) == BOOT_PGN_CMD) &&
+        ((frame->data[0] & BOOT_RSP) != 0U))
+    {
+      nodeResponses++;
+    }
+  }
+
+  refill(timeUs);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Maps the -R log and starts the replay with the node's first frame
+  * @retval None
+  */
+void SimReplay_Init(void)
+{
+  if (Sim_Cfg.replayPath == NULL)
+  {
+    return;
+  }
+  if (N2k_Open(&replayLog, Sim_Cfg.replayPath) != 0)
+  {
+    exit(2);
+  }
+  replayOpen = 1;
+  replayPos = replayLog.first;
+  haveNext = readNext();
+  replayDone = !haveNext;
+  if (replayDone)
+  {
+    /* No replayed frame will reach busTap() to end a -d 0 run */
+    fprintf(stderr, "sim: %s: nothing to replay, %lu of the node's own frames skipped\n", Sim_Cfg.replayPath,
+            (unsigned long)framesSkipped);
+    started = 1;
+    startUs = Sim_NowUs;
+    endUs = Sim_NowUs;
+    if (Sim_Cfg.durationUs == 0U)
+    {
+      Sim_Cfg.durationUs = Sim_NowUs + SIM_REPLAY_END_US;
+    }
+  }
+  SimCan_AddTap(busTap, NULL);
+}
+
+void SimReplay_Close(void)
+{
+  if (replayOpen)
+  {
+    N2k_Close(&replayLog);
+    replayOpen = 0;
+  }
+}
+
+/**
+  * @brief  Prints replay progress, timing and losses
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimReplay_Report(FILE *out, double seconds)
+{
+  double spanS = (double)(((replayDone ? endUs : Sim_NowUs) - startUs)) / 1e6;
+
+  (void)seconds;
+  if (Sim_Cfg.replayPath == NULL)
+  {
+    return;
+  }
+  fprintf(out, "===== Replay (%s) =====\n", Sim_Cfg.replayPath);
+  fprintf(out, "  frames       %10lu sent, %lu of the node's own skipped, %s\n", (unsigned long)framesSent,
+          (unsigned long)framesSkipped, replayDone ? "log complete" : "log not finished");
+  if (Sim_Cfg.replaySpeed > 0.0)
+  {
+    fprintf(out, "  timing       %10.2fx the capture", Sim_Cfg.replaySpeed);
+  }
+  else
+  {
+    fprintf(out, "  timing       %10s", "back to back");
+  }
+  fprintf(out, ", %.3f s, %.0f frames/s\n", spanS, (spanS > 0.0) ? (double)framesSent / spanS : 0.0);
+  if ((framesSent != 0U) && (Sim_Cfg.replaySpeed > 0.0))
+  {
+    fprintf(out, "  bus delay    %10.1f us avg, %.1f us max behind schedule\n",
+            (double)delaySumUs / (double)framesSent, (double)delayMaxUs);
+  }
+  fprintf(out, "  node         %10lu frames sent meanwhile, %lu command responses\n",
+          (unsigned long)nodeFrames, (unsigned long)nodeResponses);
+  if (canStats.txFailed != canAtStart.txFailed)
+  {
+    fprintf(out, "  node lost    %10lu frames to arbitration, not retried\n",
+            (unsigned long)(canStats.txFailed - canAtStart.txFailed));
+  }
+  fprintf(out, "  received     %10lu into the RX queue, %lu pings answered from the interrupt\n",
+          (unsigned long)(canStats.rxFrames - canAtStart.rxFrames), (unsigned long)(pingStats.echoes - echoesAtStart));
+  /* The filter passes everything, so every frame sent should arrive */
+  fprintf(out, "  lost         %10lu frames: %lu FIFO0 overruns, %lu RX queue full, %lu while bxCAN slept\n",
+          (unsigned long)(framesSent - (canStats.rxFrames - canAtStart.rxFrames) - (pingStats.echoes - echoesAtStart)),
+          (unsigned long)(canStats.rxOverruns - canAtStart.rxOverruns),
+          (unsigned long)(canStats.rxDropped - canAtStart.rxDropped),
+          (unsigned long)(SimCan_FramesLostAsleep() - lostAsleepAtStart));
+}
@@ -0,0 +1,301 @@
+/**
+  ******************************************************************************
+  * @file           : sim_socketcan.c
+  * @brief          : Bridges the simulated bus to a Linux SocketCAN interface
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Frames this node puts on the simulated bus are written to a raw CAN
+  * socket, and frames read from the socket are injected into the simulated
+  * bus, so the node shows up next to candump/cansend and other simulated
+  * nodes on the same vcan or can interface.
+  *
+  * Both directions are batched: transmitted frames collect in a buffer that
+  * goes out with one sendmmsg() before the simulator blocks, and every wake-up
+  * drains the socket with recvmmsg() in blocks of SIM_SOCKET_BATCH frames.
+  * Kernel receive-queue drops are reported through SO_RXQ_OVFL.
+  *
+  * With no interface open, SimSocketCan_Wait() only sleeps, which gives the
+  * real-time pacing used by -x without a bus.
+  */
+
+#include <errno.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "sim.h"
+
+#define SIM_SOCKET_BATCH      64U     /* frames per sendmmsg/recvmmsg call */
+
+static int sock = -1;
+static char sockIfName[IFNAMSIZ];
+
+static struct can_frame txFrames[SIM_SOCKET_BATCH];
+static struct iovec txIov[SIM_SOCKET_BATCH];
+static struct mmsghdr txMsgs[SIM_SOCKET_BATCH];
+static uint32_t txCount;
+
+static struct can_frame rxFrames[SIM_SOCKET_BATCH];
+static struct iovec rxIov[SIM_SOCKET_BATCH];
+static struct mmsghdr rxMsgs[SIM_SOCKET_BATCH];
+static uint8_t rxCtrl[SIM_SOCKET_BATCH][CMSG_SPACE(sizeof(uint32_t))];
+
+static struct
+{
+  uint64_t txFrames;
+  uint64_t txBatches;
+  uint64_t txDropped;
+  uint64_t rxFrames;
+  uint64_t rxBatches;
+  uint64_t rxInjectDropped;
+  uint32_t rxKernelDropped;   /* SO_RXQ_OVFL counter, cumulative */
+} stats;
+
+static void flushTx(void)
+{
+  uint32_t sent = 0;
+
+  while (sent < txCount)
+  {
+    int n = sendmmsg(sock, &txMsgs[sent], txCount - sent, MSG_DONTWAIT);
+
+    if (n < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      /* ENOBUFS/EAGAIN: interface queue full, the rest of the batch is lost */
+      stats.txDropped += txCount - sent;
+      break;
+    }
+    sent += (uint32_t)n;
+  }
+  stats.txFrames += sent;
+  stats.txBatches++;
+  txCount = 0;
+}
+
+static void socketTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  struct can_frame *cf = &txFrames[txCount];
+
+  (void)timeUs;
+  (void)ctx;
+  if (origin == SIM_CAN_ORIGIN_SOCKET)
+  {
+    return;
+  }
+
+  memset(cf, 0, sizeof(*cf));
+  cf->can_id = frame->id & CAN_FRAME_ID_MASK;
+  if ((frame->id & CAN_FRAME_EXT) != 0U)
+  {
+    cf->can_id |= CAN_EFF_FLAG;
+  }
+  if ((frame->id & CAN_FRAME_RTR) != 0U)
+  {
+    cf->can_id |= CAN_RTR_FLAG;
+  }
+  cf->can_dlc = (frame->dlc > 8U) ? 8U : frame->dlc;
+  memcpy(cf->data, frame->data, 8);
+
+  if (++txCount == SIM_SOCKET_BATCH)
+  {
+    flushTx();
+  }
+}
+
+static void drainRx(void)
+{
+  for (;;)
+  {
+    uint32_t i;
+    int n;
+
+    for (i = 0; i < SIM_SOCKET_BATCH; i++)
+    {
+      rxMsgs[i].msg_hdr.msg_controllen = sizeof(rxCtrl[i]);
+    }
+    n = recvmmsg(sock, rxMsgs, SIM_SOCKET_BATCH, MSG_DONTWAIT, NULL);
+    if (n <= 0)
+    {
+      return;
+    }
+    stats.rxBatches++;
+
+    for (i = 0; i < (uint32_t)n; i++)
+    {
+      const struct can_frame *cf = &rxFrames[i];
+      struct cmsghdr *cmsg;
+      CAN_Frame frame;
+
+      for (cmsg = CMSG_FIRSTHDR(&rxMsgs[i].msg_hdr); cmsg != NULL;
+           cmsg = CMSG_NXTHDR(&rxMsgs[i].msg_hdr, cmsg))
+      {
+        if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SO_RXQ_OVFL))
+        {
+          memcpy(&stats.rxKernelDropped, CMSG_DATA(cmsg), sizeof(stats.rxKernelDropped));
+        }
+      }
+      if ((rxMsgs[i].msg_len < sizeof(*cf)) || ((cf->can_id & CAN_ERR_FLAG) != 0U))
+      {
+        continue;
+      }
+
+      memset(&frame, 0, sizeof(frame));
+      if ((cf->can_id & CAN_EFF_FLAG) != 0U)
+      {
+        frame.id = (cf->can_id & CAN_EFF_MASK) | CAN_FRAME_EXT;
+      }
+      else
+      {
+        frame.id = cf->can_id & CAN_SFF_MASK;
+      }
+      if ((cf->can_id & CAN_RTR_FLAG) != 0U)
+      {
+        frame.id |= CAN_FRAME_RTR;
+      }
+      frame.dlc = (cf->can_dlc > 8U) ? 8U : cf->can_dlc;
+      memcpy(frame.data, cf->data, 8);
+
+      stats.rxFrames++;
+      if (SimCan_Inject(&frame, Sim_WallUs(), SIM_CAN_ORIGIN_SOCKET) != 0)
+      {
+        stats.rxInjectDropped++;
+      }
+    }
+    if ((uint32_t)n < SIM_SOCKET_BATCH)
+    {
+      return;
+    }
+  }
+}
+
+/**
+  * @brief  Opens a raw CAN socket on an interface and attaches it to the bus
+  * @param  ifname: interface name, e.g. "vcan0"
+  * @retval None, exits on failure
+  */
+void SimSocketCan_Open(const char *ifname)
+{
+  struct sockaddr_can addr;
+  struct ifreq ifr;
+  int one = 1;
+  uint32_t i;
+
+  sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (sock < 0)
+  {
+    perror("socket(PF_CAN)");
+    exit(2);
+  }
+
+  memset(&ifr, 0, sizeof(ifr));
+  snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+  if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    exit(2);
+  }
+  snprintf(sockIfName, sizeof(sockIfName), "%s", ifname);
+
+  /* Drop counter as ancillary data on every received frame */
+  (void)setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    exit(2);
+  }
+
+  for (i = 0; i < SIM_SOCKET_BATCH; i++)
+  {
+    txIov[i].iov_base = &txFrames[i];
+    txIov[i].iov_len = sizeof(txFrames[i]);
+    txMsgs[i].msg_hdr.msg_iov = &txIov[i];
+    txMsgs[i].msg_hdr.msg_iovlen = 1;
+
+    rxIov[i].iov_base = &rxFrames[i];
+    rxIov[i].iov_len = sizeof(rxFrames[i]);
+    rxMsgs[i].msg_hdr.msg_iov = &rxIov[i];
+    rxMsgs[i].msg_hdr.msg_iovlen = 1;
+    rxMsgs[i].msg_hdr.msg_control = rxCtrl[i];
+  }
+
+  SimCan_AddTap(socketTap, NULL);
+}
+
+/**
+  * @brief  Flushes pending transmissions, then waits for socket traffic
+  * @param  timeoutUs: longest wait in host microseconds
+  * @retval number of frames injected into the simulated bus
+  */
+int SimSocketCan_Wait(uint64_t timeoutUs)
+{
+  struct pollfd pfd = { .fd = sock, .events = POLLIN, .revents = 0 };
+  struct timespec ts = { .tv_sec = (time_t)(timeoutUs / 1000000U),
+                         .tv_nsec = (long)((timeoutUs % 1000000U) * 1000U) };
+  uint64_t before = stats.rxFrames;
+
+  if (sock < 0)
+  {
+    (void)ppoll(NULL, 0, &ts, NULL);
+    return 0;
+  }
+
+  if (txCount != 0U)
+  {
+    flushTx();
+  }
+  if ((ppoll(&pfd, 1, &ts, NULL) > 0) && ((pfd.revents & POLLIN) != 0))
+  {
+    drainRx();
+  }
+  return (int)(stats.rxFrames - before);
+}
+
+/**
+  * @brief  Prints the bridge counters
+  * @param  out: destination stream
+  * @retval None
+  */
+void SimSocketCan_Report(FILE *out)
+{
+  if (sock < 0)
+  {
+    return;
+  }
+  if (txCount != 0U)
+  {
+    flushTx();
+  }
+  fprintf(out, "===== SocketCAN %s =====\n", sockIfName);
+  fprintf(out, "  tx %llu frames in %llu batches (%.1f/batch), %llu dropped\n",
+          (unsigned long long)stats.txFrames, (unsigned long long)stats.txBatches,
+          (stats.txBatches != 0U) ? (double)stats.txFrames / (double)stats.txBatches : 0.0,
+          (unsigned long long)stats.txDropped);
+  fprintf(out, "  rx %llu frames in %llu batches (%.1f/batch), %u kernel drops, %llu bus queue drops\n",
+          (unsigned long long)stats.rxFrames, (unsigned long long)stats.rxBatches,
+          (stats.rxBatches != 0U) ? (double)stats.rxFrames / (double)stats.rxBatches : 0.0,
+          stats.rxKernelDropped, (unsigned long long)stats.rxInjectDropped);
+}
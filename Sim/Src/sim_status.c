@@ -0,0 +1,227 @@
+/**
+  ******************************************************************************
+  * @file           : sim_status.c
+  * @brief          : Status page check on the A1 frames
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Always on: every A1 frame the node sends is decoded with the firmware's
+  * own codec (Core/Src/status.c) and checked against the model as it goes
+  * onto the bus:
+  *
+  *   - pages and rounds follow each other without a gap, bus-stress pauses
+  *     included, unless a mailbox lost arbitration (canStats.txFailed)
+  *     since the last page
+  *   - the uptime is no later than the bus and at most SIM_STATUS_LAG_MS
+  *     earlier, the period is PARAM_A1_PERIOD_MS
+  *   - counters and high-water marks never run ahead of the firmware's
+  *     and never go back
+  *
+  * Complete rounds are reassembled into snapshots as a receiver would; the
+  * last one is printed. A failed check makes the run exit with status 1.
+  */
+
+#include "main.h"
+#include "params.h"
+#include "ram.h"
+#include "status.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_STATUS_LAG_MS       100U      /* queueing, and the 1 ms tick */
+#define SIM_STATUS_WRAP         (1UL << 28)
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t frames;
+static uint32_t snapshots;
+static uint32_t sequenceErrors;
+static uint32_t valueErrors;
+static uint32_t lostGaps;         /* out of sequence after a lost mailbox */
+static uint32_t txFailedSeen;     /* canStats.txFailed at the last A1 frame */
+
+static uint8_t started;
+static uint8_t nextPage;
+static uint8_t nextRound;
+
+static uint8_t inRound;           /* pages of this round in order so far */
+static Status_Snapshot last;      /* last complete round */
+static Status_Snapshot seen;      /* latest value of every field */
+static uint32_t loadSum;          /* LOAD pages, for the mean */
+static uint32_t loadPages;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what, uint32_t *counter)
+{
+  if (*counter == 0U)
+  {
+    fprintf(stderr, "sim: status: %s at %.6f s\n", what, (double)Sim_NowUs / 1e6);
+  }
+  (*counter)++;
+}
+
+/* a is no later than b, modulo the 28-bit counter width */
+static int notAhead(uint32_t a, uint32_t b)
+{
+  return ((b - a) & (SIM_STATUS_WRAP - 1U)) < (SIM_STATUS_WRAP / 2U);
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  Status_Snapshot page = seen;
+  uint64_t busMs = timeUs / 1000U;
+  uint8_t round;
+  uint8_t index;
+
+  (void)ctx;
+  if ((origin != SIM_CAN_ORIGIN_NODE) || ((frame->id & CAN_FRAME_EXT) != 0U) ||
+      ((frame->id & CAN_FRAME_ID_MASK) != STATUS_ID))
+  {
+    return;
+  }
+  frames++;
+  index = (frame->dlc == 8U) ? Status_Unpack(frame->data, &round, &page) : STATUS_PAGES;
+  if (index == STATUS_PAGES)
+  {
+    fail("A1 frame is no status page", &valueErrors);
+    return;
+  }
+  if (started && ((index != nextPage) || (round != nextRound)))
+  {
+    /* AutoRetransmission is off: a page that lost arbitration is gone */
+    if (canStats.txFailed != txFailedSeen)
+    {
+      lostGaps++;
+    }
+    else
+    {
+      fail("status page out of sequence", &sequenceErrors);
+    }
+    inRound = 0;
+  }
+  txFailedSeen = canStats.txFailed;
+  if (index == 0U)
+  {
+    inRound = 1;
+  }
+  started = 1;
+  nextPage = (uint8_t)((index + 1U) % STATUS_PAGES);
+  nextRound = (nextPage == 0U) ? (uint8_t)((round + 1U) % STATUS_ROUNDS) : round;
+
+  switch (index)
+  {
+    case STATUS_PAGE_UPTIME:
+      if ((page.uptimeMs > busMs) || (page.uptimeMs + SIM_STATUS_LAG_MS < busMs))
+      {
+        fail("uptime does not match the bus time", &valueErrors);
+      }
+      if (page.periodMs != Params_Get(PARAM_A1_PERIOD_MS))
+      {
+        fail("period differs from PARAM_A1_PERIOD_MS", &valueErrors);
+      }
+      break;
+    case STATUS_PAGE_TRAFFIC:
+      if (!notAhead(page.txFrames, canStats.txFrames) || !notAhead(page.rxFrames, canStats.rxFrames) ||
+          !notAhead(seen.txFrames, page.txFrames) || !notAhead(seen.rxFrames, page.rxFrames))
+      {
+        fail("frame counters ahead of the driver or going back", &valueErrors);
+      }
+      break;
+    case STATUS_PAGE_ERRORS:
+      if ((page.rxDropped > canStats.rxDropped) || (page.txDropped > canStats.txDropped) ||
+          (page.rxOverruns > canStats.rxOverruns) || (page.rxDropped < seen.rxDropped) ||
+          (page.txDropped < seen.txDropped) || (page.rxOverruns < seen.rxOverruns))
+      {
+        fail("drop counters ahead of the driver or going back", &valueErrors);
+      }
+      break;
+    case STATUS_PAGE_LOAD:
+      if (page.loadPermille > 1000U)
+      {
+        fail("CPU load above 100 %", &valueErrors);
+      }
+      loadSum += page.loadPermille;
+      loadPages++;
+      break;
+    default:
+      if ((page.stackPeak > ramStats.stackPeak) || (page.heapPeak > ramStats.heapPeak) ||
+          (page.stackPeak < seen.stackPeak) || (page.heapPeak < seen.heapPeak))
+      {
+        fail("high-water marks ahead of ramStats or going back", &valueErrors);
+      }
+      break;
+  }
+  seen = page;
+
+  /* A round counts only if all its pages came in order */
+  if ((index == (STATUS_PAGES - 1U)) && inRound)
+  {
+    last = seen;
+    snapshots++;
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Taps the bus for the A1 frames
+  * @retval None
+  */
+void SimStatus_Init(void)
+{
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Checks that whole rounds came through
+  * @retval 1 if a check failed
+  */
+int SimStatus_Close(void)
+{
+  if ((frames >= (2U * STATUS_PAGES)) && (snapshots == 0U))
+  {
+    fail("no complete round of status pages", &valueErrors);
+  }
+  return (sequenceErrors + valueErrors) != 0U;
+}
+
+/**
+  * @brief  Prints the page counts and the last snapshot
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimStatus_Report(FILE *out, double seconds)
+{
+  (void)seconds;
+  fprintf(out, "===== Status pages (A1) =====\n");
+  fprintf(out, "  frames       %10lu, %lu snapshots, %lu sequence errors, %lu value errors\n",
+          (unsigned long)frames, (unsigned long)snapshots, (unsigned long)sequenceErrors,
+          (unsigned long)valueErrors);
+  if (lostGaps != 0U)
+  {
+    fprintf(out, "  lost pages   %10lu gaps after mailboxes lost to arbitration\n", (unsigned long)lostGaps);
+  }
+  if (snapshots != 0U)
+  {
+    fprintf(out, "  uptime       %10.3f s, period %u ms\n", (double)last.uptimeMs / 1e3, last.periodMs);
+    fprintf(out, "  frames       %10lu sent, %lu received\n", (unsigned long)last.txFrames,
+            (unsigned long)last.rxFrames);
+    fprintf(out, "  errors       %10lu RX dropped, %lu TX dropped, %lu overruns, TEC %u, REC %u, LEC %u, flags 0x%X\n",
+            (unsigned long)last.rxDropped, (unsigned long)last.txDropped, (unsigned long)last.rxOverruns,
+            last.tec, last.rec, last.lec, last.flags);
+    fprintf(out, "  load         %10.1f %% (%.1f %% mean), jitter %lu us\n", (double)last.loadPermille / 10.0,
+            (loadPages != 0U) ? (double)loadSum / (10.0 * loadPages) : 0.0, (unsigned long)last.jitterUs);
+    fprintf(out, "  memory       %10u ADC counts, stack %lu bytes, heap %lu bytes\n", last.adc,
+            (unsigned long)last.stackPeak, (unsigned long)last.heapPeak);
+  }
+  fprintf(out, "  check        %10s\n", ((sequenceErrors + valueErrors) == 0U) ? "ok" : "FAILED");
+}
@@ -0,0 +1,431 @@
+/**
+  ******************************************************************************
+  * @file           : sim_stress.c
+  * @brief          : Bus-stress generator control and receiver check
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * -G load[,burst[,flags]]@seconds adds a node that starts the generator at
+  * that time (STRESS_IDS, then STRESS_START with the given STRESS_START
+  * flags) and asks for STRESS_STATUS SIM_STRESS_STATUS_US before the end of
+  * the run. Identifiers are 16 standard ones from 0x100, or 256 extended
+  * ones with STRESS_RANDOM_ID; DLCs run from 4 to 8, or 2 to 8 at random
+  * with STRESS_RANDOM_DLC.
+  *
+  * Every generator frame on the bus is checked as a receiver would: the
+  * sequence numbers must follow each other without a gap other than frames
+  * whose mailbox lost arbitration (canStats.txFailed), the time stamp
+  * must be at least the frame's own length on the wire before its end, and
+  * the length Stress_FrameBits() charged must equal the bus model's. The
+  * report gives the load the generator frames took, the latency from the
+  * time stamp to the end of the frame and the bursts as seen on the wire
+  * (frames ending one frame time apart), and checks the load within
+  * SIM_STRESS_LOAD_TOL percentage points of the target (95 % or more at
+  * 100 %), the mean burst length where the idle gaps between bursts should
+  * last a SysTick period or more, the STRESS_STATUS response unless a
+  * mailbox was lost after the request, and that no A1 frame was sent
+  * meanwhile. At 100 % the standard identifiers win every
+  * arbitration against the command, so STRESS_STATUS is only checked with
+  * the extended ones, which rank below it. A failed check makes the run exit with
+  * status 1.
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "boot.h"
+#include "scheduler.h"
+#include "stress.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_STRESS_ADDRESS      0x83U
+#define SIM_STRESS_STATUS_US    200000U   /* STRESS_STATUS before the end */
+#define SIM_STRESS_SETTLE_US    10000U    /* A1 frames queued before START may follow */
+#define SIM_STRESS_LOAD_TOL     2U        /* percentage points */
+#define SIM_STRESS_LATENCY_MAX  10000U    /* us, far beyond a few frames */
+#define SIM_STRESS_GAP_MIN_US   1000U     /* SysTick: shorter gaps may vanish */
+#define SIM_STRESS_STD_FIRST    0x100UL
+#define SIM_STRESS_STD_COUNT    16U
+#define SIM_STRESS_EXT_FIRST    (CAN_FRAME_EXT | 0x18FF1000UL)
+#define SIM_STRESS_EXT_COUNT    256U
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t load;
+static uint32_t burst = 1U;
+static uint32_t flags;
+static uint64_t startAtUs;
+static uint32_t firstId;
+static uint32_t idCount;
+
+static int started;                       /* STRESS_START answered OK */
+static uint64_t startedUs;
+static uint32_t responses;                /* OK responses to this node */
+static uint32_t refused;
+static int statusSeen;
+static uint32_t statusFrames;             /* from STRESS_STATUS */
+static uint32_t statusLoad;
+static uint32_t seenAtStatus;             /* frames seen when it was answered */
+static int statusAsked;                   /* STRESS_STATUS went out on the bus */
+static uint32_t failedAtAsk;              /* canStats.txFailed then */
+
+static uint32_t frames;
+static uint16_t expected;
+static uint32_t gaps;
+static uint32_t lost;                     /* missing after lost arbitrations */
+static uint32_t failedSeen;               /* canStats.txFailed at the last frame */
+static uint32_t lengthErrors;
+static uint32_t stampErrors;
+static uint64_t bits;
+static uint64_t firstUs;
+static uint64_t lastUs;
+static uint64_t latencySum;
+static uint32_t latencyMin = UINT32_MAX;
+static uint32_t latencyMax;
+static uint32_t groups;                   /* back-to-back runs on the wire */
+static uint32_t a1Frames;
+
+static uint32_t failures;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  fprintf(stderr, "sim: stress: %s\n", what);
+  failures++;
+}
+
+static void sendCommand(const uint8_t *data, uint64_t readyUs)
+{
+  CAN_Frame command;
+
+  memset(&command, 0xFF, sizeof(command));
+  command.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, SIM_STRESS_ADDRESS);
+  command.dlc = 8;
+  memcpy(command.data, data, 8U);
+  if (SimCan_Inject(&command, readyUs, SIM_CAN_ORIGIN_MODEL) != 0)
+  {
+    fprintf(stderr, "sim: stress: command not queued\n");
+    exit(2);
+  }
+}
+
+static uint64_t wireUs(const CAN_Frame *frame)
+{
+  uint64_t bitrate = SimCan_Bitrate();
+
+  return (((uint64_t)SimCan_FrameBits(frame) * 1000000ULL) + bitrate - 1U) / bitrate;
+}
+
+/* Idle time between bursts at the target load, from the mean frame seen */
+static uint64_t gapUs(void)
+{
+  if ((frames == 0U) || (load >= 100U))
+  {
+    return 0;
+  }
+  return (bits * 1000000ULL * burst * (100U - load)) / ((uint64_t)frames * SimCan_Bitrate() * load);
+}
+
+static void onResponse(const CAN_Frame *frame, uint64_t timeUs)
+{
+  uint8_t command = frame->data[0] & (uint8_t)~BOOT_RSP;
+
+  if (frame->data[1] != BOOT_OK)
+  {
+    refused++;
+    return;
+  }
+  responses++;
+  if (command == STRESS_CMD_START)
+  {
+    started = 1;
+    startedUs = timeUs;
+  }
+  else if (command == STRESS_CMD_STATUS)
+  {
+    statusSeen = 1;
+    statusFrames = frame->data[3] | ((uint32_t)frame->data[4] << 8) |
+                   ((uint32_t)frame->data[5] << 16) | ((uint32_t)frame->data[6] << 24);
+    statusLoad = frame->data[7];
+    seenAtStatus = frames;
+  }
+}
+
+static void onStressFrame(const CAN_Frame *frame, uint64_t timeUs)
+{
+  uint32_t length = SimCan_FrameBits(frame);
+
+  if (Stress_FrameBits(frame) != length)
+  {
+    lengthErrors++;
+  }
+  if (frame->dlc >= 2U)
+  {
+    uint16_t sequence = (uint16_t)(frame->data[0] | ((uint16_t)frame->data[1] << 8));
+
+    if (sequence != expected)
+    {
+      /* AutoRetransmission is off: frames that lost arbitration are gone */
+      uint16_t missing = (uint16_t)(sequence - expected);
+
+      if (missing <= (canStats.txFailed - failedSeen))
+      {
+        lost += missing;
+      }
+      else
+      {
+        gaps++;
+      }
+    }
+    expected = (uint16_t)(sequence + 1U);
+  }
+  else
+  {
+    expected++;
+  }
+  if (frame->dlc >= STRESS_HEADER_SIZE)
+  {
+    /* The tap runs at the end of the frame, the node's clock is current */
+    uint32_t latency = (uint16_t)(Scheduler_Micros() - (frame->data[2] | ((uint32_t)frame->data[3] << 8)));
+
+    if ((latency < wireUs(frame) - 1U) || (latency > SIM_STRESS_LATENCY_MAX))
+    {
+      stampErrors++;
+    }
+    latencySum += latency;
+    latencyMin = (latency < latencyMin) ? latency : latencyMin;
+    latencyMax = (latency > latencyMax) ? latency : latencyMax;
+  }
+
+  if ((frames == 0U) || ((timeUs - lastUs) != wireUs(frame)))
+  {
+    groups++;
+  }
+  if (frames == 0U)
+  {
+    /* The load counts from the start of the first frame */
+    firstUs = timeUs - wireUs(frame);
+  }
+  lastUs = timeUs;
+  bits += length;
+  frames++;
+  failedSeen = canStats.txFailed;
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  (void)ctx;
+
+  if ((origin == SIM_CAN_ORIGIN_MODEL) && ((frame->id & CAN_FRAME_EXT) != 0U) &&
+      (BOOT_ID_PGN(id) == BOOT_PGN_CMD) && (BOOT_ID_SA(id) == SIM_STRESS_ADDRESS) &&
+      (frame->data[0] == STRESS_CMD_STATUS))
+  {
+    statusAsked = 1;
+    failedAtAsk = canStats.txFailed;
+  }
+  if (origin != SIM_CAN_ORIGIN_NODE)
+  {
+    return;
+  }
+  if (((frame->id & CAN_FRAME_EXT) != 0U) && (BOOT_ID_PGN(id) == BOOT_PGN_CMD) &&
+      (BOOT_ID_DA(id) == SIM_STRESS_ADDRESS) && ((frame->data[0] & BOOT_RSP) != 0U))
+  {
+    onResponse(frame, timeUs);
+    return;
+  }
+  if (!started)
+  {
+    return;
+  }
+  if (((frame->id & CAN_FRAME_EXT) == (firstId & CAN_FRAME_EXT)) &&
+      ((id - (firstId & CAN_FRAME_ID_MASK)) < idCount))
+  {
+    onStressFrame(frame, timeUs);
+  }
+  else if ((frame->id == 0x0A1U) && (timeUs > startedUs + SIM_STRESS_SETTLE_US))
+  {
+    a1Frames++;
+  }
+}
+
+static uint32_t achievedPercent(void)
+{
+  uint64_t span = lastUs - firstUs;
+
+  return (span == 0U) ? 0U : (uint32_t)(((bits * 1000000000ULL) / ((uint64_t)SimCan_Bitrate() * span) + 5U) / 10U);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Parses -G and queues the commands; call after Sim_Cfg is set
+  * @retval None
+  */
+void SimStress_Init(void)
+{
+  uint8_t ids[8];
+  uint8_t start[8] = { STRESS_CMD_START, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF };
+  uint8_t status[8] = { STRESS_CMD_STATUS, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+  const char *at;
+  char *end;
+
+  if (Sim_Cfg.stressSpec == NULL)
+  {
+    return;
+  }
+  at = strchr(Sim_Cfg.stressSpec, '@');
+  load = (uint32_t)strtoul(Sim_Cfg.stressSpec, &end, 0);
+  if (*end == ',')
+  {
+    burst = (uint32_t)strtoul(end + 1, &end, 0);
+  }
+  if (*end == ',')
+  {
+    flags = (uint32_t)strtoul(end + 1, &end, 0);
+  }
+  if ((load == 0U) || (load > 100U) || (burst == 0U) || (burst > 255U) || (flags > 0x0FU) ||
+      ((flags & STRESS_PATTERN_MASK) > STRESS_PATTERN_STUFF) || ((*end != '@') && (*end != '\0')))
+  {
+    fprintf(stderr, "sim: -G %s: load 1..100 %%, burst 1..255, STRESS_START flags\n", Sim_Cfg.stressSpec);
+    exit(2);
+  }
+  startAtUs = (at != NULL) ? (uint64_t)(strtod(at + 1, NULL) * 1e6) : 0U;
+  if ((Sim_Cfg.durationUs != 0U) && (Sim_Cfg.durationUs < startAtUs + 2U * SIM_STRESS_STATUS_US))
+  {
+    fprintf(stderr, "sim: -G %s: starts too close to the end of the run\n", Sim_Cfg.stressSpec);
+    exit(2);
+  }
+
+  firstId = ((flags & STRESS_RANDOM_ID) != 0U) ? SIM_STRESS_EXT_FIRST : SIM_STRESS_STD_FIRST;
+  idCount = ((flags & STRESS_RANDOM_ID) != 0U) ? SIM_STRESS_EXT_COUNT : SIM_STRESS_STD_COUNT;
+  ids[0] = STRESS_CMD_IDS;
+  ids[1] = (uint8_t)firstId;
+  ids[2] = (uint8_t)(firstId >> 8);
+  ids[3] = (uint8_t)(firstId >> 16);
+  ids[4] = (uint8_t)(firstId >> 24);
+  ids[5] = (uint8_t)idCount;
+  ids[6] = (uint8_t)(idCount >> 8);
+  ids[7] = (uint8_t)(idCount >> 16);
+  start[1] = (uint8_t)load;
+  start[2] = (uint8_t)burst;
+  start[3] = (uint8_t)flags;
+  start[4] = ((flags & STRESS_RANDOM_DLC) != 0U) ? 0x28U : 0x48U;
+
+  sendCommand(ids, startAtUs);
+  sendCommand(start, startAtUs);
+  if (Sim_Cfg.durationUs != 0U)
+  {
+    sendCommand(status, Sim_Cfg.durationUs - SIM_STRESS_STATUS_US);
+  }
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Checks the generator frames seen against -G
+  * @retval 1 if a check failed
+  */
+int SimStress_Close(void)
+{
+  uint32_t achieved = achievedPercent();
+
+  if (Sim_Cfg.stressSpec == NULL)
+  {
+    return 0;
+  }
+  if (!started || (refused != 0U))
+  {
+    fail("STRESS_IDS or STRESS_START refused");
+    return 1;
+  }
+  if (frames == 0U)
+  {
+    fail("no generator frames");
+    return 1;
+  }
+  if (gaps != 0U)
+  {
+    fail("sequence numbers missing or out of order");
+  }
+  if (lengthErrors != 0U)
+  {
+    fail("Stress_FrameBits() differs from the bus model");
+  }
+  if (stampErrors != 0U)
+  {
+    fail("time stamp later than the start of the frame, or stale");
+  }
+  if ((load == 100U) ? (achieved < 95U) :
+      ((achieved + SIM_STRESS_LOAD_TOL < load) || (achieved > load + SIM_STRESS_LOAD_TOL)))
+  {
+    fail("load off target");
+  }
+  if ((burst > 1U) && (gapUs() >= SIM_STRESS_GAP_MIN_US) &&
+      (((frames * 4U) < (groups * burst * 3U)) || ((frames * 4U) > (groups * burst * 5U))))
+  {
+    fail("bursts on the wire differ from the burst size");
+  }
+  if (a1Frames != 0U)
+  {
+    fail("A1 frames sent while the generator ran");
+  }
+  if ((Sim_Cfg.durationUs != 0U) && ((load < 100U) || ((flags & STRESS_RANDOM_ID) != 0U)) &&
+      !(!statusSeen && statusAsked && (canStats.txFailed != failedAtAsk)) &&
+      (!statusSeen || (statusFrames < seenAtStatus) || (statusFrames > seenAtStatus + lost + 3U) ||
+       (statusLoad + SIM_STRESS_LOAD_TOL < ((load == 100U) ? 95U : load)) || (statusLoad > load + SIM_STRESS_LOAD_TOL)))
+  {
+    fail("STRESS_STATUS missing or off");
+  }
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints what the receiver saw
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimStress_Report(FILE *out, double seconds)
+{
+  (void)seconds;
+  if (Sim_Cfg.stressSpec == NULL)
+  {
+    return;
+  }
+  fprintf(out, "===== Bus stress =====\n");
+  fprintf(out, "  target       %10lu %%, burst %lu, flags 0x%02lX, %lu %s ids from 0x%lX\n",
+          (unsigned long)load, (unsigned long)burst, (unsigned long)flags, (unsigned long)idCount,
+          ((firstId & CAN_FRAME_EXT) != 0U) ? "extended" : "standard", (unsigned long)(firstId & CAN_FRAME_ID_MASK));
+  fprintf(out, "  frames       %10lu in %.3f s, load %lu %%, %lu bursts of %.1f on the wire\n",
+          (unsigned long)frames, (double)(lastUs - firstUs) / 1e6, (unsigned long)achievedPercent(),
+          (unsigned long)groups, (groups != 0U) ? (double)frames / groups : 0.0);
+  fprintf(out, "  node         %10lu loaded, %lu bursts, %lu clipped\n", (unsigned long)stressStats.frames,
+          (unsigned long)stressStats.bursts, (unsigned long)stressStats.clipped);
+  if (frames != 0U)
+  {
+    fprintf(out, "  latency      %10lu us min, %.1f avg, %lu max\n", (unsigned long)latencyMin,
+            (double)latencySum / frames, (unsigned long)latencyMax);
+  }
+  fprintf(out, "  receiver     %10lu gaps, %lu length, %lu stamp errors, %lu A1 frames\n",
+          (unsigned long)gaps, (unsigned long)lengthErrors, (unsigned long)stampErrors, (unsigned long)a1Frames);
+  if (lost != 0U)
+  {
+    fprintf(out, "  lost         %10lu frames to arbitration, not retried\n", (unsigned long)lost);
+  }
+  if (statusSeen)
+  {
+    fprintf(out, "  status       %10lu frames (%lu seen), load %lu %%\n", (unsigned long)statusFrames,
+            (unsigned long)seenAtStatus, (unsigned long)statusLoad);
+  }
+  fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+}
@@ -0,0 +1,589 @@
+/**
+  ******************************************************************************
+  * @file           : sim_trend.c
+  * @brief          : Temperature trend check against a least-squares fit in
+  *                   double and the modelled ramp
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Always on. The bus tap keeps the temperatures of the last
+  * TREND_WINDOW_MAX T1 frames (PGN 130312) with their SIDs, and checks
+  * every trend message (PGN 65283) that follows one:
+  *
+  *   - its SID is the T1 frame's, and its sample count goes up by one per
+  *     T1 frame to PARAM_TREND_WINDOW; back to one only after the window,
+  *     the T1 period or the offset has changed
+  *   - its slope, fitted value, target and time to the threshold are those
+  *     of a least-squares fit in double over the same T1 values, within
+  *     the rounding of the message
+  *
+  * On a ramp (-r) with the IIR off, the slope of a full window also has to
+  * be the model's within what the worst case of the T1 errors allows: half
+  * a code of rounding, the peak noise (-n) and 0.01 K, through the weights
+  * of the fit. When an alarm message (PGN 65282) is raised, every earlier
+  * prediction of that threshold made at least SIM_TREND_LEAD_US ahead has
+  * to be within the same bound, plus the code past the threshold the
+  * analog watchdog waits for and a T1 period. A window that T1 frames
+  * missing from the bus (silent mode, a full TX queue) make uncheckable
+  * is only counted.
+  *
+  * -w window@seconds sends an ISO Request for PGN 65283 at that time and
+  * then PARAM_TREND_WINDOW as a PARAM_SET command. A failed check makes the
+  * run exit with status 1.
+  */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "alarm.h"
+#include "boot.h"
+#include "can.h"
+#include "filter.h"
+#include "nmea.h"
+#include "params.h"
+#include "trend.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_TREND_ADDRESS       0x88U
+#define SIM_T1_PGN              130312UL
+#define SIM_TREND_LEAD_US       10000000ULL   /* predictions checked against alarms */
+#define SIM_TREND_PREDICTIONS   4096U
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uint64_t madeUs;
+  uint64_t atUs;          /* predicted threshold crossing */
+  uint8_t target;
+} SimTrend_Prediction;
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t setWindow;                /* -w */
+static uint64_t setAtUs;
+
+static uint16_t t1Values[TREND_WINDOW_MAX];   /* ring, by T1 frame */
+static uint8_t t1Sids[TREND_WINDOW_MAX];
+static uint32_t t1Frames;
+static int t1Fresh;                       /* a T1 frame since the last trend message */
+
+static uint32_t params[3];                /* window, T1 period, offset of the window */
+static uint32_t t1Params[3];              /* the same as the last T1 frame went out */
+static int changed;                       /* since the window started */
+static int started;
+static uint32_t expected;                 /* samples */
+static uint8_t lastSid;
+
+static uint32_t messages;
+static uint32_t requests;
+static uint32_t restarts;
+static uint32_t unchecked;
+static int32_t lastSlope = TREND_SLOPE_NA;
+
+static double slopeSquares;               /* against the model, K/min */
+static double slopeErrMax;
+static double slopeBound;
+static uint32_t slopeCounted;
+
+static SimTrend_Prediction predictions[SIM_TREND_PREDICTIONS];
+static uint32_t predicted;
+static uint32_t alarmsChecked;
+static double predictionErrMax;           /* s */
+static double predictionLast;
+static double predictionLead;
+static double predictionBound;
+
+static uint32_t failures;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  if (failures == 0U)
+  {
+    fprintf(stderr, "sim: trend: %s at %.6f s\n", what, (double)Sim_NowUs / 1e6);
+  }
+  failures++;
+}
+
+static void inject(const CAN_Frame *frame, uint64_t timeUs)
+{
+  if (SimCan_Inject(frame, timeUs, SIM_CAN_ORIGIN_MODEL) != 0)
+  {
+    fprintf(stderr, "sim: trend: cannot queue a command\n");
+    exit(2);
+  }
+}
+
+static void sendRequest(uint64_t timeUs)
+{
+  CAN_Frame request;
+
+  memset(&request, 0xFF, sizeof(request));
+  request.id = CAN_FRAME_EXT | BOOT_CAN_ID(NMEA_PRIO_ISO, NMEA_PGN_ISO_REQUEST, BOOT_NODE_ADDRESS,
+                                           SIM_TREND_ADDRESS);
+  request.dlc = 3;
+  request.data[0] = (uint8_t)TREND_PGN;
+  request.data[1] = (uint8_t)(TREND_PGN >> 8);
+  request.data[2] = (uint8_t)(TREND_PGN >> 16);
+  inject(&request, timeUs);
+}
+
+static void sendParam(uint16_t key, uint32_t value, uint64_t timeUs)
+{
+  CAN_Frame set;
+
+  memset(&set, 0xFF, sizeof(set));
+  set.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, SIM_TREND_ADDRESS);
+  set.dlc = 8;
+  set.data[0] = PARAMS_CMD_SET;
+  set.data[1] = (uint8_t)key;
+  set.data[2] = (uint8_t)(key >> 8);
+  set.data[3] = (uint8_t)value;
+  set.data[4] = (uint8_t)(value >> 8);
+  set.data[5] = (uint8_t)(value >> 16);
+  set.data[6] = (uint8_t)(value >> 24);
+  inject(&set, timeUs);
+}
+
+/* Degrees per code, magnitude */
+static double codeC(void)
+{
+  return 80.0 / fabs((double)Sim_Cfg.cal110 - (double)Sim_Cfg.cal30);
+}
+
+/* Worst-case error of one T1 value against the model, degC */
+static double valueBound(void)
+{
+  return (0.5 + Sim_Cfg.noiseLsb) * codeC() + 0.01;
+}
+
+/* Sums of the magnitudes of the fit's weights for n samples: of the slope
+ * per sample and of the fitted value at the newest */
+static void weights(uint32_t n, double *slope, double *fitted)
+{
+  double mean = ((double)n - 1.0) / 2.0;
+  double sxx = (double)n * ((double)n * (double)n - 1.0) / 12.0;
+  uint32_t i;
+
+  *slope = 0.0;
+  *fitted = 0.0;
+  for (i = 0; i < n; i++)
+  {
+    *slope += fabs((double)i - mean) / sxx;
+    *fitted += fabs((1.0 / (double)n) + ((double)i - mean) * ((double)n - 1.0 - mean) / sxx);
+  }
+}
+
+/* The last n T1 values came in one after another */
+static int consecutive(uint32_t n)
+{
+  uint32_t i;
+
+  for (i = 1; i < n; i++)
+  {
+    uint8_t newer = t1Sids[(t1Frames - i) % TREND_WINDOW_MAX];
+    uint8_t older = t1Sids[(t1Frames - i - 1U) % TREND_WINDOW_MAX];
+
+    if ((uint8_t)(older + 1U) != newer)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Least squares over the last n T1 values, places 0 (oldest) to n - 1:
+ * slope per sample and fitted value at the newest, 0.01 K */
+static void fit(uint32_t n, double *slope, double *fitted)
+{
+  double sy = 0.0;
+  double sxy = 0.0;
+  double sx = (double)n * ((double)n - 1.0) / 2.0;
+  double d = (double)n * (double)n * ((double)n * (double)n - 1.0) / 12.0;
+  uint32_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    double y = t1Values[(t1Frames - n + i) % TREND_WINDOW_MAX];
+
+    sy += y;
+    sxy += (double)i * y;
+  }
+  /* Integers below 2^53, exact */
+  *slope = ((double)n * sxy - sx * sy) / d;
+  *fitted = (sy - *slope * sx) / (double)n + *slope * ((double)n - 1.0);
+}
+
+static void checkMessage(const uint8_t *data, int request)
+{
+  uint32_t n = data[1];
+  int32_t slope = (int16_t)(data[2] | ((uint16_t)data[3] << 8));
+  uint32_t seconds = data[4] | ((uint32_t)data[5] << 8);
+  uint8_t target = data[6];
+  int32_t high = (int32_t)Params_Get(PARAM_ALARM_HIGH) * 10 + 27315;
+  int32_t low = (int32_t)Params_Get(PARAM_ALARM_LOW) * 10 + 27315;
+  double refSlope;
+  double refFitted;
+  double perMinute;
+  double refSeconds;
+  uint8_t refTarget;
+
+  if (n < 2U)
+  {
+    if ((slope != TREND_SLOPE_NA) || (target != TREND_TARGET_NONE) || (seconds != TREND_TIME_NA))
+    {
+      fail("trend message without a slope not marked so");
+    }
+    return;
+  }
+  if ((n > t1Frames) || !consecutive(n))
+  {
+    unchecked++;
+    return;
+  }
+
+  fit(n, &refSlope, &refFitted);
+  perMinute = refSlope * 600000.0 / (double)params[1];
+  if (fabs(perMinute) > (double)TREND_SLOPE_MAX)
+  {
+    if ((abs(slope) != TREND_SLOPE_MAX) || ((data[7] & TREND_FLAG_CLAMPED) == 0U))
+    {
+      fail("saturated slope not marked so");
+    }
+  }
+  else if ((fabs((double)slope - perMinute) > 0.5 + 1e-6) || ((data[7] & TREND_FLAG_CLAMPED) != 0U))
+  {
+    fail("slope differs from the least-squares fit");
+  }
+  if (((data[7] & TREND_FLAG_FULL) != 0U) != (n == params[0]))
+  {
+    fail("full-window flag wrong");
+  }
+
+  refTarget = ((refSlope == 0.0) || (low >= high)) ? TREND_TARGET_NONE :
+              ((refSlope > 0.0) ? TREND_TARGET_HIGH : TREND_TARGET_LOW);
+  if (target != refTarget)
+  {
+    fail("trend target differs from the fit's direction");
+    return;
+  }
+  if (refTarget == TREND_TARGET_NONE)
+  {
+    if (seconds != TREND_TIME_NA)
+    {
+      fail("time to a threshold without a target");
+    }
+    return;
+  }
+  refSeconds = ((double)((refTarget == TREND_TARGET_HIGH) ? high : low) - refFitted) /
+               (refSlope * 1000.0 / (double)params[1]);
+  refSeconds = (refSeconds < 0.0) ? 0.0 : refSeconds;
+  if (refSeconds > (double)TREND_TIME_MAX + 0.5 + 1e-6)
+  {
+    if (seconds != TREND_TIME_OVER)
+    {
+      fail("time beyond the range not marked so");
+    }
+  }
+  else if ((seconds > TREND_TIME_MAX) || (fabs((double)seconds - refSeconds) > 0.5 + 1e-6))
+  {
+    fail("time to the threshold differs from the fit");
+  }
+
+  if (!request && (n == params[0]) && (seconds <= TREND_TIME_MAX) && (predicted < SIM_TREND_PREDICTIONS))
+  {
+    predictions[predicted].madeUs = Sim_NowUs;
+    predictions[predicted].atUs = Sim_NowUs + (uint64_t)seconds * 1000000ULL;
+    predictions[predicted].target = target;
+    predicted++;
+  }
+}
+
+/* Slope of a full window against the modelled ramp */
+static void checkModel(int32_t slope)
+{
+  double ws;
+  double wf;
+  double err;
+
+  if ((Sim_Cfg.rampCPerMin == 0.0) || (slope == TREND_SLOPE_NA) ||
+      (Params_Get(PARAM_FILTER_MODE) == FILTER_MODE_IIR))
+  {
+    return;
+  }
+  weights(params[0], &ws, &wf);
+  slopeBound = ws * valueBound() * 60000.0 / (double)params[1] + 0.0005;
+  err = (double)slope / 1000.0 - Sim_Cfg.rampCPerMin;
+  slopeErrMax = (fabs(err) > slopeErrMax) ? fabs(err) : slopeErrMax;
+  slopeSquares += err * err;
+  slopeCounted++;
+  if (fabs(err) > slopeBound)
+  {
+    fail("slope off the modelled ramp by more than the T1 errors allow");
+  }
+}
+
+/* Predictions of the threshold an alarm has just crossed */
+static void checkAlarm(uint8_t state, uint64_t timeUs)
+{
+  double ws;
+  double wf;
+  double rate = fabs(Sim_Cfg.rampCPerMin) / 60.0;
+  double periodS = (double)params[1] / 1000.0;
+  uint32_t i;
+
+  if ((rate == 0.0) || (Params_Get(PARAM_FILTER_MODE) == FILTER_MODE_IIR))
+  {
+    predicted = 0;
+    return;
+  }
+  weights(params[0], &ws, &wf);
+  for (i = 0; i < predicted; i++)
+  {
+    double lead = (double)(timeUs - predictions[i].madeUs) / 1e6;
+    double ahead = (double)(predictions[i].atUs - predictions[i].madeUs) / 1e6;
+    double err = ((double)predictions[i].atUs - (double)timeUs) / 1e6;
+    double bound;
+
+    if ((predictions[i].target != state) || ((timeUs - predictions[i].madeUs) < SIM_TREND_LEAD_US))
+    {
+      continue;
+    }
+    /* Fitted value and slope errors over the time predicted (the line is
+     * off the ramp by both where it reaches the threshold), the code past
+     * the threshold and its rounding, the conversion only once a period */
+    bound = (wf * valueBound() + (ahead / periodS) * ws * valueBound() + 1.5 * codeC()) / rate + periodS + 1.0;
+    /* The bound reported is that of the worst prediction */
+    if (fabs(err) >= predictionErrMax)
+    {
+      predictionErrMax = fabs(err);
+      predictionBound = bound;
+    }
+    predictionLast = err;
+    predictionLead = lead;
+    alarmsChecked++;
+    if (fabs(err) > bound)
+    {
+      fail("threshold crossing off the prediction by more than the T1 errors allow");
+    }
+  }
+  predicted = 0;
+}
+
+static void readParams(uint32_t *now)
+{
+  now[0] = Params_Get(PARAM_TREND_WINDOW);
+  now[1] = Params_Get(PARAM_T1_PERIOD_MS);
+  now[2] = Params_Get(PARAM_TEMP_OFFSET);
+}
+
+static void onTrend(const CAN_Frame *frame)
+{
+  int request = (frame->data[7] & TREND_FLAG_REQUEST) != 0U;
+  uint32_t n = frame->data[1];
+  uint32_t now[3];
+
+  messages++;
+  readParams(now);
+  if (!started || (memcmp(now, params, sizeof(now)) != 0) || (memcmp(t1Params, params, sizeof(params)) != 0))
+  {
+    changed = 1;
+  }
+
+  if (request)
+  {
+    requests++;
+    if (changed && (n == 0U))
+    {
+      memcpy(params, now, sizeof(params));
+      changed = 0;
+      started = 1;
+      expected = 0;
+      restarts++;
+    }
+  }
+  else
+  {
+    if (!t1Fresh || (frame->data[0] != lastSid))
+    {
+      /* The T1 frame before it never made it to the bus */
+      unchecked++;
+      t1Fresh = 0;
+      return;
+    }
+    t1Fresh = 0;
+    if (changed && (n == 1U))
+    {
+      /* The firmware took them in the T1 task; a PARAM_SET may have been
+       * taken since, ahead of this frame on the bus */
+      memcpy(params, t1Params, sizeof(params));
+      changed = 0;
+      started = 1;
+      expected = 0;
+      restarts++;
+    }
+    if (!started)
+    {
+      unchecked++;
+      return;
+    }
+    if (consecutive(2U) || (expected == 0U))
+    {
+      expected = (expected < params[0]) ? (expected + 1U) : params[0];
+    }
+    else
+    {
+      /* T1 frames lost in between: the count is the firmware's */
+      expected = (n <= params[0]) ? n : params[0];
+    }
+  }
+  if (!started)
+  {
+    unchecked++;
+    return;
+  }
+  if (n != expected)
+  {
+    fail("trend sample count wrong");
+    expected = n;
+    return;
+  }
+
+  checkMessage(frame->data, request);
+  if (!request)
+  {
+    lastSlope = (int16_t)(frame->data[2] | ((uint16_t)frame->data[3] << 8));
+    if (n == params[0])
+    {
+      checkModel(lastSlope);
+    }
+  }
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+  uint32_t pgn = (id >> 8) & 0x3FFFFUL;
+
+  (void)ctx;
+  if ((origin != SIM_CAN_ORIGIN_NODE) || ((frame->id & CAN_FRAME_EXT) == 0U))
+  {
+    return;
+  }
+  if ((pgn == SIM_T1_PGN) && (frame->dlc >= 5U))
+  {
+    t1Values[t1Frames % TREND_WINDOW_MAX] = (uint16_t)(frame->data[3] | ((uint16_t)frame->data[4] << 8));
+    t1Sids[t1Frames % TREND_WINDOW_MAX] = frame->data[0];
+    t1Frames++;
+    lastSid = frame->data[0];
+    t1Fresh = 1;
+    readParams(t1Params);
+  }
+  else if ((pgn == TREND_PGN) && (frame->dlc == 8U))
+  {
+    onTrend(frame);
+  }
+  else if ((pgn == ALARM_PGN) && (frame->dlc >= 7U) && ((frame->data[6] & ALARM_FLAG_REQUEST) == 0U) &&
+           (frame->data[0] != ALARM_STATE_NORMAL))
+  {
+    checkAlarm(frame->data[0], timeUs);
+  }
+}
+
+static const char *targetName(uint32_t target)
+{
+  return (target == TREND_TARGET_HIGH) ? "high" : ((target == TREND_TARGET_LOW) ? "low" : "none");
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Parses -w, queues its request and PARAM_SET command and taps the
+  *         bus
+  * @retval None
+  */
+void SimTrend_Init(void)
+{
+  if (Sim_Cfg.trendSpec != NULL)
+  {
+    char *end = NULL;
+
+    setWindow = (uint32_t)strtoul(Sim_Cfg.trendSpec, &end, 0);
+    if ((end == Sim_Cfg.trendSpec) || ((*end != '@') && (*end != '\0')))
+    {
+      fprintf(stderr, "sim: -w %s: window@seconds\n", Sim_Cfg.trendSpec);
+      exit(2);
+    }
+    setAtUs = (*end == '@') ? (uint64_t)(strtod(end + 1, NULL) * 1e6) : 0U;
+    sendRequest(setAtUs);
+    sendParam(PARAM_TREND_WINDOW, setWindow, setAtUs);
+  }
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Checks that trend messages went out and that none went
+  *         unchecked without a reason
+  * @retval 1 if a check failed
+  */
+int SimTrend_Close(void)
+{
+  if ((t1Frames > 1U) && (messages == 0U) && (canStats.txFailed == 0U))
+  {
+    fail("no trend messages");
+  }
+  if ((unchecked > 1U) && (canStats.txSilenced == 0U) && (canStats.txDropped == 0U) && (canStats.txFailed == 0U))
+  {
+    fail("trend messages unchecked without T1 frames lost");
+  }
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints the window, the slope against the model and the
+  *         predictions against the alarms
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimTrend_Report(FILE *out, double seconds)
+{
+  (void)seconds;
+  fprintf(out, "===== Temperature trend =====\n");
+  fprintf(out, "  window       %10lu samples, %lu T1 periods of %lu ms\n", (unsigned long)params[0],
+          (unsigned long)params[0], (unsigned long)params[1]);
+  fprintf(out, "  messages     %10lu, %lu requests, %lu restarts, %lu unchecked\n", (unsigned long)messages,
+          (unsigned long)requests, (unsigned long)restarts, (unsigned long)unchecked);
+  if (lastSlope != TREND_SLOPE_NA)
+  {
+    fprintf(out, "  slope        %10.3f K/min last", (double)lastSlope / 1000.0);
+    if (slopeCounted > 0U)
+    {
+      fprintf(out, ", model %.3f, RMS error %.4f, max %.4f (bound %.4f) over %lu",
+              Sim_Cfg.rampCPerMin, sqrt(slopeSquares / slopeCounted), slopeErrMax, slopeBound,
+              (unsigned long)slopeCounted);
+    }
+    fprintf(out, "\n");
+  }
+  if (alarmsChecked > 0U)
+  {
+    fprintf(out, "  prediction   %10.2f s off from %.0f s ahead, max %.2f s (bound %.2f) over %lu\n",
+            predictionLast, predictionLead, predictionErrMax, predictionBound, (unsigned long)alarmsChecked);
+  }
+  else if (predicted > 0U)
+  {
+    fprintf(out, "  prediction   %10s alarm in %.0f s\n", targetName(predictions[predicted - 1U].target),
+            (double)(predictions[predicted - 1U].atUs - Sim_NowUs) / 1e6);
+  }
+  fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+}
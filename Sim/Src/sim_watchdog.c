@@ -0,0 +1,472 @@
+/**
+  ******************************************************************************
+  * @file           : sim_watchdog.c
+  * @brief          : IWDG model, hang injection and reset cause check
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * The IWDG counts from the LSI at its nominal 40 kHz. The model sees the
+  * last key written before time moves, so the enable and reload keys of
+  * Watchdog_Init() reach it as one: any key starts the counter, 0xAAAA
+  * reloads it. When it expires the run ends as a watchdog reset.
+  *
+  * -W kind@seconds makes the firmware hang at that virtual time:
+  *
+  *   adc     HAL_ADC_PollForConversion() never returns (inside T1)
+  *   rx      the CAN RX0 handler never returns (needs traffic, e.g. -P)
+  *   starve  another node changes the T1 period back and forth every
+  *           SIM_STARVE_PERIOD_US, so T1 is never due and never runs; each
+  *           write is repeated, since in Stop mode the first frame only
+  *           wakes the node
+  *
+  * The report gives the detection latency, from the hang and from the last
+  * refresh, and checks it and the record left in RTC backup register 1
+  * against the kind of hang. It ends with the -Y option that boots the next
+  * run from that reset: -Y csr:bkp1 presets RCC_CSR and the backup register,
+  * and the run checks the RESET_CAUSE frame the node sends at start-up. A
+  * failed check, or a watchdog reset without -W, makes the run exit with
+  * status 1.
+  */
+
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "boot.h"
+#include "params.h"
+#include "watchdog.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_LSI_HZ              40000U
+#define SIM_STARVE_ADDRESS      0x82U
+#define SIM_STARVE_PERIOD_US    500000U   /* half the default T1 period */
+#define SIM_STARVE_AHEAD_US     100000U   /* writes queued ahead of the bus */
+#define SIM_STARVE_REPEAT_US    5000U     /* each write twice: Stop mode loses the first */
+#define SIM_STARVE_T1_MS        1000U     /* alternates with one more */
+#define SIM_T1_PGN              130312UL
+#define SIM_CSR_RESET_FLAGS     0xFF000000UL
+
+/* Private variables ---------------------------------------------------------*/
+extern uint8_t taskT1;                    /* main.c, the T1 task number */
+
+static const char *const kindNames[] = { "none", "adc", "rx", "starve" };
+
+/* Reset flags in the order Watchdog_Init() ranks them */
+static const struct
+{
+  uint32_t flag;
+  uint8_t cause;
+  const char *name;
+} causes[] =
+{
+  { RCC_CSR_LPWRRSTF, WATCHDOG_CAUSE_LOW_POWER,    "low-power" },
+  { RCC_CSR_WWDGRSTF, WATCHDOG_CAUSE_WWDG,         "window watchdog" },
+  { RCC_CSR_IWDGRSTF, WATCHDOG_CAUSE_IWDG,         "watchdog" },
+  { RCC_CSR_SFTRSTF,  WATCHDOG_CAUSE_SOFTWARE,     "software" },
+  { RCC_CSR_PORRSTF,  WATCHDOG_CAUSE_POWER_ON,     "power-on" },
+  { RCC_CSR_OBLRSTF,  WATCHDOG_CAUSE_OPTION_BYTES, "option bytes" },
+  { RCC_CSR_PINRSTF,  WATCHDOG_CAUSE_PIN,          "pin" },
+};
+
+static uint32_t hangKind;
+static uint64_t hangAtUs;
+static uint64_t hungUs = UINT64_MAX;      /* hang started */
+
+static int running;
+static uint64_t deadlineUs = UINT64_MAX;
+static uint64_t timeoutUs;
+static uint64_t lastRefreshUs;
+static uint32_t refreshes;
+static uint64_t resetUs = UINT64_MAX;
+static uint32_t record;                   /* RTC->BKP1R at the reset */
+
+static uint32_t bootCsr = RCC_CSR_PORRSTF | RCC_CSR_PINRSTF;
+static uint32_t bootRecord;
+static int bootChecked;                   /* -Y given */
+static int reportSeen;
+static uint8_t reported[8];
+
+static uint64_t lastT1Us;
+static uint64_t nextStarveUs;
+static uint32_t starveWrites;
+
+static uint32_t failures;
+
+/* Private functions ---------------------------------------------------------*/
+static void fail(const char *what)
+{
+  fprintf(stderr, "sim: watchdog: %s\n", what);
+  failures++;
+}
+
+static uint8_t causeOf(uint32_t csr)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof(causes) / sizeof(causes[0]); i++)
+  {
+    if ((csr & causes[i].flag) != 0U)
+    {
+      return causes[i].cause;
+    }
+  }
+  return WATCHDOG_CAUSE_UNKNOWN;
+}
+
+static const char *causeName(uint8_t cause)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof(causes) / sizeof(causes[0]); i++)
+  {
+    if (causes[i].cause == cause)
+    {
+      return causes[i].name;
+    }
+  }
+  return "unknown";
+}
+
+/* Task number, or its meaning */
+static const char *taskName(uint8_t task, char *buf, size_t size)
+{
+  if (task == WATCHDOG_NONE)
+  {
+    return "none";
+  }
+  snprintf(buf, size, "%u%s", task, (task == taskT1) ? " (T1)" : "");
+  return buf;
+}
+
+/* Takes the key the firmware last wrote */
+static void takeKey(void)
+{
+  uint32_t key = Sim_IWDG.KR;
+
+  if (key == 0U)
+  {
+    return;
+  }
+  Sim_IWDG.KR = 0;
+  if (!running || (key == 0xAAAAU))
+  {
+    running = 1;
+    timeoutUs = ((uint64_t)(Sim_IWDG.RLR + 1U) * (4U << Sim_IWDG.PR) * 1000000U) / SIM_LSI_HZ;
+    deadlineUs = Sim_NowUs + timeoutUs;
+    lastRefreshUs = Sim_NowUs;
+    refreshes++;
+  }
+}
+
+static void sendStarve(uint64_t timeUs)
+{
+  CAN_Frame set;
+
+  while (nextStarveUs <= (timeUs + SIM_STARVE_AHEAD_US))
+  {
+    uint32_t value = SIM_STARVE_T1_MS + ((starveWrites >> 1) & 1U);
+    uint64_t readyUs = nextStarveUs + ((starveWrites & 1U) * SIM_STARVE_REPEAT_US);
+
+    memset(&set, 0xFF, sizeof(set));
+    set.id = CAN_FRAME_EXT | BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, SIM_STARVE_ADDRESS);
+    set.dlc = 8;
+    set.data[0] = PARAMS_CMD_SET;
+    set.data[1] = (uint8_t)PARAM_T1_PERIOD_MS;
+    set.data[2] = 0;
+    set.data[3] = (uint8_t)value;
+    set.data[4] = (uint8_t)(value >> 8);
+    set.data[5] = (uint8_t)(value >> 16);
+    set.data[6] = (uint8_t)(value >> 24);
+    if (SimCan_Inject(&set, readyUs, SIM_CAN_ORIGIN_MODEL) != 0)
+    {
+      return;
+    }
+    if (starveWrites == 0U)
+    {
+      hungUs = readyUs;
+    }
+    if ((starveWrites++ & 1U) != 0U)
+    {
+      nextStarveUs += SIM_STARVE_PERIOD_US;
+    }
+  }
+}
+
+static void busTap(const CAN_Frame *frame, uint64_t timeUs, uint32_t origin, void *ctx)
+{
+  uint32_t id = frame->id & CAN_FRAME_ID_MASK;
+
+  (void)ctx;
+
+  if ((origin == SIM_CAN_ORIGIN_NODE) && ((frame->id & CAN_FRAME_EXT) != 0U))
+  {
+    if (((id >> 8) & 0x3FFFFU) == SIM_T1_PGN)
+    {
+      lastT1Us = timeUs;
+    }
+    else if (!reportSeen && (BOOT_ID_PGN(id) == BOOT_PGN_CMD) && (BOOT_ID_DA(id) == 0xFFU) &&
+             (frame->data[0] == (WATCHDOG_CMD_RESET | BOOT_RSP)))
+    {
+      reportSeen = 1;
+      memcpy(reported, frame->data, sizeof(reported));
+    }
+  }
+  if (hangKind == SIM_HANG_STARVE)
+  {
+    sendStarve(timeUs);
+  }
+}
+
+/* What the node must report for the -Y reset */
+static void checkReport(void)
+{
+  uint8_t cause = causeOf(bootCsr);
+  int valid = (bootRecord >> 24) == WATCHDOG_RECORD_MAGIC;
+  uint32_t resets = valid ? ((bootRecord >> 16) & 0xFFU) : 0U;
+  uint8_t expected[6];
+
+  if ((cause == WATCHDOG_CAUSE_IWDG) && (resets < 0xFFU))
+  {
+    resets++;
+  }
+  expected[0] = WATCHDOG_CMD_RESET | BOOT_RSP;
+  expected[1] = cause;
+  expected[2] = (valid && (cause == WATCHDOG_CAUSE_IWDG)) ? (uint8_t)bootRecord : WATCHDOG_NONE;
+  expected[3] = (valid && (cause == WATCHDOG_CAUSE_IWDG)) ? (uint8_t)(bootRecord >> 8) : WATCHDOG_NONE;
+  expected[4] = (uint8_t)resets;
+  expected[5] = (uint8_t)(bootCsr >> 24);
+
+  if (!reportSeen)
+  {
+    fail("no RESET_CAUSE frame at start-up");
+  }
+  else if (memcmp(reported, expected, sizeof(expected)) != 0)
+  {
+    fail("RESET_CAUSE does not match the -Y reset");
+  }
+}
+
+/* Record and latency the kind of hang must leave */
+static void checkReset(void)
+{
+  uint8_t task = (uint8_t)record;
+  uint8_t starved = (uint8_t)(record >> 8);
+  uint64_t boundUs = timeoutUs;
+
+  if ((record >> 24) != WATCHDOG_RECORD_MAGIC)
+  {
+    fail("no record in the backup register");
+    return;
+  }
+  switch (hangKind)
+  {
+    case SIM_HANG_ADC:
+      if ((task != taskT1) || (starved != WATCHDOG_NONE))
+      {
+        fail("record does not name T1 as running");
+      }
+      break;
+    case SIM_HANG_RX:
+      if (starved != WATCHDOG_NONE)
+      {
+        fail("record names a starved task");
+      }
+      break;
+    default:
+      if (starved != taskT1)
+      {
+        fail("record does not name T1 as starved");
+      }
+      break;
+  }
+
+  /* A starved task is noticed on the first pass after its limit, then the
+   * last refresh runs out */
+  if (hangKind == SIM_HANG_STARVE)
+  {
+    boundUs = (2U * (SIM_STARVE_T1_MS + 1U) + WATCHDOG_GRACE_MS + WATCHDOG_MAX_IDLE_MS) * 1000ULL + timeoutUs;
+    if ((resetUs - lastT1Us) > boundUs)
+    {
+      fail("starved T1 detected too late");
+    }
+  }
+  else if ((hungUs == UINT64_MAX) || ((resetUs - hungUs) > boundUs))
+  {
+    fail("hang detected too late");
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Parses -W and -Y, presets the reset flags and backup register
+  * @retval None
+  */
+void SimWatchdog_Init(void)
+{
+  if (Sim_Cfg.hangSpec != NULL)
+  {
+    const char *at = strchr(Sim_Cfg.hangSpec, '@');
+    size_t len = (at != NULL) ? (size_t)(at - Sim_Cfg.hangSpec) : strlen(Sim_Cfg.hangSpec);
+    uint32_t kind;
+
+    for (kind = SIM_HANG_ADC; kind < sizeof(kindNames) / sizeof(kindNames[0]); kind++)
+    {
+      if ((strlen(kindNames[kind]) == len) && (strncmp(Sim_Cfg.hangSpec, kindNames[kind], len) == 0))
+      {
+        hangKind = kind;
+      }
+    }
+    if (hangKind == SIM_HANG_NONE)
+    {
+      fprintf(stderr, "sim: -W %s: kind is adc, rx or starve\n", Sim_Cfg.hangSpec);
+      exit(2);
+    }
+    hangAtUs = (at != NULL) ? (uint64_t)(strtod(at + 1, NULL) * 1e6) : 0U;
+    nextStarveUs = hangAtUs;
+  }
+  if (Sim_Cfg.resetSpec != NULL)
+  {
+    char *end;
+
+    bootCsr = (uint32_t)strtoul(Sim_Cfg.resetSpec, &end, 0);
+    if (*end != ':')
+    {
+      fprintf(stderr, "sim: -Y %s: expected csr:bkp1\n", Sim_Cfg.resetSpec);
+      exit(2);
+    }
+    bootRecord = (uint32_t)strtoul(end + 1, NULL, 0);
+    bootChecked = 1;
+  }
+  Sim_RCC.CSR = bootCsr & SIM_CSR_RESET_FLAGS;
+  Sim_RTC.BKP1R = bootRecord;
+  SimCan_AddTap(busTap, NULL);
+}
+
+/**
+  * @brief  Checks the reset and the start-up report
+  * @retval 1 if a check failed
+  */
+int SimWatchdog_Close(void)
+{
+  takeKey();
+  if (bootChecked)
+  {
+    checkReport();
+  }
+  if (resetUs != UINT64_MAX)
+  {
+    if (hangKind == SIM_HANG_NONE)
+    {
+      fail("watchdog reset without an injected hang");
+    }
+    else
+    {
+      checkReset();
+    }
+  }
+  else if (hangKind != SIM_HANG_NONE)
+  {
+    fail((hungUs == UINT64_MAX) ? "hang never injected" : "hang not detected");
+  }
+  return failures != 0U;
+}
+
+/**
+  * @brief  Prints the IWDG, the reset cause and the hang detection
+  * @param  out: destination stream
+  * @param  seconds: virtual run time
+  * @retval None
+  */
+void SimWatchdog_Report(FILE *out, double seconds)
+{
+  char task[16];
+  char starved[16];
+
+  (void)seconds;
+  fprintf(out, "===== Watchdog =====\n");
+  fprintf(out, "  IWDG         %10.3f s timeout, %lu refreshes (%lu passes withheld), last at %.3f s\n",
+          (double)timeoutUs / 1e6, (unsigned long)refreshes, (unsigned long)watchdogStats.withheld,
+          (double)lastRefreshUs / 1e6);
+  fprintf(out, "  reset cause  %10s (CSR 0x%08lX), task %s, starved %s, %u watchdog resets%s\n",
+          causeName(watchdogReset.cause), (unsigned long)watchdogReset.csr,
+          taskName(watchdogReset.task, task, sizeof(task)), taskName(watchdogReset.starved, starved, sizeof(starved)),
+          watchdogReset.resets, reportSeen ? ", reported" : "");
+  if (hangKind != SIM_HANG_NONE)
+  {
+    fprintf(out, "  hang         %10s at %.3f s\n", kindNames[hangKind], (double)hungUs / 1e6);
+  }
+  if (resetUs != UINT64_MAX)
+  {
+    fprintf(out, "  reset        %10.3f s", (double)resetUs / 1e6);
+    if (hungUs != UINT64_MAX)
+    {
+      fprintf(out, ", %.3f s after the hang", (double)(resetUs - hungUs) / 1e6);
+    }
+    if (hangKind == SIM_HANG_STARVE)
+    {
+      fprintf(out, ", %.3f s after the last T1 frame", (double)(resetUs - lastT1Us) / 1e6);
+    }
+    fprintf(out, ", %.3f s after the last refresh\n", (double)(resetUs - lastRefreshUs) / 1e6);
+    fprintf(out, "  record       0x%08lX: task %s running, %s starved\n", (unsigned long)record,
+            taskName((uint8_t)record, task, sizeof(task)), taskName((uint8_t)(record >> 8), starved, sizeof(starved)));
+    fprintf(out, "  next boot    -Y 0x%08lX:0x%08lX\n",
+            (unsigned long)(RCC_CSR_IWDGRSTF | RCC_CSR_PINRSTF), (unsigned long)record);
+  }
+  if (bootChecked || (hangKind != SIM_HANG_NONE))
+  {
+    fprintf(out, "  check        %10s\n", (failures == 0U) ? "ok" : "FAILED");
+  }
+}
+
+/**
+  * @brief  Time the IWDG runs out, after taking the last key written
+  * @retval absolute virtual time, UINT64_MAX while it is stopped
+  */
+uint64_t SimWatchdog_NextEventUs(void)
+{
+  takeKey();
+  return deadlineUs;
+}
+
+/**
+  * @brief  Ends the run as a watchdog reset once the IWDG has run out
+  * @param  nowUs: current virtual time
+  * @retval None
+  */
+void SimWatchdog_Process(uint64_t nowUs)
+{
+  takeKey();
+  if (nowUs < deadlineUs)
+  {
+    return;
+  }
+  resetUs = nowUs;
+  record = Sim_RTC.BKP1R;
+  fprintf(stderr, "sim: watchdog reset at %.6f s\n", (double)nowUs / 1e6);
+  Sim_Finish();
+}
+
+/**
+  * @brief  Hang hook for the HAL models
+  * @param  kind: SIM_HANG_ADC or SIM_HANG_RX
+  * @retval 1 if the caller must hang now
+  */
+int SimWatchdog_Hang(uint32_t kind)
+{
+  if ((kind != hangKind) || (Sim_NowUs < hangAtUs) || (hungUs != UINT64_MAX))
+  {
+    return 0;
+  }
+  hungUs = Sim_NowUs;
+  return 1;
+}
@@ -0,0 +1,337 @@
+/**
+  ******************************************************************************
+  * @file           : alarmcodes.c
+  * @brief          : Temperature alarm thresholds as ADC codes, and the
+  *                   codec's exhaustive self-check
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Translates alarm thresholds (Core/Inc/alarm.h) into the raw codes and the
+  * analog watchdog windows the node programs, with the firmware's own codec,
+  * for a given pair of calibration words; the default pair is the
+  * simulator's.
+  *
+  * With -x the codec is checked instead, in integer arithmetic:
+  *
+  *   - for every pair of calibration words, the calibration points map to
+  *     the words themselves, the ends saturate, and a spread of temperatures
+  *     map to the nearest code, clamped to 0..4095
+  *   - for every 4099th pair, every temperature from -55 to 150 degC in
+  *     0.01 degC steps: nearest code, codes monotonic on the rising scale,
+  *     and a round trip through Alarm_CentiC() within half a code
+  *   - equal words turn alarms off
+  *   - for every 4099th pair and a spread of thresholds, hysteresis and
+  *     offsets within the parameter limits: the thresholds are ordered, and
+  *     for every code and state Alarm_Classify() keeps the state exactly
+  *     inside Alarm_Window() and otherwise leaves it as the thresholds say
+  *
+  * Usage: alarmcodes [-a cal30] [-b cal110] [-H high] [-L low] [-y hyst]
+  *                   [-o offset]
+  *        alarmcodes -x
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "alarm.h"
+
+#define CAL30_DEFAULT     1774U     /* the simulator's TS_CAL1, TS_CAL2 */
+#define CAL110_DEFAULT    1348U
+#define PAIR_STRIDE       4099U     /* sampled pairs for the slow checks */
+
+/* Parameter limits, as in Core/Src/params.c */
+#define DECI_MIN          (-550)
+#define DECI_MAX          1500
+#define HYST_MAX          500
+#define OFFSET_LIMIT      1000
+
+static uint32_t failures;
+
+/*-------------------------------- checking ----------------------------------*/
+
+static void fail(const char *what, uint32_t cal30, uint32_t cal110, int32_t value)
+{
+  if (failures < 10U)
+  {
+    fprintf(stderr, "self-check: %s, cal30 %u, cal110 %u, at %ld\n", what, (unsigned)cal30, (unsigned)cal110,
+            (long)value);
+  }
+  failures++;
+}
+
+/* Alarm_Code() is the nearest code to the straight line through the two
+ * calibration points, or the end it is clamped to */
+static int nearest(uint16_t code, int32_t centiC, uint32_t cal30, uint32_t cal110)
+{
+  int64_t exact8000 = (int64_t)cal30 * 8000 + (int64_t)(centiC - 3000) * ((int32_t)cal110 - (int32_t)cal30);
+  int64_t error = (int64_t)code * 8000 - exact8000;
+
+  if (code == 0U)
+  {
+    return exact8000 <= 4000;
+  }
+  if (code == ALARM_CODE_MAX)
+  {
+    return exact8000 >= (int64_t)ALARM_CODE_MAX * 8000 - 4000;
+  }
+  return (error >= -4000) && (error <= 4000);
+}
+
+static void checkPoints(uint32_t cal30, uint32_t cal110)
+{
+  static const int32_t spread[] = { -100000, -27315, -5500, -4000, 0, 2999, 3001, 2500, 8500, 10999, 11001, 15000,
+                                    100000, 2000000, -2000000 };
+  uint16_t hot = Alarm_Code(100000, (uint16_t)cal30, (uint16_t)cal110);
+  uint16_t cold = Alarm_Code(-100000, (uint16_t)cal30, (uint16_t)cal110);
+  uint32_t i;
+
+  if ((Alarm_Code(3000, (uint16_t)cal30, (uint16_t)cal110) != cal30) ||
+      (Alarm_Code(11000, (uint16_t)cal30, (uint16_t)cal110) != cal110))
+  {
+    fail("calibration point", cal30, cal110, 0);
+  }
+  if ((Alarm_Code(2000000, (uint16_t)cal30, (uint16_t)cal110) != hot) ||
+      (Alarm_Code(-2000000, (uint16_t)cal30, (uint16_t)cal110) != cold))
+  {
+    fail("no saturation", cal30, cal110, 0);
+  }
+  for (i = 0; i < sizeof(spread) / sizeof(spread[0]); i++)
+  {
+    int32_t centiC = (spread[i] > 100000) ? 100000 : ((spread[i] < -100000) ? -100000 : spread[i]);
+
+    if (!nearest(Alarm_Code(spread[i], (uint16_t)cal30, (uint16_t)cal110), centiC, cal30, cal110))
+    {
+      fail("not the nearest code", cal30, cal110, spread[i]);
+    }
+  }
+}
+
+static void checkSweep(uint32_t cal30, uint32_t cal110)
+{
+  int32_t diff = (int32_t)cal110 - (int32_t)cal30;
+  int32_t step = 4000 / ((diff < 0) ? -diff : diff) + 1;   /* half a code, 0.01 degC */
+  uint16_t previous = 0;
+  int32_t centiC;
+
+  for (centiC = -5500; centiC <= 15000; centiC++)
+  {
+    uint16_t code = Alarm_Code(centiC, (uint16_t)cal30, (uint16_t)cal110);
+    uint16_t rising = (cal110 < cal30) ? (uint16_t)(ALARM_CODE_MAX - code) : code;
+    int32_t back;
+
+    if (!nearest(code, centiC, cal30, cal110))
+    {
+      fail("not the nearest code", cal30, cal110, centiC);
+    }
+    if ((centiC > -5500) && (rising < previous))
+    {
+      fail("codes not monotonic", cal30, cal110, centiC);
+    }
+    previous = rising;
+    back = Alarm_CentiC(code, (uint16_t)cal30, (uint16_t)cal110) - centiC;
+    if ((code != 0U) && (code != ALARM_CODE_MAX) && ((back > step) || (back < -step)))
+    {
+      fail("round trip beyond half a code", cal30, cal110, centiC);
+    }
+  }
+}
+
+static void checkThresholds(uint32_t cal30, uint32_t cal110, int32_t high, int32_t low, int32_t hyst, int32_t offset)
+{
+  Alarm_Codes codes;
+  uint8_t valid = Alarm_Thresholds(&codes, high, low, hyst, offset, (uint16_t)cal30, (uint16_t)cal110);
+  uint8_t state;
+  uint32_t code;
+
+  if (valid != ((cal30 != cal110) && (low < high)))
+  {
+    fail("validity", cal30, cal110, high);
+    return;
+  }
+  if (!valid)
+  {
+    return;
+  }
+  if ((codes.highClear > codes.high) || (codes.lowClear < codes.low) || (codes.low > codes.high))
+  {
+    fail("thresholds out of order", cal30, cal110, high);
+  }
+  for (state = ALARM_STATE_NORMAL; state <= ALARM_STATE_LOW; state++)
+  {
+    uint16_t lowCode;
+    uint16_t highCode;
+
+    Alarm_Window(&codes, state, &lowCode, &highCode);
+    for (code = 0; code <= ALARM_CODE_MAX; code++)
+    {
+      uint8_t next = Alarm_Classify(&codes, state, (uint16_t)code);
+      uint16_t r = codes.falling ? (uint16_t)(ALARM_CODE_MAX - code) : (uint16_t)code;
+      uint8_t fresh = (r > codes.high) ? ALARM_STATE_HIGH : ((r < codes.low) ? ALARM_STATE_LOW : ALARM_STATE_NORMAL);
+      int inside = (code >= lowCode) && (code <= highCode);
+
+      if ((next == state) != inside)
+      {
+        fail("state kept outside its window, or left inside it", cal30, cal110, (int32_t)code);
+        return;
+      }
+      if (!inside && (next != fresh))
+      {
+        fail("state left to the wrong one", cal30, cal110, (int32_t)code);
+        return;
+      }
+    }
+  }
+}
+
+static int selfCheck(void)
+{
+  static const int32_t highs[] = { DECI_MIN, -400, 0, 300, 850, DECI_MAX };
+  static const int32_t lows[] = { DECI_MIN, -400, 200, 849, DECI_MAX };
+  static const int32_t hysts[] = { 0, 20, HYST_MAX };
+  static const int32_t offsets[] = { -OFFSET_LIMIT, 0, 37, OFFSET_LIMIT };
+  Alarm_Codes codes;
+  uint32_t pairs = 0;
+  uint32_t sampled = 0;
+  uint32_t cal30;
+  uint32_t cal110;
+  uint32_t n = 0;
+
+  for (cal30 = 0; cal30 <= ALARM_CODE_MAX; cal30++)
+  {
+    for (cal110 = 0; cal110 <= ALARM_CODE_MAX; cal110++)
+    {
+      if (cal30 == cal110)
+      {
+        if (Alarm_Thresholds(&codes, 850, -400, 20, 0, (uint16_t)cal30, (uint16_t)cal110) != 0U)
+        {
+          fail("equal calibration words not refused", cal30, cal110, 0);
+        }
+        continue;
+      }
+      pairs++;
+      checkPoints(cal30, cal110);
+      if ((n++ % PAIR_STRIDE) != 0U)
+      {
+        continue;
+      }
+      sampled++;
+      checkSweep(cal30, cal110);
+      checkThresholds(cal30, cal110, highs[sampled % 6U], lows[sampled % 5U], hysts[sampled % 3U],
+                      offsets[sampled % 4U]);
+    }
+    if (failures != 0U)
+    {
+      break;
+    }
+  }
+  if (failures != 0U)
+  {
+    fprintf(stderr, "self-check: %u failures\n", (unsigned)failures);
+    return 1;
+  }
+  printf("self-check passed: %u calibration pairs, %u swept with thresholds\n", (unsigned)pairs, (unsigned)sampled);
+  return 0;
+}
+
+/*-------------------------------- printing ----------------------------------*/
+
+static void printWindow(const char *name, const Alarm_Codes *codes, uint8_t state, uint16_t cal30, uint16_t cal110,
+                        int32_t offset)
+{
+  uint16_t lowCode;
+  uint16_t highCode;
+
+  Alarm_Window(codes, state, &lowCode, &highCode);
+  printf("  %-8s LT1 %4u (%7.2f degC)  HT1 %4u (%7.2f degC)\n", name, (unsigned)lowCode,
+         (double)(Alarm_CentiC(lowCode, cal30, cal110) + offset) / 100.0, (unsigned)highCode,
+         (double)(Alarm_CentiC(highCode, cal30, cal110) + offset) / 100.0);
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-a cal30] [-b cal110] [-H high] [-L low] [-y hyst] [-o offset]\n"
+          "       %s -x\n"
+          "  -a  TS_CAL1, code at 30 degC (default %u)\n"
+          "  -b  TS_CAL2, code at 110 degC (default %u)\n"
+          "  -H  high threshold, 0.1 degC as reported (default 850)\n"
+          "  -L  low threshold, 0.1 degC as reported (default -400)\n"
+          "  -y  hysteresis, 0.1 degC (default 20)\n"
+          "  -o  temperature offset, 0.01 K (default 0)\n"
+          "  -x  check the codec for every pair of calibration words\n",
+          prog, prog, CAL30_DEFAULT, CAL110_DEFAULT);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t cal30 = CAL30_DEFAULT;
+  uint32_t cal110 = CAL110_DEFAULT;
+  int32_t hyst = 20;
+  int32_t offset = 0;
+  int32_t high = 850;
+  int32_t low = -400;
+  Alarm_Codes codes;
+  int check = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "a:b:H:L:y:o:xh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'a': cal30 = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'b': cal110 = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'H': high = (int32_t)strtol(optarg, NULL, 0); break;
+      case 'L': low = (int32_t)strtol(optarg, NULL, 0); break;
+      case 'y': hyst = (int32_t)strtol(optarg, NULL, 0); break;
+      case 'o': offset = (int32_t)strtol(optarg, NULL, 0); break;
+      case 'x': check = 1; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+
+  if (check)
+  {
+    if (optind != argc)
+    {
+      usage(argv[0]);
+      return 2;
+    }
+    return selfCheck();
+  }
+  if ((optind != argc) || (cal30 > ALARM_CODE_MAX) || (cal110 > ALARM_CODE_MAX))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  if (!Alarm_Thresholds(&codes, high, low, hyst, offset, (uint16_t)cal30, (uint16_t)cal110))
+  {
+    printf("alarms off: %s\n", (cal30 == cal110) ? "equal calibration words" :
+           ((low >= high) ? "low threshold not below the high one" : "negative hysteresis"));
+    return 1;
+  }
+  printf("===== Alarm codes, cal30 %u, cal110 %u, offset %.2f K =====\n", (unsigned)cal30, (unsigned)cal110,
+         (double)offset / 100.0);
+  printf("  high     %7.1f degC, code %4u, cleared below %7.1f degC, code %4u\n", (double)high / 10.0,
+         (unsigned)(codes.falling ? ALARM_CODE_MAX - codes.high : codes.high), (double)(high - hyst) / 10.0,
+         (unsigned)(codes.falling ? ALARM_CODE_MAX - codes.highClear : codes.highClear));
+  printf("  low      %7.1f degC, code %4u, cleared above %7.1f degC, code %4u\n", (double)low / 10.0,
+         (unsigned)(codes.falling ? ALARM_CODE_MAX - codes.low : codes.low), (double)(low + hyst) / 10.0,
+         (unsigned)(codes.falling ? ALARM_CODE_MAX - codes.lowClear : codes.lowClear));
+  printWindow("normal", &codes, ALARM_STATE_NORMAL, (uint16_t)cal30, (uint16_t)cal110, offset);
+  printWindow("high", &codes, ALARM_STATE_HIGH, (uint16_t)cal30, (uint16_t)cal110, offset);
+  printWindow("low", &codes, ALARM_STATE_LOW, (uint16_t)cal30, (uint16_t)cal110, offset);
+  return 0;
+}
@@ -0,0 +1,515 @@
+/**
+  ******************************************************************************
+  * @file           : canboot.c
+  * @brief          : Host uploader for the CAN bootloader (SocketCAN)
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Sends an application image (the .bin of a BOOTLOADER=1 build) with the
+  * protocol in Core/Inc/boot.h: PING, START (erase), BLOCK stream, END
+  * (verify) and RUN.
+  *
+  * Blocks are streamed with up to <window> of them unacknowledged, each block
+  * (header plus 128 data frames) handed to the kernel with one sendmmsg().
+  * A NAK or a missing ACK restarts the stream at that block (go-back-N).
+  *
+  * With -p the file is a delta patch from candelta: it is sent with DELTA
+  * instead of START, one block at a time, and the node rebuilds the image
+  * over the installed one.
+  *
+  * Usage: canboot [-i ifname] [-a node] [-s src] [-w window] [-e] [-p] [-q] file
+  */
+
+#define _GNU_SOURCE           /* sendmmsg() */
+#include <errno.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "boot.h"
+
+#define FRAMES_PER_BLOCK    (1U + (BOOT_BLOCK_SIZE / 8U))
+#define MAX_BLOCKS          (BOOT_APP_MAX_SIZE / BOOT_BLOCK_SIZE)
+#define MAX_RETRIES         8U
+#define ACK_TIMEOUT_MS      1000
+#define ERASE_TIMEOUT_MS    10000
+
+static int sock = -1;
+static uint8_t node = BOOT_NODE_ADDRESS;
+static uint8_t src = 0xFEU;
+static int quiet;
+
+static uint8_t image[BOOT_APP_MAX_SIZE];
+static uint32_t imageSize;
+
+static struct can_frame txFrames[FRAMES_PER_BLOCK];
+static struct iovec txIov[FRAMES_PER_BLOCK];
+static struct mmsghdr txMsgs[FRAMES_PER_BLOCK];
+
+static uint64_t nowMs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000U + (uint64_t)ts.tv_nsec / 1000000U;
+}
+
+/* zlib crc32(), matches the bootloader's hardware CRC setup */
+static uint32_t crc32(const uint8_t *data, uint32_t length)
+{
+  static uint32_t table[256];
+  uint32_t crc = 0xFFFFFFFFUL;
+  uint32_t i;
+
+  if (table[1] == 0U)
+  {
+    for (i = 0; i < 256U; i++)
+    {
+      uint32_t c = i;
+      int k;
+
+      for (k = 0; k < 8; k++)
+      {
+        c = (c & 1U) ? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+      }
+      table[i] = c;
+    }
+  }
+  for (i = 0; i < length; i++)
+  {
+    crc = table[(crc ^ data[i]) & 0xFFU] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+static void putLe32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static void fillFrame(struct can_frame *cf, uint32_t prio, uint32_t pgn, const uint8_t *data, uint32_t count)
+{
+  memset(cf, 0, sizeof(*cf));
+  cf->can_id = BOOT_CAN_ID(prio, pgn, node, src) | CAN_EFF_FLAG;
+  cf->can_dlc = 8;
+  memset(cf->data, 0xFF, 8);
+  memcpy(cf->data, data, count);
+}
+
+/* Sends frames in order; the CAN netdev queue is short, so ENOBUFS just means wait */
+static int sendFrames(uint32_t count)
+{
+  uint32_t sent = 0;
+
+  while (sent < count)
+  {
+    int n = sendmmsg(sock, &txMsgs[sent], count - sent, 0);
+
+    if (n < 0)
+    {
+      if ((errno == ENOBUFS) || (errno == EAGAIN) || (errno == EINTR))
+      {
+        struct pollfd pfd = { .fd = sock, .events = POLLOUT, .revents = 0 };
+
+        (void)poll(&pfd, 1, 1);
+        continue;
+      }
+      perror("sendmmsg");
+      return -1;
+    }
+    sent += (uint32_t)n;
+  }
+  return 0;
+}
+
+static int sendCommand(const uint8_t *data, uint32_t count)
+{
+  fillFrame(&txFrames[0], BOOT_PRIO_CMD, BOOT_PGN_CMD, data, count);
+  return sendFrames(1);
+}
+
+static int sendBlock(uint32_t number)
+{
+  uint32_t offset = number * BOOT_BLOCK_SIZE;
+  uint32_t length = ((imageSize - offset) < BOOT_BLOCK_SIZE) ? (imageSize - offset) : BOOT_BLOCK_SIZE;
+  uint8_t header[7] = { BOOT_CMD_BLOCK, (uint8_t)number, (uint8_t)(number >> 8) };
+  uint32_t frames = 1;
+  uint32_t i;
+
+  putLe32(&header[3], crc32(&image[offset], length));
+  fillFrame(&txFrames[0], BOOT_PRIO_CMD, BOOT_PGN_CMD, header, sizeof(header));
+  for (i = 0; i < length; i += 8U)
+  {
+    fillFrame(&txFrames[frames++], BOOT_PRIO_DATA, BOOT_PGN_DATA, &image[offset + i],
+              ((length - i) < 8U) ? (length - i) : 8U);
+  }
+  return sendFrames(frames);
+}
+
+/**
+  * @brief  Waits for a response from the node
+  * @param  cmd: command the response belongs to, 0 for any
+  * @param  timeoutMs: longest wait
+  * @param  rsp: response payload (8 bytes)
+  * @retval 0 on response, -1 on timeout
+  */
+static int waitResponse(uint8_t cmd, int timeoutMs, uint8_t *rsp)
+{
+  uint64_t deadline = nowMs() + (uint64_t)timeoutMs;
+
+  for (;;)
+  {
+    struct pollfd pfd = { .fd = sock, .events = POLLIN, .revents = 0 };
+    struct can_frame cf;
+    uint64_t now = nowMs();
+
+    if (now >= deadline)
+    {
+      return -1;
+    }
+    if (poll(&pfd, 1, (int)(deadline - now)) <= 0)
+    {
+      continue;
+    }
+    if (read(sock, &cf, sizeof(cf)) != (ssize_t)sizeof(cf))
+    {
+      continue;
+    }
+    if ((cf.can_dlc < 2U) || ((cf.data[0] & BOOT_RSP) == 0U) ||
+        ((cmd != 0U) && (cf.data[0] != (cmd | BOOT_RSP))))
+    {
+      continue;
+    }
+    memcpy(rsp, cf.data, 8);
+    return 0;
+  }
+}
+
+static const char *statusName(uint8_t status)
+{
+  static const char *names[] = { "ok", "block crc", "incomplete", "out of range",
+                                 "flash error", "busy", "bad state", "image crc",
+                                 "malformed patch", "installed image is not the patch base",
+                                 "out of sequence" };
+
+  return (status < (sizeof(names) / sizeof(names[0]))) ? names[status] : "unknown";
+}
+
+static void openSocket(const char *ifname)
+{
+  struct sockaddr_can addr;
+  struct ifreq ifr;
+  struct can_filter filter;
+  uint32_t i;
+
+  sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (sock < 0)
+  {
+    perror("socket(PF_CAN)");
+    exit(2);
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+  if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    exit(2);
+  }
+
+  /* Responses only: PGN 0xEF00 from the node, to us or to the global address */
+  filter.can_id = BOOT_CAN_ID(0, BOOT_PGN_CMD, 0, node) | CAN_EFF_FLAG;
+  filter.can_mask = 0x03FF00FFUL | CAN_EFF_FLAG;
+  (void)setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    exit(2);
+  }
+
+  for (i = 0; i < FRAMES_PER_BLOCK; i++)
+  {
+    txIov[i].iov_base = &txFrames[i];
+    txIov[i].iov_len = sizeof(txFrames[i]);
+    txMsgs[i].msg_hdr.msg_iov = &txIov[i];
+    txMsgs[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-i ifname] [-a node] [-s src] [-w window] [-e] [-p] [-q] file\n"
+          "  -i  SocketCAN interface (default can0)\n"
+          "  -a  node address (default 0x%02X)\n"
+          "  -s  our source address (default 0xFE)\n"
+          "  -w  blocks in flight, at most the node's window\n"
+          "  -e  ask the running application to enter the bootloader first\n"
+          "  -p  file is a delta patch from candelta, not an image\n"
+          "  -q  no progress output\n", prog, BOOT_NODE_ADDRESS);
+}
+
+/**
+  * @brief  Streams all blocks, at most <window> of them unacknowledged
+  * @param  window: blocks in flight
+  * @param  ackTimeoutMs: longest wait for a block response
+  * @param  sends: number of blocks sent, retransmissions included
+  * @retval 0 on success
+  *
+  * Go-back-N: a NAK or a missing response restarts the stream at the block
+  * concerned, skipping blocks acknowledged meanwhile. In a full update the
+  * node compares duplicates with flash; in a delta session it acknowledges
+  * blocks it already took without applying them again.
+  */
+static int streamBlocks(uint32_t window, int ackTimeoutMs, uint32_t *sends)
+{
+  uint32_t blocks = (imageSize + BOOT_BLOCK_SIZE - 1U) / BOOT_BLOCK_SIZE;
+  uint8_t acked[MAX_BLOCKS] = { 0 };
+  uint8_t retries[MAX_BLOCKS] = { 0 };
+  uint32_t base = 0;
+  uint32_t next = 0;
+  uint32_t inFlight = 0;
+  uint32_t done = 0;
+
+  while (done < blocks)
+  {
+    uint8_t rsp[8];
+    uint32_t number;
+
+    while ((inFlight < window) && (next < blocks))
+    {
+      if (!acked[next])
+      {
+        if (sendBlock(next) != 0)
+        {
+          return -1;
+        }
+        (*sends)++;
+        inFlight++;
+      }
+      next++;
+    }
+
+    if (waitResponse(BOOT_CMD_BLOCK, ackTimeoutMs, rsp) != 0)
+    {
+      if (++retries[base] > MAX_RETRIES)
+      {
+        fprintf(stderr, "\nblock %u: no response\n", base);
+        return -1;
+      }
+      next = base;
+      inFlight = 0;
+      continue;
+    }
+
+    number = (uint32_t)rsp[2] | ((uint32_t)rsp[3] << 8);
+    if (inFlight != 0U)
+    {
+      inFlight--;
+    }
+    if ((number >= blocks) || acked[number])
+    {
+      continue;
+    }
+
+    switch (rsp[1])
+    {
+      case BOOT_OK:
+        acked[number] = 1;
+        done++;
+        while ((base < blocks) && acked[base])
+        {
+          base++;
+        }
+        if (!quiet)
+        {
+          fprintf(stderr, "\r%3u%% (%u/%u blocks)", (done * 100U) / blocks, done, blocks);
+        }
+        break;
+      case BOOT_ERR_SEQUENCE:
+        /* Follows the NAK or loss of an earlier block, which restarts the stream */
+        break;
+      case BOOT_ERR_CRC:
+      case BOOT_ERR_INCOMPLETE:
+      case BOOT_ERR_BUSY:
+        if ((rsp[1] != BOOT_ERR_BUSY) && (++retries[number] > MAX_RETRIES))
+        {
+          fprintf(stderr, "\nblock %u: %s, giving up\n", number, statusName(rsp[1]));
+          return -1;
+        }
+        if (number < next)
+        {
+          next = number;
+          inFlight = 0;
+        }
+        break;
+      default:
+        fprintf(stderr, "\nblock %u: %s\n", number, statusName(rsp[1]));
+        return -1;
+    }
+  }
+  if (!quiet)
+  {
+    fprintf(stderr, "\n");
+  }
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  const char *ifname = "can0";
+  uint32_t window = BOOT_WINDOW;
+  uint32_t sends = 0;
+  int enter = 0;
+  int patch = 0;
+  uint8_t cmd[8];
+  uint8_t rsp[8];
+  uint64_t start;
+  uint64_t elapsed;
+  uint32_t crc;
+  FILE *f;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "i:a:s:w:epqh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'i': ifname = optarg; break;
+      case 'a': node = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 's': src = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 'w': window = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'e': enter = 1; break;
+      case 'p': patch = 1; break;
+      case 'q': quiet = 1; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (optind != (argc - 1))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  f = fopen(argv[optind], "rb");
+  if (f == NULL)
+  {
+    perror(argv[optind]);
+    return 2;
+  }
+  imageSize = (uint32_t)fread(image, 1, sizeof(image), f);
+  if ((fgetc(f) != EOF) || (imageSize < 8U))
+  {
+    fprintf(stderr, "%s: file must be 8..%lu bytes\n", argv[optind], (unsigned long)BOOT_APP_MAX_SIZE);
+    fclose(f);
+    return 2;
+  }
+  fclose(f);
+  crc = crc32(image, imageSize);
+
+  openSocket(ifname);
+  start = nowMs();
+
+  if (enter)
+  {
+    cmd[0] = BOOT_CMD_ENTER;
+    (void)sendCommand(cmd, 1);
+  }
+
+  /* The bootloader announces itself after reset; keep pinging until it does */
+  for (i = 0; i < 20; i++)
+  {
+    cmd[0] = BOOT_CMD_PING;
+    (void)sendCommand(cmd, 1);
+    if (waitResponse(BOOT_CMD_PING, 250, rsp) == 0)
+    {
+      break;
+    }
+  }
+  if (i == 20)
+  {
+    fprintf(stderr, "node 0x%02X: no bootloader response\n", node);
+    return 1;
+  }
+  if (window > rsp[3])
+  {
+    window = rsp[3];
+  }
+  if ((window == 0U) || (window > BOOT_WINDOW))
+  {
+    window = 1;
+  }
+  if (!quiet)
+  {
+    fprintf(stderr, "bootloader v%u, window %u, %u KB max, application %s\n",
+            rsp[2], rsp[3], rsp[6], rsp[5] ? "present" : "missing");
+  }
+  if (patch && (rsp[2] < 2U))
+  {
+    fprintf(stderr, "bootloader v%u has no delta support\n", rsp[2]);
+    return 1;
+  }
+
+  cmd[0] = patch ? BOOT_CMD_DELTA : BOOT_CMD_START;
+  cmd[1] = (uint8_t)imageSize;
+  cmd[2] = (uint8_t)(imageSize >> 8);
+  cmd[3] = (uint8_t)(imageSize >> 16);
+  putLe32(&cmd[4], crc);
+  (void)sendCommand(cmd, patch ? 4U : 8U);
+  if ((waitResponse(cmd[0], ERASE_TIMEOUT_MS, rsp) != 0) || (rsp[1] != BOOT_OK))
+  {
+    fprintf(stderr, "%s failed: %s\n", patch ? "DELTA" : "START", statusName(rsp[1]));
+    return 1;
+  }
+
+  /* A delta block may rewrite several pages before it is acknowledged */
+  if (streamBlocks(patch ? 1U : window, patch ? ERASE_TIMEOUT_MS : ACK_TIMEOUT_MS, &sends) != 0)
+  {
+    return 1;
+  }
+
+  cmd[0] = BOOT_CMD_END;
+  (void)sendCommand(cmd, 1);
+  if ((waitResponse(BOOT_CMD_END, patch ? ERASE_TIMEOUT_MS : (ACK_TIMEOUT_MS * 2), rsp) != 0) ||
+      (rsp[1] != BOOT_OK))
+  {
+    fprintf(stderr, "END failed: %s\n", statusName(rsp[1]));
+    return 1;
+  }
+  elapsed = nowMs() - start;
+
+  cmd[0] = BOOT_CMD_RUN;
+  (void)sendCommand(cmd, 1);
+  (void)waitResponse(BOOT_CMD_RUN, ACK_TIMEOUT_MS, rsp);
+
+  printf("%u %s bytes, crc32 %08X, %llu ms, %.1f KB/s, %u blocks resent\n",
+         imageSize, patch ? "patch" : "image", crc, (unsigned long long)elapsed,
+         (elapsed != 0U) ? ((double)imageSize / 1024.0) / ((double)elapsed / 1000.0) : 0.0,
+         sends - ((imageSize + BOOT_BLOCK_SIZE - 1U) / BOOT_BLOCK_SIZE));
+  return 0;
+}
@@ -0,0 +1,671 @@
+/**
+  ******************************************************************************
+  * @file           : candelta.c
+  * @brief          : Delta patch generator for CAN firmware updates
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Diffs the installed application image against a new build and writes a
+  * patch in the format of Boot/Inc/delta.h, to be sent with canboot -p.
+  *
+  * Matching follows bsdiff: an exact match of at least MIN_MATCH bytes
+  * (found through a hash chain over the old image) fixes an alignment, which
+  * is then extended in both directions as long as at least half the bytes
+  * agree. Code moved by an edit keeps its alignment while branch and literal
+  * pool addresses inside it change, so most of the image becomes ADD ops
+  * whose difference bytes are largely zero and cost almost nothing in the
+  * sparse run encoding. Sources before (destination - DELTA_HISTORY_SIZE) are
+  * never used, because the node has overwritten them by then.
+  *
+  * Every patch is applied to a copy of the old image with the bootloader's
+  * own applier (Boot/Src/delta.c) in pieces of one transfer block, exactly
+  * as the node does it, before it is written.
+  *
+  * With -x an ARM image is checked instead: it is rebuilt the way a relink
+  * changes it (a changed literal, code inserted or deleted with the vector
+  * table, literal pool addresses and BL offsets that cross the edit moved),
+  * and every rebuild must round-trip through the applier.
+  *
+  * Usage: candelta [-b bitrate] [-q] old.bin new.bin patch.scd
+  *        candelta [-b bitrate] -x image.bin
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "delta.h"
+
+#define MIN_MATCH         8U
+#define HASH_BITS         16U
+#define CHAIN_LIMIT       256U
+#define EXTEND_GIVE_UP    256U      /* stop extending after this many bytes without gain */
+#define SMALL_GAP         2U        /* zero diffs absorbed into an ADD run */
+#define FRAME_BITS        150U      /* 29-bit ID, 8 data bytes, typical stuffing */
+#define PATCH_MAX         (DELTA_HEADER_SIZE + (2U * BOOT_APP_MAX_SIZE))
+#define VECTOR_WORDS      16U       /* Cortex-M4 system vectors */
+
+static uint8_t oldImage[BOOT_APP_MAX_SIZE];
+static uint8_t newImage[BOOT_APP_MAX_SIZE];
+static uint32_t oldSize;
+static uint32_t newSize;
+
+static int32_t hashHead[1U << HASH_BITS];
+static int32_t hashPrev[BOOT_APP_MAX_SIZE];
+
+static uint8_t patch[PATCH_MAX];
+static uint32_t patchSize;
+
+static struct
+{
+  uint32_t addOps;
+  uint32_t addBytes;
+  uint32_t diffBytes;
+  uint32_t insertOps;
+  uint32_t insertBytes;
+} stats;
+
+/* Node model for the self-check: flash, and the page writer of the bootloader */
+static uint8_t flash[BOOT_APP_MAX_SIZE];
+static Delta_Applier applier;
+
+static uint32_t crc32(const uint8_t *data, uint32_t length)
+{
+  static uint32_t table[256];
+  uint32_t crc = 0xFFFFFFFFUL;
+  uint32_t i;
+
+  if (table[1] == 0U)
+  {
+    for (i = 0; i < 256U; i++)
+    {
+      uint32_t c = i;
+      int k;
+
+      for (k = 0; k < 8; k++)
+      {
+        c = (c & 1U) ? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+      }
+      table[i] = c;
+    }
+  }
+  for (i = 0; i < length; i++)
+  {
+    crc = table[(crc ^ data[i]) & 0xFFU] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+static uint32_t readFile(const char *path, uint8_t *buffer)
+{
+  FILE *f = fopen(path, "rb");
+  uint32_t size;
+
+  if (f == NULL)
+  {
+    perror(path);
+    exit(2);
+  }
+  size = (uint32_t)fread(buffer, 1, BOOT_APP_MAX_SIZE, f);
+  if ((fgetc(f) != EOF) || (size < 8U))
+  {
+    fprintf(stderr, "%s: image must be 8..%lu bytes\n", path, (unsigned long)BOOT_APP_MAX_SIZE);
+    exit(2);
+  }
+  fclose(f);
+  return size;
+}
+
+static void put(uint8_t byte)
+{
+  patch[patchSize++] = byte;
+}
+
+static void putLe32(uint32_t v)
+{
+  put((uint8_t)v);
+  put((uint8_t)(v >> 8));
+  put((uint8_t)(v >> 16));
+  put((uint8_t)(v >> 24));
+}
+
+static void putVarint(uint32_t v)
+{
+  while (v >= 0x80U)
+  {
+    put((uint8_t)(v | 0x80U));
+    v >>= 7;
+  }
+  put((uint8_t)v);
+}
+
+static uint32_t hash4(const uint8_t *p)
+{
+  uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+
+  return (uint32_t)(v * 2654435761UL) >> (32U - HASH_BITS);
+}
+
+static void buildIndex(void)
+{
+  uint32_t i;
+
+  memset(hashHead, 0xFF, sizeof(hashHead));
+  for (i = 0; (i + 4U) <= oldSize; i++)
+  {
+    uint32_t h = hash4(&oldImage[i]);
+
+    hashPrev[i] = hashHead[h];
+    hashHead[h] = (int32_t)i;
+  }
+}
+
+static uint32_t exactLength(uint32_t source, uint32_t dest)
+{
+  uint32_t n = 0;
+
+  while (((source + n) < oldSize) && ((dest + n) < newSize) && (oldImage[source + n] == newImage[dest + n]))
+  {
+    n++;
+  }
+  return n;
+}
+
+static int usable(uint32_t dest, int64_t source)
+{
+  return (source >= 0) && (source < (int64_t)oldSize) &&
+         ((source - (int64_t)dest) >= -(int64_t)DELTA_HISTORY_SIZE);
+}
+
+/**
+  * @brief  Longest exact match at dest, trying the previous alignment first
+  * @retval match length, alignment in *delta
+  */
+static uint32_t findMatch(uint32_t dest, int32_t lastDelta, int32_t *delta)
+{
+  uint32_t best = 0;
+  uint32_t chain = 0;
+  int32_t source;
+
+  if (usable(dest, (int64_t)dest + lastDelta))
+  {
+    best = exactLength((uint32_t)((int64_t)dest + lastDelta), dest);
+    *delta = lastDelta;
+  }
+  if ((dest + 4U) > newSize)
+  {
+    return best;
+  }
+  for (source = hashHead[hash4(&newImage[dest])]; (source >= 0) && (chain < CHAIN_LIMIT);
+       source = hashPrev[source], chain++)
+  {
+    uint32_t n;
+
+    if (!usable(dest, source))
+    {
+      continue;
+    }
+    n = exactLength((uint32_t)source, dest);
+    if (n > best)
+    {
+      best = n;
+      *delta = source - (int32_t)dest;
+    }
+  }
+  return best;
+}
+
+/* bsdiff scoring: keep extending while matches outnumber mismatches */
+static uint32_t extendForward(uint32_t dest, int32_t delta)
+{
+  uint32_t source = (uint32_t)((int64_t)dest + delta);
+  int32_t score = 0;
+  int32_t bestScore = 0;
+  uint32_t best = 0;
+  uint32_t k;
+
+  for (k = 0; ((dest + k) < newSize) && ((source + k) < oldSize) && ((k - best) < EXTEND_GIVE_UP); k++)
+  {
+    score += (oldImage[source + k] == newImage[dest + k]) ? 1 : -1;
+    if (score > bestScore)
+    {
+      bestScore = score;
+      best = k + 1U;
+    }
+  }
+  return best;
+}
+
+static uint32_t extendBackward(uint32_t dest, int32_t delta, uint32_t limit)
+{
+  int64_t source = (int64_t)dest + delta;
+  int32_t score = 0;
+  int32_t bestScore = 0;
+  uint32_t best = 0;
+  uint32_t k;
+
+  for (k = 1; (k <= limit) && ((source - k) >= 0) && ((k - best) < EXTEND_GIVE_UP); k++)
+  {
+    score += (oldImage[source - k] == newImage[dest - k]) ? 1 : -1;
+    if (score > bestScore)
+    {
+      bestScore = score;
+      best = k;
+    }
+  }
+  return best;
+}
+
+static void emitInsert(uint32_t dest, uint32_t length)
+{
+  if (length == 0U)
+  {
+    return;
+  }
+  put(DELTA_OP_INSERT);
+  putVarint(length);
+  memcpy(&patch[patchSize], &newImage[dest], length);
+  patchSize += length;
+  stats.insertOps++;
+  stats.insertBytes += length;
+}
+
+/* ADD op: alternating runs of unchanged bytes and difference bytes */
+static void emitAdd(uint32_t dest, uint32_t length, int32_t delta)
+{
+  const uint8_t *source = &oldImage[(int64_t)dest + delta];
+  const uint8_t *target = &newImage[dest];
+  uint32_t pos = 0;
+  uint32_t i;
+
+  put(DELTA_OP_ADD);
+  putVarint(length);
+  putVarint(((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+  stats.addOps++;
+  stats.addBytes += length;
+
+  while (pos < length)
+  {
+    uint32_t zeros = 0;
+    uint32_t count = 0;
+
+    while (((pos + zeros) < length) && (source[pos + zeros] == target[pos + zeros]))
+    {
+      zeros++;
+    }
+    putVarint(zeros);
+    pos += zeros;
+    if (pos == length)
+    {
+      break;
+    }
+
+    /* Changed bytes, including short unchanged gaps that are cheaper inline */
+    for (;;)
+    {
+      uint32_t gap = 0;
+
+      while (((pos + count) < length) && (source[pos + count] != target[pos + count]))
+      {
+        count++;
+      }
+      while (((pos + count + gap) < length) && (source[pos + count + gap] == target[pos + count + gap]))
+      {
+        gap++;
+      }
+      if ((gap == 0U) || (gap > SMALL_GAP) || ((pos + count + gap) == length))
+      {
+        break;
+      }
+      count += gap;
+    }
+    putVarint(count);
+    for (i = 0; i < count; i++)
+    {
+      put((uint8_t)(target[pos + i] - source[pos + i]));
+    }
+    stats.diffBytes += count;
+    pos += count;
+  }
+}
+
+static void diff(void)
+{
+  uint32_t dest = 0;
+  uint32_t literal = 0;
+  int32_t lastDelta = 0;
+
+  putLe32(DELTA_MAGIC);
+  putLe32(oldSize);
+  putLe32(crc32(oldImage, oldSize));
+  putLe32(newSize);
+  putLe32(crc32(newImage, newSize));
+
+  buildIndex();
+  while (dest < newSize)
+  {
+    int32_t delta = 0;
+    uint32_t forward;
+    uint32_t backward;
+
+    if (findMatch(dest, lastDelta, &delta) < MIN_MATCH)
+    {
+      dest++;
+      continue;
+    }
+    forward = extendForward(dest, delta);
+    backward = extendBackward(dest, delta, dest - literal);
+
+    emitInsert(literal, dest - backward - literal);
+    emitAdd(dest - backward, backward + forward, delta);
+    dest += forward;
+    literal = dest;
+    lastDelta = delta;
+  }
+  emitInsert(literal, newSize - literal);
+}
+
+static int writePage(uint32_t offset, const uint8_t *data, uint32_t length)
+{
+  memset(&flash[offset], 0xFF, DELTA_PAGE_SIZE);
+  memcpy(&flash[offset], data, length);
+  return 0;
+}
+
+/**
+  * @brief  Applies the patch like the node: in place, one block at a time
+  * @retval 0 if the result is the new image
+  */
+static int selfCheck(void)
+{
+  uint32_t offset;
+  int result = DELTA_OK;
+
+  memset(flash, 0xFF, sizeof(flash));
+  memcpy(flash, oldImage, oldSize);
+  Delta_Init(&applier, flash, writePage, crc32);
+  for (offset = 0; (offset < patchSize) && (result == DELTA_OK); offset += BOOT_BLOCK_SIZE)
+  {
+    uint32_t length = ((patchSize - offset) < BOOT_BLOCK_SIZE) ? (patchSize - offset) : BOOT_BLOCK_SIZE;
+
+    result = Delta_Feed(&applier, &patch[offset], length);
+  }
+  if (result == DELTA_OK)
+  {
+    result = Delta_Finish(&applier);
+  }
+  if (result != DELTA_OK)
+  {
+    fprintf(stderr, "self-check: applier error %d\n", result);
+    return -1;
+  }
+  if ((memcmp(flash, newImage, newSize) != 0) || (crc32(flash, newSize) != applier.newCrc))
+  {
+    fprintf(stderr, "self-check: result differs from the new image\n");
+    return -1;
+  }
+  return 0;
+}
+
+/* Bus time of a transfer: a BLOCK command plus ceil(n / 8) data frames per block */
+static double busMs(uint32_t bytes, uint32_t bitrate)
+{
+  uint32_t blocks = (bytes + BOOT_BLOCK_SIZE - 1U) / BOOT_BLOCK_SIZE;
+  uint32_t frames = 2U + blocks * 2U + (bytes + 7U) / 8U;   /* + START/END and ACKs */
+
+  return ((double)frames * FRAME_BITS * 1000.0) / (double)bitrate;
+}
+
+/* Check mode ------------------------------------------------------------------*/
+
+/* Link address of an image: the application slot if every system vector
+ * points into it, else the start of flash (a build without the bootloader) */
+static uint32_t imageBase(const uint8_t *image, uint32_t size)
+{
+  uint32_t i;
+
+  for (i = 1; (i < VECTOR_WORDS) && ((i * 4U) < size); i++)
+  {
+    uint32_t v = (uint32_t)image[i * 4U] | ((uint32_t)image[(i * 4U) + 1U] << 8) |
+                 ((uint32_t)image[(i * 4U) + 2U] << 16) | ((uint32_t)image[(i * 4U) + 3U] << 24);
+
+    if ((v != 0U) && ((v < BOOT_APP_BASE) || (v >= (BOOT_APP_BASE + size))))
+    {
+      return BOOT_FLASH_BASE;
+    }
+  }
+  return BOOT_APP_BASE;
+}
+
+/* Where an image offset ends up once shift bytes are inserted (or removed)
+ * at the offset at */
+static uint32_t moved(uint32_t offset, uint32_t at, int32_t shift)
+{
+  return (offset >= at) ? (uint32_t)((int32_t)offset + shift) : offset;
+}
+
+/**
+  * @brief  Builds newImage from oldImage as a relink would after an edit
+  * @param  at: image offset of the edit, word aligned
+  * @param  shift: bytes of code inserted (> 0) or deleted (< 0) at the
+  *         offset; 0 changes the literal there instead
+  * @retval None
+  */
+static void rebuild(uint32_t at, int32_t shift)
+{
+  static uint8_t work[BOOT_APP_MAX_SIZE];
+  uint32_t base = imageBase(oldImage, oldSize);
+  uint32_t seed = 0x2545F491UL;
+  uint32_t p;
+
+  memcpy(work, oldImage, oldSize);
+  if (shift == 0)
+  {
+    work[at] ^= 0x5AU;
+    memcpy(newImage, work, oldSize);
+    newSize = oldSize;
+    return;
+  }
+
+  /* Thumb-2 BL: a pc-relative call, changed if the edit lies in between */
+  for (p = 0; (p + 4U) <= oldSize; p += 2U)
+  {
+    uint32_t hi = (uint32_t)work[p] | ((uint32_t)work[p + 1U] << 8);
+    uint32_t lo = (uint32_t)work[p + 2U] | ((uint32_t)work[p + 3U] << 8);
+    uint32_t s, j1, j2;
+    int32_t offset;
+    int64_t target;
+
+    if (((hi & 0xF800U) != 0xF000U) || ((lo & 0xD000U) != 0xD000U))
+    {
+      continue;
+    }
+    s = (hi >> 10) & 1U;
+    j1 = ((lo >> 13) & 1U) ^ s ^ 1U;
+    j2 = ((lo >> 11) & 1U) ^ s ^ 1U;
+    offset = (int32_t)((s << 24) | (j1 << 23) | (j2 << 22) | ((hi & 0x3FFU) << 12) | ((lo & 0x7FFU) << 1));
+    offset = (offset << 7) >> 7;
+    target = (int64_t)p + 4 + offset;
+    if ((target < 0) || (target >= (int64_t)oldSize))
+    {
+      continue;
+    }
+    offset = (int32_t)moved((uint32_t)target, at, shift) - (int32_t)(moved(p, at, shift) + 4U);
+    s = ((uint32_t)offset >> 24) & 1U;
+    hi = 0xF000U | (s << 10) | (((uint32_t)offset >> 12) & 0x3FFU);
+    lo = 0xD000U | (((((uint32_t)offset >> 23) & 1U) ^ s ^ 1U) << 13) |
+         (((((uint32_t)offset >> 22) & 1U) ^ s ^ 1U) << 11) | (((uint32_t)offset >> 1) & 0x7FFU);
+    work[p] = (uint8_t)hi;
+    work[p + 1U] = (uint8_t)(hi >> 8);
+    work[p + 2U] = (uint8_t)lo;
+    work[p + 3U] = (uint8_t)(lo >> 8);
+    p += 2U;
+  }
+
+  /* Absolute addresses: vectors, literal pools, function pointers */
+  for (p = 0; (p + 4U) <= oldSize; p += 4U)
+  {
+    uint32_t v = (uint32_t)work[p] | ((uint32_t)work[p + 1U] << 8) |
+                 ((uint32_t)work[p + 2U] << 16) | ((uint32_t)work[p + 3U] << 24);
+
+    if ((v < (base + at)) || (v >= (base + oldSize)))
+    {
+      continue;
+    }
+    v = base + moved(v - base, at, shift);
+    work[p] = (uint8_t)v;
+    work[p + 1U] = (uint8_t)(v >> 8);
+    work[p + 2U] = (uint8_t)(v >> 16);
+    work[p + 3U] = (uint8_t)(v >> 24);
+  }
+
+  memcpy(newImage, work, at);
+  if (shift > 0)
+  {
+    for (p = 0; p < (uint32_t)shift; p++)
+    {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      newImage[at + p] = (uint8_t)seed;
+    }
+    memcpy(&newImage[at + (uint32_t)shift], &work[at], oldSize - at);
+  }
+  else
+  {
+    memcpy(&newImage[at], &work[at - (uint32_t)shift], oldSize - at + (uint32_t)shift);
+  }
+  newSize = (uint32_t)((int32_t)oldSize + shift);
+}
+
+/**
+  * @brief  Diffs and round-trips rebuilds of an ARM image
+  * @retval 0 if every patch applied to the rebuild
+  */
+static int checkImage(const char *path, uint32_t bitrate)
+{
+  static const struct
+  {
+    const char *name;
+    uint32_t eighths;     /* edit position in eighths of the image */
+    int32_t shift;
+  } edits[] =
+  {
+    { "identical", 0, 0 },
+    { "literal changed", 4, 0 },
+    { "64 B inserted", 4, 64 },
+    { "256 B inserted", 1, 256 },
+    { "32 B deleted", 6, -32 },
+  };
+  uint32_t i;
+  int failed = 0;
+
+  oldSize = readFile(path, oldImage);
+  if ((oldSize + 256U) > BOOT_APP_MAX_SIZE)
+  {
+    fprintf(stderr, "%s: no room to rebuild the image larger\n", path);
+    return 2;
+  }
+  printf("===== Delta check %s (%u bytes at 0x%08lX) =====\n", path, oldSize,
+         (unsigned long)imageBase(oldImage, oldSize));
+  for (i = 0; i < (sizeof(edits) / sizeof(edits[0])); i++)
+  {
+    uint32_t at = ((oldSize * edits[i].eighths) / 8U) & ~3UL;
+
+    if (edits[i].eighths == 0U)
+    {
+      memcpy(newImage, oldImage, oldSize);
+      newSize = oldSize;
+    }
+    else
+    {
+      rebuild(at, edits[i].shift);
+    }
+    patchSize = 0;
+    memset(&stats, 0, sizeof(stats));
+    diff();
+    printf("  %-16s new %5u bytes, patch %5u bytes (%5.1f%%), %4.0f ms of %4.0f ms",
+           edits[i].name, newSize, patchSize, (100.0 * patchSize) / newSize,
+           busMs(patchSize, bitrate), busMs(newSize, bitrate));
+    if (selfCheck() != 0)
+    {
+      printf(", round trip FAILED\n");
+      failed = 1;
+      continue;
+    }
+    printf(", round trip ok\n");
+  }
+  printf("  check        %s\n", failed ? "FAILED" : "ok");
+  return failed;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t bitrate = 1000000;
+  int quiet = 0;
+  int check = 0;
+  FILE *f;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "b:qxh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'b': bitrate = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'q': quiet = 1; break;
+      case 'x': check = 1; break;
+      default:
+        fprintf(stderr, "usage: %s [-b bitrate] [-q] old.bin new.bin patch.scd\n"
+                        "       %s [-b bitrate] -x image.bin\n", argv[0], argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (check && (optind == (argc - 1)) && (bitrate != 0U))
+  {
+    return checkImage(argv[optind], bitrate);
+  }
+  if (check || (optind != (argc - 3)) || (bitrate == 0U))
+  {
+    fprintf(stderr, "usage: %s [-b bitrate] [-q] old.bin new.bin patch.scd\n"
+                    "       %s [-b bitrate] -x image.bin\n", argv[0], argv[0]);
+    return 2;
+  }
+
+  oldSize = readFile(argv[optind], oldImage);
+  newSize = readFile(argv[optind + 1], newImage);
+  diff();
+  if (selfCheck() != 0)
+  {
+    return 1;
+  }
+
+  f = fopen(argv[optind + 2], "wb");
+  if ((f == NULL) || (fwrite(patch, 1, patchSize, f) != patchSize) || (fclose(f) != 0))
+  {
+    perror(argv[optind + 2]);
+    return 2;
+  }
+
+  if (!quiet)
+  {
+    printf("===== Delta %s -> %s =====\n", argv[optind], argv[optind + 1]);
+    printf("  old %u bytes, new %u bytes, patch %u bytes (%.1f%% of new)\n",
+           oldSize, newSize, patchSize, (100.0 * patchSize) / newSize);
+    printf("  ADD    %5u ops, %6u bytes, %u difference bytes\n", stats.addOps, stats.addBytes, stats.diffBytes);
+    printf("  INSERT %5u ops, %6u bytes\n", stats.insertOps, stats.insertBytes);
+    printf("  bus time at %u bit/s: full %.0f ms, delta %.0f ms\n",
+           bitrate, busMs(newSize, bitrate), busMs(patchSize, bitrate));
+    printf("  self-check passed (in place, %u B page history)\n", (unsigned)DELTA_HISTORY_SIZE);
+  }
+  return 0;
+}
@@ -0,0 +1,631 @@
+/**
+  ******************************************************************************
+  * @file           : canmon.c
+  * @brief          : Bus monitor control, report decoder and table benchmark
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Runs a bus monitor window on the node (Core/Inc/monitor.h) and prints
+  * its report: frames and rate per identifier, the gaps between frames, the
+  * DLCs seen and the bus errors. Without -t it fetches the report of the
+  * running or last window with MONITOR_GET. Reports the node sent can also
+  * be found in candump logs and pcap captures (n2klog.h).
+  *
+  * -b runs the firmware's table code (Core/Src/monitor.c) on a synthetic
+  * bus at 1 Mbit/s, back-to-back frames of the given number of identifiers
+  * with a few busy ones, and reports the time per update, the longest probe
+  * sequence and the overflow, and checks every count against a plain array.
+  *
+  * Usage: canmon -i ifname [-n node] [-s src] [-t seconds [-q] [-r]] [-k top]
+  *               [-x]
+  *        canmon -b ids [-f frames]
+  *        canmon log...
+  */
+
+#include <net/if.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "boot.h"
+#include "history.h"
+#include "monitor.h"
+#include "n2klog.h"
+
+#define REPORT_FRAMES       ((MONITOR_REPORT_MAX + 6U) / 7U)
+#define RESPONSE_TIMEOUT_MS 1000
+#define FRAME_TIMEOUT_MS    2000
+#define BENCH_BITRATE       1000000U
+#define BENCH_FRAMES        20000000U
+#define BENCH_IDS_MAX       4096U
+#define BENCH_TIMED         1000000U  /* updates timed one by one */
+
+static int sock = -1;
+static uint8_t node = BOOT_NODE_ADDRESS;
+static uint8_t src = 0xFEU;
+
+/*--------------------------------- report -----------------------------------*/
+
+static void formatId(char *out, size_t size, uint32_t id)
+{
+  if ((id & CAN_FRAME_EXT) != 0U)
+  {
+    snprintf(out, size, "%08lX%s", (unsigned long)(id & CAN_FRAME_ID_MASK), ((id & CAN_FRAME_RTR) != 0U) ? " R" : "");
+  }
+  else
+  {
+    snprintf(out, size, "%03lX%s", (unsigned long)(id & 0x7FFU), ((id & CAN_FRAME_RTR) != 0U) ? " R" : "");
+  }
+}
+
+static void formatDlcs(char *out, size_t size, uint16_t mask)
+{
+  size_t used = 0;
+  uint32_t dlc;
+
+  out[0] = '\0';
+  for (dlc = 0; (dlc < 16U) && (used + 4U < size); dlc++)
+  {
+    if ((mask & (1U << dlc)) != 0U)
+    {
+      used += (size_t)snprintf(&out[used], size - used, "%s%u", (used != 0U) ? "," : "", (unsigned)dlc);
+    }
+  }
+}
+
+static void printReport(const uint8_t *data, uint32_t bytes)
+{
+  static const char *const errorNames[MONITOR_ERRORS] = { "stuff", "form", "ack", "bit1", "bit0", "crc" };
+  Monitor_Header header;
+  double seconds;
+  uint32_t i;
+
+  memcpy(&header, data, sizeof(header));
+  if (bytes != sizeof(header) + header.talkers * sizeof(Monitor_Talker))
+  {
+    printf("length %u does not match %u talkers\n", (unsigned)bytes, header.talkers);
+    return;
+  }
+  seconds = (double)header.windowMs / 1000.0;
+  printf("window %.3f s%s%s%s: %lu frames (%.1f/s), %u identifiers, %lu frames not held\n", seconds,
+         ((header.flags & MONITOR_SILENT) != 0U) ? ", silent" : "",
+         ((header.flags & MONITOR_REPEAT) != 0U) ? ", repeating" : "",
+         ((header.flags & MONITOR_RUNNING) != 0U) ? ", running" : "", (unsigned long)header.frames,
+         (seconds > 0.0) ? header.frames / seconds : 0.0, header.ids, (unsigned long)header.overflow);
+  printf("errors:");
+  for (i = 0; i < MONITOR_ERRORS; i++)
+  {
+    printf(" %s %u", errorNames[i], header.errors[i]);
+  }
+  printf(", TEC peak %u, REC peak %u, bus-off %u\n", header.tecPeak, header.recPeak, header.busOff);
+  printf("%-11s %10s %10s %10s %10s  %s\n", "id", "frames", "rate Hz", "min ms", "max ms", "dlc");
+  for (i = 0; i < header.talkers; i++)
+  {
+    Monitor_Talker talker;
+    char id[16];
+    char dlcs[40];
+
+    memcpy(&talker, &data[sizeof(header) + (i * sizeof(talker))], sizeof(talker));
+    formatId(id, sizeof(id), talker.id);
+    formatDlcs(dlcs, sizeof(dlcs), talker.dlcMask);
+    if (talker.count > 1U)
+    {
+      printf("%-11s %10lu %10.2f %10.3f %10.3f  %s\n", id, (unsigned long)talker.count,
+             (seconds > 0.0) ? talker.count / seconds : 0.0, talker.minGapUs / 1000.0, talker.maxGapUs / 1000.0, dlcs);
+    }
+    else
+    {
+      printf("%-11s %10lu %10.2f %10s %10s  %s\n", id, (unsigned long)talker.count,
+             (seconds > 0.0) ? talker.count / seconds : 0.0, "-", "-", dlcs);
+    }
+  }
+}
+
+/*-------------------------------- retrieval ---------------------------------*/
+
+static void openSocket(const char *ifname)
+{
+  struct sockaddr_can addr;
+  struct ifreq ifr;
+  struct can_filter filter;
+
+  sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (sock < 0)
+  {
+    perror("socket(PF_CAN)");
+    exit(2);
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+  if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    exit(2);
+  }
+
+  /* PGN 0xEF00 and 0x1EF00 (data page ignored) from the node, to us */
+  filter.can_id = BOOT_CAN_ID(0, BOOT_PGN_CMD, src, node) | CAN_EFF_FLAG;
+  filter.can_mask = 0x02FFFFFFUL | CAN_EFF_FLAG;
+  (void)setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    exit(2);
+  }
+}
+
+static int readFrame(struct can_frame *cf, int timeoutMs)
+{
+  struct pollfd pfd = { .fd = sock, .events = POLLIN, .revents = 0 };
+
+  if (poll(&pfd, 1, timeoutMs) <= 0)
+  {
+    return -1;
+  }
+  return (read(sock, cf, sizeof(*cf)) == (ssize_t)sizeof(*cf)) ? 0 : -1;
+}
+
+static const char *statusName(uint8_t status)
+{
+  switch (status)
+  {
+    case BOOT_OK: return "ok";
+    case BOOT_ERR_RANGE: return "out of range";
+    case BOOT_ERR_BUSY: return "sending to another node";
+    case BOOT_ERR_STATE: return "not now (no window yet, or the bus-stress generator runs)";
+    default: return "unknown";
+  }
+}
+
+/* Waits for the response to cmd */
+static int response(uint8_t cmd, struct can_frame *cf, int timeoutMs)
+{
+  for (;;)
+  {
+    if (readFrame(cf, timeoutMs) != 0)
+    {
+      fprintf(stderr, "no response\n");
+      return -1;
+    }
+    if ((BOOT_ID_PGN(cf->can_id & CAN_EFF_MASK) == BOOT_PGN_CMD) && (cf->data[0] == (cmd | BOOT_RSP)))
+    {
+      return 0;
+    }
+  }
+}
+
+/* Sends a command with its arguments and waits for its response */
+static int command(uint8_t cmd, const uint8_t *args, uint32_t count, struct can_frame *cf)
+{
+  memset(cf, 0, sizeof(*cf));
+  cf->can_id = BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, node, src) | CAN_EFF_FLAG;
+  cf->can_dlc = 8;
+  memset(cf->data, 0xFF, 8);
+  cf->data[0] = cmd;
+  memcpy(&cf->data[1], args, count);
+  if (write(sock, cf, sizeof(*cf)) != (ssize_t)sizeof(*cf))
+  {
+    perror("write");
+    return -1;
+  }
+  return response(cmd, cf, RESPONSE_TIMEOUT_MS);
+}
+
+/* Receives the report announced by a MONITOR_GET response and prints it */
+static int receiveReport(const struct can_frame *rsp)
+{
+  uint8_t data[REPORT_FRAMES * 7U];
+  uint8_t seen[REPORT_FRAMES] = { 0 };
+  struct can_frame cf;
+  uint32_t bytes = rsp->data[3] | ((uint32_t)rsp->data[4] << 8);
+  uint32_t frames = (bytes + 6U) / 7U;
+  uint32_t received = 0;
+  uint16_t crc = (uint16_t)(rsp->data[5] | ((uint16_t)rsp->data[6] << 8));
+
+  if (rsp->data[1] != BOOT_OK)
+  {
+    fprintf(stderr, "MONITOR_GET: %s\n", statusName(rsp->data[1]));
+    return -1;
+  }
+  if ((bytes < sizeof(Monitor_Header)) || (bytes > MONITOR_REPORT_MAX))
+  {
+    fprintf(stderr, "MONITOR_GET: %u bytes\n", (unsigned)bytes);
+    return -1;
+  }
+  while (received < frames)
+  {
+    if (readFrame(&cf, FRAME_TIMEOUT_MS) != 0)
+    {
+      fprintf(stderr, "transfer stalled after %u of %u frames\n", (unsigned)received, (unsigned)frames);
+      return -1;
+    }
+    if ((BOOT_ID_PGN(cf.can_id & CAN_EFF_MASK) == BOOT_PGN_DATA) && (cf.data[0] < frames) && !seen[cf.data[0]])
+    {
+      seen[cf.data[0]] = 1;
+      memcpy(&data[cf.data[0] * 7U], &cf.data[1], 7);
+      received++;
+    }
+  }
+  if (History_Crc16(0xFFFFU, data, bytes) != crc)
+  {
+    fprintf(stderr, "CRC mismatch\n");
+    return -1;
+  }
+  printReport(data, bytes);
+  return 0;
+}
+
+/**
+  * @brief  Runs a window, or fetches the current report, and prints it
+  * @param  seconds: window length, -1 to fetch without starting one
+  * @param  flags: MONITOR_START flags
+  * @param  top: talkers wanted, 0 for the node's default
+  * @param  stop: MONITOR_STOP once done
+  * @retval 0 on success
+  */
+static int retrieve(long seconds, uint8_t flags, uint8_t top, int stop)
+{
+  struct can_frame cf;
+  int reports = 0;
+
+  if (seconds >= 0)
+  {
+    uint8_t start[4] = { flags, (uint8_t)seconds, (uint8_t)(seconds >> 8), top };
+
+    if (command(MONITOR_CMD_START, start, sizeof(start), &cf) != 0)
+    {
+      return -1;
+    }
+    if (cf.data[1] != BOOT_OK)
+    {
+      fprintf(stderr, "MONITOR_START: %s\n", statusName(cf.data[1]));
+      return -1;
+    }
+    /* The node sends each report itself at the end of the window */
+    do
+    {
+      if (response(MONITOR_CMD_GET, &cf, (int)(seconds * 1000) + RESPONSE_TIMEOUT_MS) != 0)
+      {
+        return -1;
+      }
+      if (receiveReport(&cf) != 0)
+      {
+        return -1;
+      }
+      fflush(stdout);
+      if ((flags & MONITOR_REPEAT) != 0U)
+      {
+        printf("\n");
+      }
+      reports++;
+    } while ((flags & MONITOR_REPEAT) != 0U);
+  }
+  else
+  {
+    if ((command(MONITOR_CMD_GET, &top, 1, &cf) != 0) || (receiveReport(&cf) != 0))
+    {
+      return -1;
+    }
+  }
+
+  if (stop)
+  {
+    if (command(MONITOR_CMD_STOP, NULL, 0, &cf) != 0)
+    {
+      return -1;
+    }
+    fprintf(stderr, "MONITOR_STOP: %s\n", statusName(cf.data[1]));
+  }
+  return 0;
+}
+
+/*---------------------------------- files -----------------------------------*/
+
+/**
+  * @brief  Prints every complete report the node sent in a log
+  * @param  path: candump log or pcap capture
+  * @retval reports found, -1 on error
+  */
+static int scanLog(const char *path)
+{
+  N2k_Log log;
+  N2k_Frame frame;
+  N2k_Id id;
+  uint8_t data[REPORT_FRAMES * 7U];
+  uint8_t seen[REPORT_FRAMES];
+  uint32_t received = 0;
+  uint32_t bytes = 0;
+  uint16_t crc = 0;
+  uint8_t requester = 0;
+  int active = 0;
+  int reports = 0;
+  size_t pos;
+
+  if (N2k_Open(&log, path) != 0)
+  {
+    return -1;
+  }
+  pos = log.first;
+  while (N2k_Next(&log, &pos, log.size, &frame) > 0)
+  {
+    if (!frame.ext || frame.rtr || (frame.dlc < 8U))
+    {
+      continue;
+    }
+    N2k_SplitId(frame.id, &id);
+    if (id.src != node)
+    {
+      continue;
+    }
+    if ((id.pgn == BOOT_PGN_CMD) && (frame.data[0] == (MONITOR_CMD_GET | BOOT_RSP)))
+    {
+      bytes = frame.data[3] | ((uint32_t)frame.data[4] << 8);
+      active = (frame.data[1] == BOOT_OK) && (bytes >= sizeof(Monitor_Header)) && (bytes <= MONITOR_REPORT_MAX);
+      requester = id.dst;
+      crc = (uint16_t)(frame.data[5] | ((uint16_t)frame.data[6] << 8));
+      received = 0;
+      memset(seen, 0, sizeof(seen));
+    }
+    else if (active && (id.pgn == BOOT_PGN_DATA) && (id.dst == requester) &&
+             (frame.data[0] < (bytes + 6U) / 7U) && !seen[frame.data[0]])
+    {
+      seen[frame.data[0]] = 1;
+      memcpy(&data[frame.data[0] * 7U], &frame.data[1], 7);
+      if (++received == (bytes + 6U) / 7U)
+      {
+        active = 0;
+        printf("%s%llu.%06u: report to 0x%02X, ", (reports != 0) ? "\n" : "", (unsigned long long)frame.sec,
+               (unsigned)frame.usec, requester);
+        if (History_Crc16(0xFFFFU, data, bytes) != crc)
+        {
+          printf("CRC mismatch\n");
+          continue;
+        }
+        printReport(data, bytes);
+        reports++;
+      }
+    }
+  }
+  N2k_Close(&log);
+  return reports;
+}
+
+/*-------------------------------- benchmark ---------------------------------*/
+
+static uint64_t nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t benchRandom(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+/* Bit times of a frame without stuff bits, plus one stuff bit in eight */
+static uint32_t benchBits(uint32_t id, uint32_t dlc)
+{
+  uint32_t bits = (((id & CAN_FRAME_EXT) != 0U) ? 64U : 44U) + (8U * dlc);
+
+  return bits + (bits / 8U) + 3U;
+}
+
+/**
+  * @brief  Times Monitor_Update() on a synthetic 1 Mbit/s bus and checks
+  *         the counts
+  * @param  ids: identifiers on the bus, half standard, half extended; one in
+  *         eight takes half of the frames
+  * @param  frames: frames to count
+  * @retval 0 if the counts check out
+  */
+static int bench(uint32_t ids, uint32_t frames)
+{
+  static Monitor_Table table;
+  static uint32_t idList[BENCH_IDS_MAX];
+  static uint32_t counts[BENCH_IDS_MAX];
+  uint32_t state = 0x12345678U;
+  uint32_t nowUs = 0;
+  uint64_t busUs = 0;
+  uint64_t start;
+  uint64_t elapsed;
+  uint64_t timedNs = 0;
+  uint64_t worstNs = 0;
+  uint64_t held = 0;
+  uint32_t busy = (ids + 7U) / 8U;
+  uint32_t stored = 0;
+  uint32_t i;
+  int failed = 0;
+
+  for (i = 0; i < ids; i++)
+  {
+    idList[i] = ((i & 1U) != 0U) ? (CAN_FRAME_EXT | (0x18F00000UL + (i * 0x101U))) : (0x100U + i);
+  }
+
+  /* Throughput: the whole run in one go */
+  Monitor_Clear(&table);
+  start = nowNs();
+  for (i = 0; i < frames; i++)
+  {
+    uint32_t r = benchRandom(&state);
+    uint32_t n = ((r & 1U) != 0U) ? ((r >> 1) % busy) : ((r >> 1) % ids);
+    uint32_t dlc = (r >> 28) & 0x07U;
+
+    Monitor_Update(&table, Monitor_Key(idList[n]), dlc + 1U, nowUs);
+    counts[n]++;
+    busUs += benchBits(idList[n], dlc + 1U);
+    nowUs = (uint32_t)(busUs * 1000000ULL / BENCH_BITRATE);
+  }
+  elapsed = nowNs() - start;
+
+  /* Latency: a shorter run timed update by update */
+  {
+    static Monitor_Table timedTable;
+
+    Monitor_Clear(&timedTable);
+    for (i = 0; i < BENCH_TIMED; i++)
+    {
+      uint32_t r = benchRandom(&state);
+      uint32_t n = ((r & 1U) != 0U) ? ((r >> 1) % busy) : ((r >> 1) % ids);
+      uint32_t key = Monitor_Key(idList[n]);
+      uint64_t t0 = nowNs();
+      uint64_t t;
+
+      Monitor_Update(&timedTable, key, 8U, i * 100U);
+      t = nowNs() - t0;
+      timedNs += t;
+      worstNs = (t > worstNs) ? t : worstNs;
+    }
+  }
+
+  /* Every identifier held must have its exact count */
+  for (i = 0; i < ids; i++)
+  {
+    uint32_t slot;
+
+    for (slot = 0; slot < MONITOR_SLOTS; slot++)
+    {
+      if (table.slots[slot].key == Monitor_Key(idList[i]))
+      {
+        break;
+      }
+    }
+    if (slot == MONITOR_SLOTS)
+    {
+      continue;
+    }
+    stored++;
+    held += table.slots[slot].count;
+    if (table.slots[slot].count != counts[i])
+    {
+      fprintf(stderr, "0x%lX: %lu counted, %lu sent\n", (unsigned long)idList[i],
+              (unsigned long)table.slots[slot].count, (unsigned long)counts[i]);
+      failed = 1;
+    }
+  }
+  if ((table.frames != frames) || (held + table.overflow != frames) || (stored != table.ids))
+  {
+    fprintf(stderr, "totals: %lu frames, %llu held, %lu overflow, %lu identifiers of %lu found\n",
+            (unsigned long)table.frames, (unsigned long long)held, (unsigned long)table.overflow,
+            (unsigned long)table.ids, (unsigned long)stored);
+    failed = 1;
+  }
+
+  printf("%4lu ids: %6.1f ns/frame (%5.1f M frames/s), timed %6.1f ns avg %6llu ns max; "
+         "bus %.0f frames/s; %lu held, probes <= %u, %.2f %% overflow%s\n",
+         (unsigned long)ids, (double)elapsed / frames, frames * 1e3 / (double)elapsed,
+         (double)timedNs / BENCH_TIMED, (unsigned long long)worstNs,
+         frames / ((double)busUs / BENCH_BITRATE), (unsigned long)table.ids, table.maxProbes,
+         100.0 * table.overflow / frames, failed ? ", FAILED" : "");
+  return failed;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s -i ifname [-n node] [-s src] [-t seconds [-q] [-r]] [-k top] [-x]\n"
+          "       %s -b ids [-f frames]\n"
+          "       %s log...\n"
+          "  -i  run a window or get the report over this SocketCAN interface\n"
+          "  -n  node address (default 0x%02X)\n"
+          "  -s  our source address (default 0xFE)\n"
+          "  -t  run a window this long and print its report, else get the current one\n"
+          "  -q  silent mode for the window: the node neither acknowledges nor sends\n"
+          "  -r  repeat the window until interrupted\n"
+          "  -k  busiest identifiers in the report, 1..%u (default %u)\n"
+          "  -x  stop the window once done\n"
+          "  -b  time the table update on a 1 Mbit/s bus of this many identifiers\n"
+          "  -f  frames for -b (default %u)\n"
+          "  log candump logs or pcap captures with reports the node sent\n",
+          prog, prog, prog, BOOT_NODE_ADDRESS, MONITOR_TOP_MAX, MONITOR_TOP_DEFAULT, BENCH_FRAMES);
+}
+
+int main(int argc, char **argv)
+{
+  const char *ifname = NULL;
+  long seconds = -1;
+  unsigned long benchIds = 0;
+  unsigned long benchFrames = BENCH_FRAMES;
+  uint8_t flags = 0;
+  uint8_t top = 0;
+  int stop = 0;
+  int opt;
+  int reports = 0;
+
+  while ((opt = getopt(argc, argv, "i:n:s:t:qrk:xb:f:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'i': ifname = optarg; break;
+      case 'n': node = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 's': src = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 't': seconds = strtol(optarg, NULL, 0); break;
+      case 'q': flags |= MONITOR_SILENT; break;
+      case 'r': flags |= MONITOR_REPEAT; break;
+      case 'k': top = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 'x': stop = 1; break;
+      case 'b': benchIds = strtoul(optarg, NULL, 0); break;
+      case 'f': benchFrames = strtoul(optarg, NULL, 0); break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if ((((ifname != NULL) + (benchIds != 0U) + (optind < argc)) != 1) || (top > MONITOR_TOP_MAX) ||
+      (seconds > 0xFFFF) || ((seconds < 1) && (flags != 0U)) || (benchIds > BENCH_IDS_MAX) || (benchFrames == 0U))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  if (benchIds != 0U)
+  {
+    return bench((uint32_t)benchIds, (uint32_t)benchFrames);
+  }
+  if (ifname != NULL)
+  {
+    openSocket(ifname);
+    return (retrieve(seconds, flags, top, stop) == 0) ? 0 : 1;
+  }
+  for (; optind < argc; optind++)
+  {
+    int found = scanLog(argv[optind]);
+
+    if (found < 0)
+    {
+      return 2;
+    }
+    reports += found;
+  }
+  if (reports == 0)
+  {
+    fprintf(stderr, "no monitor report found\n");
+    return 1;
+  }
+  return 0;
+}
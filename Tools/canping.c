@@ -0,0 +1,600 @@
+/**
+  ******************************************************************************
+  * @file           : canping.c
+  * @brief          : Round-trip latency over CAN with the node's ping/echo
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Pings the node (Core/Inc/ping.h) over SocketCAN at a fixed rate and
+  * prints the latency as percentiles and a histogram:
+  *
+  *   host        from write() to the kernel time stamp of the echo
+  *   bus         from our own ping coming back from the driver
+  *               (CAN_RAW_RECV_OWN_MSGS), which interfaces that echo on
+  *               transmission complete do at the end of the frame, to the
+  *               echo
+  *   turnaround  the node's own stamps: start of the ping to start of the
+  *               echo on the wire, in bit times at -B
+  *
+  * With -g the run is repeated at each load of the list, with the node's
+  * bus-stress generator (stress.h) started at that load in between; 0 runs
+  * without it. STRESS_IDS set beforehand choose the generator's
+  * identifiers, and with them how often the ping loses arbitration.
+  *
+  * Pings and echoes in candump logs and pcap captures (n2klog.h) are paired
+  * the same way; the round trip is then from the end of the ping to the end
+  * of the echo as logged. Unanswered pings make it exit 1, live and in
+  * logs alike.
+  *
+  * Usage: canping -i ifname [-n node] [-s src] [-c count] [-r hz] [-p prio]
+  *                [-g load,...] [-B bitrate]
+  *        canping [-n node] [-B bitrate] log...
+  */
+
+#include <net/if.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "boot.h"
+#include "ping.h"
+#include "stress.h"
+#include "n2klog.h"
+
+#define DEFAULT_BITRATE     1000000U  /* can.c bit timing */
+#define DEFAULT_COUNT       1000U
+#define DEFAULT_RATE        100.0
+#define RESPONSE_TIMEOUT_MS 1000
+#define DRAIN_MS            500       /* waiting for the last echoes */
+#define SETTLE_MS           200       /* after STRESS_START */
+#define LOADS_MAX           16U
+
+static int sock = -1;
+static uint8_t node = BOOT_NODE_ADDRESS;
+static uint8_t src = 0xFEU;
+static uint32_t bitrate = DEFAULT_BITRATE;
+
+/* Histogram bucket upper bounds, us */
+static const uint32_t edges[] = { 250U, 500U, 750U, 1000U, 1500U, 2000U, 3000U, 5000U, 10000U, 20000U, 50000U };
+
+/**
+  * @brief Latency samples of one run, us
+  */
+typedef struct
+{
+  uint32_t *host;
+  uint32_t *bus;
+  uint32_t *turnaround;
+  uint32_t hostCount;
+  uint32_t busCount;
+  uint32_t turnaroundCount;
+  uint32_t size;
+  uint32_t queueMax;      /* echo byte 4 */
+  uint32_t mailboxesMax;  /* echo byte 5 */
+  uint32_t aheadMax;
+} Samples;
+
+/*--------------------------------- samples ----------------------------------*/
+
+static void samplesInit(Samples *s, uint32_t size)
+{
+  memset(s, 0, sizeof(*s));
+  s->size = size;
+  s->host = calloc(size, sizeof(uint32_t));
+  s->bus = calloc(size, sizeof(uint32_t));
+  s->turnaround = calloc(size, sizeof(uint32_t));
+  if ((s->host == NULL) || (s->bus == NULL) || (s->turnaround == NULL))
+  {
+    fprintf(stderr, "out of memory\n");
+    exit(2);
+  }
+}
+
+static void samplesFree(Samples *s)
+{
+  free(s->host);
+  free(s->bus);
+  free(s->turnaround);
+}
+
+static void add(uint32_t *values, uint32_t *count, uint32_t size, uint64_t value)
+{
+  if (*count < size)
+  {
+    values[(*count)++] = (value > UINT32_MAX) ? UINT32_MAX : (uint32_t)value;
+  }
+}
+
+/* Turnaround and queue state from an echo */
+static void addEcho(Samples *s, const uint8_t *data)
+{
+  uint16_t rxStamp = (uint16_t)(data[2] | ((uint16_t)data[3] << 8));
+  uint16_t txStamp = (uint16_t)(data[6] | ((uint16_t)data[7] << 8));
+  uint32_t mailboxes = data[5] & PING_MAILBOXES_MASK;
+  uint32_t ahead = (data[5] & PING_AHEAD_MASK) >> PING_AHEAD_Pos;
+
+  add(s->turnaround, &s->turnaroundCount, s->size, ((uint64_t)(uint16_t)(txStamp - rxStamp) * 1000000ULL) / bitrate);
+  s->queueMax = (data[4] > s->queueMax) ? data[4] : s->queueMax;
+  s->mailboxesMax = (mailboxes > s->mailboxesMax) ? mailboxes : s->mailboxesMax;
+  s->aheadMax = (ahead > s->aheadMax) ? ahead : s->aheadMax;
+}
+
+static int compareU32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+/* Percentiles and a histogram */
+static void printDistribution(const char *name, uint32_t *values, uint32_t count)
+{
+  uint32_t buckets = sizeof(edges) / sizeof(edges[0]);
+  uint32_t bucket;
+  uint32_t bar;
+  uint32_t i = 0;
+
+  if (count == 0U)
+  {
+    printf("%-11s no samples\n", name);
+    return;
+  }
+  qsort(values, count, sizeof(values[0]), compareU32);
+  printf("%-11s %7lu us min, %lu p50, %lu p90, %lu p99, %lu max\n", name, (unsigned long)values[0],
+         (unsigned long)values[count / 2U], (unsigned long)values[(count * 9U) / 10U],
+         (unsigned long)values[(count * 99U) / 100U], (unsigned long)values[count - 1U]);
+  for (bucket = 0; bucket <= buckets; bucket++)
+  {
+    uint32_t n = 0;
+
+    while ((i < count) && ((bucket == buckets) || (values[i] <= edges[bucket])))
+    {
+      n++;
+      i++;
+    }
+    if (n == 0U)
+    {
+      continue;
+    }
+    if (bucket < buckets)
+    {
+      printf("  <= %5lu us %8lu  ", (unsigned long)edges[bucket], (unsigned long)n);
+    }
+    else
+    {
+      printf("   > %5lu us %8lu  ", (unsigned long)edges[bucket - 1U], (unsigned long)n);
+    }
+    for (bar = 0; bar < (n * 40U + count - 1U) / count; bar++)
+    {
+      putchar('#');
+    }
+    putchar('\n');
+  }
+}
+
+static void printSamples(Samples *s)
+{
+  printf("node state  %7lu frames in the TX queue, %lu mailboxes pending, %lu echoes ahead at most\n",
+         (unsigned long)s->queueMax, (unsigned long)s->mailboxesMax, (unsigned long)s->aheadMax);
+  if (s->hostCount != 0U)
+  {
+    printDistribution("host", s->host, s->hostCount);
+  }
+  printDistribution("bus", s->bus, s->busCount);
+  printDistribution("turnaround", s->turnaround, s->turnaroundCount);
+}
+
+/*---------------------------------- live ------------------------------------*/
+
+static uint64_t nowUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000U);
+}
+
+static void openSocket(const char *ifname)
+{
+  struct sockaddr_can addr;
+  struct ifreq ifr;
+  struct can_filter filter[2];
+  int on = 1;
+
+  sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (sock < 0)
+  {
+    perror("socket(PF_CAN)");
+    exit(2);
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+  if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    exit(2);
+  }
+
+  /* Command PGN from the node to us, and our own pings back from the driver */
+  filter[0].can_id = BOOT_CAN_ID(0, BOOT_PGN_CMD, src, node) | CAN_EFF_FLAG;
+  filter[0].can_mask = 0x03FFFFFFUL | CAN_EFF_FLAG;
+  filter[1].can_id = BOOT_CAN_ID(0, BOOT_PGN_CMD, node, src) | CAN_EFF_FLAG;
+  filter[1].can_mask = 0x03FFFFFFUL | CAN_EFF_FLAG;
+  (void)setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FILTER, filter, sizeof(filter));
+  (void)setsockopt(sock, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &on, sizeof(on));
+  (void)setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    exit(2);
+  }
+}
+
+/**
+  * @brief  Reads a frame with its kernel time stamp
+  * @param  cf: destination
+  * @param  stampUs: kernel receive time, us since the epoch
+  * @param  own: set for our own frames coming back
+  * @param  timeoutMs: poll() timeout
+  * @retval 0 on success, -1 on timeout
+  */
+static int readFrame(struct can_frame *cf, uint64_t *stampUs, int *own, int timeoutMs)
+{
+  struct pollfd pfd = { .fd = sock, .events = POLLIN, .revents = 0 };
+  char control[CMSG_SPACE(sizeof(struct timespec))];
+  struct iovec iov = { .iov_base = cf, .iov_len = sizeof(*cf) };
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+
+  if (poll(&pfd, 1, timeoutMs) <= 0)
+  {
+    return -1;
+  }
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  if (recvmsg(sock, &msg, 0) != (ssize_t)sizeof(*cf))
+  {
+    return -1;
+  }
+  *stampUs = nowUs();
+  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+  {
+    if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SO_TIMESTAMPNS))
+    {
+      struct timespec ts;
+
+      memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+      *stampUs = ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000U);
+    }
+  }
+  *own = ((msg.msg_flags & MSG_CONFIRM) != 0) ? 1 : 0;
+  return 0;
+}
+
+static void sendFrame(uint32_t prio, const uint8_t *data)
+{
+  struct can_frame cf;
+
+  memset(&cf, 0, sizeof(cf));
+  cf.can_id = BOOT_CAN_ID(prio, BOOT_PGN_CMD, node, src) | CAN_EFF_FLAG;
+  cf.can_dlc = 8;
+  memcpy(cf.data, data, 8);
+  if (write(sock, &cf, sizeof(cf)) != (ssize_t)sizeof(cf))
+  {
+    perror("write");
+    exit(1);
+  }
+}
+
+/* Sends a bus-stress command and waits for its status */
+static int stressCommand(const uint8_t *data)
+{
+  struct can_frame cf;
+  uint64_t stamp;
+  uint64_t deadline = nowUs() + (RESPONSE_TIMEOUT_MS * 1000U);
+  int own;
+
+  sendFrame(BOOT_PRIO_CMD, data);
+  while (nowUs() < deadline)
+  {
+    if ((readFrame(&cf, &stamp, &own, RESPONSE_TIMEOUT_MS) == 0) && !own && (cf.data[0] == (data[0] | BOOT_RSP)))
+    {
+      if (cf.data[1] != BOOT_OK)
+      {
+        fprintf(stderr, "bus-stress command 0x%02X refused (status %u)\n", data[0], cf.data[1]);
+        return -1;
+      }
+      return 0;
+    }
+  }
+  fprintf(stderr, "no response to bus-stress command 0x%02X\n", data[0]);
+  return -1;
+}
+
+/**
+  * @brief  Pings the node count times at rate and prints the latency
+  * @param  count: pings
+  * @param  rate: pings per second
+  * @param  prio: priority of the pings
+  * @retval pings not answered
+  */
+static uint32_t pingRun(uint32_t count, double rate, uint32_t prio)
+{
+  static uint64_t writtenUs[256];
+  static uint64_t ownUs[256];
+  static uint8_t open[256];
+  Samples s;
+  uint64_t startUs = nowUs();
+  uint64_t endUs = 0;
+  uint32_t sent = 0;
+  uint32_t answered = 0;
+  uint32_t late = 0;
+
+  memset(open, 0, sizeof(open));
+  samplesInit(&s, count);
+  while ((sent < count) || ((answered + late < sent) && (nowUs() < endUs)))
+  {
+    uint64_t next = startUs + (uint64_t)((double)sent * 1e6 / rate);
+    uint64_t now = nowUs();
+    struct can_frame cf;
+    uint64_t stamp;
+    int own;
+
+    if ((sent < count) && (now >= next))
+    {
+      uint8_t seq = (uint8_t)sent;
+      uint8_t ping[8] = { PING_CMD_ECHO, seq, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+      if (open[seq])
+      {
+        late++;         /* its echo never came, the sequence wrapped */
+      }
+      open[seq] = 1;
+      ownUs[seq] = 0;
+      writtenUs[seq] = nowUs();
+      sendFrame(prio, ping);
+      if (++sent == count)
+      {
+        endUs = nowUs() + (DRAIN_MS * 1000U);
+      }
+      continue;
+    }
+    if (readFrame(&cf, &stamp, &own, (sent < count) ? (int)((next - now) / 1000U) : 10) != 0)
+    {
+      continue;
+    }
+    if (own && (cf.data[0] == PING_CMD_ECHO))
+    {
+      ownUs[cf.data[1]] = stamp;
+    }
+    else if (!own && (cf.can_dlc == 8U) && (cf.data[0] == (PING_CMD_ECHO | BOOT_RSP)) && open[cf.data[1]])
+    {
+      uint8_t seq = cf.data[1];
+
+      open[seq] = 0;
+      answered++;
+      add(s.host, &s.hostCount, s.size, stamp - writtenUs[seq]);
+      if (ownUs[seq] != 0U)
+      {
+        add(s.bus, &s.busCount, s.size, stamp - ownUs[seq]);
+      }
+      addEcho(&s, cf.data);
+    }
+  }
+
+  printf("pings       %7lu at %.0f Hz, priority %lu, %lu answered, %lu lost\n", (unsigned long)sent, rate,
+         (unsigned long)prio, (unsigned long)answered, (unsigned long)(sent - answered));
+  printSamples(&s);
+  samplesFree(&s);
+  return sent - answered;
+}
+
+/*---------------------------------- files -----------------------------------*/
+
+/**
+  * @brief  Pairs the pings to the node with its echoes in a log
+  * @param  path: candump log or pcap capture
+  * @param  lost: incremented by the pings not answered
+  * @retval echoes found, -1 on error
+  */
+static int scanLog(const char *path, uint32_t *lost)
+{
+  /* Pings by requester and sequence */
+  static uint64_t pingUs[256][256];
+  static uint8_t open[256][256];
+  N2k_Log log;
+  N2k_Frame frame;
+  N2k_Id id;
+  Samples s;
+  uint32_t pings = 0;
+  uint32_t echoes = 0;
+  size_t pos;
+
+  if (N2k_Open(&log, path) != 0)
+  {
+    return -1;
+  }
+  memset(open, 0, sizeof(open));
+  samplesInit(&s, 1U << 20);
+  pos = log.first;
+  while (N2k_Next(&log, &pos, log.size, &frame) > 0)
+  {
+    uint64_t us = ((uint64_t)frame.sec * 1000000ULL) + frame.usec;
+
+    if (!frame.ext || frame.rtr || (frame.dlc < 2U))
+    {
+      continue;
+    }
+    N2k_SplitId(frame.id, &id);
+    if (id.pgn != BOOT_PGN_CMD)
+    {
+      continue;
+    }
+    if ((id.dst == node) && (frame.data[0] == PING_CMD_ECHO))
+    {
+      pingUs[id.src][frame.data[1]] = us;
+      open[id.src][frame.data[1]] = 1;
+      pings++;
+    }
+    else if ((id.src == node) && (frame.dlc == 8U) && (frame.data[0] == (PING_CMD_ECHO | BOOT_RSP)) &&
+             open[id.dst][frame.data[1]])
+    {
+      open[id.dst][frame.data[1]] = 0;
+      add(s.bus, &s.busCount, s.size, us - pingUs[id.dst][frame.data[1]]);
+      addEcho(&s, frame.data);
+      echoes++;
+    }
+  }
+  N2k_Close(&log);
+  *lost += pings - echoes;
+
+  printf("%s: %lu pings, %lu echoes\n", path, (unsigned long)pings, (unsigned long)echoes);
+  if (echoes != 0U)
+  {
+    printSamples(&s);
+  }
+  samplesFree(&s);
+  return (int)echoes;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s -i ifname [-n node] [-s src] [-c count] [-r hz] [-p prio] [-g load,...] [-B bitrate]\n"
+          "       %s [-n node] [-B bitrate] log...\n"
+          "  -i  ping over this SocketCAN interface\n"
+          "  -n  node address (default 0x%02X)\n"
+          "  -s  our source address (default 0xFE)\n"
+          "  -c  pings per run (default %u)\n"
+          "  -r  pings per second (default %.0f)\n"
+          "  -p  priority of the pings, 0..7 (default %lu)\n"
+          "  -g  a run at each bus-stress load in %%, 0 = generator off\n"
+          "  -B  bus bit rate for the node's time stamps (default %u)\n"
+          "  log candump logs or pcap captures with pings and echoes\n",
+          prog, prog, BOOT_NODE_ADDRESS, DEFAULT_COUNT, DEFAULT_RATE, (unsigned long)BOOT_PRIO_CMD, DEFAULT_BITRATE);
+}
+
+int main(int argc, char **argv)
+{
+  const char *ifname = NULL;
+  const char *loadList = NULL;
+  unsigned long loads[LOADS_MAX];
+  uint32_t loadCount = 0;
+  unsigned long count = DEFAULT_COUNT;
+  unsigned long prio = BOOT_PRIO_CMD;
+  double rate = DEFAULT_RATE;
+  uint32_t lost = 0;
+  uint32_t i;
+  int echoes = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "i:n:s:c:r:p:g:B:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'i': ifname = optarg; break;
+      case 'n': node = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 's': src = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 'c': count = strtoul(optarg, NULL, 0); break;
+      case 'r': rate = strtod(optarg, NULL); break;
+      case 'p': prio = strtoul(optarg, NULL, 0); break;
+      case 'g': loadList = optarg; break;
+      case 'B': bitrate = (uint32_t)strtoul(optarg, NULL, 0); break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (loadList != NULL)
+  {
+    char *p = (char *)loadList;
+
+    do
+    {
+      loads[loadCount] = strtoul(p, &p, 0);
+      if ((loads[loadCount] > 100U) || ((*p != ',') && (*p != '\0')))
+      {
+        usage(argv[0]);
+        return 2;
+      }
+      loadCount++;
+    } while ((*p++ == ',') && (loadCount < LOADS_MAX));
+  }
+  if (((ifname != NULL) == (optind < argc)) || (count == 0U) || (rate <= 0.0) || (prio > 7U) || (bitrate == 0U))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  if (ifname == NULL)
+  {
+    for (; optind < argc; optind++)
+    {
+      int found = scanLog(argv[optind], &lost);
+
+      if (found < 0)
+      {
+        return 2;
+      }
+      echoes += found;
+    }
+    if (echoes == 0)
+    {
+      fprintf(stderr, "no echoes found\n");
+      return 1;
+    }
+    return (lost == 0U) ? 0 : 1;
+  }
+
+  openSocket(ifname);
+  if (loadCount == 0U)
+  {
+    return (pingRun((uint32_t)count, rate, (uint32_t)prio) == 0U) ? 0 : 1;
+  }
+  for (i = 0; i < loadCount; i++)
+  {
+    uint8_t start[8] = { STRESS_CMD_START, (uint8_t)loads[i], 1, 0, 0x48, 0xFF, 0xFF, 0xFF };
+    uint8_t stop[8] = { STRESS_CMD_STOP, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+    printf("%s===== load %lu %% =====\n", (i != 0U) ? "\n" : "", loads[i]);
+    if (loads[i] != 0U)
+    {
+      if (stressCommand(start) != 0)
+      {
+        return 1;
+      }
+      usleep(SETTLE_MS * 1000U);
+    }
+    lost += pingRun((uint32_t)count, rate, (uint32_t)prio);
+    if ((loads[i] != 0U) && (stressCommand(stop) != 0))
+    {
+      return 1;
+    }
+    fflush(stdout);
+  }
+  return (lost == 0U) ? 0 : 1;
+}
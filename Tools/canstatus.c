@@ -0,0 +1,330 @@
+/**
+  ******************************************************************************
+  * @file           : canstatus.c
+  * @brief          : Status snapshots reassembled from the A1 pages
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Reads the A1 frames (Core/Inc/status.h) live from SocketCAN or from
+  * candump logs and pcap captures (n2klog.h), decodes them with the
+  * firmware's own codec and puts each round of pages, taken in order, back
+  * together into a snapshot. Every snapshot is printed as one line, with the
+  * frame rates from the counters of the snapshot before it; a round with a
+  * gap or a frame that is no status page is counted and skipped.
+  *
+  * Usage: canstatus -i ifname [-t seconds] [-q]
+  *        canstatus [-q] log...
+  */
+
+#include <net/if.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "status.h"
+#include "n2klog.h"
+
+#define COUNTER_MASK    ((1UL << 28) - 1UL)   /* TRAFFIC counter width */
+
+/**
+  * @brief Reassembly state of one source (the interface or a log)
+  */
+typedef struct
+{
+  Status_Snapshot page;       /* fields as the pages come in */
+  Status_Snapshot last;       /* last snapshot */
+  Status_Snapshot before;     /* the one before, for the rates */
+  uint64_t sec;               /* time of the last snapshot */
+  uint32_t usec;
+  uint8_t started;
+  uint8_t inRound;            /* pages of this round in order so far */
+  uint8_t nextPage;
+  uint8_t nextRound;
+  uint32_t frames;
+  uint32_t snapshots;
+  uint32_t broken;            /* rounds with a gap */
+  uint32_t invalid;           /* A1 frames that are no status page */
+} Reassembly;
+
+static int quiet;
+
+/*-------------------------------- decoding ----------------------------------*/
+
+static void printHeader(void)
+{
+  printf("%17s %10s %8s %8s %6s %6s %4s %4s %4s %3s %5s %6s %7s %5s %6s %6s\n", "time", "uptime s", "tx/s",
+         "rx/s", "rxdrop", "txdrop", "ovr", "TEC", "REC", "LEC", "flags", "load%", "jit us", "adc", "stack", "heap");
+}
+
+/* The last snapshot, with the frame rates since the one before */
+static void printSnapshot(const Reassembly *r)
+{
+  const Status_Snapshot *s = &r->last;
+  double seconds = (double)(s->uptimeMs - r->before.uptimeMs) / 1000.0;
+  double txRate = 0.0;
+  double rxRate = 0.0;
+  const char *state = "ok";
+
+  if ((r->snapshots > 1U) && (seconds > 0.0))
+  {
+    txRate = (double)((s->txFrames - r->before.txFrames) & COUNTER_MASK) / seconds;
+    rxRate = (double)((s->rxFrames - r->before.rxFrames) & COUNTER_MASK) / seconds;
+  }
+  if ((s->flags & STATUS_FLAG_BOFF) != 0U)
+  {
+    state = "off";
+  }
+  else if ((s->flags & STATUS_FLAG_EPVF) != 0U)
+  {
+    state = "pasv";
+  }
+  else if ((s->flags & STATUS_FLAG_EWGF) != 0U)
+  {
+    state = "warn";
+  }
+  printf("%10lu.%06lu %10.3f %8.1f %8.1f %6lu %6lu %4lu %4u %4u %3u %5s %6.1f %7lu %5u %6lu %6lu\n",
+         (unsigned long)r->sec, (unsigned long)r->usec, (double)s->uptimeMs / 1000.0, txRate, rxRate,
+         (unsigned long)s->rxDropped, (unsigned long)s->txDropped, (unsigned long)s->rxOverruns, s->tec, s->rec,
+         s->lec, state, (double)s->loadPermille / 10.0, (unsigned long)s->jitterUs, s->adc,
+         (unsigned long)s->stackPeak, (unsigned long)s->heapPeak);
+}
+
+/**
+  * @brief  Takes one A1 frame; prints a snapshot when it completes a round
+  * @param  r: reassembly state
+  * @param  data: frame data
+  * @param  dlc: frame length
+  * @param  sec: frame time, seconds
+  * @param  usec: frame time, microseconds
+  * @retval None
+  */
+static void addFrame(Reassembly *r, const uint8_t *data, uint8_t dlc, uint64_t sec, uint32_t usec)
+{
+  uint8_t round;
+  uint8_t page;
+
+  r->frames++;
+  page = (dlc == 8U) ? Status_Unpack(data, &round, &r->page) : STATUS_PAGES;
+  if (page == STATUS_PAGES)
+  {
+    r->invalid++;
+    r->inRound = 0;
+    return;
+  }
+  if (r->started && ((page != r->nextPage) || (round != r->nextRound)) && r->inRound)
+  {
+    r->broken++;
+    r->inRound = 0;
+  }
+  if (page == 0U)
+  {
+    r->inRound = 1;
+  }
+  r->started = 1;
+  r->nextPage = (uint8_t)((page + 1U) % STATUS_PAGES);
+  r->nextRound = (r->nextPage == 0U) ? (uint8_t)((round + 1U) % STATUS_ROUNDS) : round;
+
+  if ((page == (STATUS_PAGES - 1U)) && r->inRound)
+  {
+    r->snapshots++;
+    r->before = r->last;
+    r->last = r->page;
+    r->sec = sec;
+    r->usec = usec;
+    if (!quiet)
+    {
+      printSnapshot(r);
+    }
+  }
+}
+
+static void printSummary(const char *name, const Reassembly *r)
+{
+  printf("%s: %lu frames, %lu snapshots, %lu rounds with a gap, %lu frames no status page\n", name,
+         (unsigned long)r->frames, (unsigned long)r->snapshots, (unsigned long)r->broken,
+         (unsigned long)r->invalid);
+  if (quiet && (r->snapshots != 0U))
+  {
+    printHeader();
+    printSnapshot(r);
+  }
+}
+
+/*---------------------------------- live ------------------------------------*/
+
+static int openSocket(const char *ifname)
+{
+  struct sockaddr_can addr;
+  struct ifreq ifr;
+  struct can_filter filter;
+  int sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+
+  if (sock < 0)
+  {
+    perror("socket(PF_CAN)");
+    exit(2);
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+  if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    exit(2);
+  }
+
+  /* The A1 frame alone: standard identifier, no RTR */
+  filter.can_id = STATUS_ID;
+  filter.can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+  (void)setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    exit(2);
+  }
+  return sock;
+}
+
+/**
+  * @brief  Follows the A1 frames on an interface
+  * @param  ifname: SocketCAN interface
+  * @param  seconds: how long, 0 until interrupted
+  * @retval snapshots decoded
+  */
+static uint32_t follow(const char *ifname, long seconds)
+{
+  static Reassembly r;
+  int sock = openSocket(ifname);
+  time_t end = time(NULL) + seconds;
+
+  if (!quiet)
+  {
+    printHeader();
+  }
+  while ((seconds == 0) || (time(NULL) < end))
+  {
+    struct pollfd pfd = { .fd = sock, .events = POLLIN, .revents = 0 };
+    struct can_frame cf;
+    struct timespec now;
+
+    if ((poll(&pfd, 1, 100) <= 0) || (read(sock, &cf, sizeof(cf)) != (ssize_t)sizeof(cf)))
+    {
+      continue;
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    addFrame(&r, cf.data, cf.can_dlc, (uint64_t)now.tv_sec, (uint32_t)(now.tv_nsec / 1000));
+    fflush(stdout);
+  }
+  close(sock);
+  printSummary(ifname, &r);
+  return r.snapshots;
+}
+
+/*---------------------------------- files -----------------------------------*/
+
+/**
+  * @brief  Decodes the A1 frames of a log
+  * @param  path: candump log or pcap capture
+  * @retval snapshots decoded, -1 on error
+  */
+static int scanLog(const char *path)
+{
+  static Reassembly r;
+  N2k_Log log;
+  N2k_Frame frame;
+  size_t pos;
+
+  if (N2k_Open(&log, path) != 0)
+  {
+    return -1;
+  }
+  memset(&r, 0, sizeof(r));
+  if (!quiet)
+  {
+    printHeader();
+  }
+  pos = log.first;
+  while (N2k_Next(&log, &pos, log.size, &frame) > 0)
+  {
+    if (!frame.ext && !frame.rtr && (frame.id == STATUS_ID))
+    {
+      addFrame(&r, frame.data, frame.dlc, frame.sec, frame.usec);
+    }
+  }
+  N2k_Close(&log);
+  printSummary(path, &r);
+  return (int)r.snapshots;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s -i ifname [-t seconds] [-q]\n"
+          "       %s [-q] log...\n"
+          "  -i  follow the A1 frames on this SocketCAN interface\n"
+          "  -t  stop after this many seconds (default: Ctrl-C)\n"
+          "  -q  no line per snapshot, the last one in the summary\n"
+          "  log candump logs or pcap captures\n",
+          prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+  const char *ifname = NULL;
+  long seconds = 0;
+  int snapshots = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "i:t:qh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'i': ifname = optarg; break;
+      case 't': seconds = strtol(optarg, NULL, 0); break;
+      case 'q': quiet = 1; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (((ifname != NULL) == (optind < argc)) || (seconds < 0))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  if (ifname != NULL)
+  {
+    return (follow(ifname, seconds) != 0U) ? 0 : 1;
+  }
+  for (; optind < argc; optind++)
+  {
+    int found = scanLog(argv[optind]);
+
+    if (found < 0)
+    {
+      return 2;
+    }
+    snapshots += found;
+  }
+  return (snapshots != 0) ? 0 : 1;
+}
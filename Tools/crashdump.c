@@ -0,0 +1,734 @@
+/**
+  ******************************************************************************
+  * @file           : crashdump.c
+  * @brief          : Crash report retrieval and decoder
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Gets the crash report (Core/Inc/crash.h) from the node with CRASH_GET, or
+  * finds the reports in candump logs and pcap captures (n2klog.h), as sent
+  * at start-up, or reads a crash record file of the simulator (-Z), and
+  * prints it: the registers, the fault status bits by name, the stack words
+  * and the trace events before the crash.
+  *
+  * With -e the addresses are resolved against the symbol table of the image
+  * (build/simplecan.elf, or the simulator for its records), as
+  * function+offset; with -a also to file and line by running that addr2line
+  * (arm-none-eabi-addr2line for the target).
+  *
+  * Usage: crashdump [-e elf] [-a addr2line] [-c clock_hz] -i ifname [-n node]
+  *                  [-s src] [-x]
+  *        crashdump [-e elf] [-a addr2line] [-c clock_hz] -r record
+  *        crashdump [-e elf] [-a addr2line] [-c clock_hz] log...
+  */
+
+#include <elf.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "boot.h"
+#include "crash.h"
+#include "history.h"
+#include "n2klog.h"
+
+#define REPORT_BYTES        ((uint32_t)sizeof(Crash_Report))
+#define REPORT_FRAMES       ((REPORT_BYTES + 6U) / 7U)
+#define RESPONSE_TIMEOUT_MS 1000
+#define FRAME_TIMEOUT_MS    2000
+#define DEFAULT_CLOCK_HZ    64000000UL  /* HCLK, SystemClock_Config() */
+
+/* Must match Core/Inc/trace.h */
+#define EVT_CAN_TX_ENQUEUE      0x01
+#define EVT_CAN_TX_COMPLETE     0x02
+#define EVT_CAN_RX_ISR_ENTER    0x03
+#define EVT_CAN_RX_ISR_EXIT     0x04
+#define EVT_ADC_DONE            0x05
+#define EVT_TASK_START          0x06
+#define EVT_TASK_STOP           0x07
+
+typedef struct
+{
+  uint64_t address;
+  uint64_t size;
+  const char *name;
+} Symbol;
+
+static Symbol *symbols;
+static size_t symbolCount;
+static const char *elfPath;
+static const char *addr2line;
+static unsigned long clockHz = DEFAULT_CLOCK_HZ;
+
+static int sock = -1;
+static uint8_t node = BOOT_NODE_ADDRESS;
+static uint8_t src = 0xFEU;
+
+/*--------------------------------- symbols ----------------------------------*/
+
+static int compareSymbols(const void *a, const void *b)
+{
+  const Symbol *x = a;
+  const Symbol *y = b;
+
+  return (x->address > y->address) - (x->address < y->address);
+}
+
+/* Adds the function and object symbols of one symbol table */
+#define LOAD_SYMBOLS(Ehdr, Shdr, Sym, ST_TYPE)                                        \
+  do {                                                                                \
+    const Ehdr *eh = (const Ehdr *)image;                                             \
+    const Shdr *sh = (const Shdr *)(image + eh->e_shoff);                             \
+    size_t i;                                                                         \
+                                                                                      \
+    if ((eh->e_shoff + (uint64_t)eh->e_shnum * sizeof(Shdr)) > size)                  \
+    {                                                                                 \
+      return -1;                                                                      \
+    }                                                                                 \
+    thumb = (eh->e_machine == EM_ARM);                                                \
+    for (i = 0; i < eh->e_shnum; i++)                                                 \
+    {                                                                                 \
+      const Sym *sym;                                                                 \
+      const char *strtab;                                                             \
+      size_t n;                                                                       \
+      size_t j;                                                                       \
+                                                                                      \
+      if ((sh[i].sh_type != SHT_SYMTAB) || (sh[i].sh_link >= eh->e_shnum) ||          \
+          ((sh[i].sh_offset + sh[i].sh_size) > size) ||                               \
+          ((sh[sh[i].sh_link].sh_offset + sh[sh[i].sh_link].sh_size) > size))         \
+      {                                                                               \
+        continue;                                                                     \
+      }                                                                               \
+      sym = (const Sym *)(image + sh[i].sh_offset);                                   \
+      strtab = (const char *)(image + sh[sh[i].sh_link].sh_offset);                   \
+      n = sh[i].sh_size / sizeof(Sym);                                                \
+      symbols = realloc(symbols, (symbolCount + n) * sizeof(Symbol));                 \
+      for (j = 0; j < n; j++)                                                         \
+      {                                                                               \
+        uint32_t type = ST_TYPE(sym[j].st_info);                                      \
+                                                                                      \
+        if (((type != STT_FUNC) && (type != STT_OBJECT)) || (sym[j].st_value == 0U) || \
+            (sym[j].st_name >= sh[sh[i].sh_link].sh_size))                            \
+        {                                                                             \
+          continue;                                                                   \
+        }                                                                             \
+        symbols[symbolCount].address = sym[j].st_value;                              \
+        if (thumb && (type == STT_FUNC))                                              \
+        {                                                                             \
+          symbols[symbolCount].address &= ~1ULL;                                      \
+        }                                                                             \
+        symbols[symbolCount].size = sym[j].st_size;                                   \
+        symbols[symbolCount].name = strtab + sym[j].st_name;                          \
+        symbolCount++;                                                                \
+      }                                                                               \
+    }                                                                                 \
+  } while (0)
+
+/**
+  * @brief  Loads the symbol table of an ELF image, 32 or 64 bit
+  * @param  path: image file
+  * @retval 0 on success
+  *
+  * The image stays in memory: the names point into it.
+  */
+static int loadSymbols(const char *path)
+{
+  struct stat st;
+  uint8_t *image;
+  size_t size;
+  int thumb;
+  int fd = open(path, O_RDONLY);
+
+  if ((fd < 0) || (fstat(fd, &st) != 0))
+  {
+    perror(path);
+    return -1;
+  }
+  size = (size_t)st.st_size;
+  image = malloc(size);
+  if ((image == NULL) || (read(fd, image, size) != (ssize_t)size) || (size < sizeof(Elf64_Ehdr)) ||
+      (memcmp(image, ELFMAG, SELFMAG) != 0))
+  {
+    fprintf(stderr, "%s: not an ELF image\n", path);
+    close(fd);
+    return -1;
+  }
+  close(fd);
+
+  if (image[EI_CLASS] == ELFCLASS32)
+  {
+    LOAD_SYMBOLS(Elf32_Ehdr, Elf32_Shdr, Elf32_Sym, ELF32_ST_TYPE);
+  }
+  else
+  {
+    LOAD_SYMBOLS(Elf64_Ehdr, Elf64_Shdr, Elf64_Sym, ELF64_ST_TYPE);
+  }
+  if (symbolCount == 0U)
+  {
+    fprintf(stderr, "%s: no symbol table\n", path);
+    return -1;
+  }
+  qsort(symbols, symbolCount, sizeof(Symbol), compareSymbols);
+  return 0;
+}
+
+/**
+  * @brief  Finds the symbol holding an address
+  * @param  address: code or data address
+  * @param  out: "name+0xoffset", empty if none
+  * @param  size: of out
+  * @retval 1 if found
+  */
+static int symbolize(uint32_t address, char *out, size_t size)
+{
+  size_t lo = 0;
+  size_t hi = symbolCount;
+
+  out[0] = '\0';
+  while (lo < hi)
+  {
+    size_t mid = (lo + hi) / 2U;
+
+    if (symbols[mid].address <= address)
+    {
+      lo = mid + 1U;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  /* Symbols of the same address: any one that covers it */
+  while (lo-- != 0U)
+  {
+    const Symbol *sym = &symbols[lo];
+
+    if ((address - sym->address) < ((sym->size != 0U) ? sym->size : 1U))
+    {
+      snprintf(out, size, "%s+0x%lx", sym->name, (unsigned long)(address - sym->address));
+      return 1;
+    }
+    if ((lo == 0U) || (symbols[lo - 1U].address != sym->address))
+    {
+      break;
+    }
+  }
+  return 0;
+}
+
+/* File and line from addr2line, indented under the address */
+static void printSource(uint32_t address)
+{
+  char command[512];
+  char line[512];
+  FILE *p;
+
+  if ((addr2line == NULL) || (elfPath == NULL))
+  {
+    return;
+  }
+  snprintf(command, sizeof(command), "%s -f -i -C -e '%s' 0x%lx", addr2line, elfPath, (unsigned long)address);
+  p = popen(command, "r");
+  if (p == NULL)
+  {
+    return;
+  }
+  while (fgets(line, sizeof(line), p) != NULL)
+  {
+    printf("                          %s", line);
+  }
+  (void)pclose(p);
+}
+
+/* One code address; return addresses are looked up one byte back, inside
+ * the call */
+static void printCode(const char *label, uint32_t address, int isReturn)
+{
+  char name[160];
+  uint32_t code = address & ~1UL;
+
+  symbolize(code, name, sizeof(name));
+  printf("  %-10s 0x%08lX%s%s\n", label, (unsigned long)address, (name[0] != '\0') ? "  " : "", name);
+  if (code != 0U)
+  {
+    printSource(isReturn ? (code - 1U) : code);
+  }
+}
+
+/*--------------------------------- report -----------------------------------*/
+
+static const char *kindName(uint8_t kind)
+{
+  static const char *names[] = { "none", "HardFault", "MemManage", "BusFault", "UsageFault", "Error_Handler" };
+
+  return (kind < (sizeof(names) / sizeof(names[0]))) ? names[kind] : "unknown";
+}
+
+/* Scheduler tasks in the order main.c adds them */
+static const char *taskName(uint8_t task)
+{
+  static const char *names[] = { "A1", "T1", "heartbeat", "service" };
+
+  if (task == 0xFFU)
+  {
+    return "none (idle or interrupt)";
+  }
+  return (task < (sizeof(names) / sizeof(names[0]))) ? names[task] : "?";
+}
+
+static const char *eventName(uint8_t id)
+{
+  switch (id)
+  {
+    case EVT_CAN_TX_ENQUEUE:   return "CAN_TX_ENQUEUE";
+    case EVT_CAN_TX_COMPLETE:  return "CAN_TX_COMPLETE";
+    case EVT_CAN_RX_ISR_ENTER: return "CAN_RX_ISR_ENTER";
+    case EVT_CAN_RX_ISR_EXIT:  return "CAN_RX_ISR_EXIT";
+    case EVT_ADC_DONE:         return "ADC_DONE";
+    case EVT_TASK_START:       return "TASK_START";
+    case EVT_TASK_STOP:        return "TASK_STOP";
+    default:                   return "UNKNOWN";
+  }
+}
+
+static void printBits(const char *label, uint32_t value, const char *const *names)
+{
+  uint32_t bit;
+
+  printf("  %-10s 0x%08lX ", label, (unsigned long)value);
+  for (bit = 0; bit < 32U; bit++)
+  {
+    if (((value >> bit) & 1U) != 0U)
+    {
+      printf(" %s", (names[bit] != NULL) ? names[bit] : "?");
+    }
+  }
+  printf("\n");
+}
+
+/**
+  * @brief  Prints a crash report
+  * @param  report: as sent by the node
+  * @retval None
+  */
+static void printReport(const Crash_Report *report)
+{
+  static const char *const cfsrNames[32] =
+  {
+    [0] = "IACCVIOL", [1] = "DACCVIOL", [3] = "MUNSTKERR", [4] = "MSTKERR", [5] = "MLSPERR", [7] = "MMARVALID",
+    [8] = "IBUSERR", [9] = "PRECISERR", [10] = "IMPRECISERR", [11] = "UNSTKERR", [12] = "STKERR",
+    [13] = "LSPERR", [15] = "BFARVALID", [16] = "UNDEFINSTR", [17] = "INVSTATE", [18] = "INVPC",
+    [19] = "NOCP", [24] = "UNALIGNED", [25] = "DIVBYZERO"
+  };
+  static const char *const hfsrNames[32] = { [1] = "VECTTBL", [30] = "FORCED", [31] = "DEBUGEVT" };
+  char name[160];
+  uint32_t last;
+  uint32_t i;
+
+  printf("%s in task %u %s, uptime %lu.%03lu s\n", kindName(report->kind), report->task,
+         taskName(report->task), (unsigned long)(report->uptimeMs / 1000U),
+         (unsigned long)(report->uptimeMs % 1000U));
+
+  if (report->kind == CRASH_KIND_ERROR)
+  {
+    printCode("caller", report->pc, 1);
+  }
+  else
+  {
+    printCode("pc", report->pc, 0);
+    printCode("lr", report->lr, 1);
+    printf("  %-10s 0x%08lX 0x%08lX 0x%08lX 0x%08lX\n", "r0-r3", (unsigned long)report->r0,
+           (unsigned long)report->r1, (unsigned long)report->r2, (unsigned long)report->r3);
+    printf("  %-10s 0x%08lX\n", "r12", (unsigned long)report->r12);
+    printf("  %-10s 0x%08lX  exception %lu\n", "xpsr", (unsigned long)report->xpsr,
+           (unsigned long)(report->xpsr & 0x1FFU));
+    printf("  %-10s 0x%08lX  %s mode, %s, %s\n", "exc_return", (unsigned long)report->excReturn,
+           ((report->excReturn & 0x8U) != 0U) ? "thread" : "handler",
+           ((report->excReturn & 0x4U) != 0U) ? "PSP" : "MSP",
+           ((report->excReturn & 0x10U) != 0U) ? "no FPU state" : "FPU state stacked");
+    printBits("cfsr", report->cfsr, cfsrNames);
+    printBits("hfsr", report->hfsr, hfsrNames);
+    if ((report->cfsr & (1UL << 7)) != 0U)
+    {
+      symbolize(report->mmfar, name, sizeof(name));
+      printf("  %-10s 0x%08lX%s%s\n", "mmfar", (unsigned long)report->mmfar, (name[0] != '\0') ? "  " : "", name);
+    }
+    if ((report->cfsr & (1UL << 15)) != 0U)
+    {
+      symbolize(report->bfar, name, sizeof(name));
+      printf("  %-10s 0x%08lX%s%s\n", "bfar", (unsigned long)report->bfar, (name[0] != '\0') ? "  " : "", name);
+    }
+  }
+  printf("  %-10s 0x%08lX\n", "sp", (unsigned long)report->sp);
+
+  /* Words that land in a function are likely return addresses */
+  printf("stack, %u words from sp:\n", report->stackWords);
+  for (i = 0; (i < report->stackWords) && (i < CRASH_STACK_WORDS); i++)
+  {
+    int found = (report->stack[i] & 1U) && symbolize(report->stack[i] & ~1UL, name, sizeof(name));
+
+    printf("  0x%08lX 0x%08lX%s%s\n", (unsigned long)(report->sp + (i * 4U)), (unsigned long)report->stack[i],
+           found ? "  " : "", found ? name : "");
+  }
+
+  printf("trace, last %u events, time before the last one at %lu Hz:\n", report->traceEvents, clockHz);
+  last = (report->traceEvents != 0U) ? report->trace[report->traceEvents - 1U].time : 0U;
+  for (i = 0; (i < report->traceEvents) && (i < CRASH_TRACE_EVENTS); i++)
+  {
+    uint32_t event = report->trace[i].event;
+
+    printf("  %12.2f us  %-17s arg0=%-3u arg1=0x%04X (%u)\n",
+           0.0 - ((double)(uint32_t)(last - report->trace[i].time) * 1e6 / (double)clockHz),
+           eventName((uint8_t)(event >> 24)), (unsigned)((event >> 16) & 0xFFU),
+           (unsigned)(event & 0xFFFFU), (unsigned)(event & 0xFFFFU));
+  }
+}
+
+/*-------------------------------- retrieval ---------------------------------*/
+
+static void openSocket(const char *ifname)
+{
+  struct sockaddr_can addr;
+  struct ifreq ifr;
+  struct can_filter filter;
+
+  sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (sock < 0)
+  {
+    perror("socket(PF_CAN)");
+    exit(2);
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+  if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    exit(2);
+  }
+
+  /* PGN 0xEF00 and 0x1EF00 (data page ignored) from the node, to us */
+  filter.can_id = BOOT_CAN_ID(0, BOOT_PGN_CMD, src, node) | CAN_EFF_FLAG;
+  filter.can_mask = 0x02FFFFFFUL | CAN_EFF_FLAG;
+  (void)setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    exit(2);
+  }
+}
+
+static int readFrame(struct can_frame *cf, int timeoutMs)
+{
+  struct pollfd pfd = { .fd = sock, .events = POLLIN, .revents = 0 };
+
+  if (poll(&pfd, 1, timeoutMs) <= 0)
+  {
+    return -1;
+  }
+  return (read(sock, cf, sizeof(*cf)) == (ssize_t)sizeof(*cf)) ? 0 : -1;
+}
+
+static const char *statusName(uint8_t status)
+{
+  static const char *names[] = { "ok", "no report saved", "busy" };
+
+  return (status < (sizeof(names) / sizeof(names[0]))) ? names[status] : "unknown";
+}
+
+/* Sends a command and waits for its response */
+static int command(uint8_t cmd, struct can_frame *cf)
+{
+  memset(cf, 0, sizeof(*cf));
+  cf->can_id = BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, node, src) | CAN_EFF_FLAG;
+  cf->can_dlc = 8;
+  memset(cf->data, 0xFF, 8);
+  cf->data[0] = cmd;
+  if (write(sock, cf, sizeof(*cf)) != (ssize_t)sizeof(*cf))
+  {
+    perror("write");
+    return -1;
+  }
+  for (;;)
+  {
+    if (readFrame(cf, RESPONSE_TIMEOUT_MS) != 0)
+    {
+      fprintf(stderr, "no response\n");
+      return -1;
+    }
+    if ((BOOT_ID_PGN(cf->can_id & CAN_EFF_MASK) == BOOT_PGN_CMD) && (cf->data[0] == (cmd | BOOT_RSP)))
+    {
+      return 0;
+    }
+  }
+}
+
+/**
+  * @brief  Gets the report from the node and prints it
+  * @param  clear: CRASH_CLEAR once it has been received
+  * @retval 0 on success
+  */
+static int retrieve(int clear)
+{
+  Crash_Report report;
+  uint8_t data[REPORT_FRAMES * 7U];
+  uint8_t seen[REPORT_FRAMES] = { 0 };
+  struct can_frame cf;
+  uint32_t received = 0;
+  uint16_t crc;
+
+  if (command(CRASH_CMD_GET, &cf) != 0)
+  {
+    return -1;
+  }
+  if (cf.data[1] != CRASH_OK)
+  {
+    fprintf(stderr, "CRASH_GET: %s\n", statusName(cf.data[1]));
+    return (cf.data[1] == CRASH_ERR_NONE) ? 0 : -1;
+  }
+  if ((cf.data[3] | ((uint32_t)cf.data[4] << 8)) != REPORT_BYTES)
+  {
+    fprintf(stderr, "CRASH_GET: %u bytes, expected %u\n", cf.data[3] | ((unsigned)cf.data[4] << 8),
+            (unsigned)REPORT_BYTES);
+    return -1;
+  }
+  crc = (uint16_t)(cf.data[5] | ((uint16_t)cf.data[6] << 8));
+
+  while (received < REPORT_FRAMES)
+  {
+    if (readFrame(&cf, FRAME_TIMEOUT_MS) != 0)
+    {
+      fprintf(stderr, "transfer stalled after %u of %u frames\n", received, (unsigned)REPORT_FRAMES);
+      return -1;
+    }
+    if ((BOOT_ID_PGN(cf.can_id & CAN_EFF_MASK) == BOOT_PGN_DATA) && (cf.data[0] < REPORT_FRAMES) &&
+        !seen[cf.data[0]])
+    {
+      seen[cf.data[0]] = 1;
+      memcpy(&data[cf.data[0] * 7U], &cf.data[1], 7);
+      received++;
+    }
+  }
+  if (History_Crc16(0xFFFFU, data, REPORT_BYTES) != crc)
+  {
+    fprintf(stderr, "CRC mismatch\n");
+    return -1;
+  }
+  memcpy(&report, data, sizeof(report));
+  printReport(&report);
+
+  if (clear)
+  {
+    if (command(CRASH_CMD_CLEAR, &cf) != 0)
+    {
+      return -1;
+    }
+    fprintf(stderr, "CRASH_CLEAR: %s\n", statusName(cf.data[1]));
+  }
+  return 0;
+}
+
+/*---------------------------------- files -----------------------------------*/
+
+/**
+  * @brief  Prints every complete report the node sent in a log
+  * @param  path: candump log or pcap capture
+  * @retval reports found, -1 on error
+  */
+static int scanLog(const char *path)
+{
+  N2k_Log log;
+  N2k_Frame frame;
+  N2k_Id id;
+  uint8_t data[REPORT_FRAMES * 7U];
+  uint8_t seen[REPORT_FRAMES];
+  uint32_t received = 0;
+  uint16_t crc = 0;
+  uint8_t requester = 0;
+  int active = 0;
+  int reports = 0;
+  size_t pos;
+
+  if (N2k_Open(&log, path) != 0)
+  {
+    return -1;
+  }
+  pos = log.first;
+  while (N2k_Next(&log, &pos, log.size, &frame) > 0)
+  {
+    if (!frame.ext || frame.rtr || (frame.dlc < 8U))
+    {
+      continue;
+    }
+    N2k_SplitId(frame.id, &id);
+    if (id.src != node)
+    {
+      continue;
+    }
+    if ((id.pgn == BOOT_PGN_CMD) && (frame.data[0] == (CRASH_CMD_GET | BOOT_RSP)))
+    {
+      active = (frame.data[1] == CRASH_OK) &&
+               ((frame.data[3] | ((uint32_t)frame.data[4] << 8)) == REPORT_BYTES);
+      requester = id.dst;
+      crc = (uint16_t)(frame.data[5] | ((uint16_t)frame.data[6] << 8));
+      received = 0;
+      memset(seen, 0, sizeof(seen));
+    }
+    else if (active && (id.pgn == BOOT_PGN_DATA) && (id.dst == requester) && (frame.data[0] < REPORT_FRAMES) &&
+             !seen[frame.data[0]])
+    {
+      seen[frame.data[0]] = 1;
+      memcpy(&data[frame.data[0] * 7U], &frame.data[1], 7);
+      if (++received == REPORT_FRAMES)
+      {
+        Crash_Report report;
+
+        active = 0;
+        printf("%s%llu.%06u: report to 0x%02X, ", (reports != 0) ? "\n" : "", (unsigned long long)frame.sec,
+               (unsigned)frame.usec, requester);
+        if (History_Crc16(0xFFFFU, data, REPORT_BYTES) != crc)
+        {
+          printf("CRC mismatch\n");
+          continue;
+        }
+        memcpy(&report, data, sizeof(report));
+        printReport(&report);
+        reports++;
+      }
+    }
+  }
+  N2k_Close(&log);
+  return reports;
+}
+
+/**
+  * @brief  Prints the report of a simulator crash record file (-Z)
+  * @param  path: record file
+  * @retval 0 on success
+  */
+static int readRecord(const char *path)
+{
+  Crash_Record record;
+  FILE *f = fopen(path, "rb");
+
+  if ((f == NULL) || (fread(&record, sizeof(record), 1, f) != 1U))
+  {
+    fprintf(stderr, "%s: not a crash record\n", path);
+    if (f != NULL)
+    {
+      fclose(f);
+    }
+    return -1;
+  }
+  fclose(f);
+  if ((record.magic != CRASH_MAGIC) ||
+      (History_Crc16(0xFFFFU, (const uint8_t *)&record.report, REPORT_BYTES) != record.crc))
+  {
+    fprintf(stderr, "%s: no report saved\n", path);
+    return -1;
+  }
+  printf("record, %s: ", record.reported ? "sent" : "not sent yet");
+  printReport(&record.report);
+  return 0;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-e elf] [-a addr2line] [-c clock_hz] -i ifname [-n node] [-s src] [-x]\n"
+          "       %s [-e elf] [-a addr2line] [-c clock_hz] -r record\n"
+          "       %s [-e elf] [-a addr2line] [-c clock_hz] log...\n"
+          "  -e  resolve addresses with the symbols of this image (build/simplecan.elf)\n"
+          "  -a  also to file and line with this addr2line (arm-none-eabi-addr2line)\n"
+          "  -c  core clock for the trace times (default %lu)\n"
+          "  -i  get the report over this SocketCAN interface\n"
+          "  -n  node address (default 0x%02X)\n"
+          "  -s  our source address (default 0xFE)\n"
+          "  -x  clear the report on the node once received\n"
+          "  -r  read a crash record file of the simulator (-Z)\n"
+          "  log candump logs or pcap captures with reports the node sent\n",
+          prog, prog, prog, DEFAULT_CLOCK_HZ, BOOT_NODE_ADDRESS);
+}
+
+int main(int argc, char **argv)
+{
+  const char *ifname = NULL;
+  const char *recordPath = NULL;
+  int clear = 0;
+  int opt;
+  int reports = 0;
+
+  while ((opt = getopt(argc, argv, "e:a:c:i:n:s:xr:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'e': elfPath = optarg; break;
+      case 'a': addr2line = optarg; break;
+      case 'c': clockHz = strtoul(optarg, NULL, 0); break;
+      case 'i': ifname = optarg; break;
+      case 'n': node = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 's': src = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 'x': clear = 1; break;
+      case 'r': recordPath = optarg; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if ((clockHz == 0U) || (((ifname != NULL) + (recordPath != NULL) + (optind < argc)) != 1))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+  if ((elfPath != NULL) && (loadSymbols(elfPath) != 0))
+  {
+    return 2;
+  }
+
+  if (ifname != NULL)
+  {
+    openSocket(ifname);
+    return (retrieve(clear) == 0) ? 0 : 1;
+  }
+  if (recordPath != NULL)
+  {
+    return (readRecord(recordPath) == 0) ? 0 : 1;
+  }
+  for (; optind < argc; optind++)
+  {
+    int found = scanLog(argv[optind]);
+
+    if (found < 0)
+    {
+      return 2;
+    }
+    reports += found;
+  }
+  if (reports == 0)
+  {
+    fprintf(stderr, "no crash report found\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,296 @@
+/**
+  ******************************************************************************
+  * @file           : mapstat.c
+  * @brief          : Linker map analyzer: region usage, largest symbols, budgets
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Parses a GNU ld map file (-Wl,-Map) and prints FLASH/RAM/CCMRAM usage and
+  * the N largest functions and objects. Input sections are named after their
+  * -ffunction-sections/-fdata-sections suffix, so static functions show up
+  * even though they have no symbol line in the map.
+  *
+  * With budgets given, exits with status 1 when any region exceeds its budget
+  * so the Makefile can fail the build.
+  *
+  * Usage: mapstat [-n top] [-q] [-f flash] [-r ram] [-c ccmram] simplecan.map
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_ITEMS         4096U
+#define MAX_NAME          96U
+
+typedef enum
+{
+  REGION_NONE = 0,
+  REGION_FLASH,
+  REGION_RAM,
+  REGION_CCMRAM,
+  REGION_COUNT
+} Region;
+
+typedef struct
+{
+  char name[MAX_NAME];
+  char kind[8];
+  char object[MAX_NAME];
+  unsigned long addr;
+  unsigned long size;
+  Region region;
+} Item;
+
+static const char *regionName[REGION_COUNT] = { "-", "FLASH", "RAM", "CCMRAM" };
+static const unsigned long regionSize[REGION_COUNT] = { 0, 64UL * 1024UL, 12UL * 1024UL, 4UL * 1024UL };
+
+static Item items[MAX_ITEMS];
+static size_t itemCount;
+static unsigned long used[REGION_COUNT];
+
+static Region regionOf(unsigned long addr)
+{
+  if ((addr >= 0x08000000UL) && (addr < 0x08100000UL))
+  {
+    return REGION_FLASH;
+  }
+  if ((addr >= 0x20000000UL) && (addr < 0x20010000UL))
+  {
+    return REGION_RAM;
+  }
+  if ((addr >= 0x10000000UL) && (addr < 0x10010000UL))
+  {
+    return REGION_CCMRAM;
+  }
+  return REGION_NONE;
+}
+
+/* ".text.CAN_Receive" -> kind "text", name "CAN_Receive" */
+static void splitSection(const char *section, Item *it)
+{
+  static const char *kinds[] = { "text", "rodata", "data", "bss", "ccmram", "ccmbss", "RamFunc" };
+  const char *p = section + 1;
+  size_t i;
+
+  strcpy(it->kind, "other");
+  it->name[0] = '\0';
+  for (i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++)
+  {
+    size_t n = strlen(kinds[i]);
+
+    if ((section[0] == '.') && (strncmp(p, kinds[i], n) == 0) && ((p[n] == '.') || (p[n] == '\0')))
+    {
+      snprintf(it->kind, sizeof(it->kind), "%.7s", kinds[i]);
+      /* .ccmram.text/.ccmram.data hold several functions: named by first symbol */
+      if ((p[n] == '.') && (strncmp(p, "ccm", 3) != 0))
+      {
+        snprintf(it->name, sizeof(it->name), "%.*s", (int)MAX_NAME - 1, p + n + 1);
+      }
+      return;
+    }
+  }
+  snprintf(it->name, sizeof(it->name), "%.*s", (int)MAX_NAME - 1, section);
+}
+
+static const char *baseName(const char *path)
+{
+  const char *slash = strrchr(path, '/');
+
+  return (slash != NULL) ? slash + 1 : path;
+}
+
+static int bySizeDesc(const void *a, const void *b)
+{
+  const Item *x = (const Item *)a;
+  const Item *y = (const Item *)b;
+
+  return (x->size < y->size) ? 1 : ((x->size > y->size) ? -1 : 0);
+}
+
+int main(int argc, char **argv)
+{
+  FILE *in;
+  char line[1024];
+  char pending[MAX_NAME] = "";
+  int pendingOutput = 0;
+  Item *last = NULL;
+  unsigned long budget[REGION_COUNT] = { 0, 0, 0, 0 };
+  unsigned top = 20;
+  int quiet = 0;
+  int inMap = 0;
+  int opt;
+  int r;
+  int failed = 0;
+  size_t i;
+
+  while ((opt = getopt(argc, argv, "n:qf:r:c:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': top = (unsigned)strtoul(optarg, NULL, 0); break;
+      case 'q': quiet = 1; break;
+      case 'f': budget[REGION_FLASH] = strtoul(optarg, NULL, 0); break;
+      case 'r': budget[REGION_RAM] = strtoul(optarg, NULL, 0); break;
+      case 'c': budget[REGION_CCMRAM] = strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-n top] [-q] [-f flash] [-r ram] [-c ccmram] file.map\n", argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (optind >= argc)
+  {
+    fprintf(stderr, "usage: %s [-n top] [-q] [-f flash] [-r ram] [-c ccmram] file.map\n", argv[0]);
+    return 2;
+  }
+
+  in = fopen(argv[optind], "r");
+  if (in == NULL)
+  {
+    perror(argv[optind]);
+    return 2;
+  }
+
+  while (fgets(line, sizeof(line), in) != NULL)
+  {
+    char name[256];
+    char object[512];
+    unsigned long addr;
+    unsigned long size;
+    unsigned long lma;
+    int n;
+
+    line[strcspn(line, "\r\n")] = '\0';
+
+    if (!inMap)
+    {
+      /* Skip "Discarded input sections" and the memory configuration */
+      inMap = (strncmp(line, "Linker script and memory map", 28) == 0);
+      continue;
+    }
+
+    /* Output section: ".data  0x20000000  0x10 load address 0x08003f40",
+     * long names ("._user_heap_stack") carry the numbers on the next line */
+    n = 0;
+    if ((line[0] == '.') && (sscanf(line, "%255s 0x%lx 0x%lx%n", name, &addr, &size, &n) == 1))
+    {
+      pendingOutput = 1;
+      continue;
+    }
+    if ((n > 0) || (pendingOutput && (sscanf(line, " 0x%lx 0x%lx%n", &addr, &size, &n) == 2)))
+    {
+      Region reg = regionOf(addr);
+
+      used[reg] += size;
+      if ((sscanf(line + n, " load address 0x%lx", &lma) == 1) && (regionOf(lma) != reg))
+      {
+        used[regionOf(lma)] += size;
+      }
+      pending[0] = '\0';
+      pendingOutput = 0;
+      last = NULL;
+      continue;
+    }
+    pendingOutput = 0;
+
+    if ((line[0] != ' ') || (line[1] == ' '))
+    {
+      /* Continuation line: symbol "  0xaddr  name" or wrapped section info */
+      if (pending[0] != '\0')
+      {
+        if (sscanf(line, " 0x%lx 0x%lx %511s", &addr, &size, object) == 3)
+        {
+          snprintf(name, sizeof(name), "%.*s", (int)MAX_NAME - 1, pending);
+          pending[0] = '\0';
+          goto add_item;
+        }
+        pending[0] = '\0';
+      }
+      else if ((last != NULL) && (last->name[0] == '\0') &&
+               (sscanf(line, " 0x%lx %255s", &addr, name) == 2) && (name[0] != '0'))
+      {
+        /* Unnamed section (e.g. plain .text from assembly): use first symbol */
+        snprintf(last->name, sizeof(last->name), "%.*s", (int)MAX_NAME - 1, name);
+      }
+      continue;
+    }
+
+    /* Input section: " .text.main  0x08000abc  0x1c4 build/main.o" or
+     * a long name alone on the line, with the numbers on the next one */
+    r = sscanf(line, " %255s 0x%lx 0x%lx %511s", name, &addr, &size, object);
+    if ((r == 1) && (name[0] == '.'))
+    {
+      snprintf(pending, sizeof(pending), "%.*s", (int)MAX_NAME - 1, name);
+      continue;
+    }
+    if ((r == 4) && (strcmp(name, "COMMON") == 0))
+    {
+      strcpy(name, ".bss");
+    }
+    if ((r != 4) || (name[0] != '.'))
+    {
+      continue;
+    }
+
+add_item:
+    last = NULL;
+    if ((size == 0U) || (regionOf(addr) == REGION_NONE) || (itemCount >= MAX_ITEMS))
+    {
+      continue;
+    }
+    last = &items[itemCount++];
+    splitSection(name, last);
+    snprintf(last->object, sizeof(last->object), "%.*s", (int)MAX_NAME - 1, baseName(object));
+    last->addr = addr;
+    last->size = size;
+    last->region = regionOf(addr);
+  }
+  fclose(in);
+
+  if (!inMap)
+  {
+    fprintf(stderr, "%s: not a GNU ld map file\n", argv[optind]);
+    return 2;
+  }
+
+  if (!quiet)
+  {
+    qsort(items, itemCount, sizeof(items[0]), bySizeDesc);
+
+    printf("===== Largest functions and objects (top %u of %zu) =====\n", top, itemCount);
+    printf("%8s  %-6s %-7s %-40s %s\n", "bytes", "region", "kind", "name", "object");
+    for (i = 0; (i < itemCount) && (i < top); i++)
+    {
+      printf("%8lu  %-6s %-7s %-40s %s\n", items[i].size, regionName[items[i].region],
+             items[i].kind, (items[i].name[0] != '\0') ? items[i].name : "(anonymous)",
+             items[i].object);
+    }
+    printf("\n");
+  }
+
+  printf("===== Region usage =====\n");
+  for (r = REGION_FLASH; r < REGION_COUNT; r++)
+  {
+    printf("  %-7s %7lu / %7lu bytes (%5.1f%%)", regionName[r], used[r], regionSize[r],
+           100.0 * (double)used[r] / (double)regionSize[r]);
+    if (budget[r] != 0U)
+    {
+      printf("  budget %7lu %s", budget[r], (used[r] > budget[r]) ? "EXCEEDED" : "ok");
+      failed |= (used[r] > budget[r]);
+    }
+    printf("\n");
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,455 @@
+/**
+  ******************************************************************************
+  * @file           : n2kdump.c
+  * @brief          : candump / pcap log to CSV decoder, multi-threaded
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Decodes candump text logs and SocketCAN pcap captures (n2klog.h) into CSV
+  * on stdout, one line per frame.
+  *
+  * The mapped log is cut into chunks of CHUNK_SIZE at record boundaries.
+  * Worker threads take the next chunk, format it into the chunk's own output
+  * buffer and the main thread writes the buffers out in file order, so the
+  * output is the same for any number of threads. At most SLOTS_PER_THREAD
+  * chunks per thread are in flight, which bounds the memory used whatever
+  * the size of the log. Statistics go to stderr.
+  *
+  * -g writes a synthetic log of the given size instead (A1 at 30 Hz, T1 at
+  * 1 Hz, parameter requests from a service tool), for the benchmark.
+  *
+  * Usage: n2kdump [-j threads] [-p pgn] [-q] log...
+  *        n2kdump -g size[K|M|G] [-b] file
+  */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "n2klog.h"
+#include "boot.h"
+#include "params.h"
+
+#define CHUNK_SIZE          (4UL << 20)
+#define SLOTS_PER_THREAD    2U
+#define MAX_THREADS         64U
+
+enum
+{
+  SLOT_FREE = 0,
+  SLOT_BUSY,
+  SLOT_DONE
+};
+
+typedef struct
+{
+  size_t start;
+  size_t end;
+  char *out;
+  size_t outSize;
+  size_t outLength;
+  uint64_t frames;
+  int state;
+} Slot;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static Slot slots[MAX_THREADS * SLOTS_PER_THREAD];
+static uint32_t slotCount;
+static uint64_t nextChunk;
+static size_t nextStart;
+
+static N2k_Log input;
+static int csv = 1;
+static int filterPgn;
+static uint32_t pgn;
+
+static uint64_t nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int writeAll(int fd, const char *data, size_t length)
+{
+  while (length > 0U)
+  {
+    ssize_t n = write(fd, data, length);
+
+    if (n < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      perror("write");
+      return -1;
+    }
+    data += n;
+    length -= (size_t)n;
+  }
+  return 0;
+}
+
+/* Formats one chunk into its slot; the buffer grows, it is never freed */
+static void decodeChunk(Slot *slot)
+{
+  size_t pos = slot->start;
+  N2k_Frame frame;
+
+  slot->outLength = 0;
+  slot->frames = 0;
+  while (N2k_Next(&input, &pos, slot->end, &frame))
+  {
+    if (filterPgn)
+    {
+      N2k_Id fields;
+
+      if (!frame.ext)
+      {
+        continue;
+      }
+      N2k_SplitId(frame.id, &fields);
+      if (fields.pgn != pgn)
+      {
+        continue;
+      }
+    }
+    slot->frames++;
+    if (!csv)
+    {
+      continue;
+    }
+    if ((slot->outSize - slot->outLength) < N2K_CSV_MAX)
+    {
+      size_t size = (slot->outSize == 0U) ? (CHUNK_SIZE * 2U) : (slot->outSize * 2U);
+      char *out = realloc(slot->out, size);
+
+      if (out == NULL)
+      {
+        perror("output buffer");
+        exit(2);
+      }
+      slot->out = out;
+      slot->outSize = size;
+    }
+    slot->outLength += N2k_FormatCsv(&slot->out[slot->outLength], &frame);
+  }
+}
+
+static void *worker(void *arg)
+{
+  (void)arg;
+  for (;;)
+  {
+    Slot *slot;
+
+    pthread_mutex_lock(&lock);
+    while ((nextStart < input.size) && (slots[nextChunk % slotCount].state != SLOT_FREE))
+    {
+      pthread_cond_wait(&changed, &lock);
+    }
+    if (nextStart >= input.size)
+    {
+      pthread_mutex_unlock(&lock);
+      return NULL;
+    }
+    slot = &slots[nextChunk % slotCount];
+    slot->start = nextStart;
+    slot->end = N2k_ChunkEnd(&input, nextStart, CHUNK_SIZE);
+    slot->state = SLOT_BUSY;
+    nextStart = slot->end;
+    nextChunk++;
+    pthread_mutex_unlock(&lock);
+
+    decodeChunk(slot);
+
+    pthread_mutex_lock(&lock);
+    slot->state = SLOT_DONE;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+  }
+}
+
+/**
+  * @brief  Decodes one log to stdout
+  * @param  path: log file
+  * @param  threads: worker threads
+  * @param  frames: frames decoded, added to
+  * @param  bytes: log bytes, added to
+  * @retval 0 on success
+  */
+static int decodeLog(const char *path, uint32_t threads, uint64_t *frames, uint64_t *bytes)
+{
+  pthread_t ids[MAX_THREADS];
+  uint64_t written = 0;
+  int status = 0;
+  uint32_t i;
+
+  if (N2k_Open(&input, path) != 0)
+  {
+    return -1;
+  }
+  slotCount = threads * SLOTS_PER_THREAD;
+  nextChunk = 0;
+  nextStart = input.first;
+  for (i = 0; i < slotCount; i++)
+  {
+    slots[i].state = SLOT_FREE;
+  }
+  for (i = 0; i < threads; i++)
+  {
+    if (pthread_create(&ids[i], NULL, worker, NULL) != 0)
+    {
+      perror("pthread_create");
+      exit(2);
+    }
+  }
+
+  /* Write the chunks out in order as they complete */
+  pthread_mutex_lock(&lock);
+  for (;;)
+  {
+    Slot *slot = &slots[written % slotCount];
+
+    while ((written == nextChunk) ? (nextStart < input.size) : (slot->state != SLOT_DONE))
+    {
+      pthread_cond_wait(&changed, &lock);
+    }
+    if (written == nextChunk)
+    {
+      break;
+    }
+    pthread_mutex_unlock(&lock);
+
+    if ((status == 0) && (slot->outLength != 0U))
+    {
+      status = writeAll(STDOUT_FILENO, slot->out, slot->outLength);
+    }
+    *frames += slot->frames;
+
+    pthread_mutex_lock(&lock);
+    slot->state = SLOT_FREE;
+    written++;
+    pthread_cond_broadcast(&changed);
+  }
+  pthread_mutex_unlock(&lock);
+
+  for (i = 0; i < threads; i++)
+  {
+    pthread_join(ids[i], NULL);
+  }
+  *bytes += input.size;
+  N2k_Close(&input);
+  return status;
+}
+
+/*--------------------------------- generator --------------------------------*/
+
+static void putLe32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static void putFrame(FILE *f, int pcap, uint64_t timeUs, uint32_t id, int ext, const uint8_t *data, uint8_t dlc)
+{
+  if (pcap)
+  {
+    uint8_t record[32] = { 0 };
+    uint32_t canId = id | (ext ? 0x80000000UL : 0U);
+
+    putLe32(record, (uint32_t)(timeUs / 1000000U));
+    putLe32(&record[4], (uint32_t)(timeUs % 1000000U));
+    putLe32(&record[8], 16);
+    putLe32(&record[12], 16);
+    record[16] = (uint8_t)(canId >> 24);
+    record[17] = (uint8_t)(canId >> 16);
+    record[18] = (uint8_t)(canId >> 8);
+    record[19] = (uint8_t)canId;
+    record[20] = dlc;
+    memcpy(&record[24], data, dlc);
+    (void)fwrite(record, 1, sizeof(record), f);
+  }
+  else
+  {
+    uint8_t i;
+
+    fprintf(f, "(%010llu.%06u) can0 ", (unsigned long long)(timeUs / 1000000U), (unsigned)(timeUs % 1000000U));
+    fprintf(f, ext ? "%08X#" : "%03X#", id);
+    for (i = 0; i < dlc; i++)
+    {
+      fprintf(f, "%02X", data[i]);
+    }
+    fputc('\n', f);
+  }
+}
+
+/**
+  * @brief  Writes a synthetic log of about the given size
+  * @param  path: destination
+  * @param  size: bytes to write
+  * @param  pcap: pcap instead of candump -l text
+  * @retval 0 on success
+  */
+static int generate(const char *path, uint64_t size, int pcap)
+{
+  static const uint8_t a1[8] = { 0xDE, 0xAD, 0xBE, 0xEF, 0, 0, 0, 0 };
+  FILE *f = fopen(path, "wb");
+  uint64_t timeUs = 1767225600ULL * 1000000U;
+  uint32_t tick = 0;
+  uint32_t seed = 1;
+
+  if (f == NULL)
+  {
+    perror(path);
+    return -1;
+  }
+  if (pcap)
+  {
+    uint8_t header[24] = { 0 };
+
+    putLe32(header, 0xA1B2C3D4UL);
+    header[4] = 2;
+    header[6] = 4;
+    putLe32(&header[16], 16);
+    putLe32(&header[20], 227);
+    (void)fwrite(header, 1, sizeof(header), f);
+  }
+
+  while ((uint64_t)ftello(f) < size)
+  {
+    putFrame(f, pcap, timeUs, 0x0A1, 0, a1, 8);
+    if ((tick % 30U) == 0U)
+    {
+      /* T1: 25 degC with a slow swing and a little noise */
+      uint32_t kelvin;
+      uint8_t t1[8] = { 0, 0, 1, 0, 0, 0xFF, 0xFF, 0xFF };
+
+      seed = seed * 1103515245U + 12345U;
+      kelvin = 29815U + ((tick / 30U) % 600U) + ((seed >> 16) % 8U);
+      t1[0] = (uint8_t)(tick / 30U);
+      t1[3] = (uint8_t)kelvin;
+      t1[4] = (uint8_t)(kelvin >> 8);
+      putFrame(f, pcap, timeUs + 500U, (6UL << 26) | (130312UL << 8) | 0x01UL, 1, t1, 8);
+    }
+    if ((tick % 300U) == 150U)
+    {
+      uint8_t get[3] = { PARAMS_CMD_GET, (uint8_t)PARAM_T1_PERIOD_MS, 0 };
+      uint8_t rsp[8] = { PARAMS_CMD_GET | BOOT_RSP, PARAMS_OK, (uint8_t)PARAM_T1_PERIOD_MS, 0, 0xE8, 0x03, 0, 0 };
+
+      putFrame(f, pcap, timeUs + 900U, BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, BOOT_NODE_ADDRESS, 0x80UL), 1, get, 3);
+      putFrame(f, pcap, timeUs + 1300U, BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, 0x80UL, BOOT_NODE_ADDRESS), 1, rsp, 8);
+    }
+    timeUs += 33333U;
+    tick++;
+  }
+  if (fclose(f) != 0)
+  {
+    perror(path);
+    return -1;
+  }
+  return 0;
+}
+
+static uint64_t parseSize(const char *text)
+{
+  char *end;
+  uint64_t value = strtoull(text, &end, 0);
+
+  switch (*end)
+  {
+    case 'k': case 'K': return value << 10;
+    case 'm': case 'M': return value << 20;
+    case 'g': case 'G': return value << 30;
+    default: return value;
+  }
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-j threads] [-p pgn] [-q] log...\n"
+          "       %s -g size[K|M|G] [-b] file\n"
+          "  -j  decoding threads (default: one per CPU)\n"
+          "  -p  only frames of this PGN\n"
+          "  -q  count frames, no CSV (parsing speed)\n"
+          "  -g  write a synthetic log of this size\n"
+          "  -b  synthetic log as pcap instead of candump text\n", prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t threads = (cpus > 0) ? (uint32_t)cpus : 1U;
+  uint64_t generateSize = 0;
+  uint64_t frames = 0;
+  uint64_t bytes = 0;
+  uint64_t start;
+  double seconds;
+  int pcap = 0;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "j:p:qg:bh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'j': threads = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'p': filterPgn = 1; pgn = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'q': csv = 0; break;
+      case 'g': generateSize = parseSize(optarg); break;
+      case 'b': pcap = 1; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (optind >= argc)
+  {
+    usage(argv[0]);
+    return 2;
+  }
+  if (generateSize != 0U)
+  {
+    return ((optind == (argc - 1)) && (generate(argv[optind], generateSize, pcap) == 0)) ? 0 : 1;
+  }
+  threads = (threads == 0U) ? 1U : ((threads > MAX_THREADS) ? MAX_THREADS : threads);
+
+  if (csv && (writeAll(STDOUT_FILENO, N2k_CsvHeader, strlen(N2k_CsvHeader)) != 0))
+  {
+    return 1;
+  }
+  start = nowNs();
+  for (i = optind; i < argc; i++)
+  {
+    if (decodeLog(argv[i], threads, &frames, &bytes) != 0)
+    {
+      return 1;
+    }
+  }
+  seconds = (double)(nowNs() - start) / 1e9;
+  fprintf(stderr, "%llu frames, %.1f MB in %.3f s, %.1f MB/s, %.2f M frames/s, %u thread%s%s\n",
+          (unsigned long long)frames, (double)bytes / 1e6, seconds,
+          (seconds > 0.0) ? ((double)bytes / 1e6 / seconds) : 0.0,
+          (seconds > 0.0) ? ((double)frames / 1e6 / seconds) : 0.0,
+          threads, (threads == 1U) ? "" : "s", csv ? "" : ", parse only");
+  return 0;
+}
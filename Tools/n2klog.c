@@ -0,0 +1,833 @@
+/**
+  ******************************************************************************
+  * @file           : n2klog.c
+  * @brief          : Memory-mapped CAN log reader and NMEA 2000 decoder
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "n2klog.h"
+#include "boot.h"
+#include "history.h"
+#include "params.h"
+#include "nmea.h"
+#include "watchdog.h"
+#include "crash.h"
+#include "ram.h"
+#include "cpu.h"
+#include "alarm.h"
+#include "status.h"
+#include "trend.h"
+
+#define PCAP_MAGIC_US       0xA1B2C3D4UL
+#define PCAP_MAGIC_NS       0xA1B23C4DUL
+#define PCAP_HEADER_SIZE    24U
+#define PCAP_RECORD_SIZE    16U
+#define PCAP_CAN_SOCKETCAN  227U
+
+/* SocketCAN identifier flags (linux/can.h), big endian in pcap */
+#define SOCKETCAN_EFF       0x80000000UL
+#define SOCKETCAN_RTR       0x40000000UL
+#define SOCKETCAN_ERR       0x20000000UL
+
+#define PGN_TEMPERATURE     130312UL
+#define TEMP_NOT_AVAILABLE  0xFFFFU
+
+/* UWB distance, WHICH-PGN-SELECT-FOR-UWB-DISTANCE.md: the standard water
+ * depth PGN with the distance as the depth, or proprietary PGN 65280 in the
+ * single-anchor layout (option D) the document settles on */
+#define PGN_WATER_DEPTH     128267UL
+#define DEPTH_NOT_AVAILABLE 0xFFFFFFFFUL
+#define PGN_UWB_DISTANCE    65280UL
+#define UWB_NOT_AVAILABLE   0xFFFFU
+#define UWB_QUALITY_NA      0xFFU
+
+const char N2k_CsvHeader[] =
+  "time,iface,id,prio,pgn,src,dst,dlc,data,message,sid,instance,source,value,unit\n";
+
+/*------------------------------------ open ----------------------------------*/
+
+static uint32_t getLe32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t getBe32(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint32_t getPcap32(const N2k_Log *log, const uint8_t *p)
+{
+  return log->swapped ? getBe32(p) : getLe32(p);
+}
+
+/**
+  * @brief  Maps a log and detects its format
+  * @param  log: destination
+  * @param  path: file name
+  * @retval 0 on success, -1 with a message on stderr
+  */
+int N2k_Open(N2k_Log *log, const char *path)
+{
+  struct stat st;
+  int fd;
+
+  memset(log, 0, sizeof(*log));
+  fd = open(path, O_RDONLY);
+  if ((fd < 0) || (fstat(fd, &st) != 0))
+  {
+    perror(path);
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    return -1;
+  }
+  log->size = (size_t)st.st_size;
+  if (log->size != 0U)
+  {
+    void *map = mmap(NULL, log->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map == MAP_FAILED)
+    {
+      perror(path);
+      close(fd);
+      return -1;
+    }
+    (void)madvise(map, log->size, MADV_SEQUENTIAL);
+    log->base = map;
+  }
+  close(fd);
+
+  if (log->size >= PCAP_HEADER_SIZE)
+  {
+    uint32_t magic = getLe32(log->base);
+    uint32_t swappedMagic = getBe32(log->base);
+
+    if ((magic == PCAP_MAGIC_US) || (magic == PCAP_MAGIC_NS) ||
+        (swappedMagic == PCAP_MAGIC_US) || (swappedMagic == PCAP_MAGIC_NS))
+    {
+      log->format = N2K_FORMAT_PCAP;
+      log->swapped = (swappedMagic == PCAP_MAGIC_US) || (swappedMagic == PCAP_MAGIC_NS);
+      log->nanoseconds = (magic == PCAP_MAGIC_NS) || (swappedMagic == PCAP_MAGIC_NS);
+      log->first = PCAP_HEADER_SIZE;
+      if (getPcap32(log, &log->base[20]) != PCAP_CAN_SOCKETCAN)
+      {
+        fprintf(stderr, "%s: pcap link type %u, not CAN_SOCKETCAN\n", path, getPcap32(log, &log->base[20]));
+        N2k_Close(log);
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+void N2k_Close(N2k_Log *log)
+{
+  if (log->base != NULL)
+  {
+    (void)munmap((void *)log->base, log->size);
+  }
+  memset(log, 0, sizeof(*log));
+}
+
+/**
+  * @brief  Finds the end of a chunk
+  * @param  log: mapped log
+  * @param  start: record boundary the chunk starts at
+  * @param  want: chunk size wanted
+  * @retval offset of the first record boundary at or after start + want,
+  *         the file size at the end
+  *
+  * Text is cut after a newline. A pcap file has no markers to resync on, so
+  * its record headers are walked from start.
+  */
+size_t N2k_ChunkEnd(const N2k_Log *log, size_t start, size_t want)
+{
+  size_t pos = start;
+
+  if ((log->size - start) <= want)
+  {
+    return log->size;
+  }
+  if (log->format == N2K_FORMAT_TEXT)
+  {
+    const uint8_t *nl = memchr(&log->base[start + want], '\n', log->size - start - want);
+
+    return (nl == NULL) ? log->size : (size_t)(nl - log->base) + 1U;
+  }
+  while ((pos - start) < want)
+  {
+    size_t next;
+
+    if ((log->size - pos) < PCAP_RECORD_SIZE)
+    {
+      return log->size;
+    }
+    next = pos + PCAP_RECORD_SIZE + getPcap32(log, &log->base[pos + 8U]);
+    if ((next > log->size) || (next <= pos))
+    {
+      return log->size;
+    }
+    pos = next;
+  }
+  return pos;
+}
+
+/*----------------------------------- parse ----------------------------------*/
+
+static int hexDigit(uint8_t c)
+{
+  if ((c >= '0') && (c <= '9'))
+  {
+    return c - '0';
+  }
+  c |= 0x20U;
+  if ((c >= 'a') && (c <= 'f'))
+  {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+static const uint8_t *skipSpaces(const uint8_t *p, const uint8_t *end)
+{
+  while ((p < end) && ((*p == ' ') || (*p == '\t')))
+  {
+    p++;
+  }
+  return p;
+}
+
+/* Two hex digits, -1 if there are not */
+static int hexByte(const uint8_t *p, const uint8_t *end)
+{
+  int hi;
+  int lo;
+
+  if ((end - p) < 2)
+  {
+    return -1;
+  }
+  hi = hexDigit(p[0]);
+  lo = hexDigit(p[1]);
+  return ((hi < 0) || (lo < 0)) ? -1 : ((hi << 4) | lo);
+}
+
+/**
+  * @brief  Parses one candump line
+  * @retval 1 on a frame, 0 if the line is not one (comment, CAN FD, error)
+  */
+static int parseLine(const uint8_t *p, const uint8_t *end, N2k_Frame *frame)
+{
+  const uint8_t *start;
+  uint32_t digits = 0;
+  uint32_t id = 0;
+  int d;
+
+  frame->sec = 0;
+  frame->usec = 0;
+  frame->rtr = 0;
+  frame->dlc = 0;
+
+  p = skipSpaces(p, end);
+  if ((p < end) && (*p == '('))
+  {
+    uint32_t scale = 100000U;
+
+    for (p++; (p < end) && (*p >= '0') && (*p <= '9'); p++)
+    {
+      frame->sec = (frame->sec * 10U) + (uint64_t)(*p - '0');
+    }
+    if ((p < end) && (*p == '.'))
+    {
+      for (p++; (p < end) && (*p >= '0') && (*p <= '9'); p++)
+      {
+        frame->usec += (uint32_t)(*p - '0') * scale;
+        scale /= 10U;
+      }
+    }
+    /* -ta dates and the like are not timestamps we can use */
+    while ((p < end) && (*p != ')'))
+    {
+      frame->sec = 0;
+      frame->usec = 0;
+      p++;
+    }
+    p = skipSpaces(p + 1, end);
+  }
+
+  start = p;
+  while ((p < end) && (*p != ' ') && (*p != '\t'))
+  {
+    p++;
+  }
+  if ((p == start) || ((p - start) > 255))
+  {
+    return 0;
+  }
+  frame->iface = (const char *)start;
+  frame->ifaceLength = (uint8_t)(p - start);
+  p = skipSpaces(p, end);
+
+  while ((p < end) && ((d = hexDigit(*p)) >= 0))
+  {
+    id = (id << 4) | (uint32_t)d;
+    digits++;
+    p++;
+  }
+  if ((digits != 3U) && (digits != 8U))
+  {
+    return 0;
+  }
+  frame->ext = (digits == 8U);
+  frame->id = id & (frame->ext ? 0x1FFFFFFFUL : 0x7FFUL);
+  if (frame->ext && ((id & SOCKETCAN_ERR) != 0U))
+  {
+    return 0;
+  }
+
+  if ((p < end) && (*p == '#'))
+  {
+    /* File format: ID#data, ID#R, ID##flags data for CAN FD */
+    p++;
+    if ((p < end) && (*p == '#'))
+    {
+      return 0;
+    }
+    if ((p < end) && (*p == 'R'))
+    {
+      frame->rtr = 1;
+      frame->dlc = ((p + 1) < end) ? (uint8_t)(hexDigit(p[1]) & 0x0F) : 0U;
+      frame->dlc = (frame->dlc > 8U) ? 8U : frame->dlc;
+      return 1;
+    }
+    while ((frame->dlc < 8U) && ((d = hexByte(p, end)) >= 0))
+    {
+      frame->data[frame->dlc++] = (uint8_t)d;
+      p += 2;
+      if ((p < end) && (*p == '.'))
+      {
+        p++;
+      }
+    }
+    return 1;
+  }
+
+  /* Screen format: ID  [n]  bytes, or "remote request" */
+  p = skipSpaces(p, end);
+  if (((end - p) < 3) || (p[0] != '[') || (p[1] < '0') || (p[1] > '8') || (p[2] != ']'))
+  {
+    return 0;
+  }
+  frame->dlc = (uint8_t)(p[1] - '0');
+  p = skipSpaces(p + 3, end);
+  if ((p < end) && (*p == 'r'))
+  {
+    frame->rtr = 1;
+    return 1;
+  }
+  for (digits = 0; digits < frame->dlc; digits++)
+  {
+    if ((d = hexByte(p, end)) < 0)
+    {
+      return 0;
+    }
+    frame->data[digits] = (uint8_t)d;
+    p = skipSpaces(p + 2, end);
+  }
+  return 1;
+}
+
+/**
+  * @brief  Reads the next frame of a chunk
+  * @param  log: mapped log
+  * @param  pos: offset of the next record, advanced
+  * @param  end: end of the chunk, a record boundary
+  * @param  frame: destination
+  * @retval 1 on a frame, 0 at the end of the chunk
+  *
+  * Lines and records that are not classic CAN frames are skipped.
+  */
+int N2k_Next(const N2k_Log *log, size_t *pos, size_t end, N2k_Frame *frame)
+{
+  if (log->format == N2K_FORMAT_TEXT)
+  {
+    while (*pos < end)
+    {
+      const uint8_t *line = &log->base[*pos];
+      const uint8_t *nl = memchr(line, '\n', end - *pos);
+      const uint8_t *lineEnd = (nl == NULL) ? &log->base[end] : nl;
+
+      *pos = (size_t)(lineEnd - log->base) + ((nl == NULL) ? 0U : 1U);
+      if (parseLine(line, lineEnd, frame))
+      {
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  while ((end - *pos) >= PCAP_RECORD_SIZE)
+  {
+    const uint8_t *record = &log->base[*pos];
+    uint32_t length = getPcap32(log, &record[8]);
+    const uint8_t *data = &record[PCAP_RECORD_SIZE];
+    uint32_t id;
+
+    if ((end - *pos - PCAP_RECORD_SIZE) < length)
+    {
+      *pos = end;
+      return 0;
+    }
+    *pos += PCAP_RECORD_SIZE + length;
+    if (length < 8U)
+    {
+      continue;
+    }
+    /* CAN_SOCKETCAN keeps the identifier in network byte order */
+    id = getBe32(data);
+    if (((id & SOCKETCAN_ERR) != 0U) || (data[4] > 8U))
+    {
+      continue;
+    }
+    frame->sec = getPcap32(log, record);
+    frame->usec = getPcap32(log, &record[4]);
+    if (log->nanoseconds)
+    {
+      frame->usec /= 1000U;
+    }
+    frame->ext = ((id & SOCKETCAN_EFF) != 0U);
+    frame->rtr = ((id & SOCKETCAN_RTR) != 0U);
+    frame->id = id & (frame->ext ? 0x1FFFFFFFUL : 0x7FFUL);
+    frame->dlc = data[4];
+    frame->iface = NULL;
+    frame->ifaceLength = 0;
+    memset(frame->data, 0, sizeof(frame->data));
+    memcpy(frame->data, &data[8], ((length - 8U) < frame->dlc) ? (length - 8U) : frame->dlc);
+    return 1;
+  }
+  *pos = end;
+  return 0;
+}
+
+/*---------------------------------- decode ----------------------------------*/
+
+void N2k_SplitId(uint32_t id, N2k_Id *out)
+{
+  uint32_t pf = (id >> 16) & 0xFFU;
+
+  out->prio = (uint8_t)((id >> 26) & 0x07U);
+  out->src = (uint8_t)id;
+  out->pgn = (id >> 8) & 0x3FFFFUL;
+  if (pf < 0xF0U)
+  {
+    out->dst = (uint8_t)(id >> 8);
+    out->pgn &= 0x3FF00UL;
+  }
+  else
+  {
+    out->dst = N2K_GLOBAL;
+  }
+}
+
+static char *putString(char *p, const char *s)
+{
+  while (*s != '\0')
+  {
+    *p++ = *s++;
+  }
+  return p;
+}
+
+static char *putDecimal(char *p, uint64_t value)
+{
+  char digits[20];
+  int n = 0;
+
+  do
+  {
+    digits[n++] = (char)('0' + (value % 10U));
+    value /= 10U;
+  } while (value != 0U);
+  while (n > 0)
+  {
+    *p++ = digits[--n];
+  }
+  return p;
+}
+
+/* Exactly n digits, zero padded */
+static char *putDigits(char *p, uint32_t value, int n)
+{
+  char *end = p + n;
+
+  while (n-- > 0)
+  {
+    p[n] = (char)('0' + (value % 10U));
+    value /= 10U;
+  }
+  return end;
+}
+
+static char *putHex(char *p, uint32_t value, int digits)
+{
+  static const char hex[] = "0123456789ABCDEF";
+
+  while (digits-- > 0)
+  {
+    *p++ = hex[(value >> (digits * 4)) & 0x0FU];
+  }
+  return p;
+}
+
+/* Signed hundredths as a decimal with two places */
+static char *putHundredths(char *p, int32_t value)
+{
+  uint32_t magnitude;
+
+  if (value < 0)
+  {
+    *p++ = '-';
+  }
+  magnitude = (value < 0) ? (uint32_t)(-(int64_t)value) : (uint32_t)value;
+  p = putDecimal(p, magnitude / 100U);
+  *p++ = '.';
+  *p++ = (char)('0' + ((magnitude / 10U) % 10U));
+  *p++ = (char)('0' + (magnitude % 10U));
+  return p;
+}
+
+/* Commands of the boot, parameter and history protocols on PGN 0xEF00 */
+static const char *commandName(uint8_t cmd)
+{
+  switch (cmd & (uint8_t)~BOOT_RSP)
+  {
+    case BOOT_CMD_PING: return "boot_ping";
+    case BOOT_CMD_ENTER: return "boot_enter";
+    case BOOT_CMD_START: return "boot_start";
+    case BOOT_CMD_BLOCK: return "boot_block";
+    case BOOT_CMD_END: return "boot_end";
+    case BOOT_CMD_RUN: return "boot_run";
+    case BOOT_CMD_DELTA: return "boot_delta";
+    case PARAMS_CMD_GET: return "param_get";
+    case PARAMS_CMD_SET: return "param_set";
+    case HISTORY_CMD_GET: return "hist_get";
+    case HISTORY_CMD_END: return "hist_end";
+    case WATCHDOG_CMD_RESET: return "reset_cause";
+    case CRASH_CMD_GET: return "crash_get";
+    case CRASH_CMD_CLEAR: return "crash_clear";
+    default: return "command";
+  }
+}
+
+/**
+  * @brief  Writes a frame as a CSV line
+  * @param  out: at least N2K_CSV_MAX bytes
+  * @param  frame: frame to write
+  * @retval bytes written, newline included
+  *
+  * time, iface, id, then prio, pgn, src, dst for 29-bit identifiers, dlc and
+  * data in hex, then for known messages the name and, for PGN 130312, the
+  * SID, instance, source and the temperature in degrees Celsius, for PGN
+  * 126993 the sequence counter and the interval in seconds, for PGN 65284
+  * the headroom, heap peak and refused heap requests and the stack peak in
+  * bytes, for PGN 65281 the 1 s, 10 s and 60 s loads and the handler
+  * share in percent (empty until known), for PGN 65282 the state in the
+  * name, the change counter, the ALARM_FLAG_x bits, the raw code and the
+  * temperature in degrees Celsius, for PGN 65283 the target in the name,
+  * the SID, the samples, the seconds to the threshold (empty without one)
+  * and the slope in K/h, for PGN 128267 the SID and the depth (the UWB
+  * distance) in metres, for PGN 65280 the SID, the signal quality in
+  * percent (empty until known), the status flags and the UWB distance in
+  * metres, for an ISO Request the requested PGN; empty fields otherwise.
+  */
+size_t N2k_FormatCsv(char *out, const N2k_Frame *frame)
+{
+  char *p = out;
+  const char *message = "";
+  N2k_Id fields = { 0 };
+  uint32_t i;
+
+  p = putDecimal(p, frame->sec);
+  *p++ = '.';
+  p = putDigits(p, frame->usec, 6);
+  *p++ = ',';
+  memcpy(p, frame->iface, frame->ifaceLength);
+  p += frame->ifaceLength;
+  *p++ = ',';
+  p = putHex(p, frame->id, frame->ext ? 8 : 3);
+  *p++ = ',';
+
+  if (frame->ext)
+  {
+    N2k_SplitId(frame->id, &fields);
+    p = putDecimal(p, fields.prio);
+    *p++ = ',';
+    p = putDecimal(p, fields.pgn);
+    *p++ = ',';
+    p = putDecimal(p, fields.src);
+    *p++ = ',';
+    p = putDecimal(p, fields.dst);
+    *p++ = ',';
+  }
+  else
+  {
+    p = putString(p, ",,,,");
+  }
+  p = putDecimal(p, frame->dlc);
+  *p++ = ',';
+  if (frame->rtr)
+  {
+    *p++ = 'R';
+  }
+  else
+  {
+    for (i = 0; i < frame->dlc; i++)
+    {
+      p = putHex(p, frame->data[i], 2);
+    }
+  }
+  *p++ = ',';
+
+  if (frame->rtr)
+  {
+    p = putString(p, ",,,,,\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == PGN_TEMPERATURE) && (frame->dlc >= 5U))
+  {
+    uint32_t kelvin = frame->data[3] | ((uint32_t)frame->data[4] << 8);
+
+    p = putString(p, "temperature,");
+    p = putDecimal(p, frame->data[0]);
+    *p++ = ',';
+    p = putDecimal(p, frame->data[1]);
+    *p++ = ',';
+    p = putDecimal(p, frame->data[2]);
+    *p++ = ',';
+    if (kelvin != TEMP_NOT_AVAILABLE)
+    {
+      p = putHundredths(p, (int32_t)kelvin - 27315);
+    }
+    p = putString(p, ",C\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == NMEA_PGN_HEARTBEAT) && (frame->dlc >= 3U))
+  {
+    p = putString(p, "heartbeat,");
+    p = putDecimal(p, frame->data[2]);
+    p = putString(p, ",,,");
+    p = putHundredths(p, (int32_t)(frame->data[0] | ((uint32_t)frame->data[1] << 8)));
+    p = putString(p, ",s\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == RAM_PGN_DIAG) && (frame->dlc >= 7U))
+  {
+    p = putString(p, "ram_diag,");
+    p = putDecimal(p, frame->data[2] | ((uint32_t)frame->data[3] << 8));
+    *p++ = ',';
+    p = putDecimal(p, frame->data[4] | ((uint32_t)frame->data[5] << 8));
+    *p++ = ',';
+    p = putDecimal(p, frame->data[6]);
+    *p++ = ',';
+    p = putDecimal(p, frame->data[0] | ((uint32_t)frame->data[1] << 8));
+    p = putString(p, ",B\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == CPU_PGN_DIAG) && (frame->dlc >= 7U))
+  {
+    p = putString(p, "cpu_diag");
+    for (i = 0; i < 3U; i++)
+    {
+      uint32_t load = frame->data[2U * i] | ((uint32_t)frame->data[(2U * i) + 1U] << 8);
+
+      *p++ = ',';
+      if (load != CPU_LOAD_NA)
+      {
+        p = putHundredths(p, (int32_t)load * 10);
+      }
+    }
+    *p++ = ',';
+    if (frame->data[6] != CPU_SHARE_NA)
+    {
+      p = putHundredths(p, (int32_t)frame->data[6] * 50);
+    }
+    p = putString(p, ",%\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == ALARM_PGN) && (frame->dlc >= 7U))
+  {
+    uint32_t kelvin = frame->data[2] | ((uint32_t)frame->data[3] << 8);
+
+    p = putString(p, (frame->data[0] == ALARM_STATE_HIGH) ? "temp_alarm_high," :
+                     ((frame->data[0] == ALARM_STATE_LOW) ? "temp_alarm_low," : "temp_alarm_normal,"));
+    p = putDecimal(p, frame->data[1]);
+    *p++ = ',';
+    p = putDecimal(p, frame->data[6] & (ALARM_FLAG_REQUEST | ALARM_FLAG_OFF));
+    *p++ = ',';
+    p = putDecimal(p, frame->data[4] | ((uint32_t)frame->data[5] << 8));
+    *p++ = ',';
+    if (kelvin != TEMP_NOT_AVAILABLE)
+    {
+      p = putHundredths(p, (int32_t)kelvin - 27315);
+    }
+    p = putString(p, ",C\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == TREND_PGN) && (frame->dlc >= 8U))
+  {
+    int32_t slope = (int16_t)(frame->data[2] | ((uint32_t)frame->data[3] << 8));
+    uint32_t seconds = frame->data[4] | ((uint32_t)frame->data[5] << 8);
+
+    p = putString(p, (frame->data[6] == TREND_TARGET_HIGH) ? "temp_trend_to_high," :
+                     ((frame->data[6] == TREND_TARGET_LOW) ? "temp_trend_to_low," : "temp_trend,"));
+    p = putDecimal(p, frame->data[0]);
+    *p++ = ',';
+    p = putDecimal(p, frame->data[1]);
+    *p++ = ',';
+    if (seconds <= TREND_TIME_MAX)
+    {
+      p = putDecimal(p, seconds);
+    }
+    *p++ = ',';
+    if (slope != TREND_SLOPE_NA)
+    {
+      /* 0.001 K/min is 0.06 K/h */
+      p = putHundredths(p, slope * 6);
+    }
+    p = putString(p, ",K/h\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == PGN_WATER_DEPTH) && (frame->dlc >= 5U))
+  {
+    uint32_t depth = getLe32(&frame->data[1]);
+
+    p = putString(p, "depth,");
+    p = putDecimal(p, frame->data[0]);
+    p = putString(p, ",,,");
+    if (depth != DEPTH_NOT_AVAILABLE)
+    {
+      /* 0.01 m, past what putHundredths() takes */
+      p = putDecimal(p, depth / 100U);
+      *p++ = '.';
+      p = putDigits(p, depth % 100U, 2);
+    }
+    p = putString(p, ",m\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == PGN_UWB_DISTANCE) && (frame->dlc >= 5U))
+  {
+    uint32_t mm = frame->data[1] | ((uint32_t)frame->data[2] << 8);
+
+    p = putString(p, "uwb_distance,");
+    p = putDecimal(p, frame->data[0]);
+    *p++ = ',';
+    if (frame->data[3] != UWB_QUALITY_NA)
+    {
+      p = putDecimal(p, frame->data[3]);
+    }
+    *p++ = ',';
+    p = putDecimal(p, frame->data[4]);
+    *p++ = ',';
+    if (mm != UWB_NOT_AVAILABLE)
+    {
+      p = putDecimal(p, mm / 1000U);
+      *p++ = '.';
+      p = putDigits(p, mm % 1000U, 3);
+    }
+    p = putString(p, ",m\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == NMEA_PGN_ISO_REQUEST) && (frame->dlc >= 3U))
+  {
+    p = putString(p, "iso_request,,,,");
+    p = putDecimal(p, frame->data[0] | ((uint32_t)frame->data[1] << 8) | ((uint32_t)frame->data[2] << 16));
+    p = putString(p, ",pgn\n");
+    return (size_t)(p - out);
+  }
+
+  if (!frame->ext && (frame->id == STATUS_ID) && (frame->dlc == 8U) &&
+      ((frame->data[0] & 0x0FU) < STATUS_PAGES))
+  {
+    /* Status page: round and page, the fields need the whole round */
+    static const char *pages[STATUS_PAGES] = { "uptime", "traffic", "errors", "load", "memory" };
+
+    p = putString(p, "status_");
+    p = putString(p, pages[frame->data[0] & 0x0FU]);
+    *p++ = ',';
+    p = putDecimal(p, frame->data[0] >> 4);
+    *p++ = ',';
+    p = putDecimal(p, frame->data[0] & 0x0FU);
+    p = putString(p, ",,,\n");
+    return (size_t)(p - out);
+  }
+
+  if (!frame->ext && (frame->id == STATUS_ID) && (frame->dlc >= 4U))
+  {
+    /* Test pattern of older firmware, big endian as it reads in candump */
+    p = putString(p, "a1,,,,");
+    p = putHex(p, getBe32(frame->data), 8);
+    p = putString(p, ",\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == BOOT_PGN_CMD) && (frame->dlc >= 1U))
+  {
+    p = putString(p, commandName(frame->data[0]));
+    if ((frame->data[0] & BOOT_RSP) != 0U)
+    {
+      /* Responses carry the status in byte 1 */
+      p = putString(p, "_rsp,,,,");
+      if (frame->dlc >= 2U)
+      {
+        p = putDecimal(p, frame->data[1]);
+      }
+      p = putString(p, ",\n");
+      return (size_t)(p - out);
+    }
+    p = putString(p, ",,,,,\n");
+    return (size_t)(p - out);
+  }
+
+  if (frame->ext && (fields.pgn == BOOT_PGN_DATA))
+  {
+    message = "data";
+  }
+  else if (frame->ext && (fields.pgn == NMEA_PGN_PRODUCT_INFO))
+  {
+    message = "product_info";
+  }
+  else if (frame->ext && (fields.pgn == NMEA_PGN_ISO_ACK))
+  {
+    message = "iso_ack";
+  }
+  p = putString(p, message);
+  p = putString(p, ",,,,,\n");
+  return (size_t)(p - out);
+}
@@ -0,0 +1,99 @@
+/**
+  ******************************************************************************
+  * @file           : n2klog.h
+  * @brief          : Memory-mapped CAN log reader and NMEA 2000 decoder
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Reads candump text logs, both the -l/-L file format
+  *   (1700000000.123456) can0 19FD0801#28000165 74FFFFFF
+  * and the screen format, with or without a -t timestamp
+  *   (1700000000.123456)  can0  19FD0801   [8]  28 00 01 65 74 FF FF FF
+  * and pcap captures of a SocketCAN interface (tcpdump -i can0 -w, link type
+  * CAN_SOCKETCAN, microsecond or nanosecond timestamps, either byte order).
+  *
+  * The file is mapped, not read, and frames are parsed in place: the reader
+  * allocates nothing per line, and the interface name points into the map.
+  * A log can be cut into chunks at record boundaries with N2k_ChunkEnd(),
+  * and the chunks parsed in parallel.
+  *
+  * N2k_FormatCsv() writes one frame as a CSV line with the 29-bit identifier
+  * split into priority, PGN, source and destination, and the messages of
+  * this node decoded into engineering units (N2k_CsvHeader lists the
+  * columns).
+  */
+
+#ifndef __N2KLOG_H
+#define __N2KLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define N2K_FORMAT_TEXT     0
+#define N2K_FORMAT_PCAP     1
+
+/* Longest line N2k_FormatCsv() writes */
+#define N2K_CSV_MAX         192U
+
+/* Destination of PDU2 (broadcast) PGNs */
+#define N2K_GLOBAL          0xFFU
+
+/**
+  * @brief One frame, pointing into the log
+  */
+typedef struct
+{
+  uint64_t sec;             /* timestamp, 0 if the line has none */
+  uint32_t usec;
+  uint32_t id;              /* identifier without flags */
+  uint8_t ext;              /* 29-bit identifier */
+  uint8_t rtr;              /* remote request, no data */
+  uint8_t dlc;
+  uint8_t ifaceLength;      /* 0 for pcap */
+  const char *iface;        /* not terminated */
+  uint8_t data[8];
+} N2k_Frame;
+
+/**
+  * @brief Fields of a 29-bit identifier
+  */
+typedef struct
+{
+  uint8_t prio;
+  uint8_t src;
+  uint8_t dst;              /* N2K_GLOBAL for PDU2 */
+  uint32_t pgn;             /* PDU1: destination byte cleared */
+} N2k_Id;
+
+/**
+  * @brief A mapped log
+  */
+typedef struct
+{
+  const uint8_t *base;
+  size_t size;
+  size_t first;             /* offset of the first record */
+  int format;
+  int swapped;              /* pcap written on the other byte order */
+  int nanoseconds;          /* pcap timestamps in ns */
+} N2k_Log;
+
+extern const char N2k_CsvHeader[];
+
+int N2k_Open(N2k_Log *log, const char *path);
+void N2k_Close(N2k_Log *log);
+size_t N2k_ChunkEnd(const N2k_Log *log, size_t start, size_t want);
+int N2k_Next(const N2k_Log *log, size_t *pos, size_t end, N2k_Frame *frame);
+void N2k_SplitId(uint32_t id, N2k_Id *out);
+size_t N2k_FormatCsv(char *out, const N2k_Frame *frame);
+
+#endif /* __N2KLOG_H */
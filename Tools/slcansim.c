@@ -0,0 +1,584 @@
+/**
+  ******************************************************************************
+  * @file           : slcansim.c
+  * @brief          : SLCAN adapter model: command session check and link
+  *                   throughput with the firmware's codec
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Runs Core/Src/slcan.c, compiled with BOOT_HOST, as the adapter firmware
+  * does (Core/Inc/slcan.h):
+  *
+  * First a session in the way slcand and a terminal talk to the adapter is
+  * fed a character at a time through the line assembler and the command
+  * parser; every answer, every channel state and every frame handed to the
+  * bus must be the expected one.
+  *
+  * Then bus traffic, a candump log or, without one, a synthetic bus fully
+  * loaded with 8-byte standard frames (the most characters per bit), goes
+  * through a model of the firmware's path: a CAN_RX_QUEUE_LEN queue, the
+  * service pass encoding batches into the SLCAN_TX_RING ring, and DMA
+  * runs chained from the transfer-complete interrupt at the link's
+  * character rate. Frames arrive at their log time, never faster than the
+  * bus can carry them. The stream that leaves the model is decoded again:
+  * every frame must come back in order with its millisecond stamp, and if
+  * the queue dropped any, the stream must carry an e1o line. The report
+  * gives the link load, the batch sizes and the queueing latency.
+  *
+  * Usage: slcansim [-b baud] [-r bitrate] [-d seconds] [-z] [-w stream] [log]
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "slcan.h"
+#include "n2klog.h"
+
+#define RX_QUEUE_LEN        32U       /* CAN_RX_QUEUE_LEN, can.h needs the HAL */
+#define PCLK1_HZ            32000000UL /* SystemClock_Config(): HCLK 64 MHz / 2 */
+#define EXPECT_LEN          1024U     /* frames between the queue and the host, power of two */
+
+/**
+  * @brief A frame with its arrival time
+  */
+typedef struct
+{
+  CAN_Frame frame;
+  double at;
+} Arrival;
+
+/* Session step: characters sent, answer expected, mode after it */
+typedef struct
+{
+  const char *send;
+  const char *reply;
+  uint8_t mode;
+  uint32_t sent;            /* frames handed to the bus after the step */
+} Step;
+
+static const Step session[] =
+{
+  {"C\r",                        "\a",     SLCAN_CLOSED, 0},   /* slcand -c closes first */
+  {"S9\r",                       "\a",     SLCAN_CLOSED, 0},
+  {"S7\r",                       "\r",     SLCAN_CLOSED, 0},   /* 800k, BRP 5 */
+  {"S8\r",                       "\r",     SLCAN_CLOSED, 0},   /* slcand -s8 */
+  {"Z1\r",                       "\r",     SLCAN_CLOSED, 0},
+  {"V\r",                        "V0101\r", SLCAN_CLOSED, 0},
+  {"N\r",                        "NF334\r", SLCAN_CLOSED, 0},
+  {"F\r",                        "\a",     SLCAN_CLOSED, 0},   /* open only */
+  {"t1230\r",                    "\a",     SLCAN_CLOSED, 0},
+  {"O\r",                        "\r",     SLCAN_OPEN,   0},
+  {"O\r",                        "\a",     SLCAN_OPEN,   0},
+  {"S4\r",                       "\a",     SLCAN_OPEN,   0},
+  {"t0A18DEADBEEF00000000\r",    "z\r",    SLCAN_OPEN,   1},
+  {"T19FD08018280001657AFFFFFF\r", "Z\r", SLCAN_OPEN,   2},
+  {"r7FF0\r",                    "z\r",    SLCAN_OPEN,   3},
+  {"R1FFFFFFF8\r",               "Z\r",    SLCAN_OPEN,   4},
+  {"t0A1200ab\r\n",              "z\r",    SLCAN_OPEN,   5},   /* lower case, CR LF */
+  {"t8000\r",                    "\a",     SLCAN_OPEN,   5},   /* identifier above 0x7FF */
+  {"T200000000\r",               "\a",     SLCAN_OPEN,   5},   /* above 29 bits */
+  {"t1239\r",                    "\a",     SLCAN_OPEN,   5},   /* DLC 9 */
+  {"t123201020\r",               "\a",     SLCAN_OPEN,   5},   /* one data digit too many */
+  {"t1231AB0001\r",              "\a",     SLCAN_OPEN,   5},   /* stamped, the host does not */
+  {"t12XAB\r",                   "\a",     SLCAN_OPEN,   5},
+  {"t1238000000000000000000000000000000\r", "\a", SLCAN_OPEN, 5}, /* past SLCAN_LINE_MAX */
+  {"\r",                         "\r",     SLCAN_OPEN,   5},
+  {"F\r",                        "F00\r",  SLCAN_OPEN,   5},
+  {"Q\r",                        "\a",     SLCAN_OPEN,   5},
+  {"C\r",                        "\r",     SLCAN_CLOSED, 5},
+  {"L\r",                        "\r",     SLCAN_LISTEN, 5},
+  {"t1230\r",                    "\a",     SLCAN_LISTEN, 5},   /* silent mode sends nothing */
+  {"C\r",                        "\r",     SLCAN_CLOSED, 5},
+};
+
+/* Model state */
+static Arrival queue[RX_QUEUE_LEN];
+static uint32_t queueHead;
+static uint32_t queueTail;
+static uint32_t queuePeak;
+static uint32_t dropped;
+static uint32_t droppedSeen;
+
+static char ring[SLCAN_TX_RING + SLCAN_FRAME_MAX];
+static uint32_t txHead;
+static uint32_t txTail;
+static uint32_t txBusy;
+static uint32_t ringPeak;
+static double runStart;
+
+static Arrival expect[EXPECT_LEN];
+static uint32_t expectHead;
+static uint32_t expectTail;
+
+static uint8_t stamps;
+static uint32_t runs;
+static uint32_t lostLines;
+static uint64_t bytesOut;
+static double lastByteAt;
+
+/* Checker state */
+static Slcan_Line line;
+static uint32_t decoded;
+static uint32_t lostSeen;
+static uint32_t mismatches;
+static double latencySum;
+static double latencyMax;
+
+static FILE *stream;
+
+/* Transmitted frames of the session */
+static CAN_Frame sent[8];
+
+static double byteTime;
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-b baud] [-r bitrate] [-d seconds] [-z] [-w stream] [log]\n"
+          "  -b baud     link rate, 10 bits per character (default %lu)\n"
+          "  -r bitrate  CAN bit rate (default 1000000)\n"
+          "  -d seconds  synthetic fully loaded bus without a log (default 1)\n"
+          "  -z          time stamps on (Z1)\n"
+          "  -w stream   write the characters sent to the host\n",
+          prog, (unsigned long)SLCAN_BAUD);
+}
+
+/* Bits on the wire without stuffing, interframe space included */
+static uint32_t frameBits(const CAN_Frame *frame)
+{
+  uint32_t data = ((frame->id & CAN_FRAME_RTR) != 0U) ? 0U : (8U * frame->dlc);
+
+  return (((frame->id & CAN_FRAME_EXT) != 0U) ? 67U : 47U) + data;
+}
+
+/* ---- Command session ---------------------------------------------------- */
+
+static int runSession(void)
+{
+  Slcan_State state = { .pclk1 = PCLK1_HZ };
+  Slcan_Line input = {0};
+  uint32_t transmitted = 0;
+  uint32_t failures = 0;
+  uint32_t i;
+
+  for (i = 0; i < (sizeof(session) / sizeof(session[0])); i++)
+  {
+    const Step *step = &session[i];
+    char reply[64];
+    uint32_t replied = 0;
+    const char *c;
+
+    for (c = step->send; *c != '\0'; c++)
+    {
+      CAN_Frame frame;
+      uint8_t result;
+
+      if (!Slcan_Accept(&input, *c))
+      {
+        continue;
+      }
+      result = input.overflow ? SLCAN_ERROR : Slcan_Command(&state, input.text, input.length, &frame);
+      if ((result == SLCAN_SEND) && (transmitted < (sizeof(sent) / sizeof(sent[0]))))
+      {
+        sent[transmitted++] = frame;
+      }
+      replied += Slcan_Reply(&reply[replied], result, &frame, state.flags);
+    }
+    reply[replied] = '\0';
+
+    if ((strcmp(reply, step->reply) != 0) || (state.mode != step->mode) || (transmitted != step->sent))
+    {
+      fprintf(stderr, "slcansim: session step %u: sent %.*s, answer %u bytes, mode %u, %u frames\n",
+              i + 1U, (int)strcspn(step->send, "\r"), step->send, replied, state.mode, transmitted);
+      failures++;
+    }
+  }
+
+  /* The frames handed to the bus */
+  if ((transmitted != 5U) ||
+      (sent[0].id != 0x0A1U) || (sent[0].dlc != 8U) || (sent[0].data[0] != 0xDEU) || (sent[0].data[3] != 0xEFU) ||
+      (sent[1].id != (0x19FD0801UL | CAN_FRAME_EXT)) || (sent[1].data[4] != 0x7AU) ||
+      (sent[2].id != (0x7FFU | CAN_FRAME_RTR)) || (sent[2].dlc != 0U) ||
+      (sent[3].id != (0x1FFFFFFFUL | CAN_FRAME_EXT | CAN_FRAME_RTR)) || (sent[3].dlc != 8U) ||
+      (sent[4].id != 0x0A1U) || (sent[4].dlc != 2U) || (sent[4].data[1] != 0xABU))
+  {
+    fprintf(stderr, "slcansim: session frames differ\n");
+    failures++;
+  }
+  if ((state.bitrate != 8U) || (state.stamps != 1U))
+  {
+    fprintf(stderr, "slcansim: session state differs\n");
+    failures++;
+  }
+
+  /* MX_CAN_Init()'s 1 Mbit/s, and 800k, which a 16 MHz PCLK1 cannot give */
+  if ((Slcan_Prescaler(8U, PCLK1_HZ) != 4U) || (Slcan_Prescaler(7U, 16000000UL) != 0U))
+  {
+    fprintf(stderr, "slcansim: prescalers differ\n");
+    failures++;
+  }
+
+  printf("session      %10u steps, %s\n", (unsigned)(sizeof(session) / sizeof(session[0])),
+         (failures == 0U) ? "ok" : "FAILED");
+  return (failures == 0U) ? 0 : 1;
+}
+
+/* ---- Link model --------------------------------------------------------- */
+
+/* What the host reads, a character at a time */
+static void hostReceive(char c, double at)
+{
+  CAN_Frame frame;
+  uint8_t stamped;
+
+  if (stream != NULL)
+  {
+    fputc(c, stream);
+  }
+  if (!Slcan_Accept(&line, c))
+  {
+    return;
+  }
+  if ((line.length == 3U) && (memcmp(line.text, "e1o", 3) == 0))
+  {
+    lostSeen++;
+    return;
+  }
+  if ((expectHead == expectTail) || !Slcan_Decode(line.text, line.length, &frame, &stamped) ||
+      (stamped != stamps))
+  {
+    mismatches++;
+    return;
+  }
+  {
+    const Arrival *want = &expect[expectTail & (EXPECT_LEN - 1U)];
+
+    if ((frame.id != want->frame.id) || (frame.dlc != want->frame.dlc) ||
+        (memcmp(frame.data, want->frame.data, ((frame.id & CAN_FRAME_RTR) != 0U) ? 0U : frame.dlc) != 0) ||
+        (stamps && (frame.time != want->frame.time)))
+    {
+      mismatches++;
+    }
+    if ((at - want->at) > latencyMax)
+    {
+      latencyMax = at - want->at;
+    }
+    latencySum += at - want->at;
+  }
+  expectTail++;
+  decoded++;
+}
+
+/* CAN_Receive(): also remembers what the host must see */
+static uint8_t queueReceive(CAN_Frame *frame)
+{
+  if (queueTail == queueHead)
+  {
+    return 0;
+  }
+  expect[expectHead & (EXPECT_LEN - 1U)] = queue[queueTail % RX_QUEUE_LEN];
+  expectHead++;
+  *frame = queue[queueTail % RX_QUEUE_LEN].frame;
+  queueTail++;
+  return 1;
+}
+
+static uint32_t txFree(void)
+{
+  return SLCAN_TX_RING - (txHead - txTail);
+}
+
+static void txCommit(uint32_t length)
+{
+  uint32_t offset = txHead & (SLCAN_TX_RING - 1U);
+  uint32_t i;
+
+  for (i = SLCAN_TX_RING; i < (offset + length); i++)
+  {
+    ring[i - SLCAN_TX_RING] = ring[i];
+  }
+  txHead += length;
+  if ((txHead - txTail) > ringPeak)
+  {
+    ringPeak = txHead - txTail;
+  }
+}
+
+/* txStart() of the firmware */
+static void txStart(double now)
+{
+  uint32_t offset = txTail & (SLCAN_TX_RING - 1U);
+  uint32_t count = txHead - txTail;
+
+  if (count > (SLCAN_TX_RING - offset))
+  {
+    count = SLCAN_TX_RING - offset;
+  }
+  txBusy = count;
+  runStart = now;
+  if (count != 0U)
+  {
+    runs++;
+  }
+}
+
+/* Slcan_Poll() of the firmware, without host commands */
+static void servicePass(double now)
+{
+  if ((txFree() >= 4U) && (dropped != droppedSeen))
+  {
+    memcpy(&ring[txHead & (SLCAN_TX_RING - 1U)], "e1o\r", 4);
+    txCommit(4U);
+    droppedSeen = dropped;
+    lostLines++;
+  }
+  if (txFree() >= SLCAN_FRAME_MAX)
+  {
+    uint32_t offset = txHead & (SLCAN_TX_RING - 1U);
+    uint32_t space = txFree();
+    uint32_t frames = 0;
+
+    if (space > (SLCAN_TX_RING - offset + SLCAN_FRAME_MAX))
+    {
+      space = SLCAN_TX_RING - offset + SLCAN_FRAME_MAX;
+    }
+    txCommit(Slcan_EncodeBatch(&ring[offset], space, queueReceive, stamps, &frames));
+  }
+  if (txBusy == 0U)
+  {
+    txStart(now);
+  }
+}
+
+/* Slcan_TxDma_IRQ(): the run has gone out */
+static void runComplete(void)
+{
+  uint32_t offset = txTail & (SLCAN_TX_RING - 1U);
+  uint32_t i;
+
+  for (i = 0; i < txBusy; i++)
+  {
+    lastByteAt = runStart + ((double)(i + 1U) * byteTime);
+    hostReceive(ring[offset + i], lastByteAt);
+  }
+  bytesOut += txBusy;
+  txTail += txBusy;
+  txStart(runStart + ((double)txBusy * byteTime));
+}
+
+/* Frame source: the log, or a bus full of 8-byte standard frames */
+typedef struct
+{
+  N2k_Log log;
+  size_t pos;
+  int open;
+  uint64_t count;
+  uint64_t limit;
+  double first;
+} Source;
+
+static int nextFrame(Source *src, CAN_Frame *frame, double *at)
+{
+  if (src->open)
+  {
+    N2k_Frame f;
+
+    if (N2k_Next(&src->log, &src->pos, src->log.size, &f) <= 0)
+    {
+      return 0;
+    }
+    frame->id = f.id | (f.ext ? CAN_FRAME_EXT : 0U) | (f.rtr ? CAN_FRAME_RTR : 0U);
+    frame->dlc = f.dlc;
+    memcpy(frame->data, f.data, sizeof(frame->data));
+    *at = (double)f.sec + ((double)f.usec / 1e6);
+    if (src->count == 0U)
+    {
+      src->first = *at;
+    }
+    *at -= src->first;
+  }
+  else
+  {
+    if (src->count >= src->limit)
+    {
+      return 0;
+    }
+    frame->id = 0x100U + (uint32_t)(src->count % 0x600U);
+    frame->dlc = 8U;
+    memset(frame->data, (int)(src->count & 0xFFU), sizeof(frame->data));
+    *at = 0.0;                      /* back to back */
+  }
+  src->count++;
+  return 1;
+}
+
+static int runModel(Source *src, double bitrate, double baud)
+{
+  CAN_Frame frame = {0};
+  double busFree = 0.0;             /* end of the frame on the wire */
+  double arrival = 0.0;
+  double busBits = 0.0;
+  uint64_t frames = 0;
+  int have;
+
+  byteTime = 10.0 / baud;
+  have = nextFrame(src, &frame, &arrival);
+
+  for (;;)
+  {
+    double done = (txBusy != 0U) ? (runStart + ((double)txBusy * byteTime)) : 1e300;
+
+    if (have)
+    {
+      /* Received when the last bit is in, never faster than the bus */
+      double end = ((arrival > busFree) ? arrival : busFree) + ((double)frameBits(&frame) / bitrate);
+
+      if (end <= done)
+      {
+        busFree = end;
+        busBits += frameBits(&frame);
+        frames++;
+        frame.time = (uint16_t)((uint64_t)(end * 1000.0) % SLCAN_STAMP_WRAP);
+        if ((queueHead - queueTail) < RX_QUEUE_LEN)
+        {
+          queue[queueHead % RX_QUEUE_LEN].frame = frame;
+          queue[queueHead % RX_QUEUE_LEN].at = end;
+          queueHead++;
+          if ((queueHead - queueTail) > queuePeak)
+          {
+            queuePeak = queueHead - queueTail;
+          }
+        }
+        else
+        {
+          dropped++;
+        }
+        servicePass(end);
+        have = nextFrame(src, &frame, &arrival);
+        continue;
+      }
+    }
+    if (txBusy == 0U)
+    {
+      break;
+    }
+    runComplete();
+    servicePass(runStart);
+  }
+  /* Whatever the last pass left */
+  while ((queueHead != queueTail) || (txHead != txTail))
+  {
+    servicePass(lastByteAt);
+    if (txBusy == 0U)
+    {
+      break;
+    }
+    runComplete();
+  }
+
+  printf("bus          %10llu frames in %.3f s, %.1f %% of %.0f bit/s\n", (unsigned long long)frames, busFree,
+         (busFree > 0.0) ? (100.0 * busBits / bitrate / busFree) : 0.0, bitrate);
+  printf("link         %10llu characters, %.1f %% of %.0f baud, %lu DMA runs of %.1f on average\n",
+         (unsigned long long)bytesOut, (lastByteAt > 0.0) ? (100.0 * (double)bytesOut * byteTime / lastByteAt) : 0.0,
+         baud, (unsigned long)runs, (runs != 0U) ? ((double)bytesOut / runs) : 0.0);
+  printf("buffers      %10u of %u queued frames at most, %u of %u ring bytes\n", queuePeak, RX_QUEUE_LEN,
+         ringPeak, SLCAN_TX_RING);
+  printf("latency      %10.3f ms on average, %.3f ms at most, queue to last character\n",
+         (decoded != 0U) ? (1e3 * latencySum / decoded) : 0.0, 1e3 * latencyMax);
+  printf("lost         %10u frames, %u e1o lines sent, %u seen\n", dropped, lostLines, lostSeen);
+
+  if ((mismatches != 0U) || (decoded + dropped != frames) || (expectHead != expectTail))
+  {
+    fprintf(stderr, "slcansim: %u lines differ, %u of %llu frames decoded\n", mismatches, decoded,
+            (unsigned long long)frames);
+    return 1;
+  }
+  if ((dropped != 0U) && (lostSeen == 0U))
+  {
+    fprintf(stderr, "slcansim: frames lost without an e1o line\n");
+    return 1;
+  }
+  printf("check        %10s\n", "ok");
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  double baud = (double)SLCAN_BAUD;
+  double bitrate = 1000000.0;
+  double seconds = 1.0;
+  const char *streamPath = NULL;
+  Source src = {0};
+  int status;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "b:r:d:zw:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'b': baud = strtod(optarg, NULL); break;
+      case 'r': bitrate = strtod(optarg, NULL); break;
+      case 'd': seconds = strtod(optarg, NULL); break;
+      case 'z': stamps = 1; break;
+      case 'w': streamPath = optarg; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if ((optind < (argc - 1)) || (baud <= 0.0) || (bitrate <= 0.0) || (seconds <= 0.0))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  if (optind < argc)
+  {
+    if (N2k_Open(&src.log, argv[optind]) != 0)
+    {
+      return 2;
+    }
+    src.pos = src.log.first;
+    src.open = 1;
+  }
+  else
+  {
+    /* 8-byte standard frames, 111 bits each */
+    src.limit = (uint64_t)(seconds * bitrate / 111.0);
+  }
+  if (streamPath != NULL)
+  {
+    stream = fopen(streamPath, "wb");
+    if (stream == NULL)
+    {
+      perror(streamPath);
+      return 2;
+    }
+  }
+
+  printf("===== SLCAN %s at %.0f baud%s =====\n", src.open ? argv[optind] : "full bus", baud,
+         stamps ? ", time stamps" : "");
+  status = runSession();
+  status |= runModel(&src, bitrate, baud);
+
+  if (stream != NULL)
+  {
+    fclose(stream);
+  }
+  if (src.open)
+  {
+    N2k_Close(&src.log);
+  }
+  return status;
+}
@@ -0,0 +1,637 @@
+/**
+  ******************************************************************************
+  * @file           : stackest.c
+  * @brief          : Static worst-case stack estimate from the compiler's call
+  *                   graph and the linker map
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Reads the .ci files GCC writes with -fcallgraph-info=su (one per object:
+  * every function with its frame size and its direct calls) and the GNU ld
+  * map of the link. Functions the map lists under "Discarded input sections"
+  * were dropped by --gc-sections and are left out.
+  *
+  * Roots are main and every *Handler that nothing calls: the exception and
+  * interrupt handlers. A root's depth is its own frame plus the deepest
+  * chain of calls below it. Calls through a pointer (the scheduler's tasks)
+  * are taken to reach any function that nothing calls directly.
+  *
+  * Handlers given a priority with -p nest: the worst case is main, plus for
+  * each priority level the deepest handler of that level and an exception
+  * frame (-f, default 108 bytes: 26 words with the FPU state, plus the
+  * alignment word). Handlers without a priority share one more level.
+  *
+  * Recursion, dynamically sized frames and functions without a .ci node
+  * (libc, libgcc, assembly) cannot be bounded: they count as their frame,
+  * or 0, and the result is marked as a lower bound (">="). Calls from
+  * inline assembly are not in the graph either: Crash_Fault(), entered by a
+  * branch from the naked fault handlers, counts as called through a
+  * pointer.
+  *
+  * With -l, exits with status 1 when the worst case exceeds the limit.
+  *
+  * Usage: stackest [-n top] [-l limit] [-f frame] [-p handler=prio]...
+  *                 file.map file.ci...
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_NODES         4096U
+#define MAX_EDGES         16384U
+#define MAX_DISCARDED     8192U
+#define MAX_PRIOS         32U
+#define MAX_NAME          96U
+#define MAX_PATH          24U
+
+#define INDIRECT          "__indirect_call"
+#define NO_NODE           (-1)
+
+typedef enum
+{
+  STATE_NEW = 0,
+  STATE_VISITING,
+  STATE_DONE
+} State;
+
+typedef struct
+{
+  char title[MAX_NAME];   /* "name", or "unit.c:name" for static functions */
+  char name[MAX_NAME];
+  char unit[MAX_NAME];    /* object base name, without .o */
+  unsigned long frame;
+  int defined;            /* has a frame size */
+  int dynamic;            /* frame not bounded */
+  int dead;               /* discarded by the linker */
+  int called;             /* has a direct caller */
+  int recursive;
+  State state;
+  unsigned long depth;    /* frame plus deepest callee */
+  int next;               /* deepest callee */
+  int bounded;            /* nothing unbounded below */
+} Node;
+
+typedef struct
+{
+  int from;
+  int to;
+} Edge;
+
+typedef struct
+{
+  char name[MAX_NAME];
+  int prio;
+} Prio;
+
+static Node nodes[MAX_NODES];
+static size_t nodeCount;
+static Edge edges[MAX_EDGES];
+static size_t edgeCount;
+static char discarded[MAX_DISCARDED][2U * MAX_NAME];   /* "unit:name" */
+static size_t discardedCount;
+static Prio prios[MAX_PRIOS];
+static size_t prioCount;
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-n top] [-l limit] [-f frame] [-p handler=prio]... file.map file.ci...\n", prog);
+}
+
+static const char *baseName(const char *path)
+{
+  const char *slash = strrchr(path, '/');
+
+  return (slash != NULL) ? slash + 1 : path;
+}
+
+/* "build/debug/main.o" or "main.c" -> "main" */
+static void unitOf(const char *path, char *unit)
+{
+  const char *base = baseName(path);
+  const char *dot = strrchr(base, '.');
+  size_t n = (dot != NULL) ? (size_t)(dot - base) : strlen(base);
+
+  snprintf(unit, MAX_NAME, "%.*s", (int)((n < MAX_NAME) ? n : MAX_NAME - 1U), base);
+}
+
+static int findNode(const char *title)
+{
+  size_t i;
+
+  for (i = 0; i < nodeCount; i++)
+  {
+    if (strcmp(nodes[i].title, title) == 0)
+    {
+      return (int)i;
+    }
+  }
+  return NO_NODE;
+}
+
+static int addNode(const char *title)
+{
+  int index = findNode(title);
+  Node *node;
+  const char *colon;
+
+  if (index != NO_NODE)
+  {
+    return index;
+  }
+  if (nodeCount >= MAX_NODES)
+  {
+    fprintf(stderr, "stackest: more than %u functions\n", MAX_NODES);
+    exit(2);
+  }
+  node = &nodes[nodeCount];
+  snprintf(node->title, sizeof(node->title), "%s", title);
+  colon = strchr(title, ':');
+  if (colon != NULL)
+  {
+    char file[MAX_NAME];
+
+    snprintf(file, sizeof(file), "%.*s", (int)(colon - title), title);
+    unitOf(file, node->unit);
+    snprintf(node->name, sizeof(node->name), "%s", colon + 1);
+  }
+  else
+  {
+    snprintf(node->name, sizeof(node->name), "%s", title);
+  }
+  node->next = NO_NODE;
+  return (int)nodeCount++;
+}
+
+/* Value of key: "..." in a .ci line, 0 if absent */
+static int field(const char *line, const char *key, char *value, size_t size)
+{
+  const char *p = strstr(line, key);
+  const char *end;
+
+  if (p == NULL)
+  {
+    return 0;
+  }
+  p += strlen(key);
+  end = strchr(p, '"');
+  if (end == NULL)
+  {
+    return 0;
+  }
+  snprintf(value, size, "%.*s", (int)(end - p), p);
+  return 1;
+}
+
+static void readCallGraph(const char *path)
+{
+  FILE *in = fopen(path, "r");
+  char line[1024];
+  char unit[MAX_NAME];
+
+  if (in == NULL)
+  {
+    perror(path);
+    exit(2);
+  }
+  unitOf(path, unit);
+
+  while (fgets(line, sizeof(line), in) != NULL)
+  {
+    char title[MAX_NAME];
+    char label[512];
+    char target[MAX_NAME];
+
+    if ((strncmp(line, "node:", 5) == 0) && field(line, "title: \"", title, sizeof(title)) &&
+        field(line, "label: \"", label, sizeof(label)))
+    {
+      Node *node = &nodes[addNode(title)];
+      const char *bytes = strstr(label, " bytes (");
+
+      /* label: name\nfile:line:col\nN bytes (static|dynamic|dynamic,bounded) */
+      if (bytes != NULL)
+      {
+        const char *start = bytes;
+
+        while ((start > label) && (start[-1] != 'n'))
+        {
+          start--;
+        }
+        node->frame = strtoul(start, NULL, 10);
+        node->defined = 1;
+        node->dynamic = (strncmp(bytes + 8, "dynamic)", 8) == 0);
+        if (node->unit[0] == '\0')
+        {
+          snprintf(node->unit, sizeof(node->unit), "%s", unit);
+        }
+      }
+    }
+    else if ((strncmp(line, "edge:", 5) == 0) && field(line, "sourcename: \"", title, sizeof(title)) &&
+             field(line, "targetname: \"", target, sizeof(target)))
+    {
+      if (edgeCount >= MAX_EDGES)
+      {
+        fprintf(stderr, "stackest: more than %u calls\n", MAX_EDGES);
+        exit(2);
+      }
+      edges[edgeCount].from = addNode(title);
+      edges[edgeCount].to = addNode(target);
+      edgeCount++;
+    }
+  }
+  fclose(in);
+}
+
+/* Collects " .text.name 0x.. 0x.. object" lines of the discarded sections */
+static void readMap(const char *path)
+{
+  FILE *in = fopen(path, "r");
+  char line[1024];
+  char pending[256] = "";
+  int inDiscarded = 0;
+  int seenMap = 0;
+
+  if (in == NULL)
+  {
+    perror(path);
+    exit(2);
+  }
+
+  while (fgets(line, sizeof(line), in) != NULL)
+  {
+    char section[256];
+    char object[512];
+    char unit[MAX_NAME];
+    unsigned long addr;
+    unsigned long size;
+    int r;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    if (strncmp(line, "Discarded input sections", 24) == 0)
+    {
+      inDiscarded = 1;
+      continue;
+    }
+    if (strncmp(line, "Linker script and memory map", 28) == 0)
+    {
+      seenMap = 1;
+      break;
+    }
+    if (!inDiscarded)
+    {
+      continue;
+    }
+
+    /* Long section names carry the numbers on the next line */
+    r = sscanf(line, " %255s 0x%lx 0x%lx %511s", section, &addr, &size, object);
+    if ((r == 1) && (section[0] == '.'))
+    {
+      snprintf(pending, sizeof(pending), "%s", section);
+      continue;
+    }
+    if ((r != 4) && (pending[0] != '\0') && (sscanf(line, " 0x%lx 0x%lx %511s", &addr, &size, object) == 3))
+    {
+      snprintf(section, sizeof(section), "%s", pending);
+      r = 4;
+    }
+    pending[0] = '\0';
+    if ((r != 4) || (strncmp(section, ".text.", 6) != 0) || (discardedCount >= MAX_DISCARDED))
+    {
+      continue;
+    }
+    unitOf(object, unit);
+    snprintf(discarded[discardedCount++], sizeof(discarded[0]), "%s:%.*s", unit, (int)MAX_NAME - 1, section + 6);
+  }
+  fclose(in);
+
+  if (!seenMap)
+  {
+    fprintf(stderr, "%s: not a GNU ld map file\n", path);
+    exit(2);
+  }
+}
+
+static int isDiscarded(const Node *node)
+{
+  char key[2U * MAX_NAME];
+  size_t i;
+
+  snprintf(key, sizeof(key), "%s:%s", node->unit, node->name);
+  for (i = 0; i < discardedCount; i++)
+  {
+    if (strcmp(discarded[i], key) == 0)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int isRoot(const Node *node)
+{
+  size_t n = strlen(node->name);
+
+  if (node->dead || !node->defined || node->called)
+  {
+    return 0;
+  }
+  return (strcmp(node->name, "main") == 0) || ((n >= 7U) && (strcmp(node->name + n - 7U, "Handler") == 0));
+}
+
+/* Reached through a function pointer: defined, live, no direct caller */
+static int isIndirectTarget(const Node *node)
+{
+  return node->defined && !node->dead && !node->called && !isRoot(node);
+}
+
+static void visit(int index);
+
+static void consider(Node *node, int callee)
+{
+  visit(callee);
+  if (nodes[callee].state == STATE_VISITING)
+  {
+    node->recursive = 1;          /* a cycle: counted once */
+    node->bounded = 0;
+    return;
+  }
+  if (!nodes[callee].bounded)
+  {
+    node->bounded = 0;
+  }
+  if ((node->next == NO_NODE) || (nodes[callee].depth > nodes[node->next].depth))
+  {
+    node->next = callee;
+  }
+}
+
+static void visit(int index)
+{
+  Node *node = &nodes[index];
+  int indirect = (strcmp(node->title, INDIRECT) == 0);
+  size_t i;
+
+  if (node->state != STATE_NEW)
+  {
+    return;
+  }
+  node->state = STATE_VISITING;
+  node->bounded = (node->defined || indirect) && !node->dynamic;
+
+  for (i = 0; i < edgeCount; i++)
+  {
+    if (edges[i].from == index)
+    {
+      consider(node, edges[i].to);
+    }
+  }
+  if (indirect)
+  {
+    for (i = 0; i < nodeCount; i++)
+    {
+      if (isIndirectTarget(&nodes[i]))
+      {
+        consider(node, (int)i);
+      }
+    }
+  }
+
+  node->depth = node->frame + ((node->next != NO_NODE) ? nodes[node->next].depth : 0U);
+  node->state = STATE_DONE;
+}
+
+static void printPath(int index)
+{
+  unsigned hops = 0;
+
+  while ((index != NO_NODE) && (hops++ < MAX_PATH))
+  {
+    const Node *node = &nodes[index];
+
+    if (strcmp(node->title, INDIRECT) == 0)
+    {
+      printf("%s(*)", (hops > 1U) ? " > " : "");
+    }
+    else
+    {
+      printf("%s%s%s", (hops > 1U) ? " > " : "", node->name, !node->defined ? "?" : "");
+    }
+    index = node->next;
+  }
+  printf("\n");
+}
+
+static int priorityOf(const char *name)
+{
+  size_t i;
+
+  for (i = 0; i < prioCount; i++)
+  {
+    if (strcmp(prios[i].name, name) == 0)
+    {
+      return prios[i].prio;
+    }
+  }
+  return INT32_MAX;               /* no priority: the shared level */
+}
+
+static int byFrameDesc(const void *a, const void *b)
+{
+  const Node *x = &nodes[*(const int *)a];
+  const Node *y = &nodes[*(const int *)b];
+
+  return (x->frame < y->frame) ? 1 : ((x->frame > y->frame) ? -1 : 0);
+}
+
+int main(int argc, char **argv)
+{
+  static int order[MAX_NODES];
+  unsigned long limit = 0;
+  unsigned long excFrame = 108;
+  unsigned long total = 0;
+  unsigned top = 10;
+  unsigned levels = 0;
+  unsigned unknown = 0;
+  int bounded = 1;
+  int mainNode = NO_NODE;
+  int opt;
+  size_t live = 0;
+  size_t count;
+  size_t i;
+  size_t j;
+
+  while ((opt = getopt(argc, argv, "n:l:f:p:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': top = (unsigned)strtoul(optarg, NULL, 0); break;
+      case 'l': limit = strtoul(optarg, NULL, 0); break;
+      case 'f': excFrame = strtoul(optarg, NULL, 0); break;
+      case 'p':
+      {
+        const char *eq = strchr(optarg, '=');
+
+        if ((eq == NULL) || (prioCount >= MAX_PRIOS))
+        {
+          usage(argv[0]);
+          return 2;
+        }
+        snprintf(prios[prioCount].name, MAX_NAME, "%.*s", (int)(eq - optarg), optarg);
+        prios[prioCount].prio = (int)strtol(eq + 1, NULL, 0);
+        prioCount++;
+        break;
+      }
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (argc - optind < 2)
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  readMap(argv[optind]);
+  for (i = (size_t)optind + 1U; i < (size_t)argc; i++)
+  {
+    readCallGraph(argv[i]);
+  }
+
+  for (i = 0; i < nodeCount; i++)
+  {
+    nodes[i].dead = nodes[i].defined && isDiscarded(&nodes[i]);
+    live += (nodes[i].defined && !nodes[i].dead);
+  }
+  for (i = 0; i < edgeCount; i++)
+  {
+    if (!nodes[edges[i].from].dead)
+    {
+      nodes[edges[i].to].called = 1;
+    }
+  }
+
+  /* Roots, deepest first within each priority */
+  count = 0;
+  for (i = 0; i < nodeCount; i++)
+  {
+    if (isRoot(&nodes[i]))
+    {
+      visit((int)i);
+      order[count++] = (int)i;
+      if (strcmp(nodes[i].name, "main") == 0)
+      {
+        mainNode = (int)i;
+      }
+    }
+  }
+  if (mainNode == NO_NODE)
+  {
+    fprintf(stderr, "stackest: no main in the call graph\n");
+    return 2;
+  }
+
+  printf("===== Worst-case stack per root (%zu live functions) =====\n", live);
+  printf("%8s  %5s  %-28s %s\n", "bytes", "prio", "root", "deepest path");
+  for (i = 0; i < count; i++)
+  {
+    const Node *node = &nodes[order[i]];
+    int prio = priorityOf(node->name);
+
+    if (order[i] == mainNode)
+    {
+      printf("%s%7lu  %5s  %-28s ", node->bounded ? " " : ">=", node->depth, "-", node->name);
+    }
+    else if (prio == INT32_MAX)
+    {
+      printf("%s%7lu  %5s  %-28s ", node->bounded ? " " : ">=", node->depth, "?", node->name);
+    }
+    else
+    {
+      printf("%s%7lu  %5d  %-28s ", node->bounded ? " " : ">=", node->depth, prio, node->name);
+    }
+    printPath(order[i]);
+  }
+  printf("\n");
+
+  /* main, then the deepest handler of each priority level */
+  total = nodes[mainNode].depth;
+  bounded = nodes[mainNode].bounded;
+  for (i = 0; i < count; i++)
+  {
+    const Node *node = &nodes[order[i]];
+    int prio = priorityOf(node->name);
+    int deepest = 1;
+
+    if (order[i] == mainNode)
+    {
+      continue;
+    }
+    for (j = 0; j < count; j++)
+    {
+      const Node *other = &nodes[order[j]];
+
+      if ((order[j] != mainNode) && (j != i) && (priorityOf(other->name) == prio) &&
+          ((other->depth > node->depth) || ((other->depth == node->depth) && (j < i))))
+      {
+        deepest = 0;
+      }
+    }
+    if (deepest)
+    {
+      total += node->depth + excFrame;
+      bounded &= node->bounded;
+      levels++;
+    }
+  }
+
+  count = 0;
+  for (i = 0; i < nodeCount; i++)
+  {
+    if (!nodes[i].dead && (nodes[i].state == STATE_DONE))
+    {
+      unknown += (!nodes[i].defined && (strcmp(nodes[i].title, INDIRECT) != 0));
+      if (nodes[i].defined)
+      {
+        order[count++] = (int)i;
+      }
+    }
+  }
+  qsort(order, count, sizeof(order[0]), byFrameDesc);
+  printf("===== Largest frames (top %u of %zu reachable) =====\n", top, count);
+  for (i = 0; (i < count) && (i < top); i++)
+  {
+    const Node *node = &nodes[order[i]];
+
+    printf("%8lu  %-40s %s%s%s\n", node->frame, node->name, node->unit,
+           node->dynamic ? "  dynamic" : "", node->recursive ? "  recursive" : "");
+  }
+  printf("\n");
+
+  printf("===== Worst case =====\n");
+  printf("  main %lu + %u handler levels with %lu-byte exception frames\n",
+         nodes[mainNode].depth, levels, excFrame);
+  printf("  total    %s%lu bytes", bounded ? "" : ">=", total);
+  if (limit != 0U)
+  {
+    printf("  limit %lu %s", limit, (total > limit) ? "EXCEEDED" : "ok");
+  }
+  printf("\n");
+  if (unknown != 0U)
+  {
+    printf("  %u reachable functions without a frame size (marked ?) count as 0\n", unknown);
+  }
+
+  return ((limit != 0U) && (total > limit)) ? 1 : 0;
+}
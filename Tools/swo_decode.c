@@ -0,0 +1,338 @@
+/**
+  ******************************************************************************
+  * @file           : swo_decode.c
+  * @brief          : Host decoder for the firmware SWO/ITM event trace
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Reads a raw SWO byte stream (as written by OpenOCD "tpiu config ... <file>"
+  * or any UART SWO capture), extracts the records emitted by Trace_Emit()
+  * (see Core/Inc/trace.h) and prints a timeline. With -s it also prints
+  * duration statistics for paired events (ISR enter/exit, task start/stop,
+  * TX enqueue/complete, idle enter/exit), which is what A/B cycle comparisons
+  * are read from.
+  *
+  * Usage: swo_decode [-c clock_hz] [-s] [-q] capture.bin
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Must match Core/Inc/trace.h */
+#define TRACE_PORT_EVENT        1U
+#define TRACE_PORT_TIME         2U
+
+#define EVT_CAN_TX_ENQUEUE      0x01
+#define EVT_CAN_TX_COMPLETE     0x02
+#define EVT_CAN_RX_ISR_ENTER    0x03
+#define EVT_CAN_RX_ISR_EXIT     0x04
+#define EVT_ADC_DONE            0x05
+#define EVT_TASK_START          0x06
+#define EVT_TASK_STOP           0x07
+#define EVT_IDLE_ENTER          0x08
+#define EVT_IDLE_EXIT           0x09
+
+#define DEFAULT_CLOCK_HZ        64000000UL  /* HCLK, SystemClock_Config() */
+#define MAX_KEYS                16U
+
+typedef struct
+{
+  uint64_t cycles;
+  uint8_t id;
+  uint8_t arg0;
+  uint16_t arg1;
+} TraceRecord;
+
+typedef struct
+{
+  const char *name;
+  uint8_t startId;
+  uint8_t stopId;
+  uint64_t open[MAX_KEYS];
+  uint8_t isOpen[MAX_KEYS];
+  uint64_t count[MAX_KEYS];
+  uint64_t sum[MAX_KEYS];
+  uint64_t min[MAX_KEYS];
+  uint64_t max[MAX_KEYS];
+} PairStats;
+
+static PairStats pairs[] =
+{
+  { .name = "RX ISR (fifo)",     .startId = EVT_CAN_RX_ISR_ENTER, .stopId = EVT_CAN_RX_ISR_EXIT },
+  { .name = "Task (id)",         .startId = EVT_TASK_START,       .stopId = EVT_TASK_STOP },
+  { .name = "TX latency (mbox)", .startId = EVT_CAN_TX_ENQUEUE,   .stopId = EVT_CAN_TX_COMPLETE },
+  { .name = "Idle (mode)",       .startId = EVT_IDLE_ENTER,       .stopId = EVT_IDLE_EXIT },
+};
+
+static const char *eventName(uint8_t id)
+{
+  switch (id)
+  {
+    case EVT_CAN_TX_ENQUEUE:   return "CAN_TX_ENQUEUE";
+    case EVT_CAN_TX_COMPLETE:  return "CAN_TX_COMPLETE";
+    case EVT_CAN_RX_ISR_ENTER: return "CAN_RX_ISR_ENTER";
+    case EVT_CAN_RX_ISR_EXIT:  return "CAN_RX_ISR_EXIT";
+    case EVT_ADC_DONE:         return "ADC_DONE";
+    case EVT_TASK_START:       return "TASK_START";
+    case EVT_TASK_STOP:        return "TASK_STOP";
+    case EVT_IDLE_ENTER:       return "IDLE_ENTER";
+    case EVT_IDLE_EXIT:        return "IDLE_EXIT";
+    default:                   return "UNKNOWN";
+  }
+}
+
+static unsigned long clockHz = DEFAULT_CLOCK_HZ;
+static int printTimeline = 1;
+static int printStats = 0;
+
+static uint64_t firstCycles;
+static uint64_t lastCycles;
+static uint64_t recordCount;
+static int haveFirst;
+
+static void updatePairs(const TraceRecord *rec)
+{
+  size_t i;
+  uint8_t key = (uint8_t)(rec->arg0 % MAX_KEYS);
+
+  for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+  {
+    PairStats *p = &pairs[i];
+
+    if (rec->id == p->startId)
+    {
+      p->open[key] = rec->cycles;
+      p->isOpen[key] = 1;
+    }
+    else if ((rec->id == p->stopId) && p->isOpen[key])
+    {
+      uint64_t d = rec->cycles - p->open[key];
+
+      if ((p->count[key] == 0U) || (d < p->min[key]))
+      {
+        p->min[key] = d;
+      }
+      if (d > p->max[key])
+      {
+        p->max[key] = d;
+      }
+      p->sum[key] += d;
+      p->count[key]++;
+      p->isOpen[key] = 0;
+    }
+  }
+}
+
+static void handleRecord(const TraceRecord *rec)
+{
+  if (!haveFirst)
+  {
+    firstCycles = rec->cycles;
+    lastCycles = rec->cycles;
+    haveFirst = 1;
+  }
+
+  if (printTimeline)
+  {
+    double t = (double)(rec->cycles - firstCycles) / (double)clockHz;
+    double dt = (double)(rec->cycles - lastCycles) * 1e6 / (double)clockHz;
+
+    printf("%12.6f s  +%10.2f us  %-17s arg0=%-3u arg1=0x%04X (%u)\n",
+           t, dt, eventName(rec->id), rec->arg0, rec->arg1, rec->arg1);
+  }
+
+  lastCycles = rec->cycles;
+  recordCount++;
+
+  if (printStats)
+  {
+    updatePairs(rec);
+  }
+}
+
+static void reportStats(void)
+{
+  size_t i;
+  unsigned k;
+
+  printf("\n===== Event pair durations (cycles @ %lu Hz) =====\n", clockHz);
+  printf("%-20s %4s %10s %10s %10s %10s\n", "pair", "key", "count", "min", "avg", "max");
+  for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+  {
+    for (k = 0; k < MAX_KEYS; k++)
+    {
+      const PairStats *p = &pairs[i];
+
+      if (p->count[k] == 0U)
+      {
+        continue;
+      }
+      printf("%-20s %4u %10llu %10llu %10llu %10llu\n", p->name, k,
+             (unsigned long long)p->count[k], (unsigned long long)p->min[k],
+             (unsigned long long)(p->sum[k] / p->count[k]),
+             (unsigned long long)p->max[k]);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  FILE *in;
+  int opt;
+  int c;
+  uint32_t pendingEvent = 0;
+  int havePending = 0;
+  uint32_t lastStamp = 0;
+  uint64_t stampHigh = 0;
+  unsigned long overflows = 0;
+  unsigned long orphans = 0;
+  unsigned long zeros = 0;
+
+  while ((opt = getopt(argc, argv, "c:sqh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'c': clockHz = strtoul(optarg, NULL, 0); break;
+      case 's': printStats = 1; break;
+      case 'q': printTimeline = 0; break;
+      default:
+        fprintf(stderr, "usage: %s [-c clock_hz] [-s] [-q] capture.bin\n", argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if ((optind >= argc) || (clockHz == 0U))
+  {
+    fprintf(stderr, "usage: %s [-c clock_hz] [-s] [-q] capture.bin\n", argv[0]);
+    return 2;
+  }
+
+  in = (strcmp(argv[optind], "-") == 0) ? stdin : fopen(argv[optind], "rb");
+  if (in == NULL)
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  while ((c = fgetc(in)) != EOF)
+  {
+    uint8_t h = (uint8_t)c;
+
+    /* Synchronisation packet: a run of zero bytes terminated by 0x80 */
+    if (h == 0x00U)
+    {
+      zeros++;
+      continue;
+    }
+    if ((h == 0x80U) && (zeros >= 5U))
+    {
+      zeros = 0;
+      continue;
+    }
+    zeros = 0;
+
+    if (h == 0x70U)
+    {
+      /* ITM FIFO overflow: records were lost, the pending pair is unreliable */
+      overflows++;
+      havePending = 0;
+      continue;
+    }
+
+    if ((h & 0x03U) == 0U)
+    {
+      /* Protocol packet: timestamp, extension or global timestamp */
+      if (((h & 0x0FU) == 0U) || ((h & 0x0BU) == 0x08U) || (h == 0x94U) || (h == 0xB4U))
+      {
+        int cont = (h & 0x80U) != 0U;
+
+        while (cont && ((c = fgetc(in)) != EOF))
+        {
+          cont = (c & 0x80) != 0;
+        }
+      }
+      continue;
+    }
+
+    /* Source packet: payload of 1, 2 or 4 bytes */
+    {
+      unsigned size = ((h & 0x03U) == 3U) ? 4U : (h & 0x03U);
+      unsigned port = h >> 3;
+      uint32_t value = 0;
+      unsigned i;
+
+      for (i = 0; i < size; i++)
+      {
+        if ((c = fgetc(in)) == EOF)
+        {
+          break;
+        }
+        value |= (uint32_t)(uint8_t)c << (8U * i);
+      }
+      if (i != size)
+      {
+        break;
+      }
+
+      /* Hardware (DWT) packets and other stimulus ports are ignored */
+      if (((h & 0x04U) != 0U) || (size != 4U))
+      {
+        continue;
+      }
+
+      if (port == TRACE_PORT_EVENT)
+      {
+        if (havePending)
+        {
+          orphans++;
+        }
+        pendingEvent = value;
+        havePending = 1;
+      }
+      else if ((port == TRACE_PORT_TIME) && havePending)
+      {
+        TraceRecord rec;
+
+        /* Extend the 32-bit DWT->CYCCNT; assumes one record per wrap period */
+        if (value < lastStamp)
+        {
+          stampHigh += 1ULL << 32;
+        }
+        lastStamp = value;
+
+        rec.cycles = stampHigh | value;
+        rec.id = (uint8_t)(pendingEvent >> 24);
+        rec.arg0 = (uint8_t)(pendingEvent >> 16);
+        rec.arg1 = (uint16_t)pendingEvent;
+        havePending = 0;
+        handleRecord(&rec);
+      }
+    }
+  }
+
+  if (in != stdin)
+  {
+    fclose(in);
+  }
+
+  fprintf(stderr, "%llu records, %lu ITM overflows, %lu orphaned event words\n",
+          (unsigned long long)recordCount, overflows, orphans);
+
+  if (printStats)
+  {
+    reportStats();
+  }
+
+  return 0;
+}
@@ -0,0 +1,636 @@
+/**
+  ******************************************************************************
+  * @file           : tempfilter.c
+  * @brief          : Temperature filter stage on recorded conversions, CMSIS
+  *                   against plain C benchmark and self-check
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Runs the firmware's filter stage (Core/Inc/filter.h), on the same
+  * CMSIS-DSP sources, over conversions recorded in candump logs and pcap
+  * captures (n2klog.h): the PGN 130312 values of a node with the filter off
+  * are one conversion each, and go back to codes through the calibration
+  * words. The codes are taken in batches as the node would take them, and
+  * for each mode the RMS error of the conversions and of the filtered
+  * values against a straight line fitted through the recording is reported;
+  * a recording at a steady or steadily changing temperature leaves the
+  * noise.
+  *
+  * With -B the kernels are timed against plain C loops doing the same
+  * arithmetic, per batch. The CMSIS kernels are built for the Cortex-M4
+  * (ARM_MATH_CM4) with the simulator's C stand-ins for the SIMD intrinsics
+  * (Sim/Inc/sim_cmsis.h), so the host numbers compare code paths, not
+  * target cycles.
+  *
+  * With -x the filter stage is checked instead:
+  *
+  *   - the mean and the IIR give the same values as the plain C loops, bit
+  *     for bit, for every batch size and every cutoff, and the median the
+  *     middle of a sorted batch
+  *   - a constant conversion comes out unchanged for every code, at the
+  *     lowest, default and highest cutoffs
+  *   - a full-scale step through the IIR, overshoot and all, never wraps
+  *     and settles
+  *   - on a noisy ramp every mode takes the noise down by 5 dB or more at
+  *     the default batch and cutoff
+  *
+  * Usage: tempfilter [-m mode] [-n batch] [-f cutoff] [-a cal30] [-b cal110]
+  *                   [-o offset] log...
+  *        tempfilter -B
+  *        tempfilter -x
+  */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "filter.h"
+#include "n2klog.h"
+
+#define TEMP_PGN          130312UL
+#define CAL30_DEFAULT     1774U     /* the simulator's TS_CAL1, TS_CAL2 */
+#define CAL110_DEFAULT    1348U
+#define BATCH_DEFAULT     8U        /* as in Core/Src/params.c */
+#define CUTOFF_DEFAULT    50U
+#define CODE_MAX          4095U
+#define BENCH_MIN_NS      200000000ULL
+#define BENCH_BATCHES     1024U
+#define CHECK_BATCHES     64U
+#define NOISE_MIN_DB      5.0
+
+/**
+  * @brief The IIR as plain C: the kernel's arithmetic, one sample at a time
+  */
+typedef struct
+{
+  q31_t coeffs[5];
+  q31_t x[2];
+  q31_t y[2];
+  int primed;
+} Plain_Iir;
+
+static const char *const modeNames[FILTER_MODES] = { "off", "mean", "IIR", "median" };
+
+static uint16_t *codes;
+static uint32_t codeCount;
+static uint32_t codeSize;
+static uint32_t failures;
+static uint32_t rng = 1U;
+
+/*--------------------------------- helpers ----------------------------------*/
+
+static uint32_t xorshift32(void)
+{
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static uint64_t nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void fail(const char *what, uint32_t mode, uint32_t batch, uint32_t cutoff, uint32_t at)
+{
+  if (failures < 10U)
+  {
+    fprintf(stderr, "self-check: %s, %s, batch %u, cutoff %u, at %u\n", what, modeNames[mode], (unsigned)batch,
+            (unsigned)cutoff, (unsigned)at);
+  }
+  failures++;
+}
+
+static void addCode(uint16_t code)
+{
+  if (codeCount == codeSize)
+  {
+    codeSize = (codeSize == 0U) ? 4096U : (codeSize * 2U);
+    codes = realloc(codes, codeSize * sizeof(*codes));
+    if (codes == NULL)
+    {
+      perror("codes");
+      exit(2);
+    }
+  }
+  codes[codeCount++] = code;
+}
+
+/* Noisy ramp around the middle of the scale, peak noise in codes */
+static void synthesize(uint32_t count, double slope, uint32_t noise)
+{
+  uint32_t i;
+
+  codeCount = 0;
+  for (i = 0; i < count; i++)
+  {
+    double raw = 1700.0 + slope * (double)i + (double)noise * (2.0 * ((double)xorshift32() / 4294967295.0) - 1.0);
+
+    addCode((uint16_t)lround((raw < 0.0) ? 0.0 : ((raw > CODE_MAX) ? CODE_MAX : raw)));
+  }
+}
+
+/*------------------------------- plain C loops -------------------------------*/
+
+static uint32_t plainMean(const uint16_t *batch, uint32_t count)
+{
+  int32_t sum = 0;
+  uint32_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    sum += (int32_t)batch[i] << FILTER_FRAC_BITS;
+  }
+  return (uint32_t)(sum / (int32_t)count);
+}
+
+static void plainIirStart(Plain_Iir *iir, const Filter_State *filter)
+{
+  memcpy(iir->coeffs, filter->coeffs, sizeof(iir->coeffs));
+  iir->primed = 0;
+}
+
+static uint32_t plainIir(Plain_Iir *iir, const uint16_t *batch, uint32_t count)
+{
+  q31_t y = 0;
+  uint32_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    q31_t x = (q31_t)((uint32_t)batch[i] << FILTER_IIR_SHIFT);
+    int64_t acc;
+
+    if (!iir->primed)
+    {
+      iir->x[0] = iir->x[1] = iir->y[0] = iir->y[1] = x;
+      iir->primed = 1;
+    }
+    acc = (int64_t)iir->coeffs[0] * x + (int64_t)iir->coeffs[1] * iir->x[0] + (int64_t)iir->coeffs[2] * iir->x[1] +
+          (int64_t)iir->coeffs[3] * iir->y[0] + (int64_t)iir->coeffs[4] * iir->y[1];
+    y = (q31_t)(acc >> 30);
+    iir->x[1] = iir->x[0];
+    iir->x[0] = x;
+    iir->y[1] = iir->y[0];
+    iir->y[0] = y;
+  }
+  if (y <= 0)
+  {
+    return 0U;
+  }
+  if (y >= (q31_t)(CODE_MAX << FILTER_IIR_SHIFT))
+  {
+    return CODE_MAX << FILTER_FRAC_BITS;
+  }
+  return ((uint32_t)y + (1UL << (FILTER_IIR_SHIFT - FILTER_FRAC_BITS - 1U))) >> (FILTER_IIR_SHIFT - FILTER_FRAC_BITS);
+}
+
+static int compareCodes(const void *a, const void *b)
+{
+  return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+static uint32_t sortedMedian(const uint16_t *batch, uint32_t count)
+{
+  uint16_t sorted[FILTER_BATCH_MAX];
+
+  memcpy(sorted, batch, count * sizeof(sorted[0]));
+  qsort(sorted, count, sizeof(sorted[0]), compareCodes);
+  if ((count & 1U) != 0U)
+  {
+    return (uint32_t)sorted[count / 2U] << FILTER_FRAC_BITS;
+  }
+  return ((uint32_t)sorted[count / 2U - 1U] + sorted[count / 2U]) << (FILTER_FRAC_BITS - 1U);
+}
+
+/*---------------------------------- noise ------------------------------------*/
+
+/**
+  * @brief RMS errors of the conversions and of the filtered values against
+  *        the least-squares line through the conversions, in codes
+  */
+static void noise(uint32_t mode, uint32_t batch, uint32_t cutoff, double *rawRms, double *filteredRms,
+                  uint32_t *values)
+{
+  Filter_State filter;
+  double sx = 0.0;
+  double sy = 0.0;
+  double sxx = 0.0;
+  double sxy = 0.0;
+  double slope;
+  double intercept;
+  double raw = 0.0;
+  double filtered = 0.0;
+  uint32_t count = 0;
+  uint32_t i;
+
+  for (i = 0; i < codeCount; i++)
+  {
+    sx += i;
+    sy += codes[i];
+    sxx += (double)i * i;
+    sxy += (double)i * codes[i];
+  }
+  slope = (codeCount * sxy - sx * sy) / (codeCount * sxx - sx * sx);
+  intercept = (sy - slope * sx) / codeCount;
+  for (i = 0; i < codeCount; i++)
+  {
+    double e = codes[i] - (intercept + slope * i);
+
+    raw += e * e;
+  }
+
+  Filter_Configure(&filter, mode, batch, cutoff);
+  batch = Filter_Batch(&filter);
+  for (i = 0; (i + batch) <= codeCount; i += batch)
+  {
+    double value = (double)Filter_Run(&filter, &codes[i], batch) / (double)(1U << FILTER_FRAC_BITS);
+    double e = value - (intercept + slope * (i + batch - 1U));
+
+    filtered += e * e;
+    count++;
+  }
+  *rawRms = sqrt(raw / codeCount);
+  *filteredRms = (count > 0U) ? sqrt(filtered / count) : 0.0;
+  *values = count;
+}
+
+static int loadLog(const char *path, uint32_t cal30, uint32_t cal110, int32_t offset)
+{
+  N2k_Log log;
+  N2k_Frame frame;
+  N2k_Id id;
+  size_t pos;
+
+  if (N2k_Open(&log, path) != 0)
+  {
+    return -1;
+  }
+  pos = log.first;
+  while (N2k_Next(&log, &pos, log.size, &frame) > 0)
+  {
+    uint16_t centiK;
+    double code;
+
+    if (!frame.ext || frame.rtr || (frame.dlc < 5U))
+    {
+      continue;
+    }
+    N2k_SplitId(frame.id, &id);
+    centiK = (uint16_t)(frame.data[3] | ((uint16_t)frame.data[4] << 8));
+    if ((id.pgn != TEMP_PGN) || (centiK == 0xFFFFU))
+    {
+      continue;
+    }
+    code = (double)cal30 + ((double)((int32_t)centiK - offset) / 100.0 - 273.15 - 30.0) *
+           ((double)cal110 - (double)cal30) / 80.0;
+    addCode((uint16_t)lround((code < 0.0) ? 0.0 : ((code > CODE_MAX) ? CODE_MAX : code)));
+  }
+  N2k_Close(&log);
+  return 0;
+}
+
+static int recorded(int count, char **paths, int modeArg, uint32_t batch, uint32_t cutoff, uint32_t cal30,
+                    uint32_t cal110, int32_t offset)
+{
+  double codeC = 80.0 / fabs((double)cal110 - (double)cal30);
+  uint32_t mode;
+  int k;
+
+  for (k = 0; k < count; k++)
+  {
+    if (loadLog(paths[k], cal30, cal110, offset) != 0)
+    {
+      return 2;
+    }
+  }
+  if (codeCount < (2U * FILTER_BATCH_MAX))
+  {
+    fprintf(stderr, "%u PGN 130312 values, too few\n", (unsigned)codeCount);
+    return 1;
+  }
+
+  printf("===== Temperature filter, %u conversions, batch %u, cutoff %u per mille =====\n", (unsigned)codeCount,
+         (unsigned)batch, (unsigned)cutoff);
+  for (mode = 0; mode < FILTER_MODES; mode++)
+  {
+    double rawRms;
+    double filteredRms;
+    uint32_t values;
+
+    if ((modeArg >= 0) && ((uint32_t)modeArg != mode))
+    {
+      continue;
+    }
+    noise(mode, batch, cutoff, &rawRms, &filteredRms, &values);
+    printf("  %-7s %6u values, RMS %.3f codes (%.4f degC) from %.3f codes raw", modeNames[mode], (unsigned)values,
+           filteredRms, filteredRms * codeC, rawRms);
+    if (filteredRms > 0.0)
+    {
+      printf(", %.1f dB", 20.0 * log10(rawRms / filteredRms));
+    }
+    printf("\n");
+  }
+  return 0;
+}
+
+/*-------------------------------- benchmark ----------------------------------*/
+
+static double timeBatches(uint32_t mode, uint32_t batch, int plain)
+{
+  Filter_State filter;
+  Plain_Iir iir;
+  volatile uint32_t sink = 0;
+  uint64_t start;
+  uint64_t rounds = 0;
+  uint32_t i;
+
+  Filter_Configure(&filter, mode, batch, CUTOFF_DEFAULT);
+  plainIirStart(&iir, &filter);
+  start = nowNs();
+  do
+  {
+    for (i = 0; i < BENCH_BATCHES; i++)
+    {
+      const uint16_t *b = &codes[i * batch];
+
+      if (!plain)
+      {
+        sink += Filter_Run(&filter, b, batch);
+      }
+      else if (mode == FILTER_MODE_MEAN)
+      {
+        sink += plainMean(b, batch);
+      }
+      else if (mode == FILTER_MODE_IIR)
+      {
+        sink += plainIir(&iir, b, batch);
+      }
+      else
+      {
+        sink += sortedMedian(b, batch);
+      }
+    }
+    rounds++;
+  } while ((nowNs() - start) < BENCH_MIN_NS);
+  (void)sink;
+  return (double)(nowNs() - start) / (double)(rounds * BENCH_BATCHES);
+}
+
+static int benchmark(void)
+{
+  static const uint32_t batches[] = { 4U, 8U, 16U };
+  uint32_t mode;
+  uint32_t k;
+
+  synthesize(BENCH_BATCHES * FILTER_BATCH_MAX, 0.0, 10U);
+  printf("===== Temperature filter benchmark, ns per batch on this host =====\n");
+  printf("  %-7s %5s %10s %10s %8s\n", "mode", "batch", "firmware", "plain C", "ratio");
+  for (mode = FILTER_MODE_MEAN; mode < FILTER_MODES; mode++)
+  {
+    for (k = 0; k < sizeof(batches) / sizeof(batches[0]); k++)
+    {
+      double firmware = timeBatches(mode, batches[k], 0);
+      double plain = timeBatches(mode, batches[k], 1);
+
+      printf("  %-7s %5u %10.1f %10.1f %8.2f\n", modeNames[mode], (unsigned)batches[k], firmware, plain,
+             plain / firmware);
+    }
+  }
+  printf("  (median: insertion sort in the firmware against qsort(); mean and IIR: CMSIS-DSP against loops)\n");
+  return 0;
+}
+
+/*-------------------------------- self-check ---------------------------------*/
+
+static void checkKernels(void)
+{
+  uint32_t batch;
+  uint32_t cutoff;
+  uint32_t i;
+
+  synthesize(CHECK_BATCHES * FILTER_BATCH_MAX, 0.05, 40U);
+  for (batch = 1; batch <= FILTER_BATCH_MAX; batch++)
+  {
+    Filter_State filter;
+
+    Filter_Configure(&filter, FILTER_MODE_MEAN, batch, CUTOFF_DEFAULT);
+    for (i = 0; i < CHECK_BATCHES; i++)
+    {
+      if (Filter_Run(&filter, &codes[i * batch], batch) != plainMean(&codes[i * batch], batch))
+      {
+        fail("mean differs from the plain loop", FILTER_MODE_MEAN, batch, CUTOFF_DEFAULT, i);
+      }
+    }
+    Filter_Configure(&filter, FILTER_MODE_MEDIAN, batch, CUTOFF_DEFAULT);
+    for (i = 0; i < CHECK_BATCHES; i++)
+    {
+      if (Filter_Run(&filter, &codes[i * batch], batch) != sortedMedian(&codes[i * batch], batch))
+      {
+        fail("median differs from the sorted batch", FILTER_MODE_MEDIAN, batch, CUTOFF_DEFAULT, i);
+      }
+    }
+    for (cutoff = FILTER_CUTOFF_MIN; cutoff <= FILTER_CUTOFF_MAX; cutoff++)
+    {
+      Plain_Iir iir;
+
+      Filter_Configure(&filter, FILTER_MODE_IIR, batch, cutoff);
+      plainIirStart(&iir, &filter);
+      for (i = 0; i < CHECK_BATCHES; i++)
+      {
+        if (Filter_Run(&filter, &codes[i * batch], batch) != plainIir(&iir, &codes[i * batch], batch))
+        {
+          fail("IIR differs from the plain loop", FILTER_MODE_IIR, batch, cutoff, i);
+          break;
+        }
+      }
+    }
+  }
+}
+
+static void checkSteady(void)
+{
+  static const uint32_t cutoffs[] = { FILTER_CUTOFF_MIN, CUTOFF_DEFAULT, FILTER_CUTOFF_MAX };
+  uint16_t batch[FILTER_BATCH_MAX];
+  uint32_t mode;
+  uint32_t k;
+  uint32_t code;
+  uint32_t i;
+
+  for (code = 0; code <= CODE_MAX; code++)
+  {
+    for (i = 0; i < FILTER_BATCH_MAX; i++)
+    {
+      batch[i] = (uint16_t)code;
+    }
+    for (mode = 0; mode < FILTER_MODES; mode++)
+    {
+      for (k = 0; k < sizeof(cutoffs) / sizeof(cutoffs[0]); k++)
+      {
+        Filter_State filter;
+
+        Filter_Configure(&filter, mode, BATCH_DEFAULT, cutoffs[k]);
+        for (i = 0; i < 4U; i++)
+        {
+          if (Filter_Run(&filter, batch, Filter_Batch(&filter)) != (code << FILTER_FRAC_BITS))
+          {
+            fail("constant conversion changed", mode, BATCH_DEFAULT, cutoffs[k], code);
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+static void checkStep(void)
+{
+  uint16_t low[FILTER_BATCH_MAX];
+  uint16_t high[FILTER_BATCH_MAX];
+  uint32_t cutoff;
+  uint32_t i;
+
+  memset(low, 0, sizeof(low));
+  for (i = 0; i < FILTER_BATCH_MAX; i++)
+  {
+    high[i] = CODE_MAX;
+  }
+  for (cutoff = FILTER_CUTOFF_MIN; cutoff <= FILTER_CUTOFF_MAX; cutoff += 5U)
+  {
+    Filter_State filter;
+    uint32_t last = 0;
+    uint32_t value = 0;
+
+    Filter_Configure(&filter, FILTER_MODE_IIR, 1U, cutoff);
+    (void)Filter_Run(&filter, low, 1U);
+    for (i = 0; i < 20000U; i++)
+    {
+      value = Filter_Run(&filter, high, 1U);
+      /* A wrap drops to the far end of the scale */
+      if ((last >= ((CODE_MAX << FILTER_FRAC_BITS) / 2U)) && (value < ((CODE_MAX << FILTER_FRAC_BITS) / 2U)))
+      {
+        fail("IIR step wrapped", FILTER_MODE_IIR, 1U, cutoff, i);
+        break;
+      }
+      last = value;
+    }
+    if (value != (CODE_MAX << FILTER_FRAC_BITS))
+    {
+      fail("IIR step did not settle", FILTER_MODE_IIR, 1U, cutoff, value);
+    }
+  }
+}
+
+static void checkNoise(void)
+{
+  uint32_t mode;
+
+  synthesize(8192U, 0.02, 10U);
+  for (mode = FILTER_MODE_MEAN; mode < FILTER_MODES; mode++)
+  {
+    double rawRms;
+    double filteredRms;
+    uint32_t values;
+
+    noise(mode, BATCH_DEFAULT, CUTOFF_DEFAULT, &rawRms, &filteredRms, &values);
+    printf("  %-7s RMS %.3f codes from %.3f, %.1f dB\n", modeNames[mode], filteredRms, rawRms,
+           20.0 * log10(rawRms / filteredRms));
+    if (20.0 * log10(rawRms / filteredRms) < NOISE_MIN_DB)
+    {
+      fail("noise not taken down", mode, BATCH_DEFAULT, CUTOFF_DEFAULT, 0U);
+    }
+  }
+}
+
+static int selfCheck(void)
+{
+  printf("===== Temperature filter self-check =====\n");
+  checkKernels();
+  checkSteady();
+  checkStep();
+  checkNoise();
+  printf("  check   %s\n", (failures == 0U) ? "ok" : "FAILED");
+  return (failures == 0U) ? 0 : 1;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-m mode] [-n batch] [-f cutoff] [-a cal30] [-b cal110] [-o offset] log...\n"
+          "       %s -B\n"
+          "       %s -x\n"
+          "  -m  only this mode: 0 off, 1 mean, 2 IIR, 3 median (default all)\n"
+          "  -n  conversions per batch (default %u)\n"
+          "  -f  IIR cutoff, per mille of the conversion rate (default %u)\n"
+          "  -a  TS_CAL1 word (default %u)\n"
+          "  -b  TS_CAL2 word (default %u)\n"
+          "  -o  PARAM_TEMP_OFFSET of the recording, 0.01 K (default 0)\n"
+          "  -B  time the kernels against plain C loops\n"
+          "  -x  check the filter stage\n"
+          "  log candump logs or pcap captures of a node with the filter off\n",
+          prog, prog, prog, BATCH_DEFAULT, CUTOFF_DEFAULT, CAL30_DEFAULT, CAL110_DEFAULT);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t cal30 = CAL30_DEFAULT;
+  uint32_t cal110 = CAL110_DEFAULT;
+  uint32_t batch = BATCH_DEFAULT;
+  uint32_t cutoff = CUTOFF_DEFAULT;
+  int32_t offset = 0;
+  int mode = -1;
+  int bench = 0;
+  int check = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "m:n:f:a:b:o:Bxh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'm': mode = (int)strtol(optarg, NULL, 0); break;
+      case 'n': batch = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'f': cutoff = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'a': cal30 = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'b': cal110 = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'o': offset = (int32_t)strtol(optarg, NULL, 0); break;
+      case 'B': bench = 1; break;
+      case 'x': check = 1; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+
+  if (bench || check)
+  {
+    if (optind != argc)
+    {
+      usage(argv[0]);
+      return 2;
+    }
+    return check ? selfCheck() : benchmark();
+  }
+  if ((optind >= argc) || (mode >= (int)FILTER_MODES) || (batch < 1U) || (batch > FILTER_BATCH_MAX) ||
+      (cutoff < FILTER_CUTOFF_MIN) || (cutoff > FILTER_CUTOFF_MAX) || (cal30 > CODE_MAX) || (cal110 > CODE_MAX) ||
+      (cal30 == cal110))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+  return recorded(argc - optind, &argv[optind], mode, batch, cutoff, cal30, cal110, offset);
+}
@@ -0,0 +1,549 @@
+/**
+  ******************************************************************************
+  * @file           : temphist.c
+  * @brief          : Temperature history retrieval (SocketCAN) and block codec
+  *                   benchmark
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Retrieval sends HIST_GET (Core/Inc/history.h) to the node, places the data
+  * frames by frame number, checks the CRC from HIST_END, decodes the blocks
+  * and prints "uptime_s,celsius" lines on stdout.
+  *
+  * With -b the files are candump logs instead (candump -L, or the simulator's
+  * -l): the PGN 130312 samples in them are encoded into blocks with the
+  * firmware's own codec, decoded again and compared, and the size and speed
+  * of both directions are reported.
+  *
+  * Usage: temphist [-i ifname] [-a node] [-s src] [-f from] [-t to]
+  *        temphist -b log...
+  */
+
+#include <errno.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "boot.h"
+#include "history.h"
+
+#define TEMP_PGN            130312UL
+#define MAX_BYTES           (HISTORY_BLOCKS * HISTORY_BLOCK_SIZE)
+#define MAX_FRAMES          ((MAX_BYTES + 6U) / 7U)
+#define RESPONSE_TIMEOUT_MS 1000
+#define FRAME_TIMEOUT_MS    2000
+#define BENCH_MIN_NS        200000000ULL
+
+static int sock = -1;
+static uint8_t node = BOOT_NODE_ADDRESS;
+static uint8_t src = 0xFEU;
+
+static uint16_t values[0x10000];
+
+static uint64_t nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Decodes a transfer (headers and payloads back to back) and prints it */
+static int printBlocks(const uint8_t *data, uint32_t bytes, uint32_t *samples)
+{
+  uint32_t pos = 0;
+
+  *samples = 0;
+  while (pos < bytes)
+  {
+    History_Header header;
+    int32_t count;
+    int32_t i;
+
+    if ((bytes - pos) < HISTORY_HEADER_SIZE)
+    {
+      return -1;
+    }
+    memcpy(&header, &data[pos], sizeof(header));
+    if (((pos + HISTORY_HEADER_SIZE + header.length) > bytes) ||
+        ((count = History_BlockDecode(&header, &data[pos + HISTORY_HEADER_SIZE], values,
+                                      sizeof(values) / sizeof(values[0]))) < 0))
+    {
+      return -1;
+    }
+    for (i = 0; i < count; i++)
+    {
+      uint64_t ms = (uint64_t)header.startMs + (uint64_t)i * header.intervalMs;
+
+      printf("%llu.%03u,%.2f\n", (unsigned long long)(ms / 1000U), (unsigned)(ms % 1000U),
+             ((double)values[i] / 100.0) - 273.15);
+    }
+    *samples += (uint32_t)count;
+    pos += HISTORY_HEADER_SIZE + header.length;
+  }
+  return 0;
+}
+
+/*--------------------------------- retrieval --------------------------------*/
+
+static void openSocket(const char *ifname)
+{
+  struct sockaddr_can addr;
+  struct ifreq ifr;
+  struct can_filter filter;
+
+  sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (sock < 0)
+  {
+    perror("socket(PF_CAN)");
+    exit(2);
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+  if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    exit(2);
+  }
+
+  /* PGN 0xEF00 and 0x1EF00 (data page ignored) from the node, to us */
+  filter.can_id = BOOT_CAN_ID(0, BOOT_PGN_CMD, src, node) | CAN_EFF_FLAG;
+  filter.can_mask = 0x02FFFFFFUL | CAN_EFF_FLAG;
+  (void)setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    exit(2);
+  }
+}
+
+/**
+  * @brief  Reads one frame from the node
+  * @param  cf: destination
+  * @param  timeoutMs: longest wait
+  * @retval 0 on a frame, -1 on timeout or error
+  */
+static int readFrame(struct can_frame *cf, int timeoutMs)
+{
+  struct pollfd pfd = { .fd = sock, .events = POLLIN, .revents = 0 };
+
+  if (poll(&pfd, 1, timeoutMs) <= 0)
+  {
+    return -1;
+  }
+  return (read(sock, cf, sizeof(*cf)) == (ssize_t)sizeof(*cf)) ? 0 : -1;
+}
+
+static const char *statusName(uint8_t status)
+{
+  static const char *names[] = { "ok", "busy", "bad range", "overrun, ask again" };
+
+  return (status < (sizeof(names) / sizeof(names[0]))) ? names[status] : "unknown";
+}
+
+/**
+  * @brief  Requests a range of history and prints it
+  * @param  fromS: first second of uptime
+  * @param  toS: last second of uptime, HISTORY_TIME_NOW for now
+  * @retval 0 on success
+  */
+static int retrieve(uint32_t fromS, uint32_t toS)
+{
+  static uint8_t data[MAX_FRAMES * 7U];
+  static uint8_t seen[MAX_FRAMES];
+  struct can_frame cf;
+  uint32_t bytes = 0;
+  uint32_t frames = 0;
+  uint32_t received = 0;
+  uint32_t samples;
+  uint32_t nowS;
+  uint16_t crc = 0;
+  int ended = 0;
+  uint64_t start;
+
+  memset(&cf, 0, sizeof(cf));
+  cf.can_id = BOOT_CAN_ID(BOOT_PRIO_CMD, BOOT_PGN_CMD, node, src) | CAN_EFF_FLAG;
+  cf.can_dlc = 8;
+  memset(cf.data, 0xFF, 8);
+  cf.data[0] = HISTORY_CMD_GET;
+  cf.data[1] = (uint8_t)fromS;
+  cf.data[2] = (uint8_t)(fromS >> 8);
+  cf.data[3] = (uint8_t)(fromS >> 16);
+  cf.data[4] = (uint8_t)toS;
+  cf.data[5] = (uint8_t)(toS >> 8);
+  cf.data[6] = (uint8_t)(toS >> 16);
+  start = nowNs();
+  if (write(sock, &cf, sizeof(cf)) != (ssize_t)sizeof(cf))
+  {
+    perror("write");
+    return -1;
+  }
+
+  /* The response comes first, data and END follow */
+  for (;;)
+  {
+    if (readFrame(&cf, RESPONSE_TIMEOUT_MS) != 0)
+    {
+      fprintf(stderr, "HIST_GET: no response\n");
+      return -1;
+    }
+    if ((BOOT_ID_PGN(cf.can_id & CAN_EFF_MASK) == BOOT_PGN_CMD) && (cf.data[0] == (HISTORY_CMD_GET | BOOT_RSP)))
+    {
+      break;
+    }
+  }
+  if (cf.data[1] != HISTORY_OK)
+  {
+    fprintf(stderr, "HIST_GET: %s\n", statusName(cf.data[1]));
+    return -1;
+  }
+  bytes = cf.data[3] | ((uint32_t)cf.data[4] << 8);
+  nowS = cf.data[5] | ((uint32_t)cf.data[6] << 8) | ((uint32_t)cf.data[7] << 16);
+  frames = (bytes + 6U) / 7U;
+  if (bytes > MAX_BYTES)
+  {
+    fprintf(stderr, "HIST_GET: %u bytes, more than the ring holds\n", bytes);
+    return -1;
+  }
+
+  while (!ended || (received < frames))
+  {
+    uint32_t id;
+
+    if (readFrame(&cf, FRAME_TIMEOUT_MS) != 0)
+    {
+      fprintf(stderr, "transfer stalled after %u of %u frames\n", received, frames);
+      return -1;
+    }
+    id = cf.can_id & CAN_EFF_MASK;
+    if ((BOOT_ID_PGN(id) == BOOT_PGN_CMD) && (cf.data[0] == (HISTORY_CMD_END | BOOT_RSP)))
+    {
+      if (cf.data[1] != HISTORY_OK)
+      {
+        fprintf(stderr, "HIST_END: %s\n", statusName(cf.data[1]));
+        return -1;
+      }
+      crc = (uint16_t)(cf.data[2] | ((uint16_t)cf.data[3] << 8));
+      ended = 1;
+    }
+    else if (BOOT_ID_PGN(id) == BOOT_PGN_DATA)
+    {
+      /* Frame number mod 256; frames are out of order within a burst only */
+      uint32_t n = (received & ~0xFFUL) | cf.data[0];
+
+      if (n + 128U < received)
+      {
+        n += 256U;
+      }
+      else if ((n > received + 128U) && (n >= 256U))
+      {
+        n -= 256U;
+      }
+      if ((n >= frames) || seen[n])
+      {
+        fprintf(stderr, "unexpected data frame %u\n", cf.data[0]);
+        return -1;
+      }
+      seen[n] = 1;
+      memcpy(&data[n * 7U], &cf.data[1], 7);
+      received++;
+    }
+  }
+
+  if (History_Crc16(0xFFFFU, data, bytes) != crc)
+  {
+    fprintf(stderr, "CRC mismatch\n");
+    return -1;
+  }
+  if (printBlocks(data, bytes, &samples) != 0)
+  {
+    fprintf(stderr, "malformed block\n");
+    return -1;
+  }
+  fprintf(stderr, "%u samples, %u bytes in %u frames, %.1f ms, node uptime %u s\n",
+          samples, bytes, frames, (double)(nowNs() - start) / 1e6, nowS);
+  return 0;
+}
+
+/*--------------------------------- benchmark --------------------------------*/
+
+typedef struct
+{
+  uint32_t timeMs;
+  uint16_t value;
+} Sample;
+
+static Sample *samples;
+static uint32_t sampleCount;
+static uint32_t sampleSize;
+
+/* Adds the PGN 130312 samples of a candump log */
+static int loadLog(const char *path)
+{
+  char line[256];
+  FILE *f = fopen(path, "r");
+
+  if (f == NULL)
+  {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    double t;
+    char ifname[32];
+    char idText[16];
+    char dataText[32];
+    uint32_t id;
+    uint32_t pgn;
+    uint8_t data[8];
+    uint32_t length;
+    uint32_t i;
+
+    if ((sscanf(line, " (%lf) %31s %15[0-9A-Fa-f]#%31[0-9A-Fa-f]", &t, ifname, idText, dataText) != 4) ||
+        (strlen(idText) != 8U))
+    {
+      continue;
+    }
+    id = (uint32_t)strtoul(idText, NULL, 16);
+    pgn = (id >> 8) & 0x3FFFFUL;
+    if (((pgn >> 8) & 0xFFU) < 0xF0U)
+    {
+      pgn &= ~0xFFUL;
+    }
+    length = (uint32_t)strlen(dataText) / 2U;
+    if ((pgn != TEMP_PGN) || (length < 5U))
+    {
+      continue;
+    }
+    for (i = 0; i < 5U; i++)
+    {
+      char hex[3] = { dataText[i * 2U], dataText[i * 2U + 1U], 0 };
+
+      data[i] = (uint8_t)strtoul(hex, NULL, 16);
+    }
+    if ((data[3] == 0xFFU) && (data[4] == 0xFFU))
+    {
+      continue;                   /* not available */
+    }
+    if (sampleCount == sampleSize)
+    {
+      sampleSize = (sampleSize == 0U) ? 4096U : (sampleSize * 2U);
+      samples = realloc(samples, sampleSize * sizeof(*samples));
+      if (samples == NULL)
+      {
+        perror("samples");
+        exit(2);
+      }
+    }
+    samples[sampleCount].timeMs = (uint32_t)(t * 1000.0);
+    samples[sampleCount].value = (uint16_t)(data[3] | ((uint16_t)data[4] << 8));
+    sampleCount++;
+  }
+  fclose(f);
+  return 0;
+}
+
+/* Encodes all samples into blocks, the way History_Add() fills the ring */
+static uint32_t encodeAll(History_Block *blocks, uint32_t maxBlocks)
+{
+  History_Encoder enc;
+  uint32_t used = 0;
+  uint32_t i;
+
+  for (i = 0; i < sampleCount; i++)
+  {
+    if ((used == 0U) || (History_BlockAppend(&enc, samples[i].timeMs, samples[i].value) == 0U))
+    {
+      if (used == maxBlocks)
+      {
+        break;
+      }
+      History_BlockStart(&enc, &blocks[used++], samples[i].timeMs, samples[i].value);
+    }
+  }
+  return used;
+}
+
+static int benchmark(int count, char **paths)
+{
+  History_Block *blocks;
+  uint64_t start;
+  uint64_t encodeNs;
+  uint64_t decodeNs;
+  uint32_t rounds;
+  uint32_t used;
+  uint32_t bytes = 0;
+  uint32_t next = 0;
+  uint32_t i;
+  double bytesPerSample;
+  double intervalS;
+  int k;
+
+  for (k = 0; k < count; k++)
+  {
+    if (loadLog(paths[k]) != 0)
+    {
+      return 2;
+    }
+  }
+  if (sampleCount < 2U)
+  {
+    fprintf(stderr, "no PGN 130312 samples\n");
+    return 1;
+  }
+  blocks = calloc(sampleCount, sizeof(*blocks));
+  if (blocks == NULL)
+  {
+    perror("blocks");
+    return 2;
+  }
+
+  /* Round trip */
+  used = encodeAll(blocks, sampleCount);
+  for (i = 0; i < used; i++)
+  {
+    int32_t n = History_BlockDecode(&blocks[i].header, blocks[i].payload, values,
+                                    sizeof(values) / sizeof(values[0]));
+    int32_t j;
+
+    if (n < 0)
+    {
+      fprintf(stderr, "block %u: malformed\n", i);
+      return 1;
+    }
+    for (j = 0; j < n; j++, next++)
+    {
+      if ((next >= sampleCount) || (values[j] != samples[next].value))
+      {
+        fprintf(stderr, "block %u: sample %u decodes wrong\n", i, next);
+        return 1;
+      }
+    }
+    bytes += HISTORY_HEADER_SIZE + blocks[i].header.length;
+  }
+  if (next != sampleCount)
+  {
+    fprintf(stderr, "%u of %u samples decoded\n", next, sampleCount);
+    return 1;
+  }
+
+  /* Throughput: repeat until the run is long enough to time */
+  start = nowNs();
+  rounds = 0;
+  do
+  {
+    (void)encodeAll(blocks, sampleCount);
+    rounds++;
+  } while ((nowNs() - start) < BENCH_MIN_NS);
+  encodeNs = (nowNs() - start) / rounds;
+
+  start = nowNs();
+  rounds = 0;
+  do
+  {
+    for (i = 0; i < used; i++)
+    {
+      (void)History_BlockDecode(&blocks[i].header, blocks[i].payload, values,
+                                sizeof(values) / sizeof(values[0]));
+    }
+    rounds++;
+  } while ((nowNs() - start) < BENCH_MIN_NS);
+  decodeNs = (nowNs() - start) / rounds;
+
+  bytesPerSample = (double)bytes / (double)sampleCount;
+  intervalS = (double)(samples[sampleCount - 1U].timeMs - samples[0].timeMs) / 1000.0 / (double)(sampleCount - 1U);
+
+  printf("samples           %u, %.3f s apart on average\n", sampleCount, intervalS);
+  printf("blocks            %u, %.1f samples each\n", used, (double)sampleCount / (double)used);
+  printf("size              %u bytes, %.3f bytes per sample (headers included)\n", bytes, bytesPerSample);
+  printf("ratio             %.1fx against 2 bytes raw, %.1fx against 8-byte frames\n",
+         2.0 / bytesPerSample, 8.0 / bytesPerSample);
+  printf("ring              %.1f h in %u blocks of %u bytes\n",
+         (double)HISTORY_BLOCKS * ((double)sampleCount / (double)used) * intervalS / 3600.0,
+         HISTORY_BLOCKS, HISTORY_BLOCK_SIZE);
+  printf("encode            %.1f ns per sample, %.1f M samples/s\n",
+         (double)encodeNs / (double)sampleCount, (double)sampleCount * 1e3 / (double)encodeNs);
+  printf("decode            %.1f ns per sample, %.1f M samples/s\n",
+         (double)decodeNs / (double)sampleCount, (double)sampleCount * 1e3 / (double)decodeNs);
+  printf("round trip        all samples match\n");
+  free(blocks);
+  return 0;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-i ifname] [-a node] [-s src] [-f from] [-t to]\n"
+          "       %s -b log...\n"
+          "  -i  SocketCAN interface (default can0)\n"
+          "  -a  node address (default 0x%02X)\n"
+          "  -s  our source address (default 0xFE)\n"
+          "  -f  first second of node uptime (default 0)\n"
+          "  -t  last second of node uptime (default now)\n"
+          "  -b  encode the PGN 130312 samples of candump logs and report\n",
+          prog, prog, BOOT_NODE_ADDRESS);
+}
+
+int main(int argc, char **argv)
+{
+  const char *ifname = "can0";
+  uint32_t fromS = 0;
+  uint32_t toS = HISTORY_TIME_NOW;
+  int bench = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "i:a:s:f:t:bh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'i': ifname = optarg; break;
+      case 'a': node = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 's': src = (uint8_t)strtoul(optarg, NULL, 0); break;
+      case 'f': fromS = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 't': toS = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'b': bench = 1; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+
+  if (bench)
+  {
+    if (optind >= argc)
+    {
+      usage(argv[0]);
+      return 2;
+    }
+    return benchmark(argc - optind, &argv[optind]);
+  }
+  if ((optind != argc) || (fromS > HISTORY_TIME_NOW) || (toS > HISTORY_TIME_NOW))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+  openSocket(ifname);
+  return (retrieve(fromS, toS) == 0) ? 0 : 1;
+}
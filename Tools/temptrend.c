@@ -0,0 +1,641 @@
+/**
+  ******************************************************************************
+  * @file           : temptrend.c
+  * @brief          : Temperature trend on recorded logs against the node's
+  *                   trend messages, and self-check
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2026 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  *
+  * Runs the firmware's trend codec (Core/Inc/trend.h) over the PGN 130312
+  * values in candump logs and pcap captures (n2klog.h). Where the node sent
+  * trend messages (PGN 65283) the codec's message for the same values has
+  * to match each one byte for byte; the window starts again where the node
+  * reports one sample, and takes the size the node reports once full. The
+  * T1 period and the alarm thresholds are not in the log and come from the
+  * options. The slope range and a least-squares fit in double over the
+  * whole recording are reported.
+  *
+  * With -x the codec is checked instead:
+  *
+  *   - the running sums are those of the window summed afresh, after every
+  *     sample, for every window size
+  *   - slope, fitted value, target and time to the threshold are those of
+  *     a fit in double, rounded, on random windows, periods and thresholds
+  *   - exact ramps give their slope and crossing time exactly
+  *   - full-scale windows neither overflow nor wrap; too steep a slope is
+  *     saturated and flagged, too slow a one gives TREND_TIME_OVER
+  *
+  * Usage: temptrend [-w window] [-p ms] [-H degC] [-L degC] log...
+  *        temptrend -x
+  */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "trend.h"
+#include "n2klog.h"
+
+#define TEMP_PGN          130312UL
+#define WINDOW_DEFAULT    30U       /* as in Core/Src/params.c */
+#define PERIOD_DEFAULT    1000U
+#define HIGH_DEFAULT      85.0      /* degC */
+#define LOW_DEFAULT       (-40.0)
+#define CHECK_SAMPLES     2000U
+#define CHECK_FITS        200000U
+
+/**
+  * @brief A PGN 130312 value or a trend message, in log order
+  */
+typedef struct
+{
+  uint8_t trend;          /* 0: T1 value, 1: trend message */
+  uint8_t data[8];
+} Event;
+
+static Event *events;
+static uint32_t eventCount;
+static uint32_t eventSize;
+static uint32_t failures;
+static uint32_t rng = 1U;
+
+/*--------------------------------- helpers ----------------------------------*/
+
+static uint32_t xorshift32(void)
+{
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static void fail(const char *what, uint32_t window, uint32_t at)
+{
+  if (failures < 10U)
+  {
+    fprintf(stderr, "self-check: %s, window %u, at %u\n", what, (unsigned)window, (unsigned)at);
+  }
+  failures++;
+}
+
+static void addEvent(uint8_t trend, const uint8_t *data)
+{
+  if (eventCount == eventSize)
+  {
+    eventSize = (eventSize == 0U) ? 4096U : (eventSize * 2U);
+    events = realloc(events, eventSize * sizeof(*events));
+    if (events == NULL)
+    {
+      perror("events");
+      exit(2);
+    }
+  }
+  events[eventCount].trend = trend;
+  memcpy(events[eventCount].data, data, sizeof(events[eventCount].data));
+  eventCount++;
+}
+
+static int32_t centiK(double degC)
+{
+  return (int32_t)lround(degC * 10.0) * 10 + 27315;
+}
+
+/**
+  * @brief What Trend_Estimate() should give, from a fit in double over the
+  *        samples, oldest first
+  */
+static void reference(const uint16_t *samples, uint32_t n, uint32_t periodMs, int32_t high, int32_t low,
+                      double *slope, double *fitted, double *seconds, uint8_t *target)
+{
+  double sy = 0.0;
+  double sxy = 0.0;
+  double sx = (double)n * ((double)n - 1.0) / 2.0;
+  double d = (double)n * (double)n * ((double)n * (double)n - 1.0) / 12.0;
+  double num;
+  double perSample;
+  uint32_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    sy += samples[i];
+    sxy += (double)i * samples[i];
+  }
+  /* Integers below 2^53, exact */
+  num = (double)n * sxy - sx * sy;
+  perSample = num / d;
+  *slope = perSample * 600000.0 / (double)periodMs;
+  *fitted = (sy - perSample * sx) / (double)n + perSample * ((double)n - 1.0);
+  *target = ((num == 0.0) || (low >= high)) ? TREND_TARGET_NONE :
+            ((num > 0.0) ? TREND_TARGET_HIGH : TREND_TARGET_LOW);
+  *seconds = -1.0;
+  if (*target != TREND_TARGET_NONE)
+  {
+    *seconds = ((double)((*target == TREND_TARGET_HIGH) ? high : low) - *fitted) / (perSample * 1000.0 /
+               (double)periodMs);
+    *seconds = (*seconds < 0.0) ? 0.0 : *seconds;
+  }
+}
+
+/* Trend_Estimate() against reference(); 0 if they agree */
+static int compare(const Trend_Result *r, const uint16_t *samples, uint32_t n, uint32_t periodMs, int32_t high,
+                   int32_t low)
+{
+  double slope;
+  double fitted;
+  double seconds;
+  uint8_t target;
+  const double tie = 0.5 + 1e-9;
+
+  if (r->samples != n)
+  {
+    return 1;
+  }
+  if (n < 2U)
+  {
+    return (r->slope != TREND_SLOPE_NA) || (r->target != TREND_TARGET_NONE) || (r->seconds != TREND_TIME_NA);
+  }
+  reference(samples, n, periodMs, high, low, &slope, &fitted, &seconds, &target);
+  if (fabs(slope) > (double)TREND_SLOPE_MAX + 0.5)
+  {
+    if ((abs(r->slope) != TREND_SLOPE_MAX) || ((r->flags & TREND_FLAG_CLAMPED) == 0U))
+    {
+      return 1;
+    }
+  }
+  else if ((fabs((double)r->slope - slope) > tie) || ((r->flags & TREND_FLAG_CLAMPED) != 0U))
+  {
+    return 1;
+  }
+  if ((fabs((double)r->fitted - fitted) > tie) || (r->target != target))
+  {
+    return 1;
+  }
+  if (target == TREND_TARGET_NONE)
+  {
+    return r->seconds != TREND_TIME_NA;
+  }
+  if (seconds > (double)TREND_TIME_MAX + tie)
+  {
+    return r->seconds != TREND_TIME_OVER;
+  }
+  return (r->seconds > TREND_TIME_MAX) || (fabs((double)r->seconds - seconds) > tie);
+}
+
+/*--------------------------------- recorded ----------------------------------*/
+
+static int loadLog(const char *path)
+{
+  N2k_Log log;
+  N2k_Frame frame;
+  N2k_Id id;
+  size_t pos;
+
+  if (N2k_Open(&log, path) != 0)
+  {
+    return -1;
+  }
+  pos = log.first;
+  while (N2k_Next(&log, &pos, log.size, &frame) > 0)
+  {
+    if (!frame.ext || frame.rtr)
+    {
+      continue;
+    }
+    N2k_SplitId(frame.id, &id);
+    if ((id.pgn == TEMP_PGN) && (frame.dlc >= 5U) && ((frame.data[3] & frame.data[4]) != 0xFFU))
+    {
+      addEvent(0, frame.data);
+    }
+    else if ((id.pgn == TREND_PGN) && (frame.dlc == 8U))
+    {
+      addEvent(1, frame.data);
+    }
+  }
+  N2k_Close(&log);
+  return 0;
+}
+
+/* Size of the window starting at event 'from': what the node reports full
+ * before it starts again, or the default */
+static uint32_t windowFrom(uint32_t from, uint32_t window)
+{
+  uint32_t seen = 0;
+  uint32_t i;
+
+  for (i = from; i < eventCount; i++)
+  {
+    const uint8_t *data = events[i].data;
+
+    if (!events[i].trend || ((data[7] & TREND_FLAG_REQUEST) != 0U))
+    {
+      continue;
+    }
+    if ((data[1] == 1U) && seen++)
+    {
+      break;
+    }
+    if ((data[7] & TREND_FLAG_FULL) != 0U)
+    {
+      return data[1];
+    }
+  }
+  return window;
+}
+
+static int recorded(int count, char **paths, uint32_t window, uint32_t periodMs, int32_t high, int32_t low)
+{
+  Trend_State trend;
+  Trend_Result result;
+  uint8_t data[8];
+  uint32_t values = 0;
+  uint32_t messages = 0;
+  uint32_t requests = 0;
+  uint32_t exact = 0;
+  uint32_t differ = 0;
+  uint32_t restarts = 0;
+  int32_t slopeMin = 0;
+  int32_t slopeMax = 0;
+  int32_t slopeLast = TREND_SLOPE_NA;
+  uint8_t sid = 0;
+  double sx = 0.0;
+  double sy = 0.0;
+  double sxx = 0.0;
+  double sxy = 0.0;
+  uint32_t i;
+  int k;
+
+  for (k = 0; k < count; k++)
+  {
+    if (loadLog(paths[k]) != 0)
+    {
+      return 2;
+    }
+  }
+
+  Trend_Start(&trend, windowFrom(0, window));
+  for (i = 0; i < eventCount; i++)
+  {
+    const uint8_t *got = events[i].data;
+    uint8_t flags;
+
+    if (!events[i].trend)
+    {
+      uint16_t value = (uint16_t)(got[3] | ((uint16_t)got[4] << 8));
+
+      /* A trend message of one sample after it: the node started again */
+      if ((i + 1U < eventCount) && events[i + 1U].trend && (events[i + 1U].data[1] == 1U) &&
+          ((events[i + 1U].data[7] & TREND_FLAG_REQUEST) == 0U) && (trend.count != 0U))
+      {
+        Trend_Start(&trend, windowFrom(i, window));
+        restarts++;
+      }
+      Trend_Add(&trend, value);
+      sid = got[0];
+      sx += values;
+      sy += value;
+      sxx += (double)values * values;
+      sxy += (double)values * value;
+      values++;
+
+      Trend_Estimate(&trend, periodMs, high, low, &result);
+      if (result.slope != TREND_SLOPE_NA)
+      {
+        slopeMin = ((slopeLast == TREND_SLOPE_NA) || (result.slope < slopeMin)) ? result.slope : slopeMin;
+        slopeMax = ((slopeLast == TREND_SLOPE_NA) || (result.slope > slopeMax)) ? result.slope : slopeMax;
+        slopeLast = result.slope;
+      }
+      continue;
+    }
+
+    messages++;
+    flags = got[7] & TREND_FLAG_REQUEST;
+    if (flags != 0U)
+    {
+      requests++;
+      if (got[1] != trend.count)
+      {
+        /* Answered after a parameter change: nothing to compare */
+        continue;
+      }
+    }
+    Trend_Estimate(&trend, periodMs, high, low, &result);
+    Trend_Encode(&result, sid, flags, data);
+    if (memcmp(data, got, sizeof(data)) == 0)
+    {
+      exact++;
+    }
+    else
+    {
+      if (differ < 5U)
+      {
+        fprintf(stderr, "trend message %u: %02X%02X%02X%02X%02X%02X%02X%02X, codec %02X%02X%02X%02X%02X%02X%02X%02X\n",
+                (unsigned)messages, got[0], got[1], got[2], got[3], got[4], got[5], got[6], got[7], data[0],
+                data[1], data[2], data[3], data[4], data[5], data[6], data[7]);
+      }
+      differ++;
+    }
+  }
+
+  if (values < 2U)
+  {
+    fprintf(stderr, "%u PGN 130312 values, too few\n", (unsigned)values);
+    return 1;
+  }
+  printf("===== Temperature trend, %u values, window %u, period %u ms =====\n", (unsigned)values,
+         (unsigned)trend.window, (unsigned)periodMs);
+  printf("  slope     %9.3f K/min last, %.3f to %.3f; %.3f K/min over the recording\n",
+         (double)slopeLast / 1000.0, (double)slopeMin / 1000.0, (double)slopeMax / 1000.0,
+         ((values * sxy - sx * sy) / (values * sxx - sx * sx)) * 600.0 / (double)periodMs);
+  if (messages > 0U)
+  {
+    printf("  messages  %9u, %u requests, %u restarts: %u as the codec has them, %u differ\n", (unsigned)messages,
+           (unsigned)requests, (unsigned)restarts, (unsigned)exact, (unsigned)differ);
+  }
+  else
+  {
+    printf("  messages  %9s (no PGN 65283 in the recording)\n", "none");
+  }
+  return (differ == 0U) ? 0 : 1;
+}
+
+/*-------------------------------- self-check ---------------------------------*/
+
+static void checkSums(void)
+{
+  uint16_t history[CHECK_SAMPLES];
+  uint32_t window;
+  uint32_t i;
+
+  for (window = TREND_WINDOW_MIN; window <= TREND_WINDOW_MAX; window++)
+  {
+    Trend_State trend;
+
+    Trend_Start(&trend, window);
+    for (i = 0; i < CHECK_SAMPLES; i++)
+    {
+      uint32_t n = (i + 1U < window) ? (i + 1U) : window;
+      uint32_t sumY = 0;
+      uint32_t sumXY = 0;
+      uint32_t j;
+
+      /* Full scale now and then */
+      history[i] = ((xorshift32() & 0x3FU) == 0U) ? 0xFFFFU : (uint16_t)(27315U + (xorshift32() % 10000U));
+      Trend_Add(&trend, history[i]);
+      for (j = 0; j < n; j++)
+      {
+        sumY += history[i + 1U - n + j];
+        sumXY += j * history[i + 1U - n + j];
+      }
+      if ((trend.count != n) || (trend.sumY != sumY) || (trend.sumXY != sumXY))
+      {
+        fail("running sums differ from the window summed afresh", window, i);
+        break;
+      }
+    }
+  }
+}
+
+static void checkFits(void)
+{
+  static const uint32_t periods[] = { 100U, 250U, 1000U, 5000U, 60000U };
+  uint16_t samples[TREND_WINDOW_MAX];
+  uint32_t k;
+
+  for (k = 0; k < CHECK_FITS; k++)
+  {
+    Trend_State trend;
+    Trend_Result result;
+    uint32_t window = TREND_WINDOW_MIN + (xorshift32() % (TREND_WINDOW_MAX - TREND_WINDOW_MIN + 1U));
+    uint32_t n = 1U + (xorshift32() % window);
+    uint32_t period = periods[xorshift32() % (sizeof(periods) / sizeof(periods[0]))];
+    int32_t base = 24000 + (int32_t)(xorshift32() % 20000U);
+    int32_t step = (int32_t)(xorshift32() % 201U) - 100;
+    int32_t noise = (int32_t)(xorshift32() % 400U);
+    int32_t high = centiK(-55.0 + (double)(xorshift32() % 2050U) / 10.0);
+    int32_t low = centiK(-55.0 + (double)(xorshift32() % 2050U) / 10.0);
+    uint32_t i;
+
+    Trend_Start(&trend, window);
+    /* A fuller window slides over some first */
+    for (i = 0; i < n + (xorshift32() % 100U); i++)
+    {
+      int32_t y = base + step * (int32_t)i + ((noise > 0) ? ((int32_t)(xorshift32() % (2U * noise + 1U)) - noise) : 0);
+
+      y = (y < 0) ? 0 : ((y > 0xFFFF) ? 0xFFFF : y);
+      Trend_Add(&trend, (uint16_t)y);
+      memmove(samples, samples + ((i >= window) ? 1 : 0), (((i >= window) ? window : i + 1U) - 1U) * sizeof(samples[0]));
+      samples[((i >= window) ? window : i + 1U) - 1U] = (uint16_t)y;
+    }
+    Trend_Estimate(&trend, period, high, low, &result);
+    if (compare(&result, samples, trend.count, period, high, low) != 0)
+    {
+      fail("estimate differs from the fit in double", window, k);
+    }
+  }
+}
+
+static void checkRamps(void)
+{
+  static const uint32_t periods[] = { 1000U, 10000U, 60000U };
+  int32_t step;
+  uint32_t k;
+
+  for (k = 0; k < sizeof(periods) / sizeof(periods[0]); k++)
+  {
+    for (step = -50; step <= 50; step++)
+    {
+      Trend_State trend;
+      Trend_Result result;
+      int32_t start = 30000;
+      int32_t high = centiK(60.0);
+      int32_t low = centiK(-20.0);
+      int64_t slope = ((int64_t)step * 600000) / (int64_t)periods[k];
+      int32_t last = start + step * 99;
+      uint32_t i;
+
+      Trend_Start(&trend, WINDOW_DEFAULT);
+      for (i = 0; i < 100U; i++)
+      {
+        Trend_Add(&trend, (uint16_t)(start + step * (int32_t)i));
+      }
+      Trend_Estimate(&trend, periods[k], high, low, &result);
+
+      /* Whole 0.001 K/min for these periods */
+      if ((result.slope != slope) || (result.fitted != last) || ((result.flags & TREND_FLAG_FULL) == 0U))
+      {
+        fail("exact ramp misfitted", WINDOW_DEFAULT, (uint32_t)(step + 50));
+        continue;
+      }
+      if (step == 0)
+      {
+        if ((result.target != TREND_TARGET_NONE) || (result.seconds != TREND_TIME_NA))
+        {
+          fail("steady window with a target", WINDOW_DEFAULT, 0);
+        }
+        continue;
+      }
+      {
+        int32_t distance = ((step > 0) ? high : low) - last;
+        double seconds = (double)distance / (double)step * (double)periods[k] / 1000.0;
+        uint32_t want = (seconds <= 0.0) ? 0U :
+                        ((seconds > (double)TREND_TIME_MAX + 0.5) ? TREND_TIME_OVER : (uint32_t)lround(seconds));
+
+        if ((result.target != ((step > 0) ? TREND_TARGET_HIGH : TREND_TARGET_LOW)) || (result.seconds != want))
+        {
+          fail("exact ramp crossing time wrong", WINDOW_DEFAULT, (uint32_t)(step + 50));
+        }
+      }
+    }
+  }
+}
+
+static void checkExtremes(void)
+{
+  uint16_t samples[TREND_WINDOW_MAX];
+  Trend_State trend;
+  Trend_Result result;
+  uint8_t data[8];
+  uint32_t i;
+
+  /* Full scale, then alternating with zero */
+  Trend_Start(&trend, TREND_WINDOW_MAX);
+  for (i = 0; i < 1000U; i++)
+  {
+    uint16_t y = ((i < 500U) || ((i & 1U) != 0U)) ? 0xFFFFU : 0U;
+
+    Trend_Add(&trend, y);
+    memmove(samples, samples + ((i >= TREND_WINDOW_MAX) ? 1 : 0),
+            (((i >= TREND_WINDOW_MAX) ? TREND_WINDOW_MAX : i + 1U) - 1U) * sizeof(samples[0]));
+    samples[((i >= TREND_WINDOW_MAX) ? TREND_WINDOW_MAX : i + 1U) - 1U] = y;
+    Trend_Estimate(&trend, 60000U, centiK(150.0), centiK(-55.0), &result);
+    if (compare(&result, samples, trend.count, 60000U, centiK(150.0), centiK(-55.0)) != 0)
+    {
+      fail("full-scale window misfitted", TREND_WINDOW_MAX, i);
+      break;
+    }
+  }
+
+  /* Full scale in one period of 100 ms: saturated */
+  Trend_Start(&trend, TREND_WINDOW_MIN);
+  Trend_Add(&trend, 0U);
+  Trend_Add(&trend, 0xFFFFU);
+  Trend_Estimate(&trend, 100U, centiK(150.0), centiK(-55.0), &result);
+  if ((result.slope != TREND_SLOPE_MAX) || ((result.flags & TREND_FLAG_CLAMPED) == 0U) || (result.seconds != 0U))
+  {
+    fail("steep slope not saturated", TREND_WINDOW_MIN, 0);
+  }
+
+  /* 0.01 K over a full window of minutes toward a far threshold */
+  Trend_Start(&trend, TREND_WINDOW_MAX);
+  for (i = 0; i < TREND_WINDOW_MAX; i++)
+  {
+    Trend_Add(&trend, (uint16_t)((i < TREND_WINDOW_MAX / 2U) ? 29315U : 29316U));
+  }
+  Trend_Estimate(&trend, 60000U, centiK(150.0), centiK(-55.0), &result);
+  if ((result.target != TREND_TARGET_HIGH) || (result.seconds != TREND_TIME_OVER))
+  {
+    fail("slow slope not beyond the time range", TREND_WINDOW_MAX, 0);
+  }
+
+  /* Message layout: a negative slope, one sample without one */
+  Trend_Start(&trend, WINDOW_DEFAULT);
+  Trend_Add(&trend, 30000U);
+  Trend_Add(&trend, 29990U);
+  Trend_Estimate(&trend, 1000U, centiK(85.0), centiK(-40.0), &result);
+  Trend_Encode(&result, 0x42U, TREND_FLAG_REQUEST, data);
+  if ((data[0] != 0x42U) || (data[1] != 2U) || ((int16_t)(data[2] | (data[3] << 8)) != -6000) ||
+      (data[6] != TREND_TARGET_LOW) || (data[7] != (0xF8U | TREND_FLAG_REQUEST)))
+  {
+    fail("message layout", WINDOW_DEFAULT, 2);
+  }
+  Trend_Start(&trend, WINDOW_DEFAULT);
+  Trend_Add(&trend, 30000U);
+  Trend_Estimate(&trend, 1000U, centiK(85.0), centiK(-40.0), &result);
+  Trend_Encode(&result, 0, 0, data);
+  if ((data[1] != 1U) || (data[2] != 0xFFU) || (data[3] != 0x7FU) || (data[4] != 0xFFU) || (data[5] != 0xFFU) ||
+      (data[6] != TREND_TARGET_NONE))
+  {
+    fail("message layout without a slope", WINDOW_DEFAULT, 1);
+  }
+}
+
+static int selfCheck(void)
+{
+  printf("===== Temperature trend self-check =====\n");
+  checkSums();
+  printf("  sums    %u windows of %u samples\n", (unsigned)(TREND_WINDOW_MAX - TREND_WINDOW_MIN + 1U),
+         (unsigned)CHECK_SAMPLES);
+  checkFits();
+  printf("  fits    %u random windows against double\n", (unsigned)CHECK_FITS);
+  checkRamps();
+  printf("  ramps   %u exact ramps\n", 3U * 101U);
+  checkExtremes();
+  printf("  check   %s\n", (failures == 0U) ? "ok" : "FAILED");
+  return (failures == 0U) ? 0 : 1;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-w window] [-p ms] [-H degC] [-L degC] log...\n"
+          "       %s -x\n"
+          "  -w  window until the node reports one full (default %u)\n"
+          "  -p  T1 period of the recording (default %u)\n"
+          "  -H  high alarm threshold of the recording (default %.1f)\n"
+          "  -L  low alarm threshold of the recording (default %.1f)\n"
+          "  -x  check the trend codec\n"
+          "  log candump logs or pcap captures\n",
+          prog, prog, WINDOW_DEFAULT, PERIOD_DEFAULT, HIGH_DEFAULT, LOW_DEFAULT);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t window = WINDOW_DEFAULT;
+  uint32_t periodMs = PERIOD_DEFAULT;
+  double high = HIGH_DEFAULT;
+  double low = LOW_DEFAULT;
+  int check = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "w:p:H:L:xh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'w': window = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'p': periodMs = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'H': high = strtod(optarg, NULL); break;
+      case 'L': low = strtod(optarg, NULL); break;
+      case 'x': check = 1; break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+
+  if (check)
+  {
+    if (optind != argc)
+    {
+      usage(argv[0]);
+      return 2;
+    }
+    return selfCheck();
+  }
+  if ((optind >= argc) || (window < TREND_WINDOW_MIN) || (window > TREND_WINDOW_MAX) || (periodMs == 0U))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+  return recorded(argc - optind, &argv[optind], window, periodMs, centiK(high), centiK(low));
+}